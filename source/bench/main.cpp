@@ -0,0 +1,1281 @@
+/**
+ * @file main.cpp
+ * @brief Load generator comparing HTTP/1.1 keep-alive, HTTP/2 (h2c), TLS and shared-memory calls
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/hpack.hpp"
+#include "net/qpack.hpp"
+#include "net/quic_connection.hpp"
+#include "net/shm_channel.hpp"
+#include "net/udp_socket.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef MINISERVER_HAS_OPENSSL
+    #include <openssl/ssl.h>
+#endif
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Benchmark settings (command line)
+ */
+struct BenchOptions
+{
+    std::string host = "127.0.0.1";     ///< Server address
+    int port = 8080;                    ///< Server port
+    std::string unix_path;              ///< Unix domain socket instead of TCP ('@' prefix: abstract name)
+    std::string path = "/ping";         ///< Request target
+    std::string protocol = "both";      ///< h1, h2c, both, handshake, h3 or shm
+    std::string shm_path;               ///< Shared-memory handshake socket (shm protocol)
+    std::string service = "echo";       ///< Service called in shm mode
+    int connections = 4;                ///< Concurrent connections
+    int requests = 20000;               ///< Total requests per protocol
+    int streams = 16;                   ///< Concurrent streams per h2c connection
+    std::string tls;                    ///< TLS: "full" handshakes or "resume" sessions (empty: plaintext)
+    bool fastopen = false;              ///< Send the first request in the SYN (TCP_FASTOPEN_CONNECT)
+    int udp_port = 8125;                ///< UDP ingest port (udp protocol)
+    std::vector<size_t> sizes;          ///< Body sizes swept through /service/kv (h1), e.g. to find the zero-copy crossover
+    std::string ca_file;                ///< h3: trust anchors for the server certificate (empty: system default)
+    bool insecure = false;              ///< h3: skip the chain and name check (CertificateVerify is still checked)
+#ifdef MINISERVER_HAS_OPENSSL
+    SSL_CTX* tls_context = nullptr;     ///< Client context when tls is set
+#endif
+};
+
+/**
+ * @brief Per-connection measurements
+ */
+struct WorkerResult
+{
+    std::vector<double> latencies_us;   ///< Completed request latencies
+    size_t errors = 0;                  ///< Failed requests
+    size_t bytes = 0;                   ///< Response bytes received (body + headers)
+    size_t handshakes = 0;              ///< TLS handshakes completed
+    size_t resumed = 0;                 ///< Of which resumed a session
+};
+
+/**
+ * @brief Headline numbers of one run
+ */
+struct BenchSummary
+{
+    double requests_per_second = 0.0;
+    double mib_per_second = 0.0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    size_t errors = 0;
+};
+
+class Connection
+{
+public:
+    Connection() = default;
+    ~Connection()
+    {
+        Close();
+#ifdef MINISERVER_HAS_OPENSSL
+        SSL_SESSION_free(session_);
+#endif
+    }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    /// Connect; with TLS also run the handshake, offering `alpn` (wire format)
+    bool Open(const BenchOptions& options, const std::string& alpn = std::string("\x08http/1.1", 9))
+    {
+        Close();
+        if (!options.unix_path.empty())
+        {
+            return OpenLocal(options.unix_path);
+        }
+        if (!OpenTcp(options))
+        {
+            return false;
+        }
+#ifdef MINISERVER_HAS_OPENSSL
+        if (options.tls_context)
+        {
+            return Handshake(options, alpn);
+        }
+#else
+        (void)alpn;
+#endif
+        return true;
+    }
+
+    bool OpenTcp(const BenchOptions& options)
+    {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(options.host.c_str(), std::to_string(options.port).c_str(), &hints, &result) != 0)
+        {
+            return false;
+        }
+        for (addrinfo* ai = result; ai != nullptr; ai = ai->ai_next)
+        {
+            fd_ = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd_ < 0)
+            {
+                continue;
+            }
+#ifdef TCP_FASTOPEN_CONNECT
+            if (options.fastopen)
+            {
+                // connect() returns at once; the first write goes out with the SYN once a cookie is cached
+                int one = 1;
+                setsockopt(fd_, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &one, sizeof(one));
+            }
+#endif
+            if (connect(fd_, ai->ai_addr, ai->ai_addrlen) == 0)
+            {
+                break;
+            }
+            close(fd_);
+            fd_ = -1;
+        }
+        freeaddrinfo(result);
+        if (fd_ < 0)
+        {
+            return false;
+        }
+        int one = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        buffer_.clear();
+        return true;
+    }
+
+    bool OpenLocal(const std::string& path)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            return false;
+        }
+        memcpy(address.sun_path, path.data(), path.size());
+        socklen_t length = sizeof(address);
+        if (path.front() == '@')
+        {
+            address.sun_path[0] = '\0';     // Abstract namespace: length covers the name exactly
+            length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+        }
+        fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr*>(&address), length) != 0)
+        {
+            Close();
+            return false;
+        }
+        buffer_.clear();
+        return true;
+    }
+
+#ifdef MINISERVER_HAS_OPENSSL
+    bool Handshake(const BenchOptions& options, const std::string& alpn)
+    {
+        ssl_ = SSL_new(options.tls_context);
+        SSL_set_fd(ssl_, fd_);
+        SSL_set_alpn_protos(ssl_, reinterpret_cast<const unsigned char*>(alpn.data()), static_cast<unsigned int>(alpn.size()));
+        if (session_ && options.tls == "resume")
+        {
+            SSL_set_session(ssl_, session_);
+        }
+        if (SSL_connect(ssl_) != 1)
+        {
+            Close();
+            return false;
+        }
+        ++handshakes_;
+        resumed_ += SSL_session_reused(ssl_) ? 1 : 0;
+        return true;
+    }
+#endif
+
+    size_t Handshakes() const { return handshakes_; }
+    size_t Resumed() const { return resumed_; }
+
+    void Close()
+    {
+#ifdef MINISERVER_HAS_OPENSSL
+        if (ssl_)
+        {
+            // TLS 1.3 tickets arrive after the handshake, so keep the newest session for the next connection
+            SSL_SESSION* session = SSL_get1_session(ssl_);
+            if (session && SSL_SESSION_is_resumable(session))
+            {
+                SSL_SESSION_free(session_);
+                session_ = session;
+            }
+            else
+            {
+                SSL_SESSION_free(session);
+            }
+            SSL_shutdown(ssl_);     // without close_notify OpenSSL marks the session not resumable
+            SSL_free(ssl_);
+            ssl_ = nullptr;
+        }
+#endif
+        if (fd_ >= 0)
+        {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    bool WriteAll(const std::string& data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            const ssize_t n = Send(data.data() + sent, data.size() - sent);
+            if (n <= 0)
+            {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    /// Make sure at least `size` bytes are buffered
+    bool Fill(size_t size)
+    {
+        char chunk[65536];
+        while (buffer_.size() < size)
+        {
+            const ssize_t n = Receive(chunk, sizeof(chunk));
+            if (n <= 0)
+            {
+                return false;
+            }
+            buffer_.append(chunk, static_cast<size_t>(n));
+        }
+        return true;
+    }
+
+    /// Read until the delimiter is buffered; returns its position
+    size_t FillUntil(const char* delimiter)
+    {
+        size_t pos;
+        while ((pos = buffer_.find(delimiter)) == std::string::npos)
+        {
+            if (!Fill(buffer_.size() + 1))
+            {
+                return std::string::npos;
+            }
+        }
+        return pos;
+    }
+
+    std::string& Buffer() { return buffer_; }
+
+private:
+    ssize_t Send(const char* data, size_t size)
+    {
+#ifdef MINISERVER_HAS_OPENSSL
+        if (ssl_)
+        {
+            return SSL_write(ssl_, data, static_cast<int>(std::min<size_t>(size, 1 << 30)));
+        }
+#endif
+        return send(fd_, data, size, MSG_NOSIGNAL);
+    }
+
+    ssize_t Receive(char* data, size_t size)
+    {
+#ifdef MINISERVER_HAS_OPENSSL
+        if (ssl_)
+        {
+            return SSL_read(ssl_, data, static_cast<int>(size));
+        }
+#endif
+        return recv(fd_, data, size, 0);
+    }
+
+    int fd_ = -1;
+    std::string buffer_;
+    size_t handshakes_ = 0;
+    size_t resumed_ = 0;
+#ifdef MINISERVER_HAS_OPENSSL
+    SSL* ssl_ = nullptr;
+    SSL_SESSION* session_ = nullptr;    ///< Offered on the next handshake in resume mode
+#endif
+};
+
+// -----------------------------------------------------------------------------
+// HTTP/1.1 keep-alive
+// -----------------------------------------------------------------------------
+
+/**
+ * @param reconnect New connection (and TLS handshake) for every request, timed with the request
+ */
+void RunHttp1Worker(const BenchOptions& options, int requests, WorkerResult& result, bool reconnect)
+{
+    const std::string request = "GET " + options.path + " HTTP/1.1\r\nHost: " + options.host +
+                                "\r\nUser-Agent: mini-bench\r\nAccept: */*\r\n\r\n";
+    Connection connection;
+    bool open = false;
+
+    for (int i = 0; i < requests; ++i)
+    {
+        const auto start = Clock::now();
+        if (!open && !(open = connection.Open(options)))
+        {
+            ++result.errors;
+            continue;
+        }
+
+        if (!connection.WriteAll(request))
+        {
+            ++result.errors;
+            open = false;
+            continue;
+        }
+
+        const size_t head_end = connection.FillUntil("\r\n\r\n");
+        if (head_end == std::string::npos)
+        {
+            ++result.errors;
+            open = false;
+            continue;
+        }
+
+        std::string head = connection.Buffer().substr(0, head_end);
+        std::transform(head.begin(), head.end(), head.begin(), [](unsigned char c)
+        {
+            return static_cast<char>(std::tolower(c));
+        });
+        size_t content_length = 0;
+        const size_t length_pos = head.find("\r\ncontent-length:");
+        if (length_pos != std::string::npos)
+        {
+            content_length = std::strtoul(head.c_str() + length_pos + 17, nullptr, 10);
+        }
+
+        const size_t total = head_end + 4 + content_length;
+        if (!connection.Fill(total))
+        {
+            ++result.errors;
+            open = false;
+            continue;
+        }
+        connection.Buffer().erase(0, total);
+
+        result.latencies_us.push_back(
+            std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        result.bytes += total;
+
+        if (reconnect || head.find("\r\nconnection: close") != std::string::npos)
+        {
+            connection.Close();
+            open = false;
+        }
+    }
+    result.handshakes += connection.Handshakes();
+    result.resumed += connection.Resumed();
+}
+
+// -----------------------------------------------------------------------------
+// HTTP/2 cleartext (prior knowledge)
+// -----------------------------------------------------------------------------
+
+constexpr uint8_t kFrameData = 0x0;
+constexpr uint8_t kFrameHeaders = 0x1;
+constexpr uint8_t kFrameRstStream = 0x3;
+constexpr uint8_t kFrameSettings = 0x4;
+constexpr uint8_t kFramePing = 0x6;
+constexpr uint8_t kFrameGoAway = 0x7;
+constexpr uint8_t kFrameWindowUpdate = 0x8;
+constexpr uint8_t kFrameContinuation = 0x9;
+constexpr uint8_t kFlagEndStream = 0x1;
+constexpr uint8_t kFlagAck = 0x1;
+constexpr uint8_t kFlagEndHeaders = 0x4;
+constexpr uint32_t kMaxWindow = 0x7fffffff;
+
+void AppendFrame(std::string& output, uint8_t type, uint8_t flags, uint32_t stream_id, const std::string& payload)
+{
+    const size_t length = payload.size();
+    output.push_back(static_cast<char>((length >> 16) & 0xff));
+    output.push_back(static_cast<char>((length >> 8) & 0xff));
+    output.push_back(static_cast<char>(length & 0xff));
+    output.push_back(static_cast<char>(type));
+    output.push_back(static_cast<char>(flags));
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        output.push_back(static_cast<char>((stream_id >> shift) & 0xff));
+    }
+    output += payload;
+}
+
+std::string Uint32Payload(uint32_t value)
+{
+    std::string payload;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        payload.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+    return payload;
+}
+
+void RunHttp2Worker(const BenchOptions& options, int requests, WorkerResult& result)
+{
+    Connection connection;
+    if (!connection.Open(options, std::string("\x02h2", 3)))
+    {
+        result.errors += static_cast<size_t>(requests);
+        return;
+    }
+    result.handshakes += connection.Handshakes();
+
+    // Preface, SETTINGS (INITIAL_WINDOW_SIZE = max, ENABLE_PUSH = 0) and a
+    // connection window large enough that the server never waits on us
+    std::string output = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    std::string settings;
+    settings += std::string("\x00\x04", 2) + Uint32Payload(kMaxWindow);
+    settings += std::string("\x00\x02", 2) + Uint32Payload(0);
+    AppendFrame(output, kFrameSettings, 0, 0, settings);
+    AppendFrame(output, kFrameWindowUpdate, 0, 0, Uint32Payload(kMaxWindow - 65535));
+
+    miniserver::http::HpackEncoder encoder;
+    miniserver::http::HpackDecoder decoder;
+    const std::vector<miniserver::http::HeaderField> request_headers = {
+        {":method", "GET"},
+        {":scheme", options.tls.empty() ? "http" : "https"},
+        {":authority", options.host},
+        {":path", options.path},
+        {"user-agent", "mini-bench"},
+        {"accept", "*/*"},
+    };
+
+    std::unordered_map<uint32_t, Clock::time_point> in_flight;
+    std::string header_block;
+    uint32_t next_stream_id = 1;
+    uint64_t unacked_data = 0;
+    int sent = 0;
+    int finished = 0;
+
+    while (finished < requests)
+    {
+        // Keep up to `streams` requests outstanding
+        while (sent < requests && static_cast<int>(in_flight.size()) < options.streams)
+        {
+            std::string block;
+            encoder.Encode(request_headers, block);
+            AppendFrame(output, kFrameHeaders, kFlagEndHeaders | kFlagEndStream, next_stream_id, block);
+            in_flight[next_stream_id] = Clock::now();
+            next_stream_id += 2;
+            ++sent;
+        }
+        if (!output.empty())
+        {
+            if (!connection.WriteAll(output))
+            {
+                break;
+            }
+            output.clear();
+        }
+
+        // Read one frame
+        if (!connection.Fill(9))
+        {
+            break;
+        }
+        const auto* header = reinterpret_cast<const unsigned char*>(connection.Buffer().data());
+        const size_t length = (static_cast<size_t>(header[0]) << 16) | (static_cast<size_t>(header[1]) << 8) | header[2];
+        const uint8_t type = header[3];
+        const uint8_t flags = header[4];
+        const uint32_t stream_id = ((static_cast<uint32_t>(header[5]) << 24) | (static_cast<uint32_t>(header[6]) << 16) |
+                                    (static_cast<uint32_t>(header[7]) << 8) | header[8]) & 0x7fffffff;
+        if (!connection.Fill(9 + length))
+        {
+            break;
+        }
+        const std::string payload = connection.Buffer().substr(9, length);
+        connection.Buffer().erase(0, 9 + length);
+        result.bytes += 9 + length;
+
+        bool stream_done = false;
+        switch (type)
+        {
+            case kFrameHeaders:
+            case kFrameContinuation:
+            {
+                header_block += payload;
+                if (flags & kFlagEndHeaders)
+                {
+                    std::vector<miniserver::http::HeaderField> fields;
+                    if (!decoder.Decode(header_block, fields))
+                    {
+                        std::cerr << "HPACK decoding error\n";
+                        result.errors += static_cast<size_t>(requests - finished);
+                        return;
+                    }
+                    if (!fields.empty() && fields[0].first == ":status" && fields[0].second[0] != '2')
+                    {
+                        ++result.errors;
+                    }
+                    header_block.clear();
+                }
+                stream_done = type == kFrameHeaders && (flags & kFlagEndStream);
+                break;
+            }
+            case kFrameData:
+                unacked_data += length;
+                if (unacked_data >= (1u << 30))
+                {
+                    AppendFrame(output, kFrameWindowUpdate, 0, 0, Uint32Payload(static_cast<uint32_t>(unacked_data)));
+                    unacked_data = 0;
+                }
+                stream_done = (flags & kFlagEndStream) != 0;
+                break;
+            case kFrameSettings:
+                if (!(flags & kFlagAck))
+                {
+                    AppendFrame(output, kFrameSettings, kFlagAck, 0, "");
+                }
+                break;
+            case kFramePing:
+                if (!(flags & kFlagAck))
+                {
+                    AppendFrame(output, kFramePing, kFlagAck, 0, payload);
+                }
+                break;
+            case kFrameRstStream:
+                if (in_flight.erase(stream_id) > 0)
+                {
+                    ++result.errors;
+                    ++finished;
+                }
+                break;
+            case kFrameGoAway:
+                result.errors += static_cast<size_t>(requests - finished);
+                return;
+            default:
+                break;
+        }
+
+        if (stream_done)
+        {
+            auto it = in_flight.find(stream_id);
+            if (it != in_flight.end())
+            {
+                result.latencies_us.push_back(
+                    std::chrono::duration<double, std::micro>(Clock::now() - it->second).count());
+                in_flight.erase(it);
+                ++finished;
+            }
+        }
+    }
+
+    if (finished < requests)
+    {
+        result.errors += static_cast<size_t>(requests - finished);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// HTTP/3 over QUIC
+// -----------------------------------------------------------------------------
+
+#ifdef MINISERVER_HAS_HTTP3
+/**
+ * @brief One QUIC connection over its own UDP socket, keeping `streams` requests in flight
+ */
+void RunHttp3Worker(const BenchOptions& options, int requests, WorkerResult& result)
+{
+    using miniserver::network::QuicConnection;
+    namespace quic = miniserver::network::quic;
+
+    miniserver::network::UdpSocket socket;
+    miniserver::network::UdpAddress server;
+    if (!socket.Open("0.0.0.0", 0) || !miniserver::network::UdpAddress::Resolve(options.host, options.port, server))
+    {
+        std::cerr << "h3: cannot open a UDP socket to " << options.host << " (numeric IPv4 only)\n";
+        result.errors += static_cast<size_t>(requests);
+        return;
+    }
+
+    miniserver::network::QuicConnectionOptions connection_options;
+    connection_options.peer.server_name = options.host;
+    connection_options.peer.ca_file = options.ca_file;
+    connection_options.peer.verify = !options.insecure;
+    auto connection = QuicConnection::Connect(connection_options, server);
+    if (!connection)
+    {
+        std::cerr << "h3: cannot start the handshake\n";
+        result.errors += static_cast<size_t>(requests);
+        return;
+    }
+
+    struct Pending
+    {
+        Clock::time_point start;        ///< Request sent
+        std::string response;           ///< Response frames so far
+    };
+    std::unordered_map<uint64_t, Pending> in_flight;
+    int finished = 0;
+
+    // Frames of a finished request stream: HEADERS (status) and DATA
+    const auto complete = [&](uint64_t stream_id)
+    {
+        auto it = in_flight.find(stream_id);
+        if (it == in_flight.end())
+        {
+            return;
+        }
+        std::string_view frames = it->second.response;
+        bool ok = false;
+        while (!frames.empty())
+        {
+            uint64_t type;
+            uint64_t length;
+            std::string_view payload;
+            if (!quic::ReadVarint(frames, type) || !quic::ReadVarint(frames, length) ||
+                !quic::ReadBytes(frames, static_cast<size_t>(length), payload))
+            {
+                ok = false;
+                break;
+            }
+            std::vector<miniserver::http::HeaderField> fields;
+            if (type == 0x01 && miniserver::http::qpack::Decode(payload, fields) && !fields.empty() &&
+                fields[0].first == ":status")
+            {
+                ok = fields[0].second[0] == '2';
+            }
+        }
+        if (ok)
+        {
+            result.latencies_us.push_back(
+                std::chrono::duration<double, std::micro>(Clock::now() - it->second.start).count());
+        }
+        else
+        {
+            ++result.errors;
+        }
+        result.bytes += it->second.response.size();
+        in_flight.erase(it);
+        ++finished;
+    };
+
+    miniserver::network::QuicConnectionCallbacks callbacks;
+    callbacks.on_stream_data = [&](uint64_t stream_id, std::string_view data, bool fin)
+    {
+        auto it = in_flight.find(stream_id);
+        if (it == in_flight.end())
+        {
+            return;     // Server control and QPACK streams
+        }
+        it->second.response.append(data);
+        if (fin)
+        {
+            complete(stream_id);
+        }
+    };
+    callbacks.on_stream_reset = [&](uint64_t stream_id, uint64_t)
+    {
+        if (in_flight.erase(stream_id) > 0)
+        {
+            ++result.errors;
+            ++finished;
+        }
+    };
+    connection->SetCallbacks(callbacks);
+
+    std::string request_block;
+    miniserver::http::qpack::Encode({
+        {":method", "GET"},
+        {":scheme", "https"},
+        {":authority", options.host},
+        {":path", options.path},
+        {"user-agent", "mini-bench"},
+        {"accept", "*/*"},
+    }, request_block);
+    std::string request;
+    quic::AppendVarint(request, 0x01);
+    quic::AppendVarint(request, request_block.size());
+    request += request_block;
+
+    miniserver::network::UdpReceiveBatch receive;
+    miniserver::network::UdpSendBatch send;
+    bool control_open = false;
+    int sent = 0;
+    const auto start = Clock::now();
+
+    while (finished < requests && connection->GetState() != QuicConnection::State::kClosed)
+    {
+        const auto now = quic::Clock::now();
+        if (connection->IsEstablished())
+        {
+            if (!control_open)
+            {
+                // Control stream: type 0x00, empty SETTINGS (no dynamic QPACK table)
+                control_open = true;
+                connection->SendStream(connection->OpenStream(false), std::string("\x00\x04\x00", 3), false);
+                result.handshakes += 1;
+            }
+            while (sent < requests && static_cast<int>(in_flight.size()) < options.streams &&
+                   connection->AvailableStreams(true) > 0)
+            {
+                const uint64_t stream_id = connection->OpenStream(true);
+                in_flight[stream_id].start = Clock::now();
+                connection->SendStream(stream_id, request, true);
+                ++sent;
+            }
+        }
+        else if (connection->GetState() != QuicConnection::State::kHandshake ||
+                 Clock::now() - start > std::chrono::seconds(10))
+        {
+            break;
+        }
+
+        connection->Flush(now, send);
+        socket.Send(send);
+
+        const auto deadline = connection->NextTimeout();
+        int wait_ms = 100;
+        if (deadline != quic::TimePoint::max())
+        {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+            wait_ms = static_cast<int>(std::clamp<long long>(remaining, 0, 100));
+        }
+        pollfd descriptor = {socket.Descriptor(), POLLIN, 0};
+        ::poll(&descriptor, 1, wait_ms);
+
+        if (!socket.Receive(receive))
+        {
+            break;
+        }
+        const auto received = quic::Clock::now();
+        for (size_t i = 0; i < receive.Count(); ++i)
+        {
+            connection->Receive(receive.Data(i), received);
+        }
+        if (received >= connection->NextTimeout())
+        {
+            connection->OnTimeout(received);
+        }
+    }
+
+    if (finished < requests)
+    {
+        if (!connection->CloseReason().empty())
+        {
+            std::cerr << "h3: " << connection->CloseReason() << "\n";
+        }
+        result.errors += static_cast<size_t>(requests - finished);
+    }
+    connection->Close(0x100, true);
+    connection->Flush(quic::Clock::now(), send);
+    socket.Send(send);
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Shared-memory rings
+// -----------------------------------------------------------------------------
+
+void RunShmWorker(const BenchOptions& options, int requests, WorkerResult& result)
+{
+    miniserver::network::ShmClient client;
+    miniserver::network::ShmRequest request;
+    request.service = options.service;
+    request.content_type = "text/plain";
+    request.body = "ping";
+
+    for (int i = 0; i < requests; ++i)
+    {
+        if (!client.IsConnected() && !client.Connect(options.shm_path))
+        {
+            ++result.errors;
+            continue;
+        }
+        const auto start = Clock::now();
+        const auto response = client.Call(request);
+        if (!response || response->status != 200)
+        {
+            ++result.errors;
+            continue;
+        }
+        result.latencies_us.push_back(
+            std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        result.bytes += response->body.size();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Driver
+// -----------------------------------------------------------------------------
+
+double Percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[index];
+}
+
+BenchSummary RunBenchmark(const BenchOptions& options, const std::string& protocol)
+{
+    std::vector<WorkerResult> results(static_cast<size_t>(options.connections));
+    std::vector<std::thread> workers;
+
+    const auto start = Clock::now();
+    for (int i = 0; i < options.connections; ++i)
+    {
+        const int share = options.requests / options.connections + (i < options.requests % options.connections ? 1 : 0);
+        workers.emplace_back([&, i, share]()
+        {
+            if (protocol == "h2c")
+            {
+                RunHttp2Worker(options, share, results[static_cast<size_t>(i)]);
+            }
+            else if (protocol == "h3")
+            {
+#ifdef MINISERVER_HAS_HTTP3
+                RunHttp3Worker(options, share, results[static_cast<size_t>(i)]);
+#endif
+            }
+            else if (protocol == "shm")
+            {
+                RunShmWorker(options, share, results[static_cast<size_t>(i)]);
+            }
+            else
+            {
+                RunHttp1Worker(options, share, results[static_cast<size_t>(i)], protocol == "handshake");
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latencies;
+    size_t errors = 0;
+    size_t bytes = 0;
+    size_t handshakes = 0;
+    size_t resumed = 0;
+    for (const auto& result : results)
+    {
+        latencies.insert(latencies.end(), result.latencies_us.begin(), result.latencies_us.end());
+        errors += result.errors;
+        bytes += result.bytes;
+        handshakes += result.handshakes;
+        resumed += result.resumed;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    double average = 0.0;
+    for (double latency : latencies)
+    {
+        average += latency;
+    }
+    average = latencies.empty() ? 0.0 : average / static_cast<double>(latencies.size());
+
+    std::cout << std::fixed << std::setprecision(2);
+    // QUIC always runs TLS 1.3; its handshakes are reported like the TLS modes'
+    const bool tls = (!options.tls.empty() && protocol != "shm") || protocol == "h3";
+    std::cout << "=== " << (protocol == "h2c" ? (tls ? "HTTP/2 (h2)" : "HTTP/2 (h2c)") : protocol == "shm" ? "Shared-memory rings"
+                            : protocol == "h3" ? "HTTP/3 (QUIC)"
+                            : protocol == "handshake" ? "New connection per request" : "HTTP/1.1 keep-alive")
+              << (tls && protocol != "h3" ? " over TLS" : "") << " ===\n";
+    std::cout << "  Connections:    " << options.connections;
+    if (protocol == "h2c" || protocol == "h3")
+    {
+        std::cout << " x " << options.streams << " streams";
+    }
+    std::cout << "\n";
+    std::cout << "  Completed:      " << latencies.size() << " (errors: " << errors << ")\n";
+    if (tls)
+    {
+        std::cout << "  Handshakes:     " << handshakes << " (" << resumed << " resumed), "
+                  << static_cast<double>(handshakes) / seconds << "/s\n";
+    }
+    std::cout << "  Duration:       " << seconds << " s\n";
+    std::cout << "  Throughput:     " << static_cast<double>(latencies.size()) / seconds << " req/s, "
+              << static_cast<double>(bytes) / seconds / (1024.0 * 1024.0) << " MiB/s\n";
+    // Shared-memory round trips are a few microseconds; milliseconds would print zeros
+    const bool micro = protocol == "shm";
+    const double scale = micro ? 1.0 : 1000.0;
+    std::cout << (micro ? "  Latency (us):   avg " : "  Latency (ms):   avg ") << average / scale
+              << "  p50 " << Percentile(latencies, 50) / scale
+              << "  p90 " << Percentile(latencies, 90) / scale
+              << "  p99 " << Percentile(latencies, 99) / scale
+              << "  max " << (latencies.empty() ? 0.0 : latencies.back() / scale) << "\n\n";
+
+    BenchSummary summary;
+    summary.requests_per_second = static_cast<double>(latencies.size()) / seconds;
+    summary.mib_per_second = static_cast<double>(bytes) / seconds / (1024.0 * 1024.0);
+    summary.p50_ms = Percentile(latencies, 50) / 1000.0;
+    summary.p99_ms = Percentile(latencies, 99) / 1000.0;
+    summary.errors = errors;
+    return summary;
+}
+
+/**
+ * @brief Store a value of `size` bytes at `path` with PUT
+ */
+bool StoreValue(const BenchOptions& options, const std::string& path, size_t size)
+{
+    Connection connection;
+    if (!connection.Open(options))
+    {
+        return false;
+    }
+    const std::string request = "PUT " + path + " HTTP/1.1\r\nHost: " + options.host +
+                                "\r\nContent-Type: application/octet-stream\r\nContent-Length: " + std::to_string(size) +
+                                "\r\nConnection: close\r\n\r\n" + std::string(size, 'x');
+    if (!connection.WriteAll(request) || connection.FillUntil("\r\n") == std::string::npos)
+    {
+        return false;
+    }
+    return connection.Buffer().compare(0, 10, "HTTP/1.1 2") == 0;
+}
+
+/**
+ * @brief Run the HTTP/1.1 load once per body size and tabulate the results
+ *
+ * Each size is stored in the key/value service first, so the bodies are
+ * generated responses rather than files. Running the sweep against servers
+ * with different send paths (e.g. --tcp zerocopy=1 versus none) shows where
+ * one overtakes the other.
+ */
+void RunSizeSweep(const BenchOptions& options)
+{
+    std::vector<std::pair<size_t, BenchSummary>> rows;
+    for (size_t size : options.sizes)
+    {
+        BenchOptions run = options;
+        run.path = "/service/kv/mini-bench-" + std::to_string(size);
+        if (!StoreValue(options, run.path, size))
+        {
+            std::cerr << "Cannot store a " << size << "-byte value at " << run.path << "\n";
+            continue;
+        }
+        std::cout << "--- " << size << "-byte bodies ---\n";
+        rows.emplace_back(size, RunBenchmark(run, "h1"));
+    }
+
+    std::cout << "=== Body size sweep (HTTP/1.1 keep-alive) ===\n"
+              << std::setw(10) << "bytes" << std::setw(12) << "req/s" << std::setw(10) << "MiB/s"
+              << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms" << std::setw(8) << "errors" << "\n";
+    for (const auto& [size, summary] : rows)
+    {
+        std::cout << std::setw(10) << size << std::setw(12) << summary.requests_per_second
+                  << std::setw(10) << summary.mib_per_second << std::setw(10) << summary.p50_ms
+                  << std::setw(10) << summary.p99_ms << std::setw(8) << summary.errors << "\n";
+    }
+}
+
+/**
+ * @brief Datagrams the server's UDP ingest listener has received, from /api/server/stats
+ * @return false if the stats cannot be fetched or have no udpIngest section
+ */
+bool FetchIngestedDatagrams(const BenchOptions& options, uint64_t& datagrams)
+{
+    Connection connection;
+    const std::string request = "GET /api/server/stats HTTP/1.1\r\nHost: " + options.host +
+                                "\r\nAccept: application/json\r\nConnection: close\r\n\r\n";
+    if (!connection.Open(options) || !connection.WriteAll(request))
+    {
+        return false;
+    }
+    while (connection.Fill(connection.Buffer().size() + 1))
+    {
+    }
+    const std::string& reply = connection.Buffer();
+    const size_t section = reply.find("\"udpIngest\"");
+    const size_t key = section == std::string::npos ? section : reply.find("\"datagrams\":", section);
+    if (key == std::string::npos)
+    {
+        return false;
+    }
+    datagrams = std::strtoull(reply.c_str() + key + 12, nullptr, 10);
+    return true;
+}
+
+/**
+ * @brief Flood the server's UDP ingest port with statsd lines, one sender thread per -c
+ *
+ * Each thread queues 64 equal-sized datagrams at a time, so they leave in
+ * one sendmmsg call (one GSO super-datagram where supported). The
+ * server's own counter tells how many arrived.
+ */
+void RunUdpFlood(const BenchOptions& options)
+{
+    miniserver::network::UdpAddress server;
+    if (!miniserver::network::UdpAddress::Resolve(options.host, options.udp_port, server))
+    {
+        std::cerr << "--protocol udp needs a numeric IPv4 host\n";
+        return;
+    }
+    uint64_t before = 0;
+    const bool counted = FetchIngestedDatagrams(options, before);
+
+    std::atomic<uint64_t> sent{0};
+    std::vector<std::thread> senders;
+    const auto start = Clock::now();
+    for (int i = 0; i < options.connections; ++i)
+    {
+        const int share = options.requests / options.connections + (i < options.requests % options.connections ? 1 : 0);
+        senders.emplace_back([&, i, share]()
+        {
+            miniserver::network::UdpSocket socket;
+            if (!socket.Open("0.0.0.0", 0))
+            {
+                return;
+            }
+            const std::string line = "mini.bench.requests:1|c|#sender:" + std::to_string(i);
+            miniserver::network::UdpSendBatch batch;
+            uint64_t accepted = 0;
+            for (int queued = 0; queued < share;)
+            {
+                const int count = std::min(64, share - queued);
+                for (int k = 0; k < count; ++k)
+                {
+                    batch.Add(server, line);
+                }
+                accepted += socket.Send(batch);
+                queued += count;
+            }
+            sent.fetch_add(accepted);
+        });
+    }
+    for (auto& sender : senders)
+    {
+        sender.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "=== UDP ingest (statsd lines) ===\n";
+    std::cout << "  Senders:        " << options.connections << "\n";
+    std::cout << "  Sent:           " << sent.load() << " datagrams in " << seconds << " s, "
+              << static_cast<double>(sent.load()) / seconds / 1e6 << " M/s\n";
+
+    // Let the listener drain its queue before reading its counter
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    uint64_t after = 0;
+    if (counted && FetchIngestedDatagrams(options, after))
+    {
+        const uint64_t ingested = after - before;
+        std::cout << "  Ingested:       " << ingested << " ("
+                  << (sent.load() > 0 ? 100.0 * static_cast<double>(ingested) / static_cast<double>(sent.load()) : 0.0)
+                  << "% of sent), " << static_cast<double>(ingested) / seconds / 1e6 << " M/s\n\n";
+    }
+    else
+    {
+        std::cout << "  Ingested:       unknown (no udpIngest section in /api/server/stats on the TCP port)\n\n";
+    }
+}
+
+/**
+ * @brief Parse "4k,64k,1m" into byte counts
+ */
+bool ParseSizes(const std::string& spec, std::vector<size_t>& sizes)
+{
+    for (size_t start = 0; start <= spec.size();)
+    {
+        const size_t comma = std::min(spec.find(',', start), spec.size());
+        const std::string item = spec.substr(start, comma - start);
+        start = comma + 1;
+
+        char* end = nullptr;
+        size_t value = std::strtoul(item.c_str(), &end, 10);
+        if (end == item.c_str())
+        {
+            return false;
+        }
+        if (*end == 'k' || *end == 'K') { value *= 1024; ++end; }
+        else if (*end == 'm' || *end == 'M') { value *= 1024 * 1024; ++end; }
+        if (*end != '\0' || value == 0)
+        {
+            return false;
+        }
+        sizes.push_back(value);
+    }
+    return true;
+}
+
+void PrintUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --host <addr>         Server address (default 127.0.0.1)\n"
+              << "  --port <port>         Server port (default 8080)\n"
+              << "  --unix <path|@name>   Connect over a Unix domain socket instead of TCP\n"
+              << "  --path <path>         Request path (default /ping)\n"
+              << "  --protocol <p>        h1, h2c, both, handshake (new connection per request), h3, shm or udp (default both)\n"
+              << "  --udp-port <port>     UDP ingest port for --protocol udp (stats are read from --port)\n"
+              << "  --tls <full|resume>   Connect with TLS; resume offers the previous session on reconnects\n"
+              << "  --cacert <pem>        h3: verify the server certificate against these CAs (default: system store)\n"
+              << "  --insecure            h3: do not verify the server certificate chain or name\n"
+              << "  --fastopen            TCP Fast Open: send each new connection's first request in the SYN\n"
+              << "  --shm <path|@name>    Shared-memory handshake socket (selects --protocol shm)\n"
+              << "  --service <name>      Service called in shm mode (default echo)\n"
+              << "  -c <connections>      Concurrent connections (default 4)\n"
+              << "  -n <requests>         Total requests per protocol (default 20000)\n"
+              << "  -m <streams>          Concurrent streams per h2c/h3 connection (default 16, server max 100)\n"
+              << "  --sizes <n[k|m],...>  Sweep HTTP/1.1 body sizes through /service/kv (max 1m) and tabulate them\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--help" || arg == "-h")
+        {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        if (arg == "--fastopen")
+        {
+#ifdef TCP_FASTOPEN_CONNECT
+            options.fastopen = true;
+            continue;
+#else
+            std::cerr << "--fastopen: TCP_FASTOPEN_CONNECT is not supported on this platform\n";
+            return 1;
+#endif
+        }
+        if (arg == "--insecure")
+        {
+            options.insecure = true;
+            continue;
+        }
+        if (!has_value)
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+
+        const std::string value = argv[++i];
+        try
+        {
+            if (arg == "--host") options.host = value;
+            else if (arg == "--port") options.port = std::stoi(value);
+            else if (arg == "--unix") options.unix_path = value;
+            else if (arg == "--shm") { options.shm_path = value; options.protocol = "shm"; }
+            else if (arg == "--service") options.service = value;
+            else if (arg == "--path") options.path = value;
+            else if (arg == "--protocol") options.protocol = value;
+            else if (arg == "-c") options.connections = std::max(1, std::stoi(value));
+            else if (arg == "-n") options.requests = std::max(1, std::stoi(value));
+            else if (arg == "-m") options.streams = std::max(1, std::stoi(value));
+            else if (arg == "--tls" && (value == "full" || value == "resume")) options.tls = value;
+            else if (arg == "--cacert") options.ca_file = value;
+            else if (arg == "--udp-port") options.udp_port = std::stoi(value);
+            else if (arg == "--sizes" && ParseSizes(value, options.sizes)) options.protocol = "sizes";
+            else
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        catch (const std::exception&)
+        {
+            std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+            return 1;
+        }
+    }
+
+    if (!options.tls.empty())
+    {
+#ifdef MINISERVER_HAS_OPENSSL
+        // Throughput and handshake cost only: the server certificate is not verified
+        options.tls_context = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_verify(options.tls_context, SSL_VERIFY_NONE, nullptr);
+        SSL_CTX_set_session_cache_mode(options.tls_context, SSL_SESS_CACHE_OFF);
+#else
+        std::cerr << "--tls: built without OpenSSL\n";
+        return 1;
+#endif
+    }
+
+    if (options.protocol == "shm")
+    {
+        std::cout << "Target: shm:" << options.shm_path << " service " << options.service;
+    }
+    else if (options.unix_path.empty())
+    {
+        std::cout << "Target: " << (options.tls.empty() && options.protocol != "h3" ? "http://" : "https://") << options.host << ":" << options.port << options.path;
+    }
+    else
+    {
+        std::cout << "Target: unix:" << options.unix_path << " " << options.path;
+    }
+    std::cout << ", " << options.requests << " requests\n\n";
+
+    if (options.protocol == "udp")
+    {
+        RunUdpFlood(options);
+    }
+    if (options.protocol == "sizes")
+    {
+        RunSizeSweep(options);
+    }
+    if (options.protocol == "h1" || options.protocol == "both")
+    {
+        RunBenchmark(options, "h1");
+    }
+    if (options.protocol == "h2c" || options.protocol == "both")
+    {
+        RunBenchmark(options, "h2c");
+    }
+    if (options.protocol == "handshake")
+    {
+        RunBenchmark(options, "handshake");
+    }
+    if (options.protocol == "h3")
+    {
+#ifdef MINISERVER_HAS_HTTP3
+        RunBenchmark(options, "h3");
+#else
+        std::cerr << "--protocol h3: configure with -DMINISERVER_EXPERIMENTAL_HTTP3=ON (needs OpenSSL)\n";
+#endif
+    }
+    if (options.protocol == "shm")
+    {
+        RunBenchmark(options, "shm");
+    }
+#ifdef MINISERVER_HAS_OPENSSL
+    SSL_CTX_free(options.tls_context);
+#endif
+    return 0;
+}
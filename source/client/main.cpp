@@ -14,6 +14,17 @@
 #include <thread>
 #include <sstream>
 #include <iomanip>
+#include <cstring>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <cctype>
+#include <atomic>
+#include <functional>
+
+#ifdef MINISERVER_HAS_ZLIB
+#include <zlib.h>
+#endif
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -24,6 +35,8 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <netdb.h>
+#include <sys/un.h>
+#include <csignal>
 #endif
 
 class HttpClient
@@ -77,11 +90,43 @@ public:
             oss << "Body: " << body << "\n";
             return oss.str();
         }
+        
+        std::string GetHeader(const std::string& name) const
+        {
+            std::istringstream iss(headers);
+            std::string line;
+            while (std::getline(iss, line))
+            {
+                const size_t colon = line.find(':');
+                if (colon != name.length() ||
+                    !std::equal(name.begin(), name.end(), line.begin(), [](char a, char b) {
+                        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+                    }))
+                {
+                    continue;
+                }
+                size_t start = colon + 1;
+                while (start < line.length() && line[start] == ' ')
+                {
+                    start++;
+                }
+                size_t end = line.length();
+                while (end > start && (line[end - 1] == '\r' || line[end - 1] == ' '))
+                {
+                    end--;
+                }
+                return line.substr(start, end - start);
+            }
+            return "";
+        }
     };
+    
+    using HeaderList = std::vector<std::pair<std::string, std::string>>;
 
     HttpResponse SendRequest(const std::string& method, const std::string& path, 
                            const std::string& body = "", 
-                           const std::string& content_type = "text/plain")
+                           const std::string& content_type = "text/plain",
+                           const HeaderList& extra_headers = {})
     {
         HttpResponse response;
         
@@ -124,6 +169,10 @@ public:
             request_stream << "Host: " << host_ << ":" << port_ << "\r\n";
             request_stream << "User-Agent: MiniServer-TestClient/1.0\r\n";
             request_stream << "Connection: close\r\n";
+            for (const auto& [name, value] : extra_headers)
+            {
+                request_stream << name << ": " << value << "\r\n";
+            }
             
             if (!body.empty())
             {
@@ -161,8 +210,7 @@ public:
             while ((bytes_received = recv(sock, buffer, sizeof(buffer) - 1, 0)) > 0)
 #endif
             {
-                buffer[bytes_received] = '\0';
-                response_str += buffer;
+                response_str.append(buffer, bytes_received);
             }
 
             // Parse response
@@ -187,6 +235,176 @@ public:
         return response;
     }
 
+#ifdef _WIN32
+    using SocketHandle = SOCKET;
+#else
+    using SocketHandle = int;
+#endif
+
+    /**
+     * Open a raw connection for protocol tests (upgrades, tunnels, streams);
+     * reads on it give up after receive_timeout_ms
+     */
+    SocketHandle OpenConnection(int receive_timeout_ms = 3000)
+    {
+        SocketHandle sock = socket(AF_INET, SOCK_STREAM, 0);
+#ifdef _WIN32
+        if (sock == INVALID_SOCKET)
+#else
+        if (sock < 0)
+#endif
+        {
+            throw std::runtime_error("Failed to create socket");
+        }
+
+        struct sockaddr_in server_addr;
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(port_);
+        struct hostent* server = gethostbyname(host_.c_str());
+        if (server == nullptr || server->h_addrtype != AF_INET)
+        {
+            CloseConnection(sock);
+            throw std::runtime_error("Failed to resolve hostname: " + host_);
+        }
+        memcpy(&server_addr.sin_addr.s_addr, server->h_addr, server->h_length);
+        if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0)
+        {
+            CloseConnection(sock);
+            throw std::runtime_error("Failed to connect to server");
+        }
+
+#ifdef _WIN32
+        DWORD timeout = receive_timeout_ms;
+#else
+        struct timeval timeout;
+        timeout.tv_sec = receive_timeout_ms / 1000;
+        timeout.tv_usec = (receive_timeout_ms % 1000) * 1000;
+#endif
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+        return sock;
+    }
+
+    /**
+     * Send one UDP datagram to the server host
+     */
+    bool SendDatagram(int port, const std::string& payload)
+    {
+        struct sockaddr_in server_addr;
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(port);
+        struct hostent* server = gethostbyname(host_.c_str());
+        if (server == nullptr || server->h_addrtype != AF_INET)
+        {
+            return false;
+        }
+        memcpy(&server_addr.sin_addr.s_addr, server->h_addr, server->h_length);
+
+        SocketHandle sock = socket(AF_INET, SOCK_DGRAM, 0);
+#ifdef _WIN32
+        if (sock == INVALID_SOCKET)
+#else
+        if (sock < 0)
+#endif
+        {
+            return false;
+        }
+        const bool sent = sendto(sock, payload.data(), static_cast<int>(payload.length()), 0,
+                                 (struct sockaddr*)&server_addr, sizeof(server_addr)) == static_cast<int>(payload.length());
+        CloseConnection(sock);
+        return sent;
+    }
+
+#ifndef _WIN32
+    /**
+     * Open a raw connection to a Unix domain socket ('@' prefix: abstract namespace)
+     */
+    static SocketHandle OpenLocalConnection(const std::string& path, int receive_timeout_ms = 3000)
+    {
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.length() >= sizeof(address.sun_path))
+        {
+            throw std::runtime_error("Invalid Unix socket path: " + path);
+        }
+        memcpy(address.sun_path, path.data(), path.length());
+        socklen_t length = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + path.length() + 1);
+        if (path.front() == '@')
+        {
+            address.sun_path[0] = '\0';
+            length -= 1;
+        }
+
+        SocketHandle sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock < 0)
+        {
+            throw std::runtime_error("Failed to create socket");
+        }
+        if (connect(sock, (struct sockaddr*)&address, length) < 0)
+        {
+            CloseConnection(sock);
+            throw std::runtime_error("Failed to connect to " + path);
+        }
+        struct timeval timeout;
+        timeout.tv_sec = receive_timeout_ms / 1000;
+        timeout.tv_usec = (receive_timeout_ms % 1000) * 1000;
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return sock;
+    }
+#endif
+
+    static bool SendRaw(SocketHandle sock, const std::string& data)
+    {
+        size_t sent = 0;
+        while (sent < data.length())
+        {
+            const int result = send(sock, data.data() + sent, static_cast<int>(data.length() - sent), 0);
+            if (result <= 0)
+            {
+                return false;
+            }
+            sent += static_cast<size_t>(result);
+        }
+        return true;
+    }
+
+    /**
+     * Append the next bytes to data; false on close, error or timeout
+     */
+    static bool ReceiveMore(SocketHandle sock, std::string& data)
+    {
+        char buffer[4096];
+        const int received = recv(sock, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        data.append(buffer, received);
+        return true;
+    }
+
+    static bool ReceiveUntil(SocketHandle sock, std::string& data, const std::string& marker)
+    {
+        while (data.find(marker) == std::string::npos)
+        {
+            if (!ReceiveMore(sock, data))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void CloseConnection(SocketHandle sock)
+    {
+#ifdef _WIN32
+        closesocket(sock);
+#else
+        close(sock);
+#endif
+    }
+
 private:
     void ParseHttpResponse(const std::string& response_str, HttpResponse& response)
     {
@@ -219,34 +437,170 @@ private:
         }
         response.headers = headers_stream.str();
 
-        // Parse body
-        std::ostringstream body_stream;
-        while (std::getline(iss, line))
+        // Parse body (kept byte-exact: compressed bodies are binary)
+        const size_t body_start = response_str.find("\r\n\r\n");
+        response.body = body_start != std::string::npos ? response_str.substr(body_start + 4) : "";
+    }
+};
+
+/**
+ * Minimal HTTP/1.1 upstream on 127.0.0.1 for the reverse proxy tests.
+ * The handler picks the status for each request target and may delay;
+ * status 0 closes the connection without answering.
+ */
+class TestUpstream
+{
+public:
+    using Handler = std::function<int(const std::string& target, std::string& body)>;
+
+    TestUpstream(int port, Handler handler)
+        : handler_(std::move(handler)), running_(false), listener_(static_cast<HttpClient::SocketHandle>(-1))
+    {
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        const int reuse = 1;
+        setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+        
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listener_, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listener_, 64) < 0)
+        {
+            HttpClient::CloseConnection(listener_);
+            throw std::runtime_error("Cannot listen on upstream port " + std::to_string(port));
+        }
+        running_ = true;
+        accept_thread_ = std::thread([this]() { AcceptLoop(); });
+    }
+
+    ~TestUpstream()
+    {
+        running_ = false;
+        accept_thread_.join();
+        for (auto& thread : connection_threads_)
+        {
+            thread.join();
+        }
+        HttpClient::CloseConnection(listener_);
+    }
+
+    TestUpstream(const TestUpstream&) = delete;
+    TestUpstream& operator=(const TestUpstream&) = delete;
+
+private:
+    void AcceptLoop()
+    {
+        while (running_)
         {
-            body_stream << line << "\n";
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(listener_, &readable);
+            struct timeval timeout = {0, 100 * 1000};
+            if (select(static_cast<int>(listener_) + 1, &readable, nullptr, nullptr, &timeout) <= 0)
+            {
+                continue;
+            }
+            const HttpClient::SocketHandle connection = accept(listener_, nullptr, nullptr);
+#ifdef _WIN32
+            if (connection == INVALID_SOCKET)
+#else
+            if (connection < 0)
+#endif
+            {
+                continue;
+            }
+            connection_threads_.emplace_back([this, connection]() { Serve(connection); });
         }
-        response.body = body_stream.str();
+    }
+
+    void Serve(HttpClient::SocketHandle connection)
+    {
+#ifdef _WIN32
+        DWORD timeout = 100;
+#else
+        struct timeval timeout = {0, 100 * 1000};
+#endif
+        setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
         
-        // Remove trailing newline if present
-        if (!response.body.empty() && response.body.back() == '\n')
+        std::string buffer;
+        while (running_)
         {
-            response.body.pop_back();
+            const size_t head_end = buffer.find("\r\n\r\n");
+            if (head_end == std::string::npos)
+            {
+                char chunk[4096];
+                const int received = recv(connection, chunk, sizeof(chunk), 0);
+                if (received == 0)
+                {
+                    break;
+                }
+                if (received > 0)
+                {
+                    buffer.append(chunk, received);
+                }
+                continue;
+            }
+            
+            // Requests from the proxy tests carry no body
+            const size_t target_start = buffer.find(' ') + 1;
+            const std::string target = buffer.substr(target_start, buffer.find(' ', target_start) - target_start);
+            buffer.erase(0, head_end + 4);
+            
+            std::string body;
+            const int status = handler_(target, body);
+            if (status == 0)
+            {
+                break;
+            }
+            const std::string response = "HTTP/1.1 " + std::to_string(status) + " " + (status < 400 ? "OK" : "Error") +
+                                         "\r\nContent-Type: text/plain\r\nContent-Length: " +
+                                         std::to_string(body.length()) + "\r\n\r\n" + body;
+            if (!HttpClient::SendRaw(connection, response))
+            {
+                break;
+            }
         }
+        HttpClient::CloseConnection(connection);
     }
+
+    Handler handler_;
+    std::atomic<bool> running_;
+    HttpClient::SocketHandle listener_;
+    std::thread accept_thread_;
+    std::vector<std::thread> connection_threads_;
+};
+
+/**
+ * Optional server features the test client can exercise; each matches the
+ * server option it was started with
+ */
+struct TestOptions
+{
+    std::vector<int> upstream_ports;    ///< --upstreams: the server proxies /test-client to 127.0.0.1 on these ports
+    std::string unix_path;              ///< --unix: the server also listens on this Unix socket
+    int admin_port = 0;                 ///< --admin: the admin endpoints moved to this port
+    int connect_port = 0;               ///< --connect: CONNECT tunnels to this loopback port are allowed
 };
 
 class TestClient
 {
 private:
     HttpClient client_;
+    TestOptions options_;
+    std::unique_ptr<HttpClient> admin_client_;
     int total_tests_;
     int passed_tests_;
     int failed_tests_;
 
 public:
-    TestClient(const std::string& host = "localhost", int port = 8080)
-        : client_(host, port), total_tests_(0), passed_tests_(0), failed_tests_(0)
+    TestClient(const std::string& host = "localhost", int port = 8080, const TestOptions& options = TestOptions())
+        : client_(host, port), options_(options), total_tests_(0), passed_tests_(0), failed_tests_(0)
     {
+        if (options_.admin_port > 0)
+        {
+            admin_client_ = std::make_unique<HttpClient>(host, options_.admin_port);
+        }
     }
 
     void RunAllTests()
@@ -266,6 +620,39 @@ public:
         TestReverseService();
         TestLengthService();
         
+        // Test the built-in key/value service
+        TestKvPutGetDelete();
+        TestKvTtlExpiry();
+        TestKvMultiGet();
+        TestKvEviction();
+        
+        // Test content negotiation and coding
+        TestStructuredEncoding();
+        TestResponseCompression();
+        TestRequestDecompression();
+        TestDecompressionLimit();
+        
+        // Test protocol upgrades
+        TestH2cPriorKnowledge();
+        TestH2cUpgrade();
+        TestWebSocketEcho();
+        TestServerSentEvents();
+        
+        // Test listeners and their statistics
+        TestListenerStats();
+        TestZeroCopySend();
+        TestUdpIngest();
+        TestUnixSocket();
+        TestAdminListener();
+        
+        // Test CONNECT tunneling
+        TestConnectTunnel();
+        
+        // Test the reverse proxy against upstreams served by this client
+        TestProxyHedging();
+        TestProxyEjection();
+        TestProxyRetry();
+        
         // Test error cases
         TestNonExistentService();
         TestInvalidMethod();
@@ -461,127 +848,1551 @@ private:
         std::cout << std::endl;
     }
 
-    void TestNonExistentService()
+    void TestKvPutGetDelete()
     {
-        std::cout << "Testing non-existent service (should return 404)..." << std::endl;
+        std::cout << "Testing /service/kv PUT/GET/DELETE..." << std::endl;
+        
+        const std::string path = "/service/kv/test-client:basic";
+        const std::string value = "hello kv";
         
         try
         {
-            auto response = client_.SendRequest("POST", "/service/nonexistent", "test");
+            auto put = client_.SendRequest("PUT", path, value);
+            auto get = client_.SendRequest("GET", path);
+            auto del = client_.SendRequest("DELETE", path);
+            auto gone = client_.SendRequest("GET", path);
             
-            if (response.status_code == 404)
+            if ((put.status_code == 201 || put.status_code == 204) && get.status_code == 200 && get.body == value &&
+                del.status_code == 204 && gone.status_code == 404)
             {
-                std::cout << "✓ PASS: Non-existent service correctly returned 404" << std::endl;
-                std::cout << "  Response: " << response.body << std::endl;
+                std::cout << "✓ PASS: Key/value round trip successful" << std::endl;
+                std::cout << "  PUT " << put.status_code << ", GET " << get.status_code << " '" << get.body
+                          << "', DELETE " << del.status_code << ", GET " << gone.status_code << std::endl;
                 RecordTest(true);
             }
             else
             {
-                std::cout << "✗ FAIL: Non-existent service returned unexpected status " << response.status_code << std::endl;
-                std::cout << "  Response: " << response.body << std::endl;
+                std::cout << "✗ FAIL: Key/value round trip returned PUT " << put.status_code << ", GET " << get.status_code
+                          << " '" << get.body << "', DELETE " << del.status_code << ", GET " << gone.status_code << std::endl;
                 RecordTest(false);
             }
         }
         catch (const std::exception& e)
         {
-            std::cout << "✗ FAIL: Non-existent service test threw exception: " << e.what() << std::endl;
+            std::cout << "✗ FAIL: Key/value round trip threw exception: " << e.what() << std::endl;
             RecordTest(false);
         }
         std::cout << std::endl;
     }
 
-    void TestInvalidMethod()
+    void TestKvTtlExpiry()
     {
-        std::cout << "Testing invalid method on service endpoint..." << std::endl;
+        std::cout << "Testing /service/kv TTL expiry (waits 2 seconds)..." << std::endl;
+        
+        const std::string path = "/service/kv/test-client:ttl";
         
         try
         {
-            auto response = client_.SendRequest("GET", "/service/echo");
+            auto put = client_.SendRequest("PUT", path + "?ttl=1", "short-lived");
+            auto live = client_.SendRequest("GET", path);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+            auto expired = client_.SendRequest("GET", path);
             
-            if (response.status_code == 405 || response.status_code == 400)
+            if ((put.status_code == 201 || put.status_code == 204) && live.status_code == 200 && expired.status_code == 404)
             {
-                std::cout << "✓ PASS: Invalid method correctly returned " << response.status_code << std::endl;
-                std::cout << "  Response: " << response.body << std::endl;
+                std::cout << "✓ PASS: Key expired after its TTL" << std::endl;
                 RecordTest(true);
             }
             else
             {
-                std::cout << "✗ FAIL: Invalid method returned unexpected status " << response.status_code << std::endl;
-                std::cout << "  Response: " << response.body << std::endl;
+                std::cout << "✗ FAIL: TTL test returned PUT " << put.status_code << ", GET " << live.status_code
+                          << ", GET after expiry " << expired.status_code << std::endl;
                 RecordTest(false);
             }
         }
         catch (const std::exception& e)
         {
-            std::cout << "✗ FAIL: Invalid method test threw exception: " << e.what() << std::endl;
+            std::cout << "✗ FAIL: TTL test threw exception: " << e.what() << std::endl;
             RecordTest(false);
         }
         std::cout << std::endl;
     }
 
-    void RecordTest(bool passed)
+    void TestKvMultiGet()
     {
-        total_tests_++;
-        if (passed)
+        std::cout << "Testing /service/kv multi-get..." << std::endl;
+        
+        try
         {
-            passed_tests_++;
+            client_.SendRequest("PUT", "/service/kv/test-client:a", "1");
+            client_.SendRequest("PUT", "/service/kv/test-client:b", "2");
+            client_.SendRequest("DELETE", "/service/kv/test-client:missing");
+            auto response = client_.SendRequest("GET", "/service/kv?keys=test-client:a,test-client:b,test-client:missing");
+            
+            if (response.status_code == 200 &&
+                response.body.find("\"test-client:a\":\"1\"") != std::string::npos &&
+                response.body.find("\"test-client:b\":\"2\"") != std::string::npos &&
+                response.body.find("\"test-client:missing\":null") != std::string::npos)
+            {
+                std::cout << "✓ PASS: Multi-get returned every key" << std::endl;
+                std::cout << "  Response: " << response.body << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: Multi-get returned status " << response.status_code << std::endl;
+                std::cout << "  Response: " << response.body << std::endl;
+                RecordTest(false);
+            }
+            client_.SendRequest("DELETE", "/service/kv/test-client:a");
+            client_.SendRequest("DELETE", "/service/kv/test-client:b");
         }
-        else
+        catch (const std::exception& e)
         {
-            failed_tests_++;
+            std::cout << "✗ FAIL: Multi-get test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
         }
+        std::cout << std::endl;
     }
 
-    void PrintTestSummary()
+    void TestKvEviction()
     {
-        std::cout << "=== Test Summary ===" << std::endl;
-        std::cout << "Total tests: " << total_tests_ << std::endl;
-        std::cout << "Passed: " << passed_tests_ << std::endl;
-        std::cout << "Failed: " << failed_tests_ << std::endl;
+        std::cout << "Testing /service/kv eviction under the memory cap..." << std::endl;
         
-        double success_rate = total_tests_ > 0 ? (double)passed_tests_ / total_tests_ * 100.0 : 0.0;
-        std::cout << std::fixed << std::setprecision(1);
-        std::cout << "Success rate: " << success_rate << "%" << std::endl;
+        const size_t value_size = 256 * 1024;
+        const std::string value(value_size, 'x');
         
-        if (failed_tests_ == 0)
+        try
         {
-            std::cout << "\n🎉 All tests passed! Server is working correctly." << std::endl;
+            auto before = client_.SendRequest("GET", "/service/kv");
+            const long long max_memory = JsonNumber(before.body, "maxMemoryBytes");
+            const long long evictions_before = JsonNumber(before.body, "evictions");
+            if (before.status_code != 200 || max_memory <= 0 || evictions_before < 0)
+            {
+                std::cout << "✗ FAIL: Key/value statistics unavailable (status " << before.status_code << ")" << std::endl;
+                std::cout << "  Response: " << before.body << std::endl;
+                RecordTest(false);
+                std::cout << std::endl;
+                return;
+            }
+            
+            // Write twice the cap: every shard has to evict to stay within its slice
+            const size_t writes = static_cast<size_t>(max_memory) * 2 / value_size + 1;
+            size_t rejected = 0;
+            for (size_t i = 0; i < writes; ++i)
+            {
+                auto put = client_.SendRequest("PUT", "/service/kv/test-client:fill:" + std::to_string(i), value);
+                if (put.status_code != 201 && put.status_code != 204)
+                {
+                    ++rejected;
+                }
+            }
+            
+            auto after = client_.SendRequest("GET", "/service/kv");
+            const long long memory = JsonNumber(after.body, "memoryBytes");
+            const long long evictions = JsonNumber(after.body, "evictions");
+            
+            for (size_t i = 0; i < writes; ++i)
+            {
+                client_.SendRequest("DELETE", "/service/kv/test-client:fill:" + std::to_string(i));
+            }
+            
+            if (rejected == 0 && evictions > evictions_before && memory >= 0 && memory <= max_memory)
+            {
+                std::cout << "✓ PASS: Store stayed within its cap (" << memory << " of " << max_memory
+                          << " bytes, " << (evictions - evictions_before) << " evictions)" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: After " << writes << " writes (" << rejected << " rejected) the store holds "
+                          << memory << " of " << max_memory << " bytes with " << (evictions - evictions_before)
+                          << " evictions" << std::endl;
+                RecordTest(false);
+            }
         }
-        else
+        catch (const std::exception& e)
         {
-            std::cout << "\n⚠️  Some tests failed. Please check the server implementation." << std::endl;
+            std::cout << "✗ FAIL: Eviction test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
         }
+        std::cout << std::endl;
     }
-};
-
-int main(int argc, char* argv[])
-{
-    std::string host = "localhost";
-    int port = 8080;
 
-    // Parse command line arguments
-    if (argc > 1)
-    {
-        host = argv[1];
-    }
-    if (argc > 2)
+    void TestStructuredEncoding()
     {
+        std::cout << "Testing CBOR and MessagePack response encoding (Accept)..." << std::endl;
+        
         try
         {
-            port = std::stoi(argv[2]);
+            auto cbor = client_.SendRequest("GET", "/ping", "", "text/plain", {{"Accept", "application/cbor"}});
+            auto msgpack = client_.SendRequest("GET", "/ping", "", "text/plain", {{"Accept", "application/msgpack"}});
+            auto cbor_error = client_.SendRequest("POST", "/service/nonexistent", "test", "text/plain",
+                                                  {{"Accept", "application/cbor"}});
+            
+            // /ping is a four-member map, the error body a one-member map: CBOR 0xa4/0xa1, MessagePack fixmap 0x84
+            const bool cbor_ok = cbor.status_code == 200 && cbor.GetHeader("Content-Type") == "application/cbor" &&
+                                 !cbor.body.empty() && static_cast<uint8_t>(cbor.body[0]) == 0xA4 &&
+                                 cbor.body.find("\x64ping") != std::string::npos;
+            const bool msgpack_ok = msgpack.status_code == 200 && msgpack.GetHeader("Content-Type") == "application/msgpack" &&
+                                    !msgpack.body.empty() && static_cast<uint8_t>(msgpack.body[0]) == 0x84 &&
+                                    msgpack.body.find("\xa4ping") != std::string::npos;
+            const bool error_ok = cbor_error.status_code == 404 && cbor_error.GetHeader("Content-Type") == "application/cbor" &&
+                                  !cbor_error.body.empty() && static_cast<uint8_t>(cbor_error.body[0]) == 0xA1;
+            
+            if (cbor_ok && msgpack_ok && error_ok)
+            {
+                std::cout << "✓ PASS: /ping encoded as CBOR (" << cbor.body.length() << " bytes) and MessagePack ("
+                          << msgpack.body.length() << " bytes); 404 body encoded as CBOR" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: CBOR /ping " << cbor.status_code << " '" << cbor.GetHeader("Content-Type")
+                          << "', MessagePack /ping " << msgpack.status_code << " '" << msgpack.GetHeader("Content-Type")
+                          << "', CBOR error " << cbor_error.status_code << " '" << cbor_error.GetHeader("Content-Type")
+                          << "'" << std::endl;
+                RecordTest(false);
+            }
         }
         catch (const std::exception& e)
         {
-            std::cerr << "Invalid port number: " << argv[2] << std::endl;
-            return 1;
+            std::cout << "✗ FAIL: Structured encoding test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestResponseCompression()
+    {
+        std::cout << "Testing gzip response compression (Accept-Encoding)..." << std::endl;
+        
+        std::string input;
+        while (input.length() < 16 * 1024)
+        {
+            input += "mini-server compresses repetitive responses. ";
         }
+        
+        try
+        {
+            auto response = client_.SendRequest("POST", "/service/echo", input, "text/plain", {{"Accept-Encoding", "gzip"}});
+            const std::string coding = response.GetHeader("Content-Encoding");
+            
+#ifdef MINISERVER_HAS_ZLIB
+            std::string decoded;
+            const bool round_trip = GzipDecompress(response.body, decoded) && decoded.find(input) != std::string::npos;
+#else
+            // Without zlib only the gzip member header can be checked
+            const bool round_trip = response.body.compare(0, 2, "\x1f\x8b") == 0;
+#endif
+            if (response.status_code == 200 && coding == "gzip" && round_trip && response.body.length() < input.length())
+            {
+                std::cout << "✓ PASS: Response was gzip-encoded (" << input.length() << " byte input, "
+                          << response.body.length() << " bytes on the wire)" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: Compressed echo returned status " << response.status_code << ", Content-Encoding '"
+                          << coding << "', " << response.body.length() << " body bytes" << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Response compression test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestRequestDecompression()
+    {
+        std::cout << "Testing gzip-encoded request body (Content-Encoding)..." << std::endl;
+        
+#ifdef MINISERVER_HAS_ZLIB
+        const std::string input = "compressed request body for the echo service";
+        
+        try
+        {
+            std::string compressed;
+            if (!GzipCompress(input, compressed))
+            {
+                throw std::runtime_error("gzip compression failed");
+            }
+            auto response = client_.SendRequest("POST", "/service/echo", compressed, "text/plain",
+                                                {{"Content-Encoding", "gzip"}});
+            
+            if (response.status_code == 200 && response.body.find("\"output\":\"" + input + "\"") != std::string::npos)
+            {
+                std::cout << "✓ PASS: Server inflated the request body before dispatch" << std::endl;
+                std::cout << "  Response: " << response.body << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: Compressed request returned status " << response.status_code << std::endl;
+                std::cout << "  Response: " << response.body << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Request decompression test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+#else
+        std::cout << "- SKIP: test client built without zlib" << std::endl;
+#endif
+        std::cout << std::endl;
+    }
+
+    void TestDecompressionLimit()
+    {
+        std::cout << "Testing oversized gzip request body (should return 413)..." << std::endl;
+        
+#ifdef MINISERVER_HAS_ZLIB
+        try
+        {
+            // 32 MiB of zeros deflates to ~32 KiB: past both the size and the ratio limit
+            std::string bomb;
+            if (!GzipCompress(std::string(32 * 1024 * 1024, '\0'), bomb))
+            {
+                throw std::runtime_error("gzip compression failed");
+            }
+            auto response = client_.SendRequest("POST", "/service/echo", bomb, "text/plain", {{"Content-Encoding", "gzip"}});
+            
+            if (response.status_code == 413)
+            {
+                std::cout << "✓ PASS: " << bomb.length() << " byte gzip bomb was rejected with 413" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: gzip bomb returned status " << response.status_code << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Decompression limit test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+#else
+        std::cout << "- SKIP: test client built without zlib" << std::endl;
+#endif
+        std::cout << std::endl;
+    }
+
+    void TestH2cPriorKnowledge()
+    {
+        std::cout << "Testing HTTP/2 cleartext with prior knowledge..." << std::endl;
+        
+        try
+        {
+            auto sock = client_.OpenConnection();
+            std::string body;
+            const bool sent = HttpClient::SendRaw(sock, std::string(kH2Preface) + H2Frame(0x4, 0, 0, "") +
+                                                            H2Frame(0x1, 0x5, 1, H2PingRequestBlock()));
+            const int status = sent ? ReadH2Response(sock, body) : 0;
+            HttpClient::CloseConnection(sock);
+            
+            if (status == 200 && body.find("\"message\":\"ping\"") != std::string::npos)
+            {
+                std::cout << "✓ PASS: GET /ping over h2c returned :status 200" << std::endl;
+                std::cout << "  Response: " << body << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: h2c prior-knowledge request returned :status " << status << std::endl;
+                std::cout << "  Response: " << body << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: h2c prior-knowledge test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestH2cUpgrade()
+    {
+        std::cout << "Testing HTTP/1.1 Upgrade to h2c..." << std::endl;
+        
+        try
+        {
+            auto sock = client_.OpenConnection();
+            std::string head;
+            std::string body;
+            int status = 0;
+            // SETTINGS_MAX_CONCURRENT_STREAMS=100, INITIAL_WINDOW_SIZE=1 GiB, ENABLE_PUSH=0
+            const bool upgraded =
+                HttpClient::SendRaw(sock, "GET /ping HTTP/1.1\r\nHost: localhost\r\n"
+                                          "Connection: Upgrade, HTTP2-Settings\r\nUpgrade: h2c\r\n"
+                                          "HTTP2-Settings: AAMAAABkAARAAAAAAAIAAAAA\r\n\r\n") &&
+                HttpClient::ReceiveUntil(sock, head, "\r\n\r\n") && head.compare(0, 12, "HTTP/1.1 101") == 0;
+            if (upgraded && HttpClient::SendRaw(sock, std::string(kH2Preface) + H2Frame(0x4, 0, 0, "")))
+            {
+                // The upgraded request is answered on stream 1
+                std::string frames = head.substr(head.find("\r\n\r\n") + 4);
+                status = ReadH2Response(sock, body, frames);
+            }
+            HttpClient::CloseConnection(sock);
+            
+            if (upgraded && status == 200 && body.find("\"message\":\"ping\"") != std::string::npos)
+            {
+                std::cout << "✓ PASS: Server switched to h2c and answered the upgraded request" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: h2c upgrade returned '" << head.substr(0, head.find("\r\n")) << "', :status "
+                          << status << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: h2c upgrade test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestWebSocketEcho()
+    {
+        std::cout << "Testing WebSocket upgrade and echo on /ws/echo..." << std::endl;
+        
+        const std::string message = "hello over websocket";
+        
+        try
+        {
+            auto sock = client_.OpenConnection();
+            std::string head;
+            // Key and accept value from the RFC 6455 handshake example
+            const bool upgraded =
+                HttpClient::SendRaw(sock, "GET /ws/echo HTTP/1.1\r\nHost: localhost\r\nConnection: Upgrade\r\n"
+                                          "Upgrade: websocket\r\nSec-WebSocket-Version: 13\r\n"
+                                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n") &&
+                HttpClient::ReceiveUntil(sock, head, "\r\n\r\n") && head.compare(0, 12, "HTTP/1.1 101") == 0 &&
+                head.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") != std::string::npos;
+            
+            std::string frames = upgraded ? head.substr(head.find("\r\n\r\n") + 4) : "";
+            std::string echoed;
+            uint8_t opcode = 0;
+            if (upgraded && HttpClient::SendRaw(sock, WebSocketFrame(0x1, message)))
+            {
+                opcode = ReadWebSocketFrame(sock, frames, echoed);
+            }
+            uint8_t close_opcode = 0;
+            if (opcode == 0x1 && HttpClient::SendRaw(sock, WebSocketFrame(0x8, "")))
+            {
+                std::string reason;
+                close_opcode = ReadWebSocketFrame(sock, frames, reason);
+            }
+            HttpClient::CloseConnection(sock);
+            
+            if (upgraded && opcode == 0x1 && echoed == message && close_opcode == 0x8)
+            {
+                std::cout << "✓ PASS: Handshake accepted and text frame echoed: " << echoed << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: WebSocket returned '" << head.substr(0, head.find("\r\n")) << "', opcode "
+                          << static_cast<int>(opcode) << " '" << echoed << "', close opcode "
+                          << static_cast<int>(close_opcode) << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: WebSocket test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestServerSentEvents()
+    {
+        std::cout << "Testing Server-Sent Events on /events/clock (waits for 2 ticks)..." << std::endl;
+        
+        try
+        {
+            auto sock = client_.OpenConnection();
+            std::string stream;
+            const bool opened =
+                HttpClient::SendRaw(sock, "GET /events/clock HTTP/1.1\r\nHost: localhost\r\nAccept: text/event-stream\r\n\r\n") &&
+                HttpClient::ReceiveUntil(sock, stream, "\r\n\r\n");
+            const std::string head = stream.substr(0, stream.find("\r\n\r\n"));
+            
+            // Events are separated by a blank line; wait for two ticks
+            size_t ticks = 0;
+            size_t pos = 0;
+            while (opened && ticks < 2)
+            {
+                const size_t event = stream.find("event: tick\n", pos);
+                const size_t end = event == std::string::npos ? std::string::npos : stream.find("\n\n", event);
+                if (end != std::string::npos)
+                {
+                    ticks++;
+                    pos = end + 2;
+                }
+                else if (!HttpClient::ReceiveMore(sock, stream))
+                {
+                    break;
+                }
+            }
+            HttpClient::CloseConnection(sock);
+            
+            if (opened && head.compare(0, 12, "HTTP/1.1 200") == 0 &&
+                head.find("Content-Type: text/event-stream") != std::string::npos && ticks == 2)
+            {
+                std::cout << "✓ PASS: Received " << ticks << " tick events" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: Event stream returned '" << head.substr(0, head.find("\r\n")) << "' and "
+                          << ticks << " tick events" << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Server-Sent Events test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestProxyRetry()
+    {
+        std::cout << "Testing reverse proxy retries past a failing upstream..." << std::endl;
+        
+        if (options_.upstream_ports.size() < 2)
+        {
+            std::cout << "- SKIP: needs --upstreams <port>,<port> (server: --proxy /test-client=127.0.0.1:<port>,127.0.0.1:<port>)"
+                      << std::endl << std::endl;
+            return;
+        }
+        
+        try
+        {
+            // The first upstream drops every proxied request unanswered; the others answer.
+            // After TestProxyEjection the last one is ejected, so the first takes each request
+            // and the answer only arrives through a retry.
+            std::atomic<int> dropped(0);
+            std::vector<std::unique_ptr<TestUpstream>> upstreams;
+            for (size_t i = 0; i < options_.upstream_ports.size(); ++i)
+            {
+                upstreams.push_back(std::make_unique<TestUpstream>(options_.upstream_ports[i],
+                    [i, &dropped](const std::string& target, std::string& body) {
+                        if (i == 0 && target != "/")
+                        {
+                            dropped++;
+                            return 0;
+                        }
+                        body = "retry " + target;
+                        return 200;
+                    }));
+            }
+            if (!WaitForHealthyUpstreams())
+            {
+                std::cout << "✗ FAIL: Proxy never reported the test upstreams healthy" << std::endl << std::endl;
+                RecordTest(false);
+                return;
+            }
+            
+            const int requests = 12;
+            int answered = 0;
+            for (int i = 0; i < requests; ++i)
+            {
+                auto response = client_.SendRequest("GET", "/test-client/retry");
+                if (response.status_code == 200 && response.body == "retry /test-client/retry")
+                {
+                    answered++;
+                }
+            }
+            
+            if (answered == requests && dropped > 0)
+            {
+                std::cout << "✓ PASS: " << requests << " proxied requests answered (" << dropped.load()
+                          << " dropped by the failing upstream and retried)" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: " << answered << " of " << requests << " proxied requests answered, "
+                          << dropped.load() << " dropped by the failing upstream" << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Proxy retry test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestListenerStats()
+    {
+        std::cout << "Testing listen-queue and first-byte statistics..." << std::endl;
+        
+        try
+        {
+            const int requests = 3;
+            auto before = StatsClient().SendRequest("GET", "/api/server/stats");
+            for (int i = 0; i < requests; ++i)
+            {
+                client_.SendRequest("GET", "/ping");
+            }
+            auto after = StatsClient().SendRequest("GET", "/api/server/stats");
+            
+            const size_t before_main = before.body.find("\"name\":\"main\"");
+            const size_t after_main = after.body.find("\"name\":\"main\"");
+            if (before.status_code != 200 || after.status_code != 200 || before_main == std::string::npos ||
+                after_main == std::string::npos)
+            {
+                std::cout << "✗ FAIL: Server statistics unavailable (status " << after.status_code << ")" << std::endl;
+                std::cout << "  Response: " << after.body << std::endl << std::endl;
+                RecordTest(false);
+                return;
+            }
+            const std::string listener_before = before.body.substr(before_main);
+            const std::string listener = after.body.substr(after_main);
+            const long long accepted = JsonNumber(listener, "accepted") - JsonNumber(listener_before, "accepted");
+            const long long first_bytes = JsonNumber(listener, "count") - JsonNumber(listener_before, "count");
+            
+            if (JsonNumber(after.body, "overflows") >= 0 && JsonNumber(after.body, "drops") >= 0 &&
+                JsonNumber(listener, "backlog") > 0 && JsonNumber(listener, "peak") >= 0 &&
+                accepted >= requests && first_bytes >= requests && JsonNumber(listener, "p99Us") > 0)
+            {
+                std::cout << "✓ PASS: Main listener backlog " << JsonNumber(listener, "backlog") << ", queue peak "
+                          << JsonNumber(listener, "peak") << ", first byte p50 " << JsonNumber(listener, "p50Us")
+                          << " us, p99 " << JsonNumber(listener, "p99Us") << " us" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: " << requests << " requests moved accepted by " << accepted << " and firstByte.count by "
+                          << first_bytes << std::endl;
+                std::cout << "  Response: " << after.body << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Listener statistics test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestZeroCopySend()
+    {
+        std::cout << "Testing large responses on a MSG_ZEROCOPY listener..." << std::endl;
+        
+        try
+        {
+            auto before = StatsClient().SendRequest("GET", "/api/server/stats");
+            const size_t main = before.body.find("\"name\":\"main\"");
+            const size_t section = main == std::string::npos ? main : before.body.find("\"zeroCopy\":", main);
+            const size_t next = main == std::string::npos ? main : before.body.find("\"name\":", main + 1);
+            if (section == std::string::npos || (next != std::string::npos && section > next))
+            {
+                std::cout << "- SKIP: the main listener does not use MSG_ZEROCOPY (server: --tcp zerocopy)" << std::endl
+                          << std::endl;
+                return;
+            }
+            const long long threshold = JsonNumber(before.body.substr(section), "threshold");
+            const long long sends_before = JsonNumber(before.body.substr(section), "sends");
+            
+            // The echo response carries the input twice, well past the threshold
+            std::string input;
+            for (size_t i = 0; input.length() < static_cast<size_t>(threshold) * 4; ++i)
+            {
+                input += std::to_string(i) + ",";
+            }
+            auto response = client_.SendRequest("POST", "/service/echo", input);
+            
+            auto after = StatsClient().SendRequest("GET", "/api/server/stats");
+            const size_t after_section = after.body.find("\"zeroCopy\":", after.body.find("\"name\":\"main\""));
+            const long long sends = after_section == std::string::npos ? -1
+                : JsonNumber(after.body.substr(after_section), "sends") - sends_before;
+            
+            if (response.status_code == 200 && response.body.find("\"output\":\"" + input + "\"") != std::string::npos &&
+                sends > 0)
+            {
+                std::cout << "✓ PASS: " << response.body.length() << " byte response arrived intact through "
+                          << sends << " zero-copy send(s)" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: Large echo returned status " << response.status_code << " with "
+                          << response.body.length() << " bytes; zero-copy sends advanced by " << sends << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Zero-copy test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestUdpIngest()
+    {
+        std::cout << "Testing UDP telemetry ingest..." << std::endl;
+        
+        try
+        {
+            auto before = StatsClient().SendRequest("GET", "/api/server/stats");
+            const size_t section = before.body.find("\"udpIngest\":");
+            if (section == std::string::npos)
+            {
+                std::cout << "- SKIP: the server has no UDP ingest listener (server: --udp-ingest <port>)" << std::endl
+                          << std::endl;
+                return;
+            }
+            const std::string ingest_before = before.body.substr(section);
+            const long long port = JsonNumber(ingest_before, "port");
+            
+            // Two statsd lines and one malformed line in a single datagram
+            const bool sent = client_.SendDatagram(static_cast<int>(port),
+                                                   "test-client.requests:1|c\ntest-client.latency:12|ms\nnot a metric");
+            long long datagrams = 0;
+            long long metrics = 0;
+            long long malformed = 0;
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+            while (sent && std::chrono::steady_clock::now() < deadline)
+            {
+                auto after = StatsClient().SendRequest("GET", "/api/server/stats");
+                const std::string ingest = after.body.substr(std::min(after.body.find("\"udpIngest\":"), after.body.length()));
+                datagrams = JsonNumber(ingest, "datagrams") - JsonNumber(ingest_before, "datagrams");
+                metrics = JsonNumber(ingest, "metrics") - JsonNumber(ingest_before, "metrics");
+                malformed = JsonNumber(ingest, "malformed") - JsonNumber(ingest_before, "malformed");
+                if (datagrams > 0)
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            
+            if (datagrams == 1 && metrics == 2 && malformed == 1)
+            {
+                std::cout << "✓ PASS: Datagram on UDP port " << port << " counted 2 metrics and 1 malformed line" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: UDP port " << port << " counted " << datagrams << " datagrams, " << metrics
+                          << " metrics, " << malformed << " malformed lines" << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: UDP ingest test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestUnixSocket()
+    {
+        std::cout << "Testing /ping over the Unix domain socket listener..." << std::endl;
+        
+#ifdef _WIN32
+        std::cout << "- SKIP: Unix domain sockets are not tested on Windows" << std::endl << std::endl;
+#else
+        if (options_.unix_path.empty())
+        {
+            std::cout << "- SKIP: needs --unix <path> (server: --unix <path>)" << std::endl << std::endl;
+            return;
+        }
+        
+        try
+        {
+            auto sock = HttpClient::OpenLocalConnection(options_.unix_path);
+            std::string response;
+            const bool sent = HttpClient::SendRaw(sock, "GET /ping HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+            while (sent && HttpClient::ReceiveMore(sock, response))
+            {
+            }
+            HttpClient::CloseConnection(sock);
+            
+            if (response.compare(0, 12, "HTTP/1.1 200") == 0 && response.find("\"message\":\"ping\"") != std::string::npos)
+            {
+                std::cout << "✓ PASS: Unix socket " << options_.unix_path << " answered /ping" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: Unix socket returned '" << response.substr(0, response.find("\r\n")) << "'" << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Unix socket test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+#endif
+    }
+
+    void TestAdminListener()
+    {
+        std::cout << "Testing admin endpoints on the admin port only..." << std::endl;
+        
+        if (!admin_client_)
+        {
+            std::cout << "- SKIP: needs --admin <port> (server: --admin <port>)" << std::endl << std::endl;
+            return;
+        }
+        
+        try
+        {
+            // Admin prefixes are denied on the data port, and the admin port serves nothing else
+            auto data_stats = client_.SendRequest("GET", "/api/server/stats");
+            auto admin_stats = admin_client_->SendRequest("GET", "/api/server/stats");
+            auto admin_service = admin_client_->SendRequest("POST", "/service/echo", "test");
+            
+            if (data_stats.status_code == 404 && admin_stats.status_code == 200 &&
+                admin_stats.body.find("\"name\":\"admin\"") != std::string::npos && admin_service.status_code == 404)
+            {
+                std::cout << "✓ PASS: /api/server/stats is 404 on the data port and 200 on the admin port;"
+                          << " /service/echo is 404 on the admin port" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: /api/server/stats returned " << data_stats.status_code << " on the data port and "
+                          << admin_stats.status_code << " on the admin port; /service/echo returned "
+                          << admin_service.status_code << " on the admin port" << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Admin listener test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestConnectTunnel()
+    {
+        std::cout << "Testing CONNECT tunneling and its port allowlist..." << std::endl;
+        
+        try
+        {
+            if (options_.connect_port == 0)
+            {
+                // Tunneling is off by default
+                auto sock = client_.OpenConnection();
+                std::string head;
+                HttpClient::SendRaw(sock, "CONNECT 127.0.0.1:1 HTTP/1.1\r\nHost: 127.0.0.1:1\r\n\r\n");
+                HttpClient::ReceiveUntil(sock, head, "\r\n\r\n");
+                HttpClient::CloseConnection(sock);
+                
+                if (head.compare(0, 12, "HTTP/1.1 405") == 0)
+                {
+                    std::cout << "✓ PASS: CONNECT is refused with 405 while tunneling is disabled" << std::endl;
+                    RecordTest(true);
+                }
+                else
+                {
+                    std::cout << "✗ FAIL: CONNECT without --connect returned '" << head.substr(0, head.find("\r\n")) << "'"
+                              << std::endl;
+                    RecordTest(false);
+                }
+                std::cout << std::endl;
+                return;
+            }
+            
+            // The allowed port is served by this client; a port outside the list must be refused
+            TestUpstream upstream(options_.connect_port, [](const std::string& target, std::string& body) {
+                body = "tunnel " + target;
+                return 200;
+            });
+            const int disallowed_port = options_.connect_port == 1 ? 2 : 1;
+            const std::string before = StatsClient().SendRequest("GET", "/api/server/stats").body;
+            
+            auto refused_sock = client_.OpenConnection();
+            std::string refused;
+            const std::string refused_target = "127.0.0.1:" + std::to_string(disallowed_port);
+            HttpClient::SendRaw(refused_sock, "CONNECT " + refused_target + " HTTP/1.1\r\nHost: " + refused_target + "\r\n\r\n");
+            HttpClient::ReceiveUntil(refused_sock, refused, "\r\n\r\n");
+            HttpClient::CloseConnection(refused_sock);
+            
+            auto sock = client_.OpenConnection();
+            std::string established;
+            std::string tunneled;
+            const std::string target = "127.0.0.1:" + std::to_string(options_.connect_port);
+            if (HttpClient::SendRaw(sock, "CONNECT " + target + " HTTP/1.1\r\nHost: " + target + "\r\n\r\n") &&
+                HttpClient::ReceiveUntil(sock, established, "\r\n\r\n") && established.compare(0, 12, "HTTP/1.1 200") == 0)
+            {
+                tunneled = established.substr(established.find("\r\n\r\n") + 4);
+                if (HttpClient::SendRaw(sock, "GET /through-tunnel HTTP/1.1\r\nHost: " + target + "\r\n\r\n"))
+                {
+                    HttpClient::ReceiveUntil(sock, tunneled, "tunnel /through-tunnel");
+                }
+            }
+            HttpClient::CloseConnection(sock);
+            const std::string after = StatsClient().SendRequest("GET", "/api/server/stats").body;
+            
+            if (refused.compare(0, 12, "HTTP/1.1 403") == 0 && tunneled.find("tunnel /through-tunnel") != std::string::npos &&
+                JsonNumber(after, "refused") > JsonNumber(before, "refused") &&
+                JsonNumber(after, "opened") > JsonNumber(before, "opened"))
+            {
+                std::cout << "✓ PASS: CONNECT to port " << disallowed_port << " refused with 403; tunnel to port "
+                          << options_.connect_port << " relayed a request" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: CONNECT to port " << disallowed_port << " returned '"
+                          << refused.substr(0, refused.find("\r\n")) << "'; CONNECT to port " << options_.connect_port
+                          << " returned '" << established.substr(0, established.find("\r\n")) << "' and relayed "
+                          << tunneled.length() << " bytes" << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: CONNECT tunnel test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    /**
+     * Client for the admin endpoints: the admin port when the server has one
+     */
+    HttpClient& StatsClient()
+    {
+        return admin_client_ ? *admin_client_ : client_;
+    }
+
+    void TestProxyHedging()
+    {
+        std::cout << "Testing reverse proxy hedging of slow requests..." << std::endl;
+        
+        if (options_.upstream_ports.size() < 2)
+        {
+            std::cout << "- SKIP: needs --upstreams <port>,<port> and a server started with --hedge" << std::endl << std::endl;
+            return;
+        }
+        
+        try
+        {
+            // Every upstream answers; one request in 20 stalls, so the duplicate sent elsewhere wins
+            std::atomic<int> counter(0);
+            std::vector<std::unique_ptr<TestUpstream>> upstreams;
+            for (size_t i = 0; i < options_.upstream_ports.size(); ++i)
+            {
+                upstreams.push_back(std::make_unique<TestUpstream>(options_.upstream_ports[i],
+                    [&counter](const std::string& target, std::string& body) {
+                        if (target != "/" && ++counter % 20 == 0)
+                        {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                        }
+                        body = "hedge " + target;
+                        return 200;
+                    }));
+            }
+            if (!WaitForHealthyUpstreams())
+            {
+                std::cout << "✗ FAIL: Proxy never reported the test upstreams healthy" << std::endl << std::endl;
+                RecordTest(false);
+                return;
+            }
+            
+            const std::string before = RouteStats(StatsClient().SendRequest("GET", "/api/proxy/stats").body);
+            const int requests = 120;
+            int answered = 0;
+            for (int i = 0; i < requests; ++i)
+            {
+                if (client_.SendRequest("GET", "/test-client/hedge").status_code == 200)
+                {
+                    answered++;
+                }
+            }
+            const std::string after = RouteStats(StatsClient().SendRequest("GET", "/api/proxy/stats").body);
+            
+            if (JsonNumber(after, "hedgeDelayUs") <= 0)
+            {
+                std::cout << "- SKIP: the server does not hedge this route (start it with --hedge <percentile>)" << std::endl
+                          << std::endl;
+                return;
+            }
+            const long long hedged = JsonNumber(after, "hedged") - JsonNumber(before, "hedged");
+            const long long wins = SumJsonNumbers(after, "hedgeWins") - SumJsonNumbers(before, "hedgeWins");
+            if (answered == requests && hedged > 0 && wins > 0)
+            {
+                std::cout << "✓ PASS: " << hedged << " slow requests hedged, " << wins << " answered by the hedge (delay "
+                          << JsonNumber(after, "hedgeDelayUs") << " us)" << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: " << answered << " of " << requests << " answered, " << hedged << " hedged, "
+                          << wins << " hedge wins" << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Proxy hedging test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestProxyEjection()
+    {
+        std::cout << "Testing reverse proxy ejection of a failing upstream..." << std::endl;
+        
+        if (options_.upstream_ports.size() < 2)
+        {
+            std::cout << "- SKIP: needs --upstreams <port>,<port>" << std::endl << std::endl;
+            return;
+        }
+        
+        try
+        {
+            // Health checks pass on every upstream, but the last one drops every proxied request
+            const size_t failing = options_.upstream_ports.size() - 1;
+            std::vector<std::unique_ptr<TestUpstream>> upstreams;
+            for (size_t i = 0; i < options_.upstream_ports.size(); ++i)
+            {
+                upstreams.push_back(std::make_unique<TestUpstream>(options_.upstream_ports[i],
+                    [i, failing](const std::string& target, std::string& body) {
+                        body = "ejection " + target;
+                        return i == failing && target != "/" ? 0 : 200;
+                    }));
+            }
+            if (!WaitForHealthyUpstreams())
+            {
+                std::cout << "✗ FAIL: Proxy never reported the test upstreams healthy" << std::endl << std::endl;
+                RecordTest(false);
+                return;
+            }
+            
+            // Consecutive failures eject it; retries keep every answer a 200
+            int answered = 0;
+            int sent = 0;
+            std::string upstream;
+            for (; sent < 30; ++sent)
+            {
+                upstream = UpstreamStats(StatsClient().SendRequest("GET", "/api/proxy/stats").body, options_.upstream_ports[failing]);
+                if (upstream.find("\"ejected\":true") != std::string::npos)
+                {
+                    break;
+                }
+                if (client_.SendRequest("GET", "/test-client/ejection").status_code == 200)
+                {
+                    answered++;
+                }
+            }
+            
+            if (answered == sent && upstream.find("\"ejected\":true") != std::string::npos &&
+                JsonNumber(upstream, "ejections") > 0)
+            {
+                if (sent > 0)
+                {
+                    std::cout << "✓ PASS: Failing upstream ejected after " << sent << " requests, all answered" << std::endl;
+                }
+                else
+                {
+                    std::cout << "✓ PASS: Failing upstream is still ejected (" << JsonNumber(upstream, "ejections")
+                              << " ejections so far)" << std::endl;
+                }
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: " << answered << " of " << sent << " requests answered; failing upstream: "
+                          << upstream << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Proxy ejection test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    /**
+     * Stats of the /test-client route in /api/proxy/stats
+     */
+    static std::string RouteStats(const std::string& body)
+    {
+        const size_t start = body.find("\"prefix\":\"/test-client\"");
+        if (start == std::string::npos)
+        {
+            return "";
+        }
+        const size_t next = body.find("\"prefix\":", start + 1);
+        return body.substr(start, next == std::string::npos ? std::string::npos : next - start);
+    }
+
+    /**
+     * Health checks run every few seconds: wait until every test upstream is back in rotation
+     */
+    bool WaitForHealthyUpstreams()
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            auto stats = StatsClient().SendRequest("GET", "/api/proxy/stats");
+            size_t healthy = 0;
+            for (int port : options_.upstream_ports)
+            {
+                if (UpstreamStats(stats.body, port).find("\"healthy\":true") != std::string::npos)
+                {
+                    healthy++;
+                }
+            }
+            if (healthy == options_.upstream_ports.size())
+            {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        }
+        return false;
+    }
+
+    /**
+     * Stats object of the upstream at 127.0.0.1:port in /api/proxy/stats
+     */
+    static std::string UpstreamStats(const std::string& body, int port)
+    {
+        const size_t start = body.find("\"address\":\"127.0.0.1:" + std::to_string(port) + "\"");
+        if (start == std::string::npos)
+        {
+            return "";
+        }
+        return body.substr(start, body.find('}', start) - start);
+    }
+
+    void TestNonExistentService()
+    {
+        std::cout << "Testing non-existent service (should return 404)..." << std::endl;
+        
+        try
+        {
+            auto response = client_.SendRequest("POST", "/service/nonexistent", "test");
+            
+            if (response.status_code == 404)
+            {
+                std::cout << "✓ PASS: Non-existent service correctly returned 404" << std::endl;
+                std::cout << "  Response: " << response.body << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: Non-existent service returned unexpected status " << response.status_code << std::endl;
+                std::cout << "  Response: " << response.body << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Non-existent service test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    void TestInvalidMethod()
+    {
+        std::cout << "Testing invalid method on service endpoint..." << std::endl;
+        
+        try
+        {
+            auto response = client_.SendRequest("GET", "/service/echo");
+            
+            if (response.status_code == 405 || response.status_code == 400)
+            {
+                std::cout << "✓ PASS: Invalid method correctly returned " << response.status_code << std::endl;
+                std::cout << "  Response: " << response.body << std::endl;
+                RecordTest(true);
+            }
+            else
+            {
+                std::cout << "✗ FAIL: Invalid method returned unexpected status " << response.status_code << std::endl;
+                std::cout << "  Response: " << response.body << std::endl;
+                RecordTest(false);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "✗ FAIL: Invalid method test threw exception: " << e.what() << std::endl;
+            RecordTest(false);
+        }
+        std::cout << std::endl;
+    }
+
+    static long long JsonNumber(const std::string& body, const std::string& key)
+    {
+        const std::string needle = "\"" + key + "\":";
+        size_t pos = body.find(needle);
+        if (pos == std::string::npos)
+        {
+            return -1;
+        }
+        pos += needle.length();
+        while (pos < body.length() && body[pos] == ' ')
+        {
+            pos++;
+        }
+        long long value = 0;
+        bool digits = false;
+        while (pos < body.length() && body[pos] >= '0' && body[pos] <= '9')
+        {
+            value = value * 10 + (body[pos] - '0');
+            digits = true;
+            pos++;
+        }
+        return digits ? value : -1;
+    }
+
+    static constexpr const char* kH2Preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+    static std::string H2Frame(uint8_t type, uint8_t flags, uint32_t stream_id, const std::string& payload)
+    {
+        std::string frame;
+        frame.push_back(static_cast<char>((payload.length() >> 16) & 0xFF));
+        frame.push_back(static_cast<char>((payload.length() >> 8) & 0xFF));
+        frame.push_back(static_cast<char>(payload.length() & 0xFF));
+        frame.push_back(static_cast<char>(type));
+        frame.push_back(static_cast<char>(flags));
+        frame.push_back(static_cast<char>((stream_id >> 24) & 0x7F));
+        frame.push_back(static_cast<char>((stream_id >> 16) & 0xFF));
+        frame.push_back(static_cast<char>((stream_id >> 8) & 0xFF));
+        frame.push_back(static_cast<char>(stream_id & 0xFF));
+        return frame + payload;
+    }
+
+    static std::string H2PingRequestBlock()
+    {
+        // HPACK: :method GET, :scheme http (static table), :path and :authority as literals
+        std::string block = "\x82\x86";
+        block += "\x04\x05/ping";
+        block += "\x01\x09localhost";
+        return block;
+    }
+
+    /**
+     * Read frames until stream 1 ends; returns its :status (0 if none arrived)
+     */
+    static int ReadH2Response(HttpClient::SocketHandle sock, std::string& body, std::string buffer = "")
+    {
+        int status = 0;
+        while (true)
+        {
+            while (buffer.length() < 9 ||
+                   buffer.length() < 9 + ((static_cast<size_t>(static_cast<uint8_t>(buffer[0])) << 16) |
+                                          (static_cast<size_t>(static_cast<uint8_t>(buffer[1])) << 8) |
+                                          static_cast<uint8_t>(buffer[2])))
+            {
+                if (!HttpClient::ReceiveMore(sock, buffer))
+                {
+                    return status;
+                }
+            }
+            const size_t length = (static_cast<size_t>(static_cast<uint8_t>(buffer[0])) << 16) |
+                                  (static_cast<size_t>(static_cast<uint8_t>(buffer[1])) << 8) |
+                                  static_cast<uint8_t>(buffer[2]);
+            const uint8_t type = static_cast<uint8_t>(buffer[3]);
+            const uint8_t flags = static_cast<uint8_t>(buffer[4]);
+            const uint32_t stream_id = (static_cast<uint32_t>(static_cast<uint8_t>(buffer[5]) & 0x7F) << 24) |
+                                       (static_cast<uint32_t>(static_cast<uint8_t>(buffer[6])) << 16) |
+                                       (static_cast<uint32_t>(static_cast<uint8_t>(buffer[7])) << 8) |
+                                       static_cast<uint8_t>(buffer[8]);
+            std::string payload = buffer.substr(9, length);
+            buffer.erase(0, 9 + length);
+            
+            if (type == 0x7)
+            {
+                return status;  // GOAWAY
+            }
+            if (stream_id != 1 || (type != 0x0 && type != 0x1))
+            {
+                continue;
+            }
+            if ((flags & 0x8) && !payload.empty())
+            {
+                // PADDED: pad length byte in front, padding at the end
+                const size_t padding = static_cast<uint8_t>(payload[0]);
+                payload = payload.substr(1, payload.length() - 1 - std::min(padding, payload.length() - 1));
+            }
+            if (type == 0x1)
+            {
+                if ((flags & 0x20) && payload.length() >= 5)
+                {
+                    payload.erase(0, 5);  // PRIORITY fields
+                }
+                // The server sends :status 200 as static index 8, possibly after a table size update
+                size_t pos = 0;
+                while (pos < payload.length() && (static_cast<uint8_t>(payload[pos]) & 0xE0) == 0x20)
+                {
+                    pos++;
+                }
+                if (pos < payload.length() && static_cast<uint8_t>(payload[pos]) == 0x88)
+                {
+                    status = 200;
+                }
+                else if (status == 0)
+                {
+                    status = -1;
+                }
+            }
+            else
+            {
+                body += payload;
+            }
+            if (flags & 0x1)
+            {
+                return status;  // END_STREAM
+            }
+        }
+    }
+
+    static std::string WebSocketFrame(uint8_t opcode, const std::string& payload)
+    {
+        // Client frames are always masked
+        const uint8_t mask[4] = {0x37, 0xFA, 0x21, 0x3D};
+        std::string frame;
+        frame.push_back(static_cast<char>(0x80 | opcode));
+        if (payload.length() < 126)
+        {
+            frame.push_back(static_cast<char>(0x80 | payload.length()));
+        }
+        else
+        {
+            frame.push_back(static_cast<char>(0x80 | 126));
+            frame.push_back(static_cast<char>((payload.length() >> 8) & 0xFF));
+            frame.push_back(static_cast<char>(payload.length() & 0xFF));
+        }
+        frame.append(reinterpret_cast<const char*>(mask), sizeof(mask));
+        for (size_t i = 0; i < payload.length(); ++i)
+        {
+            frame.push_back(static_cast<char>(payload[i] ^ mask[i % 4]));
+        }
+        return frame;
+    }
+
+    /**
+     * Read one unfragmented server frame; returns its opcode (0 on failure)
+     */
+    static uint8_t ReadWebSocketFrame(HttpClient::SocketHandle sock, std::string& buffer, std::string& payload)
+    {
+        while (buffer.length() < 2)
+        {
+            if (!HttpClient::ReceiveMore(sock, buffer))
+            {
+                return 0;
+            }
+        }
+        size_t header = 2;
+        size_t length = static_cast<uint8_t>(buffer[1]) & 0x7F;
+        if (length == 126)
+        {
+            while (buffer.length() < 4)
+            {
+                if (!HttpClient::ReceiveMore(sock, buffer))
+                {
+                    return 0;
+                }
+            }
+            length = (static_cast<size_t>(static_cast<uint8_t>(buffer[2])) << 8) | static_cast<uint8_t>(buffer[3]);
+            header = 4;
+        }
+        else if (length == 127)
+        {
+            return 0;
+        }
+        while (buffer.length() < header + length)
+        {
+            if (!HttpClient::ReceiveMore(sock, buffer))
+            {
+                return 0;
+            }
+        }
+        const uint8_t opcode = static_cast<uint8_t>(buffer[0]) & 0x0F;
+        payload = buffer.substr(header, length);
+        buffer.erase(0, header + length);
+        return opcode;
+    }
+
+#ifdef MINISERVER_HAS_ZLIB
+    static bool GzipCompress(const std::string& input, std::string& output)
+    {
+        z_stream stream{};
+        if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return false;
+        }
+        output.resize(deflateBound(&stream, static_cast<uLong>(input.length())));
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = static_cast<uInt>(input.length());
+        stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+        stream.avail_out = static_cast<uInt>(output.length());
+        const int result = deflate(&stream, Z_FINISH);
+        output.resize(stream.total_out);
+        deflateEnd(&stream);
+        return result == Z_STREAM_END;
+    }
+
+    static bool GzipDecompress(const std::string& input, std::string& output)
+    {
+        z_stream stream{};
+        if (inflateInit2(&stream, 15 + 16) != Z_OK)
+        {
+            return false;
+        }
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = static_cast<uInt>(input.length());
+        int result = Z_OK;
+        char buffer[16384];
+        while (result == Z_OK)
+        {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer);
+            stream.avail_out = sizeof(buffer);
+            result = inflate(&stream, Z_NO_FLUSH);
+            output.append(buffer, sizeof(buffer) - stream.avail_out);
+        }
+        inflateEnd(&stream);
+        return result == Z_STREAM_END;
+    }
+#endif
+
+    static long long SumJsonNumbers(const std::string& body, const std::string& key)
+    {
+        long long sum = 0;
+        const std::string needle = "\"" + key + "\":";
+        for (size_t pos = body.find(needle); pos != std::string::npos; pos = body.find(needle, pos + 1))
+        {
+            const long long value = JsonNumber(body.substr(pos), key);
+            sum += value > 0 ? value : 0;
+        }
+        return sum;
+    }
+
+    void RecordTest(bool passed)
+    {
+        total_tests_++;
+        if (passed)
+        {
+            passed_tests_++;
+        }
+        else
+        {
+            failed_tests_++;
+        }
+    }
+
+    void PrintTestSummary()
+    {
+        std::cout << "=== Test Summary ===" << std::endl;
+        std::cout << "Total tests: " << total_tests_ << std::endl;
+        std::cout << "Passed: " << passed_tests_ << std::endl;
+        std::cout << "Failed: " << failed_tests_ << std::endl;
+        
+        double success_rate = total_tests_ > 0 ? (double)passed_tests_ / total_tests_ * 100.0 : 0.0;
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Success rate: " << success_rate << "%" << std::endl;
+        
+        if (failed_tests_ == 0)
+        {
+            std::cout << "\n🎉 All tests passed! Server is working correctly." << std::endl;
+        }
+        else
+        {
+            std::cout << "\n⚠️  Some tests failed. Please check the server implementation." << std::endl;
+        }
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    std::string host = "localhost";
+    int port = 8080;
+
+    // Parse command line arguments
+    if (argc > 1)
+    {
+        host = argv[1];
+    }
+    if (argc > 2)
+    {
+        try
+        {
+            port = std::stoi(argv[2]);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Invalid port number: " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+
+#ifndef _WIN32
+    // A server may answer (e.g. 413) and close before the whole request is sent
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    // Optional features, named after the server options they test
+    TestOptions options;
+    for (int i = 3; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument == "--upstreams" && i + 1 < argc)
+        {
+            std::istringstream ports(argv[++i]);
+            std::string upstream_port;
+            while (std::getline(ports, upstream_port, ','))
+            {
+                options.upstream_ports.push_back(std::atoi(upstream_port.c_str()));
+            }
+            continue;
+        }
+        if (argument == "--admin" && i + 1 < argc)
+        {
+            options.admin_port = std::atoi(argv[++i]);
+            continue;
+        }
+        if (argument == "--connect" && i + 1 < argc)
+        {
+            options.connect_port = std::atoi(argv[++i]);
+            continue;
+        }
+        if (argument == "--unix" && i + 1 < argc)
+        {
+            options.unix_path = argv[++i];
+            continue;
+        }
+        std::cerr << "Unknown option: " << argument << std::endl;
+        return 1;
     }
 
     std::cout << "Connecting to server at " << host << ":" << port << std::endl;
 
     try
     {
-        TestClient test_client(host, port);
+        TestClient test_client(host, port, options);
         test_client.RunAllTests();
     }
     catch (const std::exception& e)
@@ -0,0 +1,308 @@
+/**
+ * @file main.cpp
+ * @brief Minimal socket-activation launcher: binds listening sockets and runs a server on them (LISTEN_FDS)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr int kFirstDescriptor = 3;     ///< LISTEN_FDS sockets start here
+
+/**
+ * @brief Socket to bind (command line)
+ */
+struct SocketSpec
+{
+    std::string name = "main";          ///< LISTEN_FDNAMES entry
+    std::string host = "0.0.0.0";       ///< TCP address
+    int port = 0;                       ///< TCP port (0: Unix domain socket)
+    std::string path;                   ///< Unix socket path ('@' prefix: abstract name)
+    int socket = -1;                    ///< Bound listening socket
+};
+
+volatile sig_atomic_t g_stop_signal = 0;    ///< SIGINT/SIGTERM: stop the server and exit
+volatile sig_atomic_t g_restart = 0;        ///< SIGHUP: start a new server, then stop the old one
+
+void HandleSignal(int signal)
+{
+    if (signal == SIGHUP)
+    {
+        g_restart = 1;
+    }
+    else
+    {
+        g_stop_signal = signal;
+    }
+}
+
+/**
+ * @brief Split "[host:]port[=name]" or "path[=name]" into a spec
+ */
+SocketSpec ParseSpec(const std::string& value, bool local)
+{
+    SocketSpec spec;
+    const size_t equals = value.find('=');
+    const std::string address = value.substr(0, equals);
+    if (equals != std::string::npos)
+    {
+        spec.name = value.substr(equals + 1);
+    }
+    if (local)
+    {
+        spec.path = address;
+        return spec;
+    }
+    const size_t colon = address.rfind(':');
+    if (colon != std::string::npos)
+    {
+        spec.host = address.substr(0, colon);
+    }
+    spec.port = std::stoi(address.substr(colon == std::string::npos ? 0 : colon + 1));
+    return spec;
+}
+
+/**
+ * @brief Bind and listen; the socket stays open in the launcher across server restarts
+ */
+bool Bind(SocketSpec& spec)
+{
+    const int listener = socket(spec.port != 0 ? AF_INET : AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+    {
+        return false;
+    }
+
+    int result;
+    if (spec.port != 0)
+    {
+        const int enable = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(spec.port));
+        if (inet_pton(AF_INET, spec.host.c_str(), &address.sin_addr) != 1)
+        {
+            close(listener);
+            errno = EINVAL;
+            return false;
+        }
+        result = bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+    else
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        const bool abstract = spec.path.size() > 1 && spec.path.front() == '@';
+        if (spec.path.size() >= sizeof(address.sun_path))
+        {
+            close(listener);
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        std::memcpy(address.sun_path, spec.path.data(), spec.path.size());
+        if (abstract)
+        {
+            address.sun_path[0] = '\0';
+        }
+        else
+        {
+            unlink(spec.path.c_str());
+        }
+        const socklen_t length = abstract
+            ? static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + spec.path.size())
+            : static_cast<socklen_t>(sizeof(address));
+        result = bind(listener, reinterpret_cast<sockaddr*>(&address), length);
+    }
+
+    if (result != 0 || listen(listener, SOMAXCONN) != 0)
+    {
+        const int error = errno;
+        close(listener);
+        errno = error;
+        return false;
+    }
+    spec.socket = listener;
+    return true;
+}
+
+/**
+ * @brief Fork and exec the server with the sockets at descriptors 3, 4, ...
+ * @return Child process, or -1
+ */
+pid_t Launch(const std::vector<SocketSpec>& sockets, char* const command[])
+{
+    const pid_t pid = fork();
+    if (pid != 0)
+    {
+        return pid;
+    }
+
+    // Move the sockets out of the target range first, then into place (dup2 clears FD_CLOEXEC)
+    std::vector<int> moved;
+    for (const SocketSpec& spec : sockets)
+    {
+        moved.push_back(fcntl(spec.socket, F_DUPFD_CLOEXEC, kFirstDescriptor + static_cast<int>(sockets.size())));
+    }
+    std::string names;
+    for (size_t i = 0; i < moved.size(); ++i)
+    {
+        dup2(moved[i], kFirstDescriptor + static_cast<int>(i));
+        names += (i == 0 ? "" : ":") + sockets[i].name;
+    }
+
+    setenv("LISTEN_PID", std::to_string(getpid()).c_str(), 1);
+    setenv("LISTEN_FDS", std::to_string(sockets.size()).c_str(), 1);
+    setenv("LISTEN_FDNAMES", names.c_str(), 1);
+    signal(SIGHUP, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    execvp(command[0], command);
+    std::cerr << "mini-launch: cannot run " << command[0] << ": " << std::strerror(errno) << "\n";
+    _exit(127);
+}
+
+void PrintUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [options] -- <server command...>\n"
+              << "  --tcp [host:]port[=name]  Bind a TCP socket (name defaults to main)\n"
+              << "  --unix <path|@name>[=name] Bind a Unix domain socket\n"
+              << "  --restart                 Start the server again whenever it exits\n"
+              << "\n"
+              << "The sockets are passed as descriptors 3, 4, ... with LISTEN_FDS,\n"
+              << "LISTEN_PID and LISTEN_FDNAMES. They stay open here, so connections\n"
+              << "queue while the server starts or restarts. SIGHUP starts a new\n"
+              << "server and then sends SIGTERM to the old one.\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<SocketSpec> sockets;
+    bool restart = false;
+    int i = 1;
+    for (; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--")
+        {
+            ++i;
+            break;
+        }
+        if (arg == "--help" || arg == "-h")
+        {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        if (arg == "--restart")
+        {
+            restart = true;
+            continue;
+        }
+        if ((arg == "--tcp" || arg == "--unix") && i + 1 < argc)
+        {
+            const std::string value = argv[++i];
+            try
+            {
+                sockets.push_back(ParseSpec(value, arg == "--unix"));
+            }
+            catch (const std::exception&)
+            {
+                std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+                return 1;
+            }
+            continue;
+        }
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (sockets.empty() || i >= argc)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    for (SocketSpec& spec : sockets)
+    {
+        if (!Bind(spec))
+        {
+            std::cerr << "mini-launch: cannot bind " << (spec.port != 0 ? spec.host + ":" + std::to_string(spec.port) : spec.path)
+                      << ": " << std::strerror(errno) << "\n";
+            return 1;
+        }
+    }
+
+    struct sigaction action{};
+    action.sa_handler = HandleSignal;
+    sigaction(SIGHUP, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    pid_t server = Launch(sockets, argv + i);
+    int exit_code = 0;
+    while (server > 0)
+    {
+        if (g_restart)
+        {
+            // The new server accepts on the same sockets before the old one stops
+            g_restart = 0;
+            const pid_t replaced = server;
+            server = Launch(sockets, argv + i);
+            kill(replaced, SIGTERM);
+            std::cerr << "mini-launch: restarted, server pid " << server << "\n";
+        }
+        if (g_stop_signal)
+        {
+            kill(server, SIGTERM);
+            g_stop_signal = 0;
+            restart = false;
+        }
+
+        int status = 0;
+        const pid_t exited = waitpid(-1, &status, 0);
+        if (exited < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if (exited != server)
+        {
+            continue;
+        }
+        exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        server = restart ? Launch(sockets, argv + i) : -1;
+    }
+
+    for (const SocketSpec& spec : sockets)
+    {
+        close(spec.socket);
+        if (spec.port == 0 && spec.path.front() != '@')
+        {
+            unlink(spec.path.c_str());
+        }
+    }
+    return exit_code;
+}
@@ -0,0 +1,575 @@
+/**
+ * @file kv_store.cpp
+ * @brief Sharded in-memory key/value store implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "kv_store.hpp"
+#include "net/body_encoding.hpp"
+#include "net/http_parser.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+namespace miniserver::services
+{
+    namespace
+    {
+        constexpr size_t kInitialShardCapacity = 16;
+        constexpr size_t kNotFound = static_cast<size_t>(-1);
+        constexpr char kPathPrefix[] = "/service/kv";
+
+        int64_t NowMs()
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        size_t RoundUpPowerOfTwo(size_t value)
+        {
+            size_t result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        /**
+         * @brief Value of one query parameter (raw, not decoded)
+         */
+        std::optional<std::string> QueryParameter(const std::string& query, std::string_view name)
+        {
+            size_t start = 0;
+            while (start <= query.size())
+            {
+                size_t end = query.find('&', start);
+                if (end == std::string::npos)
+                {
+                    end = query.size();
+                }
+                const std::string_view pair(query.data() + start, end - start);
+                const size_t equals = pair.find('=');
+                if (pair.substr(0, equals) == name)
+                {
+                    return equals == std::string_view::npos ? std::string() : std::string(pair.substr(equals + 1));
+                }
+                start = end + 1;
+            }
+            return std::nullopt;
+        }
+
+        http::Response ErrorResponse(const http::Request& request, http::StatusCode status, const std::string& message)
+        {
+            auto writer = http::StructuredWriter::ForRequest(request);
+            writer.BeginObject(1);
+            writer.Key("error");
+            writer.String(message);
+            writer.EndObject();
+            http::Response response;
+            response.status = status;
+            writer.WriteTo(response);
+            return response;
+        }
+    }
+
+    /**
+     * @brief One independently locked open-addressing table
+     */
+    struct KvStore::Shard
+    {
+        enum class SlotState : uint8_t
+        {
+            Empty,
+            Full,
+            Tombstone
+        };
+
+        struct Slot
+        {
+            std::string key;                        ///< Key
+            std::string value;                      ///< Value
+            int64_t expires_ms = 0;                 ///< Steady-clock expiry, 0 for none
+            uint64_t hash = 0;                      ///< Cached key hash
+            SlotState state = SlotState::Empty;     ///< Slot state
+        };
+
+        static constexpr size_t kSlotOverhead = sizeof(Slot) + 1;
+
+        mutable std::shared_mutex mutex;                        ///< Guards everything below except the atomics
+        std::vector<Slot> slots;                                ///< Table (power-of-two size)
+        std::unique_ptr<std::atomic<uint8_t>[]> referenced;     ///< CLOCK reference bits, set under the shared lock
+        size_t live = 0;                                        ///< Full slots
+        size_t tombstones = 0;                                  ///< Tombstone slots
+        size_t memory = 0;                                      ///< Accounted bytes
+        size_t memory_limit = 0;                                ///< This shard's slice of the cap
+        size_t clock_hand = 0;                                  ///< Eviction sweep position
+
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> evictions{0};
+        std::atomic<uint64_t> expirations{0};
+
+        explicit Shard(size_t limit)
+            : memory_limit(limit)
+        {
+            Rehash(kInitialShardCapacity);
+        }
+
+        static size_t Cost(std::string_view key, std::string_view value)
+        {
+            return key.size() + value.size() + kSlotOverhead;
+        }
+
+        static bool Expired(const Slot& slot, int64_t now)
+        {
+            return slot.expires_ms != 0 && slot.expires_ms <= now;
+        }
+
+        /**
+         * @brief Probe for a key
+         * @param insert_at Receives the first reusable slot on the probe path when not found
+         * @return Slot index, or kNotFound
+         */
+        size_t Find(std::string_view key, uint64_t hash, size_t* insert_at = nullptr) const
+        {
+            const size_t mask = slots.size() - 1;
+            size_t reusable = kNotFound;
+            for (size_t i = hash & mask, probes = 0; probes < slots.size(); i = (i + 1) & mask, ++probes)
+            {
+                const Slot& slot = slots[i];
+                if (slot.state == SlotState::Empty)
+                {
+                    if (insert_at)
+                    {
+                        *insert_at = reusable != kNotFound ? reusable : i;
+                    }
+                    return kNotFound;
+                }
+                if (slot.state == SlotState::Tombstone)
+                {
+                    if (reusable == kNotFound)
+                    {
+                        reusable = i;
+                    }
+                }
+                else if (slot.hash == hash && slot.key == key)
+                {
+                    return i;
+                }
+            }
+            if (insert_at)
+            {
+                *insert_at = reusable;
+            }
+            return kNotFound;
+        }
+
+        void Remove(size_t index)
+        {
+            Slot& slot = slots[index];
+            memory -= Cost(slot.key, slot.value);
+            std::string().swap(slot.key);
+            std::string().swap(slot.value);
+            slot.state = SlotState::Tombstone;
+            --live;
+            ++tombstones;
+        }
+
+        void Rehash(size_t capacity)
+        {
+            std::vector<Slot> old_slots(capacity);
+            old_slots.swap(slots);
+            referenced = std::make_unique<std::atomic<uint8_t>[]>(capacity);
+            for (size_t i = 0; i < capacity; ++i)
+            {
+                referenced[i].store(0, std::memory_order_relaxed);
+            }
+
+            const size_t mask = capacity - 1;
+            for (Slot& slot : old_slots)
+            {
+                if (slot.state != SlotState::Full)
+                {
+                    continue;
+                }
+                size_t i = slot.hash & mask;
+                while (slots[i].state != SlotState::Empty)
+                {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = std::move(slot);
+            }
+            tombstones = 0;
+            clock_hand = 0;
+        }
+
+        /**
+         * @brief CLOCK sweep until memory is at most target
+         * @param protect Slot that must survive (kNotFound for none)
+         */
+        void EvictUntil(size_t target, int64_t now, size_t protect)
+        {
+            const size_t mask = slots.size() - 1;
+            // Two full turns: the first may only clear reference bits
+            for (size_t steps = 0; memory > target && live > 0 && steps < 2 * slots.size(); ++steps)
+            {
+                const size_t i = clock_hand;
+                clock_hand = (clock_hand + 1) & mask;
+                if (slots[i].state != SlotState::Full || i == protect)
+                {
+                    continue;
+                }
+                if (Expired(slots[i], now))
+                {
+                    Remove(i);
+                    expirations.fetch_add(1, std::memory_order_relaxed);
+                }
+                else if (referenced[i].exchange(0, std::memory_order_relaxed) == 0)
+                {
+                    Remove(i);
+                    evictions.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+
+    KvStore::KvStore(const KvStoreOptions& options)
+        : m_options(options)
+    {
+        m_options.shard_count = RoundUpPowerOfTwo(std::max<size_t>(1, m_options.shard_count));
+        const size_t shard_limit = m_options.max_memory_bytes / m_options.shard_count;
+
+        m_shards.reserve(m_options.shard_count);
+        for (size_t i = 0; i < m_options.shard_count; ++i)
+        {
+            m_shards.push_back(std::make_unique<Shard>(shard_limit));
+        }
+
+        unsigned bits = 0;
+        while ((size_t(1) << bits) < m_options.shard_count)
+        {
+            ++bits;
+        }
+        m_shard_shift = 64 - bits;
+
+        LOG_INFO_FMT(KvStore, "Initialized with {} shards, {} byte memory cap",
+                     m_options.shard_count, m_options.max_memory_bytes);
+    }
+
+    KvStore::~KvStore() = default;
+
+    uint64_t KvStore::Hash(std::string_view key)
+    {
+        // splitmix64 finalizer: spreads std::hash output over both ends of the word
+        uint64_t h = std::hash<std::string_view>{}(key);
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    KvStore::Shard& KvStore::ShardFor(uint64_t hash) const
+    {
+        return *m_shards[m_shard_shift >= 64 ? 0 : static_cast<size_t>(hash >> m_shard_shift)];
+    }
+
+    std::optional<std::string> KvStore::Get(std::string_view key)
+    {
+        const uint64_t hash = Hash(key);
+        Shard& shard = ShardFor(hash);
+
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        const size_t index = shard.Find(key, hash);
+        if (index == kNotFound || Shard::Expired(shard.slots[index], NowMs()))
+        {
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        shard.referenced[index].store(1, std::memory_order_relaxed);
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        return shard.slots[index].value;
+    }
+
+    std::vector<std::optional<std::string>> KvStore::MultiGet(const std::vector<std::string>& keys)
+    {
+        std::vector<std::optional<std::string>> results(keys.size());
+        std::vector<uint64_t> hashes(keys.size());
+        std::vector<size_t> order(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            hashes[i] = Hash(keys[i]);
+        }
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            return &ShardFor(hashes[a]) < &ShardFor(hashes[b]);
+        });
+
+        const int64_t now = NowMs();
+        for (size_t begin = 0; begin < order.size();)
+        {
+            Shard& shard = ShardFor(hashes[order[begin]]);
+            size_t end = begin;
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            for (; end < order.size() && &ShardFor(hashes[order[end]]) == &shard; ++end)
+            {
+                const size_t key_index = order[end];
+                const size_t index = shard.Find(keys[key_index], hashes[key_index]);
+                if (index == kNotFound || Shard::Expired(shard.slots[index], now))
+                {
+                    shard.misses.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                shard.referenced[index].store(1, std::memory_order_relaxed);
+                shard.hits.fetch_add(1, std::memory_order_relaxed);
+                results[key_index] = shard.slots[index].value;
+            }
+            begin = end;
+        }
+        return results;
+    }
+
+    bool KvStore::Put(std::string_view key, std::string value, std::chrono::seconds ttl)
+    {
+        if (key.empty() || key.size() > m_options.max_key_size)
+        {
+            throw std::length_error("Key length must be between 1 and " + std::to_string(m_options.max_key_size));
+        }
+        if (value.size() > m_options.max_value_size)
+        {
+            throw std::length_error("Value exceeds " + std::to_string(m_options.max_value_size) + " bytes");
+        }
+
+        const uint64_t hash = Hash(key);
+        Shard& shard = ShardFor(hash);
+        const size_t cost = Shard::Cost(key, value);
+        if (cost > shard.memory_limit)
+        {
+            throw std::length_error("Entry exceeds the per-shard memory budget");
+        }
+
+        const int64_t now = NowMs();
+        const int64_t expires = ttl.count() > 0 ? now + ttl.count() * 1000 : 0;
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        size_t index = shard.Find(key, hash);
+        if (index != kNotFound)
+        {
+            Shard::Slot& slot = shard.slots[index];
+            const bool was_expired = Shard::Expired(slot, now);
+            if (was_expired)
+            {
+                shard.expirations.fetch_add(1, std::memory_order_relaxed);
+            }
+            const size_t old_cost = Shard::Cost(slot.key, slot.value);
+            if (cost > old_cost)
+            {
+                shard.EvictUntil(shard.memory_limit - (cost - old_cost), now, index);
+            }
+            shard.memory = shard.memory - old_cost + cost;
+            slot.value = std::move(value);
+            slot.expires_ms = expires;
+            shard.referenced[index].store(1, std::memory_order_relaxed);
+            return was_expired;
+        }
+
+        shard.EvictUntil(shard.memory_limit - cost, now, kNotFound);
+
+        // Keep the load factor (tombstones included) under 3/4
+        if ((shard.live + shard.tombstones + 1) * 4 > shard.slots.size() * 3)
+        {
+            const bool grow = (shard.live + 1) * 2 > shard.slots.size();
+            shard.Rehash(grow ? shard.slots.size() * 2 : shard.slots.size());
+        }
+
+        shard.Find(key, hash, &index);
+        Shard::Slot& slot = shard.slots[index];
+        if (slot.state == Shard::SlotState::Tombstone)
+        {
+            --shard.tombstones;
+        }
+        slot.key.assign(key.data(), key.size());
+        slot.value = std::move(value);
+        slot.expires_ms = expires;
+        slot.hash = hash;
+        slot.state = Shard::SlotState::Full;
+        shard.referenced[index].store(0, std::memory_order_relaxed);
+        shard.memory += cost;
+        ++shard.live;
+        return true;
+    }
+
+    bool KvStore::Erase(std::string_view key)
+    {
+        const uint64_t hash = Hash(key);
+        Shard& shard = ShardFor(hash);
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        const size_t index = shard.Find(key, hash);
+        if (index == kNotFound)
+        {
+            return false;
+        }
+        const bool expired = Shard::Expired(shard.slots[index], NowMs());
+        shard.Remove(index);
+        if (expired)
+        {
+            shard.expirations.fetch_add(1, std::memory_order_relaxed);
+        }
+        return !expired;
+    }
+
+    KvStoreStats KvStore::GetStats() const
+    {
+        KvStoreStats stats;
+        for (const auto& shard : m_shards)
+        {
+            std::shared_lock<std::shared_mutex> lock(shard->mutex);
+            stats.entries += shard->live;
+            stats.memory_bytes += shard->memory;
+            stats.hits += shard->hits.load(std::memory_order_relaxed);
+            stats.misses += shard->misses.load(std::memory_order_relaxed);
+            stats.evictions += shard->evictions.load(std::memory_order_relaxed);
+            stats.expirations += shard->expirations.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    http::Response KvStore::HandleRequest(const http::Request& request)
+    {
+        const std::string prefix = kPathPrefix;
+        std::string key;
+        if (request.path.size() > prefix.size() + 1 && request.path[prefix.size()] == '/')
+        {
+            key = request.path.substr(prefix.size() + 1);
+        }
+
+        http::Response response;
+        switch (request.method)
+        {
+            case http::Method::GET:
+            {
+                if (!key.empty())
+                {
+                    auto value = Get(key);
+                    if (!value)
+                    {
+                        return ErrorResponse(request, http::StatusCode::NotFound, "Key not found");
+                    }
+                    response.SetContent(*value, "application/octet-stream");
+                    return response;
+                }
+
+                auto writer = http::StructuredWriter::ForRequest(request);
+                if (auto keys_param = QueryParameter(request.query_string, "keys"))
+                {
+                    // Batch lookup: ?keys=a,b,c
+                    std::vector<std::string> keys;
+                    size_t start = 0;
+                    while (start <= keys_param->size())
+                    {
+                        size_t comma = keys_param->find(',', start);
+                        if (comma == std::string::npos)
+                        {
+                            comma = keys_param->size();
+                        }
+                        if (comma > start)
+                        {
+                            keys.push_back(http::HttpParser::UrlDecode(keys_param->substr(start, comma - start)));
+                        }
+                        start = comma + 1;
+                    }
+
+                    const auto values = MultiGet(keys);
+                    writer.BeginObject(keys.size());
+                    for (size_t i = 0; i < keys.size(); ++i)
+                    {
+                        writer.Key(keys[i]);
+                        if (values[i])
+                        {
+                            writer.String(*values[i]);
+                        }
+                        else
+                        {
+                            writer.Null();
+                        }
+                    }
+                    writer.EndObject();
+                }
+                else
+                {
+                    const KvStoreStats stats = GetStats();
+                    writer.BeginObject(8);
+                    writer.Key("entries");        writer.UInt(stats.entries);
+                    writer.Key("memoryBytes");    writer.UInt(stats.memory_bytes);
+                    writer.Key("maxMemoryBytes"); writer.UInt(m_options.max_memory_bytes);
+                    writer.Key("shards");         writer.UInt(m_options.shard_count);
+                    writer.Key("hits");           writer.UInt(stats.hits);
+                    writer.Key("misses");         writer.UInt(stats.misses);
+                    writer.Key("evictions");      writer.UInt(stats.evictions);
+                    writer.Key("expirations");    writer.UInt(stats.expirations);
+                    writer.EndObject();
+                }
+                writer.WriteTo(response);
+                return response;
+            }
+
+            case http::Method::PUT:
+            {
+                if (key.empty())
+                {
+                    return ErrorResponse(request, http::StatusCode::BadRequest, "Key is required");
+                }
+
+                std::chrono::seconds ttl{0};
+                if (auto ttl_param = QueryParameter(request.query_string, "ttl"))
+                {
+                    if (ttl_param->empty() || ttl_param->size() > 9 ||
+                        !std::all_of(ttl_param->begin(), ttl_param->end(), [](char c) { return c >= '0' && c <= '9'; }))
+                    {
+                        return ErrorResponse(request, http::StatusCode::BadRequest, "ttl must be a number of seconds");
+                    }
+                    ttl = std::chrono::seconds(std::stol(*ttl_param));
+                }
+
+                try
+                {
+                    const bool created = Put(key, request.body, ttl);
+                    response.status = created ? http::StatusCode::Created : http::StatusCode::NoContent;
+                    return response;
+                }
+                catch (const std::length_error& e)
+                {
+                    return ErrorResponse(request, key.size() > m_options.max_key_size ? http::StatusCode::BadRequest
+                                                                             : http::StatusCode::PayloadTooLarge,
+                                         e.what());
+                }
+            }
+
+            case http::Method::DELETE:
+                if (key.empty())
+                {
+                    return ErrorResponse(request, http::StatusCode::BadRequest, "Key is required");
+                }
+                if (!Erase(key))
+                {
+                    return ErrorResponse(request, http::StatusCode::NotFound, "Key not found");
+                }
+                response.status = http::StatusCode::NoContent;
+                return response;
+
+            default:
+                response = ErrorResponse(request, http::StatusCode::MethodNotAllowed, "Use GET, PUT or DELETE");
+                response.headers["Allow"] = "GET, PUT, DELETE";
+                return response;
+        }
+    }
+} // namespace miniserver::services
@@ -0,0 +1,150 @@
+/**
+ * @file kv_store.hpp
+ * @brief Sharded in-memory key/value store backing the built-in kv service
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/http_types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace miniserver::services
+{
+    /**
+     * @brief Key/value store limits
+     */
+    struct KvStoreOptions
+    {
+        size_t shard_count = 16;                    ///< Number of independently locked shards (rounded up to a power of two)
+        size_t max_memory_bytes = 64 * 1024 * 1024; ///< Memory cap across all shards; least recently used entries are evicted
+        size_t max_key_size = 250;                  ///< Longest accepted key
+        size_t max_value_size = 1024 * 1024;        ///< Largest accepted value
+    };
+
+    /**
+     * @brief Key/value store counters
+     */
+    struct KvStoreStats
+    {
+        size_t entries = 0;             ///< Live entries (including not yet collected expired ones)
+        size_t memory_bytes = 0;        ///< Accounted memory
+        uint64_t hits = 0;              ///< Successful lookups
+        uint64_t misses = 0;            ///< Lookups of missing or expired keys
+        uint64_t evictions = 0;         ///< Entries evicted by the memory cap
+        uint64_t expirations = 0;       ///< Expired entries collected
+    };
+
+    /**
+     * @brief Sharded open-addressing hash table with TTLs and a memory cap
+     *
+     * Keys hash to one of `shard_count` shards; each shard is a linear-probing
+     * table guarded by its own read-write lock, so lookups on different shards
+     * never contend and lookups on the same shard share the lock. Every shard
+     * owns an equal slice of the memory cap and evicts with the CLOCK
+     * (second-chance) approximation of LRU: reads set a per-slot reference bit
+     * without taking the write lock. Expired entries are invisible to readers
+     * and reclaimed by writers and the eviction sweep.
+     *
+     * @details All methods are thread-safe.
+     */
+    class KvStore
+    {
+    public:
+        /**
+         * @brief Constructor
+         * @param options Store limits
+         */
+        explicit KvStore(const KvStoreOptions& options = {});
+
+        /**
+         * @brief Destructor
+         */
+        ~KvStore();
+
+        KvStore(const KvStore&) = delete;
+        KvStore& operator=(const KvStore&) = delete;
+
+        /**
+         * @brief Look up a key
+         * @param key Key
+         * @return Value, or nullopt if missing or expired
+         */
+        std::optional<std::string> Get(std::string_view key);
+
+        /**
+         * @brief Look up several keys, locking each shard once
+         * @param keys Keys
+         * @return Values in the order of `keys` (nullopt for missing keys)
+         */
+        std::vector<std::optional<std::string>> MultiGet(const std::vector<std::string>& keys);
+
+        /**
+         * @brief Insert or replace a key
+         * @param key Key
+         * @param value Value
+         * @param ttl Time to live (zero for no expiry)
+         * @return true if the key was created, false if an existing value was replaced
+         * @throws std::length_error If the key or value exceeds the configured limits
+         */
+        bool Put(std::string_view key, std::string value, std::chrono::seconds ttl = std::chrono::seconds::zero());
+
+        /**
+         * @brief Remove a key
+         * @param key Key
+         * @return true if a live entry was removed
+         */
+        bool Erase(std::string_view key);
+
+        /**
+         * @brief Aggregate counters over all shards
+         */
+        KvStoreStats GetStats() const;
+
+        /**
+         * @brief Get the configured limits
+         */
+        const KvStoreOptions& GetOptions() const { return m_options; }
+
+        /**
+         * @brief HTTP front end for /service/kv
+         * @param request HTTP request
+         * @return HTTP response
+         *
+         * @details
+         * - `GET /service/kv/<key>`: value (404 if missing)
+         * - `PUT /service/kv/<key>[?ttl=<seconds>]`: store the body (201 created, 204 replaced)
+         * - `DELETE /service/kv/<key>`: remove (204, 404 if missing)
+         * - `GET /service/kv?keys=a,b,c`: multi-get as an object (null for missing keys)
+         * - `GET /service/kv`: statistics
+         */
+        http::Response HandleRequest(const http::Request& request);
+
+    private:
+        struct Shard;
+
+        /**
+         * @brief Hash a key (shard index from the high bits, slot from the low bits)
+         */
+        static uint64_t Hash(std::string_view key);
+
+        /**
+         * @brief Shard owning a hash
+         */
+        Shard& ShardFor(uint64_t hash) const;
+
+        KvStoreOptions m_options;                       ///< Store limits
+        std::vector<std::unique_ptr<Shard>> m_shards;   ///< Shards
+        unsigned m_shard_shift = 0;                     ///< Right shift selecting the shard from a hash
+    };
+} // namespace miniserver::services
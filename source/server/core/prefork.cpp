@@ -0,0 +1,691 @@
+/**
+ * @file prefork.cpp
+ * @brief Prefork master and worker implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "prefork.hpp"
+#include "net/http_types.hpp"
+#include "net/socket_activation.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <csignal>
+    #include <cstring>
+    #include <fcntl.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+namespace miniserver::core
+{
+    namespace
+    {
+        constexpr std::chrono::milliseconds kSupervisePeriod{100};  ///< Master's reaping interval
+        constexpr std::chrono::milliseconds kPublishPeriod{250};    ///< Worker's metrics refresh interval
+        constexpr std::chrono::seconds kStableUptime{5};            ///< Workers dying sooner restart after the delay
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free,
+                      "Shared-memory counters must not rely on process-local locks");
+
+        /**
+         * @brief Milliseconds since the Unix epoch
+         */
+        uint64_t NowMs()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+    }
+
+    /**
+     * @brief Constructor
+     * @param options Worker count and restart policy
+     * @param factory Builds the server each worker runs
+     */
+    PreforkMaster::PreforkMaster(PreforkOptions options, ServerFactory factory)
+        : m_options(std::move(options))
+        , m_factory(std::move(factory))
+    {
+    }
+
+    /**
+     * @brief Destructor
+     */
+    PreforkMaster::~PreforkMaster()
+    {
+#ifndef _WIN32
+        for (const BoundSocket& bound : m_sockets)
+        {
+            close(bound.socket);
+        }
+        for (const auto& file : m_socket_files)
+        {
+            unlink(file.path.c_str());
+        }
+        if (m_metrics)
+        {
+            munmap(m_metrics, sizeof(WorkerMetrics) * m_worker_count);
+        }
+#endif
+    }
+
+    /**
+     * @brief Bind, fork the workers and supervise them until asked to stop
+     * @param stop_requested Polled by the master and by every worker
+     * @return Exit code
+     */
+    int PreforkMaster::Run(const std::function<bool()>& stop_requested)
+    {
+#ifdef _WIN32
+        (void)stop_requested;
+        LOG_ERROR(Prefork, "Prefork mode needs fork(); run a single process on this platform");
+        return 1;
+#else
+        if (!m_factory || m_metrics)
+        {
+            return 1;
+        }
+        m_worker_count = m_options.workers > 0
+            ? m_options.workers : std::max(1u, std::thread::hardware_concurrency());
+
+        // Spread the workers over the CPUs the master may use, one each while they last
+        if (m_options.steer_cpu && m_options.reuse_port)
+        {
+#if defined(__linux__)
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            std::vector<int> cpus;
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+            {
+                for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                {
+                    if (CPU_ISSET(cpu, &allowed))
+                    {
+                        cpus.push_back(cpu);
+                    }
+                }
+            }
+            for (size_t i = 0; i < m_worker_count && !cpus.empty(); ++i)
+            {
+                m_cpus.push_back(cpus[i % cpus.size()]);
+            }
+            if (m_worker_count > cpus.size())
+            {
+                LOG_WARN_FMT(Prefork, "{} workers share {} CPUs; steering is approximate", m_worker_count, cpus.size());
+            }
+#else
+            LOG_WARN(Prefork, "CPU steering needs Linux; workers are not pinned");
+#endif
+        }
+
+        // The master never serves; it only needs the listener layout
+        std::unique_ptr<Server> layout = m_factory();
+        if (!layout || !BindListeners(layout->GetListenerOptions()))
+        {
+            return 1;
+        }
+        layout.reset();
+
+        // Anonymous shared mapping: inherited by every fork, gone with the last process
+        void* area = mmap(nullptr, sizeof(WorkerMetrics) * m_worker_count, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (area == MAP_FAILED)
+        {
+            LOG_ERROR_FMT(Prefork, "Cannot map the metrics area: {}", std::strerror(errno));
+            return 1;
+        }
+        m_metrics = static_cast<WorkerMetrics*>(area);
+        for (size_t i = 0; i < m_worker_count; ++i)
+        {
+            new (&m_metrics[i]) WorkerMetrics();
+        }
+
+        // The master holds every receiving end, so connections queued for a dead worker reach its replacement
+        if (m_options.rebalance)
+        {
+            m_channels.resize(m_worker_count);
+            for (network::MigrationChannel& channel : m_channels)
+            {
+                if (!channel.Open())
+                {
+                    return 1;
+                }
+            }
+        }
+
+        m_pids.assign(m_worker_count, 0);
+        m_started.assign(m_worker_count, {});
+        m_restart_at.assign(m_worker_count, {});
+        LOG_INFO_FMT(Prefork, "Master {} starting {} workers ({}{})", static_cast<int>(getpid()), m_worker_count,
+            m_options.reuse_port ? "SO_REUSEPORT socket each" : "shared sockets",
+            m_options.rebalance ? ", rebalancing idle connections" : "");
+        for (size_t i = 0; i < m_worker_count; ++i)
+        {
+            if (!SpawnWorker(i, stop_requested))
+            {
+                StopWorkers();
+                return 1;
+            }
+        }
+        network::activation::NotifyReady();
+
+        while (!stop_requested())
+        {
+            std::this_thread::sleep_for(kSupervisePeriod);
+
+            int status = 0;
+            pid_t pid;
+            while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+            {
+                auto it = std::find(m_pids.begin(), m_pids.end(), static_cast<int64_t>(pid));
+                if (it == m_pids.end())
+                {
+                    continue;
+                }
+                const size_t index = static_cast<size_t>(it - m_pids.begin());
+                *it = 0;
+                m_metrics[index].pid.store(0);
+                m_metrics[index].active_connections.store(0);
+                if (WIFSIGNALED(status))
+                {
+                    LOG_WARN_FMT(Prefork, "Worker {} (pid {}) killed by signal {}", index, static_cast<int>(pid), WTERMSIG(status));
+                }
+                else
+                {
+                    LOG_WARN_FMT(Prefork, "Worker {} (pid {}) exited with status {}", index, static_cast<int>(pid), WEXITSTATUS(status));
+                }
+
+                // A worker that cannot stay up (bad config, crash on start) must not spin the master
+                const auto now = std::chrono::steady_clock::now();
+                m_restart_at[index] = now - m_started[index] < kStableUptime ? now + m_options.restart_delay : now;
+            }
+
+            for (size_t i = 0; i < m_worker_count && !stop_requested(); ++i)
+            {
+                if (m_pids[i] == 0 && std::chrono::steady_clock::now() >= m_restart_at[i])
+                {
+                    m_metrics[i].restarts.fetch_add(1);
+                    SpawnWorker(i, stop_requested);
+                }
+            }
+        }
+
+        StopWorkers();
+        LOG_INFO(Prefork, "All workers stopped");
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief Bind every listener of the template server
+     * @param listeners Listener layout
+     * @return false if a socket cannot be bound
+     */
+    bool PreforkMaster::BindListeners(const std::vector<ListenerOptions>& listeners)
+    {
+#ifdef _WIN32
+        (void)listeners;
+        return false;
+#else
+        for (const ListenerOptions& listener : listeners)
+        {
+            // A launcher's socket is shared by every worker; there is only one of it
+            auto inherited = [&](bool local)
+            {
+                return std::find_if(m_options.inherited.begin(), m_options.inherited.end(),
+                    [&](const network::InheritedListener& socket) { return socket.name == listener.name && socket.local == local; });
+            };
+            if (const auto tcp = inherited(false); tcp != m_options.inherited.end())
+            {
+                m_sockets.push_back({listener.name, false, 0, tcp->socket});
+                m_options.inherited.erase(tcp);
+                if (m_options.reuse_port)
+                {
+                    LOG_WARN_FMT(Prefork, "Listener '{}' uses an inherited socket, shared by all workers", listener.name);
+                }
+            }
+            if (const auto local = inherited(true); local != m_options.inherited.end())
+            {
+                m_sockets.push_back({listener.name, true, 0, local->socket});
+                m_options.inherited.erase(local);
+            }
+            const bool has_tcp = std::any_of(m_sockets.begin(), m_sockets.end(),
+                [&](const BoundSocket& bound) { return bound.name == listener.name && !bound.local; });
+            const bool has_local = std::any_of(m_sockets.begin(), m_sockets.end(),
+                [&](const BoundSocket& bound) { return bound.name == listener.name && bound.local; });
+
+            // With SO_REUSEPORT each worker gets its own accept queue; the kernel balances between them
+            const size_t tcp_sockets = listener.port == 0 || has_tcp ? 0 : (m_options.reuse_port ? m_worker_count : 1);
+            for (size_t i = 0; i < tcp_sockets; ++i)
+            {
+                network::SocketTuning tuning = listener.tuning;
+                if (m_options.reuse_port && i < m_cpus.size())
+                {
+                    tuning.incoming_cpu = m_cpus[i];
+                }
+                const SOCKET socket = network::SocketServer::OpenTcpListener(listener.host, listener.port, m_options.reuse_port, tuning);
+                if (socket == INVALID_SOCKET)
+                {
+                    return false;
+                }
+                m_sockets.push_back({listener.name, false, i, socket});
+            }
+
+            // Group members join in listen() order, which is slot order; exact steering needs a CPU per slot
+            if (m_options.reuse_port && tcp_sockets == m_cpus.size() && tcp_sockets > 0)
+            {
+                std::vector<int> distinct = m_cpus;
+                std::sort(distinct.begin(), distinct.end());
+                const bool exact = std::unique(distinct.begin(), distinct.end()) == distinct.end();
+                if (exact && network::SocketServer::AttachCpuSteering(m_sockets.back().socket, m_cpus))
+                {
+                    LOG_INFO_FMT(Prefork, "Listener '{}' steers each connection to the worker on its receiving CPU", listener.name);
+                }
+            }
+            if (!listener.local_socket.path.empty() && !has_local)
+            {
+                const SOCKET socket = network::SocketServer::OpenLocalListener(listener.local_socket, listener.tuning.backlog);
+                if (socket == INVALID_SOCKET)
+                {
+                    return false;
+                }
+                m_sockets.push_back({listener.name, true, 0, socket});
+                if (!listener.local_socket.abstract)
+                {
+                    m_socket_files.push_back(listener.local_socket);
+                }
+            }
+        }
+
+        // Workers race for connections on a shared socket; the losers must not block in accept()
+        for (const BoundSocket& bound : m_sockets)
+        {
+            fcntl(bound.socket, F_SETFL, fcntl(bound.socket, F_GETFL) | O_NONBLOCK);
+            fcntl(bound.socket, F_SETFD, FD_CLOEXEC);
+        }
+        return true;
+#endif
+    }
+
+    /**
+     * @brief Fork one worker
+     * @param index Worker slot
+     * @param stop_requested Stop flag, polled by the worker
+     * @return false if fork failed
+     */
+    bool PreforkMaster::SpawnWorker(size_t index, const std::function<bool()>& stop_requested)
+    {
+#ifdef _WIN32
+        (void)index;
+        (void)stop_requested;
+        return false;
+#else
+        const pid_t pid = fork();
+        if (pid < 0)
+        {
+            LOG_ERROR_FMT(Prefork, "Cannot fork worker {}: {}", index, std::strerror(errno));
+            m_restart_at[index] = std::chrono::steady_clock::now() + m_options.restart_delay;
+            return false;
+        }
+        if (pid == 0)
+        {
+            // _exit: the master's static state (and its atexit handlers) is not the worker's to tear down
+            _exit(RunWorker(index, stop_requested));
+        }
+        m_pids[index] = pid;
+        m_started[index] = std::chrono::steady_clock::now();
+        return true;
+#endif
+    }
+
+    /**
+     * @brief Body of a worker process
+     * @param index Worker slot
+     * @param stop_requested Stop flag
+     * @return Process exit code
+     */
+    int PreforkMaster::RunWorker(size_t index, const std::function<bool()>& stop_requested)
+    {
+#ifdef _WIN32
+        (void)index;
+        (void)stop_requested;
+        return 1;
+#else
+#if defined(__linux__)
+        // Before any thread exists, so every thread of the worker inherits the mask
+        if (index < m_cpus.size())
+        {
+            cpu_set_t pinned;
+            CPU_ZERO(&pinned);
+            CPU_SET(m_cpus[index], &pinned);
+            if (sched_setaffinity(0, sizeof(pinned), &pinned) != 0)
+            {
+                LOG_WARN_FMT(Prefork, "Worker {} cannot be pinned to CPU {}: {}", index, m_cpus[index], std::strerror(errno));
+            }
+        }
+#endif
+        std::unique_ptr<Server> server;
+        try
+        {
+            server = m_factory();
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT(Prefork, "Worker {} cannot build its server: {}", index, e.what());
+            return 1;
+        }
+        if (!server)
+        {
+            return 1;
+        }
+
+        // Keep the shared sockets and this worker's own SO_REUSEPORT sockets; the others are siblings'
+        std::vector<network::InheritedListener> sockets;
+        for (BoundSocket& bound : m_sockets)
+        {
+            if (bound.local || !m_options.reuse_port || bound.worker == index)
+            {
+                sockets.push_back({bound.name, bound.local, bound.socket});
+            }
+            else
+            {
+                close(bound.socket);
+            }
+        }
+        m_sockets.clear();
+        m_socket_files.clear();
+        server->SetInheritedListeners(std::move(sockets));
+
+        // Siblings' queues are only sent to; this slot's queue is read by the adopter thread below
+        for (size_t i = 0; i < m_channels.size(); ++i)
+        {
+            if (i != index)
+            {
+                m_channels[i].CloseReceiver();
+            }
+        }
+        std::atomic<int64_t> migrate_quota{0};
+        std::atomic<size_t> migrate_target{index};
+        if (!m_channels.empty())
+        {
+            server->SetConnectionMigrator([&](const network::MigratedConnection& connection)
+            {
+                if (migrate_quota.load(std::memory_order_relaxed) <= 0 ||
+                    migrate_quota.fetch_sub(1, std::memory_order_relaxed) <= 0)
+                {
+                    return false;
+                }
+                return m_channels[migrate_target.load(std::memory_order_relaxed)].Send(connection);
+            });
+        }
+
+        server->RegisterService("metrics", [this](const http::Request& request) -> http::Response
+        {
+            (void)request;
+            http::Response response;
+            response.status = http::StatusCode::OK;
+            response.SetContent(RenderMetrics(), "text/plain; version=0.0.4");
+            return response;
+        });
+
+        // Counters continue from the slot's previous worker, so they only fall on a crash's last interval
+        WorkerMetrics& slot = m_metrics[index];
+        const uint64_t requests_base = slot.requests.load();
+        const uint64_t accepted_base = slot.accepted.load();
+        const uint64_t rejected_base = slot.rejected.load();
+        const uint64_t migrated_out_base = slot.migrated_out.load();
+        const uint64_t migrated_in_base = slot.migrated_in.load();
+        const uint64_t cpu_local_base = slot.cpu_local.load();
+        const uint64_t cpu_remote_base = slot.cpu_remote.load();
+        uint64_t first_byte_base[network::FirstByteLatency::kBuckets];
+        for (size_t i = 0; i < network::FirstByteLatency::kBuckets; ++i)
+        {
+            first_byte_base[i] = slot.first_byte[i].load();
+        }
+        const uint64_t first_byte_us_base = slot.first_byte_us.load();
+        slot.pid.store(getpid());
+        slot.started_ms.store(NowMs());
+        const auto publish = [&]()
+        {
+            const ServerCounters counters = server->GetCounters();
+            slot.requests.store(requests_base + counters.requests);
+            slot.accepted.store(accepted_base + counters.accepted);
+            slot.rejected.store(rejected_base + counters.rejected);
+            slot.migrated_out.store(migrated_out_base + counters.migrated_out);
+            slot.migrated_in.store(migrated_in_base + counters.migrated_in);
+            slot.cpu_local.store(cpu_local_base + counters.cpu_local);
+            slot.cpu_remote.store(cpu_remote_base + counters.cpu_remote);
+            slot.active_connections.store(counters.active_connections);
+            slot.listen_queue.store(counters.listen_queue);
+            slot.listen_backlog.store(counters.listen_backlog);
+            for (size_t i = 0; i < network::FirstByteLatency::kBuckets; ++i)
+            {
+                slot.first_byte[i].store(first_byte_base[i] + counters.first_byte.buckets[i]);
+            }
+            slot.first_byte_us.store(first_byte_us_base + counters.first_byte.sum_us);
+            if (m_channels.empty())
+            {
+                return;
+            }
+
+            // Compare with the siblings' last published loads and pick the quietest as the target
+            uint64_t total = 0;
+            size_t running = 0;
+            uint64_t least_load = UINT64_MAX;
+            for (size_t i = 0; i < m_worker_count; ++i)
+            {
+                if (m_metrics[i].pid.load() == 0)
+                {
+                    continue;
+                }
+                const uint64_t load = m_metrics[i].active_connections.load();
+                total += load;
+                ++running;
+                if (i != index && load < least_load)
+                {
+                    least_load = load;
+                    migrate_target.store(i);
+                }
+            }
+            const uint64_t mine = counters.active_connections;
+            const double mean = running > 0 ? static_cast<double>(total) / static_cast<double>(running) : 0.0;
+            int64_t quota = 0;
+            if (running > 1 && static_cast<double>(mine) > mean * (1.0 + m_options.rebalance_slack) && mine >= least_load + 2)
+            {
+                // Half the excess per period: the siblings' loads lag a period behind, so this cannot overshoot much
+                quota = static_cast<int64_t>((static_cast<double>(mine) - mean + 1.0) / 2.0);
+            }
+            migrate_quota.store(std::max<int64_t>(quota, 0));
+        };
+
+        server->Start();
+        if (!server->IsRunning())
+        {
+            return 1;
+        }
+        LOG_INFO_FMT(Prefork, "Worker {} running as pid {}", index, static_cast<int>(getpid()));
+
+        // Connections siblings pass here continue on this worker's listeners
+        std::atomic<bool> adopting{!m_channels.empty()};
+        std::thread adopter;
+        if (adopting.load())
+        {
+            adopter = std::thread([&]()
+            {
+                network::MigratedConnection connection;
+                while (adopting.load())
+                {
+                    if (m_channels[index].Receive(connection, kPublishPeriod))
+                    {
+                        server->AdoptConnection(std::move(connection));
+                    }
+                }
+            });
+        }
+
+        // A worker whose master died has nobody to restart it or share its sockets with: stop too
+        const pid_t master = getppid();
+        while (server->IsRunning() && !stop_requested() && getppid() == master)
+        {
+            std::this_thread::sleep_for(kPublishPeriod);
+            publish();
+        }
+        migrate_quota.store(0);
+        adopting.store(false);
+        if (adopter.joinable())
+        {
+            adopter.join();
+        }
+        server->Stop();
+        publish();
+        slot.active_connections.store(0);
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief Ask every worker to stop, then kill those that outlive the timeout
+     */
+    void PreforkMaster::StopWorkers()
+    {
+#ifndef _WIN32
+        for (int64_t pid : m_pids)
+        {
+            if (pid != 0)
+            {
+                kill(static_cast<pid_t>(pid), SIGTERM);
+            }
+        }
+
+        // Workers drain their connections before exiting
+        const auto deadline = std::chrono::steady_clock::now() + m_options.stop_timeout;
+        while (std::any_of(m_pids.begin(), m_pids.end(), [](int64_t pid) { return pid != 0; }))
+        {
+            const bool overdue = std::chrono::steady_clock::now() >= deadline;
+            for (size_t i = 0; i < m_pids.size(); ++i)
+            {
+                if (m_pids[i] == 0)
+                {
+                    continue;
+                }
+                if (overdue)
+                {
+                    LOG_WARN_FMT(Prefork, "Worker {} did not stop in time, killing it", i);
+                    kill(static_cast<pid_t>(m_pids[i]), SIGKILL);
+                }
+                if (waitpid(static_cast<pid_t>(m_pids[i]), nullptr, overdue ? 0 : WNOHANG) != 0)
+                {
+                    m_pids[i] = 0;
+                    m_metrics[i].pid.store(0);
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+#endif
+    }
+
+    /**
+     * @brief Render every slot's counters in the Prometheus text format
+     * @return Exposition text
+     */
+    std::string PreforkMaster::RenderMetrics() const
+    {
+        struct Family
+        {
+            const char* name;
+            const char* type;
+            const char* help;
+            const std::atomic<uint64_t> WorkerMetrics::* field;
+        };
+        static const Family families[] =
+        {
+            {"miniserver_requests_total", "counter", "Requests handled.", &WorkerMetrics::requests},
+            {"miniserver_connections_accepted_total", "counter", "Connections accepted.", &WorkerMetrics::accepted},
+            {"miniserver_connections_rejected_total", "counter", "Connections turned away at a limit.", &WorkerMetrics::rejected},
+            {"miniserver_connections_migrated_out_total", "counter", "Idle connections passed to another worker.", &WorkerMetrics::migrated_out},
+            {"miniserver_connections_migrated_in_total", "counter", "Connections adopted from another worker.", &WorkerMetrics::migrated_in},
+            {"miniserver_connections_cpu_local_total", "counter", "Connections accepted on the CPU that received them.", &WorkerMetrics::cpu_local},
+            {"miniserver_connections_cpu_remote_total", "counter", "Connections accepted away from the CPU that received them.", &WorkerMetrics::cpu_remote},
+            {"miniserver_connections_active", "gauge", "Open connections.", &WorkerMetrics::active_connections},
+            {"miniserver_listen_queue_length", "gauge", "Connections waiting in the accept queue (TCP_INFO sample).", &WorkerMetrics::listen_queue},
+            {"miniserver_listen_queue_backlog", "gauge", "Accept queue limit.", &WorkerMetrics::listen_backlog},
+            {"miniserver_worker_restarts_total", "counter", "Times the worker was replaced.", &WorkerMetrics::restarts},
+        };
+
+        std::ostringstream out;
+        for (const Family& family : families)
+        {
+            out << "# HELP " << family.name << ' ' << family.help << '\n'
+                << "# TYPE " << family.name << ' ' << family.type << '\n';
+            for (size_t i = 0; i < m_worker_count; ++i)
+            {
+                out << family.name << "{worker=\"" << i << "\"} " << (m_metrics[i].*family.field).load() << '\n';
+            }
+        }
+
+        // Cumulative buckets in seconds, as Prometheus histograms expect
+        constexpr const char* first_byte = "miniserver_accept_first_byte_seconds";
+        out << "# HELP " << first_byte << " Time from accept() to the first request byte read (plaintext).\n"
+            << "# TYPE " << first_byte << " histogram\n";
+        for (size_t i = 0; i < m_worker_count; ++i)
+        {
+            uint64_t cumulative = 0;
+            for (size_t b = 0; b < network::FirstByteLatency::kBuckets; ++b)
+            {
+                cumulative += m_metrics[i].first_byte[b].load();
+                out << first_byte << "_bucket{worker=\"" << i << "\",le=\"";
+                if (b + 1 < network::FirstByteLatency::kBuckets)
+                {
+                    out << std::to_string(network::FirstByteLatency::kBoundsUs[b] / 1e6);
+                }
+                else
+                {
+                    out << "+Inf";
+                }
+                out << "\"} " << cumulative << '\n';
+            }
+            out << first_byte << "_sum{worker=\"" << i << "\"} " << std::to_string(m_metrics[i].first_byte_us.load() / 1e6) << '\n'
+                << first_byte << "_count{worker=\"" << i << "\"} " << cumulative << '\n';
+        }
+
+        // Host-wide: read at scrape time rather than per worker
+        network::ListenDropCounters drops;
+        if (network::SocketServer::ReadListenDrops(drops))
+        {
+            out << "# HELP miniserver_listen_overflows_total Handshakes completed against a full accept queue (host).\n"
+                << "# TYPE miniserver_listen_overflows_total counter\n"
+                << "miniserver_listen_overflows_total " << drops.overflows << '\n'
+                << "# HELP miniserver_listen_drops_total Connections dropped at a listener (host).\n"
+                << "# TYPE miniserver_listen_drops_total counter\n"
+                << "miniserver_listen_drops_total " << drops.drops << '\n';
+        }
+
+        size_t running = 0;
+        out << "# HELP miniserver_worker_up Whether the worker process is running.\n"
+            << "# TYPE miniserver_worker_up gauge\n";
+        for (size_t i = 0; i < m_worker_count; ++i)
+        {
+            const bool up = m_metrics[i].pid.load() != 0;
+            running += up ? 1 : 0;
+            out << "miniserver_worker_up{worker=\"" << i << "\"} " << (up ? 1 : 0) << '\n';
+        }
+        out << "# HELP miniserver_workers Worker processes running.\n"
+            << "# TYPE miniserver_workers gauge\n"
+            << "miniserver_workers " << running << '\n';
+        return out.str();
+    }
+
+} // namespace miniserver::core
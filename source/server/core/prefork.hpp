@@ -0,0 +1,173 @@
+/**
+ * @file prefork.hpp
+ * @brief Prefork process model: a master binding the listeners and supervising worker processes
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace miniserver::core
+{
+    /**
+     * @brief Prefork settings
+     */
+    struct PreforkOptions
+    {
+        size_t workers = 0;                                     ///< Worker processes (0: one per CPU)
+        bool reuse_port = false;                                ///< One SO_REUSEPORT socket per worker instead of one shared socket
+        std::chrono::milliseconds restart_delay{1000};          ///< Pause before restarting a worker that died soon after starting
+        std::chrono::milliseconds stop_timeout{15000};          ///< Wait for workers to drain before killing them
+        std::vector<network::InheritedListener> inherited;      ///< Pre-bound sockets used instead of binding (socket activation)
+        bool rebalance = false;                                 ///< Move idle keep-alive connections from busy workers to quiet ones
+        double rebalance_slack = 0.25;                          ///< Tolerated load above the mean before moving connections
+        bool steer_cpu = false;                                 ///< Pin workers to CPUs and steer connections to the receiving CPU's worker (reuse_port, Linux)
+    };
+
+    /**
+     * @brief Counters one worker publishes to the shared metrics area
+     */
+    struct alignas(64) WorkerMetrics
+    {
+        std::atomic<int64_t> pid{0};                            ///< Worker process (0: not running)
+        std::atomic<uint64_t> started_ms{0};                    ///< Start time, ms since the Unix epoch
+        std::atomic<uint64_t> restarts{0};                      ///< Times this slot's worker was replaced
+        std::atomic<uint64_t> requests{0};                      ///< Requests handled in this slot, across restarts
+        std::atomic<uint64_t> active_connections{0};            ///< Open connections
+        std::atomic<uint64_t> accepted{0};                      ///< Connections accepted in this slot, across restarts
+        std::atomic<uint64_t> rejected{0};                      ///< Connections turned away at a limit, across restarts
+        std::atomic<uint64_t> migrated_out{0};                  ///< Connections passed to a sibling, across restarts
+        std::atomic<uint64_t> migrated_in{0};                   ///< Connections adopted from a sibling, across restarts
+        std::atomic<uint64_t> cpu_local{0};                     ///< Accepted on the CPU that received them, across restarts
+        std::atomic<uint64_t> cpu_remote{0};                    ///< Accepted away from the CPU that received them, across restarts
+        std::atomic<uint64_t> listen_queue{0};                  ///< Connections in the worker's accept queues (last sample)
+        std::atomic<uint64_t> listen_backlog{0};                ///< Limit of those queues
+        std::atomic<uint64_t> first_byte[network::FirstByteLatency::kBuckets] = {}; ///< Accept-to-first-byte histogram, across restarts
+        std::atomic<uint64_t> first_byte_us{0};                 ///< Sum of those latencies, across restarts
+    };
+
+    /**
+     * @brief Master process of the prefork model
+     *
+     * Binds every listener once, forks the workers, and restarts any worker
+     * that exits unexpectedly. Each worker builds its own Server from the
+     * factory and accepts on the master's sockets: all workers share one
+     * socket per listener, or with reuse_port each gets its own SO_REUSEPORT
+     * socket (the master holds them all, so a restarted worker gets its
+     * predecessor's queue back). Workers publish their counters to a shared
+     * memory area, so any worker answers /metrics for all of them.
+     *
+     * With rebalance, SO_REUSEPORT hashing (or a lucky accept race) leaving
+     * one worker with far more long-lived connections is corrected: a worker
+     * whose open connections exceed the mean by more than the slack passes
+     * plaintext keep-alive connections, as they fall idle between requests,
+     * to the least loaded worker through that worker's MigrationChannel.
+     *
+     * With steer_cpu (and reuse_port) every worker is pinned to one of the
+     * master's allowed CPUs and its sockets carry SO_INCOMING_CPU, so the
+     * kernel hands a connection to the worker on the CPU whose receive queue
+     * took its packets; with no more workers than CPUs a reuseport BPF
+     * program makes that choice exact. The request is then served in the
+     * cache that already holds the socket.
+     *
+     * @details POSIX only; Run fails elsewhere. Not to be combined with the
+     * takeover socket or the shared-memory transport, which bind per process.
+     */
+    class PreforkMaster
+    {
+    public:
+        /**
+         * @brief Builds a configured (not started) server; called once in the master and in every worker
+         */
+        using ServerFactory = std::function<std::unique_ptr<Server>()>;
+
+        /**
+         * @brief Constructor
+         * @param options Worker count and restart policy
+         * @param factory Builds the server each worker runs
+         */
+        PreforkMaster(PreforkOptions options, ServerFactory factory);
+
+        /**
+         * @brief Destructor (unmaps the metrics area, closes the listeners)
+         */
+        ~PreforkMaster();
+
+        PreforkMaster(const PreforkMaster&) = delete;
+        PreforkMaster& operator=(const PreforkMaster&) = delete;
+
+        /**
+         * @brief Bind, fork the workers and supervise them until asked to stop
+         * @param stop_requested Polled by the master and by every worker
+         * @return Exit code for the calling process (a worker never returns from here)
+         */
+        int Run(const std::function<bool()>& stop_requested);
+
+    private:
+        /**
+         * @brief Listening socket held by the master
+         */
+        struct BoundSocket
+        {
+            std::string name;                                   ///< Listener name
+            bool local = false;                                 ///< Unix domain socket
+            size_t worker = 0;                                  ///< Owning worker with reuse_port (TCP), else ignored
+            SOCKET socket = INVALID_SOCKET;                     ///< Listening socket
+        };
+
+        /**
+         * @brief Bind every listener of the template server
+         * @return false if a socket cannot be bound
+         */
+        bool BindListeners(const std::vector<ListenerOptions>& listeners);
+
+        /**
+         * @brief Fork one worker
+         * @param index Worker slot
+         * @param stop_requested Stop flag, polled by the worker
+         * @return false if fork failed
+         */
+        bool SpawnWorker(size_t index, const std::function<bool()>& stop_requested);
+
+        /**
+         * @brief Body of a worker process
+         * @param index Worker slot
+         * @param stop_requested Stop flag
+         * @return Process exit code
+         */
+        int RunWorker(size_t index, const std::function<bool()>& stop_requested);
+
+        /**
+         * @brief Ask every worker to stop, then kill those that outlive the timeout
+         */
+        void StopWorkers();
+
+        /**
+         * @brief Render every slot's counters in the Prometheus text format
+         */
+        std::string RenderMetrics() const;
+
+        PreforkOptions m_options;                               ///< Settings
+        ServerFactory m_factory;                                ///< Builds worker servers
+        std::vector<BoundSocket> m_sockets;                     ///< Listening sockets
+        std::vector<network::LocalSocketOptions> m_socket_files;///< Unix socket files removed on exit
+        std::vector<network::MigrationChannel> m_channels;      ///< Connection handoff queue per slot (rebalance)
+        std::vector<int> m_cpus;                                ///< CPU each slot is pinned to (steer_cpu)
+        WorkerMetrics* m_metrics = nullptr;                     ///< Shared metrics area, one slot per worker
+        size_t m_worker_count = 0;                              ///< Metrics slots
+        std::vector<int64_t> m_pids;                            ///< Worker process per slot (0: none)
+        std::vector<std::chrono::steady_clock::time_point> m_started; ///< Fork time per slot
+        std::vector<std::chrono::steady_clock::time_point> m_restart_at; ///< Pending restart per slot
+    };
+
+} // namespace miniserver::core
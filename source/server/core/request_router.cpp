@@ -9,6 +9,7 @@
 #include "request_router.hpp"
 #include "service_registry.hpp"
 #include "static_file_handler.hpp"
+#include "net/body_encoding.hpp"
 #include "utils/logger.hpp"
 #include <sstream>
 #include <iomanip>
@@ -64,7 +65,7 @@ namespace miniserver::core
         catch (const std::exception& e)
         {
             LOG_ERROR_FMT("RequestRouter", "Error routing request: {}", e.what());
-            response = CreateErrorResponse(http::StatusCode::InternalServerError, "Internal Server Error");
+            response = CreateErrorResponse(request, http::StatusCode::InternalServerError, "Internal Server Error");
         }
 
         // Add CORS headers to all responses
@@ -76,6 +77,18 @@ namespace miniserver::core
         return response;
     }
 
+    /**
+     * @brief Set compression settings forwarded to the static file handler
+     * @param options Compression options
+     */
+    void RequestRouter::SetCompressionOptions(const http::CompressionOptions& options)
+    {
+        if (m_static_file_handler)
+        {
+            m_static_file_handler->SetCompressionOptions(options);
+        }
+    }
+
     /**
      * @brief Internal routing logic without exception handling
      * @param request HTTP request
@@ -89,7 +102,19 @@ namespace miniserver::core
             return HandleOptionsRequest(request);
         }
 
-        // 2. Handle API endpoints
+        // 2. WebSocket handshakes (the connection is handed over after the 101)
+        if (network::websocket::IsUpgradeRequest(request))
+        {
+            return HandleWebSocketUpgrade(request);
+        }
+
+        // 3. Resource-style service calls: /service/<name>/<resource> with any method (opt-in services only)
+        if (auto service_name = FindResourceService(request.path); !service_name.empty())
+        {
+            return m_service_registry->HandleServiceRequest(request, service_name);
+        }
+
+        // 4. Handle API endpoints
         if (request.method == http::Method::GET)
         {
             return HandleGetRequest(request);
@@ -99,8 +124,8 @@ namespace miniserver::core
             return HandlePostRequest(request);
         }
 
-        // 3. Method not allowed for other HTTP methods
-        return CreateErrorResponse(http::StatusCode::MethodNotAllowed, "Method not allowed");
+        // 5. Method not allowed for other HTTP methods
+        return CreateErrorResponse(request, http::StatusCode::MethodNotAllowed, "Method not allowed");
     }
 
     /**
@@ -118,10 +143,31 @@ namespace miniserver::core
             return m_service_registry->HandleServiceRequest(request, service_name);
         }
 
+        // Other services under /service/ are invoked with POST only
+        if (path.length() > 9 && path.compare(0, 9, "/service/") == 0 && m_service_registry->HasService(ExtractServiceName(path)))
+        {
+            http::Response response = CreateErrorResponse(request, http::StatusCode::MethodNotAllowed, "Method not allowed");
+            response.headers["Allow"] = "POST";
+            return response;
+        }
+
+        // Server-Sent Events: headers and preamble now, events later on the event loop
+        if (auto stream = FindEventStream(request))
+        {
+            http::Response response;
+            response.status = http::StatusCode::OK;
+            response.headers["Content-Type"] = "text/event-stream";
+            response.headers["Cache-Control"] = "no-cache";
+            response.headers["X-Accel-Buffering"] = "no";
+            response.body = stream->GetPreamble();
+            response.streaming = true;
+            return response;
+        }
+
         // Check for legacy /services endpoint
         if (path == "/services")
         {
-            return m_service_registry->GetServicesInfo();
+            return m_service_registry->GetServicesInfo(request);
         }
 
         // Static file serving (if available)
@@ -137,7 +183,100 @@ namespace miniserver::core
         }
 
         // Resource not found
-        return CreateErrorResponse(http::StatusCode::NotFound, "Resource not found");
+        return CreateErrorResponse(request, http::StatusCode::NotFound, "Resource not found");
+    }
+
+    /**
+     * @brief Find the WebSocket endpoint addressed by a request
+     * @param request HTTP request
+     * @return Endpoint callbacks, or nullptr if none is registered
+     */
+    std::shared_ptr<const network::WebSocketHandler> RequestRouter::FindWebSocketHandler(const http::Request& request) const
+    {
+        const std::string& path = request.path;
+        if (path.length() <= 4 || path.compare(0, 4, "/ws/") != 0)
+        {
+            return nullptr;
+        }
+        return m_service_registry->GetWebSocketHandler(path.substr(4));
+    }
+
+    /**
+     * @brief Find the service addressed by /service/<name>[/<resource>]
+     * @param path Request path
+     * @return Name of a registered resource service, or empty string
+     */
+    std::string RequestRouter::FindResourceService(const std::string& path) const
+    {
+        const std::string service_prefix = "/service/";
+        if (path.length() <= service_prefix.length() || path.compare(0, service_prefix.length(), service_prefix) != 0)
+        {
+            return "";
+        }
+
+        // An exact (possibly multi-segment) service name wins, then the first segment
+        const std::string remainder = path.substr(service_prefix.length());
+        if (m_service_registry->HasService(remainder))
+        {
+            return m_service_registry->IsResourceService(remainder) ? remainder : "";
+        }
+        const std::string service_name = remainder.substr(0, remainder.find('/'));
+        return m_service_registry->IsResourceService(service_name) ? service_name : "";
+    }
+
+    /**
+     * @brief Find the Server-Sent Events stream addressed by a request
+     * @param request HTTP request
+     * @return Stream, or nullptr if none is registered
+     */
+    std::shared_ptr<network::EventStream> RequestRouter::FindEventStream(const http::Request& request) const
+    {
+        const std::string& path = request.path;
+        if (request.method != http::Method::GET || path.length() <= 8 || path.compare(0, 8, "/events/") != 0)
+        {
+            return nullptr;
+        }
+        return m_service_registry->GetEventStream(path.substr(8));
+    }
+
+    /**
+     * @brief Answer a WebSocket handshake
+     * @param request HTTP request carrying "Upgrade: websocket"
+     * @return 101 Switching Protocols, or an error response
+     */
+    http::Response RequestRouter::HandleWebSocketUpgrade(const http::Request& request)
+    {
+        if (!FindWebSocketHandler(request))
+        {
+            return CreateErrorResponse(request, http::StatusCode::NotFound, "WebSocket endpoint not found");
+        }
+
+        // RFC 6455 4.2.1: a 16-byte base64 nonce and version 13
+        const std::string key = request.GetHeader("Sec-WebSocket-Key");
+        if (key.size() != 24 || key.compare(22, 2, "==") != 0)
+        {
+            return CreateErrorResponse(request, http::StatusCode::BadRequest, "Invalid Sec-WebSocket-Key");
+        }
+        if (request.GetHeader("Sec-WebSocket-Version") != "13")
+        {
+            http::Response response = CreateErrorResponse(request, http::StatusCode::BadRequest, "Unsupported WebSocket version");
+            response.headers["Sec-WebSocket-Version"] = "13";
+            return response;
+        }
+
+        http::Response response;
+        response.status = http::StatusCode::SwitchingProtocols;
+        response.headers["Upgrade"] = "websocket";
+        response.headers["Connection"] = "Upgrade";
+        response.headers["Sec-WebSocket-Accept"] = network::websocket::ComputeAcceptKey(key);
+
+        if (auto deflate = network::websocket::NegotiateDeflate(request.GetHeader("Sec-WebSocket-Extensions")))
+        {
+            response.headers["Sec-WebSocket-Extensions"] = network::websocket::FormatDeflateResponse(*deflate);
+        }
+
+        LOG_DEBUG_FMT("RequestRouter", "WebSocket handshake accepted for {}", request.path);
+        return response;
     }
 
     /**
@@ -155,13 +294,13 @@ namespace miniserver::core
             std::string service_name = ExtractServiceName(path);
             if (service_name.empty())
             {
-                return CreateErrorResponse(http::StatusCode::BadRequest, "Service name is required");
+                return CreateErrorResponse(request, http::StatusCode::BadRequest, "Service name is required");
             }
             return m_service_registry->HandleServiceRequest(request, service_name);
         }
 
         // No POST endpoints match
-        return CreateErrorResponse(http::StatusCode::NotFound, "Endpoint not found");
+        return CreateErrorResponse(request, http::StatusCode::NotFound, "Endpoint not found");
     }
 
     /**
@@ -203,25 +342,24 @@ namespace miniserver::core
      */
     http::Response RequestRouter::HandleRootRequest(const http::Request& request)
     {
-        (void)request; // Suppress unused parameter warning
-
         http::Response response;
         response.status = http::StatusCode::OK;
         
-        // Create welcome JSON response with API information
-        std::ostringstream json;
-        json << "{"
-             << "\"message\":\"Welcome to Mini Server\","
-             << "\"version\":\"1.0.0\","
-             << "\"endpoints\":{"
-             << "\"health\":\"GET /ping\","
-             << "\"services\":\"GET /services\","
-             << "\"invoke\":\"POST /service/<name>\""
-             << "},"
-             << "\"timestamp\":\"" << GetCurrentTimestamp() << "\""
-             << "}";
+        // Create welcome response with API information
+        auto writer = http::StructuredWriter::ForRequest(request);
+        writer.BeginObject(4);
+        writer.Key("message"); writer.String("Welcome to Mini Server");
+        writer.Key("version"); writer.String("1.0.0");
+        writer.Key("endpoints");
+        writer.BeginObject(3);
+        writer.Key("health");   writer.String("GET /ping");
+        writer.Key("services"); writer.String("GET /services");
+        writer.Key("invoke");   writer.String("POST /service/<name>");
+        writer.EndObject();
+        writer.Key("timestamp"); writer.String(GetCurrentTimestamp());
+        writer.EndObject();
         
-        response.SetJson(json.str());
+        writer.WriteTo(response);
 
         LOG_DEBUG("RequestRouter", "Handled root request");
         return response;
@@ -229,23 +367,23 @@ namespace miniserver::core
 
     /**
      * @brief Create error response
+     * @param request HTTP request (its Accept header selects the encoding)
      * @param status HTTP status code
      * @param message Error message
      * @return HTTP response
      */
-    http::Response RequestRouter::CreateErrorResponse(http::StatusCode status, const std::string& message)
+    http::Response RequestRouter::CreateErrorResponse(const http::Request& request, http::StatusCode status, const std::string& message)
     {
         http::Response response;
         response.status = status;
-        
-        std::ostringstream json;
-        json << "{"
-             << "\"error\":\"" << message << "\","
-             << "\"status\":" << static_cast<int>(status) << ","
-             << "\"timestamp\":\"" << GetCurrentTimestamp() << "\""
-             << "}";
-        
-        response.SetJson(json.str());
+
+        auto writer = http::StructuredWriter::ForRequest(request);
+        writer.BeginObject(3);
+        writer.Key("error");     writer.String(message);
+        writer.Key("status");    writer.Int(static_cast<int>(status));
+        writer.Key("timestamp"); writer.String(GetCurrentTimestamp());
+        writer.EndObject();
+        writer.WriteTo(response);
 
         LOG_DEBUG_FMT("RequestRouter", "Created error response: {} - {}", static_cast<int>(status), message);
         return response;
@@ -10,6 +10,8 @@
 
 #include "net/http_types.hpp"
 #include "static_file_handler.hpp"
+#include "net/websocket.hpp"
+#include "net/event_stream.hpp"
 #include <memory>
 
 namespace miniserver::services
@@ -44,6 +46,23 @@ namespace miniserver::core
          * @return HTTP response
          */
         http::Response RouteRequest(const http::Request& request);
+        /**
+         * @brief Set compression settings forwarded to the static file handler
+         * @param options Compression options
+         */
+        void SetCompressionOptions(const http::CompressionOptions& options);
+        /**
+         * @brief Find the WebSocket endpoint addressed by a request
+         * @param request HTTP request (path /ws/<name>)
+         * @return Endpoint callbacks, or nullptr if none is registered
+         */
+        std::shared_ptr<const network::WebSocketHandler> FindWebSocketHandler(const http::Request& request) const;
+        /**
+         * @brief Find the Server-Sent Events stream addressed by a request
+         * @param request HTTP request (GET /events/<name>)
+         * @return Stream, or nullptr if none is registered
+         */
+        std::shared_ptr<network::EventStream> FindEventStream(const http::Request& request) const;
 
     private:
         services::ServiceRegistry* m_service_registry; ///< Service registry
@@ -62,17 +81,24 @@ namespace miniserver::core
         http::Response HandleRootRequest(const http::Request& request);
         /**
          * @brief Create error response
+         * @param request HTTP request (its Accept header selects the encoding)
          * @param status HTTP status code
          * @param message Error message
          * @return HTTP response
          */
-        http::Response CreateErrorResponse(http::StatusCode status, const std::string& message);
+        http::Response CreateErrorResponse(const http::Request& request, http::StatusCode status, const std::string& message);
         /**
          * @brief Extract service name from path
          * @param path Request path (e.g. /api/services/echo)
          * @return Service name, empty string if extraction fails
          */
         std::string ExtractServiceName(const std::string& path);
+        /**
+         * @brief Find the resource service addressed by /service/<name>[/<resource>]
+         * @param path Request path (e.g. /service/kv/user:42)
+         * @return Registered service name, empty string if none matches
+         */
+        std::string FindResourceService(const std::string& path) const;
         /**
          * @brief Get current timestamp in ISO 8601 format
          * @return Current timestamp string
@@ -90,6 +116,12 @@ namespace miniserver::core
          * @return HTTP response
          */
         http::Response HandleGetRequest(const http::Request& request);
+        /**
+         * @brief Answer a WebSocket handshake (101 or an error)
+         * @param request HTTP request carrying "Upgrade: websocket"
+         * @return HTTP response
+         */
+        http::Response HandleWebSocketUpgrade(const http::Request& request);
         /**
          * @brief Handle POST requests
          * @param request HTTP request
@@ -11,6 +11,7 @@
 #include "net/http_types.hpp"    // Ensure proper namespace resolution
 #include "net/socket_server.hpp"
 #include "net/http_parser.hpp"
+#include "net/body_encoding.hpp"
 #include "utils/logger.hpp"
 
 #include <stdexcept>
@@ -22,6 +23,39 @@
 
 namespace miniserver::core
 {
+    namespace
+    {
+        /**
+         * @brief Path of the request target in a raw request head ("METHOD target HTTP/1.x")
+         */
+        std::string_view RequestPath(std::string_view head)
+        {
+            const size_t target_start = head.find(' ');
+            if (target_start == std::string_view::npos)
+            {
+                return {};
+            }
+            const size_t target_end = head.find_first_of(" ?\r", target_start + 1);
+            return head.substr(target_start + 1, target_end == std::string_view::npos
+                ? std::string_view::npos : target_end - target_start - 1);
+        }
+
+        constexpr std::chrono::milliseconds kListenSamplePeriod{100};  ///< Accept queue sampling interval
+    }
+
+    bool ListenerOptions::Allows(std::string_view path) const
+    {
+        const auto matches = [path](const std::string& prefix)
+        {
+            return path.compare(0, prefix.size(), prefix) == 0 &&
+                (path.size() == prefix.size() || prefix.empty() || prefix.back() == '/' || path[prefix.size()] == '/');
+        };
+        if (std::any_of(deny_prefixes.begin(), deny_prefixes.end(), matches))
+        {
+            return false;
+        }
+        return allow_prefixes.empty() || std::any_of(allow_prefixes.begin(), allow_prefixes.end(), matches);
+    }
 
     /**
      * @brief Construct a new Server object
@@ -33,12 +67,18 @@ namespace miniserver::core
         : m_port(port)
         , m_service_registry(std::make_unique<services::ServiceRegistry>())
         , m_request_router(std::make_unique<RequestRouter>(m_service_registry.get(), web_root))
-        , m_socket_server(std::make_unique<network::SocketServer>())
+        , m_event_loop(std::make_unique<network::EventLoop>())
+        , m_kv_store(std::make_shared<services::KvStore>())
+        , m_reverse_proxy(std::make_unique<network::ReverseProxy>())
     {
         if (port <= 0 || port > 65535)
         {
             throw std::invalid_argument("Port must be between 1 and 65535");
         }
+        auto main_listener = std::make_unique<Listener>();
+        main_listener->options.name = "main";
+        main_listener->options.port = port;
+        m_listeners.push_back(std::move(main_listener));
         LOG_INFO_FMT(Server, "Server created on port {} with web root: {}", m_port, web_root.empty() ? "none" : web_root);
     }
 
@@ -64,9 +104,134 @@ namespace miniserver::core
 
         RegisterInternalServices();
 
+        // A process already serving on the takeover socket hands its listening sockets over
+        std::unique_ptr<network::TakeoverClient> takeover;
+        if (!m_takeover_socket.path.empty())
+        {
+            takeover = std::make_unique<network::TakeoverClient>();
+            if (!takeover->Connect(m_takeover_socket))
+            {
+                takeover.reset();
+            }
+        }
+
+        // Bind every listener up front so a taken port fails Start as a whole
+        for (size_t i = 0; i < m_listeners.size(); ++i)
+        {
+            if (!BindListener(*m_listeners[i], takeover.get()))
+            {
+                // Release, not Stop: shutting down an inherited socket would break the old process
+                for (size_t j = 0; j < i; ++j)
+                {
+                    m_listeners[j]->socket_server->Release();
+                }
+                return;
+            }
+        }
+
         m_running.store(true);
 
-        m_server_thread = std::thread(&Server::RunServer, this);
+        m_event_loop->Start();
+        m_event_loop->Post([this]() { SampleListeners(); });
+        if (m_reverse_proxy->HasRoutes())
+        {
+            m_reverse_proxy->Start();
+        }
+
+        // Same-host callers reach the service registry without sockets
+        if (!m_shm_options.socket.path.empty())
+        {
+            m_shm_server = std::make_unique<network::ShmServer>([this](const network::ShmRequest& call)
+            {
+                http::Request request;
+                request.method = http::Method::POST;
+                request.path = "/service/" + call.service;
+                request.body = call.body;
+                if (!call.content_type.empty())
+                {
+                    request.headers["content-type"] = call.content_type;
+                }
+                http::Response response = m_service_registry->HandleServiceRequest(request, call.service);
+
+                network::ShmResponse reply;
+                reply.status = static_cast<int>(response.status);
+                auto type = response.headers.find("Content-Type");
+                if (type != response.headers.end())
+                {
+                    reply.content_type = type->second;
+                }
+                reply.body = std::move(response.body);
+                return reply;
+            });
+            if (!m_shm_server->Start(m_shm_options))
+            {
+                LOG_ERROR(Server, "Shared-memory transport not started");
+                m_shm_server.reset();
+            }
+        }
+
+        // HTTP/3 shares the main listener's policy; TLS responses advertise it once it is up
+        if (m_http3_options.port != 0)
+        {
+            m_http3_server = std::make_unique<network::Http3Server>([this](const std::string& request_data)
+            {
+                return HandleRequest(request_data, m_listeners.front()->options);
+            });
+            if (m_http3_server->Start(m_http3_options))
+            {
+                m_alt_svc = "h3=\":" + std::to_string(m_http3_server->GetPort()) + "\"; ma=86400";
+            }
+            else
+            {
+                LOG_ERROR(Server, "HTTP/3 listener not started");
+                m_http3_server.reset();
+            }
+        }
+
+        if (m_udp_ingest_options.port != 0)
+        {
+            m_udp_ingest = std::make_unique<network::UdpIngestServer>(m_udp_ingest_handler);
+            if (!m_udp_ingest->Start(m_udp_ingest_options))
+            {
+                LOG_ERROR(Server, "UDP ingest listener not started");
+                m_udp_ingest.reset();
+            }
+        }
+
+        for (auto& listener : m_listeners)
+        {
+            listener->thread = std::thread(&Server::RunListener, this, std::ref(*listener));
+        }
+
+        if (!m_takeover_socket.path.empty())
+        {
+            m_takeover_server = std::make_unique<network::TakeoverServer>([this]()
+            {
+                std::vector<network::InheritedListener> sockets;
+                for (const auto& listener : m_listeners)
+                {
+                    sockets.push_back({listener->options.name, false, listener->socket_server->GetTcpListener()});
+                    sockets.push_back({listener->options.name, true, listener->socket_server->GetLocalListener()});
+                }
+                return sockets;
+            },
+            [this]()
+            {
+                CompleteTakeover();
+            });
+            network::LocalSocketOptions takeover_socket = m_takeover_socket;
+            takeover_socket.mode = 0600;
+            if (!m_takeover_server->Start(takeover_socket, std::chrono::seconds(30),
+                                          takeover ? takeover->TakeTakeoverSocket() : INVALID_SOCKET))
+            {
+                LOG_ERROR(Server, "Takeover socket not started");
+                m_takeover_server.reset();
+            }
+        }
+        if (takeover && takeover->Confirm())
+        {
+            LOG_INFO(Server, "Took over the listening sockets; the previous process drains and exits");
+        }
     }
 
     /**
@@ -74,7 +239,10 @@ namespace miniserver::core
      */
     void Server::Stop()
     {
-        if (!m_running.load())
+        // After a takeover m_running is already false, but the listener threads still need joining
+        const bool started = std::any_of(m_listeners.begin(), m_listeners.end(),
+            [](const auto& listener) { return listener->thread.joinable(); });
+        if (!m_running.load() && !started)
         {
             return;
         }
@@ -82,14 +250,52 @@ namespace miniserver::core
 
         m_running.store(false);
 
-        if (m_socket_server)
+        if (m_takeover_server)
         {
-            m_socket_server->Stop();
+            m_takeover_server->Stop();
+            m_takeover_server.reset();
         }
+        for (auto& listener : m_listeners)
+        {
+            // Shutting down a shared socket would stop the other processes accepting on it
+            if (listener->shared)
+            {
+                listener->socket_server->Release();
+            }
+            else
+            {
+                listener->socket_server->Stop();
+            }
+        }
+        for (auto& listener : m_listeners)
+        {
+            if (listener->thread.joinable())
+            {
+                listener->thread.join();
+            }
+        }
+
+        // Requests in flight get their responses; idle keep-alive connections close now
+        DrainListeners();
 
-        if (m_server_thread.joinable())
+        // Upgraded connections are closed with 1001 (going away)
+        m_event_loop->Stop();
+        m_reverse_proxy->Stop();
+        if (m_shm_server)
         {
-            m_server_thread.join();
+            m_shm_server->Stop();
+            m_shm_server.reset();
+        }
+        if (m_http3_server)
+        {
+            m_http3_server->Stop();
+            m_http3_server.reset();
+            m_alt_svc.clear();
+        }
+        if (m_udp_ingest)
+        {
+            m_udp_ingest->Stop();
+            m_udp_ingest.reset();
         }
 
         LOG_INFO(Server, "Server stopped");
@@ -99,9 +305,10 @@ namespace miniserver::core
      * @brief Register a service with a full HTTP handler
      * @param service_name Name of the service
      * @param handler Service handler function
+     * @param resource Also route GET/PUT/DELETE and sub-paths to the service
      * @return true if registration succeeded, false otherwise
      */
-    bool Server::RegisterService(const std::string& service_name, services::ServiceHandler handler)
+    bool Server::RegisterService(const std::string& service_name, services::ServiceHandler handler, bool resource)
     {
         if (m_running.load())
         {
@@ -127,6 +334,7 @@ namespace miniserver::core
             handler,
             true
         );
+        service_info.resource = resource;
 
         bool success = m_service_registry->RegisterService(service_name, service_info);
         if (success) 
@@ -208,6 +416,432 @@ namespace miniserver::core
         return m_service_registry->GetServiceNames();
     }
 
+    /**
+     * @brief Configure response compression
+     * @param options Compression options
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetCompressionOptions(const http::CompressionOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change compression settings: server is running");
+            return false;
+        }
+        m_compression = options;
+        m_request_router->SetCompressionOptions(options);
+        return true;
+    }
+
+    /**
+     * @brief Configure limits for compressed request bodies
+     * @param limits Decompression limits
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetDecompressionLimits(const http::DecompressionLimits& limits)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change decompression limits: server is running");
+            return false;
+        }
+        m_decompression_limits = limits;
+        return true;
+    }
+
+    /**
+     * @brief Register a WebSocket endpoint
+     * @param name Endpoint name (served at /ws/<name>)
+     * @param handler Session callbacks
+     * @return true if registration succeeded, false otherwise
+     */
+    bool Server::RegisterWebSocketHandler(const std::string& name, network::WebSocketHandler handler)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN_FMT(Server, "Cannot register WebSocket endpoint '{}': server is running", name);
+            return false;
+        }
+        return m_service_registry->RegisterWebSocketHandler(name, std::move(handler));
+    }
+
+    /**
+     * @brief Configure WebSocket limits and timers
+     * @param options WebSocket options
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetWebSocketOptions(const network::WebSocketOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change WebSocket options: server is running");
+            return false;
+        }
+        m_websocket_options = options;
+        return true;
+    }
+
+    /**
+     * @brief Create a Server-Sent Events stream
+     * @param name Stream name (served at /events/<name>)
+     * @param options Per-subscriber queue limit and heartbeat
+     * @return Stream, or nullptr if the server is running or the name is taken
+     */
+    std::shared_ptr<network::EventStream> Server::CreateEventStream(const std::string& name,
+                                                                    const network::EventStreamOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN_FMT(Server, "Cannot create event stream '{}': server is running", name);
+            return nullptr;
+        }
+
+        auto stream = std::make_shared<network::EventStream>(*m_event_loop, name, options);
+        if (!m_service_registry->RegisterEventStream(name, stream))
+        {
+            return nullptr;
+        }
+        return stream;
+    }
+
+    /**
+     * @brief Configure the built-in key/value store
+     * @param options Store limits
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetKvStoreOptions(const services::KvStoreOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change key/value store options: server is running");
+            return false;
+        }
+        m_kv_store = std::make_shared<services::KvStore>(options);
+        return true;
+    }
+
+    /**
+     * @brief Access the built-in key/value store
+     * @return Store shared with /service/kv
+     */
+    services::KvStore& Server::GetKvStore()
+    {
+        return *m_kv_store;
+    }
+
+    /**
+     * @brief Forward a path prefix to upstream backends
+     * @param prefix Path prefix
+     * @param upstreams Backend addresses as "host:port"
+     * @param strip_prefix Remove the prefix from the forwarded path
+     * @return true if the route was added
+     */
+    bool Server::AddProxyRoute(const std::string& prefix, const std::vector<std::string>& upstreams, bool strip_prefix)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN_FMT(Server, "Cannot add proxy route '{}': server is running", prefix);
+            return false;
+        }
+        return m_reverse_proxy->AddRoute(prefix, upstreams, strip_prefix);
+    }
+
+    /**
+     * @brief Forward a path prefix to upstream backends with a route policy
+     * @param prefix Path prefix
+     * @param upstreams Backend addresses as "host:port"
+     * @param options Prefix stripping and hedging
+     * @return true if the route was added
+     */
+    bool Server::AddProxyRoute(const std::string& prefix, const std::vector<std::string>& upstreams,
+                               const network::ProxyRouteOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN_FMT(Server, "Cannot add proxy route '{}': server is running", prefix);
+            return false;
+        }
+        return m_reverse_proxy->AddRoute(prefix, upstreams, options);
+    }
+
+    /**
+     * @brief Configure upstream pooling, retries and health checks
+     * @param options Reverse proxy options
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetProxyOptions(const network::ReverseProxyOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change proxy options: server is running");
+            return false;
+        }
+        m_reverse_proxy->SetOptions(options);
+        return true;
+    }
+
+    /**
+     * @brief Configure the Unix domain socket listener
+     * @param options Socket path (or abstract name) and permissions
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetLocalSocket(const network::LocalSocketOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change the unix socket: server is running");
+            return false;
+        }
+        m_listeners.front()->options.local_socket = options;
+        return true;
+    }
+
+    /**
+     * @brief Configure the restart handoff socket
+     * @param options Socket path (or abstract name)
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetTakeover(const network::LocalSocketOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change the takeover socket: server is running");
+            return false;
+        }
+        m_takeover_socket = options;
+        return true;
+    }
+
+    /**
+     * @brief Use listening sockets bound by a supervising process
+     * @param sockets Listening sockets, matched to listeners by name and kind
+     */
+    void Server::SetInheritedListeners(std::vector<network::InheritedListener> sockets)
+    {
+        m_inherited_listeners = std::move(sockets);
+    }
+
+    /**
+     * @brief Configured listeners
+     * @return Listener options, "main" first
+     */
+    std::vector<ListenerOptions> Server::GetListenerOptions() const
+    {
+        std::vector<ListenerOptions> options;
+        for (const auto& listener : m_listeners)
+        {
+            options.push_back(listener->options);
+        }
+        return options;
+    }
+
+    /**
+     * @brief Sum the counters of every listener
+     * @return Counters snapshot
+     */
+    ServerCounters Server::GetCounters() const
+    {
+        ServerCounters counters;
+        counters.requests = m_request_count.load();
+        for (const auto& listener : m_listeners)
+        {
+            if (listener->socket_server)
+            {
+                const network::ConnectionStats stats = listener->socket_server->GetConnectionStats();
+                counters.active_connections += stats.active;
+                counters.accepted += stats.accepted;
+                counters.rejected += stats.rejected;
+                counters.migrated_out += stats.migrated_out;
+                counters.migrated_in += stats.migrated_in;
+                counters.cpu_local += stats.cpu_local;
+                counters.cpu_remote += stats.cpu_remote;
+                counters.listen_queue += stats.listen_queue.length;
+                counters.listen_backlog += stats.listen_queue.backlog;
+                counters.first_byte.Merge(stats.first_byte);
+            }
+        }
+        counters.listen_overflows = m_listen_overflows.load();
+        counters.listen_drops = m_listen_drops.load();
+        return counters;
+    }
+
+    /**
+     * @brief Set the drain deadline
+     * @param timeout Longest wait for open connections
+     */
+    void Server::SetDrainTimeout(std::chrono::milliseconds timeout)
+    {
+        m_drain_timeout = timeout;
+    }
+
+    /**
+     * @brief Let open connections finish on every listener within one deadline
+     */
+    void Server::DrainListeners()
+    {
+        const auto deadline = std::chrono::steady_clock::now() + m_drain_timeout;
+        for (auto& listener : m_listeners)
+        {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            listener->socket_server->Drain(std::max(left, std::chrono::milliseconds(0)));
+        }
+    }
+
+    /**
+     * @brief Hand the ports to the replacement: stop accepting, drain, stop
+     */
+    void Server::CompleteTakeover()
+    {
+        for (auto& listener : m_listeners)
+        {
+            listener->socket_server->Release();
+        }
+        LOG_INFO_FMT(Server, "Draining open connections (up to {} ms)", m_drain_timeout.count());
+        DrainListeners();
+
+        // The main loop sees the server stopped and calls Stop, which joins the listener threads
+        m_running.store(false);
+    }
+
+    /**
+     * @brief Add or replace a listener
+     * @param options Address, route subset and limits
+     * @return true if applied, false if the server is running or the listener has no endpoint
+     */
+    bool Server::AddListener(const ListenerOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change listeners: server is running");
+            return false;
+        }
+        if (options.port < 0 || options.port > 65535 || (options.port == 0 && options.local_socket.path.empty()))
+        {
+            LOG_WARN_FMT(Server, "Listener '{}' needs a port between 1 and 65535 or a unix socket", options.name);
+            return false;
+        }
+
+        auto existing = std::find_if(m_listeners.begin(), m_listeners.end(),
+            [&options](const auto& listener) { return listener->options.name == options.name; });
+        if (existing == m_listeners.end())
+        {
+            existing = m_listeners.insert(m_listeners.end(), std::make_unique<Listener>());
+        }
+        (*existing)->options = options;
+        if (existing == m_listeners.begin())
+        {
+            m_port = options.port;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Configure the shared-memory transport
+     * @param options Handshake socket and ring settings
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetShmTransport(const network::ShmServerOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change the shared-memory transport: server is running");
+            return false;
+        }
+        m_shm_options = options;
+        return true;
+    }
+
+    /**
+     * @brief Configure the HTTP/3 listener
+     * @param options UDP port, certificate and QUIC limits
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetHttp3(const network::Http3ServerOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change the HTTP/3 listener: server is running");
+            return false;
+        }
+        m_http3_options = options;
+        return true;
+    }
+
+    /**
+     * @brief Configure the UDP telemetry listener
+     * @param options UDP port and batch size
+     * @param handler Batch consumer
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetUdpIngest(const network::UdpIngestOptions& options, network::IngestHandler handler)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change the UDP ingest listener: server is running");
+            return false;
+        }
+        m_udp_ingest_options = options;
+        m_udp_ingest_handler = std::move(handler);
+        return true;
+    }
+
+    /**
+     * @brief Configure CONNECT tunneling
+     * @param options Allowed targets and timers (enabled = false turns tunneling off)
+     * @return true if applied, false if the server is already running
+     */
+    bool Server::SetConnectTunnel(const network::ConnectTunnelOptions& options)
+    {
+        if (m_running.load())
+        {
+            LOG_WARN(Server, "Cannot change CONNECT tunneling: server is running");
+            return false;
+        }
+        if (options.enabled)
+        {
+            m_connect_proxy = std::make_unique<network::ConnectProxy>(*m_event_loop, options);
+        }
+        else
+        {
+            m_connect_proxy.reset();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Let another process take idle keep-alive connections
+     * @param migrator Decides per connection and passes it on
+     */
+    void Server::SetConnectionMigrator(ConnectionMigrator migrator)
+    {
+        m_connection_migrator = std::move(migrator);
+    }
+
+    /**
+     * @brief Serve a connection migrated from another process
+     * @param connection Socket, listener name and buffered bytes
+     * @return false if no running listener has that name
+     */
+    bool Server::AdoptConnection(network::MigratedConnection connection)
+    {
+        for (auto& listener : m_listeners)
+        {
+            if (listener->options.name == connection.listener && listener->socket_server && !listener->options.tls)
+            {
+                const ListenerOptions& options = listener->options;
+                return listener->socket_server->Adopt(connection.socket, std::move(connection.buffered), connection.client_ip,
+                    [this, &options](const std::string& request_data) -> std::string
+                    {
+                        return HandleRequest(request_data, options);
+                    });
+            }
+        }
+        LOG_WARN_FMT(Server, "No listener '{}' for a migrated connection", connection.listener);
+        network::MigrationChannel::Discard(connection);
+        return false;
+    }
+
     /**
      * @brief Check if the server is currently running
      * @return true if running, false otherwise
@@ -218,32 +852,143 @@ namespace miniserver::core
     }
 
     /**
-     * @brief Main server loop, runs in a separate thread
+     * @brief Bind a listener's sockets and install its handlers
+     * @param listener Listener to bind
+     * @param takeover Sockets received from the process being replaced (may be null)
+     * @return true if listening
      */
-    void Server::RunServer()
+    bool Server::BindListener(Listener& listener, network::TakeoverClient* takeover)
     {
-        try
+        const ListenerOptions& options = listener.options;
+        listener.socket_server = std::make_unique<network::SocketServer>();
+        listener.socket_server->SetLimits(options.limits);
+        listener.socket_server->SetDecompressionLimits(m_decompression_limits);
+        listener.socket_server->SetTls(options.tls);
+        listener.socket_server->SetTuning(options.tuning);
+        listener.socket_server->SetBusyPoll(options.busy_poll);
+        if (m_connection_migrator && !options.tls)
         {
-            // Start the socket server
-            if (!m_socket_server->Start("0.0.0.0", m_port))
+            listener.socket_server->SetMigrationHandler([this, &options](SOCKET client_socket, const std::string& buffered,
+                                                                         const std::string& client_ip)
             {
-                LOG_ERROR_FMT(Server, "Failed to start server on port {}", m_port);
-                m_running.store(false);
-                return;
+                return m_connection_migrator({options.name, client_socket, client_ip, buffered});
+            });
+        }
+        if (takeover)
+        {
+            listener.socket_server->Inherit(takeover->Take(options.name, false), takeover->Take(options.name, true));
+        }
+        else if (!m_inherited_listeners.empty())
+        {
+            SOCKET shared[2] = {INVALID_SOCKET, INVALID_SOCKET};
+            for (const auto& inherited : m_inherited_listeners)
+            {
+                if (inherited.name == options.name)
+                {
+                    shared[inherited.local ? 1 : 0] = inherited.socket;
+                }
             }
-            LOG_INFO_FMT(Server, "Server running on http://localhost:{}", m_port);
+            listener.shared = shared[0] != INVALID_SOCKET || shared[1] != INVALID_SOCKET;
+            listener.socket_server->Inherit(shared[0], shared[1]);
+        }
+        listener.socket_server->SetHandoffHandler([this](SOCKET client_socket, const std::string& request_data,
+                                                         const std::string& response, const std::string& buffered,
+                                                         const std::string& client_ip)
+        {
+            return HandleHandoff(client_socket, request_data, response, buffered, client_ip);
+        });
+        // CONNECT is served where every path is: listeners carved down to a subset (admin) answer 405
+        const bool tunnels = m_connect_proxy && options.allow_prefixes.empty();
+        if (m_reverse_proxy->HasRoutes() || tunnels)
+        {
+            listener.socket_server->SetPassthroughHandler([this, &options, tunnels](SOCKET client_socket, std::string& buffer,
+                                                                                    size_t head_size, const std::string& client_ip)
+            {
+                if (tunnels && network::ConnectProxy::IsConnectRequest(buffer))
+                {
+                    m_request_count.fetch_add(1, std::memory_order_relaxed);
+                    return m_connect_proxy->Serve(client_socket, buffer, head_size, client_ip);
+                }
+                if (!m_reverse_proxy->HasRoutes())
+                {
+                    return network::PassthroughResult::Declined;
+                }
 
-            // Run the server with our request handler
-            m_socket_server->Run([this](const std::string& request_data) -> std::string
+                // Paths refused here fall through to HandleRequest, which answers 404
+                if (!options.Allows(RequestPath(std::string_view(buffer).substr(0, head_size))))
+                {
+                    return network::PassthroughResult::Declined;
+                }
+                const network::PassthroughResult result = m_reverse_proxy->Serve(client_socket, buffer, head_size, client_ip);
+                if (result != network::PassthroughResult::Declined)
+                {
+                    m_request_count.fetch_add(1, std::memory_order_relaxed);
+                }
+                return result;
+            });
+        }
+
+        if (!listener.socket_server->Start(options.host, options.port, options.local_socket))
+        {
+            LOG_ERROR_FMT(Server, "Failed to start listener '{}' on port {}", options.name, options.port);
+            return false;
+        }
+        if (options.port > 0)
+        {
+            LOG_INFO_FMT(Server, "Listener '{}' running on http://{}:{}", options.name,
+                options.host == "0.0.0.0" ? "localhost" : options.host, options.port);
+        }
+        if (!options.local_socket.path.empty())
+        {
+            LOG_INFO_FMT(Server, "Listener '{}' running on unix socket {}{}", options.name,
+                options.local_socket.abstract ? "@" : "", options.local_socket.path);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Accept loop of one listener, runs in its own thread
+     * @param listener Bound listener
+     */
+    void Server::RunListener(Listener& listener)
+    {
+        try
+        {
+            const ListenerOptions& options = listener.options;
+            listener.socket_server->Run([this, &options](const std::string& request_data) -> std::string
             {
-                return HandleRequest(request_data);
+                return HandleRequest(request_data, options);
             });
         }
         catch (const std::exception& e)
         {
-            LOG_ERROR_FMT(Server, "Server error: {}", e.what());
-            m_running.store(false);
-        }   
+            LOG_ERROR_FMT(Server, "Listener '{}' error: {}", listener.options.name, e.what());
+        }
+    }
+
+    /**
+     * @brief Sample the kernel's side of accepting: queue lengths per listener and host-wide drops
+     *
+     * Runs on the event loop every kListenSamplePeriod, so queueing in the
+     * kernel can be told apart from the first-byte latency the listeners
+     * measure in the process. Stops with the loop.
+     */
+    void Server::SampleListeners()
+    {
+        for (auto& listener : m_listeners)
+        {
+            if (listener->socket_server)
+            {
+                listener->socket_server->SampleListenQueue();
+            }
+        }
+        network::ListenDropCounters drops;
+        if (network::SocketServer::ReadListenDrops(drops))
+        {
+            m_listen_overflows.store(drops.overflows, std::memory_order_relaxed);
+            m_listen_drops.store(drops.drops, std::memory_order_relaxed);
+        }
+        m_event_loop->AddTimer(kListenSamplePeriod, [this]() { SampleListeners(); });
     }
 
     /**
@@ -255,21 +1000,19 @@ namespace miniserver::core
         // Health check endpoint
         RegisterService("ping", [this](const http::Request& request) -> http::Response 
         {
-            (void)request; // Suppress unused parameter warning
-            
             http::Response response;
             response.status = http::StatusCode::OK;
             
-            // Create health check JSON response  
-            std::ostringstream json;
-            json << "{"
-                 << "\"status\":\"ok\","
-                 << "\"message\":\"ping\","
-                 << "\"timestamp\":\"" << GetCurrentTimestamp() << "\","
-                 << "\"services\":" << m_service_registry->GetServiceNames().size()
-                 << "}";
+            // Create health check response in the encoding the client accepts
+            auto writer = http::StructuredWriter::ForRequest(request);
+            writer.BeginObject(4);
+            writer.Key("status");    writer.String("ok");
+            writer.Key("message");   writer.String("ping");
+            writer.Key("timestamp"); writer.String(GetCurrentTimestamp());
+            writer.Key("services");  writer.UInt(m_service_registry->GetServiceCount());
+            writer.EndObject();
             
-            response.SetJson(json.str());
+            writer.WriteTo(response);
             return response;
         });
 
@@ -299,8 +1042,6 @@ namespace miniserver::core
         // Server statistics endpoint
         RegisterService("api/server/stats", [this](const http::Request& request) -> http::Response 
         {
-            (void)request; // Suppress unused parameter warning
-            
             http::Response response;
             response.status = http::StatusCode::OK;
             
@@ -309,21 +1050,206 @@ namespace miniserver::core
             auto now = std::chrono::steady_clock::now();
             auto uptime_seconds = std::chrono::duration_cast<std::chrono::seconds>(now - start_time).count();
             
-            // Create server stats JSON response
-            std::ostringstream json;
-            json << "{"
-                 << "\"uptime\":" << uptime_seconds << ","
-                 << "\"uptimeFormatted\":\"" << FormatUptime(uptime_seconds) << "\","
-                 << "\"requestCount\":0,"
-                 << "\"memoryUsage\":\"N/A\","
-                 << "\"port\":8080,"
-                 << "\"version\":\"1.0.0\","
-                 << "\"timestamp\":\"" << GetCurrentTimestamp() << "\""
-                 << "}";
+            // Create server stats response in the encoding the client accepts
+            auto writer = http::StructuredWriter::ForRequest(request);
+            writer.BeginObject(9 + (m_http3_server ? 1 : 0) + (m_udp_ingest ? 1 : 0) + (m_connect_proxy ? 1 : 0));
+            writer.Key("uptime");          writer.Int(uptime_seconds);
+            writer.Key("uptimeFormatted"); writer.String(FormatUptime(uptime_seconds));
+            writer.Key("requestCount");    writer.UInt(m_request_count.load());
+            writer.Key("memoryUsage");     writer.String("N/A");
+            writer.Key("port");            writer.Int(m_port);
+            writer.Key("version");         writer.String("1.0.0");
+            writer.Key("timestamp");       writer.String(GetCurrentTimestamp());
+            writer.Key("listenDrops");
+            writer.BeginObject(2);
+            writer.Key("overflows"); writer.UInt(m_listen_overflows.load());
+            writer.Key("drops");     writer.UInt(m_listen_drops.load());
+            writer.EndObject();
+            writer.Key("listeners");
+            writer.BeginArray(m_listeners.size());
+            for (const auto& listener : m_listeners)
+            {
+                const network::ConnectionStats connections = listener->socket_server->GetConnectionStats();
+                const auto& tls = listener->options.tls;
+                const bool busy_poll = listener->options.busy_poll.enabled;
+                const bool cpu_stats = listener->options.tuning.cpu_stats;
+                const bool zerocopy = listener->options.tuning.zerocopy_threshold > 0;
+                writer.BeginObject(9 + (tls ? 1 : 0) + (busy_poll ? 1 : 0) + (cpu_stats ? 1 : 0) + (zerocopy ? 1 : 0));
+                writer.Key("name");           writer.String(listener->options.name);
+                writer.Key("address");        writer.String(listener->socket_server->GetAddress());
+                writer.Key("active");         writer.UInt(connections.active);
+                writer.Key("accepted");       writer.UInt(connections.accepted);
+                writer.Key("rejected");       writer.UInt(connections.rejected);
+                writer.Key("acceptWakeups");  writer.UInt(connections.accept_wakeups);
+                writer.Key("maxConnections"); writer.UInt(listener->options.limits.max_connections);
+                writer.Key("listenQueue");
+                writer.BeginObject(3);
+                writer.Key("length");  writer.UInt(connections.listen_queue.length);
+                writer.Key("backlog"); writer.UInt(connections.listen_queue.backlog);
+                writer.Key("peak");    writer.UInt(connections.listen_queue.peak);
+                writer.EndObject();
+                writer.Key("firstByte");
+                writer.BeginObject(4);
+                writer.Key("count");  writer.UInt(connections.first_byte.count);
+                writer.Key("meanUs"); writer.UInt(connections.first_byte.count == 0 ? 0
+                    : connections.first_byte.sum_us / connections.first_byte.count);
+                writer.Key("p50Us");  writer.UInt(connections.first_byte.QuantileUs(0.5));
+                writer.Key("p99Us");  writer.UInt(connections.first_byte.QuantileUs(0.99));
+                writer.EndObject();
+                if (tls)
+                {
+                    const network::TlsStats handshakes = tls->GetStats();
+                    writer.Key("tls");
+                    writer.BeginObject(4);
+                    writer.Key("handshakes"); writer.UInt(handshakes.handshakes);
+                    writer.Key("resumed");    writer.UInt(handshakes.resumed);
+                    writer.Key("failed");     writer.UInt(handshakes.failed);
+                    writer.Key("kernel");     writer.UInt(handshakes.kernel);
+                    writer.EndObject();
+                }
+                if (busy_poll)
+                {
+                    writer.Key("busyPoll");
+                    writer.BeginObject(4);
+                    writer.Key("spinHits"); writer.UInt(connections.busy_poll.spin_hits);
+                    writer.Key("parks");    writer.UInt(connections.busy_poll.parks);
+                    writer.Key("spinUs");   writer.UInt(connections.busy_poll.spin_us);
+                    writer.Key("parkUs");   writer.UInt(connections.busy_poll.park_us);
+                    writer.EndObject();
+                }
+                if (cpu_stats)
+                {
+                    writer.Key("incomingCpu");
+                    writer.BeginObject(2);
+                    writer.Key("local");  writer.UInt(connections.cpu_local);
+                    writer.Key("remote"); writer.UInt(connections.cpu_remote);
+                    writer.EndObject();
+                }
+                if (zerocopy)
+                {
+                    writer.Key("zeroCopy");
+                    writer.BeginObject(3);
+                    writer.Key("threshold"); writer.UInt(listener->options.tuning.zerocopy_threshold);
+                    writer.Key("sends");     writer.UInt(connections.zerocopy_sends);
+                    writer.Key("copied");    writer.UInt(connections.zerocopy_copied);
+                    writer.EndObject();
+                }
+                writer.EndObject();
+            }
+            writer.EndArray();
+            if (m_http3_server)
+            {
+                const network::Http3Stats http3 = m_http3_server->GetStats();
+                writer.Key("http3");
+                writer.BeginObject(7);
+                writer.Key("port");              writer.Int(m_http3_server->GetPort());
+                writer.Key("accepted");          writer.UInt(http3.accepted);
+                writer.Key("established");       writer.UInt(http3.established);
+                writer.Key("active");            writer.UInt(http3.active);
+                writer.Key("requests");          writer.UInt(http3.requests);
+                writer.Key("datagramsReceived"); writer.UInt(http3.datagrams_received);
+                writer.Key("datagramsSent");     writer.UInt(http3.datagrams_sent);
+                writer.EndObject();
+            }
+            if (m_udp_ingest)
+            {
+                const network::UdpIngestStats ingest = m_udp_ingest->GetStats();
+                writer.Key("udpIngest");
+                writer.BeginObject(6);
+                writer.Key("port");         writer.Int(m_udp_ingest->GetPort());
+                writer.Key("receiveCalls"); writer.UInt(ingest.receive_calls);
+                writer.Key("datagrams");    writer.UInt(ingest.datagrams);
+                writer.Key("metrics");      writer.UInt(ingest.metrics);
+                writer.Key("malformed");    writer.UInt(ingest.malformed);
+                writer.Key("callbacks");    writer.UInt(ingest.callbacks);
+                writer.EndObject();
+            }
+            if (m_connect_proxy)
+            {
+                const network::ConnectTunnelStats tunnels = m_connect_proxy->GetStats();
+                writer.Key("connectTunnels");
+                writer.BeginObject(7);
+                writer.Key("opened");     writer.UInt(tunnels.opened);
+                writer.Key("refused");    writer.UInt(tunnels.refused);
+                writer.Key("failed");     writer.UInt(tunnels.failed);
+                writer.Key("active");     writer.UInt(tunnels.active);
+                writer.Key("idleClosed"); writer.UInt(tunnels.idle_closed);
+                writer.Key("bytesUp");    writer.UInt(tunnels.bytes_up);
+                writer.Key("bytesDown");  writer.UInt(tunnels.bytes_down);
+                writer.EndObject();
+            }
+            writer.EndObject();
             
-            response.SetJson(json.str());
+            writer.WriteTo(response);
             return response;
         });
+
+        // Reverse proxy upstream counters
+        RegisterService("api/proxy/stats", [this](const http::Request& request) -> http::Response
+        {
+            const auto routes = m_reverse_proxy->GetStats();
+
+            http::Response response;
+            auto writer = http::StructuredWriter::ForRequest(request);
+            writer.BeginObject(1);
+            writer.Key("routes");
+            writer.BeginArray(routes.size());
+            for (const auto& route : routes)
+            {
+                writer.BeginObject(4);
+                writer.Key("prefix");       writer.String(route.prefix);
+                writer.Key("hedgeDelayUs"); writer.Int(route.hedge_delay_us);
+                writer.Key("hedged");       writer.UInt(route.hedged);
+                writer.Key("upstreams");
+                writer.BeginArray(route.upstreams.size());
+                for (const auto& upstream : route.upstreams)
+                {
+                    writer.BeginObject(13);
+                    writer.Key("address");     writer.String(upstream.address);
+                    writer.Key("healthy");     writer.Bool(upstream.healthy);
+                    writer.Key("ejected");     writer.Bool(upstream.ejected);
+                    writer.Key("outstanding"); writer.Int(upstream.outstanding);
+                    writer.Key("requests");    writer.UInt(upstream.requests);
+                    writer.Key("failures");    writer.UInt(upstream.failures);
+                    writer.Key("connections"); writer.UInt(upstream.connections);
+                    writer.Key("reused");      writer.UInt(upstream.reused);
+                    writer.Key("idle");        writer.UInt(upstream.idle);
+                    writer.Key("latencyUs");   writer.Int(upstream.latency_us);
+                    writer.Key("ejections");   writer.UInt(upstream.ejections);
+                    writer.Key("hedges");      writer.UInt(upstream.hedges);
+                    writer.Key("hedgeWins");   writer.UInt(upstream.hedge_wins);
+                    writer.EndObject();
+                }
+                writer.EndArray();
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+
+            writer.WriteTo(response);
+            return response;
+        });
+
+        // Sharded in-memory key/value store (/service/kv/<key>)
+        RegisterService("kv", [store = m_kv_store](const http::Request& request) -> http::Response
+        {
+            return store->HandleRequest(request);
+        }, true);
+
+        // WebSocket echo endpoint (/ws/echo)
+        network::WebSocketHandler echo;
+        echo.on_message = [](const network::WebSocketHandler::SessionPtr& session, const network::WebSocketMessage& message)
+        {
+            if (message.binary)
+            {
+                session->SendBinary(message.data);
+            }
+            else
+            {
+                session->Send(message.data);
+            }
+        };
+        RegisterWebSocketHandler("echo", std::move(echo));
     }
 
     /**
@@ -372,7 +1298,7 @@ namespace miniserver::core
      * @param request_data Raw HTTP request string
      * @return Serialized HTTP response string
      */
-    std::string Server::HandleRequest(const std::string& request_data)
+    std::string Server::HandleRequest(const std::string& request_data, const ListenerOptions& listener)
     {
         try
         {
@@ -389,13 +1315,63 @@ namespace miniserver::core
                 return http::HttpParser::SerializeResponse(error_response);
             }
             
-            const auto& request = *request_opt;
+            auto& request = *request_opt;
+            m_request_count.fetch_add(1, std::memory_order_relaxed);
+
+            // Errors answered before routing, in the encoding the client accepts
+            const auto error_response = [&request](http::StatusCode status, const std::string& message)
+            {
+                auto writer = http::StructuredWriter::ForRequest(request);
+                writer.BeginObject(2);
+                writer.Key("error");  writer.String(message);
+                writer.Key("status"); writer.Int(static_cast<int>(status));
+                writer.EndObject();
+                http::Response response;
+                response.status = status;
+                writer.WriteTo(response);
+                return http::HttpParser::SerializeResponse(response);
+            };
+
+            // Tunnels are opened before the request reaches here (HTTP/1.x pass-through) or not at all
+            if (request.method == http::Method::CONNECT)
+            {
+                return error_response(http::StatusCode::MethodNotAllowed, "CONNECT tunneling is not enabled here");
+            }
+
+            // Paths outside this listener's subset do not exist here
+            if (!listener.Allows(request.path))
+            {
+                return error_response(http::StatusCode::NotFound, "Endpoint not found");
+            }
+
+            // Proxied prefixes on connections that did not stream through the proxy (HTTP/2)
+            if (m_reverse_proxy->HasRoutes() && m_reverse_proxy->Matches(request.path))
+            {
+                return m_reverse_proxy->Forward(request_data);
+            }
+
+            // HTTP/1.x bodies were inflated while received; HTTP/2 and HTTP/3 bodies arrive buffered
+            const http::StatusCode decode_status = http::DecodeRequestBody(request, m_decompression_limits);
+            if (decode_status != http::StatusCode::OK)
+            {
+                LOG_WARN_FMT(Server, "Rejected {} body for {}: {}",
+                    request.GetHeader("Content-Encoding"), request.path, http::StatusToString(decode_status));
+                return error_response(decode_status, http::StatusToString(decode_status));
+            }
+
             LOG_DEBUG_FMT(Server, 
                 "Processing {} request to {}",
                 http::MethodToString(request.method), request.path);
             
             // Use RequestRouter to handle the request
             http::Response response = m_request_router->RouteRequest(request);
+
+            // Generated responses use the fast level; static files were handled by the router
+            http::CompressResponse(request, response, m_compression, m_compression.dynamic_level);
+            if (listener.tls && !m_alt_svc.empty())
+            {
+                response.headers["Alt-Svc"] = m_alt_svc;
+            }
             
             // Return serialized response
             return http::HttpParser::SerializeResponse(response);
@@ -410,5 +1386,58 @@ namespace miniserver::core
         }
     }
 
+    /**
+     * @brief Move an upgraded or streaming connection onto the event loop
+     * @param client_socket Connection socket
+     * @param request_data Raw request
+     * @param response Serialized response already sent
+     * @param buffered Bytes received after the request
+     * @param client_ip Peer address
+     * @return true if a WebSocket session or event stream now owns the socket
+     */
+    bool Server::HandleHandoff(SOCKET client_socket, const std::string& request_data, const std::string& response,
+                               const std::string& buffered, const std::string& client_ip)
+    {
+        auto request = http::HttpParser::ParseRequest(request_data);
+        if (!request || !m_event_loop->IsRunning())
+        {
+            return false;
+        }
+
+        if (!network::websocket::IsUpgradeRequest(*request))
+        {
+            auto stream = m_request_router->FindEventStream(*request);
+            if (!stream)
+            {
+                return false;
+            }
+            m_event_loop->Post([stream, client_socket, client_ip]()
+            {
+                stream->AddSubscriber(client_socket, client_ip);
+            });
+            return true;
+        }
+
+        auto handler = m_request_router->FindWebSocketHandler(*request);
+        if (!handler)
+        {
+            return false;
+        }
+
+        std::optional<network::WebSocketDeflateParams> deflate;
+        if (auto extensions = http::HttpParser::FindRawHeader(response, "Sec-WebSocket-Extensions"))
+        {
+            deflate = network::websocket::ParseDeflateParams(*extensions);
+        }
+
+        auto session = std::make_shared<network::WebSocketSession>(
+            *m_event_loop, client_socket, request->path, client_ip, std::move(handler), m_websocket_options, deflate);
+        m_event_loop->Post([session, buffered]() mutable
+        {
+            session->Start(std::move(buffered));
+        });
+        return true;
+    }
+
 } // namespace core
 
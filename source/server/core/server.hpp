@@ -10,12 +10,27 @@
 
 #include "service_registry.hpp"
 #include "request_router.hpp"
+#include "kv_store.hpp"
 #include "net/socket_server.hpp"
 #include "net/http_types.hpp"
+#include "net/compression.hpp"
+#include "net/event_loop.hpp"
+#include "net/websocket.hpp"
+#include "net/event_stream.hpp"
+#include "net/reverse_proxy.hpp"
+#include "net/shm_server.hpp"
+#include "net/http3_server.hpp"
+#include "net/udp_ingest.hpp"
+#include "net/connect_tunnel.hpp"
+#include "net/socket_takeover.hpp"
+#include "net/connection_migration.hpp"
+#include "net/tls.hpp"
 
 #include <string>
+#include <string_view>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <functional>
 #include <vector>
@@ -24,6 +39,61 @@ namespace miniserver::core
 {
     using services::ServiceRegistry;
 
+    /**
+     * @brief One endpoint the server listens on and the policy for its traffic
+     *
+     * Each listener has its own accept thread and connection budget, so an
+     * admin listener keeps answering while another one is saturated.
+     */
+    struct ListenerOptions
+    {
+        std::string name;                               ///< Label in logs and stats (unique)
+        std::string host = "0.0.0.0";                   ///< TCP bind address
+        int port = 0;                                   ///< TCP port (0: none, local socket only)
+        network::LocalSocketOptions local_socket;       ///< Unix domain socket (empty path: none)
+        std::vector<std::string> allow_prefixes;        ///< Paths served here (empty: all)
+        std::vector<std::string> deny_prefixes;         ///< Paths answered with 404 here, checked first
+        network::ConnectionLimits limits;               ///< Connection cap (one thread each), timeouts, body size
+        std::shared_ptr<network::TlsContext> tls;       ///< TLS on the TCP port (nullptr: plaintext)
+        network::SocketTuning tuning;                   ///< TCP socket options, backlog and accept batch
+        network::BusyPollOptions busy_poll;             ///< Spin-then-park waits (latency over CPU)
+
+        /**
+         * @brief Check whether a request path is served on this listener
+         * @param path Request path without the query
+         * @return true if no deny prefix and (with allow prefixes set) some allow prefix matches
+         *
+         * @details Prefixes match whole segments: "/api" covers "/api" and
+         * "/api/x" but not "/apis".
+         */
+        bool Allows(std::string_view path) const;
+    };
+
+    /**
+     * @brief Traffic counters summed over every listener
+     */
+    struct ServerCounters
+    {
+        uint64_t requests = 0;              ///< Requests handled (HTTP/1.x, HTTP/2 and proxied)
+        size_t active_connections = 0;      ///< Connections served by client threads now
+        uint64_t accepted = 0;              ///< Connections accepted since Start
+        uint64_t rejected = 0;              ///< Connections turned away at a limit
+        uint64_t migrated_out = 0;          ///< Idle connections passed to another process
+        uint64_t migrated_in = 0;           ///< Connections adopted from another process
+        uint64_t cpu_local = 0;             ///< Accepted on the CPU that received them (SocketTuning::cpu_stats)
+        uint64_t cpu_remote = 0;            ///< Accepted away from the CPU that received them
+        uint64_t listen_queue = 0;          ///< Connections waiting in the TCP accept queues (last sample)
+        uint64_t listen_backlog = 0;        ///< Sum of the accept queue limits
+        uint64_t listen_overflows = 0;      ///< Host ListenOverflows (last sample)
+        uint64_t listen_drops = 0;          ///< Host ListenDrops (last sample)
+        network::FirstByteLatency first_byte; ///< Accept-to-first-byte latency over all listeners
+    };
+
+    /**
+     * @brief Offered each idle plaintext keep-alive connection; returns true if it moved the connection away
+     */
+    using ConnectionMigrator = std::function<bool(const network::MigratedConnection& connection)>;
+
     /**
      * @brief Core HTTP Server
      *
@@ -76,9 +146,10 @@ namespace miniserver::core
          * @brief Register a full HTTP service handler
          * @param name Service name
          * @param handler Handler taking full Request and returning full Response
+         * @param resource Also route GET/PUT/DELETE and sub-paths (/service/<name>/<resource>) to it
          * @return true if registered successfully
          */
-        bool RegisterService(const std::string& name, services::ServiceHandler handler);
+        bool RegisterService(const std::string& name, services::ServiceHandler handler, bool resource = false);
 
         /**
          * @brief Unregister a previously registered service
@@ -91,12 +162,238 @@ namespace miniserver::core
          * @brief Get list of registered service names
          */
         std::vector<std::string> GetRegisteredServices() const;
+
+        /**
+         * @brief Configure response compression (must be called before Start)
+         * @param options Compression options (threshold, static and dynamic levels)
+         * @return true if applied, false if the server is already running
+         */
+        bool SetCompressionOptions(const http::CompressionOptions& options);
+
+        /**
+         * @brief Configure limits for Content-Encoding compressed request bodies (must be called before Start)
+         * @param limits Maximum decompressed size and compression ratio
+         * @return true if applied, false if the server is already running
+         */
+        bool SetDecompressionLimits(const http::DecompressionLimits& limits);
+
+        /**
+         * @brief Register a WebSocket endpoint served at /ws/<name>
+         * @param name Endpoint name
+         * @param handler Session callbacks (run on the event loop thread)
+         * @return true if registered successfully
+         */
+        bool RegisterWebSocketHandler(const std::string& name, network::WebSocketHandler handler);
+
+        /**
+         * @brief Configure WebSocket limits and timers (must be called before Start)
+         * @param options WebSocket options
+         * @return true if applied, false if the server is already running
+         */
+        bool SetWebSocketOptions(const network::WebSocketOptions& options);
+
+        /**
+         * @brief Create a Server-Sent Events stream served at /events/<name> (before Start)
+         * @param name Stream name
+         * @param options Per-subscriber queue limit and heartbeat
+         * @return Stream to Broadcast() on from any thread, or nullptr on failure
+         */
+        std::shared_ptr<network::EventStream> CreateEventStream(const std::string& name,
+                                                                const network::EventStreamOptions& options = {});
+
+        /**
+         * @brief Configure the built-in /service/kv store (must be called before Start)
+         * @param options Shard count, memory cap and size limits
+         * @return true if applied, false if the server is already running
+         */
+        bool SetKvStoreOptions(const services::KvStoreOptions& options);
+
+        /**
+         * @brief Access the built-in key/value store for in-process use
+         * @return Store shared with /service/kv
+         */
+        services::KvStore& GetKvStore();
+
+        /**
+         * @brief Forward a path prefix to local upstream backends (must be called before Start)
+         * @param prefix Path prefix such as "/api"
+         * @param upstreams Backend addresses as "host:port"
+         * @param strip_prefix Remove the prefix from the forwarded path
+         * @return true if the route was added
+         */
+        bool AddProxyRoute(const std::string& prefix, const std::vector<std::string>& upstreams,
+                           bool strip_prefix = false);
+
+        /**
+         * @brief Forward a path prefix with a route policy such as hedging (must be called before Start)
+         * @param prefix Path prefix such as "/api"
+         * @param upstreams Backend addresses as "host:port"
+         * @param options Prefix stripping and hedging
+         * @return true if the route was added
+         */
+        bool AddProxyRoute(const std::string& prefix, const std::vector<std::string>& upstreams,
+                           const network::ProxyRouteOptions& options);
+
+        /**
+         * @brief Configure upstream pooling, retries and health checks (must be called before Start)
+         * @param options Reverse proxy options
+         * @return true if applied, false if the server is already running
+         */
+        bool SetProxyOptions(const network::ReverseProxyOptions& options);
+
+        /**
+         * @brief Also listen on a Unix domain socket for co-located clients (must be called before Start)
+         * @param options Socket path (or abstract name) and permissions
+         * @return true if applied, false if the server is already running
+         */
+        bool SetLocalSocket(const network::LocalSocketOptions& options);
+
+        /**
+         * @brief Listen on another endpoint with its own policy (must be called before Start)
+         * @param options Address, route subset and limits
+         * @return true if applied, false if the server is running or the options name no endpoint
+         *
+         * @details
+         * The constructor's port is the listener named "main"; adding a
+         * listener with an existing name replaces it. Every listener reaches
+         * the same services, router and proxy routes, filtered by its prefixes.
+         */
+        bool AddListener(const ListenerOptions& options);
+
+        /**
+         * @brief Restart without dropping connections: take over from, and hand over to, another process (Linux, before Start)
+         * @param options Takeover socket shared by the old and the new process
+         * @return true if applied, false if the server is already running
+         *
+         * @details
+         * Start first asks a process serving on this socket for its
+         * listening sockets and uses them for the listeners of the same
+         * name, so the ports never close. After confirming, the old process
+         * stops accepting, drains and stops; this server then waits on the
+         * socket for its own replacement.
+         */
+        bool SetTakeover(const network::LocalSocketOptions& options);
+
+        /**
+         * @brief Listen on sockets a supervising process bound (must be called before Start)
+         * @param sockets Listening sockets, matched to listeners by name and kind
+         *
+         * @details
+         * Used by prefork workers: the sockets are shared with the master and
+         * the other workers, so Stop only releases them (no shutdown, the
+         * socket file stays). Listeners without a matching socket bind as usual.
+         */
+        void SetInheritedListeners(std::vector<network::InheritedListener> sockets);
+
+        /**
+         * @brief Configured listeners ("main" first)
+         */
+        std::vector<ListenerOptions> GetListenerOptions() const;
+
+        /**
+         * @brief Snapshot of the traffic counters
+         */
+        ServerCounters GetCounters() const;
+
+        /**
+         * @brief Longest wait for open connections when stopping or after a takeover
+         * @param timeout Drain deadline (connections still open then are closed)
+         */
+        void SetDrainTimeout(std::chrono::milliseconds timeout);
+
+        /**
+         * @brief Serve registered services over shared-memory rings (Linux, must be called before Start)
+         * @param options Handshake socket and ring settings
+         * @return true if applied, false if the server is already running
+         */
+        bool SetShmTransport(const network::ShmServerOptions& options);
+
+        /**
+         * @brief Also serve HTTP/3 on a UDP port (must be called before Start)
+         * @param options UDP port, certificate and QUIC limits
+         * @return true if applied, false if the server is already running
+         *
+         * @details
+         * Requests are answered by the same handler as the "main" listener.
+         * Responses on TLS listeners carry an Alt-Svc header naming the
+         * port, which is how clients discover HTTP/3.
+         */
+        bool SetHttp3(const network::Http3ServerOptions& options);
+
+        /**
+         * @brief Also ingest statsd-style telemetry on a UDP port (must be called before Start)
+         * @param options UDP port and batch size
+         * @param handler Receives each batch of parsed lines on the ingest thread (empty: count only)
+         * @return true if applied, false if the server is already running
+         */
+        bool SetUdpIngest(const network::UdpIngestOptions& options, network::IngestHandler handler);
+
+        /**
+         * @brief Open CONNECT tunnels to allowed local targets (must be called before Start)
+         * @param options Allowed hosts and ports, connect and idle timeouts
+         * @return true if applied, false if the server is already running
+         *
+         * @details Tunnels are relayed with splice() on the event loop.
+         * Listeners restricted to a path subset (admin) answer CONNECT 405.
+         */
+        bool SetConnectTunnel(const network::ConnectTunnelOptions& options);
+
+        /**
+         * @brief Let another process take idle keep-alive connections (must be called before Start)
+         * @param migrator Decides per connection and passes it on
+         *
+         * @details Used by prefork workers to even out load. TLS listeners
+         * keep their connections.
+         */
+        void SetConnectionMigrator(ConnectionMigrator migrator);
+
+        /**
+         * @brief Serve a connection migrated from another process
+         * @param connection Socket (ownership passes to the server), listener name and buffered bytes
+         * @return false if no running listener has that name (the socket is closed)
+         */
+        bool AdoptConnection(network::MigratedConnection connection);
     private:
 
         /**
-         * @brief Server main loop
+         * @brief Bound endpoint and the thread accepting on it
+         */
+        struct Listener
+        {
+            ListenerOptions options;                                    ///< Address and policy
+            std::unique_ptr<network::SocketServer> socket_server;       ///< Listening sockets and client threads
+            std::thread thread;                                         ///< Runs the accept loop
+            bool shared = false;                                        ///< Sockets owned by a supervising process
+        };
+
+        /**
+         * @brief Bind a listener and install its handlers
+         * @param listener Listener to bind
+         * @param takeover Sockets received from the process being replaced (may be null)
+         * @return true if listening
+         */
+        bool BindListener(Listener& listener, network::TakeoverClient* takeover);
+
+        /**
+         * @brief Let every listener's open connections finish, sharing one deadline
+         */
+        void DrainListeners();
+
+        /**
+         * @brief Stop accepting after a replacement took the listening sockets, drain and stop
+         */
+        void CompleteTakeover();
+
+        /**
+         * @brief Accept loop of one listener
+         * @param listener Bound listener
+         */
+        void RunListener(Listener& listener);
+
+        /**
+         * @brief Sample every listener's accept queue and the host's listen drops, then re-arm (loop thread)
          */
-        void RunServer();
+        void SampleListeners();
 
         /**
          * @brief Register built-in internal HTTP services used by the server
@@ -107,9 +404,22 @@ namespace miniserver::core
         /**
          * @brief Handle raw request string
          * @param raw_request Raw HTTP request string
+         * @param listener Policy of the listener the request arrived on
          * @return HTTP response string
          */
-        std::string HandleRequest(const std::string& raw_request);
+        std::string HandleRequest(const std::string& raw_request, const ListenerOptions& listener);
+
+        /**
+         * @brief Move an upgraded or streaming connection onto the event loop
+         * @param client_socket Connection socket
+         * @param request_data Raw request
+         * @param response Serialized response already sent
+         * @param buffered Bytes received after the request
+         * @param client_ip Peer address
+         * @return true if a WebSocket session or event stream now owns the socket
+         */
+        bool HandleHandoff(SOCKET client_socket, const std::string& request_data, const std::string& response,
+                           const std::string& buffered, const std::string& client_ip);
 
         /**
          * @brief Get current timestamp in ISO 8601 format
@@ -125,11 +435,33 @@ namespace miniserver::core
         std::string FormatUptime(long seconds);
 
         int m_port;                                                        ///< Server port
-        std::atomic<bool> m_running;                                       ///< Running state flag
-        std::thread m_server_thread;                                       ///< Server thread
+        std::atomic<bool> m_running{false};                                ///< Running state flag
         std::unique_ptr<ServiceRegistry> m_service_registry;               ///< Service registry (singleton)
         std::unique_ptr<RequestRouter> m_request_router;                   ///< Request router
-        std::unique_ptr<network::SocketServer> m_socket_server;            ///< Network socket server
+        std::vector<std::unique_ptr<Listener>> m_listeners;                ///< Endpoints ("main" first)
+        http::CompressionOptions m_compression;                            ///< Response compression settings
+        http::DecompressionLimits m_decompression_limits;                  ///< Request body decompression limits
+        std::unique_ptr<network::EventLoop> m_event_loop;                  ///< Loop serving upgraded connections
+        network::WebSocketOptions m_websocket_options;                     ///< WebSocket limits and timers
+        std::shared_ptr<services::KvStore> m_kv_store;                     ///< Built-in key/value store
+        std::unique_ptr<network::ReverseProxy> m_reverse_proxy;            ///< Upstream routes
+        std::unique_ptr<network::ConnectProxy> m_connect_proxy;            ///< CONNECT tunnels (null: answered 405)
+        network::ShmServerOptions m_shm_options;                           ///< Shared-memory transport (empty path: none)
+        std::unique_ptr<network::ShmServer> m_shm_server;                  ///< Shared-memory transport
+        network::Http3ServerOptions m_http3_options;                       ///< HTTP/3 listener (port 0: none)
+        std::unique_ptr<network::Http3Server> m_http3_server;              ///< HTTP/3 listener
+        network::UdpIngestOptions m_udp_ingest_options;                    ///< Telemetry listener (port 0: none)
+        network::IngestHandler m_udp_ingest_handler;                       ///< Telemetry consumer
+        std::unique_ptr<network::UdpIngestServer> m_udp_ingest;            ///< Telemetry listener
+        std::string m_alt_svc;                                             ///< Alt-Svc value for TLS responses (empty: none)
+        network::LocalSocketOptions m_takeover_socket;                     ///< Restart handoff socket (empty path: none)
+        std::unique_ptr<network::TakeoverServer> m_takeover_server;        ///< Waits for a replacement process
+        std::chrono::milliseconds m_drain_timeout{10000};                  ///< Drain deadline on stop and takeover
+        std::vector<network::InheritedListener> m_inherited_listeners;     ///< Sockets from a supervising process
+        ConnectionMigrator m_connection_migrator;                          ///< Moves idle connections to a sibling process
+        std::atomic<uint64_t> m_request_count{0};                          ///< Requests handled
+        std::atomic<uint64_t> m_listen_overflows{0};                       ///< Host ListenOverflows at the last sample
+        std::atomic<uint64_t> m_listen_drops{0};                           ///< Host ListenDrops at the last sample
     };
 
 
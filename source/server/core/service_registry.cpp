@@ -8,6 +8,7 @@
 
 #include "service_registry.hpp"
 #include "utils/logger.hpp"
+#include "net/body_encoding.hpp"
 
 #include <algorithm>
 
@@ -111,11 +112,84 @@ namespace miniserver::services
         return m_services.find(name) != m_services.end();
     }
 
+    bool ServiceRegistry::IsResourceService(const std::string& name) const
+    {
+        if (name.empty())
+        {
+            return false;
+        }
+        std::shared_lock<std::shared_mutex> lock(m_servicesMutex);
+        auto it = m_services.find(name);
+        return it != m_services.end() && it->second.resource;
+    }
+
+    bool ServiceRegistry::RegisterWebSocketHandler(const std::string& name, network::WebSocketHandler handler)
+    {
+        if (name.empty())
+        {
+            return false;
+        }
+        std::lock_guard<std::shared_mutex> lock(m_servicesMutex);
+        if (m_websocketHandlers.find(name) != m_websocketHandlers.end())
+        {
+            LOG_WARN("ServiceRegistry", "WebSocket endpoint already exists: " + name);
+            return false;
+        }
+        m_websocketHandlers[name] = std::make_shared<const network::WebSocketHandler>(std::move(handler));
+        LOG_INFO("ServiceRegistry", "Registered WebSocket endpoint: /ws/" + name);
+        return true;
+    }
+
+    bool ServiceRegistry::UnregisterWebSocketHandler(const std::string& name)
+    {
+        std::lock_guard<std::shared_mutex> lock(m_servicesMutex);
+        if (m_websocketHandlers.erase(name) == 0)
+        {
+            LOG_WARN("ServiceRegistry", "Failed to unregister non-existent WebSocket endpoint: " + name);
+            return false;
+        }
+        LOG_INFO("ServiceRegistry", "Unregistered WebSocket endpoint: " + name);
+        return true;
+    }
+
+    std::shared_ptr<const network::WebSocketHandler> ServiceRegistry::GetWebSocketHandler(const std::string& name) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_servicesMutex);
+        auto it = m_websocketHandlers.find(name);
+        return it != m_websocketHandlers.end() ? it->second : nullptr;
+    }
+
+    bool ServiceRegistry::RegisterEventStream(const std::string& name, std::shared_ptr<network::EventStream> stream)
+    {
+        if (name.empty() || !stream)
+        {
+            return false;
+        }
+        std::lock_guard<std::shared_mutex> lock(m_servicesMutex);
+        if (m_eventStreams.find(name) != m_eventStreams.end())
+        {
+            LOG_WARN("ServiceRegistry", "Event stream already exists: " + name);
+            return false;
+        }
+        m_eventStreams[name] = std::move(stream);
+        LOG_INFO("ServiceRegistry", "Registered event stream: /events/" + name);
+        return true;
+    }
+
+    std::shared_ptr<network::EventStream> ServiceRegistry::GetEventStream(const std::string& name) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_servicesMutex);
+        auto it = m_eventStreams.find(name);
+        return it != m_eventStreams.end() ? it->second : nullptr;
+    }
+
     void ServiceRegistry::ClearServices()
     {
         std::lock_guard<std::shared_mutex> lock(m_servicesMutex);
         auto count = m_services.size();
         m_services.clear();
+        m_websocketHandlers.clear();
+        m_eventStreams.clear();
         LOG_INFO("ServiceRegistry", "Cleared " + std::to_string(count) + " services");
     }
 
@@ -127,13 +201,13 @@ namespace miniserver::services
         if (!service_opt)
         {
             LOG_WARN("ServiceRegistry", "Requested non-existent service: " + serviceName);
-            return CreateErrorResponse(http::StatusCode::NotFound, "Service not found: " + serviceName);
+            return CreateErrorResponse(request, http::StatusCode::NotFound, "Service not found: " + serviceName);
         }
         const auto& service = *service_opt;
         if (!service.enabled)
         {
             LOG_WARN("ServiceRegistry", "Requested disabled service: " + serviceName);
-            return CreateErrorResponse(http::StatusCode::InternalServerError, "Service disabled: " + serviceName);
+            return CreateErrorResponse(request, http::StatusCode::InternalServerError, "Service disabled: " + serviceName);
         }
         try
         {
@@ -143,37 +217,36 @@ namespace miniserver::services
         catch (const std::exception& e)
         {
             LOG_ERROR("ServiceRegistry", "Exception in service '" + serviceName + "': " + e.what());
-            return CreateErrorResponse(http::StatusCode::InternalServerError, "Internal service error");
+            return CreateErrorResponse(request, http::StatusCode::InternalServerError, "Internal service error");
         }
     }
 
-    http::Response ServiceRegistry::GetServicesInfo() const
+    http::Response ServiceRegistry::GetServicesInfo(const http::Request& request) const
     {
-    std::shared_lock<std::shared_mutex> lock(m_servicesMutex);
-        std::string json = "{\n  \"services\": [\n";
-        bool first = true;
-    for (const auto& [name, info] : m_services)
+        auto writer = http::StructuredWriter::ForRequest(request);
         {
-            if (!first)
+            std::shared_lock<std::shared_mutex> lock(m_servicesMutex);
+            writer.BeginObject(2);
+            writer.Key("services");
+            writer.BeginArray(m_services.size());
+            for (const auto& [name, info] : m_services)
             {
-                json += ",\n";
+                writer.BeginObject(4);
+                writer.Key("name");        writer.String(name);
+                writer.Key("description"); writer.String(info.description);
+                writer.Key("version");     writer.String(info.version);
+                writer.Key("enabled");     writer.Bool(info.enabled);
+                writer.EndObject();
             }
-            first = false;
-            json += "    {\n";
-            json += "      \"name\": \"" + name + "\",\n";
-            json += "      \"description\": \"" + info.description + "\",\n";
-            json += "      \"version\": \"" + info.version + "\",\n";
-            json += "      \"enabled\": " + std::string(info.enabled ? "true" : "false") + "\n";
-            json += "    }";
-        }
-        json += "\n  ],\n";
-        json += "  \"total\": " + std::to_string(m_services.size()) + "\n";
-        json += "}";
+            writer.EndArray();
+            writer.Key("total");
+            writer.UInt(m_services.size());
+            writer.EndObject();
+        }
         http::Response resp;
         resp.status = http::StatusCode::OK;
-        resp.headers["Content-Type"] = "application/json";
         resp.headers["Cache-Control"] = "no-cache";
-        resp.body = json;
+        writer.WriteTo(resp);
         return resp;
     }
 
@@ -214,13 +287,18 @@ namespace miniserver::services
     }
 
     http::Response ServiceRegistry::CreateErrorResponse(
+        const http::Request& request,
         http::StatusCode status,
         const std::string& message)
     {
+        auto writer = http::StructuredWriter::ForRequest(request);
+        writer.BeginObject(1);
+        writer.Key("error");
+        writer.String(message);
+        writer.EndObject();
         http::Response resp;
         resp.status = status;
-        resp.headers["Content-Type"] = "application/json";
-        resp.body = "{\"error\": \"" + message + "\"}";
+        writer.WriteTo(resp);
         return resp;
     }
 
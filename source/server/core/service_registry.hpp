@@ -9,10 +9,13 @@
 #pragma once
 
 #include "../net/http_types.hpp"
+#include "../net/websocket.hpp"
+#include "../net/event_stream.hpp"
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <functional>
+#include <memory>
 #include <shared_mutex>
 #include <optional>
 
@@ -33,6 +36,7 @@ namespace miniserver::services
         std::string version;        ///< Service version
         ServiceHandler handler;     ///< Service handler function
         bool enabled = true;        ///< Whether service is enabled
+        bool resource = false;      ///< Also serves any method on /service/<name>/<resource>
         ServiceInfo() = default;
         ServiceInfo(const std::string& desc,
                    const std::string& ver,
@@ -94,6 +98,12 @@ namespace miniserver::services
          * @return true if service exists
          */
         bool HasService(const std::string& name) const;
+        /**
+         * @brief Check if service accepts resource-style requests (any method, sub-paths)
+         * @param name Service name
+         * @return true if service exists and was registered as a resource service
+         */
+        bool IsResourceService(const std::string& name) const;
         /**
          * @brief Clear all services
          */
@@ -107,10 +117,11 @@ namespace miniserver::services
         http::Response HandleServiceRequest(const http::Request& request,
                                            const std::string& serviceName);
         /**
-         * @brief Get all services information (JSON format)
+         * @brief Get all services information
+         * @param request HTTP request (its Accept header selects JSON, CBOR or MessagePack)
          * @return HTTP response containing all services information
          */
-        http::Response GetServicesInfo() const;
+        http::Response GetServicesInfo(const http::Request& request) const;
         /**
          * @brief Enable service
          * @param name Service name
@@ -123,18 +134,54 @@ namespace miniserver::services
          * @return true if successful
          */
         bool DisableService(const std::string& name);
+        /**
+         * @brief Register WebSocket endpoint (served at /ws/<name>)
+         * @param name Endpoint name (must be unique)
+         * @param handler Session callbacks
+         * @return true if registration successful
+         */
+        bool RegisterWebSocketHandler(const std::string& name, network::WebSocketHandler handler);
+        /**
+         * @brief Unregister WebSocket endpoint
+         * @param name Endpoint name
+         * @return true if unregistration successful
+         */
+        bool UnregisterWebSocketHandler(const std::string& name);
+        /**
+         * @brief Get WebSocket endpoint callbacks
+         * @param name Endpoint name
+         * @return Shared handler (kept alive by open sessions), or nullptr if not found
+         */
+        std::shared_ptr<const network::WebSocketHandler> GetWebSocketHandler(const std::string& name) const;
+        /**
+         * @brief Register Server-Sent Events stream (served at /events/<name>)
+         * @param name Stream name (must be unique)
+         * @param stream Broadcast channel
+         * @return true if registration successful
+         */
+        bool RegisterEventStream(const std::string& name, std::shared_ptr<network::EventStream> stream);
+        /**
+         * @brief Get Server-Sent Events stream
+         * @param name Stream name
+         * @return Stream, or nullptr if not found
+         */
+        std::shared_ptr<network::EventStream> GetEventStream(const std::string& name) const;
     private:
         /**
          * @brief Create error response
+         * @param request HTTP request (its Accept header selects the encoding)
          * @param status HTTP status code
          * @param message Error message
          * @return HTTP error response
          */
-        static http::Response CreateErrorResponse(http::StatusCode status,
+        static http::Response CreateErrorResponse(const http::Request& request,
+                                                  http::StatusCode status,
                                                   const std::string& message);
     private:
     mutable std::shared_mutex m_servicesMutex;                     ///< Read-write lock protecting service map
     std::unordered_map<std::string, ServiceInfo> m_services;       ///< Service map
+    std::unordered_map<std::string, std::shared_ptr<const network::WebSocketHandler>> m_websocketHandlers; ///< WebSocket endpoints
+    std::unordered_map<std::string, std::shared_ptr<network::EventStream>> m_eventStreams; ///< Server-Sent Events streams
     };
 } // namespace miniserver::services
 
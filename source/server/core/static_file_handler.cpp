@@ -97,6 +97,9 @@ http::Response StaticFileHandler::HandleRequest(const http::Request& request)
         
         // Add CORS headers for API access
         response.AddCorsHeaders();
+
+        // Static assets are worth a stronger level than generated responses
+        http::CompressResponse(request, response, m_compression, m_compression.static_level);
         
         LOG_DEBUG_FMT("StaticFileHandler", "Served file: {} ({})", path, mime_type);
         
@@ -117,6 +120,11 @@ void StaticFileHandler::SetRootDirectory(const std::string& root_directory)
     LOG_INFO_FMT("StaticFileHandler", "Root directory changed to: {}", m_root_directory);
 }
 
+void StaticFileHandler::SetCompressionOptions(const http::CompressionOptions& options)
+{
+    m_compression = options;
+}
+
 std::string StaticFileHandler::GetMimeType(const std::string& extension) const
 {
     auto it = m_mime_types.find(extension);
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "net/http_types.hpp"
+#include "net/compression.hpp"
 #include <string>
 #include <unordered_map>
 
@@ -38,6 +39,12 @@ namespace miniserver::core
          */
         void SetRootDirectory(const std::string& root_directory);
 
+        /**
+         * @brief Set compression settings for served files (static_level is applied)
+         * @param options Compression options
+         */
+        void SetCompressionOptions(const http::CompressionOptions& options);
+
     private:
         /**
          * @brief Get MIME type for file extension
@@ -63,6 +70,7 @@ namespace miniserver::core
     private:
         std::string m_root_directory;                           ///< Root directory for static files
         std::unordered_map<std::string, std::string> m_mime_types; ///< MIME type mapping
+        http::CompressionOptions m_compression;                 ///< Compression settings
     };
 
 } // namespace miniserver::core
@@ -5,7 +5,11 @@
  * @version 1.0.0
  */
 
+#include "core/prefork.hpp"
 #include "core/server.hpp"
+#include "net/body_encoding.hpp"
+#include "net/socket_activation.hpp"
+#include "net/tls.hpp"
 #include "utils/logger.hpp"
 
 #include <iostream>
@@ -14,25 +18,46 @@
 #include <thread>
 #include <chrono>
 #include <algorithm>
+#include <cstdlib>
 #include <filesystem>
+#include <string>
+#include <vector>
 
 using namespace miniserver;
 
 // Global server instance pointer
 std::unique_ptr<core::Server> g_server;
 
+// Set by the signal handler; the main loop stops the server (draining connections)
+volatile sig_atomic_t g_stop_signal = 0;
+
 /**
  * @brief Signal handler for graceful shutdown
  * @param signal Signal value
  */
 void SignalHandler(int signal)
 {
-    LOG_INFO_FMT("Main", "Received signal {} , shutting down...", signal);
-    if (g_server)
-    {
-        g_server->Stop();
-    }
-    exit(0);
+    g_stop_signal = signal;
+}
+
+/**
+ * @brief Build a text service's reply in the encoding negotiated from the Accept header
+ * @param request Service request (its body is the input)
+ * @param service Service name
+ * @param output Transformed input
+ * @return 200 response
+ */
+http::Response TextServiceResponse(const http::Request& request, const std::string& service, const std::string& output)
+{
+    auto writer = http::StructuredWriter::ForRequest(request);
+    writer.BeginObject(3);
+    writer.Key("service"); writer.String(service);
+    writer.Key("input");   writer.String(request.body);
+    writer.Key("output");  writer.String(output);
+    writer.EndObject();
+    http::Response response;
+    writer.WriteTo(response);
+    return response;
 }
 
 /**
@@ -44,34 +69,42 @@ void RegisterExampleServices(core::Server& server)
     LOG_INFO("Main", "Registering example services");
 
     // Echo service: returns input as output
-    server.RegisterService("echo", [](const std::string& body) -> std::string 
+    server.RegisterService("echo", [](const http::Request& request)
     {
-        return R"({"service":"echo","input":")" + body + R"(","output":")" + body + R"("})";
+        return TextServiceResponse(request, "echo", request.body);
     });
 
     // Upper service: converts input to uppercase
-    server.RegisterService("upper", [](const std::string& body) -> std::string 
+    server.RegisterService("upper", [](const http::Request& request)
     {
-        std::string upper_body = body;
+        std::string upper_body = request.body;
         std::transform(upper_body.begin(), upper_body.end(), upper_body.begin(), [](unsigned char c)
         {
             return static_cast<char>(std::toupper(c));
         });
-
-        return R"({"service":"upper","input":")" + body + R"(","output":")" + upper_body + R"("})";
+        return TextServiceResponse(request, "upper", upper_body);
     });
+
     // Reverse service: reverses input string
-    server.RegisterService("reverse", [](const std::string& body) -> std::string 
+    server.RegisterService("reverse", [](const http::Request& request)
     {
-        std::string reversed_body = body;
+        std::string reversed_body = request.body;
         std::reverse(reversed_body.begin(), reversed_body.end());
-        return R"({"service":"reverse","input":")" + body + R"(","output":")" + reversed_body + R"("})";
+        return TextServiceResponse(request, "reverse", reversed_body);
     });
 
     // Length service: returns length of input string
-    server.RegisterService("length", [](const std::string& body) -> std::string 
+    server.RegisterService("length", [](const http::Request& request)
     {
-        return R"({"service":"length","input":")" + body + R"(","length":)" + std::to_string(body.length()) + R"(})";
+        auto writer = http::StructuredWriter::ForRequest(request);
+        writer.BeginObject(3);
+        writer.Key("service"); writer.String("length");
+        writer.Key("input");   writer.String(request.body);
+        writer.Key("length");  writer.UInt(request.body.length());
+        writer.EndObject();
+        http::Response response;
+        writer.WriteTo(response);
+        return response;
     });
 
     LOG_INFO("Main", "Example services registered: echo, upper, reverse, length");
@@ -88,6 +121,11 @@ void PrintUsage()
     std::cout << "  GET  /ping              - Health check" << std::endl;
     std::cout << "  GET  /services          - List registered services" << std::endl;
     std::cout << "  POST /service/<name>    - Call a specific service" << std::endl;
+    std::cout << "  GET|PUT|DELETE /service/kv/<key> - Built-in key/value cache" << std::endl;
+    std::cout << "  GET  /ws/echo           - WebSocket echo" << std::endl;
+    std::cout << "  GET  /events/clock      - Server-Sent Events ticker" << std::endl;
+    std::cout << "  GET  /api/proxy/stats   - Route and upstream counters (with --proxy)" << std::endl;
+    std::cout << "  GET  /metrics           - Per-worker counters, Prometheus format (with --workers)" << std::endl;
     std::cout << "  OPTIONS /*              - CORS preflight" << std::endl;
     std::cout << "\nExample services:" << std::endl;
     std::cout << "  POST /service/echo      - Echo input back" << std::endl;
@@ -101,6 +139,79 @@ void PrintUsage()
     std::cout << "\nPress Ctrl+C to stop the server" << std::endl;
 }
 
+/**
+ * @brief Parse a --tcp socket profile
+ * @param spec Comma-separated options, e.g. "nodelay,quickack,defer-accept=1,fastopen=256,backlog=4096"
+ * @param tuning Receives the options
+ * @return false on an unknown option or a bad value
+ */
+bool ParseSocketTuning(const std::string& spec, network::SocketTuning& tuning)
+{
+    for (size_t start = 0; start <= spec.size();)
+    {
+        const size_t comma = std::min(spec.find(',', start), spec.size());
+        const std::string option = spec.substr(start, comma - start);
+        start = comma + 1;
+
+        const size_t equals = option.find('=');
+        const std::string name = option.substr(0, equals);
+        int value = 0;
+        if (equals != std::string::npos)
+        {
+            char* end = nullptr;
+            const long parsed = std::strtol(option.c_str() + equals + 1, &end, 10);
+            if (*end != '\0' || end == option.c_str() + equals + 1 || parsed < 0 || parsed > (1 << 30))
+            {
+                return false;
+            }
+            value = static_cast<int>(parsed);
+        }
+
+        if (name == "nodelay" && equals == std::string::npos) tuning.no_delay = true;
+        else if (name == "quickack" && equals == std::string::npos) tuning.quick_ack = true;
+        else if (name == "defer-accept") tuning.defer_accept_seconds = equals == std::string::npos ? 1 : value;
+        else if (name == "fastopen") tuning.fastopen_queue = equals == std::string::npos ? 256 : value;
+        else if (name == "rcvbuf" && value > 0) tuning.receive_buffer = value;
+        else if (name == "sndbuf" && value > 0) tuning.send_buffer = value;
+        else if (name == "backlog" && value > 0) tuning.backlog = value;
+        else if (name == "accept-batch" && value > 0) tuning.accept_batch = static_cast<size_t>(value);
+        else if (name == "cpu-stats" && equals == std::string::npos) tuning.cpu_stats = true;
+        else if (name == "zerocopy") tuning.zerocopy_threshold = equals == std::string::npos ? 32 * 1024 : static_cast<size_t>(value);
+        else return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse the --connect target ports
+ * @param spec "any", or comma-separated ports, e.g. "22,5432"
+ * @param ports Receives the ports (empty for "any")
+ * @return false on a bad port
+ */
+bool ParseConnectPorts(const std::string& spec, std::vector<int>& ports)
+{
+    ports.clear();
+    if (spec == "any")
+    {
+        return true;
+    }
+    for (size_t start = 0; start <= spec.size();)
+    {
+        const size_t comma = std::min(spec.find(',', start), spec.size());
+        const std::string port = spec.substr(start, comma - start);
+        start = comma + 1;
+
+        char* end = nullptr;
+        const long parsed = std::strtol(port.c_str(), &end, 10);
+        if (*end != '\0' || port.empty() || parsed <= 0 || parsed > 65535)
+        {
+            return false;
+        }
+        ports.push_back(static_cast<int>(parsed));
+    }
+    return true;
+}
+
 /**
  * @brief Main entry point
  * @param argc Argument count
@@ -113,11 +224,209 @@ int Main(int argc, char* argv[])
     {
         utils::Logger::GetInstance().SetLogLevel(utils::LogLevel::Info);
         int port = 8080;
-        if (argc > 1)
+        std::vector<std::string> proxy_routes;
+        network::ProxyRouteOptions route_options;
+        network::LocalSocketOptions local_socket;
+        network::ShmServerOptions shm_transport;
+        int http3_port = 0;
+        int udp_ingest_port = 0;
+        network::ConnectTunnelOptions connect_tunnel;
+        int admin_port = 0;
+        size_t max_connections = 0;
+        network::SocketTuning tuning;
+        network::BusyPollOptions busy_poll;
+        bool tuned = false;
+        network::LocalSocketOptions takeover_socket;
+        int drain_seconds = -1;
+        core::PreforkOptions prefork;
+        std::vector<std::pair<int, std::string>> inherited_fds;
+        network::TlsOptions tls_options;
+        for (int i = 1; i < argc; ++i)
         {
+            const std::string argument = argv[i];
+            if (argument == "--proxy" && i + 1 < argc)
+            {
+                proxy_routes.push_back(argv[++i]);
+                continue;
+            }
+            if (argument == "--unix" && i + 1 < argc)
+            {
+                // A leading '@' selects the abstract namespace (no socket file)
+                local_socket.path = argv[++i];
+                local_socket.abstract = local_socket.path.size() > 1 && local_socket.path.front() == '@';
+                if (local_socket.abstract)
+                {
+                    local_socket.path.erase(0, 1);
+                }
+                continue;
+            }
+            if (argument == "--shm" && i + 1 < argc)
+            {
+                // Handshake socket for shared-memory service calls ('@' prefix: abstract namespace)
+                shm_transport.socket.path = argv[++i];
+                shm_transport.socket.abstract = shm_transport.socket.path.size() > 1 && shm_transport.socket.path.front() == '@';
+                if (shm_transport.socket.abstract)
+                {
+                    shm_transport.socket.path.erase(0, 1);
+                }
+                continue;
+            }
+            if (argument == "--hedge" && i + 1 < argc)
+            {
+                // Latency percentile after which idempotent proxied requests are duplicated, e.g. 95
+                route_options.hedge_percentile = std::atof(argv[++i]);
+                continue;
+            }
+            if (argument == "--admin" && i + 1 < argc)
+            {
+                // Loopback port serving the admin endpoints, which then leave the main port
+                admin_port = std::atoi(argv[++i]);
+                continue;
+            }
+            if (argument == "--max-connections" && i + 1 < argc)
+            {
+                // Connection (and thread) cap of the main port; extra connections get 503
+                max_connections = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+                continue;
+            }
+            if (argument == "--tcp" && i + 1 < argc)
+            {
+                // Socket profile of the main port: nodelay, quickack, defer-accept[=s], fastopen[=n], rcvbuf=, sndbuf=, backlog=, accept-batch=
+                const std::string spec = argv[++i];
+                if (!ParseSocketTuning(spec, tuning))
+                {
+                    std::cerr << "Invalid --tcp options: " << spec << "\n";
+                    return 1;
+                }
+                tuned = true;
+                continue;
+            }
+            if (argument == "--busy-poll" && i + 1 < argc)
+            {
+                // Main port spins up to this many microseconds before blocking (dedicated cores)
+                const int spin_us = std::atoi(argv[++i]);
+                if (spin_us <= 0)
+                {
+                    std::cerr << "Invalid --busy-poll spin time: " << argv[i] << "\n";
+                    return 1;
+                }
+                busy_poll.enabled = true;
+                busy_poll.max_spin = std::chrono::microseconds(spin_us);
+                busy_poll.socket_busy_poll_us = spin_us;
+                continue;
+            }
+            if (argument == "--takeover" && i + 1 < argc)
+            {
+                // Restart handoff: a new process started with the same socket takes over the ports
+                takeover_socket.path = argv[++i];
+                takeover_socket.abstract = takeover_socket.path.size() > 1 && takeover_socket.path.front() == '@';
+                if (takeover_socket.abstract)
+                {
+                    takeover_socket.path.erase(0, 1);
+                }
+                continue;
+            }
+            if (argument == "--drain" && i + 1 < argc)
+            {
+                // Seconds open connections get to finish when stopping or handing over
+                drain_seconds = std::max(0, std::atoi(argv[++i]));
+                continue;
+            }
+            if (argument == "--workers" && i + 1 < argc)
+            {
+                // Prefork: a master process binds the ports and supervises this many workers
+                prefork.workers = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+                continue;
+            }
+            if (argument == "--fd" && i + 1 < argc)
+            {
+                // Pre-bound listening socket from the launcher: --fd 3 serves "main", --fd 4=admin the admin port
+                const std::string value = argv[++i];
+                const size_t equals = value.find('=');
+                inherited_fds.emplace_back(std::atoi(value.substr(0, equals).c_str()),
+                                           equals == std::string::npos ? "main" : value.substr(equals + 1));
+                continue;
+            }
+            if (argument == "--tls-cert" && i + 1 < argc)
+            {
+                // TLS on the main TCP port; the key may sit in the same PEM file
+                tls_options.certificate_file = argv[++i];
+                continue;
+            }
+            if (argument == "--tls-key" && i + 1 < argc)
+            {
+                tls_options.key_file = argv[++i];
+                continue;
+            }
+            if (argument == "--http3" && i + 1 < argc)
+            {
+                // HTTP/3 on this UDP port with the --tls-cert certificate
+                http3_port = std::atoi(argv[++i]);
+                continue;
+            }
+            if (argument == "--udp-ingest" && i + 1 < argc)
+            {
+                // statsd-style telemetry on this UDP port, parsed and counted in batches
+                udp_ingest_port = std::atoi(argv[++i]);
+                if (udp_ingest_port <= 0 || udp_ingest_port > 65535)
+                {
+                    std::cerr << "Invalid --udp-ingest port: " << argv[i] << "\n";
+                    return 1;
+                }
+                continue;
+            }
+            if (argument == "--connect" && i + 1 < argc)
+            {
+                // CONNECT tunnels to these loopback ports ("any" for every port)
+                if (!ParseConnectPorts(argv[++i], connect_tunnel.allowed_ports))
+                {
+                    std::cerr << "Invalid --connect ports: " << argv[i] << "\n";
+                    return 1;
+                }
+                connect_tunnel.enabled = true;
+                continue;
+            }
+            if (argument == "--connect-idle" && i + 1 < argc)
+            {
+                // Seconds a tunnel may stay silent in both directions before it is closed
+                const int seconds = std::atoi(argv[++i]);
+                if (seconds <= 0)
+                {
+                    std::cerr << "Invalid --connect-idle timeout: " << argv[i] << "\n";
+                    return 1;
+                }
+                connect_tunnel.idle_timeout = std::chrono::seconds(seconds);
+                continue;
+            }
+            if (argument == "--no-session-tickets")
+            {
+                // Resume TLS sessions through the server-side cache only
+                tls_options.session_tickets = false;
+                continue;
+            }
+            if (argument == "--reuse-port")
+            {
+                // Prefork workers get one SO_REUSEPORT socket each instead of sharing one
+                prefork.reuse_port = true;
+                continue;
+            }
+            if (argument == "--steer-cpu")
+            {
+                // Each SO_REUSEPORT worker pinned to a CPU takes the connections that CPU received
+                prefork.steer_cpu = true;
+                tuning.cpu_stats = true;
+                tuned = true;
+                continue;
+            }
+            if (argument == "--rebalance")
+            {
+                // Busy prefork workers hand idle keep-alive connections to quiet ones
+                prefork.rebalance = true;
+                continue;
+            }
             try
             {
-                port = std::stoi(argv[1]);
+                port = std::stoi(argument);
                 if (port <= 0 || port > 65535)
                 {
                     throw std::out_of_range("Port out of range");
@@ -125,8 +434,8 @@ int Main(int argc, char* argv[])
             }
             catch (const std::exception& e)
             {
-                std::cerr << "Invalid port number: " << argv[1] << "\n";
-                std::cerr << "Usage: " << argv[0] << " [port]" << "\n";
+                std::cerr << "Invalid port number: " << argument << "\n";
+                std::cerr << "Usage: " << argv[0] << " [port] [--proxy /prefix=host:port[,host:port...]]... [--hedge <percentile>] [--unix <path|@name>] [--shm <path|@name>] [--admin <port>] [--max-connections <n>] [--tcp <option,...>] [--busy-poll <us>] [--takeover <path|@name>] [--drain <seconds>] [--workers <n> [--reuse-port [--steer-cpu]] [--rebalance]] [--fd <n>[=main|admin]]... [--tls-cert <pem> [--tls-key <pem>] [--no-session-tickets] [--http3 <udp port>]] [--udp-ingest <udp port>] [--connect <port,...|any> [--connect-idle <seconds>]]" << "\n";
                 std::cerr << "Error: " << e.what() << "\n";
                 return 1;
             }
@@ -146,16 +455,240 @@ int Main(int argc, char* argv[])
             web_root = "./web";
         }
 
-        g_server = std::make_unique<core::Server>(port, web_root);
-        RegisterExampleServices(*g_server);
+        // Sockets bound by a launcher (LISTEN_FDS or --fd) queue connections while this process starts
+        std::vector<network::ActivatedListener> activated = network::activation::FromEnvironment();
+        for (const auto& [descriptor, name] : inherited_fds)
+        {
+            network::ActivatedListener listener;
+            if (!network::activation::Adopt(descriptor, name, listener))
+            {
+                std::cerr << "Invalid listening descriptor: " << descriptor << "\n";
+                return 1;
+            }
+            activated.push_back(listener);
+        }
+        std::vector<network::InheritedListener> inherited;
+        for (const auto& listener : activated)
+        {
+            // The launcher's addresses win over the command line's
+            if (listener.name == "main" && listener.port != 0)
+            {
+                port = listener.port;
+            }
+            else if (listener.name == "main")
+            {
+                local_socket = listener.local;
+            }
+            else if (listener.name == "admin" && listener.port != 0)
+            {
+                admin_port = listener.port;
+            }
+            else
+            {
+                LOG_WARN_FMT("Main", "Ignoring inherited socket for unknown listener '{}'", listener.name);
+                continue;
+            }
+            inherited.push_back({listener.name, listener.port == 0, listener.socket});
+        }
+        prefork.inherited = inherited;
+
+        if (prefork.workers > 0 && (!takeover_socket.path.empty() || !shm_transport.socket.path.empty()))
+        {
+            // Both bind per process: a replacement takes over one process, a channel lives in one
+            std::cerr << "--workers cannot be combined with --takeover or --shm\n";
+            return 1;
+        }
+        if (prefork.steer_cpu && (prefork.workers == 0 || !prefork.reuse_port))
+        {
+            std::cerr << "--steer-cpu needs --workers and --reuse-port\n";
+            return 1;
+        }
+        if (prefork.rebalance && prefork.workers < 2)
+        {
+            std::cerr << "--rebalance needs --workers with at least 2 workers\n";
+            return 1;
+        }
+
+#ifndef MINISERVER_HAS_HTTP3
+        if (http3_port != 0)
+        {
+            std::cerr << "--http3 is experimental: configure with -DMINISERVER_EXPERIMENTAL_HTTP3=ON (needs OpenSSL)\n";
+            return 1;
+        }
+#endif
+        if (http3_port != 0 && (tls_options.certificate_file.empty() || prefork.workers > 0 || http3_port < 0 || http3_port > 65535))
+        {
+            // QUIC always runs TLS; one process owns the UDP port and its connections
+            std::cerr << "--http3 needs a UDP port and --tls-cert, and cannot be combined with --workers\n";
+            return 1;
+        }
+
+        // One context for every worker: forked after this, they share the session ticket keys
+        std::shared_ptr<network::TlsContext> tls;
+        if (!tls_options.certificate_file.empty())
+        {
+            if (tls_options.key_file.empty())
+            {
+                tls_options.key_file = tls_options.certificate_file;
+            }
+            tls = network::TlsContext::Create(tls_options);
+            if (!tls)
+            {
+                return 1;
+            }
+        }
+
+        // Builds the configured server; prefork workers each build their own
+        const auto build_server = [&]() -> std::unique_ptr<core::Server>
+        {
+            auto server = std::make_unique<core::Server>(port, web_root);
+            RegisterExampleServices(*server);
+            if (!local_socket.path.empty())
+            {
+                server->SetLocalSocket(local_socket);
+            }
+            if (!shm_transport.socket.path.empty())
+            {
+                server->SetShmTransport(shm_transport);
+            }
+            if (http3_port != 0)
+            {
+                network::Http3ServerOptions http3;
+                http3.port = http3_port;
+                http3.certificate_file = tls_options.certificate_file;
+                http3.key_file = tls_options.key_file;
+                server->SetHttp3(http3);
+            }
+            if (udp_ingest_port != 0)
+            {
+                // Prefork workers each bind the port; the kernel spreads senders over them
+                network::UdpIngestOptions ingest;
+                ingest.port = udp_ingest_port;
+                ingest.reuse_port = prefork.workers > 0;
+                server->SetUdpIngest(ingest, nullptr);
+            }
+            if (connect_tunnel.enabled)
+            {
+                server->SetConnectTunnel(connect_tunnel);
+            }
+            if (admin_port != 0 || max_connections > 0 || tls || tuned || busy_poll.enabled)
+            {
+                // Admin endpoints get their own listener and thread budget, so they answer under load
+                const std::vector<std::string> admin_paths = {"/api/server", "/api/proxy", "/api/hotreload"};
+                core::ListenerOptions data_plane;
+                data_plane.name = "main";
+                data_plane.port = port;
+                data_plane.local_socket = local_socket;
+                data_plane.limits.max_connections = max_connections;
+                data_plane.tls = tls;
+                data_plane.tuning = tuning;
+                data_plane.busy_poll = busy_poll;
+                if (admin_port != 0)
+                {
+                    data_plane.deny_prefixes = admin_paths;
+                    core::ListenerOptions admin;
+                    admin.name = "admin";
+                    admin.host = "127.0.0.1";
+                    admin.port = admin_port;
+                    admin.allow_prefixes = admin_paths;
+                    admin.allow_prefixes.push_back("/ping");
+                    admin.limits.max_connections = 16;
+                    if (!server->AddListener(admin))
+                    {
+                        std::cerr << "Invalid admin port: " << admin_port << "\n";
+                        return nullptr;
+                    }
+                }
+                server->AddListener(data_plane);
+            }
+
+            // --proxy /api=127.0.0.1:9001,127.0.0.1:9002
+            for (const auto& route : proxy_routes)
+            {
+                const size_t equals = route.find('=');
+                std::vector<std::string> upstreams;
+                for (size_t start = equals + 1; equals != std::string::npos && start <= route.size();)
+                {
+                    const size_t comma = std::min(route.find(',', start), route.size());
+                    if (comma > start)
+                    {
+                        upstreams.push_back(route.substr(start, comma - start));
+                    }
+                    start = comma + 1;
+                }
+                if (equals == std::string::npos || !server->AddProxyRoute(route.substr(0, equals), upstreams, route_options))
+                {
+                    std::cerr << "Invalid proxy route: " << route << "\n";
+                    return nullptr;
+                }
+            }
+            if (!inherited.empty())
+            {
+                server->SetInheritedListeners(inherited);
+            }
+            if (!takeover_socket.path.empty())
+            {
+                server->SetTakeover(takeover_socket);
+            }
+            if (drain_seconds >= 0)
+            {
+                server->SetDrainTimeout(std::chrono::seconds(drain_seconds));
+            }
+            return server;
+        };
+
+        if (prefork.workers > 0)
+        {
+            // Workers drain for --drain seconds themselves; the master only kills them after that
+            if (drain_seconds >= 0)
+            {
+                prefork.stop_timeout = std::chrono::seconds(drain_seconds + 5);
+            }
+            core::PreforkMaster master(prefork, build_server);
+            PrintUsage();
+            return master.Run([]() { return g_stop_signal != 0; });
+        }
+
+        g_server = build_server();
+        if (!g_server)
+        {
+            return 1;
+        }
+        auto clock_stream = g_server->CreateEventStream("clock");
         g_server->Start();
+        if (g_server->IsRunning())
+        {
+            network::activation::NotifyReady();
+        }
 
         PrintUsage();
 
-        while (g_server->IsRunning())
+        // Example event stream: one tick per second to every /events/clock subscriber
+        uint64_t tick = 0;
+        auto next_tick = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (g_server->IsRunning() && g_stop_signal == 0)
         {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (std::chrono::steady_clock::now() < next_tick)
+            {
+                continue;
+            }
+            next_tick += std::chrono::seconds(1);
+            if (clock_stream && clock_stream->GetSubscriberCount() > 0)
+            {
+                network::ServerSentEvent event;
+                event.event = "tick";
+                event.id = std::to_string(++tick);
+                event.data = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count());
+                clock_stream->Broadcast(event);
+            }
         }
+        if (g_stop_signal != 0)
+        {
+            LOG_INFO_FMT("Main", "Received signal {} , shutting down...", static_cast<int>(g_stop_signal));
+        }
+        g_server->Stop();
     }
     catch (const std::exception& e)
     {
@@ -0,0 +1,526 @@
+/**
+ * @file body_encoding.cpp
+ * @brief Structured response writer implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "body_encoding.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace miniserver::http
+{
+
+namespace
+{
+    /**
+     * @brief Trim spaces/tabs and lowercase a token
+     */
+    std::string NormalizeToken(std::string_view token)
+    {
+        size_t start = token.find_first_not_of(" \t");
+        if (start == std::string_view::npos)
+        {
+            return "";
+        }
+        size_t end = token.find_last_not_of(" \t");
+        std::string result(token.substr(start, end - start + 1));
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c)
+        {
+            return static_cast<char>(std::tolower(c));
+        });
+        return result;
+    }
+
+    /**
+     * @brief Map a media range to the encoding it selects, if any
+     */
+    bool MediaRangeToEncoding(const std::string& media_range, BodyEncoding& encoding)
+    {
+        if (media_range == "application/cbor")
+        {
+            encoding = BodyEncoding::Cbor;
+            return true;
+        }
+        if (media_range == "application/msgpack" ||
+            media_range == "application/x-msgpack" ||
+            media_range == "application/vnd.msgpack")
+        {
+            encoding = BodyEncoding::MessagePack;
+            return true;
+        }
+        if (media_range == "application/json" || media_range == "application/*" || media_range == "*/*")
+        {
+            encoding = BodyEncoding::Json;
+            return true;
+        }
+        return false;
+    }
+}
+
+BodyEncoding NegotiateBodyEncoding(const std::string& accept_header)
+{
+    BodyEncoding best = BodyEncoding::Json;
+    double best_q = -1.0;
+
+    size_t pos = 0;
+    while (pos <= accept_header.size())
+    {
+        size_t comma = accept_header.find(',', pos);
+        if (comma == std::string::npos)
+        {
+            comma = accept_header.size();
+        }
+        std::string_view item(accept_header.data() + pos, comma - pos);
+        pos = comma + 1;
+
+        // Split "type/subtype;param=value;q=0.5"
+        size_t semicolon = item.find(';');
+        std::string media_range = NormalizeToken(item.substr(0, semicolon));
+
+        double q = 1.0;
+        while (semicolon != std::string_view::npos)
+        {
+            size_t next = item.find(';', semicolon + 1);
+            std::string param = NormalizeToken(item.substr(semicolon + 1,
+                next == std::string_view::npos ? std::string_view::npos : next - semicolon - 1));
+            if (param.size() > 2 && param[0] == 'q' && param[1] == '=')
+            {
+                q = std::strtod(param.c_str() + 2, nullptr);
+            }
+            semicolon = next;
+        }
+
+        BodyEncoding encoding;
+        if (q > 0.0 && q > best_q && MediaRangeToEncoding(media_range, encoding))
+        {
+            best = encoding;
+            best_q = q;
+        }
+    }
+
+    return best;
+}
+
+std::string BodyEncodingToContentType(BodyEncoding encoding)
+{
+    switch (encoding)
+    {
+        case BodyEncoding::Cbor: return "application/cbor";
+        case BodyEncoding::MessagePack: return "application/msgpack";
+        case BodyEncoding::Json:
+        default: return "application/json; charset=utf-8";
+    }
+}
+
+StructuredWriter::StructuredWriter(BodyEncoding encoding)
+    : m_encoding(encoding)
+{
+    m_buffer.reserve(256);
+}
+
+StructuredWriter StructuredWriter::ForRequest(const Request& request)
+{
+    return StructuredWriter(NegotiateBodyEncoding(request.GetHeader("Accept")));
+}
+
+void StructuredWriter::BeginObject(size_t size)
+{
+    BeginContainer(true, size);
+}
+
+void StructuredWriter::EndObject()
+{
+    EndContainer(true);
+}
+
+void StructuredWriter::BeginArray(size_t size)
+{
+    BeginContainer(false, size);
+}
+
+void StructuredWriter::EndArray()
+{
+    EndContainer(false);
+}
+
+void StructuredWriter::Key(std::string_view key)
+{
+    BeginItem();
+    WriteString(key);
+    if (m_encoding == BodyEncoding::Json)
+    {
+        m_buffer += ':';
+    }
+    m_after_key = true;
+}
+
+void StructuredWriter::String(std::string_view value)
+{
+    BeginItem();
+    WriteString(value);
+}
+
+void StructuredWriter::Int(int64_t value)
+{
+    if (value >= 0)
+    {
+        UInt(static_cast<uint64_t>(value));
+        return;
+    }
+
+    BeginItem();
+    switch (m_encoding)
+    {
+        case BodyEncoding::Json:
+            m_buffer += std::to_string(value);
+            break;
+        case BodyEncoding::Cbor:
+            // Negative integers encode -1 - n as major type 1
+            CborHead(1, static_cast<uint64_t>(-(value + 1)));
+            break;
+        case BodyEncoding::MessagePack:
+            if (value >= -32)
+            {
+                m_buffer += static_cast<char>(static_cast<int8_t>(value));
+            }
+            else if (value >= INT8_MIN)
+            {
+                m_buffer += static_cast<char>(0xd0);
+                AppendBigEndian(static_cast<uint64_t>(value), 1);
+            }
+            else if (value >= INT16_MIN)
+            {
+                m_buffer += static_cast<char>(0xd1);
+                AppendBigEndian(static_cast<uint64_t>(value), 2);
+            }
+            else if (value >= INT32_MIN)
+            {
+                m_buffer += static_cast<char>(0xd2);
+                AppendBigEndian(static_cast<uint64_t>(value), 4);
+            }
+            else
+            {
+                m_buffer += static_cast<char>(0xd3);
+                AppendBigEndian(static_cast<uint64_t>(value), 8);
+            }
+            break;
+    }
+}
+
+void StructuredWriter::UInt(uint64_t value)
+{
+    BeginItem();
+    switch (m_encoding)
+    {
+        case BodyEncoding::Json:
+            m_buffer += std::to_string(value);
+            break;
+        case BodyEncoding::Cbor:
+            CborHead(0, value);
+            break;
+        case BodyEncoding::MessagePack:
+            if (value < 0x80)
+            {
+                m_buffer += static_cast<char>(value);
+            }
+            else if (value <= UINT8_MAX)
+            {
+                m_buffer += static_cast<char>(0xcc);
+                AppendBigEndian(value, 1);
+            }
+            else if (value <= UINT16_MAX)
+            {
+                m_buffer += static_cast<char>(0xcd);
+                AppendBigEndian(value, 2);
+            }
+            else if (value <= UINT32_MAX)
+            {
+                m_buffer += static_cast<char>(0xce);
+                AppendBigEndian(value, 4);
+            }
+            else
+            {
+                m_buffer += static_cast<char>(0xcf);
+                AppendBigEndian(value, 8);
+            }
+            break;
+    }
+}
+
+void StructuredWriter::Double(double value)
+{
+    BeginItem();
+    if (m_encoding == BodyEncoding::Json)
+    {
+        if (!std::isfinite(value))
+        {
+            m_buffer += "null";
+            return;
+        }
+        char text[32];
+        int length = std::snprintf(text, sizeof(text), "%.17g", value);
+        m_buffer.append(text, static_cast<size_t>(length));
+        return;
+    }
+
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    m_buffer += static_cast<char>(m_encoding == BodyEncoding::Cbor ? 0xfb : 0xcb);
+    AppendBigEndian(bits, 8);
+}
+
+void StructuredWriter::Bool(bool value)
+{
+    BeginItem();
+    switch (m_encoding)
+    {
+        case BodyEncoding::Json:
+            m_buffer += value ? "true" : "false";
+            break;
+        case BodyEncoding::Cbor:
+            m_buffer += static_cast<char>(value ? 0xf5 : 0xf4);
+            break;
+        case BodyEncoding::MessagePack:
+            m_buffer += static_cast<char>(value ? 0xc3 : 0xc2);
+            break;
+    }
+}
+
+void StructuredWriter::Null()
+{
+    BeginItem();
+    switch (m_encoding)
+    {
+        case BodyEncoding::Json:
+            m_buffer += "null";
+            break;
+        case BodyEncoding::Cbor:
+            m_buffer += static_cast<char>(0xf6);
+            break;
+        case BodyEncoding::MessagePack:
+            m_buffer += static_cast<char>(0xc0);
+            break;
+    }
+}
+
+void StructuredWriter::WriteTo(Response& response)
+{
+    response.SetHeader("Vary", "Accept");
+    response.SetHeader("Content-Type", BodyEncodingToContentType(m_encoding));
+    response.SetHeader("Content-Length", std::to_string(m_buffer.size()));
+    response.body = std::move(m_buffer);
+    m_buffer.clear();
+    m_open.clear();
+    m_after_key = false;
+}
+
+void StructuredWriter::BeginItem()
+{
+    // A map value belongs to the entry its key opened
+    if (m_after_key)
+    {
+        m_after_key = false;
+        return;
+    }
+    if (!m_open.empty())
+    {
+        if (m_encoding == BodyEncoding::Json && m_open.back().items > 0)
+        {
+            m_buffer += ',';
+        }
+        ++m_open.back().items;
+    }
+}
+
+void StructuredWriter::WriteString(std::string_view value)
+{
+    switch (m_encoding)
+    {
+        case BodyEncoding::Json:
+            JsonQuoted(value);
+            break;
+        case BodyEncoding::Cbor:
+            CborHead(3, value.size());
+            m_buffer.append(value.data(), value.size());
+            break;
+        case BodyEncoding::MessagePack:
+            MsgPackHead(0xa0, 32, 0xd9, 0xda, 0xdb, value.size());
+            m_buffer.append(value.data(), value.size());
+            break;
+    }
+}
+
+void StructuredWriter::ContainerHead(bool map, size_t size)
+{
+    switch (m_encoding)
+    {
+        case BodyEncoding::Json:
+            m_buffer += map ? '{' : '[';
+            break;
+        case BodyEncoding::Cbor:
+            CborHead(map ? 5 : 4, size);
+            break;
+        case BodyEncoding::MessagePack:
+            if (map)
+            {
+                MsgPackHead(0x80, 16, 0, 0xde, 0xdf, size);
+            }
+            else
+            {
+                MsgPackHead(0x90, 16, 0, 0xdc, 0xdd, size);
+            }
+            break;
+    }
+}
+
+void StructuredWriter::BeginContainer(bool map, size_t size)
+{
+    BeginItem();
+    Container container;
+    container.map = map;
+    container.declared = size;
+    container.head = m_buffer.size();
+    ContainerHead(map, size);
+    container.head_length = m_buffer.size() - container.head;
+    m_open.push_back(container);
+}
+
+void StructuredWriter::EndContainer(bool map)
+{
+    if (m_open.empty() || m_open.back().map != map)
+    {
+        LOG_ERROR_FMT(StructuredWriter, "{} without a matching Begin", map ? "EndObject" : "EndArray");
+        return;
+    }
+    const Container container = m_open.back();
+    m_open.pop_back();
+    if (m_encoding == BodyEncoding::Json)
+    {
+        m_buffer += map ? '}' : ']';
+    }
+    if (container.items == container.declared)
+    {
+        return;
+    }
+
+    // The binary heads carry the count: rewrite this one so the body stays decodable
+    static std::atomic<bool> warned{false};
+    if (!warned.exchange(true))
+    {
+        LOG_WARN_FMT(StructuredWriter, "{} declared {} entries but {} were written",
+                     map ? "Object" : "Array", container.declared, container.items);
+    }
+    if (m_encoding != BodyEncoding::Json)
+    {
+        const size_t end = m_buffer.size();
+        ContainerHead(map, container.items);
+        const std::string head = m_buffer.substr(end);
+        m_buffer.resize(end);
+        m_buffer.replace(container.head, container.head_length, head);
+    }
+}
+
+void StructuredWriter::JsonQuoted(std::string_view value)
+{
+    static const char kHexDigits[] = "0123456789abcdef";
+
+    m_buffer += '"';
+    for (char ch : value)
+    {
+        const auto c = static_cast<unsigned char>(ch);
+        switch (c)
+        {
+            case '"': m_buffer += "\\\""; break;
+            case '\\': m_buffer += "\\\\"; break;
+            case '\n': m_buffer += "\\n"; break;
+            case '\r': m_buffer += "\\r"; break;
+            case '\t': m_buffer += "\\t"; break;
+            case '\b': m_buffer += "\\b"; break;
+            case '\f': m_buffer += "\\f"; break;
+            default:
+                if (c < 0x20)
+                {
+                    m_buffer += "\\u00";
+                    m_buffer += kHexDigits[c >> 4];
+                    m_buffer += kHexDigits[c & 0x0f];
+                }
+                else
+                {
+                    m_buffer += ch;
+                }
+                break;
+        }
+    }
+    m_buffer += '"';
+}
+
+void StructuredWriter::CborHead(uint8_t major, uint64_t value)
+{
+    const auto type = static_cast<uint8_t>(major << 5);
+    if (value < 24)
+    {
+        m_buffer += static_cast<char>(type | value);
+    }
+    else if (value <= UINT8_MAX)
+    {
+        m_buffer += static_cast<char>(type | 24);
+        AppendBigEndian(value, 1);
+    }
+    else if (value <= UINT16_MAX)
+    {
+        m_buffer += static_cast<char>(type | 25);
+        AppendBigEndian(value, 2);
+    }
+    else if (value <= UINT32_MAX)
+    {
+        m_buffer += static_cast<char>(type | 26);
+        AppendBigEndian(value, 4);
+    }
+    else
+    {
+        m_buffer += static_cast<char>(type | 27);
+        AppendBigEndian(value, 8);
+    }
+}
+
+void StructuredWriter::MsgPackHead(uint8_t fix_prefix, size_t fix_limit,
+                                   uint8_t code8, uint8_t code16, uint8_t code32, size_t size)
+{
+    if (size < fix_limit)
+    {
+        m_buffer += static_cast<char>(fix_prefix | size);
+    }
+    else if (code8 != 0 && size <= UINT8_MAX)
+    {
+        m_buffer += static_cast<char>(code8);
+        AppendBigEndian(size, 1);
+    }
+    else if (size <= UINT16_MAX)
+    {
+        m_buffer += static_cast<char>(code16);
+        AppendBigEndian(size, 2);
+    }
+    else
+    {
+        m_buffer += static_cast<char>(code32);
+        AppendBigEndian(size, 4);
+    }
+}
+
+void StructuredWriter::AppendBigEndian(uint64_t value, int bytes)
+{
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8)
+    {
+        m_buffer += static_cast<char>((value >> shift) & 0xff);
+    }
+}
+
+} // namespace miniserver::http
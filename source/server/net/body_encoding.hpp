@@ -0,0 +1,244 @@
+/**
+ * @file body_encoding.hpp
+ * @brief Encoding-agnostic structured response writer (JSON / CBOR / MessagePack)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "http_types.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace miniserver::http
+{
+
+/**
+ * @brief Wire encodings available for structured response bodies
+ */
+enum class BodyEncoding {
+    Json,
+    Cbor,
+    MessagePack
+};
+
+/**
+ * @brief Pick the body encoding preferred by an Accept header
+ * @param accept_header Raw Accept header value (may be empty)
+ * @return Best supported encoding, Json when nothing better is acceptable
+ *
+ * @details
+ * Honours q-values. Among equally weighted candidates the one listed first
+ * wins, so "application/cbor, application/json" selects CBOR.
+ */
+BodyEncoding NegotiateBodyEncoding(const std::string& accept_header);
+
+/**
+ * @brief Content-Type value for an encoding
+ * @param encoding Body encoding
+ * @return MIME type string
+ */
+std::string BodyEncodingToContentType(BodyEncoding encoding);
+
+/**
+ * @brief Streaming writer for structured (map/array/scalar) response bodies
+ *
+ * Services describe their output once through this interface and the bytes
+ * are produced directly in the negotiated encoding, so no intermediate JSON
+ * text is built for clients asking for CBOR or MessagePack.
+ *
+ * Container sizes are announced up front because MessagePack has no
+ * indefinite-length form. The writer counts what is actually written; a
+ * container ending with a different count is logged and its CBOR/MessagePack
+ * head rewritten, which moves every byte written since.
+ *
+ * @example
+ * @code
+ * auto writer = StructuredWriter::ForRequest(request);
+ * writer.BeginObject(2);
+ * writer.Key("status"); writer.String("ok");
+ * writer.Key("count");  writer.Int(42);
+ * writer.EndObject();
+ * writer.WriteTo(response);
+ * @endcode
+ */
+class StructuredWriter
+{
+public:
+    /**
+     * @brief Construct a writer for a fixed encoding
+     * @param encoding Output encoding
+     */
+    explicit StructuredWriter(BodyEncoding encoding);
+
+    /**
+     * @brief Construct a writer using the encoding negotiated from the request's Accept header
+     * @param request HTTP request
+     * @return Writer for the negotiated encoding
+     */
+    static StructuredWriter ForRequest(const Request& request);
+
+    /**
+     * @brief Begin a map with the given number of key/value pairs
+     * @param size Number of entries that will follow (checked by EndObject)
+     */
+    void BeginObject(size_t size);
+
+    /**
+     * @brief End the current map
+     */
+    void EndObject();
+
+    /**
+     * @brief Begin an array with the given number of items
+     * @param size Number of items that will follow (checked by EndArray)
+     */
+    void BeginArray(size_t size);
+
+    /**
+     * @brief End the current array
+     */
+    void EndArray();
+
+    /**
+     * @brief Write a map key (must be followed by exactly one value)
+     * @param key Key string
+     */
+    void Key(std::string_view key);
+
+    /**
+     * @brief Write a UTF-8 string value
+     * @param value String value
+     */
+    void String(std::string_view value);
+
+    /**
+     * @brief Write a signed integer value
+     * @param value Integer value
+     */
+    void Int(int64_t value);
+
+    /**
+     * @brief Write an unsigned integer value
+     * @param value Integer value
+     */
+    void UInt(uint64_t value);
+
+    /**
+     * @brief Write a floating point value (non-finite values become null in JSON)
+     * @param value Floating point value
+     */
+    void Double(double value);
+
+    /**
+     * @brief Write a boolean value
+     * @param value Boolean value
+     */
+    void Bool(bool value);
+
+    /**
+     * @brief Write a null value
+     */
+    void Null();
+
+    /**
+     * @brief Get the encoding used by this writer
+     * @return Body encoding
+     */
+    BodyEncoding GetEncoding() const noexcept { return m_encoding; }
+
+    /**
+     * @brief Get the encoded bytes written so far
+     * @return Encoded buffer
+     */
+    const std::string& GetBuffer() const noexcept { return m_buffer; }
+
+    /**
+     * @brief Move the encoded body into a response
+     * @param response Response to fill (Content-Type, Content-Length and Vary are set)
+     */
+    void WriteTo(Response& response);
+
+private:
+    /**
+     * @brief Container opened by BeginObject/BeginArray
+     */
+    struct Container
+    {
+        bool map = false;           ///< Object (entries) or array (items)
+        size_t declared = 0;        ///< Size passed to Begin*
+        size_t items = 0;           ///< Keys (maps) or values (arrays) written
+        size_t head = 0;            ///< Offset of the head in m_buffer
+        size_t head_length = 0;     ///< Bytes of the head
+    };
+
+    /**
+     * @brief Count a key or value in the enclosing container (JSON: emit its separator)
+     */
+    void BeginItem();
+
+    /**
+     * @brief Append a string in the output encoding (no item accounting)
+     * @param value UTF-8 string
+     */
+    void WriteString(std::string_view value);
+
+    /**
+     * @brief Append a map or array head (JSON: the opening bracket)
+     * @param map Map or array
+     * @param size Number of entries or items
+     */
+    void ContainerHead(bool map, size_t size);
+
+    /**
+     * @brief Shared implementation of BeginObject/BeginArray
+     */
+    void BeginContainer(bool map, size_t size);
+
+    /**
+     * @brief Shared implementation of EndObject/EndArray: close and check the count
+     */
+    void EndContainer(bool map);
+
+    /**
+     * @brief Append a JSON quoted and escaped string
+     * @param value Raw string
+     */
+    void JsonQuoted(std::string_view value);
+
+    /**
+     * @brief Append a CBOR head (major type + argument)
+     * @param major Major type (0-7)
+     * @param value Argument value
+     */
+    void CborHead(uint8_t major, uint64_t value);
+
+    /**
+     * @brief Append a MessagePack container/string head
+     * @param fix_prefix Prefix for the "fix" short form
+     * @param fix_limit Exclusive size limit of the short form
+     * @param code8 Marker for 8-bit length (0 if the type has none)
+     * @param code16 Marker for 16-bit length
+     * @param code32 Marker for 32-bit length
+     * @param size Length to encode
+     */
+    void MsgPackHead(uint8_t fix_prefix, size_t fix_limit,
+                     uint8_t code8, uint8_t code16, uint8_t code32, size_t size);
+
+    /**
+     * @brief Append an integer in big-endian byte order
+     * @param value Value to append
+     * @param bytes Number of low-order bytes to write
+     */
+    void AppendBigEndian(uint64_t value, int bytes);
+
+    BodyEncoding m_encoding;                ///< Output encoding
+    std::string m_buffer;                   ///< Encoded output
+    std::vector<Container> m_open;          ///< Open containers, innermost last
+    bool m_after_key = false;               ///< A key was just written (its value is not a new item)
+};
+
+} // namespace miniserver::http
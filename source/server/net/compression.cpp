@@ -0,0 +1,714 @@
+/**
+ * @file compression.cpp
+ * @brief HTTP content-coding negotiation and body compression implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "compression.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+#ifdef MINISERVER_HAS_ZLIB
+    #include <zlib.h>
+#endif
+#ifdef MINISERVER_HAS_ZSTD
+    #include <zstd.h>
+#endif
+
+namespace miniserver::http
+{
+
+namespace
+{
+    std::string ToLowerTrimmed(std::string_view token)
+    {
+        size_t start = token.find_first_not_of(" \t");
+        if (start == std::string_view::npos)
+        {
+            return "";
+        }
+        size_t end = token.find_last_not_of(" \t");
+        std::string result(token.substr(start, end - start + 1));
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c)
+        {
+            return static_cast<char>(std::tolower(c));
+        });
+        return result;
+    }
+
+    /**
+     * @brief Server preference used to break q-value ties (higher is better)
+     */
+    int CodingPreference(ContentCoding coding)
+    {
+        switch (coding)
+        {
+            case ContentCoding::Zstd: return 3;
+            case ContentCoding::Gzip: return 2;
+            case ContentCoding::Deflate: return 1;
+            case ContentCoding::Identity:
+            default: return 0;
+        }
+    }
+
+#ifdef MINISERVER_HAS_ZLIB
+    /**
+     * @brief zlib deflate stream cached per thread and reset between bodies
+     */
+    class ZlibCompressor
+    {
+    public:
+        explicit ZlibCompressor(int window_bits) : m_window_bits(window_bits) {}
+
+        ~ZlibCompressor()
+        {
+            if (m_initialized)
+            {
+                deflateEnd(&m_stream);
+            }
+        }
+
+        ZlibCompressor(const ZlibCompressor&) = delete;
+        ZlibCompressor& operator=(const ZlibCompressor&) = delete;
+
+        std::optional<std::string> Compress(const std::string& data, int level)
+        {
+            level = std::clamp(level, 1, 9);
+            if (!m_initialized)
+            {
+                m_stream = z_stream{};
+                if (deflateInit2(&m_stream, level, Z_DEFLATED, m_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                {
+                    return std::nullopt;
+                }
+                m_initialized = true;
+                m_level = level;
+            }
+            else
+            {
+                deflateReset(&m_stream);
+                if (level != m_level)
+                {
+                    // Allowed because no input has been supplied since the reset
+                    deflateParams(&m_stream, level, Z_DEFAULT_STRATEGY);
+                    m_level = level;
+                }
+            }
+
+            std::string output;
+            output.resize(deflateBound(&m_stream, static_cast<uLong>(data.size())));
+
+            m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+            m_stream.avail_in = static_cast<uInt>(data.size());
+            m_stream.next_out = reinterpret_cast<Bytef*>(output.data());
+            m_stream.avail_out = static_cast<uInt>(output.size());
+
+            if (deflate(&m_stream, Z_FINISH) != Z_STREAM_END)
+            {
+                deflateReset(&m_stream);
+                return std::nullopt;
+            }
+            output.resize(m_stream.total_out);
+            return output;
+        }
+
+    private:
+        z_stream m_stream{};
+        int m_window_bits;
+        int m_level = 0;
+        bool m_initialized = false;
+    };
+#endif
+
+#ifdef MINISERVER_HAS_ZSTD
+    /**
+     * @brief zstd compression context cached per thread
+     */
+    class ZstdCompressor
+    {
+    public:
+        ZstdCompressor() : m_context(ZSTD_createCCtx()) {}
+        ~ZstdCompressor() { ZSTD_freeCCtx(m_context); }
+
+        ZstdCompressor(const ZstdCompressor&) = delete;
+        ZstdCompressor& operator=(const ZstdCompressor&) = delete;
+
+        std::optional<std::string> Compress(const std::string& data, int level)
+        {
+            if (!m_context)
+            {
+                return std::nullopt;
+            }
+            std::string output;
+            output.resize(ZSTD_compressBound(data.size()));
+            size_t written = ZSTD_compressCCtx(m_context, output.data(), output.size(),
+                                               data.data(), data.size(),
+                                               std::clamp(level, 1, ZSTD_maxCLevel()));
+            if (ZSTD_isError(written))
+            {
+                return std::nullopt;
+            }
+            output.resize(written);
+            return output;
+        }
+
+    private:
+        ZSTD_CCtx* m_context;
+    };
+#endif
+}
+
+struct BodyDecompressor::Impl
+{
+    ContentCoding coding;
+    DecompressionLimits limits;
+    size_t consumed = 0;            ///< Compressed bytes consumed so far
+    size_t produced = 0;            ///< Decompressed bytes produced so far
+    bool finished = false;          ///< Codec reported end of stream
+    bool failed = false;            ///< A previous step failed
+#ifdef MINISERVER_HAS_ZLIB
+    z_stream zstream{};
+    bool zlib_initialized = false;
+    bool raw_deflate_retried = false;
+#endif
+#ifdef MINISERVER_HAS_ZSTD
+    ZSTD_DCtx* zstd_context = nullptr;
+#endif
+
+    Impl(ContentCoding c, const DecompressionLimits& l) : coding(c), limits(l) {}
+
+    ~Impl()
+    {
+#ifdef MINISERVER_HAS_ZLIB
+        if (zlib_initialized)
+        {
+            inflateEnd(&zstream);
+        }
+#endif
+#ifdef MINISERVER_HAS_ZSTD
+        ZSTD_freeDCtx(zstd_context);
+#endif
+    }
+
+    /**
+     * @brief Check the size and ratio limits against the current totals
+     */
+    bool WithinLimits() const
+    {
+        if (produced > limits.max_size)
+        {
+            return false;
+        }
+        if (produced >= limits.ratio_check_floor && limits.max_ratio > 0 &&
+            produced / std::max<size_t>(consumed, 1) > limits.max_ratio)
+        {
+            return false;
+        }
+        return true;
+    }
+};
+
+BodyDecompressor::BodyDecompressor(ContentCoding coding, const DecompressionLimits& limits)
+    : m_impl(std::make_unique<Impl>(coding, limits))
+{
+#ifdef MINISERVER_HAS_ZLIB
+    if (coding == ContentCoding::Gzip || coding == ContentCoding::Deflate)
+    {
+        // 15 + 16 expects the gzip wrapper, 15 the zlib wrapper
+        const int window_bits = coding == ContentCoding::Gzip ? 15 + 16 : 15;
+        m_impl->zlib_initialized = inflateInit2(&m_impl->zstream, window_bits) == Z_OK;
+    }
+#endif
+#ifdef MINISERVER_HAS_ZSTD
+    if (coding == ContentCoding::Zstd)
+    {
+        m_impl->zstd_context = ZSTD_createDCtx();
+    }
+#endif
+}
+
+BodyDecompressor::~BodyDecompressor() = default;
+
+DecompressStatus BodyDecompressor::Feed(std::string_view input, std::string& output)
+{
+    Impl& impl = *m_impl;
+    if (impl.failed)
+    {
+        return DecompressStatus::Corrupt;
+    }
+    if (impl.coding == ContentCoding::Identity)
+    {
+        impl.consumed += input.size();
+        impl.produced += input.size();
+        output.append(input.data(), input.size());
+        return impl.WithinLimits() ? DecompressStatus::Ok : DecompressStatus::TooLarge;
+    }
+
+    constexpr size_t kChunkSize = 16 * 1024;
+
+#ifdef MINISERVER_HAS_ZLIB
+    if (impl.coding == ContentCoding::Gzip || impl.coding == ContentCoding::Deflate)
+    {
+        if (!impl.zlib_initialized)
+        {
+            return DecompressStatus::Unsupported;
+        }
+        const bool first_feed = impl.consumed == 0;
+        z_stream& stream = impl.zstream;
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = static_cast<uInt>(input.size());
+
+        while (stream.avail_in > 0)
+        {
+            if (impl.finished)
+            {
+                // Another gzip member follows (RFC 1952 allows concatenation)
+                if (impl.coding != ContentCoding::Gzip)
+                {
+                    impl.failed = true;
+                    return DecompressStatus::Corrupt;
+                }
+                inflateReset(&stream);
+                impl.finished = false;
+            }
+
+            const size_t old_size = output.size();
+            output.resize(old_size + kChunkSize);
+            stream.next_out = reinterpret_cast<Bytef*>(output.data() + old_size);
+            stream.avail_out = static_cast<uInt>(kChunkSize);
+
+            const uInt avail_before = stream.avail_in;
+            int result = inflate(&stream, Z_NO_FLUSH);
+            const size_t written = kChunkSize - stream.avail_out;
+            output.resize(old_size + written);
+            impl.consumed += avail_before - stream.avail_in;
+            impl.produced += written;
+
+            if (result == Z_DATA_ERROR && impl.coding == ContentCoding::Deflate &&
+                !impl.raw_deflate_retried && first_feed && impl.produced == 0)
+            {
+                // Some clients send raw deflate without the zlib wrapper
+                impl.raw_deflate_retried = true;
+                inflateEnd(&stream);
+                stream = z_stream{};
+                impl.zlib_initialized = inflateInit2(&stream, -15) == Z_OK;
+                impl.consumed = 0;
+                if (!impl.zlib_initialized)
+                {
+                    return DecompressStatus::Unsupported;
+                }
+                return Feed(input, output);
+            }
+            if (result == Z_STREAM_END)
+            {
+                impl.finished = true;
+            }
+            else if (result != Z_OK && result != Z_BUF_ERROR)
+            {
+                impl.failed = true;
+                return DecompressStatus::Corrupt;
+            }
+            if (!impl.WithinLimits())
+            {
+                impl.failed = true;
+                return DecompressStatus::TooLarge;
+            }
+            if (result == Z_BUF_ERROR && stream.avail_out != 0)
+            {
+                break; // needs more input
+            }
+        }
+        return DecompressStatus::Ok;
+    }
+#endif
+
+#ifdef MINISERVER_HAS_ZSTD
+    if (impl.coding == ContentCoding::Zstd)
+    {
+        if (!impl.zstd_context)
+        {
+            return DecompressStatus::Unsupported;
+        }
+        ZSTD_inBuffer in_buffer{input.data(), input.size(), 0};
+        while (in_buffer.pos < in_buffer.size)
+        {
+            const size_t old_size = output.size();
+            output.resize(old_size + kChunkSize);
+            ZSTD_outBuffer out_buffer{output.data() + old_size, kChunkSize, 0};
+
+            const size_t pos_before = in_buffer.pos;
+            size_t result = ZSTD_decompressStream(impl.zstd_context, &out_buffer, &in_buffer);
+            output.resize(old_size + out_buffer.pos);
+            impl.consumed += in_buffer.pos - pos_before;
+            impl.produced += out_buffer.pos;
+
+            if (ZSTD_isError(result))
+            {
+                impl.failed = true;
+                return DecompressStatus::Corrupt;
+            }
+            impl.finished = result == 0;
+            if (!impl.WithinLimits())
+            {
+                impl.failed = true;
+                return DecompressStatus::TooLarge;
+            }
+        }
+        return DecompressStatus::Ok;
+    }
+#endif
+
+    (void)kChunkSize;
+    return DecompressStatus::Unsupported;
+}
+
+DecompressStatus BodyDecompressor::Finish()
+{
+    if (m_impl->failed)
+    {
+        return DecompressStatus::Corrupt;
+    }
+    if (m_impl->coding == ContentCoding::Identity || m_impl->finished)
+    {
+        return DecompressStatus::Ok;
+    }
+    return IsCodingAvailable(m_impl->coding) ? DecompressStatus::Corrupt : DecompressStatus::Unsupported;
+}
+
+namespace
+{
+    /**
+     * @brief HTTP status for a failed decompression step
+     */
+    StatusCode ToStatusCode(DecompressStatus status)
+    {
+        switch (status)
+        {
+            case DecompressStatus::Ok: return StatusCode::OK;
+            case DecompressStatus::TooLarge: return StatusCode::PayloadTooLarge;
+            case DecompressStatus::Unsupported: return StatusCode::UnsupportedMediaType;
+            case DecompressStatus::Corrupt:
+            default: return StatusCode::BadRequest;
+        }
+    }
+}
+
+RequestBodyDecoder::RequestBodyDecoder(const DecompressionLimits& limits)
+    : m_limits(limits)
+{
+}
+
+RequestBodyDecoder::~RequestBodyDecoder() = default;
+
+StatusCode RequestBodyDecoder::Start(std::string_view content_encoding)
+{
+    m_stages.clear();
+
+    // Codings are listed in the order they were applied; undo them in reverse
+    size_t pos = 0;
+    while (pos < content_encoding.size())
+    {
+        size_t comma = content_encoding.find(',', pos);
+        if (comma == std::string_view::npos)
+        {
+            comma = content_encoding.size();
+        }
+        auto coding = StringToContentCoding(std::string(content_encoding.substr(pos, comma - pos)));
+        if (!coding || !IsCodingAvailable(*coding))
+        {
+            m_stages.clear();
+            return StatusCode::UnsupportedMediaType;
+        }
+        if (*coding != ContentCoding::Identity)
+        {
+            m_stages.insert(m_stages.begin(), std::make_unique<BodyDecompressor>(*coding, m_limits));
+        }
+        pos = comma + 1;
+    }
+    return StatusCode::OK;
+}
+
+StatusCode RequestBodyDecoder::Feed(std::string_view input, std::string& output)
+{
+    if (m_stages.empty())
+    {
+        output.append(input);
+        return StatusCode::OK;
+    }
+
+    // Each stage's output is the next stage's input; the last one appends to the caller's buffer
+    for (size_t i = 0; i < m_stages.size() && !input.empty(); ++i)
+    {
+        const bool last = i + 1 == m_stages.size();
+        std::string& target = last ? output : m_scratch[i % 2];
+        if (!last)
+        {
+            target.clear();
+        }
+        const DecompressStatus status = m_stages[i]->Feed(input, target);
+        if (status != DecompressStatus::Ok)
+        {
+            return ToStatusCode(status);
+        }
+        input = target;
+    }
+    return StatusCode::OK;
+}
+
+StatusCode RequestBodyDecoder::Finish()
+{
+    for (const auto& stage : m_stages)
+    {
+        const DecompressStatus status = stage->Finish();
+        if (status != DecompressStatus::Ok)
+        {
+            return ToStatusCode(status);
+        }
+    }
+    return StatusCode::OK;
+}
+
+StatusCode DecodeRequestBody(Request& request, const DecompressionLimits& limits)
+{
+    const std::string header = request.GetHeader("Content-Encoding");
+    if (header.empty())
+    {
+        return StatusCode::OK;
+    }
+
+    RequestBodyDecoder decoder(limits);
+    StatusCode status = decoder.Start(header);
+    if (status != StatusCode::OK)
+    {
+        return status;
+    }
+
+    constexpr size_t kFeedSize = 64 * 1024;
+    std::string decoded;
+    std::string_view input(request.body);
+    for (size_t offset = 0; offset < input.size() && status == StatusCode::OK; offset += kFeedSize)
+    {
+        status = decoder.Feed(input.substr(offset, kFeedSize), decoded);
+    }
+    if (status == StatusCode::OK)
+    {
+        status = decoder.Finish();
+    }
+    if (status != StatusCode::OK)
+    {
+        return status;
+    }
+    request.body = std::move(decoded);
+
+    // Handlers see a plain body, so drop the coding and report the real length
+    request.headers.erase("content-encoding");
+    request.headers["content-length"] = std::to_string(request.body.size());
+    return StatusCode::OK;
+}
+
+bool IsCodingAvailable(ContentCoding coding)
+{
+    switch (coding)
+    {
+        case ContentCoding::Identity:
+            return true;
+        case ContentCoding::Gzip:
+        case ContentCoding::Deflate:
+#ifdef MINISERVER_HAS_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case ContentCoding::Zstd:
+#ifdef MINISERVER_HAS_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+ContentCoding NegotiateContentCoding(const std::string& accept_encoding)
+{
+    ContentCoding best = ContentCoding::Identity;
+    double best_q = 0.0;
+
+    size_t pos = 0;
+    while (pos < accept_encoding.size())
+    {
+        size_t comma = accept_encoding.find(',', pos);
+        if (comma == std::string::npos)
+        {
+            comma = accept_encoding.size();
+        }
+        std::string_view item(accept_encoding.data() + pos, comma - pos);
+        pos = comma + 1;
+
+        size_t semicolon = item.find(';');
+        std::string token = ToLowerTrimmed(item.substr(0, semicolon));
+        double q = 1.0;
+        if (semicolon != std::string_view::npos)
+        {
+            std::string param = ToLowerTrimmed(item.substr(semicolon + 1));
+            if (param.size() > 2 && param[0] == 'q' && param[1] == '=')
+            {
+                q = std::strtod(param.c_str() + 2, nullptr);
+            }
+        }
+        if (q <= 0.0)
+        {
+            continue;
+        }
+
+        ContentCoding coding;
+        if (token == "*")
+        {
+            coding = ContentCoding::Gzip;
+        }
+        else
+        {
+            auto parsed = StringToContentCoding(token);
+            if (!parsed || *parsed == ContentCoding::Identity)
+            {
+                continue;
+            }
+            coding = *parsed;
+        }
+
+        if (!IsCodingAvailable(coding))
+        {
+            continue;
+        }
+        if (q > best_q || (q == best_q && CodingPreference(coding) > CodingPreference(best)))
+        {
+            best = coding;
+            best_q = q;
+        }
+    }
+
+    return best;
+}
+
+std::string ContentCodingToString(ContentCoding coding)
+{
+    switch (coding)
+    {
+        case ContentCoding::Gzip: return "gzip";
+        case ContentCoding::Deflate: return "deflate";
+        case ContentCoding::Zstd: return "zstd";
+        case ContentCoding::Identity:
+        default: return "identity";
+    }
+}
+
+std::optional<ContentCoding> StringToContentCoding(const std::string& token)
+{
+    const std::string lower = ToLowerTrimmed(token);
+    if (lower == "gzip" || lower == "x-gzip") return ContentCoding::Gzip;
+    if (lower == "deflate") return ContentCoding::Deflate;
+    if (lower == "zstd") return ContentCoding::Zstd;
+    if (lower == "identity" || lower.empty()) return ContentCoding::Identity;
+    return std::nullopt;
+}
+
+bool IsCompressibleContentType(const std::string& content_type)
+{
+    const std::string type = ToLowerTrimmed(std::string_view(content_type).substr(0, content_type.find(';')));
+    if (type.rfind("text/", 0) == 0)
+    {
+        return true;
+    }
+    if (type.size() > 5 && (type.compare(type.size() - 5, 5, "+json") == 0 ||
+                            type.compare(type.size() - 4, 4, "+xml") == 0))
+    {
+        return true;
+    }
+    return type == "application/json" ||
+           type == "application/javascript" ||
+           type == "application/xml" ||
+           type == "application/cbor" ||
+           type == "application/msgpack" ||
+           type == "image/svg+xml";
+}
+
+std::optional<std::string> CompressBody(ContentCoding coding, const std::string& data, int level)
+{
+    switch (coding)
+    {
+#ifdef MINISERVER_HAS_ZLIB
+        case ContentCoding::Gzip:
+        {
+            thread_local ZlibCompressor gzip_compressor(15 + 16);
+            return gzip_compressor.Compress(data, level);
+        }
+        case ContentCoding::Deflate:
+        {
+            thread_local ZlibCompressor deflate_compressor(15);
+            return deflate_compressor.Compress(data, level);
+        }
+#endif
+#ifdef MINISERVER_HAS_ZSTD
+        case ContentCoding::Zstd:
+        {
+            thread_local ZstdCompressor zstd_compressor;
+            return zstd_compressor.Compress(data, level);
+        }
+#endif
+        default:
+            (void)data;
+            (void)level;
+            return std::nullopt;
+    }
+}
+
+bool CompressResponse(const Request& request, Response& response,
+                      const CompressionOptions& options, int level)
+{
+    if (!options.enabled || response.streaming || response.body.size() < options.min_size ||
+        response.headers.count("Content-Encoding") != 0)
+    {
+        return false;
+    }
+
+    auto type_it = response.headers.find("Content-Type");
+    if (type_it == response.headers.end() || !IsCompressibleContentType(type_it->second))
+    {
+        return false;
+    }
+
+    // From here on the representation depends on Accept-Encoding
+    auto vary_it = response.headers.find("Vary");
+    if (vary_it == response.headers.end() || vary_it->second.empty())
+    {
+        response.headers["Vary"] = "Accept-Encoding";
+    }
+    else if (vary_it->second.find("Accept-Encoding") == std::string::npos)
+    {
+        vary_it->second += ", Accept-Encoding";
+    }
+
+    const ContentCoding coding = NegotiateContentCoding(request.GetHeader("Accept-Encoding"));
+    if (coding == ContentCoding::Identity)
+    {
+        return false;
+    }
+
+    auto compressed = CompressBody(coding, response.body, level);
+    if (!compressed || compressed->size() >= response.body.size())
+    {
+        return false;
+    }
+
+    response.body = std::move(*compressed);
+    response.headers["Content-Encoding"] = ContentCodingToString(coding);
+    response.headers["Content-Length"] = std::to_string(response.body.size());
+    return true;
+}
+
+} // namespace miniserver::http
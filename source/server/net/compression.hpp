@@ -0,0 +1,242 @@
+/**
+ * @file compression.hpp
+ * @brief HTTP content-coding negotiation and body compression
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "http_types.hpp"
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace miniserver::http
+{
+
+/**
+ * @brief HTTP content codings understood by the server
+ */
+enum class ContentCoding {
+    Identity,
+    Gzip,
+    Deflate,
+    Zstd
+};
+
+/**
+ * @brief Response compression settings
+ *
+ * Levels use the native scale of the selected codec (zlib 1-9, zstd 1-19).
+ * Dynamic responses are produced per request, so they default to the fastest
+ * level; static assets can afford a stronger level.
+ */
+struct CompressionOptions
+{
+    bool enabled = true;            ///< Master switch
+    size_t min_size = 1024;         ///< Bodies smaller than this are sent as-is
+    int static_level = 6;           ///< Level used for static files
+    int dynamic_level = 1;          ///< Level used for service/generated responses
+};
+
+/**
+ * @brief Limits applied while inflating compressed request bodies
+ *
+ * The ratio guard only kicks in once the output passes ratio_check_floor so
+ * small, highly repetitive payloads are not rejected.
+ */
+struct DecompressionLimits
+{
+    size_t max_size = 16 * 1024 * 1024;     ///< Maximum decompressed body size
+    size_t max_ratio = 200;                 ///< Maximum decompressed/compressed ratio
+    size_t ratio_check_floor = 1024 * 1024; ///< Output size from which the ratio is enforced
+};
+
+/**
+ * @brief Outcome of a decompression step
+ */
+enum class DecompressStatus {
+    Ok,
+    Unsupported,    ///< Coding not compiled in / unknown
+    Corrupt,        ///< Malformed or truncated compressed data
+    TooLarge        ///< Size or ratio limit exceeded (decompression bomb guard)
+};
+
+/**
+ * @brief Incremental decompressor for one compressed body
+ *
+ * Input may be fed in arbitrary chunks as it arrives; limits are checked
+ * after every inflated block so a bomb is stopped long before it is
+ * expanded in full.
+ */
+class BodyDecompressor
+{
+public:
+    /**
+     * @brief Construct a decompressor
+     * @param coding Content coding of the input
+     * @param limits Size and ratio limits
+     */
+    BodyDecompressor(ContentCoding coding, const DecompressionLimits& limits);
+
+    /**
+     * @brief Destructor (releases codec state)
+     */
+    ~BodyDecompressor();
+
+    BodyDecompressor(const BodyDecompressor&) = delete;
+    BodyDecompressor& operator=(const BodyDecompressor&) = delete;
+
+    /**
+     * @brief Feed compressed bytes and append the inflated output
+     * @param input Compressed chunk
+     * @param output Buffer receiving decompressed bytes
+     * @return Ok to continue, or the error that stopped decompression
+     */
+    DecompressStatus Feed(std::string_view input, std::string& output);
+
+    /**
+     * @brief Signal end of input
+     * @return Ok if the compressed stream was complete, Corrupt if truncated
+     */
+    DecompressStatus Finish();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;       ///< Codec specific state
+};
+
+/**
+ * @brief Incremental decoder for a Content-Encoding header's list of codings
+ *
+ * Codings are undone in reverse order, each stage feeding the next, so a
+ * body can be decoded chunk by chunk while it is still being received.
+ */
+class RequestBodyDecoder
+{
+public:
+    /**
+     * @brief Construct a decoder
+     * @param limits Size and ratio limits applied to every stage
+     */
+    explicit RequestBodyDecoder(const DecompressionLimits& limits);
+
+    /**
+     * @brief Destructor
+     */
+    ~RequestBodyDecoder();
+
+    RequestBodyDecoder(const RequestBodyDecoder&) = delete;
+    RequestBodyDecoder& operator=(const RequestBodyDecoder&) = delete;
+
+    /**
+     * @brief Set up the stages for a Content-Encoding header value
+     * @param content_encoding Header value, e.g. "gzip" or "deflate, zstd"
+     * @return OK, or UnsupportedMediaType for unknown or unavailable codings
+     */
+    StatusCode Start(std::string_view content_encoding);
+
+    /**
+     * @brief Check whether any coding other than identity has to be undone
+     */
+    bool IsActive() const { return !m_stages.empty(); }
+
+    /**
+     * @brief Feed encoded bytes and append the decoded output
+     * @param input Encoded chunk
+     * @param output Buffer receiving decoded bytes
+     * @return OK to continue, PayloadTooLarge, UnsupportedMediaType or BadRequest
+     */
+    StatusCode Feed(std::string_view input, std::string& output);
+
+    /**
+     * @brief Signal end of input
+     * @return OK if every stage saw a complete stream, BadRequest if truncated
+     */
+    StatusCode Finish();
+
+private:
+    DecompressionLimits m_limits;                               ///< Limits for every stage
+    std::vector<std::unique_ptr<BodyDecompressor>> m_stages;    ///< Outermost coding first
+    std::string m_scratch[2];                                   ///< Output of intermediate stages
+};
+
+/**
+ * @brief Decode a request body according to its Content-Encoding header
+ * @param request Request whose body is replaced with the decoded bytes
+ * @param limits Size and ratio limits
+ * @return OK on success (or when no coding is present), BadRequest for corrupt
+ *         data, UnsupportedMediaType for unknown codings, PayloadTooLarge when
+ *         a limit is exceeded
+ */
+StatusCode DecodeRequestBody(Request& request, const DecompressionLimits& limits);
+
+/**
+ * @brief Check whether a coding was compiled in
+ * @param coding Content coding
+ * @return true if the coding can be produced/consumed by this build
+ */
+bool IsCodingAvailable(ContentCoding coding);
+
+/**
+ * @brief Pick the best available coding from an Accept-Encoding header
+ * @param accept_encoding Raw Accept-Encoding header value
+ * @return Chosen coding, Identity if nothing acceptable is available
+ *
+ * @details
+ * Highest q-value wins; ties are broken by server preference
+ * (zstd, gzip, deflate).
+ */
+ContentCoding NegotiateContentCoding(const std::string& accept_encoding);
+
+/**
+ * @brief Map a coding to its Content-Encoding token
+ * @param coding Content coding
+ * @return Token string ("gzip", "deflate", "zstd" or "identity")
+ */
+std::string ContentCodingToString(ContentCoding coding);
+
+/**
+ * @brief Parse a Content-Encoding token
+ * @param token Header value (case-insensitive, surrounding spaces ignored)
+ * @return Coding, or nullopt if the token is unknown
+ */
+std::optional<ContentCoding> StringToContentCoding(const std::string& token);
+
+/**
+ * @brief Check whether a Content-Type benefits from compression
+ * @param content_type Content-Type header value
+ * @return true for text, JSON, XML, JavaScript, SVG and structured binary types
+ */
+bool IsCompressibleContentType(const std::string& content_type);
+
+/**
+ * @brief Compress a buffer using the calling thread's cached compressor context
+ * @param coding Target coding (Identity is not valid)
+ * @param data Input bytes
+ * @param level Codec specific compression level
+ * @return Compressed bytes, or nullopt if the coding is unavailable or fails
+ */
+std::optional<std::string> CompressBody(ContentCoding coding, const std::string& data, int level);
+
+/**
+ * @brief Compress a response body in place if the request and response allow it
+ * @param request Request (Accept-Encoding is consulted)
+ * @param response Response to compress
+ * @param options Compression settings
+ * @param level Level to apply (typically options.static_level or options.dynamic_level)
+ * @return true if the body was replaced with a compressed representation
+ *
+ * @details
+ * Skips responses that already carry Content-Encoding, are below the size
+ * threshold, have a non-compressible Content-Type, or would not shrink.
+ * Adds "Vary: Accept-Encoding" whenever the decision depended on the request.
+ */
+bool CompressResponse(const Request& request, Response& response,
+                      const CompressionOptions& options, int level);
+
+} // namespace miniserver::http
@@ -0,0 +1,605 @@
+/**
+ * @file connect_tunnel.cpp
+ * @brief HTTP CONNECT tunnel implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/connect_tunnel.hpp"
+#include "net/http_parser.hpp"
+#include "net/http_types.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+#ifdef MSG_NOSIGNAL
+    constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kSendFlags = 0;
+#endif
+
+    constexpr char kEstablished[] = "HTTP/1.1 200 Connection Established\r\n\r\n";
+
+    void CloseSocketHandle(SOCKET socket)
+    {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    bool SendAll(SOCKET socket, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            const auto sent = send(socket, data, static_cast<int>(size), kSendFlags);
+            if (sent <= 0)
+            {
+#ifndef _WIN32
+                if (sent < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+#endif
+                return false;
+            }
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Answer a CONNECT that is not tunneled; the connection closes afterwards
+     */
+    PassthroughResult Reject(SOCKET client_socket, http::StatusCode status)
+    {
+        http::Response response;
+        response.status = status;
+        response.SetJson("{\"error\":\"" + http::StatusToString(status) + "\"}");
+        response.SetHeader("Connection", "close");
+        const std::string data = http::HttpParser::SerializeResponse(response);
+        SendAll(client_socket, data.data(), data.size());
+        return PassthroughResult::Close;
+    }
+
+    /**
+     * @brief Split an authority-form target ("host:port", "[v6]:port")
+     */
+    bool ParseAuthority(std::string_view target, std::string& host, int& port)
+    {
+        const size_t colon = target.rfind(':');
+        if (colon == std::string_view::npos || colon == 0 || colon + 1 == target.size())
+        {
+            return false;
+        }
+        std::string_view name = target.substr(0, colon);
+        if (name.front() == '[')
+        {
+            if (name.size() < 3 || name.back() != ']')
+            {
+                return false;
+            }
+            name = name.substr(1, name.size() - 2);
+        }
+        else if (name.find(':') != std::string_view::npos)
+        {
+            return false;
+        }
+        const std::string_view digits = target.substr(colon + 1);
+        const auto result = std::from_chars(digits.data(), digits.data() + digits.size(), port);
+        if (result.ec != std::errc() || result.ptr != digits.data() + digits.size() || port <= 0 || port > 65535)
+        {
+            return false;
+        }
+        host.assign(name);
+        return true;
+    }
+
+#ifndef _WIN32
+    /**
+     * @brief Resolve and connect to a target, giving up after `timeout`
+     */
+    SOCKET ConnectTarget(const std::string& host, int port, std::chrono::milliseconds timeout)
+    {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result)
+        {
+            return INVALID_SOCKET;
+        }
+
+        SOCKET socket_fd = INVALID_SOCKET;
+        for (addrinfo* entry = result; entry && socket_fd == INVALID_SOCKET; entry = entry->ai_next)
+        {
+            socket_fd = socket(entry->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (socket_fd == INVALID_SOCKET)
+            {
+                continue;
+            }
+            if (connect(socket_fd, entry->ai_addr, entry->ai_addrlen) != 0)
+            {
+                pollfd entry_poll{socket_fd, POLLOUT, 0};
+                int error = 0;
+                socklen_t length = sizeof(error);
+                if (errno != EINPROGRESS || poll(&entry_poll, 1, static_cast<int>(timeout.count())) <= 0 ||
+                    getsockopt(socket_fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0)
+                {
+                    CloseSocketHandle(socket_fd);
+                    socket_fd = INVALID_SOCKET;
+                }
+            }
+        }
+        freeaddrinfo(result);
+
+        if (socket_fd != INVALID_SOCKET)
+        {
+            // Blocking until the tunnel starts on the loop, so buffered client bytes can be written out
+            fcntl(socket_fd, F_SETFL, fcntl(socket_fd, F_GETFL) & ~O_NONBLOCK);
+            int enable = 1;
+            setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+        return socket_fd;
+    }
+#endif
+}
+
+/**
+ * @brief Counters shared by the proxy and its tunnels
+ */
+struct ConnectProxy::Counters
+{
+    std::atomic<uint64_t> opened{0};
+    std::atomic<uint64_t> refused{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> active{0};
+    std::atomic<uint64_t> idle_closed{0};
+    std::atomic<uint64_t> bytes_up{0};
+    std::atomic<uint64_t> bytes_down{0};
+};
+
+#if defined(__linux__)
+
+/**
+ * @brief One established tunnel: two sockets and a pipe per direction, on the loop thread
+ */
+class ConnectProxy::Tunnel : public std::enable_shared_from_this<ConnectProxy::Tunnel>
+{
+public:
+    Tunnel(EventLoop& loop, SOCKET client, SOCKET target, std::string client_ip,
+           std::shared_ptr<Counters> counters, std::chrono::milliseconds idle_timeout)
+        : m_loop(loop)
+        , m_client(client)
+        , m_target(target)
+        , m_client_ip(std::move(client_ip))
+        , m_counters(std::move(counters))
+        , m_idle_timeout(idle_timeout)
+    {
+        m_up.from = client;
+        m_up.to = target;
+        m_up.bytes = &m_counters->bytes_up;
+        m_down.from = target;
+        m_down.to = client;
+        m_down.bytes = &m_counters->bytes_down;
+        m_counters->active.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~Tunnel()
+    {
+        Release();
+    }
+
+    Tunnel(const Tunnel&) = delete;
+    Tunnel& operator=(const Tunnel&) = delete;
+
+    /**
+     * @brief Create the pipes (client thread, before the 200 goes out)
+     * @param pipe_size Requested capacity (0: kernel default)
+     */
+    bool Open(size_t pipe_size)
+    {
+        for (Direction* direction : {&m_up, &m_down})
+        {
+            if (pipe2(direction->pipe, O_NONBLOCK | O_CLOEXEC) != 0)
+            {
+                return false;
+            }
+            if (pipe_size > 0)
+            {
+                fcntl(direction->pipe[1], F_SETPIPE_SZ, static_cast<int>(pipe_size));
+            }
+            const int capacity = fcntl(direction->pipe[1], F_GETPIPE_SZ);
+            direction->capacity = capacity > 0 ? static_cast<size_t>(capacity) : 65536;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Register both sockets and arm the idle timer (loop thread)
+     */
+    void Start()
+    {
+        auto self = shared_from_this();
+        EventLoop::SetNonBlocking(m_client);
+        EventLoop::SetNonBlocking(m_target);
+        if (!m_loop.Watch(m_client, EventLoop::Readable, [self](uint32_t events) { self->OnEvents(self->m_client, events); }))
+        {
+            Terminate("unable to watch the client");
+            return;
+        }
+        m_client_interest = EventLoop::Readable;
+        if (!m_loop.Watch(m_target, EventLoop::Readable, [self](uint32_t events) { self->OnEvents(self->m_target, events); }))
+        {
+            Terminate("unable to watch the target");
+            return;
+        }
+        m_target_interest = EventLoop::Readable;
+        m_last_activity = std::chrono::steady_clock::now();
+        ScheduleIdleCheck(m_idle_timeout);
+    }
+
+private:
+    static constexpr uint32_t kUnwatched = ~0u;     ///< Interest of a socket no longer polled
+
+    /**
+     * @brief One direction: source socket -> pipe -> destination socket
+     */
+    struct Direction
+    {
+        SOCKET from = INVALID_SOCKET;
+        SOCKET to = INVALID_SOCKET;
+        int pipe[2] = {-1, -1};
+        size_t capacity = 0;                    ///< Pipe capacity in bytes
+        size_t buffered = 0;                    ///< Bytes in the pipe
+        bool eof = false;                       ///< Source reached end of stream
+        bool shut = false;                      ///< End of stream forwarded to the destination
+        uint64_t delivered = 0;                 ///< Bytes written to the destination
+        std::atomic<uint64_t>* bytes = nullptr; ///< Counter for delivered bytes
+    };
+
+    void OnEvents(SOCKET socket, uint32_t events)
+    {
+        if (m_closed)
+        {
+            return;
+        }
+        if (events & EventLoop::Shutdown)
+        {
+            Terminate("server shutting down");
+            return;
+        }
+        if (events & (EventLoop::Readable | EventLoop::Writable))
+        {
+            if (!Pump(m_up) || !Pump(m_down))
+            {
+                Terminate("connection error");
+                return;
+            }
+            if (m_up.shut && m_down.shut)
+            {
+                Terminate("both directions ended");
+                return;
+            }
+            UpdateInterest();
+        }
+        if (events & EventLoop::Error)
+        {
+            // A hang-up after our own half-close is orderly: the socket has nothing left to send to,
+            // and what it still has to read is pulled whenever the other side takes more
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0 ||
+                !(socket == m_client ? m_down.shut : m_up.shut))
+            {
+                Terminate("connection error");
+                return;
+            }
+            m_loop.Unwatch(socket);
+            (socket == m_client ? m_client_interest : m_target_interest) = kUnwatched;
+        }
+    }
+
+    /**
+     * @brief Move what both sockets allow without blocking
+     * @return false on a socket error
+     */
+    bool Pump(Direction& direction)
+    {
+        bool progress = true;
+        while (progress)
+        {
+            progress = false;
+            if (!direction.eof && direction.buffered < direction.capacity)
+            {
+                const ssize_t moved = splice(direction.from, nullptr, direction.pipe[1], nullptr,
+                                             direction.capacity - direction.buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (moved > 0)
+                {
+                    direction.buffered += static_cast<size_t>(moved);
+                    progress = true;
+                }
+                else if (moved == 0)
+                {
+                    direction.eof = true;
+                }
+                else if (errno != EAGAIN && errno != EINTR)
+                {
+                    return false;
+                }
+            }
+            if (direction.buffered > 0)
+            {
+                const ssize_t moved = splice(direction.pipe[0], nullptr, direction.to, nullptr, direction.buffered,
+                                             SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (moved > 0)
+                {
+                    direction.buffered -= static_cast<size_t>(moved);
+                    direction.delivered += static_cast<uint64_t>(moved);
+                    direction.bytes->fetch_add(static_cast<uint64_t>(moved), std::memory_order_relaxed);
+                    m_last_activity = std::chrono::steady_clock::now();
+                    progress = true;
+                }
+                else if (moved < 0 && errno != EAGAIN && errno != EINTR)
+                {
+                    return false;
+                }
+            }
+        }
+
+        // The peer finished sending and everything reached the other side: pass the half-close on
+        if (direction.eof && direction.buffered == 0 && !direction.shut)
+        {
+            shutdown(direction.to, SHUT_WR);
+            direction.shut = true;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Read only into empty pipes; wait for writability only while a pipe holds bytes
+     */
+    void UpdateInterest()
+    {
+        const auto interest = [](const Direction& reading, const Direction& writing)
+        {
+            uint32_t events = 0;
+            if (!reading.eof && reading.buffered == 0)
+            {
+                events |= EventLoop::Readable;
+            }
+            if (writing.buffered > 0)
+            {
+                events |= EventLoop::Writable;
+            }
+            return events;
+        };
+        const uint32_t client = interest(m_up, m_down);
+        const uint32_t target = interest(m_down, m_up);
+        if (m_client_interest != kUnwatched && client != m_client_interest)
+        {
+            m_loop.Modify(m_client, client);
+            m_client_interest = client;
+        }
+        if (m_target_interest != kUnwatched && target != m_target_interest)
+        {
+            m_loop.Modify(m_target, target);
+            m_target_interest = target;
+        }
+    }
+
+    void ScheduleIdleCheck(std::chrono::milliseconds delay)
+    {
+        std::weak_ptr<Tunnel> weak = shared_from_this();
+        m_idle_timer = m_loop.AddTimer(delay, [weak]()
+        {
+            auto self = weak.lock();
+            if (!self || self->m_closed)
+            {
+                return;
+            }
+            self->m_idle_timer = 0;
+            const auto idle = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - self->m_last_activity);
+            if (idle >= self->m_idle_timeout)
+            {
+                self->m_counters->idle_closed.fetch_add(1, std::memory_order_relaxed);
+                self->Terminate("idle timeout");
+                return;
+            }
+            self->ScheduleIdleCheck(self->m_idle_timeout - idle);
+        });
+    }
+
+    void Terminate(const char* reason)
+    {
+        if (m_closed)
+        {
+            return;
+        }
+        if (m_idle_timer != 0)
+        {
+            m_loop.CancelTimer(m_idle_timer);
+            m_idle_timer = 0;
+        }
+
+        // Keep the tunnel alive until the watchers holding it are gone
+        auto self = shared_from_this();
+        m_loop.Unwatch(m_client);
+        m_loop.Unwatch(m_target);
+        LOG_DEBUG_FMT(ConnectTunnel, "Tunnel from {} closed ({}): {} bytes up, {} bytes down", m_client_ip, reason,
+                      m_up.delivered, m_down.delivered);
+        Release();
+    }
+
+    /**
+     * @brief Close the sockets and pipes once
+     */
+    void Release()
+    {
+        if (m_closed)
+        {
+            return;
+        }
+        m_closed = true;
+        CloseSocketHandle(m_client);
+        CloseSocketHandle(m_target);
+        for (Direction* direction : {&m_up, &m_down})
+        {
+            for (int& descriptor : direction->pipe)
+            {
+                if (descriptor >= 0)
+                {
+                    close(descriptor);
+                    descriptor = -1;
+                }
+            }
+        }
+        m_counters->active.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    EventLoop& m_loop;
+    SOCKET m_client;
+    SOCKET m_target;
+    std::string m_client_ip;
+    std::shared_ptr<Counters> m_counters;
+    std::chrono::milliseconds m_idle_timeout;
+    Direction m_up;                                         ///< Client to target
+    Direction m_down;                                       ///< Target to client
+    uint32_t m_client_interest = 0;
+    uint32_t m_target_interest = 0;
+    bool m_closed = false;
+    EventLoop::TimerId m_idle_timer = 0;
+    std::chrono::steady_clock::time_point m_last_activity;
+};
+
+#endif
+
+ConnectProxy::ConnectProxy(EventLoop& loop, const ConnectTunnelOptions& options)
+    : m_loop(loop)
+    , m_options(options)
+    , m_counters(std::make_shared<Counters>())
+{
+}
+
+bool ConnectProxy::IsConnectRequest(std::string_view head)
+{
+    return head.compare(0, 8, "CONNECT ") == 0;
+}
+
+bool ConnectProxy::Allows(const std::string& host, int port) const
+{
+    const auto same_host = [&host](const std::string& allowed)
+    {
+        return allowed.size() == host.size() && std::equal(allowed.begin(), allowed.end(), host.begin(), [](char a, char b)
+        {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+    };
+    return std::any_of(m_options.allowed_hosts.begin(), m_options.allowed_hosts.end(), same_host) &&
+           (m_options.allowed_ports.empty() ||
+            std::find(m_options.allowed_ports.begin(), m_options.allowed_ports.end(), port) != m_options.allowed_ports.end());
+}
+
+ConnectTunnelStats ConnectProxy::GetStats() const
+{
+    ConnectTunnelStats stats;
+    stats.opened = m_counters->opened.load();
+    stats.refused = m_counters->refused.load();
+    stats.failed = m_counters->failed.load();
+    stats.active = m_counters->active.load();
+    stats.idle_closed = m_counters->idle_closed.load();
+    stats.bytes_up = m_counters->bytes_up.load();
+    stats.bytes_down = m_counters->bytes_down.load();
+    return stats;
+}
+
+PassthroughResult ConnectProxy::Serve(SOCKET client_socket, std::string& buffer, size_t head_size,
+                                      const std::string& client_ip)
+{
+    const std::string_view head = std::string_view(buffer).substr(0, head_size);
+    if (!IsConnectRequest(head))
+    {
+        return PassthroughResult::Declined;
+    }
+
+    // "CONNECT host:port HTTP/1.x"
+    const size_t line_end = head.find("\r\n");
+    const std::string_view line = head.substr(0, line_end);
+    const size_t target_end = line.find(' ', 8);
+    std::string host;
+    int port = 0;
+    if (target_end == std::string_view::npos || line.compare(target_end + 1, 7, "HTTP/1.") != 0 ||
+        !ParseAuthority(line.substr(8, target_end - 8), host, port))
+    {
+        m_counters->refused.fetch_add(1, std::memory_order_relaxed);
+        return Reject(client_socket, http::StatusCode::BadRequest);
+    }
+    if (!Allows(host, port))
+    {
+        LOG_WARN_FMT(ConnectTunnel, "Refused CONNECT {}:{} from {}", host, port, client_ip);
+        m_counters->refused.fetch_add(1, std::memory_order_relaxed);
+        return Reject(client_socket, http::StatusCode::Forbidden);
+    }
+
+#if defined(__linux__)
+    const SOCKET target = ConnectTarget(host, port, m_options.connect_timeout);
+    if (target == INVALID_SOCKET)
+    {
+        LOG_WARN_FMT(ConnectTunnel, "CONNECT {}:{} from {}: target unreachable", host, port, client_ip);
+        m_counters->failed.fetch_add(1, std::memory_order_relaxed);
+        return Reject(client_socket, http::StatusCode::BadGateway);
+    }
+    auto tunnel = std::make_shared<Tunnel>(m_loop, client_socket, target, client_ip, m_counters, m_options.idle_timeout);
+    if (!tunnel->Open(m_options.pipe_size))
+    {
+        LOG_ERROR_FMT(ConnectTunnel, "Cannot create tunnel pipes: {}", std::strerror(errno));
+        // The tunnel owns both sockets now and closes them when it goes away
+        m_counters->failed.fetch_add(1, std::memory_order_relaxed);
+        Reject(client_socket, http::StatusCode::ServiceUnavailable);
+        return PassthroughResult::Detached;
+    }
+
+    // Bytes the client sent after the head (a TLS ClientHello, say) go to the target before the loop takes over
+    buffer.erase(0, head_size);
+    if (!SendAll(client_socket, kEstablished, sizeof(kEstablished) - 1) ||
+        (!buffer.empty() && !SendAll(target, buffer.data(), buffer.size())))
+    {
+        return PassthroughResult::Detached;
+    }
+    m_counters->bytes_up.fetch_add(buffer.size(), std::memory_order_relaxed);
+    buffer.clear();
+    m_counters->opened.fetch_add(1, std::memory_order_relaxed);
+    LOG_DEBUG_FMT(ConnectTunnel, "Tunnel from {} to {}:{}", client_ip, host, port);
+
+    m_loop.Post([tunnel]()
+    {
+        tunnel->Start();
+    });
+    return PassthroughResult::Detached;
+#else
+    return Reject(client_socket, http::StatusCode::NotImplemented);
+#endif
+}
+
+} // namespace miniserver::network
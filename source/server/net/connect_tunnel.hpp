@@ -0,0 +1,118 @@
+/**
+ * @file connect_tunnel.hpp
+ * @brief HTTP CONNECT tunnels relayed on the event loop with splice()
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/event_loop.hpp"
+#include "net/socket_server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Which CONNECT targets are allowed, and tunnel timers
+ */
+struct ConnectTunnelOptions
+{
+    bool enabled = false;                                               ///< Answer CONNECT (otherwise 405)
+    std::vector<std::string> allowed_hosts = {"localhost", "127.0.0.1", "::1"}; ///< Target hosts as written in the request
+    std::vector<int> allowed_ports;                                     ///< Target ports (empty: any)
+    std::chrono::milliseconds connect_timeout{5000};                    ///< Give up connecting to the target (502)
+    std::chrono::milliseconds idle_timeout{300000};                     ///< Close a tunnel with no bytes either way this long
+    size_t pipe_size = 0;                                               ///< F_SETPIPE_SZ per direction (0: kernel default)
+};
+
+/**
+ * @brief CONNECT tunnel counters
+ */
+struct ConnectTunnelStats
+{
+    uint64_t opened = 0;            ///< Tunnels established (200 sent)
+    uint64_t refused = 0;           ///< Targets outside the allow-list (403) or malformed (400)
+    uint64_t failed = 0;            ///< Targets that could not be resolved or reached (502)
+    uint64_t active = 0;            ///< Tunnels open now
+    uint64_t idle_closed = 0;       ///< Tunnels closed by the idle timeout
+    uint64_t bytes_up = 0;          ///< Client to target
+    uint64_t bytes_down = 0;        ///< Target to client
+};
+
+/**
+ * @brief Forward tunnel for "CONNECT host:port" requests
+ *
+ * Offered request heads as a pass-through handler. The client thread checks
+ * the target against the allow-list, connects with a timeout and answers
+ * "200 Connection Established"; from then on both sockets belong to a tunnel
+ * on the event loop and the client thread is free. Each direction moves
+ * bytes socket -> pipe -> socket with splice(), so the payload never enters
+ * user space. A direction stops reading while its pipe holds bytes the other
+ * side cannot take yet, end of stream is forwarded as a half-close, and the
+ * tunnel closes once both directions have ended, on an error, or after the
+ * idle timeout.
+ *
+ * @details splice() is Linux-only; elsewhere CONNECT is answered 501.
+ */
+class ConnectProxy
+{
+public:
+    /**
+     * @brief Constructor
+     * @param loop Event loop the tunnels run on (must outlive them)
+     * @param options Allow-list and timers
+     */
+    ConnectProxy(EventLoop& loop, const ConnectTunnelOptions& options);
+
+    ConnectProxy(const ConnectProxy&) = delete;
+    ConnectProxy& operator=(const ConnectProxy&) = delete;
+
+    /**
+     * @brief Pass-through handler body: open a tunnel for a CONNECT request
+     * @param client_socket Client connection
+     * @param buffer Receive buffer starting with the request head
+     * @param head_size Length of the request head
+     * @param client_ip Peer address
+     * @return Declined for other methods, Detached once the tunnel owns the socket, Close after an error response
+     */
+    PassthroughResult Serve(SOCKET client_socket, std::string& buffer, size_t head_size, const std::string& client_ip);
+
+    /**
+     * @brief Check whether a request head starts with the CONNECT method
+     */
+    static bool IsConnectRequest(std::string_view head);
+
+    /**
+     * @brief Settings
+     */
+    const ConnectTunnelOptions& GetOptions() const { return m_options; }
+
+    /**
+     * @brief Counters snapshot
+     */
+    ConnectTunnelStats GetStats() const;
+
+private:
+    class Tunnel;
+    struct Counters;
+
+    /**
+     * @brief Check a target against the allow-list
+     */
+    bool Allows(const std::string& host, int port) const;
+
+    EventLoop& m_loop;                              ///< Runs the tunnels
+    ConnectTunnelOptions m_options;                 ///< Allow-list and timers
+    std::shared_ptr<Counters> m_counters;           ///< Shared with the tunnels, which outlive Serve
+};
+
+} // namespace miniserver::network
@@ -0,0 +1,205 @@
+/**
+ * @file connection_migration.cpp
+ * @brief Connection migration channel implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/connection_migration.hpp"
+#include "utils/logger.hpp"
+
+#include <cstring>
+#include <utility>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace miniserver::network
+{
+
+MigrationChannel::~MigrationChannel()
+{
+    Close();
+}
+
+MigrationChannel::MigrationChannel(MigrationChannel&& other) noexcept
+    : m_receiver(std::exchange(other.m_receiver, -1))
+    , m_sender(std::exchange(other.m_sender, -1))
+{
+}
+
+MigrationChannel& MigrationChannel::operator=(MigrationChannel&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_receiver = std::exchange(other.m_receiver, -1);
+        m_sender = std::exchange(other.m_sender, -1);
+    }
+    return *this;
+}
+
+bool MigrationChannel::Open()
+{
+#ifndef _WIN32
+    Close();
+    int ends[2];
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, ends) != 0)
+    {
+        LOG_ERROR_FMT(MigrationChannel, "Cannot create a migration channel: {}", std::strerror(errno));
+        return false;
+    }
+    for (int end : ends)
+    {
+        fcntl(end, F_SETFD, FD_CLOEXEC);
+        fcntl(end, F_SETFL, fcntl(end, F_GETFL) | O_NONBLOCK);
+    }
+    m_receiver = ends[0];
+    m_sender = ends[1];
+    return true;
+#else
+    LOG_ERROR(MigrationChannel, "Connection migration needs SCM_RIGHTS");
+    return false;
+#endif
+}
+
+void MigrationChannel::Close()
+{
+    CloseReceiver();
+#ifndef _WIN32
+    if (m_sender >= 0)
+    {
+        close(m_sender);
+    }
+#endif
+    m_sender = -1;
+}
+
+void MigrationChannel::CloseReceiver()
+{
+#ifndef _WIN32
+    if (m_receiver >= 0)
+    {
+        close(m_receiver);
+    }
+#endif
+    m_receiver = -1;
+}
+
+bool MigrationChannel::Send(const MigratedConnection& connection) const
+{
+#ifndef _WIN32
+    if (m_sender < 0 || connection.buffered.size() > kMaxBuffered)
+    {
+        return false;
+    }
+
+    // "listener\nclient_ip\n" followed by the buffered bytes
+    std::string message = connection.listener + '\n' + connection.client_ip + '\n';
+    message += connection.buffered;
+
+    iovec vector{message.data(), message.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr header{};
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+    cmsghdr* rights = CMSG_FIRSTHDR(&header);
+    rights->cmsg_level = SOL_SOCKET;
+    rights->cmsg_type = SCM_RIGHTS;
+    rights->cmsg_len = CMSG_LEN(sizeof(int));
+    const int descriptor = connection.socket;
+    std::memcpy(CMSG_DATA(rights), &descriptor, sizeof(int));
+
+    // Nonblocking: a full queue means the receiver is behind, so it is not the place to send load to
+    if (sendmsg(m_sender, &header, MSG_DONTWAIT | MSG_NOSIGNAL) != static_cast<ssize_t>(message.size()))
+    {
+        return false;
+    }
+    close(connection.socket);
+    return true;
+#else
+    (void)connection;
+    return false;
+#endif
+}
+
+bool MigrationChannel::Receive(MigratedConnection& connection, std::chrono::milliseconds timeout) const
+{
+#ifndef _WIN32
+    if (m_receiver < 0)
+    {
+        return false;
+    }
+    pollfd entry{m_receiver, POLLIN, 0};
+    if (poll(&entry, 1, static_cast<int>(timeout.count())) <= 0)
+    {
+        return false;
+    }
+
+    std::string message(kMaxBuffered + 1024, '\0');
+    iovec vector{message.data(), message.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr header{};
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+    const ssize_t received = recvmsg(m_receiver, &header, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (received < 0)
+    {
+        return false;
+    }
+
+    int descriptor = -1;
+    for (cmsghdr* rights = CMSG_FIRSTHDR(&header); rights; rights = CMSG_NXTHDR(&header, rights))
+    {
+        if (rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS && rights->cmsg_len == CMSG_LEN(sizeof(int)))
+        {
+            std::memcpy(&descriptor, CMSG_DATA(rights), sizeof(int));
+        }
+    }
+    message.resize(static_cast<size_t>(received));
+    const size_t first = message.find('\n');
+    const size_t second = first == std::string::npos ? std::string::npos : message.find('\n', first + 1);
+    if (descriptor < 0 || second == std::string::npos || (header.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0)
+    {
+        LOG_WARN(MigrationChannel, "Dropping a malformed migration message");
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+        return false;
+    }
+
+    connection.listener = message.substr(0, first);
+    connection.client_ip = message.substr(first + 1, second - first - 1);
+    connection.buffered = message.substr(second + 1);
+    connection.socket = descriptor;
+    return true;
+#else
+    (void)connection;
+    (void)timeout;
+    return false;
+#endif
+}
+
+void MigrationChannel::Discard(const MigratedConnection& connection)
+{
+#ifndef _WIN32
+    if (connection.socket != INVALID_SOCKET)
+    {
+        close(connection.socket);
+    }
+#else
+    (void)connection;
+#endif
+}
+
+} // namespace miniserver::network
@@ -0,0 +1,101 @@
+/**
+ * @file connection_migration.hpp
+ * @brief Passing idle keep-alive connections between sibling worker processes
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/socket_server.hpp"
+
+#include <chrono>
+#include <string>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Keep-alive connection moving to another process, with what its new owner needs
+ */
+struct MigratedConnection
+{
+    std::string listener;                   ///< Name of the listener that accepted it
+    SOCKET socket = INVALID_SOCKET;         ///< Connected socket
+    std::string client_ip;                  ///< Peer address (for logs)
+    std::string buffered;                   ///< Bytes received past the last request (pipelined requests)
+};
+
+/**
+ * @brief One-way channel handing connections to a worker process
+ *
+ * A SOCK_DGRAM socketpair created before the workers are forked: every
+ * worker holds the sending end, the receiving worker the other end. Each
+ * message is one datagram carrying the socket (SCM_RIGHTS) and its state,
+ * so messages from several senders never interleave. Sockets in flight are
+ * owned by the channel: if the receiver dies, its replacement inherits the
+ * receiving end and the queued connections with it.
+ *
+ * @details POSIX only; Open fails elsewhere.
+ */
+class MigrationChannel
+{
+public:
+    static constexpr size_t kMaxBuffered = 16 * 1024;   ///< Larger pipelined backlogs are served where they are
+
+    MigrationChannel() = default;
+    ~MigrationChannel();
+
+    MigrationChannel(const MigrationChannel&) = delete;
+    MigrationChannel& operator=(const MigrationChannel&) = delete;
+    MigrationChannel(MigrationChannel&& other) noexcept;
+    MigrationChannel& operator=(MigrationChannel&& other) noexcept;
+
+    /**
+     * @brief Create the socketpair
+     * @return false on failure (the reason is logged)
+     */
+    bool Open();
+
+    /**
+     * @brief Close both ends
+     */
+    void Close();
+
+    /**
+     * @brief Close the receiving end (in processes that only send)
+     */
+    void CloseReceiver();
+
+    /**
+     * @brief Pass a connection without blocking
+     * @param connection Connection to pass; on success this process's descriptor is closed
+     * @return false if the channel is full or the state too large (the caller keeps the connection)
+     */
+    bool Send(const MigratedConnection& connection) const;
+
+    /**
+     * @brief Take the next connection
+     * @param connection Receives the connection; its socket is owned by the caller
+     * @param timeout Longest wait
+     * @return false if none arrived in time
+     */
+    bool Receive(MigratedConnection& connection, std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief Close the socket of a received connection nobody will serve
+     * @param connection Received connection
+     */
+    static void Discard(const MigratedConnection& connection);
+
+    /**
+     * @brief Check whether the channel is open
+     */
+    bool IsOpen() const { return m_receiver >= 0 || m_sender >= 0; }
+
+private:
+    int m_receiver = -1;    ///< Receiving end
+    int m_sender = -1;      ///< Sending end
+};
+
+} // namespace miniserver::network
@@ -0,0 +1,452 @@
+/**
+ * @file event_loop.cpp
+ * @brief Readiness-based event loop implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/event_loop.hpp"
+#include "utils/logger.hpp"
+
+#include <stdexcept>
+
+#if defined(__linux__)
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+#elif defined(_WIN32)
+    #include <winsock2.h>
+#else
+    #include <poll.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+    constexpr int kMaxEventsPerPoll = 256;
+
+#if defined(__linux__)
+    uint32_t ToEpollEvents(uint32_t events)
+    {
+        uint32_t result = 0;
+        if (events & EventLoop::Readable) result |= EPOLLIN | EPOLLRDHUP;
+        if (events & EventLoop::Writable) result |= EPOLLOUT;
+        return result;
+    }
+#endif
+}
+
+EventLoop::EventLoop()
+{
+#if defined(__linux__)
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll_fd < 0 || m_wakeup_fd < 0)
+    {
+        if (m_epoll_fd >= 0) close(m_epoll_fd);
+        if (m_wakeup_fd >= 0) close(m_wakeup_fd);
+        throw std::runtime_error("Unable to create event loop");
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_wakeup_fd;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wakeup_fd, &event);
+#elif defined(_WIN32)
+    // A UDP socket connected to itself serves as the wakeup channel
+    m_wakeup_read = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int length = sizeof(address);
+    if (m_wakeup_read == INVALID_SOCKET ||
+        bind(m_wakeup_read, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        getsockname(m_wakeup_read, reinterpret_cast<sockaddr*>(&address), &length) != 0 ||
+        connect(m_wakeup_read, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        throw std::runtime_error("Unable to create event loop");
+    }
+    m_wakeup_write = m_wakeup_read;
+    SetNonBlocking(m_wakeup_read);
+#else
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        throw std::runtime_error("Unable to create event loop");
+    }
+    m_wakeup_read = fds[0];
+    m_wakeup_write = fds[1];
+    SetNonBlocking(m_wakeup_read);
+    SetNonBlocking(m_wakeup_write);
+#endif
+}
+
+EventLoop::~EventLoop()
+{
+    Stop();
+
+#if defined(__linux__)
+    close(m_epoll_fd);
+    close(m_wakeup_fd);
+#elif defined(_WIN32)
+    closesocket(m_wakeup_read);
+#else
+    close(m_wakeup_read);
+    close(m_wakeup_write);
+#endif
+}
+
+bool EventLoop::Start()
+{
+    if (m_running.exchange(true))
+    {
+        return false;
+    }
+
+    m_thread = std::thread(&EventLoop::Loop, this);
+    LOG_INFO(EventLoop, "Event loop started");
+    return true;
+}
+
+void EventLoop::Stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    Wakeup();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    LOG_INFO(EventLoop, "Event loop stopped");
+}
+
+bool EventLoop::IsRunning() const
+{
+    return m_running.load();
+}
+
+bool EventLoop::IsInLoopThread() const
+{
+    return m_loop_thread_id.load() == std::this_thread::get_id();
+}
+
+void EventLoop::Post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_tasks_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    Wakeup();
+}
+
+bool EventLoop::Watch(SOCKET socket, uint32_t events, IoCallback callback)
+{
+    auto watcher = std::make_shared<Watcher>();
+    watcher->events = events;
+    watcher->callback = std::move(callback);
+
+#if defined(__linux__)
+    epoll_event event{};
+    event.events = ToEpollEvents(events);
+    event.data.fd = socket;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, socket, &event) != 0)
+    {
+        LOG_ERROR(EventLoop, "epoll_ctl(ADD) failed for socket " + std::to_string(socket));
+        return false;
+    }
+#endif
+
+    m_watchers[socket] = std::move(watcher);
+    m_watch_count.store(m_watchers.size());
+    return true;
+}
+
+bool EventLoop::Modify(SOCKET socket, uint32_t events)
+{
+    auto it = m_watchers.find(socket);
+    if (it == m_watchers.end())
+    {
+        return false;
+    }
+    if (it->second->events == events)
+    {
+        return true;
+    }
+    it->second->events = events;
+
+#if defined(__linux__)
+    epoll_event event{};
+    event.events = ToEpollEvents(events);
+    event.data.fd = socket;
+    return epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, socket, &event) == 0;
+#else
+    return true;
+#endif
+}
+
+void EventLoop::Unwatch(SOCKET socket)
+{
+    if (m_watchers.erase(socket) == 0)
+    {
+        return;
+    }
+    m_watch_count.store(m_watchers.size());
+
+#if defined(__linux__)
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, socket, nullptr);
+#endif
+}
+
+EventLoop::TimerId EventLoop::AddTimer(std::chrono::milliseconds delay, Task task)
+{
+    const TimerId id = m_next_timer_id++;
+    m_timers.emplace(id, std::move(task));
+    m_timer_queue.emplace(Clock::now() + delay, id);
+    return id;
+}
+
+void EventLoop::CancelTimer(TimerId id)
+{
+    // The queue entry is skipped when it fires
+    m_timers.erase(id);
+}
+
+bool EventLoop::SetNonBlocking(SOCKET socket)
+{
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    const int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+void EventLoop::Loop()
+{
+    m_loop_thread_id.store(std::this_thread::get_id());
+
+    while (m_running.load())
+    {
+        PollOnce();
+        RunExpiredTimers();
+        RunPendingTasks();
+    }
+
+    // Let tasks posted before Stop() run, then release every watcher
+    RunPendingTasks();
+    auto watchers = m_watchers;
+    for (const auto& [socket, watcher] : watchers)
+    {
+        try
+        {
+            watcher->callback(Shutdown);
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR(EventLoop, std::string("Watcher shutdown failed: ") + e.what());
+        }
+    }
+    RunPendingTasks();
+
+    m_watchers.clear();
+    m_watch_count.store(0);
+    m_timers.clear();
+    m_timer_queue.clear();
+    m_loop_thread_id.store(std::thread::id());
+}
+
+void EventLoop::PollOnce()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_tasks_mutex);
+        if (!m_tasks.empty())
+        {
+            return;
+        }
+    }
+    const int timeout_ms = NextTimeoutMs();
+
+#if defined(__linux__)
+    epoll_event events[kMaxEventsPerPoll];
+    const int count = epoll_wait(m_epoll_fd, events, kMaxEventsPerPoll, timeout_ms);
+    for (int i = 0; i < count; ++i)
+    {
+        const int fd = events[i].data.fd;
+        if (fd == m_wakeup_fd)
+        {
+            DrainWakeup();
+            continue;
+        }
+
+        uint32_t ready = 0;
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP)) ready |= Readable;
+        if (events[i].events & EPOLLOUT) ready |= Writable;
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) ready |= Error;
+        Dispatch(fd, ready);
+    }
+#else
+    #ifdef _WIN32
+        std::vector<WSAPOLLFD> fds;
+    #else
+        std::vector<pollfd> fds;
+    #endif
+    fds.reserve(m_watchers.size() + 1);
+    fds.push_back({m_wakeup_read, POLLIN, 0});
+    for (const auto& [socket, watcher] : m_watchers)
+    {
+        short events = 0;
+        if (watcher->events & Readable) events |= POLLIN;
+        if (watcher->events & Writable) events |= POLLOUT;
+        fds.push_back({socket, events, 0});
+    }
+
+    #ifdef _WIN32
+        const int count = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout_ms);
+    #else
+        const int count = poll(fds.data(), fds.size(), timeout_ms);
+    #endif
+    if (count <= 0)
+    {
+        return;
+    }
+    if (fds[0].revents & POLLIN)
+    {
+        DrainWakeup();
+    }
+    for (size_t i = 1; i < fds.size(); ++i)
+    {
+        uint32_t ready = 0;
+        if (fds[i].revents & POLLIN) ready |= Readable;
+        if (fds[i].revents & POLLOUT) ready |= Writable;
+        if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) ready |= Error;
+        if (ready != 0)
+        {
+            Dispatch(fds[i].fd, ready);
+        }
+    }
+#endif
+}
+
+void EventLoop::Dispatch(SOCKET socket, uint32_t events)
+{
+    auto it = m_watchers.find(socket);
+    if (it == m_watchers.end())
+    {
+        return;
+    }
+
+    // Hold a reference: the callback may unwatch (and free) itself
+    const auto watcher = it->second;
+    try
+    {
+        watcher->callback(events);
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR(EventLoop, std::string("Event callback failed: ") + e.what());
+    }
+}
+
+void EventLoop::Wakeup()
+{
+#if defined(__linux__)
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = write(m_wakeup_fd, &one, sizeof(one));
+#elif defined(_WIN32)
+    const char byte = 1;
+    send(m_wakeup_write, &byte, 1, 0);
+#else
+    const char byte = 1;
+    [[maybe_unused]] const ssize_t written = write(m_wakeup_write, &byte, 1);
+#endif
+}
+
+void EventLoop::DrainWakeup()
+{
+#if defined(__linux__)
+    uint64_t value;
+    [[maybe_unused]] const ssize_t received = read(m_wakeup_fd, &value, sizeof(value));
+#else
+    char buffer[64];
+    #ifdef _WIN32
+        while (recv(m_wakeup_read, buffer, sizeof(buffer), 0) > 0) {}
+    #else
+        while (read(m_wakeup_read, buffer, sizeof(buffer)) > 0) {}
+    #endif
+#endif
+}
+
+void EventLoop::RunPendingTasks()
+{
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_tasks_mutex);
+        tasks.swap(m_tasks);
+    }
+
+    for (auto& task : tasks)
+    {
+        try
+        {
+            task();
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR(EventLoop, std::string("Posted task failed: ") + e.what());
+        }
+    }
+}
+
+void EventLoop::RunExpiredTimers()
+{
+    const auto now = Clock::now();
+    while (!m_timer_queue.empty() && m_timer_queue.begin()->first <= now)
+    {
+        const TimerId id = m_timer_queue.begin()->second;
+        m_timer_queue.erase(m_timer_queue.begin());
+
+        auto it = m_timers.find(id);
+        if (it == m_timers.end())
+        {
+            continue; // cancelled
+        }
+        Task task = std::move(it->second);
+        m_timers.erase(it);
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR(EventLoop, std::string("Timer task failed: ") + e.what());
+        }
+    }
+}
+
+int EventLoop::NextTimeoutMs() const
+{
+    if (m_timer_queue.empty())
+    {
+        return -1;
+    }
+
+    const auto delay = m_timer_queue.begin()->first - Clock::now();
+    if (delay <= Clock::duration::zero())
+    {
+        return 0;
+    }
+    // Round up so the timer has expired when the wait returns
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(delay).count()) + 1;
+}
+
+} // namespace miniserver::network
@@ -0,0 +1,224 @@
+/**
+ * @file event_loop.hpp
+ * @brief Readiness-based event loop for long-lived connections
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/socket_server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Single-threaded I/O event loop
+ *
+ * Multiplexes many non-blocking sockets on one thread using epoll on Linux
+ * and poll() elsewhere. Connections that stay open for a long time while
+ * mostly idle (WebSocket, server-sent events) are parked here instead of
+ * occupying a thread each.
+ *
+ * @details
+ * Watch/Modify/Unwatch and timers must be used from the loop thread; other
+ * threads hand work to the loop with Post(). Callbacks run on the loop thread
+ * and must not block.
+ */
+class EventLoop
+{
+public:
+    /**
+     * @brief Readiness flags passed to I/O callbacks
+     */
+    enum Events : uint32_t
+    {
+        Readable = 1u << 0,     ///< Data (or EOF) can be read
+        Writable = 1u << 1,     ///< Socket send buffer has room
+        Error    = 1u << 2,     ///< Error or hang-up reported by the kernel
+        Shutdown = 1u << 3      ///< The loop is stopping; release the socket
+    };
+
+    using IoCallback = std::function<void(uint32_t events)>;
+    using Task = std::function<void()>;
+    using TimerId = uint64_t;
+
+    /**
+     * @brief Create the poller and wakeup channel
+     * @throws std::runtime_error If the poller cannot be created
+     */
+    EventLoop();
+
+    /**
+     * @brief Stops the loop if still running
+     */
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief Start the loop thread
+     * @return true if started (false if already running)
+     */
+    bool Start();
+
+    /**
+     * @brief Stop the loop thread
+     *
+     * Every watcher receives a final Shutdown event on the loop thread before
+     * the thread exits. Must not be called from the loop thread.
+     */
+    void Stop();
+
+    /**
+     * @brief Running state
+     */
+    bool IsRunning() const;
+
+    /**
+     * @brief Check whether the caller is the loop thread
+     */
+    bool IsInLoopThread() const;
+
+    /**
+     * @brief Queue a task to run on the loop thread (thread-safe)
+     * @param task Task to run
+     */
+    void Post(Task task);
+
+    /**
+     * @brief Start watching a non-blocking socket
+     * @param socket Socket descriptor
+     * @param events Readable and/or Writable
+     * @param callback Invoked with the ready flags
+     * @return true if registered
+     */
+    bool Watch(SOCKET socket, uint32_t events, IoCallback callback);
+
+    /**
+     * @brief Change the events watched for a socket
+     * @param socket Socket descriptor
+     * @param events Readable and/or Writable
+     * @return true if updated
+     */
+    bool Modify(SOCKET socket, uint32_t events);
+
+    /**
+     * @brief Stop watching a socket (the socket is not closed)
+     * @param socket Socket descriptor
+     */
+    void Unwatch(SOCKET socket);
+
+    /**
+     * @brief Run a task once after a delay (loop thread only)
+     * @param delay Delay from now
+     * @param task Task to run
+     * @return Timer identifier for CancelTimer
+     */
+    TimerId AddTimer(std::chrono::milliseconds delay, Task task);
+
+    /**
+     * @brief Cancel a pending timer (loop thread only)
+     * @param id Timer identifier
+     */
+    void CancelTimer(TimerId id);
+
+    /**
+     * @brief Number of watched sockets
+     */
+    size_t GetWatchCount() const { return m_watch_count.load(); }
+
+    /**
+     * @brief Put a socket into non-blocking mode
+     * @param socket Socket descriptor
+     * @return true on success
+     */
+    static bool SetNonBlocking(SOCKET socket);
+
+private:
+    /**
+     * @brief Registered socket
+     */
+    struct Watcher
+    {
+        uint32_t events = 0;                ///< Watched events
+        IoCallback callback;                ///< Event callback
+    };
+
+    /**
+     * @brief Loop thread body
+     */
+    void Loop();
+
+    /**
+     * @brief Wait for I/O (bounded by the next timer) and dispatch callbacks
+     */
+    void PollOnce();
+
+    /**
+     * @brief Wake the loop thread from Post() or Stop()
+     */
+    void Wakeup();
+
+    /**
+     * @brief Drain the wakeup channel
+     */
+    void DrainWakeup();
+
+    /**
+     * @brief Run all queued tasks
+     */
+    void RunPendingTasks();
+
+    /**
+     * @brief Run timers whose deadline has passed
+     */
+    void RunExpiredTimers();
+
+    /**
+     * @brief Milliseconds until the next timer, or -1 if none
+     */
+    int NextTimeoutMs() const;
+
+    /**
+     * @brief Dispatch events to a watcher
+     */
+    void Dispatch(SOCKET socket, uint32_t events);
+
+    std::atomic<bool> m_running{false};                                 ///< Loop running state
+    std::thread m_thread;                                               ///< Loop thread
+    std::atomic<std::thread::id> m_loop_thread_id{};                    ///< Loop thread id
+
+    std::mutex m_tasks_mutex;                                           ///< Protects m_tasks
+    std::vector<Task> m_tasks;                                          ///< Tasks posted from other threads
+
+    std::unordered_map<SOCKET, std::shared_ptr<Watcher>> m_watchers;   ///< Watched sockets (loop thread)
+    std::atomic<size_t> m_watch_count{0};                               ///< Mirror of m_watchers.size()
+
+    using Clock = std::chrono::steady_clock;
+    std::multimap<Clock::time_point, TimerId> m_timer_queue;            ///< Deadlines (loop thread)
+    std::unordered_map<TimerId, Task> m_timers;                         ///< Pending timer tasks
+    TimerId m_next_timer_id = 1;                                        ///< Next timer identifier
+
+#if defined(__linux__)
+    int m_epoll_fd = -1;                                                ///< epoll instance
+    int m_wakeup_fd = -1;                                               ///< eventfd used for wakeups
+#else
+    SOCKET m_wakeup_read = INVALID_SOCKET;                              ///< Wakeup channel, read side
+    SOCKET m_wakeup_write = INVALID_SOCKET;                             ///< Wakeup channel, write side
+#endif
+};
+
+} // namespace miniserver::network
@@ -0,0 +1,317 @@
+/**
+ * @file event_stream.cpp
+ * @brief Server-Sent Events broadcast channel implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/event_stream.hpp"
+#include "utils/logger.hpp"
+
+#include <cerrno>
+#include <vector>
+
+#ifndef _WIN32
+    #include <sys/uio.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+    constexpr size_t kMaxIovecs = 64;       ///< Buffers gathered per send call
+
+#ifdef MSG_NOSIGNAL
+    constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kSendFlags = 0;
+#endif
+
+    bool WouldBlock()
+    {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+    }
+
+    void CloseSocketHandle(SOCKET socket)
+    {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    /**
+     * @brief Append "name: value" lines, one per line of the value
+     */
+    void AppendField(std::string& output, const char* name, const std::string& value)
+    {
+        size_t start = 0;
+        while (true)
+        {
+            size_t end = value.find_first_of("\r\n", start);
+            output += name;
+            output += ": ";
+            output.append(value, start, end == std::string::npos ? std::string::npos : end - start);
+            output += '\n';
+            if (end == std::string::npos)
+            {
+                break;
+            }
+            // Treat "\r\n" as one line break
+            start = end + ((value[end] == '\r' && end + 1 < value.size() && value[end + 1] == '\n') ? 2 : 1);
+        }
+    }
+
+    /**
+     * @brief Single-line field: line breaks would end the field early
+     */
+    std::string SingleLine(const std::string& value)
+    {
+        return value.substr(0, value.find_first_of("\r\n"));
+    }
+}
+
+namespace sse
+{
+    std::string FormatEvent(const ServerSentEvent& event)
+    {
+        std::string output;
+        output.reserve(event.data.size() + event.event.size() + event.id.size() + 32);
+        if (!event.id.empty())
+        {
+            output += "id: " + SingleLine(event.id) + "\n";
+        }
+        if (!event.event.empty())
+        {
+            output += "event: " + SingleLine(event.event) + "\n";
+        }
+        if (event.retry_ms)
+        {
+            output += "retry: " + std::to_string(*event.retry_ms) + "\n";
+        }
+        AppendField(output, "data", event.data);
+        output += '\n';
+        return output;
+    }
+} // namespace sse
+
+EventStream::EventStream(EventLoop& loop, std::string name, const EventStreamOptions& options)
+    : m_loop(loop)
+    , m_name(std::move(name))
+    , m_options(options)
+    , m_heartbeat(std::make_shared<const std::string>(": keepalive\n\n"))
+{
+}
+
+void EventStream::Broadcast(const ServerSentEvent& event)
+{
+    // Serialized once; every subscriber queues the same buffer
+    Buffer buffer = std::make_shared<const std::string>(sse::FormatEvent(event));
+    if (m_loop.IsInLoopThread())
+    {
+        FanOut(buffer);
+        return;
+    }
+    m_loop.Post([self = shared_from_this(), buffer = std::move(buffer)]()
+    {
+        self->FanOut(buffer);
+    });
+}
+
+std::string EventStream::GetPreamble() const
+{
+    return "retry: " + std::to_string(m_options.retry_ms) + "\n\n";
+}
+
+void EventStream::AddSubscriber(SOCKET socket, std::string remote_address)
+{
+    EventLoop::SetNonBlocking(socket);
+    auto self = shared_from_this();
+    if (!m_loop.Watch(socket, EventLoop::Readable, [self, socket](uint32_t events) { self->OnEvents(socket, events); }))
+    {
+        CloseSocketHandle(socket);
+        return;
+    }
+
+    auto subscriber = std::make_unique<Subscriber>();
+    subscriber->socket = socket;
+    subscriber->remote_address = std::move(remote_address);
+    LOG_DEBUG_FMT(EventStream, "Subscriber {} joined stream '{}'", subscriber->remote_address, m_name);
+    m_subscribers[socket] = std::move(subscriber);
+    m_subscriber_count.store(m_subscribers.size());
+
+    if (m_heartbeat_timer == 0)
+    {
+        ScheduleHeartbeat();
+    }
+}
+
+void EventStream::FanOut(const Buffer& buffer)
+{
+    std::vector<SOCKET> slow;
+    for (auto& [socket, subscriber] : m_subscribers)
+    {
+        if (subscriber->queued_bytes + buffer->size() > m_options.max_queued_bytes)
+        {
+            slow.push_back(socket);
+            continue;
+        }
+
+        const bool was_idle = subscriber->queue.empty();
+        subscriber->queue.push_back(buffer);
+        subscriber->queued_bytes += buffer->size();
+        if (was_idle && !Flush(*subscriber))
+        {
+            slow.push_back(socket);
+        }
+    }
+
+    for (SOCKET socket : slow)
+    {
+        Drop(socket, "slow consumer");
+    }
+}
+
+bool EventStream::Flush(Subscriber& subscriber)
+{
+    while (!subscriber.queue.empty())
+    {
+#ifndef _WIN32
+        // Gather several shared buffers into one send
+        iovec iov[kMaxIovecs];
+        size_t count = 0;
+        for (auto it = subscriber.queue.begin(); it != subscriber.queue.end() && count < kMaxIovecs; ++it, ++count)
+        {
+            const size_t skip = count == 0 ? subscriber.offset : 0;
+            iov[count].iov_base = const_cast<char*>((*it)->data() + skip);
+            iov[count].iov_len = (*it)->size() - skip;
+        }
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = count;
+        const ssize_t sent = sendmsg(subscriber.socket, &message, kSendFlags);
+#else
+        const std::string& front = *subscriber.queue.front();
+        const int sent = send(subscriber.socket, front.data() + subscriber.offset,
+                              static_cast<int>(front.size() - subscriber.offset), kSendFlags);
+#endif
+        if (sent < 0)
+        {
+            if (WouldBlock())
+            {
+                break;
+            }
+            return false;
+        }
+
+        size_t remaining = static_cast<size_t>(sent);
+        subscriber.queued_bytes -= remaining;
+        while (remaining > 0)
+        {
+            const size_t front_left = subscriber.queue.front()->size() - subscriber.offset;
+            if (remaining < front_left)
+            {
+                subscriber.offset += remaining;
+                break;
+            }
+            remaining -= front_left;
+            subscriber.queue.pop_front();
+            subscriber.offset = 0;
+        }
+    }
+
+    const bool want_writable = !subscriber.queue.empty();
+    if (want_writable != subscriber.writable_interest)
+    {
+        subscriber.writable_interest = want_writable;
+        m_loop.Modify(subscriber.socket, EventLoop::Readable | (want_writable ? uint32_t(EventLoop::Writable) : 0u));
+    }
+    return true;
+}
+
+void EventStream::OnEvents(SOCKET socket, uint32_t events)
+{
+    auto it = m_subscribers.find(socket);
+    if (it == m_subscribers.end())
+    {
+        return;
+    }
+
+    if (events & EventLoop::Shutdown)
+    {
+        Drop(socket, "server shutting down");
+        return;
+    }
+
+    if (events & EventLoop::Readable)
+    {
+        // Clients send nothing after the request; EOF means they went away
+        char buffer[512];
+        const auto received = recv(socket, buffer, sizeof(buffer), 0);
+        if (received == 0 || (received < 0 && !WouldBlock()))
+        {
+            Drop(socket, "client disconnected");
+            return;
+        }
+    }
+    if ((events & EventLoop::Writable) && !Flush(*it->second))
+    {
+        Drop(socket, "send failed");
+        return;
+    }
+    if (events & EventLoop::Error)
+    {
+        Drop(socket, "connection error");
+    }
+}
+
+void EventStream::Drop(SOCKET socket, const char* reason)
+{
+    auto it = m_subscribers.find(socket);
+    if (it == m_subscribers.end())
+    {
+        return;
+    }
+
+    LOG_DEBUG_FMT(EventStream, "Subscriber {} left stream '{}': {}", it->second->remote_address, m_name, reason);
+    m_subscribers.erase(it);
+    m_subscriber_count.store(m_subscribers.size());
+    m_loop.Unwatch(socket);
+    CloseSocketHandle(socket);
+
+    if (m_subscribers.empty() && m_heartbeat_timer != 0)
+    {
+        m_loop.CancelTimer(m_heartbeat_timer);
+        m_heartbeat_timer = 0;
+    }
+}
+
+void EventStream::ScheduleHeartbeat()
+{
+    if (m_options.heartbeat_interval.count() <= 0)
+    {
+        return;
+    }
+
+    std::weak_ptr<EventStream> weak = shared_from_this();
+    m_heartbeat_timer = m_loop.AddTimer(m_options.heartbeat_interval, [weak]()
+    {
+        if (auto self = weak.lock())
+        {
+            self->m_heartbeat_timer = 0;
+            if (!self->m_subscribers.empty())
+            {
+                self->FanOut(self->m_heartbeat);
+                self->ScheduleHeartbeat();
+            }
+        }
+    });
+}
+
+} // namespace miniserver::network
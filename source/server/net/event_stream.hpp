@@ -0,0 +1,154 @@
+/**
+ * @file event_stream.hpp
+ * @brief Server-Sent Events (text/event-stream) broadcast channel
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/event_loop.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief One Server-Sent Event
+ */
+struct ServerSentEvent
+{
+    std::string data;                   ///< Payload; embedded newlines become several data lines
+    std::string event;                  ///< Event type (empty for the default "message")
+    std::string id;                     ///< Event id echoed back by clients as Last-Event-ID
+    std::optional<int> retry_ms;        ///< Reconnection delay hint
+};
+
+/**
+ * @brief Event stream limits and timers
+ */
+struct EventStreamOptions
+{
+    size_t max_queued_bytes = 1024 * 1024;                  ///< Unsent bytes before a subscriber is dropped
+    std::chrono::milliseconds heartbeat_interval{15000};    ///< Comment line keeping idle streams alive (0 disables)
+    int retry_ms = 3000;                                    ///< Reconnection delay sent when a client subscribes
+};
+
+namespace sse
+{
+    /**
+     * @brief Serialize an event in text/event-stream format
+     * @param event Event to serialize
+     * @return Wire bytes, terminated by a blank line
+     */
+    std::string FormatEvent(const ServerSentEvent& event);
+} // namespace sse
+
+/**
+ * @brief Broadcast channel for Server-Sent Events subscribers
+ *
+ * Subscriber connections are parked on an EventLoop after their response
+ * headers have been sent. Broadcast() serializes an event once; the same
+ * immutable buffer is queued on every subscriber and written with gathered
+ * sends. Each subscriber's queue is bounded by max_queued_bytes: a client
+ * that falls that far behind is disconnected (EventSource reconnects and can
+ * resume with Last-Event-ID) so one slow consumer never holds memory for all.
+ */
+class EventStream : public std::enable_shared_from_this<EventStream>
+{
+public:
+    using Buffer = std::shared_ptr<const std::string>;
+
+    /**
+     * @brief Construct a stream
+     * @param loop Loop the subscribers live on
+     * @param name Stream name (served at /events/<name>)
+     * @param options Limits and timers
+     */
+    EventStream(EventLoop& loop, std::string name, const EventStreamOptions& options);
+
+    EventStream(const EventStream&) = delete;
+    EventStream& operator=(const EventStream&) = delete;
+
+    /**
+     * @brief Send an event to every subscriber (thread-safe)
+     * @param event Event to broadcast
+     */
+    void Broadcast(const ServerSentEvent& event);
+
+    /**
+     * @brief Attach a connection whose response headers have been sent (loop thread only)
+     * @param socket Connected socket (owned by the stream from now on)
+     * @param remote_address Peer address
+     */
+    void AddSubscriber(SOCKET socket, std::string remote_address);
+
+    /**
+     * @brief Initial body sent right after the response headers
+     */
+    std::string GetPreamble() const;
+
+    /**
+     * @brief Number of connected subscribers
+     */
+    size_t GetSubscriberCount() const { return m_subscriber_count.load(); }
+
+    /**
+     * @brief Stream name
+     */
+    const std::string& GetName() const { return m_name; }
+
+private:
+    /**
+     * @brief Connected client
+     */
+    struct Subscriber
+    {
+        SOCKET socket = INVALID_SOCKET;     ///< Connection socket
+        std::string remote_address;         ///< Peer address
+        std::deque<Buffer> queue;           ///< Shared event buffers not fully written
+        size_t offset = 0;                  ///< Bytes of queue.front() already written
+        size_t queued_bytes = 0;            ///< Unsent bytes in queue
+        bool writable_interest = false;     ///< Watching for Writable
+    };
+
+    /**
+     * @brief Queue a buffer on every subscriber (loop thread)
+     */
+    void FanOut(const Buffer& buffer);
+
+    /**
+     * @brief Write as much queued data as the socket accepts
+     * @return false if the subscriber was dropped
+     */
+    bool Flush(Subscriber& subscriber);
+
+    /**
+     * @brief Handle socket readiness for one subscriber
+     */
+    void OnEvents(SOCKET socket, uint32_t events);
+
+    /**
+     * @brief Close and forget a subscriber
+     */
+    void Drop(SOCKET socket, const char* reason);
+
+    void ScheduleHeartbeat();
+
+    EventLoop& m_loop;                                                      ///< Owning loop
+    std::string m_name;                                                     ///< Stream name
+    EventStreamOptions m_options;                                           ///< Limits and timers
+    std::unordered_map<SOCKET, std::unique_ptr<Subscriber>> m_subscribers;  ///< Subscribers (loop thread)
+    std::atomic<size_t> m_subscriber_count{0};                              ///< Mirror of m_subscribers.size()
+    EventLoop::TimerId m_heartbeat_timer = 0;                               ///< Heartbeat timer (loop thread)
+    Buffer m_heartbeat;                                                     ///< Shared heartbeat comment
+};
+
+} // namespace miniserver::network
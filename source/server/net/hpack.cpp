@@ -0,0 +1,620 @@
+/**
+ * @file hpack.cpp
+ * @brief HPACK header compression implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "hpack.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace miniserver::http
+{
+
+namespace
+{
+    constexpr size_t kEntryOverhead = 32;       ///< Per-entry size overhead (RFC 7541 4.1)
+    constexpr size_t kNotFound = SIZE_MAX;
+
+    /**
+     * @brief Static table (RFC 7541 Appendix A), index 1 is element 0
+     */
+    const std::array<std::pair<const char*, const char*>, 61> kStaticTable = {{
+        {":authority", ""}, {":method", "GET"}, {":method", "POST"}, {":path", "/"},
+        {":path", "/index.html"}, {":scheme", "http"}, {":scheme", "https"}, {":status", "200"},
+        {":status", "204"}, {":status", "206"}, {":status", "304"}, {":status", "400"},
+        {":status", "404"}, {":status", "500"}, {"accept-charset", ""}, {"accept-encoding", "gzip, deflate"},
+        {"accept-language", ""}, {"accept-ranges", ""}, {"accept", ""}, {"access-control-allow-origin", ""},
+        {"age", ""}, {"allow", ""}, {"authorization", ""}, {"cache-control", ""},
+        {"content-disposition", ""}, {"content-encoding", ""}, {"content-language", ""}, {"content-length", ""},
+        {"content-location", ""}, {"content-range", ""}, {"content-type", ""}, {"cookie", ""},
+        {"date", ""}, {"etag", ""}, {"expect", ""}, {"expires", ""},
+        {"from", ""}, {"host", ""}, {"if-match", ""}, {"if-modified-since", ""},
+        {"if-none-match", ""}, {"if-range", ""}, {"if-unmodified-since", ""}, {"last-modified", ""},
+        {"link", ""}, {"location", ""}, {"max-forwards", ""}, {"proxy-authenticate", ""},
+        {"proxy-authorization", ""}, {"range", ""}, {"referer", ""}, {"refresh", ""},
+        {"retry-after", ""}, {"server", ""}, {"set-cookie", ""}, {"strict-transport-security", ""},
+        {"transfer-encoding", ""}, {"user-agent", ""}, {"vary", ""}, {"via", ""},
+        {"www-authenticate", ""}
+    }};
+
+    /**
+     * @brief Huffman code table (RFC 7541 Appendix B): {code, bit length}, symbol 256 is EOS
+     */
+    const std::array<std::pair<uint32_t, uint8_t>, 257> kHuffmanCodes = {{
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+    {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+    {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+    {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+    {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+    {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+    {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+    {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+    {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+    {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+    {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+    {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+    {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+    {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+    {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+    {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+    {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+    {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+    {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+    {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+    {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+    {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+    {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+    {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+    {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+    {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+    {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+    {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+    {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+    {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+    {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+    {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+    {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+    {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+    {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+    {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+    {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+    {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+    {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+    {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+    {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+    {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+    {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+    {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+    {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+    {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+    {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+    {0x3fffffff, 30}
+    }};
+
+
+    /**
+     * @brief Binary decoding tree built once from kHuffmanCodes
+     */
+    class HuffmanTree
+    {
+    public:
+        struct Node
+        {
+            int16_t children[2] = {-1, -1};     ///< Child node indices
+            int16_t symbol = -1;                ///< Symbol for leaves, -1 otherwise
+        };
+
+        HuffmanTree()
+        {
+            m_nodes.reserve(512);
+            m_nodes.emplace_back();
+            for (size_t symbol = 0; symbol < kHuffmanCodes.size(); ++symbol)
+            {
+                const auto [code, length] = kHuffmanCodes[symbol];
+                size_t node = 0;
+                for (int bit = length - 1; bit >= 0; --bit)
+                {
+                    const int branch = (code >> bit) & 1;
+                    if (m_nodes[node].children[branch] < 0)
+                    {
+                        m_nodes[node].children[branch] = static_cast<int16_t>(m_nodes.size());
+                        m_nodes.emplace_back();
+                    }
+                    node = static_cast<size_t>(m_nodes[node].children[branch]);
+                }
+                m_nodes[node].symbol = static_cast<int16_t>(symbol);
+            }
+        }
+
+        const Node& operator[](size_t index) const { return m_nodes[index]; }
+
+    private:
+        std::vector<Node> m_nodes;
+    };
+
+    const HuffmanTree& GetHuffmanTree()
+    {
+        static const HuffmanTree tree;
+        return tree;
+    }
+
+    /**
+     * @brief Decode an HPACK integer with an N-bit prefix
+     */
+    bool DecodeInteger(std::string_view input, size_t& pos, int prefix_bits, uint64_t& value)
+    {
+        if (pos >= input.size())
+        {
+            return false;
+        }
+        const uint64_t max_prefix = (1u << prefix_bits) - 1;
+        value = static_cast<uint8_t>(input[pos++]) & max_prefix;
+        if (value < max_prefix)
+        {
+            return true;
+        }
+        for (int shift = 0; shift <= 56; shift += 7)
+        {
+            if (pos >= input.size())
+            {
+                return false;
+            }
+            const auto byte = static_cast<uint8_t>(input[pos++]);
+            value += static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false; // integer overflow
+    }
+
+    /**
+     * @brief Decode a (possibly Huffman coded) string literal
+     */
+    bool DecodeString(std::string_view input, size_t& pos, std::string& output)
+    {
+        if (pos >= input.size())
+        {
+            return false;
+        }
+        const bool huffman = (static_cast<uint8_t>(input[pos]) & 0x80) != 0;
+        uint64_t length;
+        if (!DecodeInteger(input, pos, 7, length) || length > input.size() - pos)
+        {
+            return false;
+        }
+        std::string_view raw = input.substr(pos, static_cast<size_t>(length));
+        pos += static_cast<size_t>(length);
+
+        output.clear();
+        if (huffman)
+        {
+            return hpack::HuffmanDecode(raw, output);
+        }
+        output.assign(raw.data(), raw.size());
+        return true;
+    }
+
+    /**
+     * @brief Fields that should never enter the dynamic table
+     *
+     * Values that change on nearly every response would only churn the
+     * table, and credentials must not be kept in shared compression state.
+     */
+    bool ShouldIndex(const std::string& name, const std::string& value, size_t table_size)
+    {
+        if (name == "content-length" || name == "date" || name == "etag" || name == "last-modified" ||
+            name == "set-cookie" || name == "authorization" || name == "cookie")
+        {
+            return false;
+        }
+        return name.size() + value.size() + kEntryOverhead <= table_size / 2;
+    }
+
+    /**
+     * @brief Look up a field in the static table
+     * @return 1-based index of a full match or 0; name_index receives a name-only match or 0
+     */
+    size_t FindStatic(const std::string& name, const std::string& value, size_t& name_index)
+    {
+        name_index = 0;
+        for (size_t i = 0; i < kStaticTable.size(); ++i)
+        {
+            if (name == kStaticTable[i].first)
+            {
+                if (value == kStaticTable[i].second)
+                {
+                    return i + 1;
+                }
+                if (name_index == 0)
+                {
+                    name_index = i + 1;
+                }
+            }
+        }
+        return 0;
+    }
+}
+
+// ============================================================================
+// HpackDynamicTable
+// ============================================================================
+
+HpackDynamicTable::HpackDynamicTable(size_t max_size)
+    : m_max_size(max_size)
+{
+}
+
+void HpackDynamicTable::Add(const std::string& name, const std::string& value)
+{
+    const size_t entry_size = name.size() + value.size() + kEntryOverhead;
+    if (entry_size > m_max_size)
+    {
+        // An entry larger than the table empties it (RFC 7541 4.4)
+        m_entries.clear();
+        m_size = 0;
+        return;
+    }
+    EvictTo(m_max_size - entry_size);
+    m_entries.emplace_front(name, value);
+    m_size += entry_size;
+}
+
+void HpackDynamicTable::SetMaxSize(size_t max_size)
+{
+    m_max_size = max_size;
+    EvictTo(max_size);
+}
+
+const HeaderField* HpackDynamicTable::Get(size_t index) const
+{
+    return index < m_entries.size() ? &m_entries[index] : nullptr;
+}
+
+size_t HpackDynamicTable::Find(const std::string& name, const std::string& value, size_t& name_only_index) const
+{
+    name_only_index = kNotFound;
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        if (m_entries[i].first == name)
+        {
+            if (m_entries[i].second == value)
+            {
+                return i;
+            }
+            if (name_only_index == kNotFound)
+            {
+                name_only_index = i;
+            }
+        }
+    }
+    return kNotFound;
+}
+
+void HpackDynamicTable::EvictTo(size_t limit)
+{
+    while (m_size > limit && !m_entries.empty())
+    {
+        const auto& oldest = m_entries.back();
+        m_size -= oldest.first.size() + oldest.second.size() + kEntryOverhead;
+        m_entries.pop_back();
+    }
+}
+
+// ============================================================================
+// HpackDecoder
+// ============================================================================
+
+HpackDecoder::HpackDecoder(size_t max_table_size)
+    : m_table(max_table_size)
+    , m_settings_max_size(max_table_size)
+{
+}
+
+bool HpackDecoder::Decode(std::string_view block, std::vector<HeaderField>& headers)
+{
+    size_t pos = 0;
+    bool field_seen = false;
+
+    auto lookup = [this](uint64_t index) -> const HeaderField*
+    {
+        static thread_local HeaderField static_entry;
+        if (index == 0)
+        {
+            return nullptr;
+        }
+        if (index <= kStaticTable.size())
+        {
+            static_entry.first = kStaticTable[index - 1].first;
+            static_entry.second = kStaticTable[index - 1].second;
+            return &static_entry;
+        }
+        return m_table.Get(static_cast<size_t>(index - kStaticTable.size() - 1));
+    };
+
+    while (pos < block.size())
+    {
+        const auto byte = static_cast<uint8_t>(block[pos]);
+
+        if (byte & 0x80)
+        {
+            // Indexed header field
+            uint64_t index;
+            if (!DecodeInteger(block, pos, 7, index))
+            {
+                return false;
+            }
+            const HeaderField* entry = lookup(index);
+            if (!entry)
+            {
+                return false;
+            }
+            headers.push_back(*entry);
+            field_seen = true;
+            continue;
+        }
+
+        if ((byte & 0xe0) == 0x20)
+        {
+            // Dynamic table size update, only allowed before the first field
+            uint64_t new_size;
+            if (field_seen || !DecodeInteger(block, pos, 5, new_size) || new_size > m_settings_max_size)
+            {
+                return false;
+            }
+            m_table.SetMaxSize(static_cast<size_t>(new_size));
+            continue;
+        }
+
+        // Literal: with incremental indexing (6-bit prefix), without / never indexed (4-bit prefix)
+        const bool incremental = (byte & 0xc0) == 0x40;
+        uint64_t name_index;
+        if (!DecodeInteger(block, pos, incremental ? 6 : 4, name_index))
+        {
+            return false;
+        }
+
+        HeaderField field;
+        if (name_index == 0)
+        {
+            if (!DecodeString(block, pos, field.first))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            const HeaderField* entry = lookup(name_index);
+            if (!entry)
+            {
+                return false;
+            }
+            field.first = entry->first;
+        }
+        if (!DecodeString(block, pos, field.second))
+        {
+            return false;
+        }
+
+        if (incremental)
+        {
+            m_table.Add(field.first, field.second);
+        }
+        headers.push_back(std::move(field));
+        field_seen = true;
+    }
+
+    return true;
+}
+
+// ============================================================================
+// HpackEncoder
+// ============================================================================
+
+HpackEncoder::HpackEncoder(size_t max_table_size)
+    : m_table(max_table_size)
+    , m_pending_size_update(kNotFound)
+{
+}
+
+void HpackEncoder::SetPeerMaxTableSize(size_t size)
+{
+    // Never grow beyond our own preference; shrinking must be signalled
+    const size_t new_size = std::min<size_t>(size, 4096);
+    if (new_size != m_table.MaxSize())
+    {
+        m_table.SetMaxSize(new_size);
+        m_pending_size_update = new_size;
+    }
+}
+
+void HpackEncoder::Encode(const std::vector<HeaderField>& headers, std::string& output)
+{
+    if (m_pending_size_update != kNotFound)
+    {
+        hpack::EncodeInteger(output, 0x20, 5, m_pending_size_update);
+        m_pending_size_update = kNotFound;
+    }
+
+    for (const auto& [name, value] : headers)
+    {
+        size_t static_name_index;
+        const size_t static_index = FindStatic(name, value, static_name_index);
+        if (static_index != 0)
+        {
+            hpack::EncodeInteger(output, 0x80, 7, static_index);
+            continue;
+        }
+
+        size_t dynamic_name_index;
+        const size_t dynamic_index = m_table.Find(name, value, dynamic_name_index);
+        if (dynamic_index != kNotFound)
+        {
+            hpack::EncodeInteger(output, 0x80, 7, dynamic_index + kStaticTable.size() + 1);
+            continue;
+        }
+
+        size_t name_index = static_name_index;
+        if (name_index == 0 && dynamic_name_index != kNotFound)
+        {
+            name_index = dynamic_name_index + kStaticTable.size() + 1;
+        }
+
+        const bool index = ShouldIndex(name, value, m_table.MaxSize());
+        if (index)
+        {
+            hpack::EncodeInteger(output, 0x40, 6, name_index);
+        }
+        else
+        {
+            hpack::EncodeInteger(output, 0x00, 4, name_index);
+        }
+        if (name_index == 0)
+        {
+            hpack::EncodeString(output, name);
+        }
+        hpack::EncodeString(output, value);
+
+        if (index)
+        {
+            m_table.Add(name, value);
+        }
+    }
+}
+
+// ============================================================================
+// Primitives
+// ============================================================================
+
+namespace hpack
+{
+    void EncodeInteger(std::string& output, uint8_t first_byte_flags, int prefix_bits, uint64_t value)
+    {
+        const uint64_t max_prefix = (1u << prefix_bits) - 1;
+        if (value < max_prefix)
+        {
+            output += static_cast<char>(first_byte_flags | value);
+            return;
+        }
+        output += static_cast<char>(first_byte_flags | max_prefix);
+        value -= max_prefix;
+        while (value >= 0x80)
+        {
+            output += static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        output += static_cast<char>(value);
+    }
+
+    void EncodeString(std::string& output, std::string_view value)
+    {
+        const size_t huffman_length = HuffmanEncodedLength(value);
+        if (huffman_length < value.size())
+        {
+            EncodeInteger(output, 0x80, 7, huffman_length);
+            HuffmanEncode(value, output);
+        }
+        else
+        {
+            EncodeInteger(output, 0x00, 7, value.size());
+            output.append(value.data(), value.size());
+        }
+    }
+
+    size_t HuffmanEncodedLength(std::string_view input)
+    {
+        size_t bits = 0;
+        for (char c : input)
+        {
+            bits += kHuffmanCodes[static_cast<uint8_t>(c)].second;
+        }
+        return (bits + 7) / 8;
+    }
+
+    void HuffmanEncode(std::string_view input, std::string& output)
+    {
+        uint64_t buffer = 0;
+        int buffered_bits = 0;
+        for (char c : input)
+        {
+            const auto [code, length] = kHuffmanCodes[static_cast<uint8_t>(c)];
+            buffer = (buffer << length) | code;
+            buffered_bits += length;
+            while (buffered_bits >= 8)
+            {
+                buffered_bits -= 8;
+                output += static_cast<char>((buffer >> buffered_bits) & 0xff);
+            }
+        }
+        if (buffered_bits > 0)
+        {
+            // Pad with the most significant bits of EOS (all ones)
+            const int padding = 8 - buffered_bits;
+            output += static_cast<char>(((buffer << padding) | ((1u << padding) - 1)) & 0xff);
+        }
+    }
+
+    bool HuffmanDecode(std::string_view input, std::string& output)
+    {
+        const HuffmanTree& tree = GetHuffmanTree();
+        size_t node = 0;
+        int pending_bits = 0;
+        bool pending_all_ones = true;
+
+        for (char c : input)
+        {
+            const auto byte = static_cast<uint8_t>(c);
+            for (int bit = 7; bit >= 0; --bit)
+            {
+                const int branch = (byte >> bit) & 1;
+                const int16_t next = tree[node].children[branch];
+                if (next < 0)
+                {
+                    return false;
+                }
+                node = static_cast<size_t>(next);
+                ++pending_bits;
+                pending_all_ones = pending_all_ones && branch == 1;
+
+                const int16_t symbol = tree[node].symbol;
+                if (symbol >= 0)
+                {
+                    if (symbol == 256)
+                    {
+                        return false; // EOS inside a string is an error
+                    }
+                    output += static_cast<char>(symbol);
+                    node = 0;
+                    pending_bits = 0;
+                    pending_all_ones = true;
+                }
+            }
+        }
+
+        // Padding must be shorter than 8 bits and consist of EOS prefix (ones)
+        return pending_bits < 8 && pending_all_ones;
+    }
+}
+
+} // namespace miniserver::http
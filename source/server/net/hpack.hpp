@@ -0,0 +1,194 @@
+/**
+ * @file hpack.hpp
+ * @brief HPACK header compression for HTTP/2 (RFC 7541)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace miniserver::http
+{
+
+/**
+ * @brief A single decoded header field (name is lowercase on the wire)
+ */
+using HeaderField = std::pair<std::string, std::string>;
+
+/**
+ * @brief HPACK dynamic table shared by the encoder and decoder implementations
+ *
+ * Entries are kept newest-first; every entry costs name + value + 32 bytes
+ * against the table size as defined by RFC 7541 section 4.1.
+ */
+class HpackDynamicTable
+{
+public:
+    /**
+     * @brief Construct a table
+     * @param max_size Maximum table size in bytes
+     */
+    explicit HpackDynamicTable(size_t max_size = 4096);
+
+    /**
+     * @brief Insert an entry, evicting older entries as needed
+     * @param name Header name
+     * @param value Header value
+     */
+    void Add(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Change the maximum size, evicting entries that no longer fit
+     * @param max_size New maximum size in bytes
+     */
+    void SetMaxSize(size_t max_size);
+
+    /**
+     * @brief Get an entry by 0-based dynamic index (0 is the newest)
+     * @param index Dynamic index
+     * @return Pointer to entry, or nullptr if out of range
+     */
+    const HeaderField* Get(size_t index) const;
+
+    /**
+     * @brief Number of entries
+     */
+    size_t Count() const noexcept { return m_entries.size(); }
+
+    /**
+     * @brief Maximum size in bytes
+     */
+    size_t MaxSize() const noexcept { return m_max_size; }
+
+    /**
+     * @brief Find an entry
+     * @param name Header name
+     * @param value Header value
+     * @param name_only_index Receives a 0-based index of a name-only match (or SIZE_MAX)
+     * @return 0-based index of a full match, or SIZE_MAX
+     */
+    size_t Find(const std::string& name, const std::string& value, size_t& name_only_index) const;
+
+private:
+    /**
+     * @brief Evict oldest entries until the table fits in the given size
+     * @param limit Size limit in bytes
+     */
+    void EvictTo(size_t limit);
+
+    std::deque<HeaderField> m_entries;      ///< Entries, newest first
+    size_t m_size = 0;                      ///< Current size in bytes
+    size_t m_max_size;                      ///< Maximum size in bytes
+};
+
+/**
+ * @brief HPACK header block decoder
+ */
+class HpackDecoder
+{
+public:
+    /**
+     * @brief Construct a decoder
+     * @param max_table_size SETTINGS_HEADER_TABLE_SIZE advertised to the peer
+     */
+    explicit HpackDecoder(size_t max_table_size = 4096);
+
+    /**
+     * @brief Decode a complete header block
+     * @param block Header block fragment(s) concatenated
+     * @param headers Receives decoded fields in order
+     * @return true on success, false on a compression error (connection error)
+     */
+    bool Decode(std::string_view block, std::vector<HeaderField>& headers);
+
+private:
+    HpackDynamicTable m_table;              ///< Dynamic table
+    size_t m_settings_max_size;             ///< Upper bound for table size updates
+};
+
+/**
+ * @brief HPACK header block encoder
+ *
+ * Uses the static table, a dynamic table for repeated fields and Huffman
+ * coding whenever it is shorter than the literal string.
+ */
+class HpackEncoder
+{
+public:
+    /**
+     * @brief Construct an encoder
+     * @param max_table_size Table size to use (bounded by the peer's SETTINGS_HEADER_TABLE_SIZE)
+     */
+    explicit HpackEncoder(size_t max_table_size = 4096);
+
+    /**
+     * @brief Apply the peer's SETTINGS_HEADER_TABLE_SIZE
+     * @param size New maximum size; a size update is emitted with the next block
+     */
+    void SetPeerMaxTableSize(size_t size);
+
+    /**
+     * @brief Encode a header list
+     * @param headers Fields (names must already be lowercase)
+     * @param output Buffer receiving the header block
+     */
+    void Encode(const std::vector<HeaderField>& headers, std::string& output);
+
+private:
+    HpackDynamicTable m_table;              ///< Dynamic table mirror of the peer's decoder
+    size_t m_pending_size_update;           ///< Table size update to emit, SIZE_MAX if none
+};
+
+/**
+ * @brief HPACK primitive helpers (also used by tests and tools)
+ */
+namespace hpack
+{
+    /**
+     * @brief Append an HPACK integer with an N-bit prefix
+     * @param output Buffer
+     * @param first_byte_flags High bits to OR into the first byte
+     * @param prefix_bits Prefix size (1-8)
+     * @param value Integer value
+     */
+    void EncodeInteger(std::string& output, uint8_t first_byte_flags, int prefix_bits, uint64_t value);
+
+    /**
+     * @brief Append a string literal (Huffman coded if shorter)
+     * @param output Buffer
+     * @param value String value
+     */
+    void EncodeString(std::string& output, std::string_view value);
+
+    /**
+     * @brief Huffman encode a string
+     * @param input Raw bytes
+     * @param output Buffer receiving the encoded bytes
+     */
+    void HuffmanEncode(std::string_view input, std::string& output);
+
+    /**
+     * @brief Length of the Huffman encoding of a string in bytes
+     * @param input Raw bytes
+     * @return Encoded size
+     */
+    size_t HuffmanEncodedLength(std::string_view input);
+
+    /**
+     * @brief Huffman decode a string
+     * @param input Encoded bytes
+     * @param output Buffer receiving the decoded bytes
+     * @return false on invalid padding or an EOS symbol
+     */
+    bool HuffmanDecode(std::string_view input, std::string& output);
+}
+
+} // namespace miniserver::http
@@ -0,0 +1,1141 @@
+/**
+ * @file http2_connection.cpp
+ * @brief HTTP/2 cleartext (h2c) connection handling implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/http2_connection.hpp"
+#include "net/http_parser.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <system_error>
+#include <thread>
+
+#ifndef _WIN32
+    #include <netinet/tcp.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+    constexpr std::string_view kPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+    // Frame types (RFC 9113 section 6)
+    constexpr uint8_t kFrameData = 0x0;
+    constexpr uint8_t kFrameHeaders = 0x1;
+    constexpr uint8_t kFramePriority = 0x2;
+    constexpr uint8_t kFrameRstStream = 0x3;
+    constexpr uint8_t kFrameSettings = 0x4;
+    constexpr uint8_t kFramePushPromise = 0x5;
+    constexpr uint8_t kFramePing = 0x6;
+    constexpr uint8_t kFrameGoAway = 0x7;
+    constexpr uint8_t kFrameWindowUpdate = 0x8;
+    constexpr uint8_t kFrameContinuation = 0x9;
+
+    // Frame flags
+    constexpr uint8_t kFlagEndStream = 0x1;
+    constexpr uint8_t kFlagAck = 0x1;
+    constexpr uint8_t kFlagEndHeaders = 0x4;
+    constexpr uint8_t kFlagPadded = 0x8;
+    constexpr uint8_t kFlagPriority = 0x20;
+
+    // Settings identifiers
+    constexpr uint16_t kSettingsHeaderTableSize = 0x1;
+    constexpr uint16_t kSettingsEnablePush = 0x2;
+    constexpr uint16_t kSettingsMaxConcurrentStreams = 0x3;
+    constexpr uint16_t kSettingsInitialWindowSize = 0x4;
+    constexpr uint16_t kSettingsMaxFrameSize = 0x5;
+
+    // Error codes
+    constexpr uint32_t kNoError = 0x0;
+    constexpr uint32_t kProtocolError = 0x1;
+    constexpr uint32_t kInternalError = 0x2;
+    constexpr uint32_t kFlowControlError = 0x3;
+    constexpr uint32_t kStreamClosed = 0x5;
+    constexpr uint32_t kFrameSizeError = 0x6;
+    constexpr uint32_t kRefusedStream = 0x7;
+    constexpr uint32_t kCompressionError = 0x9;
+    constexpr uint32_t kEnhanceYourCalm = 0xb;
+
+    constexpr uint32_t kMaxConcurrentStreams = 100;             ///< Advertised stream limit
+    constexpr size_t kMaxStreamWorkers = 8;                     ///< Handler threads per connection
+    constexpr uint32_t kLocalMaxFrameSize = 16384;              ///< We never raise SETTINGS_MAX_FRAME_SIZE
+    constexpr int64_t kMaxWindow = 0x7fffffff;                  ///< 2^31 - 1
+    constexpr int64_t kDefaultWindow = 65535;                   ///< Initial window before SETTINGS
+
+    /**
+     * Request bodies are capped at the same 1 MiB as HTTP/1.1; advertising a
+     * stream window of that size means stream-level WINDOW_UPDATEs are never
+     * needed, only the connection window is replenished.
+     */
+    constexpr size_t kMaxRequestBody = 1024 * 1024;
+    constexpr uint32_t kLocalInitialWindow = 1024 * 1024;
+    constexpr size_t kMaxHeaderBlock = 64 * 1024;
+
+    uint32_t ReadUint32(const char* data)
+    {
+        const auto* p = reinterpret_cast<const unsigned char*>(data);
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    void AppendUint32(std::string& output, uint32_t value)
+    {
+        output.push_back(static_cast<char>((value >> 24) & 0xff));
+        output.push_back(static_cast<char>((value >> 16) & 0xff));
+        output.push_back(static_cast<char>((value >> 8) & 0xff));
+        output.push_back(static_cast<char>(value & 0xff));
+    }
+
+    void AppendSetting(std::string& output, uint16_t id, uint32_t value)
+    {
+        output.push_back(static_cast<char>((id >> 8) & 0xff));
+        output.push_back(static_cast<char>(id & 0xff));
+        AppendUint32(output, value);
+    }
+
+    void AppendFrameHeader(std::string& output, size_t length, uint8_t type, uint8_t flags, uint32_t stream_id)
+    {
+        output.push_back(static_cast<char>((length >> 16) & 0xff));
+        output.push_back(static_cast<char>((length >> 8) & 0xff));
+        output.push_back(static_cast<char>(length & 0xff));
+        output.push_back(static_cast<char>(type));
+        output.push_back(static_cast<char>(flags));
+        AppendUint32(output, stream_id & 0x7fffffff);
+    }
+
+    /**
+     * @brief Decode the base64url (no padding) HTTP2-Settings header value
+     */
+    bool Base64UrlDecode(std::string_view input, std::string& output)
+    {
+        uint32_t buffer = 0;
+        int bits = 0;
+        for (char c : input)
+        {
+            int value;
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '-' || c == '+') value = 62;
+            else if (c == '_' || c == '/') value = 63;
+            else if (c == '=') break;
+            else return false;
+
+            buffer = (buffer << 6) | static_cast<uint32_t>(value);
+            bits += 6;
+            if (bits >= 8)
+            {
+                bits -= 8;
+                output.push_back(static_cast<char>((buffer >> bits) & 0xff));
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Headers that are meaningful only for a single HTTP/1.1 hop
+     */
+    bool IsConnectionSpecific(std::string_view name)
+    {
+        return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+               name == "transfer-encoding" || name == "upgrade";
+    }
+
+    std::string ToLower(std::string_view value)
+    {
+        std::string result(value);
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c)
+        {
+            return static_cast<char>(std::tolower(c));
+        });
+        return result;
+    }
+}
+
+Http2Connection::Http2Connection(SOCKET client_socket, RequestHandler handler, std::string client_ip)
+    : m_socket(client_socket)
+    , m_handler(std::move(handler))
+    , m_client_ip(std::move(client_ip))
+{
+    // Frames from concurrent streams are written as they are ready; Nagle
+    // would hold them back waiting for the peer's delayed ACK
+    int no_delay = 1;
+    setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&no_delay), sizeof(no_delay));
+}
+
+Http2Connection::~Http2Connection()
+{
+    std::unique_lock<std::mutex> lock(m_state_mutex);
+    m_closed = true;
+    m_state_cv.notify_all();
+    m_work_cv.notify_all();
+    m_state_cv.wait(lock, [this]() { return m_active_workers == 0; });
+}
+
+bool Http2Connection::StartsWithPreface(std::string_view data)
+{
+    const size_t length = std::min(data.size(), kPreface.size());
+    return data.substr(0, length) == kPreface.substr(0, length);
+}
+
+bool Http2Connection::IsUpgradeRequest(std::string_view request_head)
+{
+    const auto upgrade = http::HttpParser::FindRawHeader(request_head, "upgrade");
+    if (!upgrade || !http::HttpParser::FindRawHeader(request_head, "http2-settings"))
+    {
+        return false;
+    }
+
+    // Upgrade is a comma separated list of protocols
+    const std::string protocols = ToLower(*upgrade);
+    size_t start = 0;
+    while (start <= protocols.size())
+    {
+        size_t end = protocols.find(',', start);
+        if (end == std::string::npos)
+        {
+            end = protocols.size();
+        }
+        std::string_view token(protocols.data() + start, end - start);
+        while (!token.empty() && token.front() == ' ') token.remove_prefix(1);
+        while (!token.empty() && token.back() == ' ') token.remove_suffix(1);
+        if (token == "h2c")
+        {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+void Http2Connection::ServePriorKnowledge(std::string received)
+{
+    LOG_INFO(Http2Connection, "HTTP/2 (prior knowledge) connection from " + m_client_ip);
+
+    m_recv_buffer = std::move(received);
+    SendSettings();
+    Serve();
+}
+
+bool Http2Connection::ServeUpgrade(const std::string& upgrade_request, std::string received)
+{
+    // The HTTP2-Settings header carries the client's SETTINGS payload
+    const auto encoded = http::HttpParser::FindRawHeader(upgrade_request, "http2-settings");
+    std::string settings;
+    if (!encoded || !Base64UrlDecode(*encoded, settings) || settings.size() % 6 != 0 ||
+        ApplySettings(settings) != kNoError)
+    {
+        LOG_WARN(Http2Connection, "Ignoring h2c upgrade with invalid HTTP2-Settings from " + m_client_ip);
+        return false;
+    }
+
+    LOG_INFO(Http2Connection, "HTTP/2 (upgrade) connection from " + m_client_ip);
+
+    {
+        std::lock_guard<std::mutex> lock(m_send_mutex);
+        if (!WriteAll("HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n"))
+        {
+            return true;
+        }
+    }
+
+    // Server connection preface must precede the response on stream 1
+    SendSettings();
+
+    // The upgrade request itself is answered on stream 1 (half-closed remote)
+    auto stream = std::make_shared<Stream>();
+    stream->id = 1;
+    stream->headers_done = true;
+    stream->remote_closed = true;
+    stream->raw_request = upgrade_request;
+    {
+        std::lock_guard<std::mutex> lock(m_state_mutex);
+        stream->send_window = m_peer_initial_window;
+        m_streams[1] = stream;
+    }
+    m_last_stream_id = 1;
+    Dispatch(stream);
+
+    m_recv_buffer = std::move(received);
+    Serve();
+    return true;
+}
+
+void Http2Connection::Serve()
+{
+    bool graceful = true;
+    if (!Fill(kPreface.size()) ||
+        std::string_view(m_recv_buffer).substr(m_recv_offset, kPreface.size()) != kPreface)
+    {
+        graceful = ConnectionError(kProtocolError, "invalid connection preface");
+    }
+    else
+    {
+        m_recv_offset += kPreface.size();
+
+        while (Fill(9))
+        {
+            const char* header = m_recv_buffer.data() + m_recv_offset;
+            const size_t length = (static_cast<size_t>(static_cast<unsigned char>(header[0])) << 16) |
+                                  (static_cast<size_t>(static_cast<unsigned char>(header[1])) << 8) |
+                                  static_cast<size_t>(static_cast<unsigned char>(header[2]));
+            const auto type = static_cast<uint8_t>(header[3]);
+            const auto flags = static_cast<uint8_t>(header[4]);
+            const uint32_t stream_id = ReadUint32(header + 5) & 0x7fffffff;
+
+            if (length > kLocalMaxFrameSize)
+            {
+                graceful = ConnectionError(kFrameSizeError, "frame exceeds SETTINGS_MAX_FRAME_SIZE");
+                break;
+            }
+            if (!Fill(9 + length))
+            {
+                break;
+            }
+
+            const std::string_view payload(m_recv_buffer.data() + m_recv_offset + 9, length);
+            const bool keep_open = HandleFrame(type, flags, stream_id, payload);
+            m_recv_offset += 9 + length;
+            if (!keep_open)
+            {
+                graceful = false;
+                break;
+            }
+
+            if (m_goaway_received)
+            {
+                std::lock_guard<std::mutex> lock(m_state_mutex);
+                if (m_streams.empty())
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Idle timeout or peer close: tell the peer nothing more will be processed
+    if (graceful)
+    {
+        SendGoAway(kNoError);
+    }
+
+    // Wake any worker waiting for flow control or work and let them finish
+    std::unique_lock<std::mutex> lock(m_state_mutex);
+    m_closed = true;
+    m_state_cv.notify_all();
+    m_work_cv.notify_all();
+    m_state_cv.wait(lock, [this]() { return m_active_workers == 0; });
+
+    LOG_DEBUG(Http2Connection, "HTTP/2 connection closed: " + m_client_ip);
+}
+
+bool Http2Connection::Fill(size_t size)
+{
+    while (m_recv_buffer.size() - m_recv_offset < size)
+    {
+        // Compact consumed bytes before growing the buffer
+        if (m_recv_offset > 0)
+        {
+            m_recv_buffer.erase(0, m_recv_offset);
+            m_recv_offset = 0;
+        }
+
+        char buffer[16384];
+        const int received = recv(m_socket, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        m_recv_buffer.append(buffer, static_cast<size_t>(received));
+    }
+    return true;
+}
+
+bool Http2Connection::HandleFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload)
+{
+    // A header block must be contiguous (RFC 9113 section 4.3)
+    if (m_pending_headers && type != kFrameContinuation)
+    {
+        return ConnectionError(kProtocolError, "expected CONTINUATION");
+    }
+
+    switch (type)
+    {
+        case kFrameData:
+            return HandleData(flags, stream_id, payload);
+
+        case kFrameHeaders:
+            return HandleHeaders(flags, stream_id, payload);
+
+        case kFramePriority:
+            // Prioritization is advisory; streams are served as they complete
+            if (stream_id == 0)
+            {
+                return ConnectionError(kProtocolError, "PRIORITY on stream 0");
+            }
+            return true;
+
+        case kFrameRstStream:
+            return HandleRstStream(stream_id, payload);
+
+        case kFrameSettings:
+            return HandleSettings(flags, stream_id, payload);
+
+        case kFramePushPromise:
+            return ConnectionError(kProtocolError, "PUSH_PROMISE from client");
+
+        case kFramePing:
+            if (stream_id != 0 || payload.size() != 8)
+            {
+                return ConnectionError(kProtocolError, "malformed PING");
+            }
+            if (!(flags & kFlagAck))
+            {
+                SendFrame(kFramePing, kFlagAck, 0, payload);
+            }
+            return true;
+
+        case kFrameGoAway:
+            LOG_DEBUG(Http2Connection, "GOAWAY received from " + m_client_ip);
+            m_goaway_received = true;
+            return true;
+
+        case kFrameWindowUpdate:
+            return HandleWindowUpdate(stream_id, payload);
+
+        case kFrameContinuation:
+            return HandleContinuation(flags, stream_id, payload);
+
+        default:
+            // Unknown frame types must be ignored
+            return true;
+    }
+}
+
+bool Http2Connection::HandleHeaders(uint8_t flags, uint32_t stream_id, std::string_view payload)
+{
+    if (stream_id == 0 || stream_id % 2 == 0)
+    {
+        return ConnectionError(kProtocolError, "HEADERS on invalid stream");
+    }
+
+    size_t padding = 0;
+    if (flags & kFlagPadded)
+    {
+        if (payload.empty())
+        {
+            return ConnectionError(kProtocolError, "HEADERS padding");
+        }
+        padding = static_cast<unsigned char>(payload[0]);
+        payload.remove_prefix(1);
+    }
+    if (flags & kFlagPriority)
+    {
+        if (payload.size() < 5)
+        {
+            return ConnectionError(kFrameSizeError, "HEADERS priority");
+        }
+        payload.remove_prefix(5);
+    }
+    if (padding > payload.size())
+    {
+        return ConnectionError(kProtocolError, "HEADERS padding");
+    }
+    payload.remove_suffix(padding);
+
+    std::shared_ptr<Stream> stream;
+    if (stream_id > m_last_stream_id)
+    {
+        m_last_stream_id = stream_id;
+        stream = std::make_shared<Stream>();
+        stream->id = stream_id;
+    }
+    else
+    {
+        // Trailers on a stream whose body is still arriving
+        std::lock_guard<std::mutex> lock(m_state_mutex);
+        auto it = m_streams.find(stream_id);
+        if (it == m_streams.end() || it->second->remote_closed)
+        {
+            return ConnectionError(kStreamClosed, "HEADERS on closed stream");
+        }
+        stream = it->second;
+        if (!(flags & kFlagEndStream))
+        {
+            return ConnectionError(kProtocolError, "trailers without END_STREAM");
+        }
+    }
+
+    stream->header_block.assign(payload.data(), payload.size());
+    if (flags & kFlagEndHeaders)
+    {
+        return FinishHeaders(stream, (flags & kFlagEndStream) != 0);
+    }
+
+    m_pending_headers = stream;
+    m_pending_end_stream = (flags & kFlagEndStream) != 0;
+    return true;
+}
+
+bool Http2Connection::HandleContinuation(uint8_t flags, uint32_t stream_id, std::string_view payload)
+{
+    if (!m_pending_headers || m_pending_headers->id != stream_id)
+    {
+        return ConnectionError(kProtocolError, "unexpected CONTINUATION");
+    }
+
+    auto& block = m_pending_headers->header_block;
+    if (block.size() + payload.size() > kMaxHeaderBlock)
+    {
+        return ConnectionError(kEnhanceYourCalm, "header block too large");
+    }
+    block.append(payload.data(), payload.size());
+
+    if (!(flags & kFlagEndHeaders))
+    {
+        return true;
+    }
+
+    auto stream = std::move(m_pending_headers);
+    m_pending_headers.reset();
+    return FinishHeaders(stream, m_pending_end_stream);
+}
+
+bool Http2Connection::FinishHeaders(const std::shared_ptr<Stream>& stream, bool end_stream)
+{
+    // Always decode, even for refused streams, to keep HPACK state in sync
+    std::vector<http::HeaderField> fields;
+    const bool decoded = m_decoder.Decode(stream->header_block, fields);
+    stream->header_block.clear();
+    stream->header_block.shrink_to_fit();
+    if (!decoded)
+    {
+        return ConnectionError(kCompressionError, "HPACK decoding failed");
+    }
+
+    if (!stream->headers_done)
+    {
+        stream->headers = std::move(fields);
+        stream->headers_done = true;
+
+        std::unique_lock<std::mutex> lock(m_state_mutex);
+        if (m_streams.size() >= kMaxConcurrentStreams || m_goaway_received)
+        {
+            lock.unlock();
+            SendRstStream(stream->id, kRefusedStream);
+            return true;
+        }
+        stream->send_window = m_peer_initial_window;
+        m_streams[stream->id] = stream;
+    }
+
+    if (end_stream)
+    {
+        stream->remote_closed = true;
+        Dispatch(stream);
+    }
+    return true;
+}
+
+bool Http2Connection::HandleData(uint8_t flags, uint32_t stream_id, std::string_view payload)
+{
+    if (stream_id == 0)
+    {
+        return ConnectionError(kProtocolError, "DATA on stream 0");
+    }
+
+    // Flow control counts the whole payload including padding
+    m_recv_unacked += payload.size();
+    if (m_recv_unacked >= kLocalInitialWindow / 2)
+    {
+        SendWindowUpdate(0, static_cast<uint32_t>(m_recv_unacked));
+        m_recv_unacked = 0;
+    }
+
+    if (flags & kFlagPadded)
+    {
+        if (payload.empty() || static_cast<unsigned char>(payload[0]) >= payload.size())
+        {
+            return ConnectionError(kProtocolError, "DATA padding");
+        }
+        const size_t padding = static_cast<unsigned char>(payload[0]);
+        payload.remove_prefix(1);
+        payload.remove_suffix(padding);
+    }
+
+    std::shared_ptr<Stream> stream;
+    {
+        std::lock_guard<std::mutex> lock(m_state_mutex);
+        auto it = m_streams.find(stream_id);
+        if (it != m_streams.end())
+        {
+            stream = it->second;
+        }
+    }
+    if (!stream || stream->remote_closed)
+    {
+        if (stream_id > m_last_stream_id)
+        {
+            return ConnectionError(kProtocolError, "DATA on idle stream");
+        }
+        SendRstStream(stream_id, kStreamClosed);
+        return true;
+    }
+
+    if (stream->body.size() + payload.size() > kMaxRequestBody)
+    {
+        // Answer early and stop the upload (RFC 9113 section 8.1)
+        SendStatusOnly(stream_id, 413);
+        SendRstStream(stream_id, kNoError);
+        CloseStream(stream_id);
+        return true;
+    }
+    stream->body.append(payload.data(), payload.size());
+
+    if (flags & kFlagEndStream)
+    {
+        stream->remote_closed = true;
+        Dispatch(stream);
+    }
+    return true;
+}
+
+bool Http2Connection::HandleSettings(uint8_t flags, uint32_t stream_id, std::string_view payload)
+{
+    if (stream_id != 0)
+    {
+        return ConnectionError(kProtocolError, "SETTINGS on a stream");
+    }
+    if (flags & kFlagAck)
+    {
+        if (!payload.empty())
+        {
+            return ConnectionError(kFrameSizeError, "SETTINGS ACK with payload");
+        }
+        return true;
+    }
+    if (payload.size() % 6 != 0)
+    {
+        return ConnectionError(kFrameSizeError, "SETTINGS length");
+    }
+
+    const uint32_t error = ApplySettings(payload);
+    if (error != kNoError)
+    {
+        return ConnectionError(error, "invalid SETTINGS value");
+    }
+    SendFrame(kFrameSettings, kFlagAck, 0, {});
+    return true;
+}
+
+uint32_t Http2Connection::ApplySettings(std::string_view payload)
+{
+    for (size_t offset = 0; offset + 6 <= payload.size(); offset += 6)
+    {
+        const uint16_t id = static_cast<uint16_t>(
+            (static_cast<unsigned char>(payload[offset]) << 8) | static_cast<unsigned char>(payload[offset + 1]));
+        const uint32_t value = ReadUint32(payload.data() + offset + 2);
+
+        switch (id)
+        {
+            case kSettingsHeaderTableSize:
+            {
+                std::lock_guard<std::mutex> lock(m_send_mutex);
+                m_encoder.SetPeerMaxTableSize(value);
+                break;
+            }
+            case kSettingsEnablePush:
+                if (value > 1)
+                {
+                    return kProtocolError;
+                }
+                break;
+            case kSettingsInitialWindowSize:
+            {
+                if (value > kMaxWindow)
+                {
+                    return kFlowControlError;
+                }
+                // The delta applies to every open stream (RFC 9113 section 6.9.2)
+                std::lock_guard<std::mutex> lock(m_state_mutex);
+                const int64_t delta = static_cast<int64_t>(value) - m_peer_initial_window;
+                m_peer_initial_window = value;
+                for (auto& [id_, stream] : m_streams)
+                {
+                    stream->send_window += delta;
+                }
+                m_state_cv.notify_all();
+                break;
+            }
+            case kSettingsMaxFrameSize:
+            {
+                if (value < 16384 || value > 16777215)
+                {
+                    return kProtocolError;
+                }
+                std::lock_guard<std::mutex> lock(m_state_mutex);
+                m_peer_max_frame_size = value;
+                break;
+            }
+            case kSettingsMaxConcurrentStreams:
+            default:
+                // We never push, and unknown settings must be ignored
+                break;
+        }
+    }
+    return kNoError;
+}
+
+bool Http2Connection::HandleWindowUpdate(uint32_t stream_id, std::string_view payload)
+{
+    if (payload.size() != 4)
+    {
+        return ConnectionError(kFrameSizeError, "WINDOW_UPDATE length");
+    }
+    const uint32_t increment = ReadUint32(payload.data()) & 0x7fffffff;
+
+    std::unique_lock<std::mutex> lock(m_state_mutex);
+    if (stream_id == 0)
+    {
+        if (increment == 0)
+        {
+            lock.unlock();
+            return ConnectionError(kProtocolError, "zero WINDOW_UPDATE");
+        }
+        m_connection_send_window += increment;
+        if (m_connection_send_window > kMaxWindow)
+        {
+            lock.unlock();
+            return ConnectionError(kFlowControlError, "connection window overflow");
+        }
+    }
+    else
+    {
+        auto it = m_streams.find(stream_id);
+        if (it != m_streams.end())
+        {
+            auto& stream = it->second;
+            stream->send_window += increment;
+            if (increment == 0 || stream->send_window > kMaxWindow)
+            {
+                stream->reset = true;
+                m_streams.erase(it);
+                lock.unlock();
+                SendRstStream(stream_id, increment == 0 ? kProtocolError : kFlowControlError);
+                m_state_cv.notify_all();
+                return true;
+            }
+        }
+    }
+    m_state_cv.notify_all();
+    return true;
+}
+
+bool Http2Connection::HandleRstStream(uint32_t stream_id, std::string_view payload)
+{
+    if (stream_id == 0)
+    {
+        return ConnectionError(kProtocolError, "RST_STREAM on stream 0");
+    }
+    if (payload.size() != 4)
+    {
+        return ConnectionError(kFrameSizeError, "RST_STREAM length");
+    }
+
+    std::lock_guard<std::mutex> lock(m_state_mutex);
+    auto it = m_streams.find(stream_id);
+    if (it != m_streams.end())
+    {
+        it->second->reset = true;
+        m_streams.erase(it);
+    }
+    m_state_cv.notify_all();
+    return true;
+}
+
+bool Http2Connection::ConnectionError(uint32_t error_code, const std::string& reason)
+{
+    LOG_WARN(Http2Connection, "HTTP/2 connection error from " + m_client_ip + ": " + reason);
+    SendGoAway(error_code);
+    return false;
+}
+
+void Http2Connection::Dispatch(const std::shared_ptr<Stream>& stream)
+{
+    std::unique_lock<std::mutex> lock(m_state_mutex);
+    m_ready_streams.push_back(stream);
+    if (m_idle_workers > 0 || m_active_workers >= kMaxStreamWorkers)
+    {
+        m_work_cv.notify_one();
+        return;
+    }
+    ++m_active_workers;
+    lock.unlock();
+
+    try
+    {
+        std::thread([this]() { WorkerLoop(); }).detach();
+    }
+    catch (const std::system_error& e)
+    {
+        LOG_ERROR(Http2Connection, std::string("Failed to start stream worker: ") + e.what());
+
+        // Without any worker the queued streams would never be answered
+        std::deque<std::shared_ptr<Stream>> orphaned;
+        lock.lock();
+        --m_active_workers;
+        if (m_active_workers == 0)
+        {
+            orphaned.swap(m_ready_streams);
+        }
+        lock.unlock();
+
+        for (const auto& refused : orphaned)
+        {
+            SendRstStream(refused->id, kRefusedStream);
+            CloseStream(refused->id);
+        }
+    }
+}
+
+void Http2Connection::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_state_mutex);
+    while (!m_closed)
+    {
+        if (m_ready_streams.empty())
+        {
+            ++m_idle_workers;
+            m_work_cv.wait(lock, [this]() { return m_closed || !m_ready_streams.empty(); });
+            --m_idle_workers;
+            continue;
+        }
+
+        auto stream = std::move(m_ready_streams.front());
+        m_ready_streams.pop_front();
+        lock.unlock();
+        ProcessStream(stream);
+        lock.lock();
+    }
+
+    --m_active_workers;
+    m_state_cv.notify_all();
+}
+
+void Http2Connection::ProcessStream(const std::shared_ptr<Stream>& stream)
+{
+    const std::string request = stream->raw_request.empty() ? BuildHttp1Request(*stream) : stream->raw_request;
+    if (request.empty())
+    {
+        SendRstStream(stream->id, kProtocolError);
+        CloseStream(stream->id);
+        return;
+    }
+
+    std::string response;
+    try
+    {
+        response = m_handler(request);
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR(Http2Connection, std::string("Handler failed on HTTP/2 stream: ") + e.what());
+        SendRstStream(stream->id, kInternalError);
+        CloseStream(stream->id);
+        return;
+    }
+
+    SendResponse(stream, response);
+    CloseStream(stream->id);
+}
+
+std::string Http2Connection::BuildHttp1Request(const Stream& stream)
+{
+    std::string method;
+    std::string path;
+    std::string authority;
+    std::string header_lines;
+    std::string cookie;
+    bool has_host = false;
+    bool has_length = false;
+
+    for (const auto& [name, value] : stream.headers)
+    {
+        if (!name.empty() && name[0] == ':')
+        {
+            if (name == ":method") method = value;
+            else if (name == ":path") path = value;
+            else if (name == ":authority") authority = value;
+            else if (name != ":scheme") return "";
+            continue;
+        }
+
+        // Split cookie crumbs are joined back (RFC 9113 section 8.2.3)
+        if (name == "cookie")
+        {
+            cookie += cookie.empty() ? value : "; " + value;
+            continue;
+        }
+        if (IsConnectionSpecific(name))
+        {
+            continue;
+        }
+        has_host |= name == "host";
+        has_length |= name == "content-length";
+        header_lines += name + ": " + value + "\r\n";
+    }
+
+    if (method.empty() || path.empty())
+    {
+        return "";
+    }
+
+    std::string request = method + " " + path + " HTTP/1.1\r\n";
+    if (!has_host && !authority.empty())
+    {
+        request += "host: " + authority + "\r\n";
+    }
+    request += header_lines;
+    if (!cookie.empty())
+    {
+        request += "cookie: " + cookie + "\r\n";
+    }
+    if (!has_length && !stream.body.empty())
+    {
+        request += "content-length: " + std::to_string(stream.body.size()) + "\r\n";
+    }
+    request += "\r\n";
+    request += stream.body;
+    return request;
+}
+
+void Http2Connection::SendResponse(const std::shared_ptr<Stream>& stream, const std::string& response)
+{
+    // Status line: "HTTP/1.1 200 OK"
+    const size_t status_end = response.find("\r\n");
+    const size_t head_end = response.find("\r\n\r\n");
+    if (status_end == std::string::npos || head_end == std::string::npos || status_end < 12)
+    {
+        SendRstStream(stream->id, kInternalError);
+        return;
+    }
+
+    std::vector<http::HeaderField> headers;
+    headers.emplace_back(":status", response.substr(9, 3));
+
+    size_t line_start = status_end + 2;
+    while (line_start < head_end + 2)
+    {
+        const size_t line_end = response.find("\r\n", line_start);
+        const std::string_view line(response.data() + line_start, line_end - line_start);
+        const size_t colon = line.find(':');
+        if (colon != std::string_view::npos)
+        {
+            std::string name = ToLower(line.substr(0, colon));
+            std::string_view value = line.substr(colon + 1);
+            while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+            if (!IsConnectionSpecific(name))
+            {
+                headers.emplace_back(std::move(name), std::string(value));
+            }
+        }
+        line_start = line_end + 2;
+    }
+
+    const std::string_view body(response.data() + head_end + 4, response.size() - head_end - 4);
+
+    // Whatever the window allows right now goes out in the same write as the
+    // headers, so small responses cost a single send
+    size_t offset = body.empty() ? 0 : AcquireSendWindow(stream, body.size(), false);
+    if (!SendHeaderBlock(stream->id, headers, offset == body.size(), body.substr(0, offset)))
+    {
+        return;
+    }
+
+    while (offset < body.size())
+    {
+        const size_t chunk = AcquireSendWindow(stream, body.size() - offset, true);
+        if (chunk == 0)
+        {
+            return;
+        }
+
+        std::string frames;
+        AppendDataFrames(frames, stream->id, body.substr(offset, chunk), offset + chunk == body.size());
+        std::lock_guard<std::mutex> lock(m_send_mutex);
+        if (!WriteAll(frames))
+        {
+            return;
+        }
+        offset += chunk;
+    }
+}
+
+size_t Http2Connection::AcquireSendWindow(const std::shared_ptr<Stream>& stream, size_t wanted, bool wait)
+{
+    std::unique_lock<std::mutex> lock(m_state_mutex);
+    auto available = [&]()
+    {
+        return m_connection_send_window > 0 && stream->send_window > 0;
+    };
+
+    if (wait)
+    {
+        m_state_cv.wait(lock, [&]() { return m_closed || stream->reset || available(); });
+    }
+    if (m_closed || stream->reset || !available())
+    {
+        return 0;
+    }
+
+    const size_t granted = std::min({wanted,
+                                     static_cast<size_t>(m_connection_send_window),
+                                     static_cast<size_t>(stream->send_window)});
+    m_connection_send_window -= static_cast<int64_t>(granted);
+    stream->send_window -= static_cast<int64_t>(granted);
+    return granted;
+}
+
+void Http2Connection::AppendDataFrames(std::string& output, uint32_t stream_id, std::string_view data, bool end_stream)
+{
+    size_t max_frame_size;
+    {
+        std::lock_guard<std::mutex> lock(m_state_mutex);
+        max_frame_size = m_peer_max_frame_size;
+    }
+
+    size_t offset = 0;
+    do
+    {
+        const size_t chunk = std::min(data.size() - offset, max_frame_size);
+        const bool last = offset + chunk == data.size();
+        AppendFrameHeader(output, chunk, kFrameData, last && end_stream ? kFlagEndStream : 0, stream_id);
+        output.append(data.data() + offset, chunk);
+        offset += chunk;
+    } while (offset < data.size());
+}
+
+void Http2Connection::SendStatusOnly(uint32_t stream_id, int status)
+{
+    SendHeaderBlock(stream_id, {{":status", std::to_string(status)}}, true);
+}
+
+bool Http2Connection::SendHeaderBlock(uint32_t stream_id, const std::vector<http::HeaderField>& headers,
+                                      bool end_stream, std::string_view data)
+{
+    size_t max_frame_size;
+    {
+        std::lock_guard<std::mutex> lock(m_state_mutex);
+        max_frame_size = m_peer_max_frame_size;
+    }
+
+    // Encoding and writing must happen atomically: the peer decodes blocks in
+    // the order they arrive and the dynamic table depends on it
+    std::lock_guard<std::mutex> lock(m_send_mutex);
+    std::string block;
+    m_encoder.Encode(headers, block);
+
+    std::string frames;
+    size_t offset = 0;
+    bool first = true;
+    do
+    {
+        const size_t chunk = std::min(block.size() - offset, max_frame_size);
+        const bool end_headers = offset + chunk == block.size();
+        uint8_t flags = end_headers ? kFlagEndHeaders : 0;
+        if (first && end_stream && data.empty())
+        {
+            flags |= kFlagEndStream;
+        }
+        AppendFrameHeader(frames, chunk, first ? kFrameHeaders : kFrameContinuation, flags, stream_id);
+        frames.append(block, offset, chunk);
+        offset += chunk;
+        first = false;
+    } while (offset < block.size());
+
+    if (!data.empty())
+    {
+        AppendDataFrames(frames, stream_id, data, end_stream);
+    }
+    return WriteAll(frames);
+}
+
+bool Http2Connection::SendFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload)
+{
+    std::string frame;
+    frame.reserve(9 + payload.size());
+    AppendFrameHeader(frame, payload.size(), type, flags, stream_id);
+    frame.append(payload.data(), payload.size());
+
+    std::lock_guard<std::mutex> lock(m_send_mutex);
+    return WriteAll(frame);
+}
+
+bool Http2Connection::WriteAll(std::string_view data)
+{
+#ifdef MSG_NOSIGNAL
+    constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kSendFlags = 0;
+#endif
+    size_t total_sent = 0;
+    while (total_sent < data.size())
+    {
+        const int sent = send(m_socket, data.data() + total_sent,
+                              static_cast<int>(data.size() - total_sent), kSendFlags);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        total_sent += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+void Http2Connection::SendSettings()
+{
+    std::string payload;
+    AppendSetting(payload, kSettingsMaxConcurrentStreams, kMaxConcurrentStreams);
+    AppendSetting(payload, kSettingsInitialWindowSize, kLocalInitialWindow);
+    SendFrame(kFrameSettings, 0, 0, payload);
+
+    // Raise the connection window to match the stream window
+    SendWindowUpdate(0, static_cast<uint32_t>(kLocalInitialWindow - kDefaultWindow));
+}
+
+void Http2Connection::SendWindowUpdate(uint32_t stream_id, uint32_t increment)
+{
+    std::string payload;
+    AppendUint32(payload, increment & 0x7fffffff);
+    SendFrame(kFrameWindowUpdate, 0, stream_id, payload);
+}
+
+void Http2Connection::SendRstStream(uint32_t stream_id, uint32_t error_code)
+{
+    std::string payload;
+    AppendUint32(payload, error_code);
+    SendFrame(kFrameRstStream, 0, stream_id, payload);
+}
+
+void Http2Connection::SendGoAway(uint32_t error_code)
+{
+    std::string payload;
+    AppendUint32(payload, m_last_stream_id);
+    AppendUint32(payload, error_code);
+    SendFrame(kFrameGoAway, 0, 0, payload);
+}
+
+void Http2Connection::CloseStream(uint32_t stream_id)
+{
+    std::lock_guard<std::mutex> lock(m_state_mutex);
+    m_streams.erase(stream_id);
+    m_state_cv.notify_all();
+}
+
+} // namespace miniserver::network
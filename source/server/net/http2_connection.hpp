@@ -0,0 +1,256 @@
+/**
+ * @file http2_connection.hpp
+ * @brief HTTP/2 cleartext (h2c) connection handling
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/socket_server.hpp"
+#include "net/hpack.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Serves one HTTP/2 connection on the calling thread
+ *
+ * The connection thread reads and parses frames; every stream whose request
+ * is complete is queued for a small per-connection pool of worker threads
+ * that call the same RequestHandler used for HTTP/1.1, so streams on one
+ * connection run concurrently and reach RequestRouter unchanged. Responses are sent back as
+ * HEADERS + DATA frames subject to connection and stream flow control.
+ *
+ * Both ways into h2c are supported:
+ *  - prior knowledge: the client starts with the connection preface;
+ *  - HTTP/1.1 "Upgrade: h2c": the upgrade request becomes stream 1.
+ */
+class Http2Connection
+{
+public:
+    /**
+     * @brief Construct a connection handler
+     * @param client_socket Connected socket (not closed by this class)
+     * @param handler Request handler taking/returning HTTP/1.1 messages
+     * @param client_ip Peer address for logging
+     */
+    Http2Connection(SOCKET client_socket, RequestHandler handler, std::string client_ip);
+
+    /**
+     * @brief Destructor (waits for in-flight stream workers)
+     */
+    ~Http2Connection();
+
+    Http2Connection(const Http2Connection&) = delete;
+    Http2Connection& operator=(const Http2Connection&) = delete;
+
+    /**
+     * @brief Serve a prior-knowledge connection until it closes
+     * @param received Bytes already read from the socket (starting with the preface)
+     */
+    void ServePriorKnowledge(std::string received);
+
+    /**
+     * @brief Switch an HTTP/1.1 connection to h2c and serve it until it closes
+     * @param upgrade_request Complete HTTP/1.1 request carrying "Upgrade: h2c"
+     * @param received Bytes read after the upgrade request
+     * @return false if the upgrade was declined (invalid HTTP2-Settings); nothing
+     *         has been written and the caller continues with HTTP/1.1
+     */
+    bool ServeUpgrade(const std::string& upgrade_request, std::string received);
+
+    /**
+     * @brief Check whether data starts with (a prefix of) the HTTP/2 connection preface
+     * @param data Received bytes
+     * @return true if the data is consistent with the preface so far
+     */
+    static bool StartsWithPreface(std::string_view data);
+
+    /**
+     * @brief Check whether an HTTP/1.1 request asks to upgrade to h2c
+     * @param request_head Request line and headers
+     * @return true if "Upgrade: h2c" and "HTTP2-Settings" are present
+     */
+    static bool IsUpgradeRequest(std::string_view request_head);
+
+private:
+    /**
+     * @brief Per-stream state
+     */
+    struct Stream
+    {
+        uint32_t id = 0;                        ///< Stream identifier
+        std::string header_block;               ///< Header block being assembled (HEADERS + CONTINUATION)
+        std::vector<http::HeaderField> headers; ///< Decoded request headers
+        std::string body;                       ///< Request body
+        bool headers_done = false;              ///< Request headers decoded (further blocks are trailers)
+        bool remote_closed = false;             ///< END_STREAM received
+        bool reset = false;                     ///< Stream reset by either side
+        int64_t send_window = 0;                ///< Peer's receive window for this stream
+        std::string raw_request;                ///< Pre-built request for an upgraded stream 1
+    };
+
+    /**
+     * @brief Frame reading loop shared by both entry points
+     */
+    void Serve();
+
+    /**
+     * @brief Make sure enough unparsed bytes are buffered
+     * @param size Number of bytes required past m_recv_offset
+     * @return false on EOF, error or timeout
+     */
+    bool Fill(size_t size);
+
+    /**
+     * @brief Process one complete frame
+     * @return false if the connection must be closed
+     */
+    bool HandleFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload);
+
+    bool HandleHeaders(uint8_t flags, uint32_t stream_id, std::string_view payload);
+    bool HandleContinuation(uint8_t flags, uint32_t stream_id, std::string_view payload);
+    bool HandleData(uint8_t flags, uint32_t stream_id, std::string_view payload);
+    bool HandleSettings(uint8_t flags, uint32_t stream_id, std::string_view payload);
+    bool HandleWindowUpdate(uint32_t stream_id, std::string_view payload);
+    bool HandleRstStream(uint32_t stream_id, std::string_view payload);
+
+    /**
+     * @brief Apply a SETTINGS payload received from the peer
+     * @return HTTP/2 error code, 0 (NO_ERROR) if all settings were valid
+     */
+    uint32_t ApplySettings(std::string_view payload);
+
+    /**
+     * @brief Decode a completed header block and dispatch if the request is complete
+     * @return false on a compression error
+     */
+    bool FinishHeaders(const std::shared_ptr<Stream>& stream, bool end_stream);
+
+    /**
+     * @brief Close the connection with a GOAWAY frame
+     * @param error_code HTTP/2 error code
+     * @param reason Log message
+     * @return Always false, so frame handlers can "return ConnectionError(...)"
+     */
+    bool ConnectionError(uint32_t error_code, const std::string& reason);
+
+    /**
+     * @brief Queue a complete stream for the worker pool (starting a worker if needed)
+     * @param stream Stream whose request is complete
+     */
+    void Dispatch(const std::shared_ptr<Stream>& stream);
+
+    /**
+     * @brief Worker thread body: process queued streams until the connection closes
+     */
+    void WorkerLoop();
+
+    /**
+     * @brief Worker body: invoke handler and send the response
+     * @param stream Stream to answer
+     */
+    void ProcessStream(const std::shared_ptr<Stream>& stream);
+
+    /**
+     * @brief Send a complete HTTP/1.1 response (as produced by the handler) on a stream
+     * @param stream Target stream
+     * @param response Serialized HTTP/1.1 response
+     */
+    void SendResponse(const std::shared_ptr<Stream>& stream, const std::string& response);
+
+    /**
+     * @brief Send a header-only response with the given status and END_STREAM
+     */
+    void SendStatusOnly(uint32_t stream_id, int status);
+
+    /**
+     * @brief Encode and send a header block (HEADERS + CONTINUATION frames)
+     * @param stream_id Stream identifier
+     * @param headers Header fields
+     * @param end_stream Whether the stream ends with this write
+     * @param data Optional body bytes (already charged to the windows) sent in the
+     *        same write after the header block
+     */
+    bool SendHeaderBlock(uint32_t stream_id, const std::vector<http::HeaderField>& headers,
+                         bool end_stream, std::string_view data = {});
+
+    /**
+     * @brief Take up to `wanted` bytes from the connection and stream send windows
+     * @param stream Stream sending the data
+     * @param wanted Bytes still to send
+     * @param wait Block until some window is available
+     * @return Bytes granted; 0 if nothing is available (or the stream/connection closed)
+     */
+    size_t AcquireSendWindow(const std::shared_ptr<Stream>& stream, size_t wanted, bool wait);
+
+    /**
+     * @brief Append DATA frames for a body chunk, split by the peer's max frame size
+     */
+    void AppendDataFrames(std::string& output, uint32_t stream_id, std::string_view data, bool end_stream);
+
+    /**
+     * @brief Build an HTTP/1.1 request from decoded HTTP/2 headers and body
+     */
+    static std::string BuildHttp1Request(const Stream& stream);
+
+    /**
+     * @brief Send one frame (thread-safe)
+     */
+    bool SendFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload);
+
+    /**
+     * @brief Write raw bytes to the socket; caller holds m_send_mutex
+     */
+    bool WriteAll(std::string_view data);
+
+    void SendSettings();
+    void SendWindowUpdate(uint32_t stream_id, uint32_t increment);
+    void SendRstStream(uint32_t stream_id, uint32_t error_code);
+    void SendGoAway(uint32_t error_code);
+
+    /**
+     * @brief Remove a stream from the table once both sides are done
+     */
+    void CloseStream(uint32_t stream_id);
+
+    SOCKET m_socket;                                        ///< Connection socket
+    RequestHandler m_handler;                               ///< Request handler (HTTP/1.1 messages)
+    std::string m_client_ip;                                ///< Peer address
+    std::string m_recv_buffer;                              ///< Unparsed received bytes
+    size_t m_recv_offset = 0;                               ///< Parse position in m_recv_buffer
+
+    http::HpackDecoder m_decoder;                           ///< Request header decoder (reader thread only)
+    http::HpackEncoder m_encoder;                           ///< Response header encoder (under m_send_mutex)
+    std::mutex m_send_mutex;                                ///< Serializes frame writes
+
+    std::mutex m_state_mutex;                               ///< Protects streams, windows and settings below
+    std::condition_variable m_state_cv;                     ///< Signals window updates, resets, worker exit
+    std::condition_variable m_work_cv;                      ///< Signals queued streams to idle workers
+    std::deque<std::shared_ptr<Stream>> m_ready_streams;    ///< Complete streams awaiting a worker
+    size_t m_idle_workers = 0;                              ///< Workers waiting for a stream
+    std::unordered_map<uint32_t, std::shared_ptr<Stream>> m_streams; ///< Open streams
+    int64_t m_connection_send_window = 65535;               ///< Peer's connection receive window
+    int64_t m_peer_initial_window = 65535;                  ///< Peer's SETTINGS_INITIAL_WINDOW_SIZE
+    uint32_t m_peer_max_frame_size = 16384;                 ///< Peer's SETTINGS_MAX_FRAME_SIZE
+    size_t m_active_workers = 0;                            ///< Running worker threads
+    bool m_closed = false;                                  ///< Connection is shutting down
+
+    uint32_t m_last_stream_id = 0;                          ///< Highest client stream id seen
+    std::shared_ptr<Stream> m_pending_headers;              ///< Stream whose header block awaits CONTINUATION
+    bool m_pending_end_stream = false;                      ///< END_STREAM flag of the pending HEADERS
+    size_t m_recv_unacked = 0;                              ///< Received DATA bytes not yet returned via WINDOW_UPDATE
+    bool m_goaway_received = false;                         ///< Peer sent GOAWAY
+};
+
+} // namespace miniserver::network
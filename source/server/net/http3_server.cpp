@@ -0,0 +1,902 @@
+/**
+ * @file http3_server.cpp
+ * @brief HTTP/3 over QUIC listener implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/http3_server.hpp"
+#include "net/qpack.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+#if defined(MINISERVER_HAS_HTTP3) && !defined(_WIN32)
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Per-connection HTTP/3 state (loop thread only)
+ */
+struct Http3Server::Connection
+{
+    /**
+     * @brief Request stream being received
+     */
+    struct Request
+    {
+        std::string buffer;                         ///< Bytes of incomplete frames
+        std::vector<http::HeaderField> headers;     ///< Decoded request fields
+        std::string body;                           ///< DATA frame payloads
+        bool has_headers = false;                   ///< HEADERS frame seen
+        bool done = false;                          ///< Queued for a worker or rejected
+        bool rejected = false;                      ///< Answered with an error before the body ended
+    };
+
+    /**
+     * @brief Peer unidirectional stream
+     */
+    struct Unidirectional
+    {
+        uint64_t type = UINT64_MAX;                 ///< Stream type, UINT64_MAX until read
+        std::string buffer;                         ///< Bytes of incomplete frames (control stream)
+        bool settings = false;                      ///< Control stream: SETTINGS received
+    };
+
+    uint64_t serial = 0;                            ///< Key in m_connections
+    std::unique_ptr<QuicConnection> quic;           ///< Transport
+    std::vector<std::string> ids;                   ///< Keys in m_routes
+    std::map<uint64_t, Request> requests;           ///< Open request streams
+    std::map<uint64_t, Unidirectional> unidirectional; ///< Peer unidirectional streams
+    bool peer_control = false;                      ///< Peer control stream opened
+};
+
+#if defined(MINISERVER_HAS_HTTP3) && !defined(_WIN32)
+
+namespace
+{
+    // Frame types (RFC 9114 section 7.2)
+    constexpr uint64_t kFrameData = 0x00;
+    constexpr uint64_t kFrameHeaders = 0x01;
+    constexpr uint64_t kFrameCancelPush = 0x03;
+    constexpr uint64_t kFrameSettings = 0x04;
+    constexpr uint64_t kFramePushPromise = 0x05;
+    constexpr uint64_t kFrameGoaway = 0x07;
+    constexpr uint64_t kFrameMaxPushId = 0x0d;
+
+    // Unidirectional stream types
+    constexpr uint64_t kStreamControl = 0x00;
+    constexpr uint64_t kStreamPush = 0x01;
+    constexpr uint64_t kStreamQpackEncoder = 0x02;
+    constexpr uint64_t kStreamQpackDecoder = 0x03;
+
+    // Error codes (RFC 9114 section 8.1, RFC 9204 section 6)
+    constexpr uint64_t kNoError = 0x100;
+    constexpr uint64_t kInternalError = 0x102;
+    constexpr uint64_t kStreamCreationError = 0x103;
+    constexpr uint64_t kClosedCriticalStream = 0x104;
+    constexpr uint64_t kFrameUnexpected = 0x105;
+    constexpr uint64_t kFrameError = 0x106;
+    constexpr uint64_t kExcessiveLoad = 0x107;
+    constexpr uint64_t kSettingsError = 0x109;
+    constexpr uint64_t kMissingSettings = 0x10a;
+    constexpr uint64_t kRequestIncomplete = 0x10d;
+    constexpr uint64_t kMessageError = 0x10e;
+    constexpr uint64_t kDecompressionFailed = 0x200;
+
+    constexpr size_t kMaxFieldSection = 64 * 1024;      ///< Largest HEADERS frame accepted
+    constexpr size_t kMaxControlFrame = 16 * 1024;      ///< Largest control stream frame accepted
+    constexpr size_t kReceiveRounds = 8;                ///< Receive batches per loop iteration
+
+    /**
+     * @brief Split the next complete frame off a buffer
+     * @return false if the frame is not complete yet
+     */
+    bool NextFrame(std::string_view& input, uint64_t& type, uint64_t& length, std::string_view& payload)
+    {
+        std::string_view rest = input;
+        if (!quic::ReadVarint(rest, type) || !quic::ReadVarint(rest, length))
+        {
+            return false;
+        }
+        if (rest.size() < length)
+        {
+            payload = {};
+            return false;
+        }
+        payload = rest.substr(0, static_cast<size_t>(length));
+        input = rest.substr(static_cast<size_t>(length));
+        return true;
+    }
+
+    /**
+     * @brief Peek at the length of the next frame, even if incomplete
+     */
+    bool PeekFrameLength(std::string_view input, uint64_t& type, uint64_t& length)
+    {
+        return quic::ReadVarint(input, type) && quic::ReadVarint(input, length);
+    }
+
+    /**
+     * @brief HTTP/2 frame types that are reserved in HTTP/3 and any frame that belongs on the control stream
+     */
+    bool IsRequestStreamViolation(uint64_t type)
+    {
+        return type == kFrameCancelPush || type == kFrameSettings || type == kFramePushPromise || type == kFrameGoaway
+            || type == kFrameMaxPushId || type == 0x02 || type == 0x06 || type == 0x08 || type == 0x09;
+    }
+
+    /**
+     * @brief Headers that have no meaning in HTTP/3 (RFC 9114 section 4.2)
+     */
+    bool IsConnectionSpecific(std::string_view name)
+    {
+        return name == "connection" || name == "keep-alive" || name == "proxy-connection" || name == "transfer-encoding"
+            || name == "upgrade";
+    }
+
+    /**
+     * @brief Turn decoded request fields and body into an HTTP/1.1 request
+     * @return Empty if the request is malformed
+     */
+    std::string BuildHttp1Request(const std::vector<http::HeaderField>& headers, const std::string& body)
+    {
+        std::string method;
+        std::string path;
+        std::string authority;
+        std::string header_lines;
+        std::string cookie;
+        bool has_host = false;
+        bool has_length = false;
+        bool regular_seen = false;
+
+        for (const auto& [name, value] : headers)
+        {
+            if (name.empty() || std::any_of(name.begin(), name.end(), [](unsigned char c) { return std::isupper(c); }))
+            {
+                return "";
+            }
+            if (name[0] == ':')
+            {
+                if (regular_seen)
+                {
+                    return "";
+                }
+                if (name == ":method") method = value;
+                else if (name == ":path") path = value;
+                else if (name == ":authority") authority = value;
+                else if (name != ":scheme") return "";
+                continue;
+            }
+            regular_seen = true;
+            if (name == "cookie")
+            {
+                cookie += cookie.empty() ? value : "; " + value;
+                continue;
+            }
+            if (IsConnectionSpecific(name) || (name == "te" && value != "trailers"))
+            {
+                return "";
+            }
+            has_host |= name == "host";
+            has_length |= name == "content-length";
+            header_lines += name + ": " + value + "\r\n";
+        }
+        if (method.empty() || path.empty())
+        {
+            return "";
+        }
+
+        std::string request = method + " " + path + " HTTP/1.1\r\n";
+        if (!has_host && !authority.empty())
+        {
+            request += "host: " + authority + "\r\n";
+        }
+        request += header_lines;
+        if (!cookie.empty())
+        {
+            request += "cookie: " + cookie + "\r\n";
+        }
+        if (!has_length && !body.empty())
+        {
+            request += "content-length: " + std::to_string(body.size()) + "\r\n";
+        }
+        request += "\r\n";
+        request += body;
+        return request;
+    }
+
+    /**
+     * @brief Split an HTTP/1.1 response into HTTP/3 fields and body
+     * @return false if the response is malformed
+     */
+    bool ParseHttp1Response(const std::string& response, std::vector<http::HeaderField>& headers, std::string_view& body)
+    {
+        const size_t status_end = response.find("\r\n");
+        const size_t head_end = response.find("\r\n\r\n");
+        if (status_end == std::string::npos || head_end == std::string::npos || status_end < 12)
+        {
+            return false;
+        }
+        headers.emplace_back(":status", response.substr(9, 3));
+
+        size_t line_start = status_end + 2;
+        while (line_start < head_end + 2)
+        {
+            const size_t line_end = response.find("\r\n", line_start);
+            const std::string_view line(response.data() + line_start, line_end - line_start);
+            const size_t colon = line.find(':');
+            if (colon != std::string_view::npos)
+            {
+                std::string name(line.substr(0, colon));
+                std::transform(name.begin(), name.end(), name.begin(),
+                               [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                std::string_view value = line.substr(colon + 1);
+                while (!value.empty() && value.front() == ' ')
+                {
+                    value.remove_prefix(1);
+                }
+                if (!IsConnectionSpecific(name))
+                {
+                    headers.emplace_back(std::move(name), std::string(value));
+                }
+            }
+            line_start = line_end + 2;
+        }
+        body = std::string_view(response).substr(head_end + 4);
+        return true;
+    }
+
+    /**
+     * @brief Serialized response for requests refused before reaching the handler
+     */
+    std::string ErrorResponse(int status, const char* reason)
+    {
+        const std::string body = std::string("{\"error\":\"") + reason + "\"}";
+        return "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\ncontent-type: application/json\r\ncontent-length: "
+             + std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+} // namespace
+
+Http3Server::Http3Server(RequestHandler handler)
+    : m_handler(std::move(handler))
+{
+}
+
+Http3Server::~Http3Server()
+{
+    Stop();
+}
+
+bool Http3Server::Start(const Http3ServerOptions& options)
+{
+    if (m_running.load())
+    {
+        return false;
+    }
+    m_options = options;
+    m_options.workers = std::max<size_t>(1, m_options.workers);
+
+    std::string error;
+    m_credentials = QuicCredentials::Load(options.certificate_file, options.key_file, error);
+    if (!m_credentials)
+    {
+        LOG_ERROR_FMT(Http3Server, "Cannot load HTTP/3 certificate: {}", error);
+        return false;
+    }
+    if (!m_socket.Open(options.host, options.port))
+    {
+        LOG_ERROR_FMT(Http3Server, "Cannot bind UDP {}:{}: {}", options.host, options.port, UdpSocket::LastError());
+        return false;
+    }
+    if (pipe(m_wake_pipe) != 0)
+    {
+        LOG_ERROR_FMT(Http3Server, "Cannot create wake pipe: {}", UdpSocket::LastError());
+        m_socket.Close();
+        return false;
+    }
+    for (int descriptor : m_wake_pipe)
+    {
+        fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+        fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+    }
+
+    m_running.store(true);
+    m_loop_thread = std::thread(&Http3Server::Loop, this);
+    for (size_t i = 0; i < m_options.workers; ++i)
+    {
+        m_workers.emplace_back(&Http3Server::WorkerLoop, this);
+    }
+    LOG_INFO_FMT(Http3Server, "HTTP/3 listening on udp {}:{} (GSO {}, GRO {})", options.host, m_socket.Port(),
+                 m_socket.UsesGso() ? "on" : "off", m_socket.UsesGro() ? "on" : "off");
+    return true;
+}
+
+void Http3Server::Stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+    Wake();
+    m_jobs_cv.notify_all();
+    if (m_loop_thread.joinable())
+    {
+        m_loop_thread.join();
+    }
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+
+    m_connections.clear();
+    m_routes.clear();
+    m_requests.clear();
+    m_responses.clear();
+    m_active.store(0);
+    m_socket.Close();
+    for (int& descriptor : m_wake_pipe)
+    {
+        close(descriptor);
+        descriptor = -1;
+    }
+    LOG_INFO(Http3Server, "HTTP/3 listener stopped");
+}
+
+Http3Stats Http3Server::GetStats() const
+{
+    Http3Stats stats;
+    stats.accepted = m_accepted.load();
+    stats.established = m_established.load();
+    stats.active = m_active.load();
+    stats.requests = m_request_count.load();
+    stats.datagrams_received = m_datagrams_received.load();
+    stats.datagrams_sent = m_datagrams_sent.load();
+    return stats;
+}
+
+void Http3Server::Wake()
+{
+    const char byte = 1;
+    if (m_wake_pipe[1] >= 0)
+    {
+        (void)!write(m_wake_pipe[1], &byte, 1);
+    }
+}
+
+void Http3Server::Loop()
+{
+    UdpReceiveBatch batch;
+    pollfd descriptors[2] = {{m_socket.Descriptor(), POLLIN, 0}, {m_wake_pipe[0], POLLIN, 0}};
+
+    while (m_running.load())
+    {
+        quic::TimePoint deadline = quic::TimePoint::max();
+        for (const auto& entry : m_connections)
+        {
+            deadline = std::min(deadline, entry.second->quic->NextTimeout());
+        }
+        int timeout_ms = 1000;
+        if (deadline != quic::TimePoint::max())
+        {
+            const auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - quic::Clock::now()).count();
+            timeout_ms = static_cast<int>(std::clamp<int64_t>(wait, 0, 1000));
+        }
+        if (poll(descriptors, 2, timeout_ms) < 0 && errno != EINTR)
+        {
+            LOG_ERROR_FMT(Http3Server, "poll failed: {}", UdpSocket::LastError());
+            break;
+        }
+        if ((descriptors[1].revents & POLLIN) != 0)
+        {
+            char drain[64];
+            while (read(m_wake_pipe[0], drain, sizeof(drain)) > 0)
+            {
+            }
+        }
+
+        quic::TimePoint now = quic::Clock::now();
+        DrainResponses();
+        for (size_t round = 0; round < kReceiveRounds && m_socket.Receive(batch) && batch.Count() > 0; ++round)
+        {
+            m_datagrams_received.fetch_add(batch.Count(), std::memory_order_relaxed);
+            for (size_t i = 0; i < batch.Count(); ++i)
+            {
+                OnDatagram(batch.Data(i), batch.Peer(i), now);
+            }
+        }
+
+        now = quic::Clock::now();
+        std::vector<uint64_t> closed;
+        for (auto& entry : m_connections)
+        {
+            QuicConnection& quic = *entry.second->quic;
+            if (now >= quic.NextTimeout())
+            {
+                quic.OnTimeout(now);
+            }
+            quic.Flush(now, m_send_batch);
+            if (quic.GetState() == QuicConnection::State::kClosed)
+            {
+                closed.push_back(entry.first);
+            }
+        }
+        if (!m_send_batch.Empty())
+        {
+            m_datagrams_sent.fetch_add(m_socket.Send(m_send_batch), std::memory_order_relaxed);
+        }
+        for (const uint64_t serial : closed)
+        {
+            RemoveConnection(serial);
+        }
+    }
+
+    // Tell every peer we are going away so it does not wait for its idle timeout
+    const quic::TimePoint now = quic::Clock::now();
+    for (auto& entry : m_connections)
+    {
+        entry.second->quic->Close(kNoError, true, "server stopping");
+        entry.second->quic->Flush(now, m_send_batch);
+    }
+    m_socket.Send(m_send_batch);
+}
+
+void Http3Server::OnDatagram(std::string_view datagram, const UdpAddress& peer, quic::TimePoint now)
+{
+    quic::PacketHeader header;
+    if (!quic::ParseHeader(datagram, quic::kConnectionIdLength, header))
+    {
+        return;
+    }
+
+    auto route = m_routes.find(std::string(header.destination));
+    if (route != m_routes.end())
+    {
+        route->second->quic->Receive(datagram, now);
+        return;
+    }
+    if (header.type == quic::PacketType::kOneRtt || datagram.size() < quic::kMinInitialDatagram)
+    {
+        return;     // Unknown connection; too small to answer without amplifying
+    }
+    if (header.version != quic::kVersion1)
+    {
+        if (header.version != 0)
+        {
+            m_send_batch.Add(peer, quic::BuildVersionNegotiation(header.source, header.destination));
+        }
+        return;
+    }
+    if (header.type == quic::PacketType::kInitial && header.destination.size() >= 8)
+    {
+        AcceptConnection(datagram, peer, header, now);
+    }
+}
+
+void Http3Server::AcceptConnection(std::string_view datagram, const UdpAddress& peer, const quic::PacketHeader& header,
+                                   quic::TimePoint now)
+{
+    if (m_connections.size() >= m_options.max_connections)
+    {
+        return;
+    }
+    auto quic = QuicConnection::Accept(m_credentials, m_options.connection, peer, header.destination, header.source);
+    if (!quic)
+    {
+        return;
+    }
+
+    auto connection = std::make_unique<Connection>();
+    Connection* raw = connection.get();
+    connection->serial = m_next_serial++;
+    connection->quic = std::move(quic);
+    connection->ids = {connection->quic->LocalId(), connection->quic->OriginalId()};
+
+    QuicConnectionCallbacks callbacks;
+    callbacks.on_established = [this, raw]()
+    {
+        m_established.fetch_add(1, std::memory_order_relaxed);
+
+        // Control stream with our SETTINGS: no dynamic table, no blocked streams
+        const uint64_t control = raw->quic->OpenStream(false);
+        std::string settings;
+        quic::AppendVarint(settings, 0x01);     // SETTINGS_QPACK_MAX_TABLE_CAPACITY
+        quic::AppendVarint(settings, 0);
+        quic::AppendVarint(settings, 0x07);     // SETTINGS_QPACK_BLOCKED_STREAMS
+        quic::AppendVarint(settings, 0);
+        quic::AppendVarint(settings, 0x06);     // SETTINGS_MAX_FIELD_SECTION_SIZE
+        quic::AppendVarint(settings, kMaxFieldSection);
+        std::string stream;
+        quic::AppendVarint(stream, kStreamControl);
+        quic::AppendVarint(stream, kFrameSettings);
+        quic::AppendVarint(stream, settings.size());
+        stream += settings;
+        if (control == UINT64_MAX || !raw->quic->SendStream(control, stream, false))
+        {
+            raw->quic->Close(kStreamCreationError, true, "cannot open control stream");
+        }
+    };
+    callbacks.on_stream_data = [this, raw](uint64_t stream_id, std::string_view data, bool fin)
+    {
+        OnStreamData(*raw, stream_id, data, fin);
+    };
+    callbacks.on_stream_reset = [raw](uint64_t stream_id, uint64_t)
+    {
+        raw->requests.erase(stream_id);
+    };
+    connection->quic->SetCallbacks(std::move(callbacks));
+
+    for (const std::string& id : connection->ids)
+    {
+        m_routes[id] = raw;
+    }
+    m_connections.emplace(connection->serial, std::move(connection));
+    m_accepted.fetch_add(1, std::memory_order_relaxed);
+    m_active.fetch_add(1, std::memory_order_relaxed);
+    LOG_DEBUG_FMT(Http3Server, "QUIC connection from {}", peer.ToString());
+
+    raw->quic->Receive(datagram, now);
+}
+
+void Http3Server::RemoveConnection(uint64_t serial)
+{
+    auto it = m_connections.find(serial);
+    if (it == m_connections.end())
+    {
+        return;
+    }
+    const Connection& connection = *it->second;
+    LOG_DEBUG_FMT(Http3Server, "QUIC connection from {} closed: {}", connection.quic->Peer().ToString(),
+                  connection.quic->CloseReason());
+    for (const std::string& id : connection.ids)
+    {
+        m_routes.erase(id);
+    }
+    m_connections.erase(it);
+    m_active.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Http3Server::OnStreamData(Connection& connection, uint64_t stream_id, std::string_view data, bool fin)
+{
+    if ((stream_id & 0x03) == 0x00)
+    {
+        OnRequestData(connection, stream_id, data, fin);
+    }
+    else if ((stream_id & 0x03) == 0x02)
+    {
+        OnUnidirectionalData(connection, stream_id, data, fin);
+    }
+}
+
+void Http3Server::OnRequestData(Connection& connection, uint64_t stream_id, std::string_view data, bool fin)
+{
+    Connection::Request& request = connection.requests[stream_id];
+    if (request.rejected)
+    {
+        // Answered already; the rest of the body is discarded
+        if (fin)
+        {
+            connection.requests.erase(stream_id);
+        }
+        return;
+    }
+    request.buffer.append(data);
+    const auto reject = [&](int status, const char* reason)
+    {
+        request.done = true;
+        request.rejected = true;
+        request.buffer.clear();
+        request.body.clear();
+        SendResponse(connection, stream_id, ErrorResponse(status, reason));
+        if (fin)
+        {
+            connection.requests.erase(stream_id);
+        }
+    };
+
+    std::string_view input = request.buffer;
+    uint64_t type = 0;
+    uint64_t length = 0;
+    std::string_view payload;
+    while (!input.empty())
+    {
+        if (PeekFrameLength(input, type, length))
+        {
+            if (type == kFrameHeaders && length > kMaxFieldSection)
+            {
+                reject(431, "Request Header Fields Too Large");
+                return;
+            }
+            if (type == kFrameData && request.body.size() + length > m_options.max_body_size)
+            {
+                reject(413, "Payload Too Large");
+                return;
+            }
+        }
+        if (!NextFrame(input, type, length, payload))
+        {
+            break;
+        }
+        if (type == kFrameHeaders)
+        {
+            std::vector<http::HeaderField> fields;
+            if (!http::qpack::Decode(payload, fields))
+            {
+                connection.quic->Close(kDecompressionFailed, true, "QPACK decoding failed");
+                return;
+            }
+            if (!request.has_headers)
+            {
+                request.headers = std::move(fields);
+                request.has_headers = true;
+            }
+            // A second HEADERS frame holds trailers, which are not passed on
+        }
+        else if (type == kFrameData)
+        {
+            if (!request.has_headers)
+            {
+                connection.quic->Close(kFrameUnexpected, true, "DATA before HEADERS");
+                return;
+            }
+            request.body.append(payload);
+        }
+        else if (IsRequestStreamViolation(type))
+        {
+            connection.quic->Close(kFrameUnexpected, true, "frame not allowed on a request stream");
+            return;
+        }
+        // Unknown and reserved frame types are skipped
+    }
+    request.buffer.erase(0, request.buffer.size() - input.size());
+
+    if (!fin)
+    {
+        return;
+    }
+    if (!request.buffer.empty())
+    {
+        connection.quic->Close(kFrameError, true, "truncated frame");
+        return;
+    }
+    if (!request.has_headers)
+    {
+        connection.quic->ResetStream(stream_id, kRequestIncomplete);
+        connection.requests.erase(stream_id);
+        return;
+    }
+
+    std::string message = BuildHttp1Request(request.headers, request.body);
+    if (message.empty())
+    {
+        connection.quic->ResetStream(stream_id, kMessageError);
+        connection.requests.erase(stream_id);
+        return;
+    }
+    request.done = true;
+    request.headers.clear();
+    request.body.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_jobs_mutex);
+        m_requests.push_back({connection.serial, stream_id, std::move(message)});
+    }
+    m_jobs_cv.notify_one();
+}
+
+void Http3Server::OnUnidirectionalData(Connection& connection, uint64_t stream_id, std::string_view data, bool fin)
+{
+    Connection::Unidirectional& stream = connection.unidirectional[stream_id];
+    stream.buffer.append(data);
+    std::string_view input = stream.buffer;
+
+    if (stream.type == UINT64_MAX)
+    {
+        if (!quic::ReadVarint(input, stream.type))
+        {
+            stream.type = UINT64_MAX;
+            return;
+        }
+        if (stream.type == kStreamControl)
+        {
+            if (connection.peer_control)
+            {
+                connection.quic->Close(kStreamCreationError, true, "second control stream");
+                return;
+            }
+            connection.peer_control = true;
+        }
+        else if (stream.type == kStreamPush)
+        {
+            connection.quic->Close(kStreamCreationError, true, "push stream from a client");
+            return;
+        }
+    }
+
+    if (stream.type != kStreamControl)
+    {
+        // No dynamic table: the QPACK streams carry nothing we act on; unknown types are ignored
+        stream.buffer.clear();
+        if (fin && (stream.type == kStreamQpackEncoder || stream.type == kStreamQpackDecoder))
+        {
+            connection.quic->Close(kClosedCriticalStream, true, "QPACK stream closed");
+        }
+        return;
+    }
+
+    uint64_t type = 0;
+    uint64_t length = 0;
+    std::string_view payload;
+    while (!input.empty())
+    {
+        if (PeekFrameLength(input, type, length) && length > kMaxControlFrame)
+        {
+            connection.quic->Close(kExcessiveLoad, true, "control frame too large");
+            return;
+        }
+        if (!NextFrame(input, type, length, payload))
+        {
+            break;
+        }
+        if (!stream.settings)
+        {
+            if (type != kFrameSettings)
+            {
+                connection.quic->Close(kMissingSettings, true, "control stream must start with SETTINGS");
+                return;
+            }
+            stream.settings = true;
+            while (!payload.empty())
+            {
+                uint64_t id = 0;
+                uint64_t value = 0;
+                if (!quic::ReadVarint(payload, id) || !quic::ReadVarint(payload, value))
+                {
+                    connection.quic->Close(kFrameError, true, "malformed SETTINGS");
+                    return;
+                }
+                if (id >= 0x02 && id <= 0x05)
+                {
+                    connection.quic->Close(kSettingsError, true, "HTTP/2 setting in SETTINGS");
+                    return;
+                }
+            }
+            continue;
+        }
+        if (type == kFrameSettings || type == kFrameData || type == kFrameHeaders || type == kFramePushPromise
+            || type == 0x02 || type == 0x06 || type == 0x08 || type == 0x09)
+        {
+            connection.quic->Close(kFrameUnexpected, true, "frame not allowed on the control stream");
+            return;
+        }
+        // GOAWAY, MAX_PUSH_ID and CANCEL_PUSH need no action without server push
+    }
+    stream.buffer.erase(0, stream.buffer.size() - input.size());
+
+    if (fin)
+    {
+        connection.quic->Close(kClosedCriticalStream, true, "control stream closed");
+    }
+}
+
+void Http3Server::WorkerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_jobs_mutex);
+            m_jobs_cv.wait(lock, [this]() { return !m_running.load() || !m_requests.empty(); });
+            if (!m_running.load())
+            {
+                return;
+            }
+            job = std::move(m_requests.front());
+            m_requests.pop_front();
+        }
+
+        try
+        {
+            job.message = m_handler(job.message);
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT(Http3Server, "Handler failed on HTTP/3 stream: {}", e.what());
+            job.message = ErrorResponse(500, "Internal Server Error");
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_jobs_mutex);
+            m_responses.push_back(std::move(job));
+        }
+        Wake();
+    }
+}
+
+void Http3Server::DrainResponses()
+{
+    std::deque<Job> responses;
+    {
+        std::lock_guard<std::mutex> lock(m_jobs_mutex);
+        responses.swap(m_responses);
+    }
+    for (const Job& job : responses)
+    {
+        auto it = m_connections.find(job.connection);
+        if (it == m_connections.end())
+        {
+            continue;   // Closed while the request was being handled
+        }
+        SendResponse(*it->second, job.stream_id, job.message);
+    }
+}
+
+void Http3Server::SendResponse(Connection& connection, uint64_t stream_id, const std::string& response)
+{
+    std::vector<http::HeaderField> headers;
+    std::string_view body;
+    if (!ParseHttp1Response(response, headers, body))
+    {
+        connection.quic->ResetStream(stream_id, kInternalError);
+        connection.requests.erase(stream_id);
+        return;
+    }
+
+    std::string block;
+    http::qpack::Encode(headers, block);
+    std::string frames;
+    frames.reserve(block.size() + body.size() + 16);
+    quic::AppendVarint(frames, kFrameHeaders);
+    quic::AppendVarint(frames, block.size());
+    frames += block;
+    if (!body.empty())
+    {
+        quic::AppendVarint(frames, kFrameData);
+        quic::AppendVarint(frames, body.size());
+        frames.append(body);
+    }
+    if (connection.quic->SendStream(stream_id, frames, true))
+    {
+        m_request_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Rejected streams stay until the peer finishes sending, so late data is not taken for a new request
+    auto it = connection.requests.find(stream_id);
+    if (it != connection.requests.end() && !it->second.rejected)
+    {
+        connection.requests.erase(it);
+    }
+}
+
+#else
+
+Http3Server::Http3Server(RequestHandler handler)
+    : m_handler(std::move(handler))
+{
+}
+
+Http3Server::~Http3Server() = default;
+
+bool Http3Server::Start(const Http3ServerOptions&)
+{
+    LOG_ERROR(Http3Server, "HTTP/3 is experimental: configure with -DMINISERVER_EXPERIMENTAL_HTTP3=ON (needs OpenSSL and POSIX sockets)");
+    return false;
+}
+
+void Http3Server::Stop()
+{
+}
+
+Http3Stats Http3Server::GetStats() const
+{
+    return {};
+}
+
+#endif
+
+} // namespace miniserver::network
@@ -0,0 +1,216 @@
+/**
+ * @file http3_server.hpp
+ * @brief HTTP/3 over QUIC listener (RFC 9114)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/quic_connection.hpp"
+#include "net/socket_server.hpp"
+#include "net/udp_socket.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief HTTP/3 listener settings
+ */
+struct Http3ServerOptions
+{
+    std::string host = "0.0.0.0";              ///< UDP bind address
+    int port = 0;                               ///< UDP port
+    std::string certificate_file;               ///< PEM certificate chain
+    std::string key_file;                       ///< PEM private key (ECDSA P-256, RSA or Ed25519)
+    QuicConnectionOptions connection;           ///< Per-connection QUIC limits
+    size_t max_connections = 1024;              ///< New handshakes beyond this are dropped
+    size_t max_body_size = 1024 * 1024;         ///< Larger request bodies get 413
+    size_t workers = 4;                         ///< Handler threads shared by all connections
+};
+
+/**
+ * @brief HTTP/3 listener counters
+ */
+struct Http3Stats
+{
+    uint64_t accepted = 0;              ///< Connections started
+    uint64_t established = 0;           ///< Handshakes completed
+    uint64_t active = 0;                ///< Connections open now
+    uint64_t requests = 0;              ///< Requests answered
+    uint64_t datagrams_received = 0;    ///< UDP datagrams read
+    uint64_t datagrams_sent = 0;        ///< UDP datagrams written
+};
+
+/**
+ * @brief Serves HTTP/3 on a UDP port
+ *
+ * One thread owns the socket and every QUIC connection: it reads datagrams
+ * in batches, routes them by destination connection ID, runs the
+ * connections' timers and writes their packets back in batches (with GSO
+ * where the kernel supports it). Complete requests are converted to
+ * HTTP/1.1 messages and answered by a small pool of worker threads calling
+ * the same RequestHandler as the TCP listeners, so routing, services and
+ * compression behave identically; responses travel back to the loop thread
+ * through a queue and go out as QPACK HEADERS and DATA frames.
+ *
+ * Header compression uses the QPACK static table only; server push, 0-RTT,
+ * Retry and connection migration are not supported. Stop() closes open
+ * connections with H3_NO_ERROR rather than draining them.
+ *
+ * @details Requires OpenSSL for the crypto primitives and a POSIX socket
+ * API; Start() fails elsewhere.
+ */
+class Http3Server
+{
+public:
+    /**
+     * @brief Constructor
+     * @param handler Called with an HTTP/1.1 request, returns an HTTP/1.1 response
+     */
+    explicit Http3Server(RequestHandler handler);
+
+    /**
+     * @brief Destructor (stops the server)
+     */
+    ~Http3Server();
+
+    Http3Server(const Http3Server&) = delete;
+    Http3Server& operator=(const Http3Server&) = delete;
+
+    /**
+     * @brief Load the certificate, bind the port and start the loop and worker threads
+     * @param options Listener settings
+     * @return false if the certificate cannot be loaded or the port cannot be bound
+     */
+    bool Start(const Http3ServerOptions& options);
+
+    /**
+     * @brief Close every connection and join the threads
+     */
+    void Stop();
+
+    /**
+     * @brief Check whether the listener is running
+     */
+    bool IsRunning() const { return m_running.load(); }
+
+    /**
+     * @brief Bound UDP port (useful with port 0)
+     */
+    int GetPort() const { return m_socket.Port(); }
+
+    /**
+     * @brief Counters snapshot
+     */
+    Http3Stats GetStats() const;
+
+private:
+    struct Connection;
+
+    /**
+     * @brief Request waiting for a worker, or a response waiting for the loop thread
+     */
+    struct Job
+    {
+        uint64_t connection = 0;        ///< Connection serial number
+        uint64_t stream_id = 0;         ///< Request stream
+        std::string message;            ///< HTTP/1.1 request or response
+    };
+
+    /**
+     * @brief Loop thread body: socket I/O, timers, responses
+     */
+    void Loop();
+
+    /**
+     * @brief Worker thread body: answer queued requests until Stop
+     */
+    void WorkerLoop();
+
+    /**
+     * @brief Route one datagram to its connection, starting a connection for a new client Initial
+     */
+    void OnDatagram(std::string_view datagram, const UdpAddress& peer, quic::TimePoint now);
+
+    /**
+     * @brief Create the connection for a client's first Initial packet
+     */
+    void AcceptConnection(std::string_view datagram, const UdpAddress& peer, const quic::PacketHeader& header,
+                          quic::TimePoint now);
+
+    /**
+     * @brief Bytes arrived on a stream of a connection
+     */
+    void OnStreamData(Connection& connection, uint64_t stream_id, std::string_view data, bool fin);
+
+    /**
+     * @brief Parse the frames of a request stream; queue the request once the stream ends
+     */
+    void OnRequestData(Connection& connection, uint64_t stream_id, std::string_view data, bool fin);
+
+    /**
+     * @brief Parse a peer unidirectional stream (control, QPACK encoder/decoder)
+     */
+    void OnUnidirectionalData(Connection& connection, uint64_t stream_id, std::string_view data, bool fin);
+
+    /**
+     * @brief Send an HTTP/1.1 response on a request stream as HEADERS and DATA frames
+     */
+    void SendResponse(Connection& connection, uint64_t stream_id, const std::string& response);
+
+    /**
+     * @brief Deliver responses finished by the workers
+     */
+    void DrainResponses();
+
+    /**
+     * @brief Forget a closed connection
+     */
+    void RemoveConnection(uint64_t serial);
+
+    /**
+     * @brief Wake the loop thread from poll()
+     */
+    void Wake();
+
+    RequestHandler m_handler;                                           ///< HTTP/1.1 request handler
+    Http3ServerOptions m_options;                                       ///< Settings
+    std::shared_ptr<const QuicCredentials> m_credentials;               ///< Certificate and key
+    UdpSocket m_socket;                                                 ///< Listening socket
+    int m_wake_pipe[2] = {-1, -1};                                      ///< Wakes the loop thread
+    std::thread m_loop_thread;                                          ///< Runs Loop
+    std::vector<std::thread> m_workers;                                 ///< Run WorkerLoop
+    std::atomic<bool> m_running{false};                                 ///< Serving
+
+    std::map<uint64_t, std::unique_ptr<Connection>> m_connections;      ///< By serial number (loop thread)
+    std::unordered_map<std::string, Connection*> m_routes;              ///< By connection ID (loop thread)
+    uint64_t m_next_serial = 1;                                         ///< Next connection serial number
+    UdpSendBatch m_send_batch;                                          ///< Outgoing datagrams (loop thread)
+
+    std::mutex m_jobs_mutex;                                            ///< Guards both queues
+    std::condition_variable m_jobs_cv;                                  ///< Signals queued requests
+    std::deque<Job> m_requests;                                         ///< Requests for the workers
+    std::deque<Job> m_responses;                                        ///< Responses for the loop thread
+
+    std::atomic<uint64_t> m_accepted{0};                                ///< Connections started
+    std::atomic<uint64_t> m_established{0};                             ///< Handshakes completed
+    std::atomic<uint64_t> m_active{0};                                  ///< Connections open
+    std::atomic<uint64_t> m_request_count{0};                           ///< Requests answered
+    std::atomic<uint64_t> m_datagrams_received{0};                      ///< Datagrams read
+    std::atomic<uint64_t> m_datagrams_sent{0};                          ///< Datagrams written
+};
+
+} // namespace miniserver::network
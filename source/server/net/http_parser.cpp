@@ -59,18 +59,16 @@ std::optional<Request> HttpParser::ParseRequest(const std::string& raw_data)
         ParseHeaderLine(line, request);
     }
     
-    // Parse body (rest of the stream)
-    std::string body;
-    std::string body_line;
-    while (std::getline(stream, body_line))
+    // Body is everything after the blank line, byte for byte (it may be binary)
+    size_t header_end = raw_data.find("\r\n\r\n");
+    if (header_end != std::string::npos)
     {
-        if (!body.empty())
-        {
-            body += "\n";
-        }
-        body += body_line;
+        request.body = raw_data.substr(header_end + 4);
+    }
+    else if ((header_end = raw_data.find("\n\n")) != std::string::npos)
+    {
+        request.body = raw_data.substr(header_end + 2);
     }
-    request.body = body;
     
     return request;
 }
@@ -89,8 +87,10 @@ std::string HttpParser::SerializeResponse(const Response& response)
         stream << name << ": " << value << "\r\n";
     }
     
-    // Content-Length header if not present
-    if (response.headers.find("Content-Length") == response.headers.end())
+    // Content-Length header if not present (never on 1xx or streaming responses,
+    // whose body is delimited by closing the connection)
+    if (response.status != StatusCode::SwitchingProtocols && !response.streaming &&
+        response.headers.find("Content-Length") == response.headers.end())
     {
         stream << "Content-Length: " << response.body.size() << "\r\n";
     }
@@ -104,6 +104,40 @@ std::string HttpParser::SerializeResponse(const Response& response)
     return stream.str();
 }
 
+std::optional<std::string> HttpParser::FindRawHeader(std::string_view head, std::string_view name)
+{
+    const size_t head_end = head.find("\r\n\r\n");
+    if (head_end != std::string_view::npos)
+    {
+        head = head.substr(0, head_end + 2);
+    }
+
+    // Skip the start line
+    size_t line_start = head.find("\r\n");
+    while (line_start != std::string_view::npos)
+    {
+        line_start += 2;
+        const size_t line_end = head.find("\r\n", line_start);
+        if (line_end == std::string_view::npos)
+        {
+            break;
+        }
+
+        const std::string_view line = head.substr(line_start, line_end - line_start);
+        const size_t colon = line.find(':');
+        if (colon == name.size() &&
+            std::equal(name.begin(), name.end(), line.begin(), [](char a, char b) {
+                return std::tolower(static_cast<unsigned char>(a)) ==
+                       std::tolower(static_cast<unsigned char>(b));
+            }))
+        {
+            return Trim(std::string(line.substr(colon + 1)));
+        }
+        line_start = line_end;
+    }
+    return std::nullopt;
+}
+
 bool HttpParser::ParseRequestLine(const std::string& request_line, Request& request)
 {
     std::istringstream stream(request_line);
@@ -174,6 +208,7 @@ std::optional<Method> HttpParser::ParseMethod(const std::string& method_str)
     if (upper_method == "OPTIONS") return Method::OPTIONS;
     if (upper_method == "HEAD") return Method::HEAD;
     if (upper_method == "PATCH") return Method::PATCH;
+    if (upper_method == "CONNECT") return Method::CONNECT;
     
     return std::nullopt;
 }
@@ -237,14 +272,21 @@ std::string HttpParser::GetStatusText(StatusCode status)
 {
     switch (status)
     {
+        case StatusCode::SwitchingProtocols: return "Switching Protocols";
         case StatusCode::OK: return "OK";
         case StatusCode::Created: return "Created";
         case StatusCode::NoContent: return "No Content";
         case StatusCode::BadRequest: return "Bad Request";
+        case StatusCode::Forbidden: return "Forbidden";
         case StatusCode::NotFound: return "Not Found";
         case StatusCode::MethodNotAllowed: return "Method Not Allowed";
+        case StatusCode::PayloadTooLarge: return "Payload Too Large";
+        case StatusCode::UnsupportedMediaType: return "Unsupported Media Type";
         case StatusCode::InternalServerError: return "Internal Server Error";
         case StatusCode::NotImplemented: return "Not Implemented";
+        case StatusCode::BadGateway: return "Bad Gateway";
+        case StatusCode::ServiceUnavailable: return "Service Unavailable";
+        case StatusCode::GatewayTimeout: return "Gateway Timeout";
         default: return "Unknown";
     }
 }
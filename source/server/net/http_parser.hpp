@@ -9,6 +9,7 @@
 
 #include "http_types.hpp"
 #include <string>
+#include <string_view>
 #include <optional>
 
 namespace miniserver::http
@@ -35,6 +36,25 @@ public:
      */
     static std::string SerializeResponse(const Response& response);
 
+    /**
+     * @brief Look up a header in an unparsed request/response head
+     * @param head Raw message (only the part before the blank line is searched)
+     * @param name Header name (case-insensitive)
+     * @return Trimmed header value, or nullopt if absent
+     *
+     * @details
+     * Used by the transport to make framing decisions (Content-Length,
+     * Connection, Upgrade) without building a full Request.
+     */
+    static std::optional<std::string> FindRawHeader(std::string_view head, std::string_view name);
+
+    /**
+     * @brief URL decode string
+     * @param str String to decode
+     * @return Decoded string
+     */
+    static std::string UrlDecode(const std::string& str);
+
 private:
     /**
      * @brief Parse request line
@@ -79,13 +99,6 @@ private:
      */
     static std::string Trim(const std::string& str);
     
-    /**
-     * @brief URL decode string
-     * @param str String to decode
-     * @return Decoded string
-     */
-    static std::string UrlDecode(const std::string& str);
-    
     /**
      * @brief Get status text for status code
      * @param status Status code
@@ -77,6 +77,7 @@ std::string MethodToString(Method method)
         case Method::OPTIONS: return "OPTIONS";
         case Method::HEAD: return "HEAD";
         case Method::PATCH: return "PATCH";
+        case Method::CONNECT: return "CONNECT";
         case Method::UNKNOWN:
         default: return "UNKNOWN";
     }
@@ -97,6 +98,7 @@ Method StringToMethod(const std::string& method_str)
     if (upper_method == "OPTIONS") return Method::OPTIONS;
     if (upper_method == "HEAD") return Method::HEAD;
     if (upper_method == "PATCH") return Method::PATCH;
+    if (upper_method == "CONNECT") return Method::CONNECT;
     
     return Method::UNKNOWN;
 }
@@ -104,14 +106,21 @@ Method StringToMethod(const std::string& method_str)
 std::string StatusToString(StatusCode status)
 {
     switch (status) {
+        case StatusCode::SwitchingProtocols: return "Switching Protocols";
         case StatusCode::OK: return "OK";
         case StatusCode::Created: return "Created";
         case StatusCode::NoContent: return "No Content";
         case StatusCode::BadRequest: return "Bad Request";
+        case StatusCode::Forbidden: return "Forbidden";
         case StatusCode::NotFound: return "Not Found";
         case StatusCode::MethodNotAllowed: return "Method Not Allowed";
+        case StatusCode::PayloadTooLarge: return "Payload Too Large";
+        case StatusCode::UnsupportedMediaType: return "Unsupported Media Type";
         case StatusCode::InternalServerError: return "Internal Server Error";
         case StatusCode::NotImplemented: return "Not Implemented";
+        case StatusCode::BadGateway: return "Bad Gateway";
+        case StatusCode::ServiceUnavailable: return "Service Unavailable";
+        case StatusCode::GatewayTimeout: return "Gateway Timeout";
         default: return "Unknown";
     }
 }
@@ -23,6 +23,7 @@ enum class Method {
     OPTIONS,
     HEAD,
     PATCH,
+    CONNECT,
     UNKNOWN
 };
 
@@ -30,14 +31,21 @@ enum class Method {
  * @brief HTTP status code enumeration
  */
 enum class StatusCode {
+    SwitchingProtocols = 101,
     OK = 200,
     Created = 201,
     NoContent = 204,
     BadRequest = 400,
+    Forbidden = 403,
     NotFound = 404,
     MethodNotAllowed = 405,
+    PayloadTooLarge = 413,
+    UnsupportedMediaType = 415,
     InternalServerError = 500,
-    NotImplemented = 501
+    NotImplemented = 501,
+    BadGateway = 502,
+    ServiceUnavailable = 503,
+    GatewayTimeout = 504
 };
 
 /**
@@ -83,6 +91,7 @@ struct Response
     StatusCode status = StatusCode::OK;                 ///< HTTP状态码
     std::map<std::string, std::string> headers;         ///< 响应头
     std::string body;                                   ///< 响应体
+    bool streaming = false;                             ///< Body continues after `body` until the connection closes (event streams)
     
     /**
      * @brief 设置响应内容
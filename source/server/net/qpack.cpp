@@ -0,0 +1,244 @@
+/**
+ * @file qpack.cpp
+ * @brief QPACK static table field coding implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/qpack.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace miniserver::http
+{
+
+namespace
+{
+    /**
+     * @brief Static table (RFC 9204 Appendix A), index 0 is element 0
+     */
+    const std::array<std::pair<const char*, const char*>, 99> kStaticTable = {{
+        {":authority", ""}, {":path", "/"}, {"age", "0"}, {"content-disposition", ""},
+        {"content-length", "0"}, {"cookie", ""}, {"date", ""}, {"etag", ""},
+        {"if-modified-since", ""}, {"if-none-match", ""}, {"last-modified", ""}, {"link", ""},
+        {"location", ""}, {"referer", ""}, {"set-cookie", ""}, {":method", "CONNECT"},
+        {":method", "DELETE"}, {":method", "GET"}, {":method", "HEAD"}, {":method", "OPTIONS"},
+        {":method", "POST"}, {":method", "PUT"}, {":scheme", "http"}, {":scheme", "https"},
+        {":status", "103"}, {":status", "200"}, {":status", "304"}, {":status", "404"},
+        {":status", "503"}, {"accept", "*/*"}, {"accept", "application/dns-message"}, {"accept-encoding", "gzip, deflate, br"},
+        {"accept-ranges", "bytes"}, {"access-control-allow-headers", "cache-control"},
+        {"access-control-allow-headers", "content-type"}, {"access-control-allow-origin", "*"},
+        {"cache-control", "max-age=0"}, {"cache-control", "max-age=2592000"}, {"cache-control", "max-age=604800"},
+        {"cache-control", "no-cache"}, {"cache-control", "no-store"}, {"cache-control", "public, max-age=31536000"},
+        {"content-encoding", "br"}, {"content-encoding", "gzip"}, {"content-type", "application/dns-message"},
+        {"content-type", "application/javascript"}, {"content-type", "application/json"},
+        {"content-type", "application/x-www-form-urlencoded"}, {"content-type", "image/gif"},
+        {"content-type", "image/jpeg"}, {"content-type", "image/png"}, {"content-type", "text/css"},
+        {"content-type", "text/html; charset=utf-8"}, {"content-type", "text/plain"},
+        {"content-type", "text/plain;charset=utf-8"}, {"range", "bytes=0-"},
+        {"strict-transport-security", "max-age=31536000"},
+        {"strict-transport-security", "max-age=31536000; includesubdomains"},
+        {"strict-transport-security", "max-age=31536000; includesubdomains; preload"}, {"vary", "accept-encoding"},
+        {"vary", "origin"}, {"x-content-type-options", "nosniff"}, {"x-xss-protection", "1; mode=block"},
+        {":status", "100"}, {":status", "204"}, {":status", "206"}, {":status", "302"},
+        {":status", "400"}, {":status", "403"}, {":status", "421"}, {":status", "425"},
+        {":status", "500"}, {"accept-language", ""}, {"access-control-allow-credentials", "FALSE"},
+        {"access-control-allow-credentials", "TRUE"}, {"access-control-allow-headers", "*"},
+        {"access-control-allow-methods", "get"}, {"access-control-allow-methods", "get, post, options"},
+        {"access-control-allow-methods", "options"}, {"access-control-expose-headers", "content-length"},
+        {"access-control-request-headers", "content-type"}, {"access-control-request-method", "get"},
+        {"access-control-request-method", "post"}, {"alt-svc", "clear"}, {"authorization", ""},
+        {"content-security-policy", "script-src 'none'; object-src 'none'; base-uri 'none'"}, {"early-data", "1"},
+        {"expect-ct", ""}, {"forwarded", ""}, {"if-range", ""}, {"origin", ""},
+        {"purpose", "prefetch"}, {"server", ""}, {"timing-allow-origin", "*"}, {"upgrade-insecure-requests", "1"},
+        {"user-agent", ""}, {"x-forwarded-for", ""}, {"x-frame-options", "deny"}, {"x-frame-options", "sameorigin"},
+    }};
+
+    constexpr size_t kMaxFieldSection = 64 * 1024;  ///< Decoded size limit (names + values)
+
+    /**
+     * @brief Decode a QPACK/HPACK prefixed integer
+     */
+    bool DecodeInteger(std::string_view input, size_t& pos, int prefix_bits, uint64_t& value)
+    {
+        if (pos >= input.size())
+        {
+            return false;
+        }
+        const uint64_t max_prefix = (1u << prefix_bits) - 1;
+        value = static_cast<uint8_t>(input[pos++]) & max_prefix;
+        if (value < max_prefix)
+        {
+            return true;
+        }
+        for (int shift = 0; shift <= 56; shift += 7)
+        {
+            if (pos >= input.size())
+            {
+                return false;
+            }
+            const auto byte = static_cast<uint8_t>(input[pos++]);
+            value += static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Decode a string literal whose length has an N-bit prefix and whose Huffman flag sits just above it
+     */
+    bool DecodeString(std::string_view input, size_t& pos, int prefix_bits, std::string& output)
+    {
+        if (pos >= input.size())
+        {
+            return false;
+        }
+        const bool huffman = (static_cast<uint8_t>(input[pos]) & (1u << prefix_bits)) != 0;
+        uint64_t length;
+        if (!DecodeInteger(input, pos, prefix_bits, length) || length > input.size() - pos)
+        {
+            return false;
+        }
+        const std::string_view raw = input.substr(pos, static_cast<size_t>(length));
+        pos += static_cast<size_t>(length);
+
+        output.clear();
+        if (huffman)
+        {
+            return hpack::HuffmanDecode(raw, output);
+        }
+        output.assign(raw.data(), raw.size());
+        return true;
+    }
+
+    /**
+     * @brief Look up a field in the static table
+     * @return Index of a full match or SIZE_MAX; name_index receives a name-only match or SIZE_MAX
+     */
+    size_t FindStatic(const std::string& name, const std::string& value, size_t& name_index)
+    {
+        name_index = SIZE_MAX;
+        for (size_t i = 0; i < kStaticTable.size(); ++i)
+        {
+            if (name == kStaticTable[i].first)
+            {
+                if (value == kStaticTable[i].second)
+                {
+                    return i;
+                }
+                if (name_index == SIZE_MAX)
+                {
+                    name_index = i;
+                }
+            }
+        }
+        return SIZE_MAX;
+    }
+}
+
+namespace qpack
+{
+    bool Decode(std::string_view block, std::vector<HeaderField>& headers)
+    {
+        size_t pos = 0;
+        uint64_t required_insert_count;
+        uint64_t delta_base;
+        if (!DecodeInteger(block, pos, 8, required_insert_count) || !DecodeInteger(block, pos, 7, delta_base)
+            || required_insert_count != 0)
+        {
+            return false;
+        }
+
+        size_t total = 0;
+        while (pos < block.size())
+        {
+            const auto byte = static_cast<uint8_t>(block[pos]);
+            HeaderField field;
+            if ((byte & 0x80) != 0)
+            {
+                // Indexed field line; T (0x40) selects the static table
+                uint64_t index;
+                if ((byte & 0x40) == 0 || !DecodeInteger(block, pos, 6, index) || index >= kStaticTable.size())
+                {
+                    return false;
+                }
+                field.first = kStaticTable[index].first;
+                field.second = kStaticTable[index].second;
+            }
+            else if ((byte & 0xc0) == 0x40)
+            {
+                // Literal field line with name reference
+                uint64_t index;
+                if ((byte & 0x10) == 0 || !DecodeInteger(block, pos, 4, index) || index >= kStaticTable.size()
+                    || !DecodeString(block, pos, 7, field.second))
+                {
+                    return false;
+                }
+                field.first = kStaticTable[index].first;
+            }
+            else if ((byte & 0xe0) == 0x20)
+            {
+                // Literal field line with literal name
+                if (!DecodeString(block, pos, 3, field.first) || !DecodeString(block, pos, 7, field.second))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;   // Post-base references need a dynamic table
+            }
+
+            total += field.first.size() + field.second.size();
+            if (total > kMaxFieldSection)
+            {
+                return false;
+            }
+            headers.push_back(std::move(field));
+        }
+        return true;
+    }
+
+    void Encode(const std::vector<HeaderField>& headers, std::string& output)
+    {
+        // Required Insert Count 0, Delta Base 0
+        output.push_back('\0');
+        output.push_back('\0');
+
+        for (const auto& [name, value] : headers)
+        {
+            size_t name_index;
+            const size_t index = FindStatic(name, value, name_index);
+            if (index != SIZE_MAX)
+            {
+                hpack::EncodeInteger(output, 0xc0, 6, index);
+                continue;
+            }
+            if (name_index != SIZE_MAX)
+            {
+                hpack::EncodeInteger(output, 0x50, 4, name_index);
+            }
+            else
+            {
+                const size_t huffman_length = hpack::HuffmanEncodedLength(name);
+                if (huffman_length < name.size())
+                {
+                    hpack::EncodeInteger(output, 0x28, 3, huffman_length);
+                    hpack::HuffmanEncode(name, output);
+                }
+                else
+                {
+                    hpack::EncodeInteger(output, 0x20, 3, name.size());
+                    output.append(name);
+                }
+            }
+            hpack::EncodeString(output, value);
+        }
+    }
+}
+
+} // namespace miniserver::http
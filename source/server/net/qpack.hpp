@@ -0,0 +1,46 @@
+/**
+ * @file qpack.hpp
+ * @brief QPACK field compression for HTTP/3, static table only (RFC 9204)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/hpack.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace miniserver::http
+{
+
+/**
+ * @brief QPACK field section coding without a dynamic table
+ *
+ * The server advertises SETTINGS_QPACK_MAX_TABLE_CAPACITY 0, so a compliant
+ * peer never references a dynamic table and the encoder and decoder streams
+ * stay silent. Field sections therefore start with a zero Required Insert
+ * Count and use static table references and literals only; string literals
+ * share the Huffman code with HPACK.
+ */
+namespace qpack
+{
+    /**
+     * @brief Decode a field section (HEADERS frame payload)
+     * @param block Encoded field section
+     * @param headers Receives the fields in order
+     * @return false on malformed input or a dynamic table reference
+     */
+    bool Decode(std::string_view block, std::vector<HeaderField>& headers);
+
+    /**
+     * @brief Encode a field section
+     * @param headers Fields (names lowercase)
+     * @param output Buffer receiving the encoded section
+     */
+    void Encode(const std::vector<HeaderField>& headers, std::string& output);
+}
+
+} // namespace miniserver::http
@@ -0,0 +1,2120 @@
+/**
+ * @file quic_connection.cpp
+ * @brief QUIC connection implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/quic_connection.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace miniserver::network
+{
+
+namespace quic
+{
+
+// =============================================================================
+// RangeSet
+// =============================================================================
+
+void RangeSet::Add(uint64_t start, uint64_t end)
+{
+    if (start >= end)
+    {
+        return;
+    }
+    auto it = m_ranges.upper_bound(start);
+    if (it != m_ranges.begin())
+    {
+        auto previous = std::prev(it);
+        if (previous->second >= start)
+        {
+            start = previous->first;
+            end = std::max(end, previous->second);
+            it = m_ranges.erase(previous);
+        }
+    }
+    while (it != m_ranges.end() && it->first <= end)
+    {
+        end = std::max(end, it->second);
+        it = m_ranges.erase(it);
+    }
+    m_ranges.emplace(start, end);
+}
+
+void RangeSet::Remove(uint64_t start, uint64_t end)
+{
+    if (start >= end)
+    {
+        return;
+    }
+    auto it = m_ranges.upper_bound(start);
+    if (it != m_ranges.begin())
+    {
+        auto previous = std::prev(it);
+        if (previous->second > start)
+        {
+            const uint64_t range_start = previous->first;
+            const uint64_t range_end = previous->second;
+            m_ranges.erase(previous);
+            if (range_start < start)
+            {
+                m_ranges.emplace(range_start, start);
+            }
+            if (range_end > end)
+            {
+                m_ranges.emplace(end, range_end);
+                return;
+            }
+        }
+    }
+    it = m_ranges.lower_bound(start);
+    while (it != m_ranges.end() && it->first < end)
+    {
+        const uint64_t range_end = it->second;
+        it = m_ranges.erase(it);
+        if (range_end > end)
+        {
+            m_ranges.emplace(end, range_end);
+            break;
+        }
+    }
+}
+
+bool RangeSet::Contains(uint64_t value) const
+{
+    auto it = m_ranges.upper_bound(value);
+    if (it == m_ranges.begin())
+    {
+        return false;
+    }
+    return value < std::prev(it)->second;
+}
+
+// =============================================================================
+// SendBuffer / ReceiveBuffer
+// =============================================================================
+
+bool SendBuffer::HasPending(uint64_t limit) const
+{
+    return !m_lost.Empty() || (m_sent < End() && m_sent < limit) || (m_fin && m_sent == End() && (!m_fin_sent || m_fin_lost));
+}
+
+bool SendBuffer::Next(size_t max_length, uint64_t limit, uint64_t& offset, std::string_view& data, bool& fin)
+{
+    if (max_length == 0)
+    {
+        return false;
+    }
+    if (!m_lost.Empty())
+    {
+        const auto& range = *m_lost.Ranges().begin();
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(range.second - range.first, max_length));
+        offset = range.first;
+        data = std::string_view(m_data).substr(m_front + static_cast<size_t>(offset - m_base), length);
+        fin = m_fin && offset + length == End();
+        return true;
+    }
+    if (m_sent < End() && m_sent < limit)
+    {
+        const uint64_t available = std::min(End(), limit) - m_sent;
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(available, max_length));
+        offset = m_sent;
+        data = std::string_view(m_data).substr(m_front + static_cast<size_t>(offset - m_base), length);
+        fin = m_fin && offset + length == End();
+        return true;
+    }
+    if (m_fin && m_sent == End() && (!m_fin_sent || m_fin_lost))
+    {
+        offset = End();
+        data = {};
+        fin = true;
+        return true;
+    }
+    return false;
+}
+
+void SendBuffer::OnSent(uint64_t offset, size_t length, bool fin)
+{
+    m_lost.Remove(offset, offset + length);
+    m_sent = std::max(m_sent, offset + length);
+    if (fin)
+    {
+        m_fin_sent = true;
+        m_fin_lost = false;
+    }
+}
+
+void SendBuffer::OnAcked(uint64_t offset, size_t length, bool fin)
+{
+    if (fin)
+    {
+        m_fin_acked = true;
+        m_fin_lost = false;
+    }
+    const uint64_t end = offset + length;
+    if (end <= m_base)
+    {
+        return;
+    }
+    offset = std::max(offset, m_base);
+    m_acked.Add(offset, end);
+    m_lost.Remove(offset, end);
+    while (!m_acked.Empty() && m_acked.Ranges().begin()->first <= m_base)
+    {
+        const uint64_t acked_end = m_acked.Ranges().begin()->second;
+        m_front += static_cast<size_t>(acked_end - m_base);
+        m_base = acked_end;
+        m_acked.Remove(0, acked_end);
+    }
+    // Erase acknowledged bytes lazily so a large buffer is not shifted on every ACK
+    if (m_front > 65536 && m_front > m_data.size() / 2)
+    {
+        m_data.erase(0, m_front);
+        m_front = 0;
+    }
+}
+
+void SendBuffer::OnLost(uint64_t offset, size_t length, bool fin)
+{
+    if (fin && !m_fin_acked)
+    {
+        m_fin_lost = true;
+    }
+    const uint64_t start = std::max(offset, m_base);
+    const uint64_t end = std::min<uint64_t>(offset + length, End());
+    if (start >= end)
+    {
+        return;
+    }
+    m_lost.Add(start, end);
+    for (const auto& range : m_acked.Ranges())
+    {
+        if (range.first >= end)
+        {
+            break;
+        }
+        m_lost.Remove(range.first, range.second);
+    }
+}
+
+void SendBuffer::Reset()
+{
+    m_data.clear();
+    m_front = 0;
+    m_base = m_sent;
+    m_acked.Clear();
+    m_lost.Clear();
+    m_fin = true;
+    m_fin_sent = true;
+    m_fin_acked = true;
+    m_fin_lost = false;
+}
+
+bool ReceiveBuffer::Insert(uint64_t offset, std::string_view data, bool fin)
+{
+    const uint64_t end = offset + data.size();
+    if (m_final_size != UINT64_MAX && (end > m_final_size || (fin && end != m_final_size)))
+    {
+        return false;
+    }
+    if (fin)
+    {
+        if (end < m_highest)
+        {
+            return false;
+        }
+        m_final_size = end;
+    }
+    m_highest = std::max(m_highest, end);
+    if (end <= m_offset || data.empty())
+    {
+        return true;
+    }
+    if (offset < m_offset)
+    {
+        data.remove_prefix(static_cast<size_t>(m_offset - offset));
+        offset = m_offset;
+    }
+    std::string& segment = m_segments[offset];
+    if (segment.size() < data.size())
+    {
+        segment.assign(data);
+    }
+    return true;
+}
+
+bool ReceiveBuffer::Read(std::string& output)
+{
+    while (!m_segments.empty())
+    {
+        auto it = m_segments.begin();
+        if (it->first > m_offset)
+        {
+            break;
+        }
+        const uint64_t end = it->first + it->second.size();
+        if (end > m_offset)
+        {
+            output.append(it->second, static_cast<size_t>(m_offset - it->first), std::string::npos);
+            m_offset = end;
+        }
+        m_segments.erase(it);
+    }
+    if (!m_fin_delivered && IsFinished())
+    {
+        m_fin_delivered = true;
+        return true;
+    }
+    return false;
+}
+
+// =============================================================================
+// Transport parameters
+// =============================================================================
+
+namespace
+{
+    enum ParameterId : uint64_t
+    {
+        kOriginalDestinationConnectionId = 0x00,
+        kMaxIdleTimeout = 0x01,
+        kMaxUdpPayloadSize = 0x03,
+        kInitialMaxData = 0x04,
+        kInitialMaxStreamDataBidiLocal = 0x05,
+        kInitialMaxStreamDataBidiRemote = 0x06,
+        kInitialMaxStreamDataUni = 0x07,
+        kInitialMaxStreamsBidi = 0x08,
+        kInitialMaxStreamsUni = 0x09,
+        kAckDelayExponent = 0x0a,
+        kMaxAckDelay = 0x0b,
+        kDisableActiveMigration = 0x0c,
+        kActiveConnectionIdLimit = 0x0e,
+        kInitialSourceConnectionId = 0x0f,
+    };
+
+    void AppendParameter(std::string& output, uint64_t id, std::string_view value)
+    {
+        AppendVarint(output, id);
+        AppendVarint(output, value.size());
+        output.append(value);
+    }
+
+    void AppendIntegerParameter(std::string& output, uint64_t id, uint64_t value)
+    {
+        AppendVarint(output, id);
+        AppendVarint(output, VarintLength(value));
+        AppendVarint(output, value);
+    }
+} // namespace
+
+std::string TransportParameters::Encode() const
+{
+    std::string output;
+    if (!original_destination_connection_id.empty())
+    {
+        AppendParameter(output, kOriginalDestinationConnectionId, original_destination_connection_id);
+    }
+    AppendParameter(output, kInitialSourceConnectionId, initial_source_connection_id);
+    AppendIntegerParameter(output, kMaxIdleTimeout, max_idle_timeout);
+    AppendIntegerParameter(output, kMaxUdpPayloadSize, max_udp_payload_size);
+    AppendIntegerParameter(output, kInitialMaxData, initial_max_data);
+    AppendIntegerParameter(output, kInitialMaxStreamDataBidiLocal, initial_max_stream_data_bidi_local);
+    AppendIntegerParameter(output, kInitialMaxStreamDataBidiRemote, initial_max_stream_data_bidi_remote);
+    AppendIntegerParameter(output, kInitialMaxStreamDataUni, initial_max_stream_data_uni);
+    AppendIntegerParameter(output, kInitialMaxStreamsBidi, initial_max_streams_bidi);
+    AppendIntegerParameter(output, kInitialMaxStreamsUni, initial_max_streams_uni);
+    AppendIntegerParameter(output, kAckDelayExponent, ack_delay_exponent);
+    AppendIntegerParameter(output, kMaxAckDelay, max_ack_delay);
+    AppendIntegerParameter(output, kActiveConnectionIdLimit, active_connection_id_limit);
+    if (disable_active_migration)
+    {
+        AppendParameter(output, kDisableActiveMigration, {});
+    }
+    return output;
+}
+
+bool TransportParameters::Decode(std::string_view input)
+{
+    *this = TransportParameters{};
+    max_idle_timeout = 0;
+    max_udp_payload_size = 65527;
+    while (!input.empty())
+    {
+        uint64_t id = 0;
+        uint64_t length = 0;
+        std::string_view value;
+        if (!ReadVarint(input, id) || !ReadVarint(input, length) || !ReadBytes(input, length, value))
+        {
+            return false;
+        }
+
+        uint64_t number = 0;
+        std::string_view number_input = value;
+        const bool integer = ReadVarint(number_input, number) && number_input.empty();
+        switch (id)
+        {
+            case kOriginalDestinationConnectionId:
+                original_destination_connection_id.assign(value);
+                break;
+            case kInitialSourceConnectionId:
+                initial_source_connection_id.assign(value);
+                break;
+            case kDisableActiveMigration:
+                disable_active_migration = true;
+                break;
+            case kMaxIdleTimeout:
+            case kMaxUdpPayloadSize:
+            case kInitialMaxData:
+            case kInitialMaxStreamDataBidiLocal:
+            case kInitialMaxStreamDataBidiRemote:
+            case kInitialMaxStreamDataUni:
+            case kInitialMaxStreamsBidi:
+            case kInitialMaxStreamsUni:
+            case kAckDelayExponent:
+            case kMaxAckDelay:
+            case kActiveConnectionIdLimit:
+            {
+                if (!integer)
+                {
+                    return false;
+                }
+                uint64_t* const fields[] = {&max_idle_timeout, nullptr, &max_udp_payload_size, &initial_max_data,
+                                            &initial_max_stream_data_bidi_local, &initial_max_stream_data_bidi_remote,
+                                            &initial_max_stream_data_uni, &initial_max_streams_bidi, &initial_max_streams_uni,
+                                            &ack_delay_exponent, &max_ack_delay, nullptr, nullptr, &active_connection_id_limit};
+                *fields[id - kMaxIdleTimeout] = number;
+                break;
+            }
+            default:
+                break;     // Unknown parameters are ignored
+        }
+    }
+    return max_udp_payload_size >= 1200 && ack_delay_exponent <= 20 && max_ack_delay < 16384
+        && initial_max_streams_bidi <= (uint64_t(1) << 60) && initial_max_streams_uni <= (uint64_t(1) << 60);
+}
+
+} // namespace quic
+
+// =============================================================================
+// QuicConnection
+// =============================================================================
+
+using quic::Level;
+using quic::TimePoint;
+
+namespace
+{
+    constexpr std::chrono::microseconds kGranularity{1000};    ///< Timer granularity (RFC 9002)
+    constexpr std::chrono::milliseconds kMaxAckDelay{25};       ///< Our max_ack_delay
+    constexpr uint64_t kAckDelayExponent = 3;                   ///< Our ack_delay_exponent
+    constexpr size_t kMaxAckRanges = 32;                        ///< Ranges remembered and reported per space
+    constexpr uint64_t kMaxCryptoBuffer = 65536;                ///< Largest CRYPTO offset accepted
+    constexpr uint64_t kMinimumWindow = 2 * 1200;               ///< Congestion window floor
+    constexpr size_t kMaxDatagramsPerFlush = 256;               ///< Bound on one Flush() call
+
+    std::string RandomId()
+    {
+        static thread_local std::mt19937_64 generator{std::random_device{}()};
+        std::string id(quic::kConnectionIdLength, '\0');
+        for (char& byte : id)
+        {
+            byte = static_cast<char>(generator());
+        }
+        return id;
+    }
+
+    bool IsAckEliciting(uint64_t type)
+    {
+        return type != 0x00 && type != 0x02 && type != 0x03 && type != 0x1c && type != 0x1d;
+    }
+} // namespace
+
+QuicConnection::QuicConnection(bool server, const QuicConnectionOptions& options, const UdpAddress& peer)
+    : m_server(server)
+    , m_options(options)
+    , m_peer(peer)
+    , m_local_id(RandomId())
+    , m_last_activity(quic::Clock::now())
+{
+    m_max_receive_data = options.max_data;
+    m_max_peer_streams = {options.max_streams_bidi, options.max_streams_uni};
+}
+
+QuicConnection::~QuicConnection() = default;
+
+std::unique_ptr<QuicConnection> QuicConnection::Accept(std::shared_ptr<const QuicCredentials> credentials,
+                                                       const QuicConnectionOptions& options, const UdpAddress& peer,
+                                                       std::string_view original_destination, std::string_view client_source)
+{
+    if (credentials == nullptr || original_destination.size() < 8)
+    {
+        return nullptr;
+    }
+    std::unique_ptr<QuicConnection> connection(new QuicConnection(true, options, peer));
+    connection->m_original_id.assign(original_destination);
+    connection->m_peer_id.assign(client_source);
+
+    std::string client_secret;
+    std::string server_secret;
+    quic::DeriveInitialSecrets(original_destination, client_secret, server_secret);
+    Space& initial = connection->GetSpace(Level::kInitial);
+    if (!initial.read.Install(client_secret) || !initial.write.Install(server_secret))
+    {
+        return nullptr;
+    }
+    connection->m_tls = std::make_unique<QuicTls>(QuicTls::Role::kServer, std::move(credentials),
+                                                  connection->LocalParameters().Encode());
+    return connection;
+}
+
+std::unique_ptr<QuicConnection> QuicConnection::Connect(const QuicConnectionOptions& options, const UdpAddress& peer)
+{
+    std::unique_ptr<QuicConnection> connection(new QuicConnection(false, options, peer));
+    connection->m_original_id = RandomId();
+    connection->m_peer_id = connection->m_original_id;
+    connection->m_address_validated = true;
+
+    std::string client_secret;
+    std::string server_secret;
+    quic::DeriveInitialSecrets(connection->m_original_id, client_secret, server_secret);
+    Space& initial = connection->GetSpace(Level::kInitial);
+    if (!initial.read.Install(server_secret) || !initial.write.Install(client_secret))
+    {
+        return nullptr;
+    }
+    connection->m_tls = std::make_unique<QuicTls>(QuicTls::Role::kClient, nullptr, connection->LocalParameters().Encode());
+    connection->m_tls->SetPeerVerification(options.peer);
+    if (!connection->m_tls->Start())
+    {
+        return nullptr;
+    }
+    initial.crypto_send.Append(connection->m_tls->TakeOutput(Level::kInitial));
+    return connection;
+}
+
+quic::TransportParameters QuicConnection::LocalParameters() const
+{
+    quic::TransportParameters parameters;
+    if (m_server)
+    {
+        parameters.original_destination_connection_id = m_original_id;
+        parameters.disable_active_migration = true;
+    }
+    parameters.initial_source_connection_id = m_local_id;
+    parameters.max_idle_timeout = static_cast<uint64_t>(m_options.idle_timeout.count());
+    parameters.max_udp_payload_size = quic::kMaxDatagram;
+    parameters.initial_max_data = m_options.max_data;
+    parameters.initial_max_stream_data_bidi_local = m_options.max_stream_data;
+    parameters.initial_max_stream_data_bidi_remote = m_options.max_stream_data;
+    parameters.initial_max_stream_data_uni = m_options.max_stream_data;
+    parameters.initial_max_streams_bidi = m_options.max_streams_bidi;
+    parameters.initial_max_streams_uni = m_options.max_streams_uni;
+    parameters.ack_delay_exponent = kAckDelayExponent;
+    parameters.max_ack_delay = static_cast<uint64_t>(kMaxAckDelay.count());
+    return parameters;
+}
+
+bool QuicConnection::ApplyPeerParameters()
+{
+    if (!m_peer_parameters.Decode(m_tls->PeerTransportParameters()))
+    {
+        return false;
+    }
+    if (m_peer_parameters.initial_source_connection_id != m_peer_id)
+    {
+        return false;
+    }
+    if (!m_server && m_peer_parameters.original_destination_connection_id != m_original_id)
+    {
+        return false;
+    }
+    if (m_server && !m_peer_parameters.original_destination_connection_id.empty())
+    {
+        return false;
+    }
+    m_max_send_data = m_peer_parameters.initial_max_data;
+    m_max_local_streams = {m_peer_parameters.initial_max_streams_bidi, m_peer_parameters.initial_max_streams_uni};
+    return true;
+}
+
+uint64_t QuicConnection::AvailableStreams(bool bidirectional) const
+{
+    const size_t kind = bidirectional ? 0 : 1;
+    return m_max_local_streams[kind] - std::min(m_max_local_streams[kind], m_next_local_stream[kind]);
+}
+
+void QuicConnection::InstallKeys()
+{
+    for (const Level level : {Level::kHandshake, Level::kApplication})
+    {
+        Space& space = GetSpace(level);
+        if (space.discarded)
+        {
+            continue;
+        }
+        if (!space.read.IsInstalled() && !m_tls->ReadSecret(level).empty())
+        {
+            space.read.Install(m_tls->ReadSecret(level));
+        }
+        if (!space.write.IsInstalled() && !m_tls->WriteSecret(level).empty())
+        {
+            space.write.Install(m_tls->WriteSecret(level));
+        }
+    }
+}
+
+void QuicConnection::DiscardSpace(Level level)
+{
+    Space& space = GetSpace(level);
+    if (space.discarded)
+    {
+        return;
+    }
+    for (const auto& entry : space.sent)
+    {
+        m_bytes_in_flight -= std::min<uint64_t>(m_bytes_in_flight, entry.second.size);
+    }
+    space.sent.clear();
+    space.read.Discard();
+    space.write.Discard();
+    space.ack_pending = false;
+    space.ack_deadline = TimePoint::max();
+    space.loss_time = TimePoint::max();
+    space.crypto_send = quic::SendBuffer{};
+    space.discarded = true;
+    m_probe_count = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Receiving
+// -----------------------------------------------------------------------------
+
+void QuicConnection::Receive(std::string_view datagram, TimePoint now)
+{
+    if (m_state == State::kClosed || m_state == State::kDraining)
+    {
+        return;
+    }
+    m_bytes_received += datagram.size();
+
+    while (!datagram.empty())
+    {
+        quic::PacketHeader header;
+        if (!quic::ParseHeader(datagram, quic::kConnectionIdLength, header) || header.packet_length == 0
+            || header.packet_length > datagram.size())
+        {
+            break;
+        }
+        const std::string_view packet = datagram.substr(0, header.packet_length);
+        datagram.remove_prefix(header.packet_length);
+
+        Level level;
+        switch (header.type)
+        {
+            case quic::PacketType::kInitial:
+                level = Level::kInitial;
+                break;
+            case quic::PacketType::kHandshake:
+                level = Level::kHandshake;
+                break;
+            case quic::PacketType::kOneRtt:
+                level = Level::kApplication;
+                break;
+            case quic::PacketType::kVersionNegotiation:
+                if (!m_server && m_state == State::kHandshake)
+                {
+                    Terminate("server does not support QUIC v1");
+                    return;
+                }
+                continue;
+            default:
+                continue;   // 0-RTT and Retry are not supported
+        }
+        if (header.version != 0 && header.version != quic::kVersion1)
+        {
+            continue;
+        }
+        if (header.destination != m_local_id && !(m_server && header.destination == m_original_id))
+        {
+            continue;
+        }
+
+        Space& space = GetSpace(level);
+        if (space.discarded || !space.read.IsInstalled())
+        {
+            continue;
+        }
+        if (m_state == State::kClosing)
+        {
+            m_close_pending = true;
+            continue;
+        }
+
+        m_packet.assign(packet.data(), packet.size());
+        uint64_t packet_number = 0;
+        size_t payload_offset = 0;
+        if (!space.read.Open(m_packet, header.packet_number_offset, space.largest_received, packet_number, payload_offset)
+            || space.received.Contains(packet_number))
+        {
+            continue;
+        }
+        if ((static_cast<unsigned char>(m_packet[0]) & ((m_packet[0] & 0x80) != 0 ? 0x0c : 0x18)) != 0)
+        {
+            Close(quic::kProtocolViolation, false, "reserved bits set");
+            return;
+        }
+
+        if (!m_server && level == Level::kInitial && !m_peer_id_confirmed)
+        {
+            // The server chose its connection ID; everything from now on goes there
+            m_peer_id.assign(header.source);
+            m_peer_id_confirmed = true;
+        }
+        if (m_server && level == Level::kHandshake)
+        {
+            m_address_validated = true;
+            DiscardSpace(Level::kInitial);
+        }
+        m_last_activity = now;
+
+        bool ack_eliciting = false;
+        const std::string_view payload(m_packet.data() + payload_offset, m_packet.size() - payload_offset);
+        if (!ProcessFrames(level, payload, now, ack_eliciting))
+        {
+            return;
+        }
+        if (space.discarded)
+        {
+            continue;
+        }
+
+        // Out-of-order arrival hints at loss; acknowledging at once speeds up its detection
+        const bool out_of_order = static_cast<int64_t>(packet_number) != space.largest_received + 1;
+        space.received.Add(packet_number, packet_number + 1);
+        while (space.received.Ranges().size() > kMaxAckRanges)
+        {
+            const auto oldest = *space.received.Ranges().begin();
+            space.received.Remove(oldest.first, oldest.second);
+        }
+        if (static_cast<int64_t>(packet_number) > space.largest_received)
+        {
+            space.largest_received = static_cast<int64_t>(packet_number);
+            space.largest_received_time = now;
+        }
+        if (ack_eliciting)
+        {
+            space.ack_pending = true;
+            ++space.unacked_eliciting;
+            if (level != Level::kApplication || space.unacked_eliciting >= 2 || out_of_order)
+            {
+                space.ack_deadline = now;
+            }
+            else if (space.ack_deadline == TimePoint::max())
+            {
+                space.ack_deadline = now + kMaxAckDelay;
+            }
+        }
+    }
+}
+
+bool QuicConnection::ProcessFrames(Level level, std::string_view payload, TimePoint now, bool& ack_eliciting)
+{
+    const bool handshake_level = level != Level::kApplication;
+    const auto malformed = [this]() {
+        Close(quic::kFrameEncodingError, false, "malformed frame");
+        return false;
+    };
+
+    while (!payload.empty())
+    {
+        uint64_t type = 0;
+        if (!quic::ReadVarint(payload, type))
+        {
+            return malformed();
+        }
+        if (IsAckEliciting(type))
+        {
+            ack_eliciting = true;
+        }
+        if (handshake_level && type != 0x00 && type != 0x01 && type != 0x02 && type != 0x03 && type != 0x06 && type != 0x1c)
+        {
+            Close(quic::kProtocolViolation, false, "frame not allowed at this encryption level");
+            return false;
+        }
+
+        uint64_t values[4] = {};
+        std::string_view bytes;
+        switch (type)
+        {
+            case 0x00:  // PADDING
+                while (!payload.empty() && payload.front() == '\0')
+                {
+                    payload.remove_prefix(1);
+                }
+                break;
+            case 0x01:  // PING
+                break;
+            case 0x02:  // ACK
+            case 0x03:  // ACK with ECN counts
+                if (!OnAckFrame(level, payload, type == 0x03, now))
+                {
+                    return false;
+                }
+                break;
+            case 0x04:  // RESET_STREAM
+            {
+                if (!quic::ReadVarint(payload, values[0]) || !quic::ReadVarint(payload, values[1])
+                    || !quic::ReadVarint(payload, values[2]))
+                {
+                    return malformed();
+                }
+                uint64_t error = 0;
+                Stream* stream = GetStream(values[0], true, error);
+                if (stream == nullptr)
+                {
+                    if (error != 0)
+                    {
+                        Close(error, false, "invalid stream");
+                        return false;
+                    }
+                    break;
+                }
+                if (!stream->local_receive)
+                {
+                    Close(quic::kStreamStateError, false, "RESET_STREAM on a send-only stream");
+                    return false;
+                }
+                const uint64_t highest = stream->receive.Highest();
+                if (!stream->receive.Insert(values[2], {}, true))
+                {
+                    Close(quic::kFinalSizeError, false, "final size changed");
+                    return false;
+                }
+                m_received_data += stream->receive.Highest() - highest;
+                if (!stream->receive_done)
+                {
+                    stream->receive_done = true;
+                    if (m_callbacks.on_stream_reset)
+                    {
+                        m_callbacks.on_stream_reset(values[0], values[1]);
+                    }
+                }
+                MaybeRetireStream(values[0]);
+                break;
+            }
+            case 0x05:  // STOP_SENDING
+            {
+                if (!quic::ReadVarint(payload, values[0]) || !quic::ReadVarint(payload, values[1]))
+                {
+                    return malformed();
+                }
+                uint64_t error = 0;
+                Stream* stream = GetStream(values[0], true, error);
+                if (stream == nullptr)
+                {
+                    if (error != 0)
+                    {
+                        Close(error, false, "invalid stream");
+                        return false;
+                    }
+                    break;
+                }
+                if (!stream->local_send)
+                {
+                    Close(quic::kStreamStateError, false, "STOP_SENDING on a receive-only stream");
+                    return false;
+                }
+                if (!stream->reset_sent && !stream->send.IsAcked())
+                {
+                    stream->send.Reset();
+                    stream->reset_sent = true;
+                    stream->send_reset = true;
+                    stream->reset_error = values[1];
+                }
+                break;
+            }
+            case 0x06:  // CRYPTO
+            {
+                if (!quic::ReadVarint(payload, values[0]) || !quic::ReadVarint(payload, values[1])
+                    || !quic::ReadBytes(payload, values[1], bytes))
+                {
+                    return malformed();
+                }
+                if (values[0] + values[1] > kMaxCryptoBuffer)
+                {
+                    Close(0x0d, false, "crypto buffer exceeded");
+                    return false;
+                }
+                GetSpace(level).crypto_receive.Insert(values[0], bytes, false);
+                if (!OnCryptoData(level))
+                {
+                    return false;
+                }
+                break;
+            }
+            case 0x07:  // NEW_TOKEN
+                if (!quic::ReadVarint(payload, values[0]) || !quic::ReadBytes(payload, values[0], bytes))
+                {
+                    return malformed();
+                }
+                if (m_server)
+                {
+                    Close(quic::kProtocolViolation, false, "NEW_TOKEN from a client");
+                    return false;
+                }
+                break;
+            case 0x08: case 0x09: case 0x0a: case 0x0b:
+            case 0x0c: case 0x0d: case 0x0e: case 0x0f:    // STREAM
+            {
+                if (!quic::ReadVarint(payload, values[0]))
+                {
+                    return malformed();
+                }
+                if ((type & 0x04) != 0 && !quic::ReadVarint(payload, values[1]))
+                {
+                    return malformed();
+                }
+                if ((type & 0x02) != 0)
+                {
+                    if (!quic::ReadVarint(payload, values[2]) || !quic::ReadBytes(payload, values[2], bytes))
+                    {
+                        return malformed();
+                    }
+                }
+                else
+                {
+                    bytes = payload;
+                    payload = {};
+                }
+                if (values[1] + bytes.size() > quic::kMaxVarint)
+                {
+                    Close(quic::kFrameEncodingError, false, "stream offset too large");
+                    return false;
+                }
+                if (!OnStreamFrame(values[0], values[1], bytes, (type & 0x01) != 0))
+                {
+                    return false;
+                }
+                break;
+            }
+            case 0x10:  // MAX_DATA
+                if (!quic::ReadVarint(payload, values[0]))
+                {
+                    return malformed();
+                }
+                m_max_send_data = std::max(m_max_send_data, values[0]);
+                break;
+            case 0x11:  // MAX_STREAM_DATA
+            {
+                if (!quic::ReadVarint(payload, values[0]) || !quic::ReadVarint(payload, values[1]))
+                {
+                    return malformed();
+                }
+                uint64_t error = 0;
+                Stream* stream = GetStream(values[0], true, error);
+                if (stream == nullptr && error != 0)
+                {
+                    Close(error, false, "invalid stream");
+                    return false;
+                }
+                if (stream != nullptr)
+                {
+                    stream->max_send = std::max(stream->max_send, values[1]);
+                }
+                break;
+            }
+            case 0x12:  // MAX_STREAMS (bidirectional)
+            case 0x13:  // MAX_STREAMS (unidirectional)
+            {
+                if (!quic::ReadVarint(payload, values[0]))
+                {
+                    return malformed();
+                }
+                uint64_t& limit = m_max_local_streams[type == 0x12 ? 0 : 1];
+                limit = std::max(limit, values[0]);
+                break;
+            }
+            case 0x14:  // DATA_BLOCKED
+            case 0x16:  // STREAMS_BLOCKED
+            case 0x17:
+            case 0x19:  // RETIRE_CONNECTION_ID
+                if (!quic::ReadVarint(payload, values[0]))
+                {
+                    return malformed();
+                }
+                break;
+            case 0x15:  // STREAM_DATA_BLOCKED
+                if (!quic::ReadVarint(payload, values[0]) || !quic::ReadVarint(payload, values[1]))
+                {
+                    return malformed();
+                }
+                break;
+            case 0x18:  // NEW_CONNECTION_ID: unused, the handshake connection ID stays in use
+                if (!quic::ReadVarint(payload, values[0]) || !quic::ReadVarint(payload, values[1])
+                    || !quic::ReadBytes(payload, 1, bytes) || !quic::ReadBytes(payload, static_cast<unsigned char>(bytes[0]), bytes)
+                    || !quic::ReadBytes(payload, 16, bytes))
+                {
+                    return malformed();
+                }
+                break;
+            case 0x1a:  // PATH_CHALLENGE
+                if (!quic::ReadBytes(payload, 8, bytes))
+                {
+                    return malformed();
+                }
+                m_path_responses.emplace_back(bytes);
+                break;
+            case 0x1b:  // PATH_RESPONSE
+                if (!quic::ReadBytes(payload, 8, bytes))
+                {
+                    return malformed();
+                }
+                break;
+            case 0x1c:  // CONNECTION_CLOSE (transport)
+            case 0x1d:  // CONNECTION_CLOSE (application)
+            {
+                if (!quic::ReadVarint(payload, values[0]) || (type == 0x1c && !quic::ReadVarint(payload, values[1]))
+                    || !quic::ReadVarint(payload, values[2]) || !quic::ReadBytes(payload, values[2], bytes))
+                {
+                    return malformed();
+                }
+                m_close_error = values[0];
+                m_close_application = type == 0x1d;
+                m_close_reason = "peer closed (" + std::string(type == 0x1d ? "application" : "transport") + " error "
+                               + std::to_string(values[0]) + (bytes.empty() ? "" : ": " + std::string(bytes)) + ")";
+                m_state = State::kDraining;
+                m_close_deadline = now + 3 * ProbeTimeout();
+                return false;
+            }
+            case 0x1e:  // HANDSHAKE_DONE
+                if (m_server)
+                {
+                    Close(quic::kProtocolViolation, false, "HANDSHAKE_DONE from a client");
+                    return false;
+                }
+                m_handshake_confirmed = true;
+                DiscardSpace(Level::kHandshake);
+                break;
+            default:
+                Close(quic::kFrameEncodingError, false, "unknown frame type " + std::to_string(type));
+                return false;
+        }
+        if (m_state == State::kClosing || m_state == State::kClosed)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool QuicConnection::OnAckFrame(Level level, std::string_view& payload, bool ecn, TimePoint now)
+{
+    uint64_t largest = 0;
+    uint64_t delay = 0;
+    uint64_t count = 0;
+    uint64_t first = 0;
+    if (!quic::ReadVarint(payload, largest) || !quic::ReadVarint(payload, delay) || !quic::ReadVarint(payload, count)
+        || !quic::ReadVarint(payload, first) || first > largest)
+    {
+        Close(quic::kFrameEncodingError, false, "malformed ACK");
+        return false;
+    }
+
+    Space& space = GetSpace(level);
+    if (largest >= space.next_packet_number)
+    {
+        Close(quic::kProtocolViolation, false, "ACK of an unsent packet");
+        return false;
+    }
+
+    std::vector<uint64_t> acked;
+    uint64_t high = largest;
+    uint64_t low = largest - first;
+    for (uint64_t i = 0;; ++i)
+    {
+        for (auto it = space.sent.lower_bound(low); it != space.sent.end() && it->first <= high; ++it)
+        {
+            acked.push_back(it->first);
+        }
+        if (i == count)
+        {
+            break;
+        }
+        uint64_t gap = 0;
+        uint64_t length = 0;
+        if (!quic::ReadVarint(payload, gap) || !quic::ReadVarint(payload, length) || gap + 2 > low
+            || length > low - gap - 2)
+        {
+            Close(quic::kFrameEncodingError, false, "malformed ACK range");
+            return false;
+        }
+        high = low - gap - 2;
+        low = high - length;
+    }
+    if (ecn)
+    {
+        uint64_t counts[3];
+        if (!quic::ReadVarint(payload, counts[0]) || !quic::ReadVarint(payload, counts[1]) || !quic::ReadVarint(payload, counts[2]))
+        {
+            Close(quic::kFrameEncodingError, false, "malformed ACK");
+            return false;
+        }
+    }
+    if (acked.empty())
+    {
+        return true;
+    }
+
+    // RTT sample from the largest acknowledged packet if it is newly acknowledged
+    auto largest_packet = space.sent.find(largest);
+    if (largest_packet != space.sent.end() && largest_packet->second.ack_eliciting)
+    {
+        m_latest_rtt = std::chrono::duration_cast<std::chrono::microseconds>(now - largest_packet->second.time);
+        std::chrono::microseconds ack_delay(level == Level::kApplication
+                                                ? static_cast<int64_t>(delay << m_peer_parameters.ack_delay_exponent)
+                                                : 0);
+        if (m_handshake_confirmed)
+        {
+            ack_delay = std::min(ack_delay, std::chrono::microseconds(m_peer_parameters.max_ack_delay * 1000));
+        }
+        if (!m_rtt_sampled)
+        {
+            m_rtt_sampled = true;
+            m_min_rtt = m_latest_rtt;
+            m_smoothed_rtt = m_latest_rtt;
+            m_rtt_variance = m_latest_rtt / 2;
+        }
+        else
+        {
+            m_min_rtt = std::min(m_min_rtt, m_latest_rtt);
+            auto adjusted = m_latest_rtt;
+            if (m_latest_rtt >= m_min_rtt + ack_delay)
+            {
+                adjusted -= ack_delay;
+            }
+            const auto difference = m_smoothed_rtt > adjusted ? m_smoothed_rtt - adjusted : adjusted - m_smoothed_rtt;
+            m_rtt_variance = (3 * m_rtt_variance + difference) / 4;
+            m_smoothed_rtt = (7 * m_smoothed_rtt + adjusted) / 8;
+        }
+    }
+    space.largest_acked = std::max(space.largest_acked, static_cast<int64_t>(largest));
+
+    OnPacketsAcked(level, acked, now);
+    DetectLoss(level, now);
+    m_probe_count = 0;
+    return true;
+}
+
+void QuicConnection::OnPacketsAcked(Level level, const std::vector<uint64_t>& numbers, TimePoint now)
+{
+    (void)now;
+    Space& space = GetSpace(level);
+    for (const uint64_t number : numbers)
+    {
+        auto it = space.sent.find(number);
+        if (it == space.sent.end())
+        {
+            continue;
+        }
+        SentPacket packet = std::move(it->second);
+        space.sent.erase(it);
+        if (packet.size > 0)
+        {
+            m_bytes_in_flight -= std::min<uint64_t>(m_bytes_in_flight, packet.size);
+            if (packet.time > m_recovery_start)
+            {
+                if (m_congestion_window < m_slow_start_threshold)
+                {
+                    m_congestion_window += packet.size;
+                }
+                else
+                {
+                    m_congestion_window += 1200 * packet.size / m_congestion_window;
+                }
+            }
+        }
+        for (const SentFrame& frame : packet.frames)
+        {
+            OnFrameAcked(frame);
+        }
+        if (space.discarded)
+        {
+            return;
+        }
+    }
+}
+
+void QuicConnection::DetectLoss(Level level, TimePoint now)
+{
+    Space& space = GetSpace(level);
+    space.loss_time = TimePoint::max();
+    if (space.largest_acked < 0)
+    {
+        return;
+    }
+    const auto loss_delay = std::max<std::chrono::microseconds>(9 * std::max(m_latest_rtt, m_smoothed_rtt) / 8, kGranularity);
+    const TimePoint lost_before = now - loss_delay;
+    TimePoint latest_lost{};
+    bool lost = false;
+
+    for (auto it = space.sent.begin(); it != space.sent.end() && static_cast<int64_t>(it->first) <= space.largest_acked;)
+    {
+        if (static_cast<int64_t>(it->first) + 3 <= space.largest_acked || it->second.time <= lost_before)
+        {
+            SentPacket packet = std::move(it->second);
+            it = space.sent.erase(it);
+            m_bytes_in_flight -= std::min<uint64_t>(m_bytes_in_flight, packet.size);
+            latest_lost = std::max(latest_lost, packet.time);
+            lost = true;
+            for (const SentFrame& frame : packet.frames)
+            {
+                OnFrameLost(frame);
+            }
+        }
+        else
+        {
+            space.loss_time = std::min(space.loss_time, it->second.time + loss_delay);
+            ++it;
+        }
+    }
+    if (lost)
+    {
+        OnCongestionEvent(latest_lost, now);
+    }
+}
+
+void QuicConnection::OnCongestionEvent(TimePoint sent_time, TimePoint now)
+{
+    if (sent_time <= m_recovery_start)
+    {
+        return;     // Already reduced for this flight
+    }
+    m_recovery_start = now;
+    m_congestion_window = std::max(m_congestion_window / 2, kMinimumWindow);
+    m_slow_start_threshold = m_congestion_window;
+}
+
+void QuicConnection::OnFrameAcked(const SentFrame& frame)
+{
+    switch (frame.kind)
+    {
+        case SentFrame::Kind::kCrypto:
+        {
+            Space& space = m_spaces[frame.stream_id];
+            if (!space.discarded)
+            {
+                space.crypto_send.OnAcked(frame.offset, frame.length, false);
+            }
+            break;
+        }
+        case SentFrame::Kind::kStream:
+        {
+            auto it = m_streams.find(frame.stream_id);
+            if (it != m_streams.end())
+            {
+                it->second.send.OnAcked(frame.offset, frame.length, frame.fin);
+                MaybeRetireStream(frame.stream_id);
+            }
+            break;
+        }
+        case SentFrame::Kind::kResetStream:
+        {
+            auto it = m_streams.find(frame.stream_id);
+            if (it != m_streams.end())
+            {
+                it->second.reset_in_flight = false;
+                MaybeRetireStream(frame.stream_id);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void QuicConnection::OnFrameLost(const SentFrame& frame)
+{
+    switch (frame.kind)
+    {
+        case SentFrame::Kind::kCrypto:
+        {
+            Space& space = m_spaces[frame.stream_id];
+            if (!space.discarded)
+            {
+                space.crypto_send.OnLost(frame.offset, frame.length, false);
+            }
+            break;
+        }
+        case SentFrame::Kind::kStream:
+        {
+            auto it = m_streams.find(frame.stream_id);
+            if (it != m_streams.end() && !it->second.reset_sent)
+            {
+                it->second.send.OnLost(frame.offset, frame.length, frame.fin);
+            }
+            break;
+        }
+        case SentFrame::Kind::kMaxData:
+            m_send_max_data = true;
+            break;
+        case SentFrame::Kind::kMaxStreamData:
+        {
+            auto it = m_streams.find(frame.stream_id);
+            if (it != m_streams.end() && !it->second.receive_done)
+            {
+                it->second.send_max_receive = true;
+            }
+            break;
+        }
+        case SentFrame::Kind::kMaxStreamsBidi:
+            m_send_max_streams[0] = true;
+            break;
+        case SentFrame::Kind::kMaxStreamsUni:
+            m_send_max_streams[1] = true;
+            break;
+        case SentFrame::Kind::kHandshakeDone:
+            m_handshake_done_pending = true;
+            break;
+        case SentFrame::Kind::kResetStream:
+        {
+            auto it = m_streams.find(frame.stream_id);
+            if (it != m_streams.end())
+            {
+                it->second.send_reset = true;
+                it->second.reset_in_flight = false;
+            }
+            break;
+        }
+        case SentFrame::Kind::kStopSending:
+        {
+            auto it = m_streams.find(frame.stream_id);
+            if (it != m_streams.end())
+            {
+                it->second.send_stop = true;
+            }
+            break;
+        }
+    }
+}
+
+bool QuicConnection::OnCryptoData(Level level)
+{
+    Space& space = GetSpace(level);
+    std::string data;
+    space.crypto_receive.Read(data);
+    if (data.empty())
+    {
+        return true;
+    }
+    if (!m_tls->Receive(level, data))
+    {
+        Close(quic::kCryptoError + m_tls->Alert(), false, m_tls->Error());
+        return false;
+    }
+    for (const Level output_level : {Level::kInitial, Level::kHandshake, Level::kApplication})
+    {
+        std::string output = m_tls->TakeOutput(output_level);
+        if (!output.empty() && !GetSpace(output_level).discarded)
+        {
+            GetSpace(output_level).crypto_send.Append(output);
+        }
+    }
+    InstallKeys();
+    if (m_state == State::kHandshake && m_tls->IsComplete())
+    {
+        OnHandshakeComplete();
+    }
+    return m_state != State::kClosing && m_state != State::kClosed;
+}
+
+void QuicConnection::OnHandshakeComplete()
+{
+    if (!ApplyPeerParameters())
+    {
+        Close(quic::kTransportParameterError, false, "invalid transport parameters");
+        return;
+    }
+    m_state = State::kEstablished;
+    if (m_server)
+    {
+        // The client's Finished confirms the handshake for the server
+        m_handshake_confirmed = true;
+        m_handshake_done_pending = true;
+        DiscardSpace(Level::kHandshake);
+    }
+    if (m_callbacks.on_established)
+    {
+        m_callbacks.on_established();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Streams
+// -----------------------------------------------------------------------------
+
+QuicConnection::Stream* QuicConnection::GetStream(uint64_t stream_id, bool from_peer, uint64_t& error)
+{
+    error = 0;
+    auto it = m_streams.find(stream_id);
+    if (it != m_streams.end())
+    {
+        return &it->second;
+    }
+
+    const size_t kind = (stream_id & 0x02) != 0 ? 1 : 0;
+    const uint64_t index = stream_id >> 2;
+    if (IsLocalStream(stream_id))
+    {
+        if (from_peer && index >= m_next_local_stream[kind])
+        {
+            error = quic::kStreamStateError;     // Never opened
+        }
+        return nullptr;
+    }
+    if (index < m_peer_streams_opened[kind])
+    {
+        return nullptr;     // Already closed
+    }
+    if (index >= m_max_peer_streams[kind])
+    {
+        error = quic::kStreamLimitError;
+        return nullptr;
+    }
+
+    // Opening a stream opens every lower-numbered stream of the same type
+    Stream* stream = nullptr;
+    for (uint64_t next = m_peer_streams_opened[kind]; next <= index; ++next)
+    {
+        const uint64_t id = (next << 2) | (stream_id & 0x03);
+        Stream& created = m_streams[id];
+        created.local_send = kind == 0;
+        created.max_receive = m_options.max_stream_data;
+        created.max_send = kind == 0 ? m_peer_parameters.initial_max_stream_data_bidi_local : 0;
+        if (kind == 1)
+        {
+            created.send.Reset();
+        }
+        stream = &created;
+    }
+    m_peer_streams_opened[kind] = index + 1;
+    return stream;
+}
+
+uint64_t QuicConnection::OpenStream(bool bidirectional)
+{
+    const size_t kind = bidirectional ? 0 : 1;
+    if (m_state != State::kEstablished || m_next_local_stream[kind] >= m_max_local_streams[kind])
+    {
+        return UINT64_MAX;
+    }
+    const uint64_t id = (m_next_local_stream[kind]++ << 2) | (bidirectional ? 0 : 2) | (m_server ? 1 : 0);
+    Stream& stream = m_streams[id];
+    stream.local_receive = bidirectional;
+    stream.receive_done = !bidirectional;
+    stream.max_receive = bidirectional ? m_options.max_stream_data : 0;
+    stream.max_send = bidirectional ? m_peer_parameters.initial_max_stream_data_bidi_remote
+                                    : m_peer_parameters.initial_max_stream_data_uni;
+    return id;
+}
+
+bool QuicConnection::SendStream(uint64_t stream_id, std::string_view data, bool fin)
+{
+    auto it = m_streams.find(stream_id);
+    if (it == m_streams.end() || !it->second.local_send || it->second.reset_sent || m_state != State::kEstablished)
+    {
+        return false;
+    }
+    it->second.send.Append(data);
+    if (fin)
+    {
+        it->second.send.Finish();
+    }
+    return true;
+}
+
+void QuicConnection::ResetStream(uint64_t stream_id, uint64_t error)
+{
+    auto it = m_streams.find(stream_id);
+    if (it == m_streams.end())
+    {
+        return;
+    }
+    Stream& stream = it->second;
+    if (stream.local_send && !stream.reset_sent && !stream.send.IsAcked())
+    {
+        stream.send.Reset();
+        stream.reset_sent = true;
+        stream.send_reset = true;
+        stream.reset_error = error;
+    }
+    if (stream.local_receive && !stream.receive_done)
+    {
+        stream.receive_done = true;
+        stream.send_stop = true;
+        stream.reset_error = error;
+    }
+    MaybeRetireStream(stream_id);
+}
+
+void QuicConnection::MaybeRetireStream(uint64_t stream_id)
+{
+    auto it = m_streams.find(stream_id);
+    if (it == m_streams.end())
+    {
+        return;
+    }
+    const Stream& stream = it->second;
+    const bool send_done = !stream.local_send
+        || (stream.send.IsAcked() && !stream.send_reset && !stream.reset_in_flight && !stream.send_stop);
+    const bool receive_done = !stream.local_receive || stream.receive_done;
+    if (!send_done || !receive_done)
+    {
+        return;
+    }
+    if (!IsLocalStream(stream_id))
+    {
+        // Let the peer open another stream in place of this one
+        const size_t kind = (stream_id & 0x02) != 0 ? 1 : 0;
+        ++m_max_peer_streams[kind];
+        m_send_max_streams[kind] = true;
+    }
+    m_streams.erase(it);
+}
+
+bool QuicConnection::OnStreamFrame(uint64_t stream_id, uint64_t offset, std::string_view data, bool fin)
+{
+    uint64_t error = 0;
+    Stream* stream = GetStream(stream_id, true, error);
+    if (stream == nullptr)
+    {
+        if (error != 0)
+        {
+            Close(error, false, "invalid stream");
+            return false;
+        }
+        return true;
+    }
+    if (!stream->local_receive)
+    {
+        Close(quic::kStreamStateError, false, "STREAM on a send-only stream");
+        return false;
+    }
+    if (stream->receive_done)
+    {
+        return true;
+    }
+    if (offset + data.size() > stream->max_receive)
+    {
+        Close(quic::kFlowControlError, false, "stream flow control exceeded");
+        return false;
+    }
+    const uint64_t highest = stream->receive.Highest();
+    if (!stream->receive.Insert(offset, data, fin))
+    {
+        Close(quic::kFinalSizeError, false, "final size changed");
+        return false;
+    }
+    m_received_data += stream->receive.Highest() - highest;
+    if (m_received_data > m_max_receive_data)
+    {
+        Close(quic::kFlowControlError, false, "connection flow control exceeded");
+        return false;
+    }
+
+    m_stream_scratch.clear();
+    const bool ended = stream->receive.Read(m_stream_scratch);
+    if (m_stream_scratch.empty() && !ended)
+    {
+        return true;
+    }
+
+    // Data is handed over at once, so credit goes back as soon as half a window is used
+    m_delivered_data += m_stream_scratch.size();
+    if (m_max_receive_data - m_delivered_data < m_options.max_data / 2)
+    {
+        m_max_receive_data = m_delivered_data + m_options.max_data;
+        m_send_max_data = true;
+    }
+    if (ended)
+    {
+        stream->receive_done = true;
+    }
+    else if (stream->max_receive - stream->receive.Delivered() < m_options.max_stream_data / 2)
+    {
+        stream->max_receive = stream->receive.Delivered() + m_options.max_stream_data;
+        stream->send_max_receive = true;
+    }
+
+    if (m_callbacks.on_stream_data)
+    {
+        const std::string delivered = std::move(m_stream_scratch);
+        m_callbacks.on_stream_data(stream_id, delivered, ended);
+    }
+    MaybeRetireStream(stream_id);
+    return m_state != State::kClosing && m_state != State::kClosed;
+}
+
+// -----------------------------------------------------------------------------
+// Sending
+// -----------------------------------------------------------------------------
+
+void QuicConnection::AppendAckFrame(Level level, std::string& payload, TimePoint now)
+{
+    Space& space = GetSpace(level);
+    const auto& ranges = space.received.Ranges();
+    if (ranges.empty())
+    {
+        return;
+    }
+    auto it = ranges.rbegin();
+    const uint64_t largest = it->second - 1;
+    const auto delay = std::chrono::duration_cast<std::chrono::microseconds>(now - space.largest_received_time).count();
+
+    payload.push_back(0x02);
+    quic::AppendVarint(payload, largest);
+    quic::AppendVarint(payload, static_cast<uint64_t>(std::max<int64_t>(delay, 0)) >> kAckDelayExponent);
+    quic::AppendVarint(payload, ranges.size() - 1);
+    quic::AppendVarint(payload, largest - it->first);
+    uint64_t previous_start = it->first;
+    for (++it; it != ranges.rend(); ++it)
+    {
+        quic::AppendVarint(payload, previous_start - it->second - 1);
+        quic::AppendVarint(payload, it->second - 1 - it->first);
+        previous_start = it->first;
+    }
+
+    space.ack_pending = false;
+    space.unacked_eliciting = 0;
+    space.ack_deadline = TimePoint::max();
+}
+
+std::string QuicConnection::BuildPayload(Level level, size_t budget, bool allow_eliciting, TimePoint now, SentPacket& packet)
+{
+    Space& space = GetSpace(level);
+    std::string payload;
+
+    if (m_state == State::kClosing)
+    {
+        if (!m_close_pending)
+        {
+            return payload;
+        }
+        // Application errors may not be revealed before the handshake keys are confirmed
+        const bool application = m_close_application && level == Level::kApplication;
+        payload.push_back(application ? 0x1d : 0x1c);
+        quic::AppendVarint(payload, m_close_application && !application ? quic::kApplicationError : m_close_error);
+        if (!application)
+        {
+            quic::AppendVarint(payload, 0);
+        }
+        const std::string reason = application || !m_close_application ? m_close_reason.substr(0, 100) : std::string();
+        quic::AppendVarint(payload, reason.size());
+        payload.append(reason);
+        return payload;
+    }
+
+    const bool ack_due = space.ack_pending && space.ack_deadline <= now;
+    std::string ack;
+    if (space.ack_pending)
+    {
+        AppendAckFrame(level, ack, now);
+        if (ack.size() >= budget)
+        {
+            ack.clear();
+        }
+    }
+    size_t remaining = budget - ack.size();
+    const auto record = [&packet](SentFrame::Kind kind, uint64_t stream_id = 0, uint64_t offset = 0, uint64_t length = 0,
+                                  bool fin = false) {
+        packet.frames.push_back({kind, stream_id, offset, length, fin});
+    };
+
+    if (allow_eliciting)
+    {
+        std::string& frames = payload;
+        if (level == Level::kApplication)
+        {
+            if (m_handshake_done_pending && remaining > 1)
+            {
+                frames.push_back(0x1e);
+                record(SentFrame::Kind::kHandshakeDone);
+                m_handshake_done_pending = false;
+            }
+            while (!m_path_responses.empty() && remaining > frames.size() + 9)
+            {
+                frames.push_back(0x1b);
+                frames.append(m_path_responses.back());
+                m_path_responses.pop_back();
+            }
+            if (m_send_max_data && remaining > frames.size() + 9)
+            {
+                frames.push_back(0x10);
+                quic::AppendVarint(frames, m_max_receive_data);
+                record(SentFrame::Kind::kMaxData);
+                m_send_max_data = false;
+            }
+            for (size_t kind = 0; kind < 2; ++kind)
+            {
+                if (m_send_max_streams[kind] && remaining > frames.size() + 9)
+                {
+                    frames.push_back(kind == 0 ? 0x12 : 0x13);
+                    quic::AppendVarint(frames, m_max_peer_streams[kind]);
+                    record(kind == 0 ? SentFrame::Kind::kMaxStreamsBidi : SentFrame::Kind::kMaxStreamsUni);
+                    m_send_max_streams[kind] = false;
+                }
+            }
+            for (auto& entry : m_streams)
+            {
+                Stream& stream = entry.second;
+                if (stream.send_reset && remaining > frames.size() + 25)
+                {
+                    frames.push_back(0x04);
+                    quic::AppendVarint(frames, entry.first);
+                    quic::AppendVarint(frames, stream.reset_error);
+                    quic::AppendVarint(frames, stream.send.Sent());
+                    record(SentFrame::Kind::kResetStream, entry.first);
+                    stream.send_reset = false;
+                    stream.reset_in_flight = true;
+                }
+                if (stream.send_stop && remaining > frames.size() + 17)
+                {
+                    frames.push_back(0x05);
+                    quic::AppendVarint(frames, entry.first);
+                    quic::AppendVarint(frames, stream.reset_error);
+                    record(SentFrame::Kind::kStopSending, entry.first);
+                    stream.send_stop = false;
+                }
+                if (stream.send_max_receive && remaining > frames.size() + 17)
+                {
+                    frames.push_back(0x11);
+                    quic::AppendVarint(frames, entry.first);
+                    quic::AppendVarint(frames, stream.max_receive);
+                    record(SentFrame::Kind::kMaxStreamData, entry.first);
+                    stream.send_max_receive = false;
+                }
+            }
+        }
+
+        // CRYPTO: type, offset (up to 8 bytes) and length (2 bytes) before the data
+        while (space.crypto_send.HasPending() && remaining > frames.size() + 12)
+        {
+            uint64_t offset = 0;
+            std::string_view data;
+            bool fin = false;
+            if (!space.crypto_send.Next(remaining - frames.size() - 11, UINT64_MAX, offset, data, fin))
+            {
+                break;
+            }
+            frames.push_back(0x06);
+            quic::AppendVarint(frames, offset);
+            quic::AppendVarint(frames, data.size());
+            frames.append(data);
+            space.crypto_send.OnSent(offset, data.size(), false);
+            record(SentFrame::Kind::kCrypto, static_cast<uint64_t>(level), offset, data.size());
+        }
+
+        // STREAM: round-robin from where the last packet stopped
+        if (level == Level::kApplication && m_state == State::kEstablished && !m_streams.empty())
+        {
+            auto it = m_streams.lower_bound(m_next_stream_round);
+            for (size_t visited = 0; visited < m_streams.size() && remaining > frames.size() + 20; ++visited)
+            {
+                if (it == m_streams.end())
+                {
+                    it = m_streams.begin();
+                }
+                Stream& stream = it->second;
+                const uint64_t connection_credit = m_max_send_data - std::min(m_max_send_data, m_sent_data);
+                const uint64_t limit = std::min(stream.max_send, stream.send.Sent() + connection_credit);
+                uint64_t offset = 0;
+                std::string_view data;
+                bool fin = false;
+                if (stream.local_send && !stream.reset_sent && stream.send.HasPending(limit)
+                    && stream.send.Next(remaining - frames.size() - 19, limit, offset, data, fin))
+                {
+                    frames.push_back(0x0e | (fin ? 0x01 : 0x00));
+                    quic::AppendVarint(frames, it->first);
+                    quic::AppendVarint(frames, offset);
+                    quic::AppendVarint(frames, data.size());
+                    frames.append(data);
+                    if (offset + data.size() > stream.send.Sent())
+                    {
+                        m_sent_data += offset + data.size() - stream.send.Sent();
+                    }
+                    stream.send.OnSent(offset, data.size(), fin);
+                    record(SentFrame::Kind::kStream, it->first, offset, data.size(), fin);
+                    m_next_stream_round = it->first + 1;
+                }
+                ++it;
+            }
+        }
+
+        if (frames.empty() && m_probes_pending > 0 && m_probe_level == level)
+        {
+            frames.push_back(0x01);     // PING
+        }
+    }
+
+    packet.ack_eliciting = !payload.empty();
+    if (packet.ack_eliciting || ack_due)
+    {
+        payload.insert(0, ack);
+    }
+    else if (!ack.empty())
+    {
+        // Not due yet: keep the ACK pending for the timer or the next packet
+        space.ack_pending = true;
+        space.ack_deadline = space.ack_deadline == TimePoint::max() ? now + kMaxAckDelay : space.ack_deadline;
+    }
+    if (packet.ack_eliciting && m_probes_pending > 0 && m_probe_level == level)
+    {
+        --m_probes_pending;
+    }
+    return payload;
+}
+
+bool QuicConnection::SealPacket(Level level, std::string& payload, SentPacket& packet, TimePoint now, std::string& datagram)
+{
+    Space& space = GetSpace(level);
+    const uint64_t number = space.next_packet_number++;
+
+    std::string bytes;
+    bytes.reserve(quic::kMaxDatagram);
+    if (level != Level::kApplication)
+    {
+        bytes.push_back(static_cast<char>(0xc0 | (level == Level::kInitial ? 0x00 : 0x20) | (quic::kPacketNumberLength - 1)));
+        bytes.append("\x00\x00\x00\x01", 4);
+        bytes.push_back(static_cast<char>(m_peer_id.size()));
+        bytes.append(m_peer_id);
+        bytes.push_back(static_cast<char>(m_local_id.size()));
+        bytes.append(m_local_id);
+        if (level == Level::kInitial)
+        {
+            bytes.push_back('\0');      // Token length
+        }
+        const size_t length = quic::kPacketNumberLength + payload.size() + quic::kTagLength;
+        bytes.push_back(static_cast<char>(0x40 | (length >> 8)));
+        bytes.push_back(static_cast<char>(length));
+    }
+    else
+    {
+        bytes.push_back(static_cast<char>(0x40 | (quic::kPacketNumberLength - 1)));
+        bytes.append(m_peer_id);
+    }
+    const size_t number_offset = bytes.size();
+    for (size_t i = quic::kPacketNumberLength; i > 0; --i)
+    {
+        bytes.push_back(static_cast<char>(number >> (8 * (i - 1))));
+    }
+    bytes.append(payload);
+    if (!space.write.Seal(bytes, number_offset, number))
+    {
+        return false;
+    }
+    datagram.append(bytes);
+
+    if (packet.ack_eliciting)
+    {
+        packet.time = now;
+        packet.size = bytes.size();
+        m_bytes_in_flight += packet.size;
+        space.last_eliciting_sent = now;
+        space.sent.emplace(number, std::move(packet));
+    }
+    return true;
+}
+
+size_t QuicConnection::Flush(TimePoint now, UdpSendBatch& batch)
+{
+    if (m_state == State::kClosed || m_state == State::kDraining)
+    {
+        return 0;
+    }
+
+    size_t datagrams = 0;
+    std::string datagram;
+    while (datagrams < kMaxDatagramsPerFlush)
+    {
+        size_t limit = quic::kMaxDatagram;
+        if (IsAmplificationLimited())
+        {
+            break;
+        }
+        const bool allow_eliciting = m_probes_pending > 0 || m_bytes_in_flight + quic::kMaxDatagram <= m_congestion_window;
+
+        struct Pending
+        {
+            Level level;
+            std::string payload;
+            SentPacket packet;
+        };
+        std::vector<Pending> packets;
+        size_t size = 0;
+        bool has_initial = false;
+        bool eliciting_initial = false;
+        for (const Level level : {Level::kInitial, Level::kHandshake, Level::kApplication})
+        {
+            Space& space = GetSpace(level);
+            if (space.discarded || !space.write.IsInstalled())
+            {
+                continue;
+            }
+            const size_t overhead = level == Level::kApplication
+                ? 1 + m_peer_id.size() + quic::kPacketNumberLength + quic::kTagLength
+                : 1 + 4 + 2 + m_peer_id.size() + m_local_id.size() + (level == Level::kInitial ? 1 : 0) + 2
+                      + quic::kPacketNumberLength + quic::kTagLength;
+            if (size + overhead + 8 > limit)
+            {
+                break;
+            }
+            Pending pending{level, {}, {}};
+            pending.payload = BuildPayload(level, limit - size - overhead, allow_eliciting, now, pending.packet);
+            if (pending.payload.empty())
+            {
+                continue;
+            }
+            size += overhead + pending.payload.size();
+            has_initial = has_initial || level == Level::kInitial;
+            eliciting_initial = eliciting_initial || (level == Level::kInitial && pending.packet.ack_eliciting);
+            packets.push_back(std::move(pending));
+        }
+        if (packets.empty())
+        {
+            break;
+        }
+
+        // Datagrams with Initial packets are padded so the path proves it carries 1200 bytes
+        if ((m_server ? eliciting_initial : has_initial) && size < quic::kMinInitialDatagram)
+        {
+            packets.back().payload.append(quic::kMinInitialDatagram - size, '\0');
+        }
+        // Header protection samples 16 bytes after a 4-byte packet number offset
+        for (Pending& pending : packets)
+        {
+            if (pending.payload.size() < 4)
+            {
+                pending.payload.append(4 - pending.payload.size(), '\0');
+            }
+        }
+
+        datagram.clear();
+        bool sent_handshake = false;
+        for (Pending& pending : packets)
+        {
+            if (!SealPacket(pending.level, pending.payload, pending.packet, now, datagram))
+            {
+                Terminate("packet protection failed");
+                return datagrams;
+            }
+            sent_handshake = sent_handshake || pending.level == Level::kHandshake;
+        }
+        batch.Add(m_peer, datagram);
+        m_bytes_sent += datagram.size();
+        ++datagrams;
+
+        if (!m_server && sent_handshake)
+        {
+            DiscardSpace(Level::kInitial);
+        }
+        if (m_state == State::kClosing)
+        {
+            m_close_pending = false;
+            break;
+        }
+    }
+    return datagrams;
+}
+
+// -----------------------------------------------------------------------------
+// Timers and closing
+// -----------------------------------------------------------------------------
+
+std::chrono::microseconds QuicConnection::ProbeTimeout() const
+{
+    auto timeout = m_smoothed_rtt + std::max<std::chrono::microseconds>(4 * m_rtt_variance, kGranularity);
+    if (m_handshake_confirmed)
+    {
+        timeout += std::chrono::milliseconds(m_peer_parameters.max_ack_delay);
+    }
+    return timeout * (1u << std::min(m_probe_count, 10u));
+}
+
+TimePoint QuicConnection::ProbeDeadline(Level& level) const
+{
+    TimePoint deadline = TimePoint::max();
+    bool in_flight = false;
+    for (const Level candidate : {Level::kInitial, Level::kHandshake, Level::kApplication})
+    {
+        const Space& space = GetSpace(candidate);
+        if (space.discarded || space.sent.empty())
+        {
+            continue;
+        }
+        in_flight = true;
+        if (candidate == Level::kApplication && !m_handshake_confirmed)
+        {
+            continue;   // Handshake packets are probed first
+        }
+        const TimePoint candidate_deadline = space.last_eliciting_sent + ProbeTimeout();
+        if (candidate_deadline < deadline)
+        {
+            deadline = candidate_deadline;
+            level = candidate;
+        }
+    }
+    if (!in_flight && !m_server && !m_handshake_confirmed)
+    {
+        // The client keeps probing until the handshake is confirmed, or a lost server flight deadlocks it
+        level = GetSpace(Level::kHandshake).write.IsInstalled() ? Level::kHandshake : Level::kInitial;
+        if (GetSpace(level).discarded)
+        {
+            level = Level::kApplication;
+        }
+        deadline = m_last_activity + ProbeTimeout();
+    }
+    return deadline;
+}
+
+bool QuicConnection::IsAmplificationLimited() const
+{
+    return !m_address_validated && 3 * m_bytes_received < m_bytes_sent + quic::kMinInitialDatagram;
+}
+
+TimePoint QuicConnection::NextTimeout() const
+{
+    if (m_state == State::kClosed)
+    {
+        return TimePoint::max();
+    }
+    if (m_state == State::kClosing || m_state == State::kDraining)
+    {
+        return m_close_deadline;
+    }
+
+    auto idle = m_options.idle_timeout;
+    if (m_peer_parameters.max_idle_timeout > 0)
+    {
+        idle = std::min(idle, std::chrono::milliseconds(m_peer_parameters.max_idle_timeout));
+    }
+    TimePoint deadline = m_last_activity + std::max<std::chrono::microseconds>(idle, 3 * ProbeTimeout());
+
+    bool loss_armed = false;
+    for (const Space& space : m_spaces)
+    {
+        if (space.discarded)
+        {
+            continue;
+        }
+        if (space.ack_pending)
+        {
+            deadline = std::min(deadline, space.ack_deadline);
+        }
+        if (space.loss_time != TimePoint::max())
+        {
+            deadline = std::min(deadline, space.loss_time);
+            loss_armed = true;
+        }
+    }
+    if (!loss_armed && !IsAmplificationLimited())
+    {
+        Level level = Level::kInitial;
+        deadline = std::min(deadline, ProbeDeadline(level));
+    }
+    return deadline;
+}
+
+void QuicConnection::OnTimeout(TimePoint now)
+{
+    if (m_state == State::kClosing || m_state == State::kDraining)
+    {
+        if (now >= m_close_deadline)
+        {
+            m_state = State::kClosed;
+        }
+        return;
+    }
+    if (m_state == State::kClosed)
+    {
+        return;
+    }
+
+    auto idle = m_options.idle_timeout;
+    if (m_peer_parameters.max_idle_timeout > 0)
+    {
+        idle = std::min(idle, std::chrono::milliseconds(m_peer_parameters.max_idle_timeout));
+    }
+    if (now >= m_last_activity + std::max<std::chrono::microseconds>(idle, 3 * ProbeTimeout()))
+    {
+        Terminate("idle timeout");
+        return;
+    }
+
+    bool loss_armed = false;
+    for (const Level level : {Level::kInitial, Level::kHandshake, Level::kApplication})
+    {
+        Space& space = GetSpace(level);
+        if (!space.discarded && space.loss_time != TimePoint::max())
+        {
+            loss_armed = true;
+            if (space.loss_time <= now)
+            {
+                DetectLoss(level, now);
+            }
+        }
+    }
+    if (loss_armed || IsAmplificationLimited())
+    {
+        return;
+    }
+
+    Level level = Level::kInitial;
+    if (ProbeDeadline(level) <= now)
+    {
+        // Probe: send the unacknowledged data again (or a PING), outside the congestion window
+        ++m_probe_count;
+        m_probes_pending = 2;
+        m_probe_level = level;
+        Space& space = GetSpace(level);
+        for (const auto& entry : space.sent)
+        {
+            for (const SentFrame& frame : entry.second.frames)
+            {
+                OnFrameLost(frame);
+            }
+        }
+    }
+}
+
+void QuicConnection::Close(uint64_t error, bool application, const std::string& reason)
+{
+    if (m_state == State::kClosing || m_state == State::kDraining || m_state == State::kClosed)
+    {
+        return;
+    }
+    EnterClosing(error, application, reason, true);
+}
+
+void QuicConnection::EnterClosing(uint64_t error, bool application, const std::string& reason, bool send)
+{
+    m_state = State::kClosing;
+    m_close_error = error;
+    m_close_application = application;
+    m_close_reason = reason;
+    m_close_pending = send;
+    m_close_deadline = quic::Clock::now() + 3 * ProbeTimeout();
+}
+
+void QuicConnection::Terminate(const std::string& reason)
+{
+    m_state = State::kClosed;
+    if (m_close_reason.empty())
+    {
+        m_close_reason = reason;
+    }
+}
+
+} // namespace miniserver::network
@@ -0,0 +1,539 @@
+/**
+ * @file quic_connection.hpp
+ * @brief QUIC v1 connection: packet spaces, loss recovery, congestion and flow control, streams (RFC 9000, RFC 9002)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/quic_packet.hpp"
+#include "net/quic_tls.hpp"
+#include "net/udp_socket.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace miniserver::network
+{
+
+namespace quic
+{
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    /**
+     * @brief Transport error codes (RFC 9000 section 20.1)
+     */
+    enum TransportError : uint64_t
+    {
+        kNoError = 0x00,
+        kInternalError = 0x01,
+        kFlowControlError = 0x03,
+        kStreamLimitError = 0x04,
+        kStreamStateError = 0x05,
+        kFinalSizeError = 0x06,
+        kFrameEncodingError = 0x07,
+        kTransportParameterError = 0x08,
+        kProtocolViolation = 0x0a,
+        kApplicationError = 0x0c,
+        kCryptoError = 0x100,
+    };
+
+    /**
+     * @brief Disjoint half-open ranges [start, end) of packet numbers or stream offsets
+     */
+    class RangeSet
+    {
+    public:
+        void Add(uint64_t start, uint64_t end);
+        void Remove(uint64_t start, uint64_t end);
+        bool Contains(uint64_t value) const;
+        bool Empty() const { return m_ranges.empty(); }
+        void Clear() { m_ranges.clear(); }
+
+        /**
+         * @brief Ranges in ascending order (start -> end)
+         */
+        const std::map<uint64_t, uint64_t>& Ranges() const { return m_ranges; }
+
+    private:
+        std::map<uint64_t, uint64_t> m_ranges;  ///< start -> end
+    };
+
+    /**
+     * @brief Outgoing byte stream (CRYPTO or STREAM data) kept until acknowledged
+     */
+    class SendBuffer
+    {
+    public:
+        void Append(std::string_view data) { m_data.append(data); }
+        void Finish() { m_fin = true; }
+
+        /**
+         * @brief Offset after the last byte written
+         */
+        uint64_t End() const { return m_base + (m_data.size() - m_front); }
+
+        /**
+         * @brief Offset after the last byte sent at least once
+         */
+        uint64_t Sent() const { return m_sent; }
+
+        /**
+         * @brief Something to (re)send within the given limit for new data
+         */
+        bool HasPending(uint64_t limit = UINT64_MAX) const;
+
+        /**
+         * @brief Pick the next chunk: lost data first, then new data below limit
+         * @param max_length Largest chunk
+         * @param limit Flow control limit for new data
+         * @param offset Chunk offset
+         * @param data Chunk bytes
+         * @param fin Chunk ends the stream
+         * @return false if nothing is pending
+         */
+        bool Next(size_t max_length, uint64_t limit, uint64_t& offset, std::string_view& data, bool& fin);
+
+        /**
+         * @brief Mark a sent chunk consumed (the bytes stay until acknowledged)
+         */
+        void OnSent(uint64_t offset, size_t length, bool fin);
+        void OnAcked(uint64_t offset, size_t length, bool fin);
+        void OnLost(uint64_t offset, size_t length, bool fin);
+
+        /**
+         * @brief Everything including the FIN is acknowledged
+         */
+        bool IsAcked() const { return m_fin && m_fin_acked && End() == m_base && m_base == m_sent; }
+
+        /**
+         * @brief Drop everything (stream reset)
+         */
+        void Reset();
+
+    private:
+        std::string m_data;             ///< Bytes from m_base on, after m_front dead bytes
+        size_t m_front = 0;             ///< Acknowledged bytes not yet erased from m_data
+        uint64_t m_base = 0;            ///< Offset of m_data[m_front] (everything before is acknowledged)
+        uint64_t m_sent = 0;            ///< Offset after the highest byte sent
+        RangeSet m_acked;               ///< Acknowledged ranges above m_base
+        RangeSet m_lost;                ///< Ranges to send again
+        bool m_fin = false;             ///< Stream ends at End()
+        bool m_fin_sent = false;        ///< FIN sent at least once
+        bool m_fin_acked = false;       ///< FIN acknowledged
+        bool m_fin_lost = false;        ///< FIN must be sent again
+    };
+
+    /**
+     * @brief Incoming byte stream reassembled in order
+     */
+    class ReceiveBuffer
+    {
+    public:
+        /**
+         * @brief Store a chunk
+         * @return false if it contradicts the final size
+         */
+        bool Insert(uint64_t offset, std::string_view data, bool fin);
+
+        /**
+         * @brief Take the contiguous bytes available
+         * @param output Receives the bytes
+         * @return true if the stream just ended (all bytes up to the final size delivered)
+         */
+        bool Read(std::string& output);
+
+        uint64_t Highest() const { return m_highest; }
+        uint64_t Delivered() const { return m_offset; }
+        bool IsFinished() const { return m_final_size != UINT64_MAX && m_offset == m_final_size; }
+
+    private:
+        std::map<uint64_t, std::string> m_segments;    ///< Out-of-order chunks by offset
+        uint64_t m_offset = 0;                          ///< Bytes delivered
+        uint64_t m_highest = 0;                         ///< Highest offset received
+        uint64_t m_final_size = UINT64_MAX;             ///< Known final size
+        bool m_fin_delivered = false;                   ///< End reported to the reader
+    };
+
+    /**
+     * @brief Transport parameters (RFC 9000 section 18)
+     */
+    struct TransportParameters
+    {
+        std::string original_destination_connection_id;    ///< Server only
+        std::string initial_source_connection_id;
+        uint64_t max_idle_timeout = 30000;                  ///< Milliseconds
+        uint64_t max_udp_payload_size = 1472;
+        uint64_t initial_max_data = 0;
+        uint64_t initial_max_stream_data_bidi_local = 0;
+        uint64_t initial_max_stream_data_bidi_remote = 0;
+        uint64_t initial_max_stream_data_uni = 0;
+        uint64_t initial_max_streams_bidi = 0;
+        uint64_t initial_max_streams_uni = 0;
+        uint64_t ack_delay_exponent = 3;
+        uint64_t max_ack_delay = 25;                        ///< Milliseconds
+        uint64_t active_connection_id_limit = 2;
+        bool disable_active_migration = false;
+
+        std::string Encode() const;
+        bool Decode(std::string_view input);
+    };
+}
+
+/**
+ * @brief Limits a connection advertises to its peer
+ */
+struct QuicConnectionOptions
+{
+    std::chrono::milliseconds idle_timeout{30000};  ///< Close after this long without packets
+    uint64_t max_data = 16 * 1024 * 1024;           ///< Connection receive window
+    uint64_t max_stream_data = 1024 * 1024;         ///< Per-stream receive window
+    uint64_t max_streams_bidi = 100;                ///< Concurrent peer-initiated bidirectional streams
+    uint64_t max_streams_uni = 3;                   ///< Peer-initiated unidirectional streams (HTTP/3 needs 3)
+    QuicPeerVerification peer;                      ///< Client: how the server is authenticated
+};
+
+/**
+ * @brief Events a connection reports to the application protocol
+ */
+struct QuicConnectionCallbacks
+{
+    std::function<void()> on_established;                                               ///< Handshake completed
+    std::function<void(uint64_t stream_id, std::string_view data, bool fin)> on_stream_data; ///< In-order stream bytes
+    std::function<void(uint64_t stream_id, uint64_t error)> on_stream_reset;            ///< Peer abandoned a stream
+};
+
+/**
+ * @brief One QUIC connection, driven by a single thread
+ *
+ * The owner feeds received datagrams to Receive(), calls Flush() to collect
+ * datagrams to send, and calls OnTimeout() when NextTimeout() passes. The
+ * connection never touches a socket itself. Loss detection and congestion
+ * control follow RFC 9002 (NewReno, probe timeouts); Initial datagrams are
+ * padded to 1200 bytes and the server honours the 3x amplification limit
+ * until the client's address is validated by a Handshake packet.
+ *
+ * Not supported: Retry, 0-RTT, connection migration, key updates, new
+ * connection IDs. The peer is not offered more than the connection ID it
+ * used during the handshake.
+ */
+class QuicConnection
+{
+public:
+    enum class State
+    {
+        kHandshake,     ///< Keys being negotiated
+        kEstablished,   ///< Handshake complete
+        kClosing,       ///< We sent CONNECTION_CLOSE; waiting before forgetting the connection
+        kDraining,      ///< Peer sent CONNECTION_CLOSE
+        kClosed,        ///< Can be destroyed
+    };
+
+    /**
+     * @brief Server side of a connection started by a client Initial packet
+     * @param credentials Certificate and key
+     * @param options Limits
+     * @param peer Client address
+     * @param original_destination Destination connection ID of the client's first Initial
+     * @param client_source Client's source connection ID
+     */
+    static std::unique_ptr<QuicConnection> Accept(std::shared_ptr<const QuicCredentials> credentials,
+                                                  const QuicConnectionOptions& options, const UdpAddress& peer,
+                                                  std::string_view original_destination, std::string_view client_source);
+
+    /**
+     * @brief Client side; the first Flush() sends the ClientHello
+     * @param options Limits
+     * @param peer Server address
+     */
+    static std::unique_ptr<QuicConnection> Connect(const QuicConnectionOptions& options, const UdpAddress& peer);
+
+    ~QuicConnection();
+
+    QuicConnection(const QuicConnection&) = delete;
+    QuicConnection& operator=(const QuicConnection&) = delete;
+
+    void SetCallbacks(QuicConnectionCallbacks callbacks) { m_callbacks = std::move(callbacks); }
+
+    /**
+     * @brief Process a datagram (possibly several coalesced packets)
+     */
+    void Receive(std::string_view datagram, quic::TimePoint now);
+
+    /**
+     * @brief Append the datagrams that can be sent now to a batch
+     * @return Datagrams added
+     */
+    size_t Flush(quic::TimePoint now, UdpSendBatch& batch);
+
+    /**
+     * @brief Earliest time OnTimeout() must run (TimePoint::max() if none)
+     */
+    quic::TimePoint NextTimeout() const;
+
+    /**
+     * @brief Handle expired timers (loss detection, delayed ACK, idle, closing)
+     */
+    void OnTimeout(quic::TimePoint now);
+
+    /**
+     * @brief Queue stream data
+     * @param stream_id Stream we may send on
+     * @param data Bytes
+     * @param fin End the stream after them
+     * @return false if the stream does not exist or was reset
+     */
+    bool SendStream(uint64_t stream_id, std::string_view data, bool fin);
+
+    /**
+     * @brief Open a stream initiated by this side
+     * @param bidirectional Bidirectional or unidirectional
+     * @return Stream ID, or UINT64_MAX if the peer's stream limit is reached
+     */
+    uint64_t OpenStream(bool bidirectional);
+
+    /**
+     * @brief Abandon sending and receiving on a stream (RESET_STREAM and STOP_SENDING)
+     */
+    void ResetStream(uint64_t stream_id, uint64_t error);
+
+    /**
+     * @brief Close the connection
+     * @param error Error code
+     * @param application Application (HTTP/3) or transport error space
+     * @param reason Reason phrase
+     */
+    void Close(uint64_t error, bool application, const std::string& reason = {});
+
+    State GetState() const { return m_state; }
+    bool IsServer() const { return m_server; }
+    bool IsEstablished() const { return m_state == State::kEstablished; }
+    const UdpAddress& Peer() const { return m_peer; }
+
+    /**
+     * @brief Connection ID chosen by this side (destination of the peer's packets)
+     */
+    const std::string& LocalId() const { return m_local_id; }
+
+    /**
+     * @brief Destination connection ID of the client's first Initial (server)
+     */
+    const std::string& OriginalId() const { return m_original_id; }
+
+    /**
+     * @brief Stream limit the peer gives us right now
+     */
+    uint64_t AvailableStreams(bool bidirectional) const;
+
+    /**
+     * @brief Why the connection closed (error code and reason, for logging)
+     */
+    const std::string& CloseReason() const { return m_close_reason; }
+
+    /**
+     * @brief Smoothed round-trip time
+     */
+    std::chrono::microseconds SmoothedRtt() const { return m_smoothed_rtt; }
+
+private:
+    /**
+     * @brief Frame carried by a sent packet, replayed when the packet is acknowledged or lost
+     */
+    struct SentFrame
+    {
+        enum class Kind : uint8_t
+        {
+            kCrypto,
+            kStream,
+            kMaxData,
+            kMaxStreamData,
+            kMaxStreamsBidi,
+            kMaxStreamsUni,
+            kHandshakeDone,
+            kResetStream,
+            kStopSending,
+        };
+        Kind kind;
+        uint64_t stream_id = 0;
+        uint64_t offset = 0;
+        uint64_t length = 0;
+        bool fin = false;
+    };
+
+    struct SentPacket
+    {
+        quic::TimePoint time;               ///< When sent
+        size_t size = 0;                    ///< Bytes counted in flight
+        bool ack_eliciting = false;
+        std::vector<SentFrame> frames;
+    };
+
+    /**
+     * @brief Packet number space state
+     */
+    struct Space
+    {
+        QuicPacketProtection read;          ///< Keys of received packets
+        QuicPacketProtection write;         ///< Keys of sent packets
+        uint64_t next_packet_number = 0;
+        int64_t largest_received = -1;
+        quic::TimePoint largest_received_time;
+        quic::RangeSet received;            ///< Packet numbers to acknowledge
+        bool ack_pending = false;           ///< An ACK frame should be sent
+        size_t unacked_eliciting = 0;       ///< Ack-eliciting packets since the last ACK sent
+        quic::TimePoint ack_deadline = quic::TimePoint::max();
+        int64_t largest_acked = -1;
+        std::map<uint64_t, SentPacket> sent;
+        quic::TimePoint loss_time = quic::TimePoint::max();
+        quic::TimePoint last_eliciting_sent;
+        quic::SendBuffer crypto_send;
+        quic::ReceiveBuffer crypto_receive;
+        bool discarded = false;
+    };
+
+    struct Stream
+    {
+        quic::SendBuffer send;
+        quic::ReceiveBuffer receive;
+        uint64_t max_send = 0;              ///< Peer's limit for our data
+        uint64_t max_receive = 0;           ///< Our advertised limit
+        bool send_max_receive = false;      ///< MAX_STREAM_DATA update pending
+        bool local_send = true;             ///< We may send (false: peer's unidirectional stream)
+        bool local_receive = true;          ///< We may receive (false: our unidirectional stream)
+        bool reset_sent = false;            ///< RESET_STREAM queued or sent
+        bool send_reset = false;            ///< RESET_STREAM pending
+        bool reset_in_flight = false;       ///< RESET_STREAM sent, not yet acknowledged
+        bool send_stop = false;             ///< STOP_SENDING pending
+        uint64_t reset_error = 0;
+        bool receive_done = false;          ///< All data delivered or reset
+    };
+
+    QuicConnection(bool server, const QuicConnectionOptions& options, const UdpAddress& peer);
+
+    quic::TransportParameters LocalParameters() const;
+
+    /**
+     * @brief Process one decrypted packet
+     * @return false if the connection was closed by a protocol error
+     */
+    bool ProcessFrames(quic::Level level, std::string_view payload, quic::TimePoint now, bool& ack_eliciting);
+    bool OnAckFrame(quic::Level level, std::string_view& payload, bool ecn, quic::TimePoint now);
+    bool OnStreamFrame(uint64_t stream_id, uint64_t offset, std::string_view data, bool fin);
+    bool OnCryptoData(quic::Level level);
+    void OnHandshakeComplete();
+    bool ApplyPeerParameters();
+
+    /**
+     * @brief Stream by ID, creating peer-initiated streams on first use
+     * @param error Set to a transport error for an invalid stream
+     */
+    Stream* GetStream(uint64_t stream_id, bool from_peer, uint64_t& error);
+    bool IsLocalStream(uint64_t stream_id) const { return ((stream_id & 1) != 0) == m_server; }
+    void MaybeRetireStream(uint64_t stream_id);
+
+    void InstallKeys();
+    void DiscardSpace(quic::Level level);
+
+    /**
+     * @brief Build the payload of one packet at a level
+     * @param budget Largest payload
+     * @param allow_eliciting Congestion window (or a probe) allows more than an ACK
+     */
+    std::string BuildPayload(quic::Level level, size_t budget, bool allow_eliciting, quic::TimePoint now, SentPacket& packet);
+    void AppendAckFrame(quic::Level level, std::string& payload, quic::TimePoint now);
+
+    /**
+     * @brief Header, packet number, protection; records the packet
+     */
+    bool SealPacket(quic::Level level, std::string& payload, SentPacket& packet, quic::TimePoint now, std::string& datagram);
+
+    void OnPacketsAcked(quic::Level level, const std::vector<uint64_t>& numbers, quic::TimePoint now);
+    void OnFrameAcked(const SentFrame& frame);
+    void OnFrameLost(const SentFrame& frame);
+    void DetectLoss(quic::Level level, quic::TimePoint now);
+    void OnCongestionEvent(quic::TimePoint sent_time, quic::TimePoint now);
+    quic::TimePoint ProbeDeadline(quic::Level& level) const;
+
+    /**
+     * @brief Server may not send another full datagram before the client's address is validated
+     */
+    bool IsAmplificationLimited() const;
+    std::chrono::microseconds ProbeTimeout() const;
+    void EnterClosing(uint64_t error, bool application, const std::string& reason, bool send);
+    void Terminate(const std::string& reason);
+
+    Space& GetSpace(quic::Level level) { return m_spaces[static_cast<size_t>(level)]; }
+    const Space& GetSpace(quic::Level level) const { return m_spaces[static_cast<size_t>(level)]; }
+
+    bool m_server;                                          ///< Role
+    QuicConnectionOptions m_options;                        ///< Local limits
+    UdpAddress m_peer;                                      ///< Peer address
+    QuicConnectionCallbacks m_callbacks;                    ///< Application events
+    std::unique_ptr<QuicTls> m_tls;                         ///< Handshake
+    State m_state = State::kHandshake;                      ///< Connection state
+    std::string m_local_id;                                 ///< Our connection ID
+    std::string m_peer_id;                                  ///< Peer's connection ID (destination of our packets)
+    std::string m_original_id;                              ///< Client's first destination connection ID
+    bool m_peer_id_confirmed = false;                       ///< Client: switched to the server's connection ID
+    std::array<Space, quic::kLevels> m_spaces;              ///< Packet number spaces
+    std::string m_packet;                                   ///< Receive scratch buffer
+    std::string m_stream_scratch;                           ///< Delivered stream bytes scratch buffer
+
+    // Peer parameters and flow control
+    quic::TransportParameters m_peer_parameters;            ///< Received transport parameters
+    uint64_t m_max_send_data = 0;                           ///< Peer's connection limit for our data
+    uint64_t m_sent_data = 0;                               ///< New stream bytes sent
+    uint64_t m_max_receive_data = 0;                        ///< Our advertised connection limit
+    uint64_t m_received_data = 0;                           ///< Sum of highest offsets received
+    uint64_t m_delivered_data = 0;                          ///< Bytes delivered to the application
+    bool m_send_max_data = false;                           ///< MAX_DATA update pending
+    std::map<uint64_t, Stream> m_streams;                   ///< Open streams by ID
+    std::array<uint64_t, 2> m_next_local_stream{};          ///< Next local stream index [bidi, uni]
+    std::array<uint64_t, 2> m_max_local_streams{};          ///< Peer's stream limits [bidi, uni]
+    std::array<uint64_t, 2> m_max_peer_streams{};           ///< Our stream limits [bidi, uni]
+    std::array<uint64_t, 2> m_peer_streams_opened{};        ///< Highest peer stream index + 1 [bidi, uni]
+    std::array<bool, 2> m_send_max_streams{};               ///< MAX_STREAMS update pending [bidi, uni]
+    uint64_t m_next_stream_round = 0;                       ///< Round-robin position over streams
+
+    // Recovery and congestion control
+    std::chrono::microseconds m_smoothed_rtt{333000};
+    std::chrono::microseconds m_rtt_variance{166500};
+    std::chrono::microseconds m_min_rtt{0};
+    std::chrono::microseconds m_latest_rtt{0};
+    bool m_rtt_sampled = false;
+    uint64_t m_congestion_window = 10 * 1200;
+    uint64_t m_slow_start_threshold = UINT64_MAX;
+    uint64_t m_bytes_in_flight = 0;
+    quic::TimePoint m_recovery_start;
+    unsigned m_probe_count = 0;                             ///< Consecutive probe timeouts
+    unsigned m_probes_pending = 0;                          ///< Probe packets to send regardless of the window
+    quic::Level m_probe_level = quic::Level::kInitial;      ///< Space the probes are for
+
+    // Anti-amplification (server)
+    bool m_address_validated = false;
+    uint64_t m_bytes_received = 0;
+    uint64_t m_bytes_sent = 0;
+
+    // Lifecycle
+    bool m_handshake_done_pending = false;                  ///< Server: HANDSHAKE_DONE to send
+    bool m_handshake_confirmed = false;
+    quic::TimePoint m_last_activity;                        ///< Idle timer base
+    quic::TimePoint m_close_deadline = quic::TimePoint::max();
+    uint64_t m_close_error = 0;
+    bool m_close_application = false;
+    std::string m_close_reason;
+    bool m_close_pending = false;                           ///< CONNECTION_CLOSE to (re)send
+    std::vector<std::string> m_path_responses;              ///< PATH_RESPONSE data to send
+};
+
+} // namespace miniserver::network
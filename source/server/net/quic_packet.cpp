@@ -0,0 +1,469 @@
+/**
+ * @file quic_packet.cpp
+ * @brief QUIC wire format and packet protection implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/quic_packet.hpp"
+
+#include <cstring>
+
+#if defined(MINISERVER_HAS_HTTP3)
+    #include <openssl/evp.h>
+    #include <openssl/hmac.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace quic
+{
+
+namespace
+{
+    /**
+     * @brief Initial salt of QUIC version 1 (RFC 9001 section 5.2)
+     */
+    constexpr unsigned char kInitialSalt[] = {
+        0x38, 0x76, 0x2c, 0xf7, 0xf5, 0x59, 0x34, 0xb3, 0x4d, 0x17,
+        0x9a, 0xe6, 0xa4, 0xc8, 0x0c, 0xad, 0xcc, 0xbb, 0x7f, 0x0a,
+    };
+} // namespace
+
+size_t VarintLength(uint64_t value)
+{
+    if (value < 64)
+    {
+        return 1;
+    }
+    if (value < 16384)
+    {
+        return 2;
+    }
+    if (value < 1073741824)
+    {
+        return 4;
+    }
+    return 8;
+}
+
+void AppendVarint(std::string& output, uint64_t value)
+{
+    const size_t length = VarintLength(value);
+    static constexpr unsigned char kPrefix[] = {0, 0, 0x40, 0, 0x80, 0, 0, 0, 0xc0};
+    for (size_t i = 0; i < length; ++i)
+    {
+        auto byte = static_cast<unsigned char>(value >> (8 * (length - 1 - i)));
+        if (i == 0)
+        {
+            byte |= kPrefix[length];
+        }
+        output.push_back(static_cast<char>(byte));
+    }
+}
+
+bool ReadVarint(std::string_view& input, uint64_t& value)
+{
+    if (input.empty())
+    {
+        return false;
+    }
+    const auto first = static_cast<unsigned char>(input[0]);
+    const size_t length = size_t(1) << (first >> 6);
+    if (input.size() < length)
+    {
+        return false;
+    }
+    value = first & 0x3f;
+    for (size_t i = 1; i < length; ++i)
+    {
+        value = (value << 8) | static_cast<unsigned char>(input[i]);
+    }
+    input.remove_prefix(length);
+    return true;
+}
+
+bool ReadBytes(std::string_view& input, size_t length, std::string_view& bytes)
+{
+    if (input.size() < length)
+    {
+        return false;
+    }
+    bytes = input.substr(0, length);
+    input.remove_prefix(length);
+    return true;
+}
+
+uint64_t DecodePacketNumber(int64_t largest, uint64_t truncated, size_t bits)
+{
+    const uint64_t expected = static_cast<uint64_t>(largest + 1);
+    const uint64_t window = uint64_t(1) << bits;
+    const uint64_t half = window / 2;
+    const uint64_t mask = window - 1;
+    const uint64_t candidate = (expected & ~mask) | truncated;
+    if (candidate + half <= expected && candidate < (uint64_t(1) << 62) - window)
+    {
+        return candidate + window;
+    }
+    if (candidate > expected + half && candidate >= window)
+    {
+        return candidate - window;
+    }
+    return candidate;
+}
+
+bool ParseHeader(std::string_view datagram, size_t short_id_length, PacketHeader& header)
+{
+    header = PacketHeader{};
+    std::string_view input = datagram;
+    if (input.empty())
+    {
+        return false;
+    }
+    const auto first = static_cast<unsigned char>(input[0]);
+    input.remove_prefix(1);
+
+    if ((first & 0x80) == 0)
+    {
+        header.type = PacketType::kOneRtt;
+        if (!ReadBytes(input, short_id_length, header.destination))
+        {
+            return false;
+        }
+        header.packet_number_offset = 1 + short_id_length;
+        header.packet_length = datagram.size();
+        return true;
+    }
+
+    std::string_view bytes;
+    if (!ReadBytes(input, 4, bytes))
+    {
+        return false;
+    }
+    header.version = (uint32_t(static_cast<unsigned char>(bytes[0])) << 24) | (uint32_t(static_cast<unsigned char>(bytes[1])) << 16)
+                   | (uint32_t(static_cast<unsigned char>(bytes[2])) << 8) | uint32_t(static_cast<unsigned char>(bytes[3]));
+
+    for (std::string_view* id : {&header.destination, &header.source})
+    {
+        if (!ReadBytes(input, 1, bytes) || !ReadBytes(input, static_cast<unsigned char>(bytes[0]), *id))
+        {
+            return false;
+        }
+    }
+
+    if (header.version == 0)
+    {
+        header.type = PacketType::kVersionNegotiation;
+        header.packet_length = datagram.size();
+        return true;
+    }
+    if (header.version != kVersion1)
+    {
+        // Only the invariant fields are meaningful; the caller answers with Version Negotiation
+        header.packet_length = datagram.size();
+        return true;
+    }
+    if (header.destination.size() > kMaxConnectionIdLength || header.source.size() > kMaxConnectionIdLength)
+    {
+        return false;
+    }
+
+    static constexpr PacketType kLongTypes[] = {PacketType::kInitial, PacketType::kZeroRtt, PacketType::kHandshake, PacketType::kRetry};
+    header.type = kLongTypes[(first >> 4) & 0x03];
+    if (header.type == PacketType::kRetry)
+    {
+        header.packet_length = datagram.size();
+        return true;
+    }
+
+    uint64_t value = 0;
+    if (header.type == PacketType::kInitial)
+    {
+        if (!ReadVarint(input, value) || !ReadBytes(input, value, header.token))
+        {
+            return false;
+        }
+    }
+    if (!ReadVarint(input, value) || value > input.size())
+    {
+        return false;
+    }
+    header.packet_number_offset = datagram.size() - input.size();
+    header.packet_length = header.packet_number_offset + value;
+    return true;
+}
+
+std::string BuildVersionNegotiation(std::string_view destination, std::string_view source)
+{
+    std::string packet;
+    packet.push_back(static_cast<char>(0xc0));
+    packet.append(4, '\0');
+    packet.push_back(static_cast<char>(destination.size()));
+    packet.append(destination);
+    packet.push_back(static_cast<char>(source.size()));
+    packet.append(source);
+    packet.append("\x00\x00\x00\x01", 4);
+    // A reserved version (0x?a?a?a?a) keeps clients from relying on the list being exact
+    packet.append("\x1a\x2a\x3a\x4a", 4);
+    return packet;
+}
+
+#if defined(MINISERVER_HAS_HTTP3)
+
+std::string HkdfExtract(std::string_view salt, std::string_view key_material)
+{
+    unsigned char output[32];
+    unsigned int length = sizeof(output);
+    static constexpr unsigned char kZero[32] = {};
+    const void* key = salt.empty() ? static_cast<const void*>(kZero) : static_cast<const void*>(salt.data());
+    HMAC(EVP_sha256(), key, static_cast<int>(salt.empty() ? sizeof(kZero) : salt.size()),
+         reinterpret_cast<const unsigned char*>(key_material.data()), key_material.size(), output, &length);
+    return std::string(reinterpret_cast<char*>(output), length);
+}
+
+std::string HkdfExpandLabel(std::string_view secret, std::string_view label, std::string_view context, size_t length)
+{
+    std::string info;
+    info.push_back(static_cast<char>(length >> 8));
+    info.push_back(static_cast<char>(length));
+    info.push_back(static_cast<char>(6 + label.size()));
+    info.append("tls13 ");
+    info.append(label);
+    info.push_back(static_cast<char>(context.size()));
+    info.append(context);
+
+    // HKDF-Expand: T(i) = HMAC(secret, T(i-1) | info | i)
+    std::string output;
+    std::string block;
+    for (unsigned char counter = 1; output.size() < length; ++counter)
+    {
+        std::string input = block;
+        input.append(info);
+        input.push_back(static_cast<char>(counter));
+        unsigned char digest[32];
+        unsigned int digest_length = sizeof(digest);
+        HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+             reinterpret_cast<const unsigned char*>(input.data()), input.size(), digest, &digest_length);
+        block.assign(reinterpret_cast<char*>(digest), digest_length);
+        output.append(block);
+    }
+    output.resize(length);
+    return output;
+}
+
+void DeriveInitialSecrets(std::string_view connection_id, std::string& client, std::string& server)
+{
+    const std::string initial = HkdfExtract(std::string_view(reinterpret_cast<const char*>(kInitialSalt), sizeof(kInitialSalt)),
+                                            connection_id);
+    client = HkdfExpandLabel(initial, "client in", {}, 32);
+    server = HkdfExpandLabel(initial, "server in", {}, 32);
+}
+
+#else
+
+std::string HkdfExtract(std::string_view, std::string_view)
+{
+    return {};
+}
+
+std::string HkdfExpandLabel(std::string_view, std::string_view, std::string_view, size_t)
+{
+    return {};
+}
+
+void DeriveInitialSecrets(std::string_view, std::string& client, std::string& server)
+{
+    client.clear();
+    server.clear();
+}
+
+#endif
+
+} // namespace quic
+
+QuicPacketProtection::~QuicPacketProtection()
+{
+    Discard();
+}
+
+#if defined(MINISERVER_HAS_HTTP3)
+
+bool QuicPacketProtection::Install(std::string_view secret)
+{
+    Discard();
+    const std::string key = quic::HkdfExpandLabel(secret, "quic key", {}, m_key.size());
+    const std::string iv = quic::HkdfExpandLabel(secret, "quic iv", {}, m_iv.size());
+    const std::string header_key = quic::HkdfExpandLabel(secret, "quic hp", {}, m_header_key.size());
+    std::memcpy(m_key.data(), key.data(), m_key.size());
+    std::memcpy(m_iv.data(), iv.data(), m_iv.size());
+    std::memcpy(m_header_key.data(), header_key.data(), m_header_key.size());
+
+    m_aead = EVP_CIPHER_CTX_new();
+    m_header = EVP_CIPHER_CTX_new();
+    if (m_aead == nullptr || m_header == nullptr
+        || EVP_EncryptInit_ex(m_aead, EVP_aes_128_gcm(), nullptr, nullptr, nullptr) != 1
+        || EVP_CIPHER_CTX_ctrl(m_aead, EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(m_iv.size()), nullptr) != 1
+        || EVP_EncryptInit_ex(m_aead, nullptr, nullptr, m_key.data(), nullptr) != 1
+        || EVP_EncryptInit_ex(m_header, EVP_aes_128_ecb(), nullptr, m_header_key.data(), nullptr) != 1)
+    {
+        Discard();
+        return false;
+    }
+    EVP_CIPHER_CTX_set_padding(m_header, 0);
+    return true;
+}
+
+void QuicPacketProtection::Discard()
+{
+    EVP_CIPHER_CTX_free(m_aead);
+    EVP_CIPHER_CTX_free(m_header);
+    m_aead = nullptr;
+    m_header = nullptr;
+}
+
+bool QuicPacketProtection::Mask(const std::string& packet, size_t packet_number_offset, unsigned char mask[5])
+{
+    const size_t sample = packet_number_offset + 4;
+    if (packet.size() < sample + 16)
+    {
+        return false;
+    }
+    unsigned char block[32];
+    int length = 0;
+    if (EVP_EncryptUpdate(m_header, block, &length, reinterpret_cast<const unsigned char*>(packet.data()) + sample, 16) != 1)
+    {
+        return false;
+    }
+    std::memcpy(mask, block, 5);
+    return true;
+}
+
+bool QuicPacketProtection::Seal(std::string& packet, size_t packet_number_offset, uint64_t packet_number)
+{
+    if (m_aead == nullptr)
+    {
+        return false;
+    }
+    unsigned char nonce[12];
+    std::memcpy(nonce, m_iv.data(), sizeof(nonce));
+    for (size_t i = 0; i < 8; ++i)
+    {
+        nonce[11 - i] ^= static_cast<unsigned char>(packet_number >> (8 * i));
+    }
+
+    const size_t header_length = packet_number_offset + quic::kPacketNumberLength;
+    const size_t payload_length = packet.size() - header_length;
+    packet.resize(packet.size() + quic::kTagLength);
+    auto* bytes = reinterpret_cast<unsigned char*>(packet.data());
+
+    int length = 0;
+    if (EVP_EncryptInit_ex(m_aead, nullptr, nullptr, nullptr, nonce) != 1
+        || EVP_EncryptUpdate(m_aead, nullptr, &length, bytes, static_cast<int>(header_length)) != 1
+        || EVP_EncryptUpdate(m_aead, bytes + header_length, &length, bytes + header_length, static_cast<int>(payload_length)) != 1
+        || EVP_EncryptFinal_ex(m_aead, bytes + header_length + length, &length) != 1
+        || EVP_CIPHER_CTX_ctrl(m_aead, EVP_CTRL_GCM_GET_TAG, quic::kTagLength, bytes + header_length + payload_length) != 1)
+    {
+        return false;
+    }
+
+    unsigned char mask[5];
+    if (!Mask(packet, packet_number_offset, mask))
+    {
+        return false;
+    }
+    bytes[0] ^= mask[0] & ((bytes[0] & 0x80) != 0 ? 0x0f : 0x1f);
+    for (size_t i = 0; i < quic::kPacketNumberLength; ++i)
+    {
+        bytes[packet_number_offset + i] ^= mask[1 + i];
+    }
+    return true;
+}
+
+bool QuicPacketProtection::Open(std::string& packet, size_t packet_number_offset, int64_t largest, uint64_t& packet_number,
+                                size_t& payload_offset)
+{
+    unsigned char mask[5];
+    if (m_aead == nullptr || !Mask(packet, packet_number_offset, mask))
+    {
+        return false;
+    }
+
+    auto* bytes = reinterpret_cast<unsigned char*>(packet.data());
+    const unsigned char first = bytes[0] ^ (mask[0] & ((bytes[0] & 0x80) != 0 ? 0x0f : 0x1f));
+    const size_t number_length = (first & 0x03) + 1;
+    uint64_t truncated = 0;
+    for (size_t i = 0; i < number_length; ++i)
+    {
+        truncated = (truncated << 8) | static_cast<unsigned char>(bytes[packet_number_offset + i] ^ mask[1 + i]);
+    }
+    const size_t header_length = packet_number_offset + number_length;
+    if (packet.size() < header_length + quic::kTagLength)
+    {
+        return false;
+    }
+    packet_number = quic::DecodePacketNumber(largest, truncated, number_length * 8);
+
+    // The unprotected header is the associated data; it replaces the protected one once the packet authenticates
+    std::string header(packet, 0, header_length);
+    header[0] = static_cast<char>(first);
+    for (size_t i = 0; i < number_length; ++i)
+    {
+        header[packet_number_offset + i] = static_cast<char>(bytes[packet_number_offset + i] ^ mask[1 + i]);
+    }
+
+    unsigned char nonce[12];
+    std::memcpy(nonce, m_iv.data(), sizeof(nonce));
+    for (size_t i = 0; i < 8; ++i)
+    {
+        nonce[11 - i] ^= static_cast<unsigned char>(packet_number >> (8 * i));
+    }
+
+    const size_t ciphertext_length = packet.size() - header_length - quic::kTagLength;
+    unsigned char* ciphertext = bytes + header_length;
+    int length = 0;
+    if (EVP_DecryptInit_ex(m_aead, nullptr, nullptr, nullptr, nonce) != 1
+        || EVP_DecryptUpdate(m_aead, nullptr, &length, reinterpret_cast<const unsigned char*>(header.data()),
+                             static_cast<int>(header.size())) != 1
+        || EVP_DecryptUpdate(m_aead, ciphertext, &length, ciphertext, static_cast<int>(ciphertext_length)) != 1
+        || EVP_CIPHER_CTX_ctrl(m_aead, EVP_CTRL_GCM_SET_TAG, quic::kTagLength, ciphertext + ciphertext_length) != 1
+        || EVP_DecryptFinal_ex(m_aead, ciphertext + length, &length) != 1)
+    {
+        return false;
+    }
+
+    std::memcpy(packet.data(), header.data(), header.size());
+    packet.resize(header_length + ciphertext_length);
+    payload_offset = header_length;
+    return true;
+}
+
+#else
+
+bool QuicPacketProtection::Install(std::string_view)
+{
+    return false;
+}
+
+void QuicPacketProtection::Discard()
+{
+}
+
+bool QuicPacketProtection::Mask(const std::string&, size_t, unsigned char*)
+{
+    return false;
+}
+
+bool QuicPacketProtection::Seal(std::string&, size_t, uint64_t)
+{
+    return false;
+}
+
+bool QuicPacketProtection::Open(std::string&, size_t, int64_t, uint64_t&, size_t&)
+{
+    return false;
+}
+
+#endif
+
+} // namespace miniserver::network
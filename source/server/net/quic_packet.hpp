@@ -0,0 +1,213 @@
+/**
+ * @file quic_packet.hpp
+ * @brief QUIC v1 wire format: variable-length integers, packet headers and packet protection (RFC 9000, RFC 9001)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
+namespace miniserver::network
+{
+
+namespace quic
+{
+    constexpr uint32_t kVersion1 = 0x00000001;      ///< The only version spoken
+    constexpr size_t kConnectionIdLength = 8;       ///< Length of the connection IDs this side issues
+    constexpr size_t kMaxConnectionIdLength = 20;   ///< Longest connection ID in a v1 long header
+    constexpr size_t kMinInitialDatagram = 1200;    ///< Client Initial datagrams are padded to at least this
+    constexpr size_t kMaxDatagram = 1232;           ///< Largest datagram sent (fits an IPv6 minimum MTU path)
+    constexpr size_t kPacketNumberLength = 4;       ///< Packet numbers are always sent in 4 bytes
+    constexpr size_t kTagLength = 16;               ///< AEAD tag (AES-128-GCM)
+    constexpr uint64_t kMaxVarint = (uint64_t(1) << 62) - 1;
+
+    /**
+     * @brief Packet number spaces, which are also the TLS encryption levels (0-RTT is not supported)
+     */
+    enum class Level
+    {
+        kInitial = 0,
+        kHandshake = 1,
+        kApplication = 2,
+    };
+    constexpr size_t kLevels = 3;
+
+    /**
+     * @brief Packet types
+     */
+    enum class PacketType
+    {
+        kInitial,
+        kZeroRtt,
+        kHandshake,
+        kRetry,
+        kOneRtt,
+        kVersionNegotiation,
+    };
+
+    /**
+     * @brief Bytes needed to encode a value as a varint (1, 2, 4 or 8)
+     */
+    size_t VarintLength(uint64_t value);
+
+    /**
+     * @brief Append a varint
+     * @param output Buffer
+     * @param value Value (at most kMaxVarint)
+     */
+    void AppendVarint(std::string& output, uint64_t value);
+
+    /**
+     * @brief Read a varint and advance past it
+     * @param input Remaining bytes (advanced on success)
+     * @param value Decoded value
+     * @return false if input is too short
+     */
+    bool ReadVarint(std::string_view& input, uint64_t& value);
+
+    /**
+     * @brief Read a number of bytes and advance past them
+     * @return false if input is too short
+     */
+    bool ReadBytes(std::string_view& input, size_t length, std::string_view& bytes);
+
+    /**
+     * @brief Recover a full packet number from its truncated encoding (RFC 9000 appendix A.3)
+     * @param largest Largest packet number received so far in the space (or -1)
+     * @param truncated Received bits
+     * @param bits Number of received bits
+     */
+    uint64_t DecodePacketNumber(int64_t largest, uint64_t truncated, size_t bits);
+
+    /**
+     * @brief Header fields of a packet, before header protection is removed
+     */
+    struct PacketHeader
+    {
+        PacketType type = PacketType::kOneRtt;
+        uint32_t version = 0;               ///< Long headers only
+        std::string_view destination;       ///< Destination connection ID
+        std::string_view source;            ///< Source connection ID (long headers)
+        std::string_view token;             ///< Initial packets
+        size_t packet_number_offset = 0;    ///< Start of the protected packet number
+        size_t packet_length = 0;           ///< Bytes of this packet in the datagram (later packets may follow)
+    };
+
+    /**
+     * @brief Parse the unprotected part of the first packet in a datagram
+     * @param datagram Bytes from this packet on
+     * @param short_id_length Destination connection ID length of short-header packets
+     * @param header Parsed fields
+     * @return false if the header is malformed
+     */
+    bool ParseHeader(std::string_view datagram, size_t short_id_length, PacketHeader& header);
+
+    /**
+     * @brief Build a Version Negotiation packet offering version 1
+     * @param destination Client's source connection ID
+     * @param source Client's destination connection ID
+     */
+    std::string BuildVersionNegotiation(std::string_view destination, std::string_view source);
+
+    /**
+     * @brief HKDF-Extract with SHA-256
+     */
+    std::string HkdfExtract(std::string_view salt, std::string_view key_material);
+
+    /**
+     * @brief HKDF-Expand-Label with SHA-256 (RFC 8446 section 7.1, "tls13 " prefix)
+     * @param secret Pseudorandom key
+     * @param label Label without the prefix
+     * @param context Hash value or empty
+     * @param length Output bytes
+     */
+    std::string HkdfExpandLabel(std::string_view secret, std::string_view label, std::string_view context, size_t length);
+
+    /**
+     * @brief Initial secrets derived from the client's first destination connection ID
+     * @param connection_id Destination connection ID of the client's first Initial packet
+     * @param client Client Initial secret
+     * @param server Server Initial secret
+     */
+    void DeriveInitialSecrets(std::string_view connection_id, std::string& client, std::string& server);
+}
+
+/**
+ * @brief Packet protection keys of one direction at one encryption level (AES-128-GCM)
+ *
+ * Seal and Open work in place on a packet buffer. The cipher contexts are
+ * set up once when the keys are installed, so protecting a packet costs no
+ * allocation. Not thread-safe; a connection is used by one thread.
+ */
+class QuicPacketProtection
+{
+public:
+    QuicPacketProtection() = default;
+    ~QuicPacketProtection();
+
+    QuicPacketProtection(const QuicPacketProtection&) = delete;
+    QuicPacketProtection& operator=(const QuicPacketProtection&) = delete;
+
+    /**
+     * @brief Derive key, IV and header protection key from a traffic secret
+     * @param secret TLS traffic secret (32 bytes)
+     * @return false if the cipher contexts cannot be created
+     */
+    bool Install(std::string_view secret);
+
+    /**
+     * @brief Forget the keys (the level was discarded)
+     */
+    void Discard();
+
+    bool IsInstalled() const { return m_aead != nullptr; }
+
+    /**
+     * @brief Encrypt the payload and apply header protection
+     * @param packet Header (packet number written in kPacketNumberLength bytes) followed by the payload; the tag is appended
+     * @param packet_number_offset Start of the packet number
+     * @param packet_number Full packet number (forms the nonce)
+     * @return false on a cipher failure
+     */
+    bool Seal(std::string& packet, size_t packet_number_offset, uint64_t packet_number);
+
+    /**
+     * @brief Remove header protection and decrypt
+     * @param packet One packet; on success it is truncated to header + plaintext payload
+     * @param packet_number_offset Start of the packet number
+     * @param largest Largest packet number received in the space (or -1)
+     * @param packet_number Decoded packet number
+     * @param payload_offset Start of the plaintext payload
+     * @return false if the packet does not authenticate
+     */
+    bool Open(std::string& packet, size_t packet_number_offset, int64_t largest, uint64_t& packet_number, size_t& payload_offset);
+
+    /**
+     * @brief Derived values, exposed for checking against the RFC 9001 test vectors
+     */
+    const std::array<unsigned char, 16>& Key() const { return m_key; }
+    const std::array<unsigned char, 12>& Iv() const { return m_iv; }
+    const std::array<unsigned char, 16>& HeaderKey() const { return m_header_key; }
+
+private:
+    /**
+     * @brief Header protection mask from the sample at packet_number_offset + 4
+     */
+    bool Mask(const std::string& packet, size_t packet_number_offset, unsigned char mask[5]);
+
+    std::array<unsigned char, 16> m_key{};          ///< AEAD key
+    std::array<unsigned char, 12> m_iv{};           ///< AEAD IV (XORed with the packet number)
+    std::array<unsigned char, 16> m_header_key{};   ///< Header protection key
+    EVP_CIPHER_CTX* m_aead = nullptr;               ///< AES-128-GCM context keyed with m_key
+    EVP_CIPHER_CTX* m_header = nullptr;             ///< AES-128-ECB context keyed with m_header_key
+};
+
+} // namespace miniserver::network
@@ -0,0 +1,1107 @@
+/**
+ * @file quic_tls.cpp
+ * @brief TLS 1.3 handshake implementation for QUIC
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/quic_tls.hpp"
+
+#include <algorithm>
+
+#if defined(MINISERVER_HAS_HTTP3)
+    #include <openssl/evp.h>
+    #include <openssl/hmac.h>
+    #include <openssl/pem.h>
+    #include <openssl/rand.h>
+    #include <openssl/rsa.h>
+    #include <openssl/x509.h>
+    #include <openssl/x509_vfy.h>
+    #include <openssl/x509v3.h>
+#endif
+
+namespace miniserver::network
+{
+
+#if defined(MINISERVER_HAS_HTTP3)
+
+namespace
+{
+    // Handshake message types (RFC 8446 section 4)
+    constexpr uint8_t kClientHello = 1;
+    constexpr uint8_t kServerHello = 2;
+    constexpr uint8_t kNewSessionTicket = 4;
+    constexpr uint8_t kEncryptedExtensions = 8;
+    constexpr uint8_t kCertificate = 11;
+    constexpr uint8_t kCertificateVerify = 15;
+    constexpr uint8_t kFinished = 20;
+
+    // Extensions
+    constexpr uint16_t kServerName = 0;
+    constexpr uint16_t kSupportedGroups = 10;
+    constexpr uint16_t kSignatureAlgorithms = 13;
+    constexpr uint16_t kAlpn = 16;
+    constexpr uint16_t kSupportedVersions = 43;
+    constexpr uint16_t kKeyShare = 51;
+    constexpr uint16_t kQuicTransportParameters = 0x39;
+
+    constexpr uint16_t kTls13 = 0x0304;
+    constexpr uint16_t kAes128GcmSha256 = 0x1301;
+    constexpr uint16_t kX25519 = 0x001d;
+    constexpr size_t kX25519KeyLength = 32;
+    constexpr size_t kHashLength = 32;
+    constexpr size_t kMaxMessage = 65536;       ///< Longest handshake message accepted
+
+    // Alerts
+    constexpr uint8_t kUnexpectedMessage = 10;
+    constexpr uint8_t kHandshakeFailure = 40;
+    constexpr uint8_t kBadCertificate = 42;
+    constexpr uint8_t kUnsupportedCertificate = 43;
+    constexpr uint8_t kCertificateExpired = 45;
+    constexpr uint8_t kCertificateUnknown = 46;
+    constexpr uint8_t kIllegalParameter = 47;
+    constexpr uint8_t kUnknownCa = 48;
+    constexpr uint8_t kDecodeError = 50;
+    constexpr uint8_t kDecryptError = 51;
+    constexpr uint8_t kProtocolVersion = 70;
+    constexpr uint8_t kInternalError = 80;
+    constexpr uint8_t kMissingExtension = 109;
+    constexpr uint8_t kNoApplicationProtocol = 120;
+
+    constexpr std::string_view kH3 = "h3";
+
+    /**
+     * @brief Big-endian reader over a handshake message
+     */
+    struct Reader
+    {
+        std::string_view data;
+
+        bool Number(size_t bytes, uint32_t& value)
+        {
+            if (data.size() < bytes)
+            {
+                return false;
+            }
+            value = 0;
+            for (size_t i = 0; i < bytes; ++i)
+            {
+                value = (value << 8) | static_cast<unsigned char>(data[i]);
+            }
+            data.remove_prefix(bytes);
+            return true;
+        }
+
+        bool Bytes(size_t length, std::string_view& bytes)
+        {
+            return quic::ReadBytes(data, length, bytes);
+        }
+
+        /**
+         * @brief Length-prefixed vector
+         */
+        bool Vector(size_t length_bytes, std::string_view& bytes)
+        {
+            uint32_t length = 0;
+            return Number(length_bytes, length) && Bytes(length, bytes);
+        }
+    };
+
+    void AppendNumber(std::string& output, size_t bytes, uint32_t value)
+    {
+        for (size_t i = bytes; i > 0; --i)
+        {
+            output.push_back(static_cast<char>(value >> (8 * (i - 1))));
+        }
+    }
+
+    void AppendVector(std::string& output, size_t length_bytes, std::string_view bytes)
+    {
+        AppendNumber(output, length_bytes, static_cast<uint32_t>(bytes.size()));
+        output.append(bytes);
+    }
+
+    void AppendExtension(std::string& output, uint16_t type, std::string_view body)
+    {
+        AppendNumber(output, 2, type);
+        AppendVector(output, 2, body);
+    }
+
+    /**
+     * @brief Check whether a vector of 16-bit values contains one
+     */
+    bool ContainsU16(std::string_view list, uint16_t wanted)
+    {
+        Reader reader{list};
+        uint32_t value = 0;
+        while (reader.Number(2, value))
+        {
+            if (value == wanted)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string Sha256(std::string_view data)
+    {
+        unsigned char digest[kHashLength];
+        EVP_Digest(data.data(), data.size(), digest, nullptr, EVP_sha256(), nullptr);
+        return std::string(reinterpret_cast<char*>(digest), sizeof(digest));
+    }
+
+    std::string Hmac(std::string_view key, std::string_view data)
+    {
+        unsigned char digest[kHashLength];
+        unsigned int length = sizeof(digest);
+        HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), reinterpret_cast<const unsigned char*>(data.data()),
+             data.size(), digest, &length);
+        return std::string(reinterpret_cast<char*>(digest), length);
+    }
+
+    /**
+     * @brief Fresh X25519 key pair, or nullptr
+     */
+    EVP_PKEY* GenerateKeyShare()
+    {
+        EVP_PKEY* key = nullptr;
+        EVP_PKEY_CTX* context = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, nullptr);
+        if (context != nullptr && EVP_PKEY_keygen_init(context) == 1)
+        {
+            EVP_PKEY_keygen(context, &key);
+        }
+        EVP_PKEY_CTX_free(context);
+        return key;
+    }
+
+    std::string Random(size_t length)
+    {
+        std::string bytes(length, '\0');
+        RAND_bytes(reinterpret_cast<unsigned char*>(bytes.data()), static_cast<int>(length));
+        return bytes;
+    }
+
+    /**
+     * @brief Signed content of the server CertificateVerify (RFC 8446 section 4.4.3)
+     */
+    std::string CertificateVerifyContent(const std::string& transcript_hash)
+    {
+        std::string content(64, ' ');
+        content.append("TLS 1.3, server CertificateVerify");
+        content.push_back('\0');
+        content.append(transcript_hash);
+        return content;
+    }
+
+    /**
+     * @brief Check whether a key can produce signatures of a scheme we offer
+     */
+    bool SchemeMatchesKey(uint16_t scheme, EVP_PKEY* key)
+    {
+        switch (scheme)
+        {
+            case 0x0403: return EVP_PKEY_id(key) == EVP_PKEY_EC && EVP_PKEY_bits(key) == 256;
+            case 0x0804: return EVP_PKEY_id(key) == EVP_PKEY_RSA;
+            case 0x0807: return EVP_PKEY_id(key) == EVP_PKEY_ED25519;
+            default: return false;
+        }
+    }
+
+    /**
+     * @brief Verify a server CertificateVerify signature
+     */
+    bool Verify(EVP_PKEY* key, uint16_t scheme, const std::string& transcript_hash, std::string_view signature)
+    {
+        const std::string content = CertificateVerifyContent(transcript_hash);
+        EVP_MD_CTX* context = EVP_MD_CTX_new();
+        EVP_PKEY_CTX* key_context = nullptr;
+        const EVP_MD* digest = scheme == 0x0807 ? nullptr : EVP_sha256();
+        bool ok = context != nullptr && EVP_DigestVerifyInit(context, &key_context, digest, nullptr, key) == 1;
+        if (ok && scheme == 0x0804)
+        {
+            ok = EVP_PKEY_CTX_set_rsa_padding(key_context, RSA_PKCS1_PSS_PADDING) == 1
+                && EVP_PKEY_CTX_set_rsa_pss_saltlen(key_context, RSA_PSS_SALTLEN_DIGEST) == 1;
+        }
+        ok = ok && EVP_DigestVerify(context, reinterpret_cast<const unsigned char*>(signature.data()), signature.size(),
+                                    reinterpret_cast<const unsigned char*>(content.data()), content.size()) == 1;
+        EVP_MD_CTX_free(context);
+        return ok;
+    }
+
+    /**
+     * @brief TLS alert for a failed chain verification
+     */
+    uint8_t CertificateAlert(int error)
+    {
+        switch (error)
+        {
+            case X509_V_ERR_CERT_HAS_EXPIRED:
+            case X509_V_ERR_CERT_NOT_YET_VALID:
+                return kCertificateExpired;
+            case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT:
+            case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY:
+            case X509_V_ERR_DEPTH_ZERO_SELF_SIGNED_CERT:
+            case X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN:
+                return kUnknownCa;
+            case X509_V_ERR_HOSTNAME_MISMATCH:
+            case X509_V_ERR_IP_ADDRESS_MISMATCH:
+                return kCertificateUnknown;
+            default:
+                return kBadCertificate;
+        }
+    }
+
+    /**
+     * @brief Check whether a server name is an IPv4 or IPv6 literal (no SNI, matched against IP SANs)
+     */
+    bool IsIpLiteral(const std::string& name)
+    {
+        ASN1_OCTET_STRING* address = a2i_IPADDRESS(name.c_str());
+        ASN1_OCTET_STRING_free(address);
+        return address != nullptr;
+    }
+
+    /**
+     * @brief Sign the CertificateVerify content (RFC 8446 section 4.4.3)
+     */
+    bool Sign(EVP_PKEY* key, uint16_t scheme, const std::string& transcript_hash, std::string& signature)
+    {
+        const std::string content = CertificateVerifyContent(transcript_hash);
+
+        EVP_MD_CTX* context = EVP_MD_CTX_new();
+        EVP_PKEY_CTX* key_context = nullptr;
+        const EVP_MD* digest = scheme == 0x0807 ? nullptr : EVP_sha256();
+        size_t length = 0;
+        bool ok = context != nullptr && EVP_DigestSignInit(context, &key_context, digest, nullptr, key) == 1;
+        if (ok && scheme == 0x0804)
+        {
+            ok = EVP_PKEY_CTX_set_rsa_padding(key_context, RSA_PKCS1_PSS_PADDING) == 1
+                && EVP_PKEY_CTX_set_rsa_pss_saltlen(key_context, RSA_PSS_SALTLEN_DIGEST) == 1;
+        }
+        ok = ok
+            && EVP_DigestSign(context, nullptr, &length, reinterpret_cast<const unsigned char*>(content.data()), content.size()) == 1;
+        if (ok)
+        {
+            signature.resize(length);
+            ok = EVP_DigestSign(context, reinterpret_cast<unsigned char*>(signature.data()), &length,
+                                reinterpret_cast<const unsigned char*>(content.data()), content.size()) == 1;
+            signature.resize(length);
+        }
+        EVP_MD_CTX_free(context);
+        return ok;
+    }
+} // namespace
+
+std::shared_ptr<QuicCredentials> QuicCredentials::Load(const std::string& certificate_file, const std::string& key_file,
+                                                       std::string& error)
+{
+    std::shared_ptr<QuicCredentials> credentials(new QuicCredentials());
+
+    BIO* input = BIO_new_file(certificate_file.c_str(), "r");
+    if (input == nullptr)
+    {
+        error = "cannot open " + certificate_file;
+        return nullptr;
+    }
+    X509* leaf = nullptr;
+    while (X509* certificate = PEM_read_bio_X509(input, nullptr, nullptr, nullptr))
+    {
+        unsigned char* der = nullptr;
+        const int length = i2d_X509(certificate, &der);
+        if (length > 0)
+        {
+            credentials->m_chain.emplace_back(reinterpret_cast<char*>(der), static_cast<size_t>(length));
+            OPENSSL_free(der);
+        }
+        if (leaf == nullptr)
+        {
+            leaf = certificate;
+        }
+        else
+        {
+            X509_free(certificate);
+        }
+    }
+    BIO_free(input);
+    if (leaf == nullptr)
+    {
+        error = "no certificate in " + certificate_file;
+        return nullptr;
+    }
+
+    input = BIO_new_file(key_file.c_str(), "r");
+    credentials->m_key = input != nullptr ? PEM_read_bio_PrivateKey(input, nullptr, nullptr, nullptr) : nullptr;
+    BIO_free(input);
+    const bool matches = credentials->m_key != nullptr && X509_check_private_key(leaf, credentials->m_key) == 1;
+    X509_free(leaf);
+    if (credentials->m_key == nullptr)
+    {
+        error = "cannot read a private key from " + key_file;
+        return nullptr;
+    }
+    if (!matches)
+    {
+        error = "private key does not match the certificate";
+        return nullptr;
+    }
+
+    switch (EVP_PKEY_id(credentials->m_key))
+    {
+        case EVP_PKEY_EC:
+            if (EVP_PKEY_bits(credentials->m_key) != 256)
+            {
+                error = "only P-256 ECDSA keys are supported";
+                return nullptr;
+            }
+            credentials->m_scheme = 0x0403;     // ecdsa_secp256r1_sha256
+            break;
+        case EVP_PKEY_RSA:
+            credentials->m_scheme = 0x0804;     // rsa_pss_rsae_sha256
+            break;
+        case EVP_PKEY_ED25519:
+            credentials->m_scheme = 0x0807;     // ed25519
+            break;
+        default:
+            error = "unsupported key type";
+            return nullptr;
+    }
+    return credentials;
+}
+
+QuicCredentials::~QuicCredentials()
+{
+    EVP_PKEY_free(m_key);
+}
+
+QuicTls::QuicTls(Role role, std::shared_ptr<const QuicCredentials> credentials, std::string transport_parameters)
+    : m_role(role)
+    , m_credentials(std::move(credentials))
+    , m_local_parameters(std::move(transport_parameters))
+    , m_state(role == Role::kServer ? State::kWaitClientHello : State::kStart)
+{
+}
+
+QuicTls::~QuicTls()
+{
+    EVP_PKEY_free(m_key_share);
+    EVP_PKEY_free(m_peer_key);
+}
+
+bool QuicTls::Fail(uint8_t alert, const std::string& error)
+{
+    m_state = State::kFailed;
+    m_alert = alert;
+    m_error = error;
+    return false;
+}
+
+std::string QuicTls::TakeOutput(quic::Level level)
+{
+    std::string output;
+    output.swap(m_output[static_cast<size_t>(level)]);
+    return output;
+}
+
+std::string QuicTls::TranscriptHash() const
+{
+    return Sha256(m_transcript);
+}
+
+void QuicTls::WriteMessage(quic::Level level, uint8_t type, const std::string& body)
+{
+    std::string message;
+    message.push_back(static_cast<char>(type));
+    AppendVector(message, 3, body);
+    m_transcript.append(message);
+    m_output[static_cast<size_t>(level)].append(message);
+}
+
+std::string QuicTls::KeyShareEntry() const
+{
+    unsigned char key[kX25519KeyLength];
+    size_t length = sizeof(key);
+    EVP_PKEY_get_raw_public_key(m_key_share, key, &length);
+    std::string entry;
+    AppendNumber(entry, 2, kX25519);
+    AppendVector(entry, 2, std::string_view(reinterpret_cast<char*>(key), length));
+    return entry;
+}
+
+std::string QuicTls::SharedSecret(std::string_view peer_public_key) const
+{
+    std::string secret;
+    EVP_PKEY* peer = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr,
+                                                 reinterpret_cast<const unsigned char*>(peer_public_key.data()),
+                                                 peer_public_key.size());
+    EVP_PKEY_CTX* context = peer != nullptr ? EVP_PKEY_CTX_new(m_key_share, nullptr) : nullptr;
+    size_t length = 0;
+    if (context != nullptr && EVP_PKEY_derive_init(context) == 1 && EVP_PKEY_derive_set_peer(context, peer) == 1
+        && EVP_PKEY_derive(context, nullptr, &length) == 1)
+    {
+        secret.resize(length);
+        if (EVP_PKEY_derive(context, reinterpret_cast<unsigned char*>(secret.data()), &length) != 1)
+        {
+            secret.clear();
+        }
+    }
+    EVP_PKEY_CTX_free(context);
+    EVP_PKEY_free(peer);
+    return secret;
+}
+
+void QuicTls::DeriveHandshakeSecrets(const std::string& shared_secret)
+{
+    const std::string zeros(kHashLength, '\0');
+    const std::string empty_hash = Sha256({});
+    const std::string early = quic::HkdfExtract({}, zeros);
+    const std::string derived = quic::HkdfExpandLabel(early, "derived", empty_hash, kHashLength);
+    m_handshake_secret = quic::HkdfExtract(derived, shared_secret);
+
+    const std::string hash = TranscriptHash();
+    m_client_handshake_secret = quic::HkdfExpandLabel(m_handshake_secret, "c hs traffic", hash, kHashLength);
+    m_server_handshake_secret = quic::HkdfExpandLabel(m_handshake_secret, "s hs traffic", hash, kHashLength);
+
+    const auto level = static_cast<size_t>(quic::Level::kHandshake);
+    const bool server = m_role == Role::kServer;
+    m_read_secret[level] = server ? m_client_handshake_secret : m_server_handshake_secret;
+    m_write_secret[level] = server ? m_server_handshake_secret : m_client_handshake_secret;
+}
+
+void QuicTls::DeriveApplicationSecrets()
+{
+    const std::string zeros(kHashLength, '\0');
+    const std::string derived = quic::HkdfExpandLabel(m_handshake_secret, "derived", Sha256({}), kHashLength);
+    const std::string master = quic::HkdfExtract(derived, zeros);
+
+    const std::string hash = TranscriptHash();
+    const std::string client = quic::HkdfExpandLabel(master, "c ap traffic", hash, kHashLength);
+    const std::string server = quic::HkdfExpandLabel(master, "s ap traffic", hash, kHashLength);
+
+    const auto level = static_cast<size_t>(quic::Level::kApplication);
+    if (m_role == Role::kServer)
+    {
+        // 1-RTT packets from the client are only accepted after its Finished
+        m_write_secret[level] = server;
+        m_client_application_secret = client;
+    }
+    else
+    {
+        m_read_secret[level] = server;
+        m_write_secret[level] = client;
+    }
+}
+
+std::string QuicTls::FinishedData(const std::string& base_secret) const
+{
+    const std::string key = quic::HkdfExpandLabel(base_secret, "finished", {}, kHashLength);
+    return Hmac(key, TranscriptHash());
+}
+
+bool QuicTls::Start()
+{
+    if (m_role != Role::kClient || m_state != State::kStart)
+    {
+        return false;
+    }
+    if (m_verification.verify && m_verification.server_name.empty())
+    {
+        return Fail(kInternalError, "no server name to verify the certificate against");
+    }
+    m_key_share = GenerateKeyShare();
+    if (m_key_share == nullptr)
+    {
+        return Fail(kInternalError, "key generation failed");
+    }
+
+    std::string extensions;
+    std::string list;
+    std::string body;
+    if (!m_verification.server_name.empty() && !IsIpLiteral(m_verification.server_name))
+    {
+        std::string name;
+        name.push_back('\0');                       // host_name
+        AppendVector(name, 2, m_verification.server_name);
+        AppendVector(body, 2, name);
+        AppendExtension(extensions, kServerName, body);
+        body.clear();
+    }
+    AppendNumber(list, 2, kX25519);
+    AppendVector(body, 2, list);
+    AppendExtension(extensions, kSupportedGroups, body);
+    list.clear();
+    body.clear();
+    for (const uint16_t scheme : {0x0403, 0x0804, 0x0807})
+    {
+        AppendNumber(list, 2, scheme);
+    }
+    AppendVector(body, 2, list);
+    AppendExtension(extensions, kSignatureAlgorithms, body);
+    AppendExtension(extensions, kSupportedVersions, std::string("\x02\x03\x04", 3));
+    body.clear();
+    AppendVector(body, 2, KeyShareEntry());
+    AppendExtension(extensions, kKeyShare, body);
+    body.clear();
+    std::string protocols;
+    AppendVector(protocols, 1, kH3);
+    AppendVector(body, 2, protocols);
+    AppendExtension(extensions, kAlpn, body);
+    AppendExtension(extensions, kQuicTransportParameters, m_local_parameters);
+
+    std::string hello;
+    AppendNumber(hello, 2, 0x0303);
+    hello.append(Random(32));
+    hello.push_back('\0');                          // legacy_session_id: empty in QUIC
+    AppendVector(hello, 2, std::string("\x13\x01", 2));
+    AppendVector(hello, 1, std::string(1, '\0'));   // null compression
+    AppendVector(hello, 2, extensions);
+    WriteMessage(quic::Level::kInitial, kClientHello, hello);
+    m_state = State::kWaitServerHello;
+    return true;
+}
+
+bool QuicTls::Receive(quic::Level level, std::string_view data)
+{
+    if (m_state == State::kFailed)
+    {
+        return false;
+    }
+    std::string& input = m_input[static_cast<size_t>(level)];
+    input.append(data);
+
+    size_t offset = 0;
+    while (input.size() - offset >= 4)
+    {
+        const auto type = static_cast<uint8_t>(input[offset]);
+        const size_t length = (size_t(static_cast<unsigned char>(input[offset + 1])) << 16)
+                            | (size_t(static_cast<unsigned char>(input[offset + 2])) << 8)
+                            | size_t(static_cast<unsigned char>(input[offset + 3]));
+        if (length > kMaxMessage)
+        {
+            return Fail(kDecodeError, "handshake message too long");
+        }
+        if (input.size() - offset < 4 + length)
+        {
+            break;
+        }
+        const std::string_view message(input.data() + offset, 4 + length);
+        if (!HandleMessage(level, type, message.substr(4), message))
+        {
+            return false;
+        }
+        offset += 4 + length;
+    }
+    input.erase(0, offset);
+    return true;
+}
+
+bool QuicTls::HandleMessage(quic::Level level, uint8_t type, std::string_view body, std::string_view message)
+{
+    const bool initial = level == quic::Level::kInitial;
+    const bool handshake = level == quic::Level::kHandshake;
+    switch (m_state)
+    {
+        case State::kWaitClientHello:
+            if (initial && type == kClientHello)
+            {
+                return HandleClientHello(body, message);
+            }
+            break;
+        case State::kWaitServerHello:
+            if (initial && type == kServerHello)
+            {
+                return HandleServerHello(body, message);
+            }
+            break;
+        case State::kWaitEncryptedExtensions:
+            if (handshake && type == kEncryptedExtensions)
+            {
+                return HandleEncryptedExtensions(body, message);
+            }
+            break;
+        case State::kWaitCertificate:
+            if (handshake && type == kCertificate)
+            {
+                return HandleCertificate(body, message);
+            }
+            break;
+        case State::kWaitCertificateVerify:
+            if (handshake && type == kCertificateVerify)
+            {
+                return HandleCertificateVerify(body, message);
+            }
+            break;
+        case State::kWaitFinished:
+            if (handshake && type == kFinished)
+            {
+                return HandleFinished(body, message);
+            }
+            break;
+        case State::kComplete:
+            if (m_role == Role::kClient && level == quic::Level::kApplication && type == kNewSessionTicket)
+            {
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+    return Fail(kUnexpectedMessage, "unexpected handshake message " + std::to_string(type));
+}
+
+bool QuicTls::HandleClientHello(std::string_view body, std::string_view message)
+{
+    Reader reader{body};
+    uint32_t version = 0;
+    std::string_view random;
+    std::string_view session_id;
+    std::string_view cipher_suites;
+    std::string_view compression;
+    std::string_view extensions;
+    if (!reader.Number(2, version) || !reader.Bytes(32, random) || !reader.Vector(1, session_id)
+        || !reader.Vector(2, cipher_suites) || !reader.Vector(1, compression) || !reader.Vector(2, extensions))
+    {
+        return Fail(kDecodeError, "malformed ClientHello");
+    }
+
+    bool tls13 = false;
+    bool has_alpn = false;
+    bool has_parameters = false;
+    bool has_scheme = false;
+    std::string_view peer_key;
+    Reader list{extensions};
+    while (!list.data.empty())
+    {
+        uint32_t type = 0;
+        std::string_view data;
+        if (!list.Number(2, type) || !list.Vector(2, data))
+        {
+            return Fail(kDecodeError, "malformed extensions");
+        }
+        Reader extension{data};
+        std::string_view items;
+        switch (type)
+        {
+            case kSupportedVersions:
+                tls13 = extension.Vector(1, items) && ContainsU16(items, kTls13);
+                break;
+            case kSignatureAlgorithms:
+                has_scheme = extension.Vector(2, items) && ContainsU16(items, m_credentials->Scheme());
+                break;
+            case kKeyShare:
+                if (extension.Vector(2, items))
+                {
+                    Reader shares{items};
+                    uint32_t group = 0;
+                    std::string_view key;
+                    while (shares.Number(2, group) && shares.Vector(2, key))
+                    {
+                        if (group == kX25519 && key.size() == kX25519KeyLength)
+                        {
+                            peer_key = key;
+                        }
+                    }
+                }
+                break;
+            case kAlpn:
+                if (extension.Vector(2, items))
+                {
+                    Reader protocols{items};
+                    std::string_view protocol;
+                    while (protocols.Vector(1, protocol))
+                    {
+                        has_alpn = has_alpn || protocol == kH3;
+                    }
+                }
+                break;
+            case kQuicTransportParameters:
+                m_peer_parameters.assign(data);
+                has_parameters = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (!tls13)
+    {
+        return Fail(kProtocolVersion, "client does not offer TLS 1.3");
+    }
+    if (!ContainsU16(cipher_suites, kAes128GcmSha256))
+    {
+        return Fail(kHandshakeFailure, "client does not offer TLS_AES_128_GCM_SHA256");
+    }
+    if (peer_key.empty())
+    {
+        return Fail(kHandshakeFailure, "client sent no X25519 key share");
+    }
+    if (!has_scheme)
+    {
+        return Fail(kHandshakeFailure, "client does not accept the certificate's signature scheme");
+    }
+    if (!has_alpn)
+    {
+        return Fail(kNoApplicationProtocol, "client does not offer h3");
+    }
+    if (!has_parameters)
+    {
+        return Fail(kMissingExtension, "no quic_transport_parameters");
+    }
+
+    m_key_share = GenerateKeyShare();
+    const std::string shared = m_key_share != nullptr ? SharedSecret(peer_key) : std::string();
+    if (shared.empty())
+    {
+        return Fail(kIllegalParameter, "key exchange failed");
+    }
+    m_transcript.append(message);
+
+    // ServerHello
+    std::string hello;
+    AppendNumber(hello, 2, 0x0303);
+    hello.append(Random(32));
+    AppendVector(hello, 1, session_id);
+    AppendNumber(hello, 2, kAes128GcmSha256);
+    hello.push_back('\0');
+    std::string hello_extensions;
+    AppendExtension(hello_extensions, kSupportedVersions, std::string("\x03\x04", 2));
+    AppendExtension(hello_extensions, kKeyShare, KeyShareEntry());
+    AppendVector(hello, 2, hello_extensions);
+    WriteMessage(quic::Level::kInitial, kServerHello, hello);
+    DeriveHandshakeSecrets(shared);
+
+    // EncryptedExtensions, Certificate, CertificateVerify, Finished
+    std::string encrypted;
+    std::string protocols;
+    std::string alpn;
+    AppendVector(protocols, 1, kH3);
+    AppendVector(alpn, 2, protocols);
+    AppendExtension(encrypted, kAlpn, alpn);
+    AppendExtension(encrypted, kQuicTransportParameters, m_local_parameters);
+    std::string encrypted_extensions;
+    AppendVector(encrypted_extensions, 2, encrypted);
+    WriteMessage(quic::Level::kHandshake, kEncryptedExtensions, encrypted_extensions);
+
+    std::string entries;
+    for (const std::string& certificate : m_credentials->Chain())
+    {
+        AppendVector(entries, 3, certificate);
+        AppendNumber(entries, 2, 0);
+    }
+    std::string certificate;
+    certificate.push_back('\0');                    // certificate_request_context
+    AppendVector(certificate, 3, entries);
+    WriteMessage(quic::Level::kHandshake, kCertificate, certificate);
+
+    std::string signature;
+    if (!Sign(m_credentials->Key(), m_credentials->Scheme(), TranscriptHash(), signature))
+    {
+        return Fail(kInternalError, "signing failed");
+    }
+    std::string verify;
+    AppendNumber(verify, 2, m_credentials->Scheme());
+    AppendVector(verify, 2, signature);
+    WriteMessage(quic::Level::kHandshake, kCertificateVerify, verify);
+
+    WriteMessage(quic::Level::kHandshake, kFinished, FinishedData(m_server_handshake_secret));
+    DeriveApplicationSecrets();
+    m_state = State::kWaitFinished;
+    return true;
+}
+
+bool QuicTls::HandleServerHello(std::string_view body, std::string_view message)
+{
+    Reader reader{body};
+    uint32_t version = 0;
+    uint32_t cipher = 0;
+    uint32_t compression = 0;
+    std::string_view random;
+    std::string_view session_id;
+    std::string_view extensions;
+    if (!reader.Number(2, version) || !reader.Bytes(32, random) || !reader.Vector(1, session_id)
+        || !reader.Number(2, cipher) || !reader.Number(1, compression) || !reader.Vector(2, extensions))
+    {
+        return Fail(kDecodeError, "malformed ServerHello");
+    }
+    if (cipher != kAes128GcmSha256)
+    {
+        return Fail(kIllegalParameter, "server chose an unsupported cipher suite");
+    }
+
+    uint32_t selected_version = 0;
+    std::string_view peer_key;
+    Reader list{extensions};
+    while (!list.data.empty())
+    {
+        uint32_t type = 0;
+        std::string_view data;
+        if (!list.Number(2, type) || !list.Vector(2, data))
+        {
+            return Fail(kDecodeError, "malformed extensions");
+        }
+        Reader extension{data};
+        uint32_t group = 0;
+        if (type == kSupportedVersions)
+        {
+            extension.Number(2, selected_version);
+        }
+        else if (type == kKeyShare && extension.Number(2, group) && group == kX25519)
+        {
+            extension.Vector(2, peer_key);
+        }
+    }
+    if (selected_version != kTls13)
+    {
+        return Fail(kProtocolVersion, "server did not select TLS 1.3");
+    }
+
+    const std::string shared = peer_key.size() == kX25519KeyLength ? SharedSecret(peer_key) : std::string();
+    if (shared.empty())
+    {
+        return Fail(kIllegalParameter, "key exchange failed");
+    }
+    m_transcript.append(message);
+    DeriveHandshakeSecrets(shared);
+    m_state = State::kWaitEncryptedExtensions;
+    return true;
+}
+
+bool QuicTls::HandleEncryptedExtensions(std::string_view body, std::string_view message)
+{
+    Reader reader{body};
+    std::string_view extensions;
+    if (!reader.Vector(2, extensions))
+    {
+        return Fail(kDecodeError, "malformed EncryptedExtensions");
+    }
+    bool has_alpn = false;
+    bool has_parameters = false;
+    Reader list{extensions};
+    while (!list.data.empty())
+    {
+        uint32_t type = 0;
+        std::string_view data;
+        if (!list.Number(2, type) || !list.Vector(2, data))
+        {
+            return Fail(kDecodeError, "malformed extensions");
+        }
+        if (type == kAlpn)
+        {
+            Reader extension{data};
+            std::string_view protocols;
+            std::string_view protocol;
+            has_alpn = extension.Vector(2, protocols) && Reader{protocols}.Vector(1, protocol) && protocol == kH3;
+        }
+        else if (type == kQuicTransportParameters)
+        {
+            m_peer_parameters.assign(data);
+            has_parameters = true;
+        }
+    }
+    if (!has_alpn)
+    {
+        return Fail(kNoApplicationProtocol, "server did not select h3");
+    }
+    if (!has_parameters)
+    {
+        return Fail(kMissingExtension, "no quic_transport_parameters");
+    }
+    m_transcript.append(message);
+    m_state = State::kWaitCertificate;
+    return true;
+}
+
+bool QuicTls::HandleCertificate(std::string_view body, std::string_view message)
+{
+    Reader reader{body};
+    std::string_view context;
+    std::string_view entries;
+    if (!reader.Vector(1, context) || !reader.Vector(3, entries) || !reader.data.empty())
+    {
+        return Fail(kDecodeError, "malformed Certificate");
+    }
+    if (!context.empty())
+    {
+        return Fail(kIllegalParameter, "Certificate has a request context");
+    }
+
+    // Leaf first, then whatever intermediates the server sends
+    X509* leaf = nullptr;
+    STACK_OF(X509)* intermediates = sk_X509_new_null();
+    Reader list{entries};
+    bool decoded = intermediates != nullptr;
+    while (decoded && !list.data.empty())
+    {
+        std::string_view der;
+        std::string_view extensions;
+        if (!list.Vector(3, der) || !list.Vector(2, extensions))
+        {
+            decoded = false;
+            break;
+        }
+        const auto* data = reinterpret_cast<const unsigned char*>(der.data());
+        X509* certificate = d2i_X509(nullptr, &data, static_cast<long>(der.size()));
+        if (certificate == nullptr || data != reinterpret_cast<const unsigned char*>(der.data() + der.size()))
+        {
+            X509_free(certificate);
+            decoded = false;
+        }
+        else if (leaf == nullptr)
+        {
+            leaf = certificate;
+        }
+        else
+        {
+            sk_X509_push(intermediates, certificate);
+        }
+    }
+
+    const auto release = [&]()
+    {
+        X509_free(leaf);
+        sk_X509_pop_free(intermediates, X509_free);
+    };
+    if (!decoded)
+    {
+        release();
+        return Fail(kBadCertificate, "malformed certificate in Certificate");
+    }
+    if (leaf == nullptr)
+    {
+        release();
+        return Fail(kDecodeError, "server sent no certificate");
+    }
+
+    if (m_verification.verify)
+    {
+        X509_STORE* store = X509_STORE_new();
+        X509_STORE_CTX* store_context = X509_STORE_CTX_new();
+        bool ready = store != nullptr && store_context != nullptr;
+        if (ready)
+        {
+            ready = m_verification.ca_file.empty() ? X509_STORE_set_default_paths(store) == 1
+                                                   : X509_STORE_load_file(store, m_verification.ca_file.c_str()) == 1;
+        }
+        ready = ready && X509_STORE_CTX_init(store_context, store, leaf, intermediates) == 1;
+        if (ready)
+        {
+            X509_VERIFY_PARAM* parameters = X509_STORE_CTX_get0_param(store_context);
+            X509_VERIFY_PARAM_set_purpose(parameters, X509_PURPOSE_SSL_SERVER);
+            ready = IsIpLiteral(m_verification.server_name)
+                ? X509_VERIFY_PARAM_set1_ip_asc(parameters, m_verification.server_name.c_str()) == 1
+                : X509_VERIFY_PARAM_set1_host(parameters, m_verification.server_name.c_str(), 0) == 1;
+        }
+        const bool verified = ready && X509_verify_cert(store_context) == 1;
+        const int error = store_context != nullptr ? X509_STORE_CTX_get_error(store_context) : X509_V_ERR_UNSPECIFIED;
+        X509_STORE_CTX_free(store_context);
+        X509_STORE_free(store);
+        if (!ready)
+        {
+            release();
+            return Fail(kInternalError, "cannot load trust anchors" +
+                        (m_verification.ca_file.empty() ? std::string() : " from " + m_verification.ca_file));
+        }
+        if (!verified)
+        {
+            release();
+            return Fail(CertificateAlert(error), std::string("certificate verification failed: ") +
+                        X509_verify_cert_error_string(error));
+        }
+    }
+
+    m_peer_key = X509_get_pubkey(leaf);
+    release();
+    if (m_peer_key == nullptr)
+    {
+        return Fail(kUnsupportedCertificate, "cannot read the certificate's public key");
+    }
+    m_transcript.append(message);
+    m_state = State::kWaitCertificateVerify;
+    return true;
+}
+
+bool QuicTls::HandleCertificateVerify(std::string_view body, std::string_view message)
+{
+    Reader reader{body};
+    uint32_t scheme = 0;
+    std::string_view signature;
+    if (!reader.Number(2, scheme) || !reader.Vector(2, signature) || !reader.data.empty())
+    {
+        return Fail(kDecodeError, "malformed CertificateVerify");
+    }
+    if (!SchemeMatchesKey(static_cast<uint16_t>(scheme), m_peer_key))
+    {
+        return Fail(kIllegalParameter, "CertificateVerify scheme does not match the certificate");
+    }
+    // The signature covers the transcript through the Certificate message
+    if (!Verify(m_peer_key, static_cast<uint16_t>(scheme), TranscriptHash(), signature))
+    {
+        return Fail(kDecryptError, "CertificateVerify does not verify");
+    }
+    m_transcript.append(message);
+    m_state = State::kWaitFinished;
+    return true;
+}
+
+bool QuicTls::HandleFinished(std::string_view body, std::string_view message)
+{
+    const bool server = m_role == Role::kServer;
+    const std::string expected = FinishedData(server ? m_client_handshake_secret : m_server_handshake_secret);
+    if (body.size() != expected.size() || CRYPTO_memcmp(body.data(), expected.data(), expected.size()) != 0)
+    {
+        return Fail(kDecryptError, "Finished does not verify");
+    }
+    m_transcript.append(message);
+
+    const auto application = static_cast<size_t>(quic::Level::kApplication);
+    if (server)
+    {
+        m_read_secret[application] = m_client_application_secret;
+    }
+    else
+    {
+        // Application secrets cover the transcript through the server Finished, before ours
+        DeriveApplicationSecrets();
+        WriteMessage(quic::Level::kHandshake, kFinished, FinishedData(m_client_handshake_secret));
+    }
+    m_state = State::kComplete;
+    return true;
+}
+
+#else
+
+std::shared_ptr<QuicCredentials> QuicCredentials::Load(const std::string&, const std::string&, std::string& error)
+{
+    error = "built without MINISERVER_EXPERIMENTAL_HTTP3 (or without OpenSSL)";
+    return nullptr;
+}
+
+QuicCredentials::~QuicCredentials() = default;
+
+QuicTls::QuicTls(Role role, std::shared_ptr<const QuicCredentials> credentials, std::string transport_parameters)
+    : m_role(role)
+    , m_credentials(std::move(credentials))
+    , m_local_parameters(std::move(transport_parameters))
+{
+}
+
+QuicTls::~QuicTls() = default;
+
+bool QuicTls::Start()
+{
+    return false;
+}
+
+bool QuicTls::Receive(quic::Level, std::string_view)
+{
+    return false;
+}
+
+std::string QuicTls::TakeOutput(quic::Level)
+{
+    return {};
+}
+
+#endif
+
+} // namespace miniserver::network
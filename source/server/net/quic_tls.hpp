@@ -0,0 +1,231 @@
+/**
+ * @file quic_tls.hpp
+ * @brief TLS 1.3 handshake carried in QUIC CRYPTO frames (RFC 9001)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/quic_packet.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+typedef struct evp_pkey_st EVP_PKEY;
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Server certificate chain and signing key, loaded once and shared by all connections
+ */
+class QuicCredentials
+{
+public:
+    /**
+     * @brief Load a PEM certificate chain and private key
+     * @param certificate_file Chain, leaf first
+     * @param key_file Private key (ECDSA P-256, RSA or Ed25519)
+     * @param error Reason on failure
+     * @return Credentials, or nullptr
+     */
+    static std::shared_ptr<QuicCredentials> Load(const std::string& certificate_file, const std::string& key_file,
+                                                 std::string& error);
+
+    ~QuicCredentials();
+
+    QuicCredentials(const QuicCredentials&) = delete;
+    QuicCredentials& operator=(const QuicCredentials&) = delete;
+
+    const std::vector<std::string>& Chain() const { return m_chain; }
+    EVP_PKEY* Key() const { return m_key; }
+    uint16_t Scheme() const { return m_scheme; }
+
+private:
+    QuicCredentials() = default;
+
+    std::vector<std::string> m_chain;   ///< DER certificates, leaf first
+    EVP_PKEY* m_key = nullptr;          ///< Signing key
+    uint16_t m_scheme = 0;              ///< TLS SignatureScheme used for CertificateVerify
+};
+
+/**
+ * @brief How the client role authenticates the server
+ *
+ * The CertificateVerify signature is always checked against the leaf's key;
+ * `verify` additionally requires a chain to a trust anchor that covers
+ * `server_name`.
+ */
+struct QuicPeerVerification
+{
+    bool verify = true;             ///< Check the chain and the name (false: key possession only, like curl -k)
+    std::string server_name;        ///< DNS name or IP literal the certificate must cover (DNS names are sent as SNI)
+    std::string ca_file;            ///< PEM trust anchors (empty: the system's default paths)
+};
+
+/**
+ * @brief TLS 1.3 handshake state machine without a record layer
+ *
+ * QUIC carries handshake messages in CRYPTO frames and protects packets with
+ * its own keys, so TLS only has to turn handshake bytes into traffic secrets.
+ * This engine implements exactly what HTTP/3 needs: TLS_AES_128_GCM_SHA256,
+ * X25519 key exchange, ALPN "h3" and the quic_transport_parameters
+ * extension. There is no HelloRetryRequest, session resumption, 0-RTT,
+ * client authentication or key update; a client offering none of what is
+ * supported gets a handshake_failure alert. The client role verifies the
+ * server's chain, name and CertificateVerify as set by SetPeerVerification.
+ *
+ * @details Experimental: built only with MINISERVER_EXPERIMENTAL_HTTP3.
+ */
+class QuicTls
+{
+public:
+    enum class Role
+    {
+        kServer,
+        kClient,
+    };
+
+    /**
+     * @param role Server or client
+     * @param credentials Certificate and key (server role)
+     * @param transport_parameters Encoded local transport parameters
+     */
+    QuicTls(Role role, std::shared_ptr<const QuicCredentials> credentials, std::string transport_parameters);
+    ~QuicTls();
+
+    QuicTls(const QuicTls&) = delete;
+    QuicTls& operator=(const QuicTls&) = delete;
+
+    /**
+     * @brief Client role: how to authenticate the server (call before Start)
+     */
+    void SetPeerVerification(QuicPeerVerification verification) { m_verification = std::move(verification); }
+
+    /**
+     * @brief Client role: produce the ClientHello
+     * @return false on failure
+     */
+    bool Start();
+
+    /**
+     * @brief Process handshake bytes received at a level (in order, possibly partial messages)
+     * @return false on a handshake failure; Alert() tells which
+     */
+    bool Receive(quic::Level level, std::string_view data);
+
+    /**
+     * @brief Take the handshake bytes to send at a level
+     */
+    std::string TakeOutput(quic::Level level);
+
+    /**
+     * @brief Traffic secrets; empty until the level's keys are available
+     */
+    const std::string& ReadSecret(quic::Level level) const { return m_read_secret[static_cast<size_t>(level)]; }
+    const std::string& WriteSecret(quic::Level level) const { return m_write_secret[static_cast<size_t>(level)]; }
+
+    bool IsComplete() const { return m_state == State::kComplete; }
+    const std::string& PeerTransportParameters() const { return m_peer_parameters; }
+
+    /**
+     * @brief TLS alert of the failure (QUIC error code 0x100 + alert)
+     */
+    uint8_t Alert() const { return m_alert; }
+
+    /**
+     * @brief Description of the failure
+     */
+    const std::string& Error() const { return m_error; }
+
+private:
+    enum class State
+    {
+        kStart,
+        kWaitClientHello,
+        kWaitServerHello,
+        kWaitEncryptedExtensions,
+        kWaitCertificate,
+        kWaitCertificateVerify,
+        kWaitFinished,
+        kComplete,
+        kFailed,
+    };
+
+    /**
+     * @brief Dispatch one complete handshake message
+     */
+    bool HandleMessage(quic::Level level, uint8_t type, std::string_view body, std::string_view message);
+
+    bool HandleClientHello(std::string_view body, std::string_view message);
+    bool HandleServerHello(std::string_view body, std::string_view message);
+    bool HandleEncryptedExtensions(std::string_view body, std::string_view message);
+    bool HandleCertificate(std::string_view body, std::string_view message);
+    bool HandleCertificateVerify(std::string_view body, std::string_view message);
+    bool HandleFinished(std::string_view body, std::string_view message);
+
+    /**
+     * @brief Append a handshake message to the output of a level and to the transcript
+     */
+    void WriteMessage(quic::Level level, uint8_t type, const std::string& body);
+
+    /**
+     * @brief Derive the handshake traffic secrets from the shared key
+     */
+    void DeriveHandshakeSecrets(const std::string& shared_secret);
+
+    /**
+     * @brief Derive the application traffic secrets (transcript through the server Finished)
+     */
+    void DeriveApplicationSecrets();
+
+    /**
+     * @brief Finished verify_data for a base secret over the current transcript
+     */
+    std::string FinishedData(const std::string& base_secret) const;
+
+    /**
+     * @brief SHA-256 of the transcript so far
+     */
+    std::string TranscriptHash() const;
+
+    /**
+     * @brief Our key_share entry: X25519 group and public key
+     */
+    std::string KeyShareEntry() const;
+
+    /**
+     * @brief X25519 shared secret with the peer's public key, empty on failure
+     */
+    std::string SharedSecret(std::string_view peer_public_key) const;
+
+    bool Fail(uint8_t alert, const std::string& error);
+
+    Role m_role;                                            ///< Server or client
+    std::shared_ptr<const QuicCredentials> m_credentials;   ///< Server certificate and key
+    std::string m_local_parameters;                         ///< Our transport parameters
+    std::string m_peer_parameters;                          ///< Peer's transport parameters
+    State m_state = State::kStart;                          ///< Handshake progress
+    std::array<std::string, quic::kLevels> m_input;         ///< Unprocessed bytes per level
+    std::array<std::string, quic::kLevels> m_output;        ///< Bytes to send per level
+    std::array<std::string, quic::kLevels> m_read_secret;   ///< Secrets of received packets
+    std::array<std::string, quic::kLevels> m_write_secret;  ///< Secrets of sent packets
+    std::string m_transcript;                               ///< Handshake messages so far
+    EVP_PKEY* m_key_share = nullptr;                        ///< Ephemeral X25519 key
+    std::string m_handshake_secret;                         ///< Handshake Secret
+    std::string m_client_handshake_secret;                  ///< client_handshake_traffic_secret
+    std::string m_server_handshake_secret;                  ///< server_handshake_traffic_secret
+    std::string m_client_application_secret;                ///< Installed once the client Finished verified (server)
+    QuicPeerVerification m_verification;                    ///< Server authentication (client)
+    EVP_PKEY* m_peer_key = nullptr;                         ///< Server leaf key, checked against CertificateVerify (client)
+    uint8_t m_alert = 0;                                    ///< Failure alert
+    std::string m_error;                                    ///< Failure description
+};
+
+} // namespace miniserver::network
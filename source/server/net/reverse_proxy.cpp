@@ -0,0 +1,1902 @@
+/**
+ * @file reverse_proxy.cpp
+ * @brief Reverse proxy and upstream load balancer implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/reverse_proxy.hpp"
+#include "net/http_parser.hpp"
+#include "net/http_types.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#ifdef _WIN32
+    #include <ws2tcpip.h>
+#else
+    #include <netdb.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+    constexpr size_t kMaxResponseHead = 64 * 1024;  ///< Largest upstream response head
+    constexpr size_t kRelayChunk = 16 * 1024;       ///< Bytes moved per read while relaying
+    constexpr size_t kLatencySamples = 256;         ///< Recent response times kept per route for the hedge percentile
+    constexpr size_t kHedgeRecompute = 16;          ///< Samples between hedge delay updates
+    constexpr uint64_t kMaxEjectionMultiplier = 10; ///< Cap on base_ejection_time multiples
+
+#ifdef MSG_NOSIGNAL
+    constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kSendFlags = 0;
+#endif
+
+    /**
+     * @brief How a message body is delimited
+     */
+    enum class Framing
+    {
+        None,           ///< No body
+        Length,         ///< Content-Length bytes
+        Chunked,        ///< Transfer-Encoding: chunked
+        UntilClose      ///< Runs until the sender closes (responses only)
+    };
+
+    /**
+     * @brief Outcome of one receive
+     */
+    enum class ReadStatus
+    {
+        Data,
+        Closed,
+        TimedOut,
+        Failed
+    };
+
+    void CloseSocketHandle(SOCKET socket)
+    {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    bool LastErrorIsTimeout()
+    {
+#ifdef _WIN32
+        const int error = WSAGetLastError();
+        return error == WSAETIMEDOUT || error == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+    }
+
+    bool SendAll(SOCKET socket, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            const auto sent = send(socket, data, static_cast<int>(std::min<size_t>(size, 1 << 30)), kSendFlags);
+            if (sent <= 0)
+            {
+#ifndef _WIN32
+                if (sent < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+#endif
+                return false;
+            }
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    ReadStatus Receive(SOCKET socket, char* out, size_t size, size_t& received)
+    {
+        while (true)
+        {
+            const auto result = recv(socket, out, static_cast<int>(size), 0);
+            if (result > 0)
+            {
+                received = static_cast<size_t>(result);
+                return ReadStatus::Data;
+            }
+            if (result == 0)
+            {
+                return ReadStatus::Closed;
+            }
+#ifndef _WIN32
+            if (errno == EINTR)
+            {
+                continue;
+            }
+#endif
+            return LastErrorIsTimeout() ? ReadStatus::TimedOut : ReadStatus::Failed;
+        }
+    }
+
+    void SetIoTimeout(SOCKET socket, std::chrono::milliseconds timeout)
+    {
+#ifdef _WIN32
+        DWORD value = static_cast<DWORD>(timeout.count());
+        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&value), sizeof(value));
+        setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&value), sizeof(value));
+#else
+        timeval value;
+        value.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+        value.tv_usec = static_cast<suseconds_t>((timeout.count() % 1000) * 1000);
+        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+        setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &value, sizeof(value));
+#endif
+    }
+
+    bool SetBlocking(SOCKET socket, bool blocking)
+    {
+#ifdef _WIN32
+        u_long mode = blocking ? 0 : 1;
+        return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+        const int flags = fcntl(socket, F_GETFL, 0);
+        if (flags < 0)
+        {
+            return false;
+        }
+        return fcntl(socket, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK)) == 0;
+#endif
+    }
+
+    /**
+     * @brief Wait for readiness on one socket
+     * @return true if any of `events` (or an error) was reported in time
+     */
+    bool WaitFor(SOCKET socket, short events, std::chrono::milliseconds timeout)
+    {
+#ifdef _WIN32
+        WSAPOLLFD entry{};
+        entry.fd = socket;
+        entry.events = events;
+        return WSAPoll(&entry, 1, static_cast<INT>(timeout.count())) > 0;
+#else
+        pollfd entry{};
+        entry.fd = socket;
+        entry.events = events;
+        int result;
+        do
+        {
+            result = poll(&entry, 1, static_cast<int>(timeout.count()));
+        } while (result < 0 && errno == EINTR);
+        return result > 0;
+#endif
+    }
+
+    /**
+     * @brief Open a TCP connection, giving up after `timeout`
+     */
+    SOCKET Connect(const sockaddr_in& address, std::chrono::milliseconds timeout)
+    {
+        SOCKET socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (socket_fd == INVALID_SOCKET)
+        {
+            return INVALID_SOCKET;
+        }
+
+        SetBlocking(socket_fd, false);
+        if (connect(socket_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+#ifdef _WIN32
+            const bool pending = WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+            const bool pending = errno == EINPROGRESS;
+#endif
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (!pending || !WaitFor(socket_fd, POLLOUT, timeout) ||
+                getsockopt(socket_fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length) != 0 ||
+                error != 0)
+            {
+                CloseSocketHandle(socket_fd);
+                return INVALID_SOCKET;
+            }
+        }
+        SetBlocking(socket_fd, true);
+
+        int enable = 1;
+        setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enable), sizeof(enable));
+        return socket_fd;
+    }
+
+    /**
+     * @brief Wait until one of several sockets is readable
+     * @return Index of the first readable socket, or npos on timeout
+     */
+    size_t WaitForAny(const std::vector<SOCKET>& sockets, std::chrono::milliseconds timeout)
+    {
+#ifdef _WIN32
+        std::vector<WSAPOLLFD> entries(sockets.size());
+#else
+        std::vector<pollfd> entries(sockets.size());
+#endif
+        for (size_t i = 0; i < sockets.size(); ++i)
+        {
+            entries[i].fd = sockets[i];
+            entries[i].events = POLLIN;
+        }
+#ifdef _WIN32
+        const int result = WSAPoll(entries.data(), static_cast<ULONG>(entries.size()), static_cast<INT>(timeout.count()));
+#else
+        int result;
+        do
+        {
+            result = poll(entries.data(), entries.size(), static_cast<int>(timeout.count()));
+        } while (result < 0 && errno == EINTR);
+#endif
+        for (size_t i = 0; result > 0 && i < entries.size(); ++i)
+        {
+            if (entries[i].revents != 0)
+            {
+                return i;
+            }
+        }
+        return std::string::npos;
+    }
+
+    /**
+     * @brief Milliseconds on the steady clock (ejection deadlines)
+     */
+    int64_t SteadyNowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief A pooled connection is usable if it has nothing to read (no FIN, no stray bytes)
+     */
+    bool IsIdleConnectionAlive(SOCKET socket)
+    {
+        return !WaitFor(socket, POLLIN, std::chrono::milliseconds(0));
+    }
+
+    std::string ToLower(std::string_view value)
+    {
+        std::string lower(value);
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c)
+        {
+            return static_cast<char>(std::tolower(c));
+        });
+        return lower;
+    }
+
+    std::string_view TrimView(std::string_view value)
+    {
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        {
+            value.remove_prefix(1);
+        }
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        {
+            value.remove_suffix(1);
+        }
+        return value;
+    }
+
+    /**
+     * @brief Lower-cased comma-separated tokens of a header value
+     */
+    std::vector<std::string> SplitTokens(std::string_view value)
+    {
+        std::vector<std::string> tokens;
+        size_t start = 0;
+        while (start <= value.size())
+        {
+            size_t end = value.find(',', start);
+            if (end == std::string_view::npos)
+            {
+                end = value.size();
+            }
+            const auto token = TrimView(value.substr(start, end - start));
+            if (!token.empty())
+            {
+                tokens.push_back(ToLower(token));
+            }
+            start = end + 1;
+        }
+        return tokens;
+    }
+
+    bool Contains(const std::vector<std::string>& tokens, std::string_view token)
+    {
+        return std::find(tokens.begin(), tokens.end(), token) != tokens.end();
+    }
+
+    /**
+     * @brief Headers that describe a single connection and are never forwarded (RFC 9110 section 7.6.1)
+     */
+    bool IsHopByHop(const std::string& lower_name)
+    {
+        return lower_name == "connection" || lower_name == "keep-alive" || lower_name == "proxy-connection" ||
+               lower_name == "te" || lower_name == "trailer" || lower_name == "upgrade" ||
+               lower_name == "transfer-encoding";
+    }
+
+    /**
+     * @brief Parsed header block: lines in order, original case
+     */
+    struct HeaderBlock
+    {
+        std::string start_line;
+        std::vector<std::pair<std::string, std::string>> fields;
+
+        const std::string* Find(std::string_view lower_name) const
+        {
+            for (const auto& [name, value] : fields)
+            {
+                if (name.size() == lower_name.size() && ToLower(name) == lower_name)
+                {
+                    return &value;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    /**
+     * @brief Split a head ("start line CRLF fields CRLF CRLF") into its parts
+     */
+    bool ParseHeaderBlock(std::string_view head, HeaderBlock& block)
+    {
+        size_t line_end = head.find("\r\n");
+        if (line_end == std::string_view::npos || line_end == 0)
+        {
+            return false;
+        }
+        block.start_line.assign(head.substr(0, line_end));
+
+        size_t position = line_end + 2;
+        while (position < head.size())
+        {
+            line_end = head.find("\r\n", position);
+            if (line_end == std::string_view::npos || line_end == position)
+            {
+                break;
+            }
+            const auto line = head.substr(position, line_end - position);
+            const size_t colon = line.find(':');
+            if (colon == std::string_view::npos || colon == 0 || line.front() == ' ' || line.front() == '\t')
+            {
+                return false;   // No obsolete line folding
+            }
+            block.fields.emplace_back(std::string(line.substr(0, colon)), std::string(TrimView(line.substr(colon + 1))));
+            position = line_end + 2;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Determine body framing from Transfer-Encoding / Content-Length
+     * @return false if the framing is invalid
+     */
+    bool ParseFraming(const HeaderBlock& block, Framing& framing, uint64_t& length)
+    {
+        framing = Framing::None;
+        length = 0;
+        if (const auto* encoding = block.Find("transfer-encoding"))
+        {
+            const auto codings = SplitTokens(*encoding);
+            if (codings.empty() || codings.back() != "chunked")
+            {
+                return false;
+            }
+            framing = Framing::Chunked;
+            return true;
+        }
+
+        bool seen = false;
+        for (const auto& [name, value] : block.fields)
+        {
+            if (ToLower(name) != "content-length")
+            {
+                continue;
+            }
+            if (value.empty() || value.size() > 18 ||
+                !std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); }))
+            {
+                return false;
+            }
+            const uint64_t parsed = std::stoull(value);
+            if (seen && parsed != length)
+            {
+                return false;
+            }
+            seen = true;
+            length = parsed;
+        }
+        if (seen && length > 0)
+        {
+            framing = Framing::Length;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Incremental chunked-coding scanner
+     *
+     * Finds where a chunked body ends so it can be relayed verbatim (and the
+     * connection reused), optionally extracting the payload for receivers
+     * that cannot take chunked coding.
+     */
+    class ChunkedScanner
+    {
+    public:
+        /**
+         * @brief Consume bytes up to the end of the body
+         * @param data Input
+         * @param size Input length
+         * @param payload If non-null, receives the chunk data
+         * @return Bytes that belong to the body (less than size once Done)
+         */
+        size_t Feed(const char* data, size_t size, std::string* payload)
+        {
+            size_t i = 0;
+            while (i < size && m_state != State::Done && m_state != State::Failed)
+            {
+                const char c = data[i];
+                switch (m_state)
+                {
+                    case State::Size:
+                        if (std::isxdigit(static_cast<unsigned char>(c)))
+                        {
+                            if (m_size > (std::numeric_limits<uint64_t>::max() >> 4))
+                            {
+                                m_state = State::Failed;
+                                break;
+                            }
+                            m_size = (m_size << 4) | static_cast<uint64_t>(HexValue(c));
+                            m_digits = true;
+                        }
+                        else if (m_digits && (c == ';' || c == ' ' || c == '\t'))
+                        {
+                            m_state = State::Extension;
+                        }
+                        else if (m_digits && c == '\r')
+                        {
+                            m_state = State::SizeLf;
+                        }
+                        else
+                        {
+                            m_state = State::Failed;
+                        }
+                        ++i;
+                        break;
+                    case State::Extension:
+                        if (c == '\r')
+                        {
+                            m_state = State::SizeLf;
+                        }
+                        ++i;
+                        break;
+                    case State::SizeLf:
+                        m_state = c != '\n' ? State::Failed : (m_size == 0 ? State::TrailerStart : State::Data);
+                        ++i;
+                        break;
+                    case State::Data:
+                    {
+                        const size_t take = static_cast<size_t>(std::min<uint64_t>(m_size, size - i));
+                        if (payload)
+                        {
+                            payload->append(data + i, take);
+                        }
+                        m_size -= take;
+                        i += take;
+                        if (m_size == 0)
+                        {
+                            m_state = State::DataCr;
+                        }
+                        break;
+                    }
+                    case State::DataCr:
+                        m_state = c == '\r' ? State::DataLf : State::Failed;
+                        ++i;
+                        break;
+                    case State::DataLf:
+                        m_state = c == '\n' ? State::Size : State::Failed;
+                        m_digits = false;
+                        ++i;
+                        break;
+                    case State::TrailerStart:
+                        m_state = c == '\r' ? State::FinalLf : State::Trailer;
+                        ++i;
+                        break;
+                    case State::Trailer:
+                        if (c == '\r')
+                        {
+                            m_state = State::TrailerLf;
+                        }
+                        ++i;
+                        break;
+                    case State::TrailerLf:
+                        m_state = c == '\n' ? State::TrailerStart : State::Failed;
+                        ++i;
+                        break;
+                    case State::FinalLf:
+                        m_state = c == '\n' ? State::Done : State::Failed;
+                        ++i;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            return i;
+        }
+
+        bool Done() const { return m_state == State::Done; }
+        bool Failed() const { return m_state == State::Failed; }
+
+    private:
+        enum class State
+        {
+            Size, Extension, SizeLf, Data, DataCr, DataLf, TrailerStart, Trailer, TrailerLf, FinalLf, Done, Failed
+        };
+
+        static int HexValue(char c)
+        {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            return c - 'A' + 10;
+        }
+
+        State m_state = State::Size;
+        uint64_t m_size = 0;
+        bool m_digits = false;
+    };
+
+    /**
+     * @brief Serialized error response generated by the proxy itself
+     */
+    std::string ErrorResponse(http::StatusCode status, const char* connection)
+    {
+        http::Response response;
+        response.status = status;
+        response.SetJson("{\"error\":\"" + http::StatusToString(status) + "\"}");
+        if (connection)
+        {
+            response.SetHeader("Connection", connection);
+        }
+        return http::HttpParser::SerializeResponse(response);
+    }
+
+    bool IsIdempotent(std::string_view method)
+    {
+        return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" ||
+               method == "OPTIONS" || method == "TRACE";
+    }
+
+}
+
+/**
+ * @brief One backend and its connection pool
+ */
+struct ReverseProxy::Upstream
+{
+    /**
+     * @brief Pooled keep-alive connection
+     */
+    struct IdleConnection
+    {
+        SOCKET socket;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    std::string address;                            ///< host:port as configured
+    std::string host;                               ///< Host part (Host header when the client sent none)
+    sockaddr_in endpoint{};                         ///< Resolved address
+    std::atomic<int64_t> outstanding{0};            ///< Requests in flight
+    std::atomic<bool> healthy{true};                ///< In rotation
+    std::atomic<uint64_t> requests{0};              ///< Attempts sent
+    std::atomic<uint64_t> failures{0};              ///< Failed attempts
+    std::atomic<uint64_t> connections{0};           ///< Connections opened
+    std::atomic<uint64_t> reused{0};                ///< Attempts on pooled connections
+    std::atomic<int64_t> latency_us{0};             ///< Smoothed time to response head
+    std::atomic<int> consecutive_failures{0};       ///< Failed attempts in a row
+    std::atomic<uint64_t> window_requests{0};       ///< Outcomes since the last outlier evaluation
+    std::atomic<uint64_t> window_errors{0};         ///< Failed outcomes since the last outlier evaluation
+    std::atomic<int64_t> ejected_until{0};          ///< Steady-clock ms until which the upstream is ejected (0 if not)
+    std::atomic<uint64_t> ejections{0};             ///< Times ejected
+    std::atomic<uint64_t> hedges{0};                ///< Hedged duplicates sent here
+    std::atomic<uint64_t> hedge_wins{0};            ///< Hedged duplicates that answered first
+    uint64_t ejection_multiplier = 0;               ///< Current ejection length in base units (Route::ejection_mutex)
+    int passes = 0;                                 ///< Consecutive passing probes (health thread)
+    int fails = 0;                                  ///< Consecutive failing probes (health thread)
+    mutable std::mutex pool_mutex;                  ///< Guards idle
+    std::vector<IdleConnection> idle;               ///< Idle connections, most recent last
+};
+
+/**
+ * @brief Path prefix and its upstreams
+ */
+struct ReverseProxy::Route
+{
+    std::string prefix;                                 ///< Normalized prefix without trailing '/'
+    ProxyRouteOptions options;                          ///< Prefix stripping and hedging
+    std::vector<std::unique_ptr<Upstream>> upstreams;   ///< Backends
+    std::atomic<uint64_t> next{0};                      ///< Rotates the tie-break start
+    std::mutex ejection_mutex;                          ///< Serializes ejection decisions
+    std::mutex latency_mutex;                           ///< Guards the latency samples
+    std::vector<int64_t> latency_samples;               ///< Ring of recent response times (us)
+    uint64_t latency_count = 0;                         ///< Samples recorded so far
+    std::atomic<int64_t> hedge_delay_us{0};             ///< Current hedge delay (0 = do not hedge)
+    std::atomic<uint64_t> hedged{0};                    ///< Requests that sent a hedge
+};
+
+/**
+ * @brief One request sent to one upstream; owns the connection until it is handed back
+ */
+class ReverseProxy::Attempt
+{
+public:
+    explicit Attempt(Upstream& target)
+        : upstream(&target)
+        , started(std::chrono::steady_clock::now())
+    {
+        upstream->outstanding.fetch_add(1);
+        upstream->requests.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~Attempt()
+    {
+        if (socket != INVALID_SOCKET)
+        {
+            CloseSocketHandle(socket);
+        }
+        upstream->outstanding.fetch_sub(1);
+    }
+
+    Attempt(const Attempt&) = delete;
+    Attempt& operator=(const Attempt&) = delete;
+
+    Upstream* upstream;                                 ///< Target
+    SOCKET socket = INVALID_SOCKET;                     ///< Connection (closed on destruction unless taken)
+    bool reused = false;                                ///< Connection came from the pool
+    std::chrono::steady_clock::time_point started;      ///< Start, for latency
+};
+
+/**
+ * @brief Client request as it will be forwarded
+ */
+struct ReverseProxy::RequestHead
+{
+    std::string method;                                         ///< Request method
+    std::string target;                                         ///< Forwarded request target
+    std::vector<std::pair<std::string, std::string>> fields;    ///< End-to-end headers
+    std::string forwarded_for;                                  ///< X-Forwarded-For value to send
+    bool has_host = false;                                      ///< Client sent Host
+    Framing framing = Framing::None;                            ///< Request body framing
+    uint64_t content_length = 0;                                ///< Body size for Framing::Length
+    bool http10 = false;                                        ///< Client speaks HTTP/1.0
+    bool keep_alive = true;                                     ///< Client wants the connection kept
+    bool expect_continue = false;                               ///< Client waits for 100 Continue
+};
+
+/**
+ * @brief Client side of an exchange: a socket with a receive buffer, or a complete request
+ */
+class ReverseProxy::Downstream
+{
+public:
+    /**
+     * @brief Connected HTTP/1.x client
+     */
+    Downstream(SOCKET socket, std::string& pending) : m_socket(socket), m_pending(pending) {}
+
+    /**
+     * @brief In-memory request; the response is collected and framed with Content-Length
+     */
+    explicit Downstream(std::string& pending) : m_pending(pending), m_collect(true) {}
+
+    /**
+     * @brief Read request bytes (buffered bytes first)
+     */
+    ReadStatus Read(char* out, size_t size, size_t& received)
+    {
+        if (!m_pending.empty())
+        {
+            received = std::min(size, m_pending.size());
+            std::memcpy(out, m_pending.data(), received);
+            m_pending.erase(0, received);
+            return ReadStatus::Data;
+        }
+        if (m_socket == INVALID_SOCKET)
+        {
+            return ReadStatus::Closed;
+        }
+        return Receive(m_socket, out, size, received);
+    }
+
+    /**
+     * @brief Put back bytes read past the end of the request
+     */
+    void Unread(const char* data, size_t size)
+    {
+        m_pending.insert(0, data, size);
+    }
+
+    /**
+     * @brief Send response bytes (collected in memory for in-memory requests)
+     */
+    bool Write(const char* data, size_t size)
+    {
+        if (m_collect)
+        {
+            m_output.append(data, size);
+            return true;
+        }
+        m_wrote = true;
+        return SendAll(m_socket, data, size);
+    }
+
+    bool Collecting() const { return m_collect; }
+    bool WroteAnything() const { return m_wrote; }
+    std::string& Output() { return m_output; }
+
+private:
+    SOCKET m_socket = INVALID_SOCKET;
+    std::string& m_pending;
+    bool m_collect = false;
+    bool m_wrote = false;
+    std::string m_output;
+};
+
+ReverseProxy::ReverseProxy(const ReverseProxyOptions& options)
+    : m_options(options)
+{
+}
+
+ReverseProxy::~ReverseProxy()
+{
+    Stop();
+}
+
+void ReverseProxy::SetOptions(const ReverseProxyOptions& options)
+{
+    m_options = options;
+}
+
+bool ReverseProxy::AddRoute(const std::string& prefix, const std::vector<std::string>& upstreams, bool strip_prefix)
+{
+    ProxyRouteOptions options;
+    options.strip_prefix = strip_prefix;
+    return AddRoute(prefix, upstreams, options);
+}
+
+bool ReverseProxy::AddRoute(const std::string& prefix, const std::vector<std::string>& upstreams,
+                            const ProxyRouteOptions& options)
+{
+    if (m_running.load() || prefix.empty() || prefix.front() != '/' || upstreams.empty() ||
+        options.hedge_percentile < 0.0 || options.hedge_percentile >= 100.0)
+    {
+        LOG_WARN_FMT(ReverseProxy, "Invalid proxy route '{}'", prefix);
+        return false;
+    }
+
+    auto route = std::make_unique<Route>();
+    route->prefix = prefix;
+    while (route->prefix.size() > 1 && route->prefix.back() == '/')
+    {
+        route->prefix.pop_back();
+    }
+    route->options = options;
+    if (options.hedge_percentile > 0.0)
+    {
+        route->latency_samples.resize(kLatencySamples);
+    }
+    for (const auto& existing : m_routes)
+    {
+        if (existing->prefix == route->prefix)
+        {
+            LOG_WARN_FMT(ReverseProxy, "Proxy route '{}' already exists", route->prefix);
+            return false;
+        }
+    }
+
+    for (const auto& address : upstreams)
+    {
+        const size_t colon = address.rfind(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 == address.size())
+        {
+            LOG_WARN_FMT(ReverseProxy, "Invalid upstream address '{}'", address);
+            return false;
+        }
+
+        auto upstream = std::make_unique<Upstream>();
+        upstream->address = address;
+        upstream->host = address.substr(0, colon);
+
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(upstream->host.c_str(), address.c_str() + colon + 1, &hints, &result) != 0 || !result)
+        {
+            LOG_WARN_FMT(ReverseProxy, "Cannot resolve upstream '{}'", address);
+            return false;
+        }
+        std::memcpy(&upstream->endpoint, result->ai_addr, sizeof(upstream->endpoint));
+        freeaddrinfo(result);
+
+        route->upstreams.push_back(std::move(upstream));
+    }
+
+    LOG_INFO_FMT(ReverseProxy, "Proxying {} to {} upstream(s)", route->prefix, route->upstreams.size());
+    m_routes.push_back(std::move(route));
+    std::stable_sort(m_routes.begin(), m_routes.end(), [](const auto& a, const auto& b)
+    {
+        return a->prefix.size() > b->prefix.size();
+    });
+    return true;
+}
+
+ReverseProxy::Route* ReverseProxy::FindRoute(std::string_view path) const
+{
+    for (const auto& route : m_routes)
+    {
+        const std::string& prefix = route->prefix;
+        if (prefix == "/" ||
+            (path.compare(0, prefix.size(), prefix) == 0 && (path.size() == prefix.size() || path[prefix.size()] == '/')))
+        {
+            return route.get();
+        }
+    }
+    return nullptr;
+}
+
+bool ReverseProxy::Matches(std::string_view path) const
+{
+    return FindRoute(path) != nullptr;
+}
+
+void ReverseProxy::Start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+    m_stopping = false;
+    if (!m_routes.empty() && (!m_options.health_check_path.empty() || m_options.outlier_interval.count() > 0))
+    {
+        m_health_thread = std::thread(&ReverseProxy::HealthCheckLoop, this);
+    }
+}
+
+void ReverseProxy::Stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_health_mutex);
+        m_stopping = true;
+    }
+    m_health_cv.notify_all();
+    if (m_health_thread.joinable())
+    {
+        m_health_thread.join();
+    }
+
+    for (const auto& route : m_routes)
+    {
+        for (const auto& upstream : route->upstreams)
+        {
+            std::lock_guard<std::mutex> lock(upstream->pool_mutex);
+            for (const auto& connection : upstream->idle)
+            {
+                CloseSocketHandle(connection.socket);
+            }
+            upstream->idle.clear();
+        }
+    }
+}
+
+std::vector<ProxyRouteStats> ReverseProxy::GetStats() const
+{
+    const int64_t now = SteadyNowMs();
+    std::vector<ProxyRouteStats> stats;
+    for (const auto& route : m_routes)
+    {
+        ProxyRouteStats route_entry;
+        route_entry.prefix = route->prefix;
+        route_entry.hedge_delay_us = route->hedge_delay_us.load();
+        route_entry.hedged = route->hedged.load();
+        for (const auto& upstream : route->upstreams)
+        {
+            UpstreamStats entry;
+            entry.address = upstream->address;
+            entry.healthy = upstream->healthy.load();
+            entry.ejected = upstream->ejected_until.load() > now;
+            entry.outstanding = upstream->outstanding.load();
+            entry.requests = upstream->requests.load();
+            entry.failures = upstream->failures.load();
+            entry.connections = upstream->connections.load();
+            entry.reused = upstream->reused.load();
+            entry.latency_us = upstream->latency_us.load();
+            entry.ejections = upstream->ejections.load();
+            entry.hedges = upstream->hedges.load();
+            entry.hedge_wins = upstream->hedge_wins.load();
+            {
+                std::lock_guard<std::mutex> lock(upstream->pool_mutex);
+                entry.idle = upstream->idle.size();
+            }
+            route_entry.upstreams.push_back(std::move(entry));
+        }
+        stats.push_back(std::move(route_entry));
+    }
+    return stats;
+}
+
+PassthroughResult ReverseProxy::Serve(SOCKET client_socket, std::string& buffer, size_t head_size,
+                                      const std::string& client_ip)
+{
+    HeaderBlock block;
+    if (m_routes.empty() || !ParseHeaderBlock(std::string_view(buffer).substr(0, head_size), block))
+    {
+        return PassthroughResult::Declined;
+    }
+
+    // "METHOD target HTTP/1.x"
+    const size_t method_end = block.start_line.find(' ');
+    const size_t target_end = block.start_line.rfind(' ');
+    if (method_end == std::string::npos || target_end <= method_end ||
+        block.start_line.compare(target_end + 1, 7, "HTTP/1.") != 0 || block.Find("upgrade"))
+    {
+        return PassthroughResult::Declined;
+    }
+    const std::string target = block.start_line.substr(method_end + 1, target_end - method_end - 1);
+    Route* route = FindRoute(std::string_view(target).substr(0, target.find('?')));
+    if (!route)
+    {
+        return PassthroughResult::Declined;
+    }
+
+    RequestHead request;
+    request.method = block.start_line.substr(0, method_end);
+    request.http10 = block.start_line.compare(target_end + 1, 8, "HTTP/1.0") == 0;
+
+    const std::vector<std::string> connection = block.Find("connection") ? SplitTokens(*block.Find("connection"))
+                                                                          : std::vector<std::string>{};
+    request.keep_alive = request.http10 ? Contains(connection, "keep-alive") : !Contains(connection, "close");
+
+    buffer.erase(0, head_size);
+    if (!ParseFraming(block, request.framing, request.content_length))
+    {
+        const std::string response = ErrorResponse(http::StatusCode::BadRequest, "close");
+        SendAll(client_socket, response.data(), response.size());
+        return PassthroughResult::Close;
+    }
+
+    request.target = target;
+    if (route->options.strip_prefix && route->prefix != "/")
+    {
+        request.target.erase(0, route->prefix.size());
+        if (request.target.empty() || request.target.front() != '/')
+        {
+            request.target.insert(0, "/");
+        }
+    }
+
+    for (auto& [name, value] : block.fields)
+    {
+        const std::string lower = ToLower(name);
+        if (IsHopByHop(lower) || Contains(connection, lower) || lower == "content-length")
+        {
+            continue;
+        }
+        if (lower == "expect")
+        {
+            request.expect_continue = ToLower(value) == "100-continue";
+            continue;
+        }
+        if (lower == "x-forwarded-for")
+        {
+            request.forwarded_for = value + ", ";
+            continue;
+        }
+        request.has_host = request.has_host || lower == "host";
+        request.fields.emplace_back(std::move(name), std::move(value));
+    }
+    request.forwarded_for += client_ip;
+
+    // Responses are relayed in several writes; do not let Nagle hold back the last one
+    int no_delay = 1;
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&no_delay), sizeof(no_delay));
+
+    Downstream downstream(client_socket, buffer);
+    const bool keep_alive = Exchange(*route, request, downstream);
+    return keep_alive ? PassthroughResult::KeepAlive : PassthroughResult::Close;
+}
+
+std::string ReverseProxy::Forward(const std::string& request_data)
+{
+    const size_t head_end = request_data.find("\r\n\r\n");
+    HeaderBlock block;
+    if (head_end == std::string::npos ||
+        !ParseHeaderBlock(std::string_view(request_data).substr(0, head_end + 4), block))
+    {
+        return ErrorResponse(http::StatusCode::BadRequest, nullptr);
+    }
+
+    const size_t method_end = block.start_line.find(' ');
+    const size_t target_end = block.start_line.rfind(' ');
+    if (method_end == std::string::npos || target_end <= method_end)
+    {
+        return ErrorResponse(http::StatusCode::BadRequest, nullptr);
+    }
+
+    RequestHead request;
+    request.method = block.start_line.substr(0, method_end);
+    request.target = block.start_line.substr(method_end + 1, target_end - method_end - 1);
+    Route* route = FindRoute(std::string_view(request.target).substr(0, request.target.find('?')));
+    if (!route)
+    {
+        return ErrorResponse(http::StatusCode::NotFound, nullptr);
+    }
+    if (route->options.strip_prefix && route->prefix != "/")
+    {
+        request.target.erase(0, route->prefix.size());
+        if (request.target.empty() || request.target.front() != '/')
+        {
+            request.target.insert(0, "/");
+        }
+    }
+
+    std::string body = request_data.substr(head_end + 4);
+    request.framing = body.empty() ? Framing::None : Framing::Length;
+    request.content_length = body.size();
+    for (auto& [name, value] : block.fields)
+    {
+        const std::string lower = ToLower(name);
+        if (IsHopByHop(lower) || lower == "content-length" || lower == "expect")
+        {
+            continue;
+        }
+        if (lower == "x-forwarded-for")
+        {
+            request.forwarded_for = value;
+            continue;
+        }
+        request.has_host = request.has_host || lower == "host";
+        request.fields.emplace_back(std::move(name), std::move(value));
+    }
+
+    Downstream downstream(body);
+    Exchange(*route, request, downstream);
+    return std::move(downstream.Output());
+}
+
+bool ReverseProxy::Exchange(Route& route, RequestHead& request, Downstream& downstream)
+{
+    // Tell a waiting client to send its body before anything is read
+    if (request.expect_continue && request.framing != Framing::None && !request.http10 && !downstream.Collecting())
+    {
+        static constexpr char kContinue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        if (!downstream.Write(kContinue, sizeof(kContinue) - 1))
+        {
+            return false;
+        }
+    }
+
+    // Small bodies are read up front so the request can be replayed on another upstream
+    std::string body;
+    bool body_buffered = request.framing == Framing::None;
+    if (request.framing == Framing::Length && request.content_length <= m_options.max_replay_body)
+    {
+        body.reserve(static_cast<size_t>(request.content_length));
+        char chunk[kRelayChunk];
+        while (body.size() < request.content_length)
+        {
+            size_t received = 0;
+            if (downstream.Read(chunk, std::min<size_t>(sizeof(chunk), request.content_length - body.size()), received) !=
+                ReadStatus::Data)
+            {
+                return false;
+            }
+            body.append(chunk, received);
+        }
+        body_buffered = true;
+    }
+    bool body_consumed = body_buffered;
+
+    const auto fail = [&](http::StatusCode status) -> bool
+    {
+        if (downstream.WroteAnything())
+        {
+            return false;   // Part of a response is already out; only closing can signal the error
+        }
+        const bool keep_alive = request.keep_alive && body_consumed;
+        const std::string response = ErrorResponse(status, downstream.Collecting() ? nullptr
+                                                           : (keep_alive ? "keep-alive" : "close"));
+        return downstream.Write(response.data(), response.size()) && keep_alive;
+    };
+
+    // Request head for one upstream; buffered bodies go out with it
+    const auto build_head = [&](const Upstream& upstream) -> std::string
+    {
+        std::string head;
+        head.reserve(256 + request.fields.size() * 48 + body.size());
+        head += request.method;
+        head += ' ';
+        head += request.target;
+        head += " HTTP/1.1\r\n";
+        if (!request.has_host)
+        {
+            head += "Host: " + upstream.address + "\r\n";
+        }
+        for (const auto& [name, value] : request.fields)
+        {
+            head += name;
+            head += ": ";
+            head += value;
+            head += "\r\n";
+        }
+        if (!request.forwarded_for.empty())
+        {
+            head += "X-Forwarded-For: " + request.forwarded_for + "\r\n";
+        }
+        if (request.framing == Framing::Chunked)
+        {
+            head += "Transfer-Encoding: chunked\r\n";
+        }
+        else if (request.framing == Framing::Length)
+        {
+            head += "Content-Length: " + std::to_string(request.content_length) + "\r\n";
+        }
+        head += "Connection: keep-alive\r\n\r\n";
+        if (body_buffered)
+        {
+            head += body;
+        }
+        return head;
+    };
+
+    // Replay (retries and hedges) only when the whole request is at hand and repeating it is harmless
+    const bool replayable = body_buffered && IsIdempotent(request.method);
+    bool may_hedge = replayable && route.options.hedge_percentile > 0.0;
+
+    std::vector<Upstream*> tried;
+    std::vector<std::unique_ptr<Attempt>> attempts;
+    int retries_left = m_options.max_retries;
+    http::StatusCode failure = http::StatusCode::ServiceUnavailable;
+    while (true)
+    {
+        if (attempts.empty())
+        {
+            Upstream* upstream = PickUpstream(route, tried);
+            if (!upstream)
+            {
+                LOG_WARN_FMT(ReverseProxy, "No upstream available for {} {}", request.method, request.target);
+                return fail(failure);
+            }
+            tried.push_back(upstream);
+
+            auto attempt = std::make_unique<Attempt>(*upstream);
+            if (!Launch(route, *attempt, build_head(*upstream)))
+            {
+                // Nothing reached the upstream if connecting failed, so any request can move on
+                failure = http::StatusCode::BadGateway;
+                if ((attempt->socket == INVALID_SOCKET || replayable) && retries_left-- > 0)
+                {
+                    continue;
+                }
+                return fail(failure);
+            }
+
+            // Larger bodies are relayed as they arrive
+            char chunk[kRelayChunk];
+            uint64_t remaining = request.content_length;
+            ChunkedScanner request_scanner;
+            while (!body_consumed)
+            {
+                const size_t want = request.framing == Framing::Length
+                    ? static_cast<size_t>(std::min<uint64_t>(sizeof(chunk), remaining)) : sizeof(chunk);
+                size_t received = 0;
+                if (downstream.Read(chunk, want, received) != ReadStatus::Data)
+                {
+                    return false;   // Client went away mid-body: neither side can be reused
+                }
+                size_t take = received;
+                if (request.framing == Framing::Chunked)
+                {
+                    take = request_scanner.Feed(chunk, received, nullptr);
+                    if (request_scanner.Failed())
+                    {
+                        return fail(http::StatusCode::BadRequest);
+                    }
+                    downstream.Unread(chunk + take, received - take);
+                    body_consumed = request_scanner.Done();
+                }
+                else
+                {
+                    remaining -= take;
+                    body_consumed = remaining == 0;
+                }
+                if (!SendAll(attempt->socket, chunk, take))
+                {
+                    upstream->failures.fetch_add(1, std::memory_order_relaxed);
+                    RecordOutcome(route, *upstream, false, {});
+                    LOG_WARN_FMT(ReverseProxy, "Upstream {} stopped reading the body of {} {}",
+                        upstream->address, request.method, request.target);
+                    body_consumed = false;
+                    return fail(http::StatusCode::BadGateway);
+                }
+            }
+            attempts.push_back(std::move(attempt));
+        }
+
+        // Hedge: a slow first attempt gets a duplicate on another upstream; the first head wins
+        if (may_hedge && attempts.size() == 1)
+        {
+            const int64_t delay_us = route.hedge_delay_us.load(std::memory_order_relaxed);
+            const auto delay = std::chrono::milliseconds((delay_us + 999) / 1000);
+            if (delay_us > 0 && !WaitFor(attempts.front()->socket, POLLIN, delay))
+            {
+                may_hedge = false;
+                if (Upstream* spare = PickUpstream(route, tried))
+                {
+                    tried.push_back(spare);
+                    route.hedged.fetch_add(1, std::memory_order_relaxed);
+                    spare->hedges.fetch_add(1, std::memory_order_relaxed);
+                    auto hedge = std::make_unique<Attempt>(*spare);
+                    if (Launch(route, *hedge, build_head(*spare)))
+                    {
+                        attempts.push_back(std::move(hedge));
+                    }
+                }
+            }
+        }
+
+        size_t index = 0;
+        if (attempts.size() > 1)
+        {
+            std::vector<SOCKET> sockets;
+            for (const auto& attempt : attempts)
+            {
+                sockets.push_back(attempt->socket);
+            }
+            index = WaitForAny(sockets, m_options.io_timeout);
+            if (index == std::string::npos)
+            {
+                for (const auto& attempt : attempts)
+                {
+                    attempt->upstream->failures.fetch_add(1, std::memory_order_relaxed);
+                    RecordOutcome(route, *attempt->upstream, false, {});
+                }
+                LOG_WARN_FMT(ReverseProxy, "No upstream answered {} {} in time", request.method, request.target);
+                return fail(http::StatusCode::GatewayTimeout);
+            }
+        }
+        Attempt& attempt = *attempts[index];
+
+        // Response head, skipping interim 1xx responses
+        std::string response;
+        size_t head_size = 0;
+        HeaderBlock block;
+        int status = 0;
+        ReadStatus read_status = ReadStatus::Data;
+        while (true)
+        {
+            size_t head_end;
+            while ((head_end = response.find("\r\n\r\n")) == std::string::npos && response.size() <= kMaxResponseHead)
+            {
+                char chunk[kRelayChunk];
+                size_t received = 0;
+                read_status = Receive(attempt.socket, chunk, sizeof(chunk), received);
+                if (read_status != ReadStatus::Data)
+                {
+                    break;
+                }
+                response.append(chunk, received);
+            }
+            if (head_end == std::string::npos)
+            {
+                break;
+            }
+
+            head_size = head_end + 4;
+            block = HeaderBlock();
+            if (!ParseHeaderBlock(std::string_view(response).substr(0, head_size), block) ||
+                block.start_line.compare(0, 7, "HTTP/1.") != 0 || block.start_line.size() < 12)
+            {
+                status = -1;
+                break;
+            }
+            status = std::atoi(block.start_line.c_str() + 9);
+            if (status < 100 || status > 999 || status == 101)
+            {
+                status = -1;
+                break;
+            }
+            if (status >= 200)
+            {
+                break;
+            }
+            // 100 Continue was already answered by the proxy; other 1xx go to HTTP/1.1 clients
+            if (status != 100 && !request.http10 && !downstream.Collecting() &&
+                !downstream.Write(response.data(), head_size))
+            {
+                return false;
+            }
+            response.erase(0, head_size);
+            status = 0;
+        }
+
+        if (status < 200)
+        {
+            attempt.upstream->failures.fetch_add(1, std::memory_order_relaxed);
+            RecordOutcome(route, *attempt.upstream, false, {});
+
+            const bool timed_out = read_status == ReadStatus::TimedOut;
+            LOG_WARN_FMT(ReverseProxy, "Upstream {} {} for {} {}{}", attempt.upstream->address,
+                timed_out ? "timed out" : (status < 0 ? "sent an invalid response" : "failed"),
+                request.method, request.target, attempt.reused ? " (pooled connection)" : "");
+            failure = timed_out ? http::StatusCode::GatewayTimeout : http::StatusCode::BadGateway;
+
+            attempts.erase(attempts.begin() + static_cast<std::ptrdiff_t>(index));
+            if (!attempts.empty() || (status == 0 && replayable && retries_left-- > 0))
+            {
+                continue;
+            }
+            return fail(failure);
+        }
+
+        // The first complete head wins; the other attempt's connection is dropped
+        RecordOutcome(route, *attempt.upstream, status < 500,
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - attempt.started));
+        if (index > 0)
+        {
+            attempt.upstream->hedge_wins.fetch_add(1, std::memory_order_relaxed);
+        }
+        const std::unique_ptr<Attempt> winner = std::move(attempts[index]);
+        attempts.clear();
+        Upstream* upstream = winner->upstream;
+        const SOCKET upstream_socket = std::exchange(winner->socket, INVALID_SOCKET);
+
+        // Response body framing
+        Framing framing = Framing::None;
+        uint64_t length = 0;
+        const bool bodiless = request.method == "HEAD" || status == 204 || status == 304;
+        if (!bodiless)
+        {
+            if (!ParseFraming(block, framing, length))
+            {
+                upstream->failures.fetch_add(1, std::memory_order_relaxed);
+                CloseSocketHandle(upstream_socket);
+                return fail(http::StatusCode::BadGateway);
+            }
+            if (framing == Framing::None && !block.Find("content-length"))
+            {
+                framing = Framing::UntilClose;
+            }
+        }
+
+        const std::vector<std::string> upstream_connection = block.Find("connection")
+            ? SplitTokens(*block.Find("connection")) : std::vector<std::string>{};
+        const bool upstream_http10 = block.start_line.compare(0, 8, "HTTP/1.0") == 0;
+        bool upstream_reusable = framing != Framing::UntilClose &&
+            (upstream_http10 ? Contains(upstream_connection, "keep-alive") : !Contains(upstream_connection, "close"));
+
+        // Chunked bodies pass through verbatim to HTTP/1.1 clients and are decoded otherwise
+        const bool decode_chunks = framing == Framing::Chunked && (request.http10 || downstream.Collecting());
+        bool client_keep_alive = request.keep_alive && body_consumed &&
+                                 framing != Framing::UntilClose && !(decode_chunks && !downstream.Collecting());
+
+        std::string client_head = "HTTP/1.1" + block.start_line.substr(8) + "\r\n";
+        for (const auto& [name, value] : block.fields)
+        {
+            const std::string lower = ToLower(name);
+            // Content-Length stays for bodiless and fixed-length responses; collected ones get their own
+            const bool framed_by_proxy = framing == Framing::Chunked || framing == Framing::UntilClose ||
+                                         (framing == Framing::Length && downstream.Collecting());
+            if (IsHopByHop(lower) || Contains(upstream_connection, lower) ||
+                (lower == "content-length" && framed_by_proxy))
+            {
+                continue;
+            }
+            client_head += name + ": " + value + "\r\n";
+        }
+        if (framing == Framing::Chunked && !decode_chunks)
+        {
+            client_head += "Transfer-Encoding: chunked\r\n";
+        }
+        if (!downstream.Collecting())
+        {
+            client_head += client_keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+        }
+
+        // Body bytes are batched per upstream read; the head goes out with the first batch
+        // (one segment for small responses). In-memory exchanges get the head once the length is known.
+        std::string outgoing;
+        if (!downstream.Collecting())
+        {
+            outgoing = std::move(client_head);
+            outgoing += "\r\n";
+        }
+        const auto emit = [&](const char* data, size_t size) -> bool
+        {
+            outgoing.append(data, size);
+            return true;
+        };
+        const auto flush = [&]() -> bool
+        {
+            if (downstream.Collecting() || outgoing.empty())
+            {
+                return true;
+            }
+            const bool ok = downstream.Write(outgoing.data(), outgoing.size());
+            outgoing.clear();
+            return ok;
+        };
+
+        bool complete = false;
+        bool client_ok = true;
+
+        response.erase(0, head_size);
+        ChunkedScanner scanner;
+        std::string decoded;
+        uint64_t remaining = length;
+        const auto consume = [&](const char* data, size_t size) -> size_t
+        {
+            switch (framing)
+            {
+                case Framing::Length:
+                {
+                    const size_t take = static_cast<size_t>(std::min<uint64_t>(remaining, size));
+                    remaining -= take;
+                    complete = remaining == 0;
+                    client_ok = client_ok && emit(data, take);
+                    return take;
+                }
+                case Framing::Chunked:
+                {
+                    decoded.clear();
+                    const size_t take = scanner.Feed(data, size, decode_chunks ? &decoded : nullptr);
+                    complete = scanner.Done();
+                    client_ok = client_ok && (decode_chunks ? emit(decoded.data(), decoded.size()) : emit(data, take));
+                    return take;
+                }
+                case Framing::UntilClose:
+                    client_ok = client_ok && emit(data, size);
+                    return size;
+                default:
+                    complete = true;
+                    return 0;
+            }
+        };
+
+        complete = framing == Framing::None;
+        if (!response.empty() && !complete)
+        {
+            const size_t take = consume(response.data(), response.size());
+            if (take < response.size())
+            {
+                upstream_reusable = false;  // Bytes after the response
+            }
+        }
+        else if (!response.empty())
+        {
+            upstream_reusable = false;
+        }
+        client_ok = flush();
+
+        char chunk[kRelayChunk];
+        while (!complete && client_ok && !scanner.Failed())
+        {
+            size_t received = 0;
+            read_status = Receive(upstream_socket, chunk, sizeof(chunk), received);
+            if (read_status != ReadStatus::Data)
+            {
+                complete = framing == Framing::UntilClose && read_status == ReadStatus::Closed;
+                break;
+            }
+            if (consume(chunk, received) < received)
+            {
+                upstream_reusable = false;
+            }
+            client_ok = client_ok && flush();
+        }
+
+        if (!complete || scanner.Failed())
+        {
+            upstream->failures.fetch_add(1, std::memory_order_relaxed);
+            if (client_ok)
+            {
+                LOG_WARN_FMT(ReverseProxy, "Upstream {} cut off the response to {} {}",
+                    upstream->address, request.method, request.target);
+            }
+            CloseSocketHandle(upstream_socket);
+            if (downstream.Collecting())
+            {
+                downstream.Output() = ErrorResponse(http::StatusCode::BadGateway, nullptr);
+            }
+            return false;
+        }
+
+        Release(*upstream, upstream_socket, upstream_reusable && client_ok);
+
+        if (downstream.Collecting())
+        {
+            if (framing != Framing::None)
+            {
+                client_head += "Content-Length: " + std::to_string(outgoing.size()) + "\r\n";
+            }
+            client_head += "\r\n";
+            downstream.Write(client_head.data(), client_head.size());
+            downstream.Write(outgoing.data(), outgoing.size());
+        }
+        LOG_DEBUG_FMT(ReverseProxy, "{} {} -> {} ({})", request.method, request.target, upstream->address, status);
+        return client_ok && client_keep_alive;
+    }
+}
+
+ReverseProxy::Upstream* ReverseProxy::PickUpstream(Route& route, const std::vector<Upstream*>& tried)
+{
+    const size_t count = route.upstreams.size();
+    const size_t start = static_cast<size_t>(route.next.fetch_add(1, std::memory_order_relaxed));
+    const int64_t now = SteadyNowMs();
+    Upstream* best = nullptr;
+    Upstream* fallback = nullptr;   // Ejected but healthy, used only when nothing else is left
+    int64_t best_load = std::numeric_limits<int64_t>::max();
+    int64_t fallback_load = std::numeric_limits<int64_t>::max();
+    for (size_t i = 0; i < count; ++i)
+    {
+        Upstream* candidate = route.upstreams[(start + i) % count].get();
+        if (!candidate->healthy.load(std::memory_order_relaxed) ||
+            std::find(tried.begin(), tried.end(), candidate) != tried.end())
+        {
+            continue;
+        }
+        const int64_t load = candidate->outstanding.load(std::memory_order_relaxed);
+        if (candidate->ejected_until.load(std::memory_order_relaxed) > now)
+        {
+            if (load < fallback_load)
+            {
+                fallback = candidate;
+                fallback_load = load;
+            }
+            continue;
+        }
+        if (load < best_load)
+        {
+            best = candidate;
+            best_load = load;
+        }
+    }
+    return best ? best : fallback;
+}
+
+bool ReverseProxy::Launch(Route& route, Attempt& attempt, const std::string& request_data)
+{
+    Upstream& upstream = *attempt.upstream;
+    attempt.socket = Acquire(upstream, attempt.reused);
+    if (attempt.socket == INVALID_SOCKET)
+    {
+        upstream.failures.fetch_add(1, std::memory_order_relaxed);
+        RecordOutcome(route, upstream, false, {});
+        LOG_WARN_FMT(ReverseProxy, "Cannot connect to upstream {}", upstream.address);
+        return false;
+    }
+    if (!SendAll(attempt.socket, request_data.data(), request_data.size()))
+    {
+        upstream.failures.fetch_add(1, std::memory_order_relaxed);
+        RecordOutcome(route, upstream, false, {});
+        LOG_WARN_FMT(ReverseProxy, "Cannot send to upstream {}{}", upstream.address,
+            attempt.reused ? " (pooled connection)" : "");
+        return false;
+    }
+    return true;
+}
+
+void ReverseProxy::RecordOutcome(Route& route, Upstream& upstream, bool success, std::chrono::microseconds latency)
+{
+    upstream.window_requests.fetch_add(1, std::memory_order_relaxed);
+    if (!success)
+    {
+        upstream.window_errors.fetch_add(1, std::memory_order_relaxed);
+        const int streak = upstream.consecutive_failures.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (m_options.outlier_consecutive_failures > 0 && streak >= m_options.outlier_consecutive_failures)
+        {
+            Eject(route, upstream, "consecutive failures");
+        }
+        return;
+    }
+    upstream.consecutive_failures.store(0, std::memory_order_relaxed);
+
+    // Moving average with weight 1/8; concurrent updates may drop a sample, which is harmless
+    const int64_t sample = latency.count();
+    const int64_t average = upstream.latency_us.load(std::memory_order_relaxed);
+    upstream.latency_us.store(average == 0 ? sample : average + (sample - average) / 8, std::memory_order_relaxed);
+
+    if (route.latency_samples.empty())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(route.latency_mutex);
+    route.latency_samples[route.latency_count % kLatencySamples] = sample;
+    ++route.latency_count;
+    if (route.latency_count < 2 * kHedgeRecompute || route.latency_count % kHedgeRecompute != 0)
+    {
+        return;
+    }
+    std::vector<int64_t> window(route.latency_samples.begin(),
+        route.latency_samples.begin() + static_cast<std::ptrdiff_t>(std::min<uint64_t>(route.latency_count, kLatencySamples)));
+    const size_t rank = std::min(window.size() - 1,
+        static_cast<size_t>(static_cast<double>(window.size()) * route.options.hedge_percentile / 100.0));
+    std::nth_element(window.begin(), window.begin() + static_cast<std::ptrdiff_t>(rank), window.end());
+    const int64_t floor = std::chrono::duration_cast<std::chrono::microseconds>(route.options.hedge_min_delay).count();
+    route.hedge_delay_us.store(std::max(window[rank], floor), std::memory_order_relaxed);
+}
+
+void ReverseProxy::Eject(Route& route, Upstream& upstream, const char* reason)
+{
+    std::lock_guard<std::mutex> lock(route.ejection_mutex);
+    const int64_t now = SteadyNowMs();
+    if (route.upstreams.size() < 2 || upstream.ejected_until.load() > now)
+    {
+        return;
+    }
+
+    // Keep enough of the route in rotation to carry the load
+    size_t ejected = 0;
+    for (const auto& candidate : route.upstreams)
+    {
+        ejected += candidate->ejected_until.load() > now ? 1 : 0;
+    }
+    const size_t budget = std::max<size_t>(1,
+        route.upstreams.size() * static_cast<size_t>(std::max(m_options.max_ejection_percent, 0)) / 100);
+    if (ejected >= budget)
+    {
+        return;
+    }
+
+    // Each repeat ejection lasts one base period longer; quiet intervals shorten it again
+    upstream.ejection_multiplier = std::min(upstream.ejection_multiplier + 1, kMaxEjectionMultiplier);
+    const auto duration = m_options.base_ejection_time * static_cast<int64_t>(upstream.ejection_multiplier);
+    upstream.ejected_until.store(now + duration.count());
+    upstream.ejections.fetch_add(1, std::memory_order_relaxed);
+    upstream.consecutive_failures.store(0, std::memory_order_relaxed);
+    LOG_WARN_FMT(ReverseProxy, "Ejecting upstream {} from route {} for {} ms ({})",
+        upstream.address, route.prefix, duration.count(), reason);
+
+    std::lock_guard<std::mutex> pool_lock(upstream.pool_mutex);
+    for (const auto& connection : upstream.idle)
+    {
+        CloseSocketHandle(connection.socket);
+    }
+    upstream.idle.clear();
+}
+
+void ReverseProxy::EvaluateOutliers()
+{
+    const int64_t now = SteadyNowMs();
+    for (const auto& route : m_routes)
+    {
+        struct Window
+        {
+            Upstream* upstream;
+            uint64_t requests;
+            uint64_t errors;
+            int64_t latency_us;
+        };
+        std::vector<Window> windows;
+        for (const auto& upstream : route->upstreams)
+        {
+            const int64_t until = upstream->ejected_until.load();
+            if (until != 0 && until <= now)
+            {
+                // Back in rotation; the latency that got it ejected no longer applies
+                upstream->ejected_until.store(0);
+                upstream->latency_us.store(0, std::memory_order_relaxed);
+                LOG_INFO_FMT(ReverseProxy, "Upstream {} returned to route {}", upstream->address, route->prefix);
+            }
+            windows.push_back({upstream.get(), upstream->window_requests.exchange(0),
+                               upstream->window_errors.exchange(0), upstream->latency_us.load()});
+        }
+
+        const int64_t min_latency =
+            std::chrono::duration_cast<std::chrono::microseconds>(m_options.outlier_min_latency).count();
+        for (const Window& window : windows)
+        {
+            Upstream& upstream = *window.upstream;
+            if (upstream.ejected_until.load() > now)
+            {
+                continue;
+            }
+
+            if (m_options.outlier_error_rate > 0.0 && window.requests >= m_options.outlier_min_requests &&
+                static_cast<double>(window.errors) >= m_options.outlier_error_rate * static_cast<double>(window.requests))
+            {
+                Eject(*route, upstream, "error rate");
+                continue;
+            }
+
+            // Compare with the median of the other upstreams that served traffic
+            if (m_options.outlier_latency_factor > 0.0 && window.requests > 0 && window.latency_us >= min_latency)
+            {
+                std::vector<int64_t> others;
+                for (const Window& other : windows)
+                {
+                    if (&other != &window && other.latency_us > 0 && other.upstream->ejected_until.load() <= now)
+                    {
+                        others.push_back(other.latency_us);
+                    }
+                }
+                if (!others.empty())
+                {
+                    std::nth_element(others.begin(), others.begin() + static_cast<std::ptrdiff_t>(others.size() / 2), others.end());
+                    if (static_cast<double>(window.latency_us) >
+                        m_options.outlier_latency_factor * static_cast<double>(others[others.size() / 2]))
+                    {
+                        Eject(*route, upstream, "latency");
+                        continue;
+                    }
+                }
+            }
+
+            if (window.errors == 0)
+            {
+                std::lock_guard<std::mutex> lock(route->ejection_mutex);
+                if (upstream.ejection_multiplier > 0)
+                {
+                    --upstream.ejection_multiplier;
+                }
+            }
+        }
+    }
+}
+
+SOCKET ReverseProxy::Acquire(Upstream& upstream, bool& reused)
+{
+    const auto now = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(upstream.pool_mutex);
+        while (!upstream.idle.empty())
+        {
+            const auto connection = upstream.idle.back();
+            upstream.idle.pop_back();
+            if (now - connection.since <= m_options.idle_timeout)
+            {
+                lock.unlock();
+                if (IsIdleConnectionAlive(connection.socket))
+                {
+                    reused = true;
+                    upstream.reused.fetch_add(1, std::memory_order_relaxed);
+                    return connection.socket;
+                }
+                CloseSocketHandle(connection.socket);
+                lock.lock();
+                continue;
+            }
+            CloseSocketHandle(connection.socket);
+        }
+    }
+
+    const SOCKET socket_fd = Connect(upstream.endpoint, m_options.connect_timeout);
+    if (socket_fd != INVALID_SOCKET)
+    {
+        SetIoTimeout(socket_fd, m_options.io_timeout);
+        upstream.connections.fetch_add(1, std::memory_order_relaxed);
+    }
+    return socket_fd;
+}
+
+void ReverseProxy::Release(Upstream& upstream, SOCKET socket, bool reusable)
+{
+    if (reusable && m_running.load() && upstream.healthy.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(upstream.pool_mutex);
+        if (upstream.idle.size() < m_options.max_idle_connections)
+        {
+            upstream.idle.push_back({socket, std::chrono::steady_clock::now()});
+            return;
+        }
+    }
+    CloseSocketHandle(socket);
+}
+
+bool ReverseProxy::Probe(Upstream& upstream)
+{
+    const SOCKET socket_fd = Connect(upstream.endpoint, m_options.connect_timeout);
+    if (socket_fd == INVALID_SOCKET)
+    {
+        return false;
+    }
+    SetIoTimeout(socket_fd, std::min(m_options.io_timeout, m_options.health_check_interval));
+
+    const std::string probe = "GET " + m_options.health_check_path + " HTTP/1.1\r\nHost: " + upstream.address +
+                              "\r\nUser-Agent: mini-server-health-check\r\nConnection: close\r\n\r\n";
+    std::string status_line;
+    bool ok = SendAll(socket_fd, probe.data(), probe.size());
+    while (ok && status_line.find("\r\n") == std::string::npos && status_line.size() < 1024)
+    {
+        char chunk[512];
+        size_t received = 0;
+        ok = Receive(socket_fd, chunk, sizeof(chunk), received) == ReadStatus::Data;
+        status_line.append(chunk, ok ? received : 0);
+    }
+    CloseSocketHandle(socket_fd);
+
+    // Any 2xx or 3xx passes
+    return ok && status_line.size() >= 12 && status_line.compare(0, 7, "HTTP/1.") == 0 &&
+           (status_line[9] == '2' || status_line[9] == '3');
+}
+
+void ReverseProxy::HealthCheckLoop()
+{
+    const bool probing = !m_options.health_check_path.empty();
+    const bool evaluating = m_options.outlier_interval.count() > 0;
+    auto next_probe = std::chrono::steady_clock::now();
+    auto next_evaluation = next_probe + m_options.outlier_interval;
+
+    std::unique_lock<std::mutex> lock(m_health_mutex);
+    while (!m_stopping)
+    {
+        lock.unlock();
+        if (probing && std::chrono::steady_clock::now() >= next_probe)
+        {
+            for (const auto& route : m_routes)
+            {
+                for (const auto& upstream : route->upstreams)
+                {
+                    if (Probe(*upstream))
+                    {
+                        upstream->fails = 0;
+                        if (++upstream->passes >= m_options.healthy_threshold && !upstream->healthy.load())
+                        {
+                            upstream->healthy.store(true);
+                            LOG_INFO_FMT(ReverseProxy, "Upstream {} is healthy again", upstream->address);
+                        }
+                        continue;
+                    }
+
+                    upstream->passes = 0;
+                    if (++upstream->fails >= m_options.unhealthy_threshold && upstream->healthy.load())
+                    {
+                        upstream->healthy.store(false);
+                        LOG_WARN_FMT(ReverseProxy, "Upstream {} failed {} health checks, removing it from rotation",
+                            upstream->address, upstream->fails);
+
+                        std::lock_guard<std::mutex> pool_lock(upstream->pool_mutex);
+                        for (const auto& connection : upstream->idle)
+                        {
+                            CloseSocketHandle(connection.socket);
+                        }
+                        upstream->idle.clear();
+                    }
+                }
+            }
+            next_probe = std::chrono::steady_clock::now() + m_options.health_check_interval;
+        }
+        if (evaluating && std::chrono::steady_clock::now() >= next_evaluation)
+        {
+            EvaluateOutliers();
+            next_evaluation = std::chrono::steady_clock::now() + m_options.outlier_interval;
+        }
+        lock.lock();
+
+        const auto wake = !probing ? next_evaluation : (!evaluating ? next_probe : std::min(next_probe, next_evaluation));
+        m_health_cv.wait_until(lock, wake, [this]() { return m_stopping; });
+    }
+}
+
+} // namespace miniserver::network
@@ -0,0 +1,282 @@
+/**
+ * @file reverse_proxy.hpp
+ * @brief Reverse proxy routing path prefixes to pooled upstream backends
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/socket_server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Upstream connection, retry and health check settings
+ */
+struct ReverseProxyOptions
+{
+    std::chrono::milliseconds connect_timeout{2000};            ///< TCP connect to an upstream
+    std::chrono::milliseconds io_timeout{30000};                ///< Longest wait for upstream or client bytes
+    size_t max_idle_connections = 32;                           ///< Idle keep-alive connections kept per upstream
+    std::chrono::milliseconds idle_timeout{60000};              ///< Idle connections older than this are closed
+    int max_retries = 2;                                        ///< Extra attempts on other upstreams for idempotent requests
+    size_t max_replay_body = 64 * 1024;                         ///< Bodies up to this size are buffered so they can be retried
+    std::string health_check_path = "/";                        ///< GET target probed on every upstream (empty disables)
+    std::chrono::milliseconds health_check_interval{5000};      ///< Time between probes
+    int healthy_threshold = 2;                                  ///< Consecutive passing probes that restore an upstream
+    int unhealthy_threshold = 3;                                ///< Consecutive failing probes that take an upstream out
+    int outlier_consecutive_failures = 5;                       ///< Failures in a row that eject an upstream (0 disables)
+    double outlier_error_rate = 0.5;                            ///< Error share (gateway errors and 5xx) that ejects (0 disables)
+    double outlier_latency_factor = 3.0;                        ///< Ejects when latency exceeds this multiple of the route median (0 disables)
+    std::chrono::milliseconds outlier_min_latency{5};           ///< Latencies below this are never outliers
+    uint64_t outlier_min_requests = 20;                         ///< Requests per interval needed to judge error rate
+    std::chrono::milliseconds outlier_interval{10000};          ///< Error rate and latency evaluation period
+    std::chrono::milliseconds base_ejection_time{30000};        ///< First ejection; repeat ejections last proportionally longer
+    int max_ejection_percent = 50;                              ///< Upper bound on ejected upstreams per route (at least one)
+};
+
+/**
+ * @brief Per-route forwarding policy
+ */
+struct ProxyRouteOptions
+{
+    bool strip_prefix = false;                                  ///< Remove the prefix from the forwarded path
+    double hedge_percentile = 0.0;                              ///< Hedge idempotent requests slower than this latency percentile (0 disables)
+    std::chrono::milliseconds hedge_min_delay{2};               ///< Never hedge earlier than this
+};
+
+/**
+ * @brief Snapshot of one upstream's counters
+ */
+struct UpstreamStats
+{
+    std::string address;            ///< host:port
+    bool healthy = true;            ///< Passing health checks
+    bool ejected = false;           ///< Temporarily ejected as an outlier
+    int64_t outstanding = 0;        ///< Requests in flight
+    uint64_t requests = 0;          ///< Requests sent (including retries and hedges)
+    uint64_t failures = 0;          ///< Connect, send or response failures
+    uint64_t connections = 0;       ///< Connections opened
+    uint64_t reused = 0;            ///< Requests served on a pooled connection
+    size_t idle = 0;                ///< Pooled idle connections
+    int64_t latency_us = 0;         ///< Smoothed time to response head
+    uint64_t ejections = 0;         ///< Times ejected as an outlier
+    uint64_t hedges = 0;            ///< Hedged duplicates sent to this upstream
+    uint64_t hedge_wins = 0;        ///< Hedged duplicates that answered first
+};
+
+/**
+ * @brief Snapshot of one route and its upstreams
+ */
+struct ProxyRouteStats
+{
+    std::string prefix;                     ///< Route prefix
+    int64_t hedge_delay_us = 0;             ///< Current hedge delay (0 while disabled or warming up)
+    uint64_t hedged = 0;                    ///< Requests that sent a hedge
+    std::vector<UpstreamStats> upstreams;   ///< Backends
+};
+
+/**
+ * @brief Reverse proxy and load balancer for local backends
+ *
+ * Requests whose path falls under a configured prefix are forwarded to one
+ * of the route's upstreams. The upstream with the fewest outstanding requests
+ * among the healthy ones is chosen; ties rotate. Each upstream keeps a pool of
+ * idle keep-alive connections (most recently used first) that are checked for
+ * a remote close before reuse.
+ *
+ * @details
+ * On HTTP/1.x connections request and response bodies are relayed in chunks
+ * as they arrive; neither is held in memory in full. Bodies up to
+ * max_replay_body are read before the first attempt so idempotent requests
+ * (GET, HEAD, PUT, DELETE, OPTIONS) can be retried on another upstream when
+ * a connection fails before any response byte reached the client; larger and
+ * chunked bodies are streamed and only retried if connecting failed.
+ * A background thread probes every upstream with GET health_check_path and
+ * takes it out of rotation after unhealthy_threshold failed probes.
+ *
+ * Tail latency: a route with hedge_percentile set sends a duplicate of a
+ * replayable idempotent request to a second upstream when the first has not
+ * answered within that percentile of recent response times; the first
+ * response head wins and the other connection is closed. Outlier detection
+ * ejects an upstream for a growing period after consecutive failures, or when
+ * its error rate or smoothed latency stands out from the rest of its route.
+ */
+class ReverseProxy
+{
+public:
+    /**
+     * @brief Constructor
+     * @param options Connection, retry and health check settings
+     */
+    explicit ReverseProxy(const ReverseProxyOptions& options = {});
+
+    /**
+     * @brief Destructor (stops health checks, closes pooled connections)
+     */
+    ~ReverseProxy();
+
+    ReverseProxy(const ReverseProxy&) = delete;
+    ReverseProxy& operator=(const ReverseProxy&) = delete;
+
+    /**
+     * @brief Replace the settings (before Start)
+     * @param options Connection, retry and health check settings
+     */
+    void SetOptions(const ReverseProxyOptions& options);
+
+    /**
+     * @brief Forward a path prefix to a set of upstreams (before Start)
+     * @param prefix Path prefix such as "/api" (matches "/api" and "/api/...")
+     * @param upstreams Backend addresses as "host:port" (IPv4 or a resolvable name)
+     * @param strip_prefix Remove the prefix from the forwarded path
+     * @return false if the prefix is invalid or taken, or an address cannot be resolved
+     */
+    bool AddRoute(const std::string& prefix, const std::vector<std::string>& upstreams, bool strip_prefix = false);
+
+    /**
+     * @brief Forward a path prefix to a set of upstreams with a route policy (before Start)
+     * @param prefix Path prefix such as "/api"
+     * @param upstreams Backend addresses as "host:port"
+     * @param options Prefix stripping and hedging
+     * @return false if the prefix is invalid or taken, or an address cannot be resolved
+     */
+    bool AddRoute(const std::string& prefix, const std::vector<std::string>& upstreams,
+                  const ProxyRouteOptions& options);
+
+    /**
+     * @brief Check whether any route is configured
+     */
+    bool HasRoutes() const { return !m_routes.empty(); }
+
+    /**
+     * @brief Check whether a path is forwarded
+     * @param path Request path (without query)
+     */
+    bool Matches(std::string_view path) const;
+
+    /**
+     * @brief Start health checks and outlier evaluation
+     */
+    void Start();
+
+    /**
+     * @brief Stop background checks and close idle connections
+     */
+    void Stop();
+
+    /**
+     * @brief Proxy an HTTP/1.x request, streaming both bodies
+     * @param client_socket Client connection
+     * @param buffer Receive buffer starting with the request head; on success
+     *        the head and body are consumed and pipelined bytes are left in place
+     * @param head_size Length of the head including the blank line
+     * @param client_ip Peer address (appended to X-Forwarded-For)
+     * @return Declined (buffer untouched) if no route matches or the request
+     *         asks for a protocol upgrade, else whether the connection stays open
+     */
+    PassthroughResult Serve(SOCKET client_socket, std::string& buffer, size_t head_size,
+                            const std::string& client_ip);
+
+    /**
+     * @brief Proxy a complete request and return the complete response
+     * @param request_data Raw request with a Content-Length body (as built for HTTP/2 streams)
+     * @return Serialized response with Content-Length (502/503/504 on failure)
+     */
+    std::string Forward(const std::string& request_data);
+
+    /**
+     * @brief Counters for every route and upstream
+     */
+    std::vector<ProxyRouteStats> GetStats() const;
+
+private:
+    struct Upstream;
+    struct Route;
+    struct RequestHead;
+    class Downstream;
+    class Attempt;
+
+    /**
+     * @brief Longest-prefix route for a path, or nullptr
+     */
+    Route* FindRoute(std::string_view path) const;
+
+    /**
+     * @brief Forward one request on a route, retrying on other upstreams
+     * @return true if the downstream connection can stay open
+     */
+    bool Exchange(Route& route, RequestHead& request, Downstream& downstream);
+
+    /**
+     * @brief Healthy, non-ejected upstream with the fewest outstanding requests, skipping tried ones
+     */
+    Upstream* PickUpstream(Route& route, const std::vector<Upstream*>& tried);
+
+    /**
+     * @brief Connect and send the request head (and buffered body)
+     * @return false if the upstream could not be reached (the failure is recorded)
+     */
+    bool Launch(Route& route, Attempt& attempt, const std::string& request_data);
+
+    /**
+     * @brief Feed one attempt's result into outlier detection and the hedge delay
+     * @param success Valid response below 500
+     * @param latency Time to the response head (successful attempts)
+     */
+    void RecordOutcome(Route& route, Upstream& upstream, bool success, std::chrono::microseconds latency);
+
+    /**
+     * @brief Eject an upstream unless the route's ejection budget is spent
+     */
+    void Eject(Route& route, Upstream& upstream, const char* reason);
+
+    /**
+     * @brief Compare each upstream's error rate and latency with its route
+     */
+    void EvaluateOutliers();
+
+    /**
+     * @brief Take a pooled connection or open a new one
+     * @param reused Set when the connection came from the pool
+     */
+    SOCKET Acquire(Upstream& upstream, bool& reused);
+
+    /**
+     * @brief Return a connection to the pool or close it
+     */
+    void Release(Upstream& upstream, SOCKET socket, bool reusable);
+
+    /**
+     * @brief Probe one upstream with GET health_check_path
+     */
+    bool Probe(Upstream& upstream);
+
+    /**
+     * @brief Background thread: health probes and outlier evaluation
+     */
+    void HealthCheckLoop();
+
+    ReverseProxyOptions m_options;                      ///< Settings
+    std::vector<std::unique_ptr<Route>> m_routes;       ///< Routes, longest prefix first
+    std::thread m_health_thread;                        ///< Health checker
+    std::mutex m_health_mutex;                          ///< Guards m_stopping for the health checker
+    std::condition_variable m_health_cv;                ///< Wakes the health checker on Stop
+    bool m_stopping = false;                            ///< Health checker exit flag
+    std::atomic<bool> m_running{false};                 ///< Started
+};
+
+} // namespace miniserver::network
@@ -0,0 +1,517 @@
+/**
+ * @file shm_channel.cpp
+ * @brief Shared-memory ring and client implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/shm_channel.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <climits>
+    #include <linux/futex.h>
+    #include <poll.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+    constexpr uint32_t kWrapMarker = 0xffffffffu;   ///< Rest of the data area is unused; continue at the start
+    constexpr size_t kSegmentHeader = 64;           ///< Segment header size (keeps the rings cache-line aligned)
+    constexpr std::chrono::milliseconds kLivenessInterval{100}; ///< Sleep between checks that the peer is alive
+
+    /**
+     * @brief First bytes of a channel segment
+     */
+    struct SegmentHeader
+    {
+        uint32_t magic;             ///< ShmChannelLayout::kMagic
+        uint32_t reserved;          ///< Zero
+        uint64_t ring_capacity;     ///< Data bytes per ring
+    };
+
+    size_t Align8(size_t size)
+    {
+        return (size + 7) & ~size_t(7);
+    }
+
+    /**
+     * @brief Hint to the CPU that this is a spin-wait loop
+     */
+    inline void CpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    void AppendUint32(std::string& output, uint32_t value)
+    {
+        char bytes[4];
+        std::memcpy(bytes, &value, sizeof(value));
+        output.append(bytes, sizeof(bytes));
+    }
+
+    bool ReadUint32(std::string_view& input, uint32_t& value)
+    {
+        if (input.size() < sizeof(value))
+        {
+            return false;
+        }
+        std::memcpy(&value, input.data(), sizeof(value));
+        input.remove_prefix(sizeof(value));
+        return true;
+    }
+
+#if defined(__linux__)
+    /**
+     * @brief Sleep while *word == expected (shared futex: the word may live in another process's mapping too)
+     */
+    void FutexWait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::milliseconds timeout)
+    {
+        timespec relative;
+        relative.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+        relative.tv_nsec = static_cast<long>((timeout.count() % 1000) * 1000000);
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &relative, nullptr, 0);
+    }
+
+    void FutexWake(std::atomic<uint32_t>& word)
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    /**
+     * @brief Fill a sockaddr_un; a leading '@' selects the abstract namespace
+     */
+    bool MakeAddress(const std::string& path, sockaddr_un& address, socklen_t& length)
+    {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            return false;
+        }
+        std::memcpy(address.sun_path, path.data(), path.size());
+        length = sizeof(address);
+        if (path.front() == '@')
+        {
+            address.sun_path[0] = '\0';
+            length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+        }
+        return true;
+    }
+#endif
+}
+
+namespace shm
+{
+    void EncodeRequest(const ShmRequest& request, std::string& output)
+    {
+        output.reserve(output.size() + 8 + request.service.size() + request.content_type.size() + request.body.size());
+        AppendUint32(output, static_cast<uint32_t>(request.service.size()));
+        AppendUint32(output, static_cast<uint32_t>(request.content_type.size()));
+        output += request.service;
+        output += request.content_type;
+        output += request.body;
+    }
+
+    bool DecodeRequest(std::string_view message, ShmRequest& request)
+    {
+        uint32_t service_size = 0;
+        uint32_t type_size = 0;
+        if (!ReadUint32(message, service_size) || !ReadUint32(message, type_size) ||
+            message.size() < static_cast<size_t>(service_size) + type_size)
+        {
+            return false;
+        }
+        request.service.assign(message.data(), service_size);
+        request.content_type.assign(message.data() + service_size, type_size);
+        message.remove_prefix(static_cast<size_t>(service_size) + type_size);
+        request.body.assign(message.data(), message.size());
+        return true;
+    }
+
+    void EncodeResponse(const ShmResponse& response, std::string& output)
+    {
+        output.reserve(output.size() + 8 + response.content_type.size() + response.body.size());
+        AppendUint32(output, static_cast<uint32_t>(response.status));
+        AppendUint32(output, static_cast<uint32_t>(response.content_type.size()));
+        output += response.content_type;
+        output += response.body;
+    }
+
+    bool DecodeResponse(std::string_view message, ShmResponse& response)
+    {
+        uint32_t status = 0;
+        uint32_t type_size = 0;
+        if (!ReadUint32(message, status) || !ReadUint32(message, type_size) || message.size() < type_size)
+        {
+            return false;
+        }
+        response.status = static_cast<int>(status);
+        response.content_type.assign(message.data(), type_size);
+        message.remove_prefix(type_size);
+        response.body.assign(message.data(), message.size());
+        return true;
+    }
+
+    int DefaultSpinIterations()
+    {
+        return std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+    }
+} // namespace shm
+
+// -----------------------------------------------------------------------------
+// ShmRing
+// -----------------------------------------------------------------------------
+
+struct ShmRing::Header
+{
+    alignas(64) std::atomic<uint64_t> tail;         ///< Bytes ever written (producer)
+    alignas(64) std::atomic<uint64_t> head;         ///< Bytes ever consumed (consumer)
+    alignas(64) std::atomic<uint32_t> sequence;     ///< Futex word, bumped on every write
+    std::atomic<uint32_t> sleepers;                 ///< Readers inside FutexWait
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared-memory rings need address-free atomics");
+
+size_t ShmRing::Footprint(size_t capacity)
+{
+    return sizeof(Header) + capacity;
+}
+
+ShmRing::ShmRing(void* memory, size_t capacity)
+    : m_header(static_cast<Header*>(memory))
+    , m_data(static_cast<char*>(memory) + sizeof(Header))
+    , m_capacity(capacity)
+{
+}
+
+void ShmRing::Initialize()
+{
+    new (m_header) Header();
+    m_header->tail.store(0);
+    m_header->head.store(0);
+    m_header->sequence.store(0);
+    m_header->sleepers.store(0);
+}
+
+size_t ShmRing::MaxMessageSize() const
+{
+    // Half the ring: a message that has to wrap still fits behind the marker
+    return m_capacity / 2 - 8;
+}
+
+bool ShmRing::Write(std::string_view message)
+{
+    if (message.size() > MaxMessageSize())
+    {
+        return false;
+    }
+    const size_t need = Align8(sizeof(uint32_t) + message.size());
+    uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+    const uint64_t head = m_header->head.load(std::memory_order_acquire);
+    size_t offset = static_cast<size_t>(tail % m_capacity);
+    const size_t contiguous = m_capacity - offset;
+    const size_t total = contiguous < need ? contiguous + need : need;
+    if (m_capacity - static_cast<size_t>(tail - head) < total)
+    {
+        return false;
+    }
+
+    if (contiguous < need)
+    {
+        std::memcpy(m_data + offset, &kWrapMarker, sizeof(kWrapMarker));
+        tail += contiguous;
+        offset = 0;
+    }
+    const uint32_t length = static_cast<uint32_t>(message.size());
+    std::memcpy(m_data + offset, &length, sizeof(length));
+    std::memcpy(m_data + offset + sizeof(length), message.data(), message.size());
+
+    // Publish, then wake only if the reader went to sleep (seq_cst pairs with WaitReadable)
+    m_header->tail.store(tail + need, std::memory_order_seq_cst);
+    m_header->sequence.fetch_add(1, std::memory_order_seq_cst);
+#if defined(__linux__)
+    if (m_header->sleepers.load(std::memory_order_seq_cst) != 0)
+    {
+        FutexWake(m_header->sequence);
+    }
+#endif
+    return true;
+}
+
+bool ShmRing::Read(std::string& message)
+{
+    uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    const uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+    if (m_corrupt || head == tail)
+    {
+        return false;
+    }
+
+    // Both positions live in memory the peer can write: check everything before copying
+    const uint64_t published = tail - head;
+    size_t offset = static_cast<size_t>(head % m_capacity);
+    if (published > m_capacity || offset % 8 != 0)
+    {
+        m_corrupt = true;
+        return false;
+    }
+    uint32_t length;
+    std::memcpy(&length, m_data + offset, sizeof(length));
+    if (length == kWrapMarker)
+    {
+        if (published < m_capacity - offset)
+        {
+            m_corrupt = true;
+            return false;
+        }
+        head += m_capacity - offset;
+        offset = 0;
+        std::memcpy(&length, m_data, sizeof(length));
+    }
+    const size_t need = Align8(sizeof(length) + static_cast<size_t>(length));
+    if (length > MaxMessageSize() || offset + need > m_capacity || head + need > tail)
+    {
+        m_corrupt = true;
+        return false;
+    }
+    message.assign(m_data + offset + sizeof(length), length);
+    m_header->head.store(head + need, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::WaitReadable(int spin_iterations, std::chrono::milliseconds timeout)
+{
+    const auto readable = [this]()
+    {
+        return m_header->head.load(std::memory_order_relaxed) != m_header->tail.load(std::memory_order_seq_cst);
+    };
+    for (int i = 0; i < spin_iterations; ++i)
+    {
+        if (readable())
+        {
+            return true;
+        }
+        CpuRelax();
+    }
+
+#if defined(__linux__)
+    // Read the futex word before announcing ourselves: a write after this point
+    // either changes the word (the wait returns at once) or sees the sleeper
+    const uint32_t sequence = m_header->sequence.load(std::memory_order_seq_cst);
+    m_header->sleepers.fetch_add(1, std::memory_order_seq_cst);
+    bool ready = readable();
+    if (!ready)
+    {
+        FutexWait(m_header->sequence, sequence, timeout);
+        ready = readable();
+    }
+    m_header->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    return ready;
+#else
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!readable() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+    return readable();
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// ShmChannelLayout
+// -----------------------------------------------------------------------------
+
+size_t ShmChannelLayout::SegmentSize(size_t ring_capacity)
+{
+    return kSegmentHeader + 2 * ShmRing::Footprint(ring_capacity);
+}
+
+size_t ShmChannelLayout::RequestRingOffset()
+{
+    return kSegmentHeader;
+}
+
+size_t ShmChannelLayout::ResponseRingOffset(size_t ring_capacity)
+{
+    return kSegmentHeader + ShmRing::Footprint(ring_capacity);
+}
+
+// -----------------------------------------------------------------------------
+// ShmClient
+// -----------------------------------------------------------------------------
+
+ShmClient::~ShmClient()
+{
+    Close();
+}
+
+bool ShmClient::Connect(const std::string& path)
+{
+    Close();
+#if defined(__linux__)
+    sockaddr_un address;
+    socklen_t address_len = 0;
+    if (!MakeAddress(path, address, address_len))
+    {
+        return false;
+    }
+    m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_socket < 0 || connect(m_socket, reinterpret_cast<sockaddr*>(&address), address_len) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    // The server answers with one byte carrying the segment's memfd
+    timeval timeout{5, 0};
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    char byte = 0;
+    iovec iov{&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t received;
+    do
+    {
+        received = recvmsg(m_socket, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    cmsghdr* header = received == 1 ? CMSG_FIRSTHDR(&message) : nullptr;
+    if (!header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+    {
+        Close();
+        return false;
+    }
+    int memory_fd;
+    std::memcpy(&memory_fd, CMSG_DATA(header), sizeof(memory_fd));
+
+    struct stat info;
+    void* segment = MAP_FAILED;
+    if (fstat(memory_fd, &info) == 0 && static_cast<size_t>(info.st_size) >= kSegmentHeader)
+    {
+        segment = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd, 0);
+    }
+    close(memory_fd);
+    if (segment == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    m_segment = segment;
+    m_segment_size = static_cast<size_t>(info.st_size);
+
+    SegmentHeader layout;
+    std::memcpy(&layout, m_segment, sizeof(layout));
+    m_ring_capacity = static_cast<size_t>(layout.ring_capacity);
+    if (layout.magic != ShmChannelLayout::kMagic || m_ring_capacity % 8 != 0 ||
+        ShmChannelLayout::SegmentSize(m_ring_capacity) != m_segment_size)
+    {
+        Close();
+        return false;
+    }
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+std::optional<ShmResponse> ShmClient::Call(const ShmRequest& request, std::chrono::milliseconds timeout)
+{
+    if (!m_segment)
+    {
+        return std::nullopt;
+    }
+    char* base = static_cast<char*>(m_segment);
+    ShmRing requests(base + ShmChannelLayout::RequestRingOffset(), m_ring_capacity);
+    ShmRing responses(base + ShmChannelLayout::ResponseRingOffset(m_ring_capacity), m_ring_capacity);
+
+    m_message.clear();
+    shm::EncodeRequest(request, m_message);
+    if (!requests.Write(m_message))
+    {
+        return std::nullopt;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!responses.Read(m_message))
+    {
+        if (responses.IsCorrupt())
+        {
+            Close();
+            return std::nullopt;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            Close();    // A late response would be taken for the next call's
+            return std::nullopt;
+        }
+        if (responses.WaitReadable(m_spin_iterations,
+                std::min(kLivenessInterval, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now) +
+                                            std::chrono::milliseconds(1))))
+        {
+            continue;
+        }
+#if defined(__linux__)
+        // Quiet for a while: make sure the server still holds its end
+        pollfd entry{m_socket, POLLIN, 0};
+        char byte;
+        if (poll(&entry, 1, 0) > 0 && recv(m_socket, &byte, 1, MSG_PEEK | MSG_DONTWAIT) <= 0)
+        {
+            Close();
+            return std::nullopt;
+        }
+#endif
+    }
+
+    ShmResponse response;
+    if (!shm::DecodeResponse(m_message, response))
+    {
+        Close();
+        return std::nullopt;
+    }
+    return response;
+}
+
+void ShmClient::Close()
+{
+#if defined(__linux__)
+    if (m_segment)
+    {
+        munmap(m_segment, m_segment_size);
+    }
+    if (m_socket >= 0)
+    {
+        close(m_socket);
+    }
+#endif
+    m_segment = nullptr;
+    m_segment_size = 0;
+    m_ring_capacity = 0;
+    m_socket = -1;
+}
+
+} // namespace miniserver::network
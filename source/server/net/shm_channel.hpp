@@ -0,0 +1,233 @@
+/**
+ * @file shm_channel.hpp
+ * @brief Shared-memory request/response channel for same-host service calls
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Service call sent over a shared-memory channel
+ */
+struct ShmRequest
+{
+    std::string service;        ///< Registered service name (as in /service/<name>)
+    std::string content_type;   ///< Body media type (may be empty)
+    std::string body;           ///< Request body
+};
+
+/**
+ * @brief Reply to a ShmRequest
+ */
+struct ShmResponse
+{
+    int status = 200;           ///< HTTP status code
+    std::string content_type;   ///< Body media type
+    std::string body;           ///< Response body
+};
+
+namespace shm
+{
+    /**
+     * @brief Append a request in channel wire format
+     */
+    void EncodeRequest(const ShmRequest& request, std::string& output);
+
+    /**
+     * @brief Parse a request in channel wire format
+     * @return false if the message is truncated
+     */
+    bool DecodeRequest(std::string_view message, ShmRequest& request);
+
+    /**
+     * @brief Append a response in channel wire format
+     */
+    void EncodeResponse(const ShmResponse& response, std::string& output);
+
+    /**
+     * @brief Parse a response in channel wire format
+     * @return false if the message is truncated
+     */
+    bool DecodeResponse(std::string_view message, ShmResponse& response);
+
+    /**
+     * @brief Spin iterations before sleeping: none on a single CPU, where spinning only delays the peer
+     */
+    int DefaultSpinIterations();
+} // namespace shm
+
+/**
+ * @brief Single-producer single-consumer message ring in shared memory
+ *
+ * A view over memory laid out as a header (producer and consumer positions on
+ * separate cache lines, plus a futex word) followed by `capacity` bytes of
+ * data. Messages are stored with a 4-byte length prefix, 8-byte aligned; a
+ * message that would cross the end of the data area is preceded by a wrap
+ * marker and stored at the start. Positions only grow, so the ring never has
+ * to tell "full" from "empty".
+ *
+ * @details
+ * Exactly one thread (in any process) may write and one may read. A reader
+ * with nothing to read spins for a while, then sleeps on the futex word; a
+ * writer only makes the wake-up system call when a reader is asleep.
+ */
+class ShmRing
+{
+public:
+    /**
+     * @brief Bytes of shared memory needed for a ring
+     * @param capacity Data area size (a multiple of 8)
+     */
+    static size_t Footprint(size_t capacity);
+
+    /**
+     * @brief Attach to a ring
+     * @param memory Start of the ring (Footprint(capacity) bytes, 64-byte aligned)
+     * @param capacity Data area size
+     */
+    ShmRing(void* memory, size_t capacity);
+
+    /**
+     * @brief Reset positions (creator only, before the peer attaches)
+     */
+    void Initialize();
+
+    /**
+     * @brief Largest message the ring accepts
+     */
+    size_t MaxMessageSize() const;
+
+    /**
+     * @brief Append one message and wake a sleeping reader
+     * @return false if the message is larger than MaxMessageSize() or there is no room
+     */
+    bool Write(std::string_view message);
+
+    /**
+     * @brief Take the next message
+     * @param message Receives the payload
+     * @return false if the ring is empty or corrupt (see IsCorrupt)
+     */
+    bool Read(std::string& message);
+
+    /**
+     * @brief Check whether Read found positions or a length outside the ring
+     * @return true once the peer broke the protocol; the channel must be closed
+     */
+    bool IsCorrupt() const { return m_corrupt; }
+
+    /**
+     * @brief Wait until a message is available
+     * @param spin_iterations Busy-wait checks before sleeping
+     * @param timeout Longest sleep
+     * @return true if a message is available
+     */
+    bool WaitReadable(int spin_iterations, std::chrono::milliseconds timeout);
+
+private:
+    struct Header;
+
+    Header* m_header;       ///< Positions and futex word
+    char* m_data;           ///< Data area
+    size_t m_capacity;      ///< Data area size
+    bool m_corrupt = false; ///< Read rejected the shared positions or a length
+};
+
+/**
+ * @brief Shared memory layout of one channel: requests toward the server, responses back
+ */
+struct ShmChannelLayout
+{
+    static constexpr uint32_t kMagic = 0x4d534831;  ///< "MSH1"
+
+    /**
+     * @brief Segment size for a given ring capacity
+     */
+    static size_t SegmentSize(size_t ring_capacity);
+
+    /**
+     * @brief Offset of the request ring
+     */
+    static size_t RequestRingOffset();
+
+    /**
+     * @brief Offset of the response ring
+     */
+    static size_t ResponseRingOffset(size_t ring_capacity);
+};
+
+/**
+ * @brief Client side of a shared-memory channel
+ *
+ * Connects to the server's Unix domain socket, receives a memfd holding the
+ * two rings, and then exchanges calls without touching a socket. The socket
+ * stays open only so each side notices when the other goes away.
+ *
+ * @details One call at a time; use one client per thread.
+ */
+class ShmClient
+{
+public:
+    ShmClient() = default;
+
+    /**
+     * @brief Unmaps the segment and closes the socket
+     */
+    ~ShmClient();
+
+    ShmClient(const ShmClient&) = delete;
+    ShmClient& operator=(const ShmClient&) = delete;
+
+    /**
+     * @brief Attach to a server
+     * @param path Socket path, or abstract name with a leading '@'
+     * @return false if the server cannot be reached or sent an invalid segment
+     */
+    bool Connect(const std::string& path);
+
+    /**
+     * @brief Call a service and wait for its response
+     * @param request Service call
+     * @param timeout Longest wait for the response
+     * @return Response, or nullopt on timeout, oversized messages or a lost server
+     */
+    std::optional<ShmResponse> Call(const ShmRequest& request,
+                                    std::chrono::milliseconds timeout = std::chrono::milliseconds(30000));
+
+    /**
+     * @brief Detach from the server
+     */
+    void Close();
+
+    /**
+     * @brief Check whether the client is attached
+     */
+    bool IsConnected() const { return m_segment != nullptr; }
+
+    /**
+     * @brief Set busy-wait checks before sleeping for a response
+     */
+    void SetSpinIterations(int spin_iterations) { m_spin_iterations = spin_iterations; }
+
+private:
+    int m_socket = -1;                                  ///< Control socket (liveness)
+    void* m_segment = nullptr;                          ///< Mapped channel
+    size_t m_segment_size = 0;                          ///< Mapping length
+    size_t m_ring_capacity = 0;                         ///< Data bytes per ring
+    int m_spin_iterations = shm::DefaultSpinIterations(); ///< Busy-wait checks before sleeping
+    std::string m_message;                              ///< Reused encode/decode buffer
+};
+
+} // namespace miniserver::network
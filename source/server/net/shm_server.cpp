@@ -0,0 +1,265 @@
+/**
+ * @file shm_server.cpp
+ * @brief Shared-memory transport server implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/shm_server.hpp"
+#include "utils/logger.hpp"
+
+#include <cstring>
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <poll.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+    constexpr std::chrono::milliseconds kLivenessInterval{100}; ///< Sleep between checks that the client is alive
+    constexpr size_t kMinRingCapacity = 4096;                   ///< Smallest accepted ring
+
+#if defined(__linux__)
+    /**
+     * @brief Check whether the client closed its end of the handshake socket
+     */
+    bool PeerClosed(SOCKET socket)
+    {
+        pollfd entry{socket, POLLIN, 0};
+        char byte;
+        return poll(&entry, 1, 0) > 0 && recv(socket, &byte, 1, MSG_PEEK | MSG_DONTWAIT) <= 0;
+    }
+
+    /**
+     * @brief Pass a file descriptor with a one-byte message
+     */
+    bool SendDescriptor(SOCKET socket, int descriptor)
+    {
+        char byte = 1;
+        iovec iov{&byte, 1};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        std::memset(control, 0, sizeof(control));
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(header), &descriptor, sizeof(descriptor));
+        return sendmsg(socket, &message, MSG_NOSIGNAL) == 1;
+    }
+#endif
+}
+
+ShmServer::ShmServer(ShmHandler handler)
+    : m_handler(std::move(handler))
+{
+}
+
+ShmServer::~ShmServer()
+{
+    Stop();
+}
+
+bool ShmServer::Start(const ShmServerOptions& options)
+{
+#if defined(__linux__)
+    if (m_running.load() || options.socket.path.empty() || !m_handler)
+    {
+        return false;
+    }
+    m_options = options;
+    m_options.ring_capacity = std::max(kMinRingCapacity, (options.ring_capacity + 7) & ~size_t(7));
+    if (m_options.spin_iterations < 0)
+    {
+        m_options.spin_iterations = shm::DefaultSpinIterations();
+    }
+
+    m_listener = SocketServer::OpenLocalListener(m_options.socket);
+    if (m_listener == INVALID_SOCKET)
+    {
+        return false;
+    }
+    m_running.store(true);
+    m_accept_thread = std::thread(&ShmServer::AcceptLoop, this);
+    LOG_INFO_FMT(ShmServer, "Shared-memory transport on {}{} ({} KiB rings)",
+        m_options.socket.abstract ? "@" : "", m_options.socket.path, m_options.ring_capacity / 1024);
+    return true;
+#else
+    (void)options;
+    LOG_ERROR(ShmServer, "Shared-memory transport needs Linux (memfd, futex)");
+    return false;
+#endif
+}
+
+void ShmServer::Stop()
+{
+#if defined(__linux__)
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    // Shutting the listener down wakes accept()
+    shutdown(m_listener, SHUT_RDWR);
+    if (m_accept_thread.joinable())
+    {
+        m_accept_thread.join();
+    }
+    close(m_listener);
+    m_listener = INVALID_SOCKET;
+    if (!m_options.socket.abstract)
+    {
+        unlink(m_options.socket.path.c_str());
+    }
+
+    // Channel threads notice m_running within one liveness interval
+    std::unique_lock<std::mutex> lock(m_channels_mutex);
+    m_channels_cv.wait(lock, [this]() { return m_channels.load() == 0; });
+#endif
+}
+
+void ShmServer::AcceptLoop()
+{
+#if defined(__linux__)
+    while (m_running.load())
+    {
+        const SOCKET client_socket = accept4(m_listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_socket == INVALID_SOCKET)
+        {
+            if (errno != EINTR && errno != ECONNABORTED && m_running.load())
+            {
+                LOG_ERROR_FMT(ShmServer, "Accept failed: {}", std::strerror(errno));
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+        if (m_channels.load() >= m_options.max_channels)
+        {
+            LOG_WARN_FMT(ShmServer, "Refusing client: {} channels open", m_channels.load());
+            close(client_socket);
+            continue;
+        }
+
+        m_channels.fetch_add(1);
+        std::thread([this, client_socket]()
+        {
+            ServeChannel(client_socket);
+            std::lock_guard<std::mutex> lock(m_channels_mutex);
+            m_channels.fetch_sub(1);
+            m_channels_cv.notify_all();
+        }).detach();
+    }
+#endif
+}
+
+void ShmServer::ServeChannel(SOCKET client_socket)
+{
+#if defined(__linux__)
+    const size_t capacity = m_options.ring_capacity;
+    const size_t segment_size = ShmChannelLayout::SegmentSize(capacity);
+    const int memory_fd = memfd_create("mini-server-shm", MFD_CLOEXEC);
+    void* segment = MAP_FAILED;
+    if (memory_fd >= 0 && ftruncate(memory_fd, static_cast<off_t>(segment_size)) == 0)
+    {
+        segment = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd, 0);
+    }
+    if (segment == MAP_FAILED)
+    {
+        LOG_ERROR_FMT(ShmServer, "Cannot create channel segment: {}", std::strerror(errno));
+        if (memory_fd >= 0)
+        {
+            close(memory_fd);
+        }
+        close(client_socket);
+        return;
+    }
+
+    char* base = static_cast<char*>(segment);
+    ShmRing requests(base + ShmChannelLayout::RequestRingOffset(), capacity);
+    ShmRing responses(base + ShmChannelLayout::ResponseRingOffset(capacity), capacity);
+    requests.Initialize();
+    responses.Initialize();
+    const uint32_t magic = ShmChannelLayout::kMagic;
+    const uint64_t ring_capacity = capacity;
+    std::memcpy(base, &magic, sizeof(magic));
+    std::memcpy(base + 8, &ring_capacity, sizeof(ring_capacity));
+
+    const bool handed_over = SendDescriptor(client_socket, memory_fd);
+    close(memory_fd);
+    if (handed_over)
+    {
+        LOG_DEBUG(ShmServer, "Channel opened");
+    }
+
+    std::string message;
+    std::string reply;
+    ShmRequest request;
+    while (handed_over && m_running.load())
+    {
+        if (!requests.WaitReadable(m_options.spin_iterations, kLivenessInterval))
+        {
+            if (PeerClosed(client_socket))
+            {
+                break;
+            }
+            continue;
+        }
+
+        while (requests.Read(message))
+        {
+            ShmResponse response;
+            if (!shm::DecodeRequest(message, request))
+            {
+                response.status = 400;
+                response.body = "Malformed request";
+            }
+            else
+            {
+                try
+                {
+                    response = m_handler(request);
+                }
+                catch (const std::exception& e)
+                {
+                    LOG_ERROR_FMT(ShmServer, "Handler failed for '{}': {}", request.service, e.what());
+                    response = ShmResponse{500, "text/plain", "Internal service error"};
+                }
+            }
+
+            reply.clear();
+            shm::EncodeResponse(response, reply);
+            if (reply.size() > responses.MaxMessageSize())
+            {
+                reply.clear();
+                shm::EncodeResponse(ShmResponse{500, "text/plain", "Response exceeds the ring size"}, reply);
+            }
+            responses.Write(reply);
+            m_calls.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (requests.IsCorrupt())
+        {
+            LOG_WARN(ShmServer, "Corrupt request ring; closing the channel");
+            break;
+        }
+    }
+
+    munmap(segment, segment_size);
+    close(client_socket);
+    LOG_DEBUG(ShmServer, "Channel closed");
+#else
+    (void)client_socket;
+#endif
+}
+
+} // namespace miniserver::network
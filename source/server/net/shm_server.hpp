@@ -0,0 +1,116 @@
+/**
+ * @file shm_server.hpp
+ * @brief Shared-memory transport serving service calls from same-host clients
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/shm_channel.hpp"
+#include "net/socket_server.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Shared-memory transport settings
+ */
+struct ShmServerOptions
+{
+    LocalSocketOptions socket;                  ///< Handshake socket (path or abstract name)
+    size_t ring_capacity = 1024 * 1024;         ///< Data bytes per ring (messages up to half of it)
+    int spin_iterations = -1;                   ///< Busy-wait checks before sleeping (-1: automatic)
+    size_t max_channels = 64;                   ///< Concurrent clients
+};
+
+/**
+ * @brief Service call handler
+ */
+using ShmHandler = std::function<ShmResponse(const ShmRequest& request)>;
+
+/**
+ * @brief Serves ShmClient channels
+ *
+ * Each client that connects to the handshake socket gets its own memfd
+ * segment holding a request ring and a response ring, passed over the socket
+ * with SCM_RIGHTS, and a thread that waits on the request ring and answers
+ * with the handler. After the handshake no socket I/O happens per call.
+ *
+ * @details Linux only (memfd, futex); Start() fails elsewhere.
+ */
+class ShmServer
+{
+public:
+    /**
+     * @brief Constructor
+     * @param handler Called for every request on every channel
+     */
+    explicit ShmServer(ShmHandler handler);
+
+    /**
+     * @brief Destructor (stops the server)
+     */
+    ~ShmServer();
+
+    ShmServer(const ShmServer&) = delete;
+    ShmServer& operator=(const ShmServer&) = delete;
+
+    /**
+     * @brief Listen for clients
+     * @param options Socket and ring settings
+     * @return false if the socket cannot be bound or the platform lacks memfd
+     */
+    bool Start(const ShmServerOptions& options);
+
+    /**
+     * @brief Stop accepting, end every channel and wait for their threads
+     */
+    void Stop();
+
+    /**
+     * @brief Check whether the server is listening
+     */
+    bool IsRunning() const { return m_running.load(); }
+
+    /**
+     * @brief Open channels
+     */
+    size_t GetChannelCount() const { return m_channels.load(); }
+
+    /**
+     * @brief Calls answered since Start
+     */
+    uint64_t GetCallCount() const { return m_calls.load(); }
+
+private:
+    /**
+     * @brief Accept handshake connections until Stop
+     */
+    void AcceptLoop();
+
+    /**
+     * @brief Create a channel for one client and answer its calls
+     * @param client_socket Handshake connection (closed on return)
+     */
+    void ServeChannel(SOCKET client_socket);
+
+    ShmHandler m_handler;                       ///< Service call handler
+    ShmServerOptions m_options;                 ///< Settings
+    SOCKET m_listener = INVALID_SOCKET;         ///< Handshake socket
+    std::thread m_accept_thread;                ///< Runs AcceptLoop
+    std::atomic<bool> m_running{false};         ///< Listening
+    std::atomic<size_t> m_channels{0};          ///< Open channels
+    std::atomic<uint64_t> m_calls{0};           ///< Calls answered
+    std::mutex m_channels_mutex;                ///< Guards channel exit notification
+    std::condition_variable m_channels_cv;      ///< Signals the last channel thread exiting
+};
+
+} // namespace miniserver::network
@@ -0,0 +1,184 @@
+/**
+ * @file socket_activation.cpp
+ * @brief Socket activation implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/socket_activation.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <cstddef>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace activation
+{
+
+std::vector<ActivatedListener> FromEnvironment()
+{
+    std::vector<ActivatedListener> listeners;
+#ifndef _WIN32
+    const char* pid = std::getenv("LISTEN_PID");
+    const char* count = std::getenv("LISTEN_FDS");
+    const std::string names = std::getenv("LISTEN_FDNAMES") ? std::getenv("LISTEN_FDNAMES") : "";
+    const bool ours = pid && count && std::strtol(pid, nullptr, 10) == static_cast<long>(getpid());
+    const int descriptors = ours ? std::atoi(count) : 0;
+
+    // Children must not mistake the variables for their own
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+    unsetenv("LISTEN_FDNAMES");
+
+    size_t name_start = 0;
+    for (int i = 0; i < descriptors; ++i)
+    {
+        // LISTEN_FDNAMES is colon-separated, one entry per descriptor
+        std::string name;
+        if (name_start <= names.size())
+        {
+            const size_t colon = std::min(names.find(':', name_start), names.size());
+            name = names.substr(name_start, colon - name_start);
+            name_start = colon + 1;
+        }
+        if (name.empty() || name == "unknown")
+        {
+            name = "main";
+        }
+
+        ActivatedListener listener;
+        if (Adopt(kFirstDescriptor + i, name, listener))
+        {
+            listeners.push_back(std::move(listener));
+        }
+        else
+        {
+            close(kFirstDescriptor + i);
+        }
+    }
+    if (descriptors > 0)
+    {
+        LOG_INFO_FMT(SocketActivation, "Adopted {} of {} listening sockets from the launcher", listeners.size(), descriptors);
+    }
+#endif
+    return listeners;
+}
+
+bool Adopt(int descriptor, const std::string& name, ActivatedListener& listener)
+{
+#ifdef _WIN32
+    (void)descriptor;
+    (void)name;
+    (void)listener;
+    LOG_ERROR(SocketActivation, "Inherited descriptors are not supported on this platform");
+    return false;
+#else
+    int type = 0;
+    int accepting = 0;
+    socklen_t option_len = sizeof(type);
+    sockaddr_storage address;
+    socklen_t address_len = sizeof(address);
+    if (getsockopt(descriptor, SOL_SOCKET, SO_TYPE, &type, &option_len) != 0 ||
+        getsockname(descriptor, reinterpret_cast<sockaddr*>(&address), &address_len) != 0)
+    {
+        LOG_ERROR_FMT(SocketActivation, "Descriptor {} is not a socket: {}", descriptor, std::strerror(errno));
+        return false;
+    }
+    option_len = sizeof(accepting);
+    getsockopt(descriptor, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &option_len);
+    if (type != SOCK_STREAM || !accepting || (address.ss_family != AF_INET && address.ss_family != AF_UNIX))
+    {
+        LOG_ERROR_FMT(SocketActivation, "Descriptor {} is not a listening IPv4 or Unix stream socket", descriptor);
+        return false;
+    }
+
+    listener = ActivatedListener{};
+    listener.name = name;
+    listener.socket = descriptor;
+    if (address.ss_family == AF_INET)
+    {
+        listener.port = ntohs(reinterpret_cast<sockaddr_in*>(&address)->sin_port);
+    }
+    else
+    {
+        // Abstract names start with a NUL byte and run to the end of the address
+        const sockaddr_un& local = reinterpret_cast<const sockaddr_un&>(address);
+        const size_t length = address_len > offsetof(sockaddr_un, sun_path)
+            ? address_len - offsetof(sockaddr_un, sun_path) : 0;
+        listener.local.abstract = length > 0 && local.sun_path[0] == '\0';
+        listener.local.path = listener.local.abstract
+            ? std::string(local.sun_path + 1, length - 1)
+            : std::string(local.sun_path, strnlen(local.sun_path, length));
+        if (listener.local.path.empty())
+        {
+            LOG_ERROR_FMT(SocketActivation, "Descriptor {} is an unnamed Unix socket", descriptor);
+            return false;
+        }
+    }
+
+    // Owned by this process from now on; keep it out of programs it runs. A launcher restarting the
+    // server may overlap two processes on the socket, so the one losing a connection must not block
+    fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+    fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+    return true;
+#endif
+}
+
+bool NotifyReady()
+{
+#ifdef _WIN32
+    return false;
+#else
+    const char* target = std::getenv("NOTIFY_SOCKET");
+    if (!target || (target[0] != '/' && target[0] != '@'))
+    {
+        return false;
+    }
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    const size_t length = std::strlen(target);
+    if (length >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    std::memcpy(address.sun_path, target, length);
+    if (address.sun_path[0] == '@')
+    {
+        address.sun_path[0] = '\0';
+    }
+
+    const int notify = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (notify < 0)
+    {
+        return false;
+    }
+    static const char kReady[] = "READY=1";
+    const bool sent = sendto(notify, kReady, sizeof(kReady) - 1, MSG_NOSIGNAL, reinterpret_cast<sockaddr*>(&address),
+                             static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + length)) >= 0;
+    if (!sent)
+    {
+        LOG_WARN_FMT(SocketActivation, "Cannot notify the service manager: {}", std::strerror(errno));
+    }
+    close(notify);
+    return sent;
+#endif
+}
+
+} // namespace activation
+
+} // namespace miniserver::network
@@ -0,0 +1,64 @@
+/**
+ * @file socket_activation.hpp
+ * @brief Listening sockets handed in by a launcher (systemd LISTEN_FDS protocol or explicit descriptors)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/socket_server.hpp"
+
+#include <string>
+#include <vector>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Pre-bound listening socket adopted from the launching process
+ */
+struct ActivatedListener
+{
+    std::string name;                   ///< Listener it serves ("main" unless the launcher named it)
+    SOCKET socket = INVALID_SOCKET;     ///< Listening socket
+    int port = 0;                       ///< Bound TCP port (0: Unix domain socket)
+    LocalSocketOptions local;           ///< Bound Unix socket path or abstract name
+};
+
+namespace activation
+{
+    /**
+     * @brief First descriptor of the LISTEN_FDS protocol
+     */
+    constexpr int kFirstDescriptor = 3;
+
+    /**
+     * @brief Adopt the sockets a launcher passed with LISTEN_FDS
+     * @return Sockets in descriptor order; empty when LISTEN_PID names another process
+     *
+     * @details
+     * Reads LISTEN_PID, LISTEN_FDS and LISTEN_FDNAMES (names default to
+     * "main") and unsets them, so processes started later do not adopt the
+     * descriptors too. Descriptors that are not listening IPv4 or Unix
+     * stream sockets are logged and closed.
+     */
+    std::vector<ActivatedListener> FromEnvironment();
+
+    /**
+     * @brief Adopt one descriptor passed explicitly (--fd)
+     * @param descriptor Inherited descriptor
+     * @param name Listener it serves
+     * @param listener Filled with the socket's address
+     * @return false if the descriptor is not a listening IPv4 or Unix stream socket
+     */
+    bool Adopt(int descriptor, const std::string& name, ActivatedListener& listener);
+
+    /**
+     * @brief Tell the service manager the server accepts connections (sd_notify READY=1)
+     * @return false if NOTIFY_SOCKET is unset or unreachable
+     */
+    bool NotifyReady();
+}
+
+} // namespace miniserver::network
@@ -4,10 +4,21 @@
  */
 
 #include "net/socket_server.hpp"
+#include "net/http2_connection.hpp"
+#include "net/http_parser.hpp"
+#include "net/tls.hpp"
 #include "utils/logger.hpp"
+#include <algorithm>
+#include <cctype>
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <cstring>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <utility>
 
 #ifdef _WIN32
     #include <ws2tcpip.h>
@@ -15,15 +26,102 @@
 #else
     #include <sys/socket.h>
     #include <netinet/in.h>
+    #include <netinet/tcp.h>
     #include <arpa/inet.h>
     #include <unistd.h>
     #include <fcntl.h>
     #include <errno.h>
+    #include <poll.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+#endif
+#if defined(__linux__)
+    #include <linux/errqueue.h>
+    #include <linux/filter.h>
+    #include <sched.h>
 #endif
 
 namespace miniserver::network
 {
 
+namespace
+{
+    /**
+     * @brief Hint to the CPU that this is a spin-wait loop
+     */
+    inline void CpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    constexpr std::chrono::nanoseconds kMinSpin = std::chrono::microseconds(1);    ///< Floor of an adaptive spin budget
+    constexpr int kZeroCopyTimeoutMs = 30000;   ///< Longest wait for zero-copy completions (the send timeout)
+
+    /**
+     * @brief Check whether a header line carries the given (lower-case) field name
+     */
+    bool IsHeaderLine(std::string_view line, std::string_view name)
+    {
+        return line.size() > name.size() && line[name.size()] == ':' &&
+               std::equal(name.begin(), name.end(), line.begin(), [](char lower, char c)
+               {
+                   return lower == std::tolower(static_cast<unsigned char>(c));
+               });
+    }
+
+    /**
+     * @brief Leave exactly one Connection header, with the given value, right after the status line
+     */
+    void SetConnectionHeader(std::string& response, std::string_view value)
+    {
+        const size_t status_line_end = response.find("\r\n");
+        if (status_line_end == std::string::npos)
+        {
+            return;
+        }
+        size_t pos = status_line_end + 2;
+        size_t line_end;
+        while ((line_end = response.find("\r\n", pos)) != std::string::npos && line_end > pos)
+        {
+            if (IsHeaderLine(std::string_view(response).substr(pos, line_end - pos), "connection"))
+            {
+                response.erase(pos, line_end + 2 - pos);
+            }
+            else
+            {
+                pos = line_end + 2;
+            }
+        }
+        response.insert(status_line_end + 2, "Connection: " + std::string(value) + "\r\n");
+    }
+
+    /**
+     * @brief Request head describing a decoded body: no Content-Encoding, the decoded Content-Length
+     */
+    std::string DecodedHead(std::string_view head, size_t body_size)
+    {
+        std::string result;
+        result.reserve(head.size());
+        size_t pos = 0;
+        size_t line_end;
+        while ((line_end = head.find("\r\n", pos)) != std::string_view::npos && line_end > pos)
+        {
+            const std::string_view line = head.substr(pos, line_end - pos);
+            if (!IsHeaderLine(line, "content-encoding") && !IsHeaderLine(line, "content-length"))
+            {
+                result.append(line).append("\r\n");
+            }
+            pos = line_end + 2;
+        }
+        result.append("Content-Length: ").append(std::to_string(body_size)).append("\r\n\r\n");
+        return result;
+    }
+}
+
 SocketServer::SocketServer()
     : m_server_socket(INVALID_SOCKET)
     , m_is_running(false)
@@ -39,6 +137,18 @@ SocketServer::SocketServer()
     }
 #endif
 
+#ifndef _WIN32
+    // Release() writes here to wake the accept loop without shutting the listeners down
+    if (pipe(m_wake_pipe) == 0)
+    {
+        for (int descriptor : m_wake_pipe)
+        {
+            fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+            fcntl(descriptor, F_SETFL, O_NONBLOCK);
+        }
+    }
+#endif
+
     LOG_ERROR(
         SocketServer, "Socket server initialized");
 }
@@ -46,13 +156,23 @@ SocketServer::SocketServer()
 SocketServer::~SocketServer()
 {
     Stop();
+    CloseSocket(m_inherited_tcp);
+    CloseSocket(m_inherited_local);
 #ifdef _WIN32
     WSACleanup();
+#else
+    for (int descriptor : m_wake_pipe)
+    {
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+    }
 #endif
     LOG_INFO(SocketServer, "Socket server destroyed");
 }
 
-bool SocketServer::Start(const std::string& host, int port)
+bool SocketServer::Start(const std::string& host, int port, const LocalSocketOptions& local_socket)
 {
     if (IsRunning())
     {
@@ -60,24 +180,121 @@ bool SocketServer::Start(const std::string& host, int port)
             "Server is already running");
         return false;
     }
+    if (port <= 0 && local_socket.path.empty())
+    {
+        LOG_ERROR(SocketServer, "No TCP port or unix socket to listen on");
+        return false;
+    }
 
-    // Create socket
-    m_server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (m_server_socket == INVALID_SOCKET)
+    // Sockets inherited from a previous process are already bound and listening
+    SOCKET inherited_tcp = std::exchange(m_inherited_tcp, INVALID_SOCKET);
+    SOCKET inherited_local = std::exchange(m_inherited_local, INVALID_SOCKET);
+    if (inherited_tcp != INVALID_SOCKET)
     {
-        LOG_ERROR(SocketServer,
-            "Failed to create socket: " + GetLastErrorString());
+        sockaddr_in bound;
+        socklen_t bound_len = sizeof(bound);
+        if (port <= 0 || getsockname(inherited_tcp, reinterpret_cast<struct sockaddr*>(&bound), &bound_len) != 0 ||
+            bound.sin_family != AF_INET || ntohs(bound.sin_port) != port)
+        {
+            LOG_WARN(SocketServer, "Inherited socket does not match port " + std::to_string(port) + ", binding anew");
+            CloseSocket(inherited_tcp);
+            inherited_tcp = INVALID_SOCKET;
+        }
+    }
+    if (inherited_local != INVALID_SOCKET && local_socket.path.empty())
+    {
+        CloseSocket(inherited_local);
+        inherited_local = INVALID_SOCKET;
+    }
+
+    if (inherited_tcp != INVALID_SOCKET)
+    {
+        // A second listen() only resizes the queue; connections already in it stay
+        listen(inherited_tcp, m_tuning.backlog);
+        ApplyListenerTuning(inherited_tcp, m_tuning);
+        m_server_socket = inherited_tcp;
+    }
+    else if (port > 0 && !StartTcp(host, port))
+    {
+        CloseSocket(inherited_local);
         return false;
     }
 
-    // Set socket options
-    if (!SetSocketOptions())
+    if (inherited_local != INVALID_SOCKET)
+    {
+        listen(inherited_local, m_tuning.backlog);
+        m_local_socket = inherited_local;
+        m_local_options = local_socket;
+    }
+    else if (!local_socket.path.empty() && !StartLocalSocket(local_socket))
     {
         CloseSocket(m_server_socket);
         m_server_socket = INVALID_SOCKET;
         return false;
     }
 
+    m_host = host;
+    m_port = port;
+    m_active.store(0);
+    m_accepted.store(0);
+    m_rejected.store(0);
+    m_accept_wakeups.store(0);
+    m_migrated_out.store(0);
+    m_migrated_in.store(0);
+    m_cpu_local.store(0);
+    m_cpu_remote.store(0);
+    m_zerocopy_sends.store(0);
+    m_zerocopy_copied.store(0);
+    m_spin_hits.store(0);
+    m_parks.store(0);
+    m_spin_ns.store(0);
+    m_park_ns.store(0);
+    m_draining.store(false);
+#ifndef _WIN32
+    char stale[16];
+    while (m_wake_pipe[0] >= 0 && read(m_wake_pipe[0], stale, sizeof(stale)) > 0)
+    {
+    }
+#endif
+
+    m_is_running.store(true);
+
+    LOG_INFO(SocketServer, "Server started successfully at " + GetAddress());
+    return true;
+}
+
+SOCKET SocketServer::OpenTcpListener(const std::string& host, int port, bool reuse_port, const SocketTuning& tuning)
+{
+    // Create socket
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET)
+    {
+        LOG_ERROR(SocketServer,
+            "Failed to create socket: " + GetLastErrorString());
+        return INVALID_SOCKET;
+    }
+
+    // Set socket options
+    if (!SetSocketOptions(listener, reuse_port))
+    {
+        CloseSocket(listener);
+        return INVALID_SOCKET;
+    }
+
+    // Buffer sizes are inherited by accepted sockets; set before listen() they also size the window scale
+    if (tuning.receive_buffer > 0 &&
+        setsockopt(listener, SOL_SOCKET, SO_RCVBUF,
+                   reinterpret_cast<const char*>(&tuning.receive_buffer), sizeof(tuning.receive_buffer)) == SOCKET_ERROR)
+    {
+        LOG_WARN(SocketServer, "Failed to set SO_RCVBUF: " + GetLastErrorString());
+    }
+    if (tuning.send_buffer > 0 &&
+        setsockopt(listener, SOL_SOCKET, SO_SNDBUF,
+                   reinterpret_cast<const char*>(&tuning.send_buffer), sizeof(tuning.send_buffer)) == SOCKET_ERROR)
+    {
+        LOG_WARN(SocketServer, "Failed to set SO_SNDBUF: " + GetLastErrorString());
+    }
+
     // Bind address
     sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
@@ -94,41 +311,199 @@ bool SocketServer::Start(const std::string& host, int port)
         {
             LOG_ERROR(
                 SocketServer, "Invalid IP address: " + host);
-            CloseSocket(m_server_socket);
-            m_server_socket = INVALID_SOCKET;
-            return false;
+            CloseSocket(listener);
+            return INVALID_SOCKET;
         }
     }
 
-    if (bind(m_server_socket, reinterpret_cast<struct sockaddr*>(&server_addr),
+    if (bind(listener, reinterpret_cast<struct sockaddr*>(&server_addr),
              sizeof(server_addr)) == SOCKET_ERROR)
     {
         LOG_ERROR(
             SocketServer, "Failed to bind address: " + GetLastErrorString());
-        CloseSocket(m_server_socket);
-        m_server_socket = INVALID_SOCKET;
-        return false;
+        CloseSocket(listener);
+        return INVALID_SOCKET;
     }
 
     // Start listening
-    if (listen(m_server_socket, SOMAXCONN) == SOCKET_ERROR)
+    if (listen(listener, tuning.backlog) == SOCKET_ERROR)
     {
         LOG_ERROR(
             SocketServer, "Listen failed: " + GetLastErrorString());
-        CloseSocket(m_server_socket);
-        m_server_socket = INVALID_SOCKET;
+        CloseSocket(listener);
+        return INVALID_SOCKET;
+    }
+    ApplyListenerTuning(listener, tuning);
+
+    return listener;
+}
+
+bool SocketServer::AttachCpuSteering(SOCKET listener, const std::vector<int>& cpus)
+{
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+    // A = receiving CPU; return the member pinned to it, else fall back to A % members
+    std::vector<sock_filter> code;
+    code.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)));
+    for (size_t i = 0; i < cpus.size(); ++i)
+    {
+        code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(cpus[i]), 0, 1));
+        code.push_back(BPF_STMT(BPF_RET | BPF_K, static_cast<uint32_t>(i)));
+    }
+    code.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(std::max<size_t>(cpus.size(), 1))));
+    code.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+    if (code.size() > BPF_MAXINSNS)
+    {
+        LOG_WARN(SocketServer, "Too many reuseport members for a CPU steering program");
         return false;
     }
 
-    m_host = host;
-    m_port = port;
+    sock_fprog program;
+    program.len = static_cast<unsigned short>(code.size());
+    program.filter = code.data();
+    if (setsockopt(listener, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == SOCKET_ERROR)
+    {
+        LOG_WARN(SocketServer, "Failed to attach the reuseport CPU program: " + GetLastErrorString());
+        return false;
+    }
+    return true;
+#else
+    (void)listener;
+    (void)cpus;
+    LOG_WARN(SocketServer, "Reuseport CPU steering is not supported on this platform");
+    return false;
+#endif
+}
 
-    m_is_running.store(true);
+void SocketServer::ApplyListenerTuning(SOCKET listener, const SocketTuning& tuning)
+{
+    if (tuning.defer_accept_seconds > 0)
+    {
+#ifdef TCP_DEFER_ACCEPT
+        // Connections that never send are dropped after the timeout instead of costing a thread
+        if (setsockopt(listener, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+                       &tuning.defer_accept_seconds, sizeof(tuning.defer_accept_seconds)) == SOCKET_ERROR)
+        {
+            LOG_WARN(SocketServer, "Failed to set TCP_DEFER_ACCEPT: " + GetLastErrorString());
+        }
+#else
+        LOG_WARN(SocketServer, "TCP_DEFER_ACCEPT is not supported on this platform");
+#endif
+    }
+    if (tuning.fastopen_queue > 0)
+    {
+#ifdef TCP_FASTOPEN
+        // The request may ride on the SYN; the kernel also needs net.ipv4.tcp_fastopen & 2
+        if (setsockopt(listener, IPPROTO_TCP, TCP_FASTOPEN,
+                       reinterpret_cast<const char*>(&tuning.fastopen_queue), sizeof(tuning.fastopen_queue)) == SOCKET_ERROR)
+        {
+            LOG_WARN(SocketServer, "Failed to set TCP_FASTOPEN: " + GetLastErrorString());
+        }
+#else
+        LOG_WARN(SocketServer, "TCP_FASTOPEN is not supported on this platform");
+#endif
+    }
+    if (tuning.incoming_cpu >= 0)
+    {
+#ifdef SO_INCOMING_CPU
+        // Within a SO_REUSEPORT group the kernel prefers the member tagged with the CPU that took the SYN
+        if (setsockopt(listener, SOL_SOCKET, SO_INCOMING_CPU,
+                       &tuning.incoming_cpu, sizeof(tuning.incoming_cpu)) == SOCKET_ERROR)
+        {
+            LOG_WARN(SocketServer, "Failed to set SO_INCOMING_CPU: " + GetLastErrorString());
+        }
+#else
+        LOG_WARN(SocketServer, "SO_INCOMING_CPU is not supported on this platform");
+#endif
+    }
+#if !defined(TCP_QUICKACK)
+    if (tuning.quick_ack)
+    {
+        LOG_WARN(SocketServer, "TCP_QUICKACK is not supported on this platform");
+    }
+#endif
+}
+
+bool SocketServer::StartTcp(const std::string& host, int port)
+{
+    m_server_socket = OpenTcpListener(host, port, false, m_tuning);
+    return m_server_socket != INVALID_SOCKET;
+}
 
-    LOG_INFO(SocketServer, "Server started successfully at " + host + ":" + std::to_string(port));
+bool SocketServer::StartLocalSocket(const LocalSocketOptions& options)
+{
+    m_local_socket = OpenLocalListener(options, m_tuning.backlog);
+    if (m_local_socket == INVALID_SOCKET)
+    {
+        return false;
+    }
+    m_local_options = options;
     return true;
 }
 
+SOCKET SocketServer::OpenLocalListener(const LocalSocketOptions& options, int backlog)
+{
+#ifdef _WIN32
+    (void)options;
+    (void)backlog;
+    LOG_ERROR(SocketServer, "Unix domain sockets are not supported on this platform");
+    return INVALID_SOCKET;
+#else
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    // Abstract names start with a NUL byte and are not NUL-terminated
+    const size_t offset = options.abstract ? 1 : 0;
+    if (options.path.size() + offset >= sizeof(address.sun_path))
+    {
+        LOG_ERROR(SocketServer, "Unix socket path is too long: " + options.path);
+        return INVALID_SOCKET;
+    }
+    memcpy(address.sun_path + offset, options.path.data(), options.path.size());
+    const socklen_t address_len = options.abstract
+        ? static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + options.path.size())
+        : static_cast<socklen_t>(sizeof(address));
+
+    // A socket file left behind by a previous run would make bind fail
+    struct stat info;
+    if (!options.abstract && lstat(options.path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+    {
+        unlink(options.path.c_str());
+    }
+
+    SOCKET listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET)
+    {
+        LOG_ERROR(SocketServer, "Failed to create unix socket: " + GetLastErrorString());
+        return INVALID_SOCKET;
+    }
+
+    const std::string display = (options.abstract ? "@" : "") + options.path;
+    if (bind(listener, reinterpret_cast<struct sockaddr*>(&address), address_len) == SOCKET_ERROR)
+    {
+        LOG_ERROR(SocketServer, "Failed to bind unix socket " + display + ": " + GetLastErrorString());
+        CloseSocket(listener);
+        return INVALID_SOCKET;
+    }
+
+    // Connections are refused until listen(), so tightening the mode here leaves no window
+    if ((!options.abstract && chmod(options.path.c_str(), static_cast<mode_t>(options.mode)) != 0) ||
+        listen(listener, backlog) == SOCKET_ERROR)
+    {
+        LOG_ERROR(SocketServer, "Failed to set up unix socket " + display + ": " + GetLastErrorString());
+        CloseSocket(listener);
+        if (!options.abstract)
+        {
+            unlink(options.path.c_str());
+        }
+        return INVALID_SOCKET;
+    }
+
+    LOG_INFO(SocketServer, "Listening on unix socket " + display);
+    return listener;
+#endif
+}
+
 void SocketServer::Stop()
 {
     if (!IsRunning())
@@ -138,11 +513,29 @@ void SocketServer::Stop()
 
     m_is_running.store(false);
 
+    // Shutting a listener down wakes the accept loop; closing alone does not
     if (m_server_socket != INVALID_SOCKET)
     {
+#ifdef _WIN32
+        shutdown(m_server_socket, SD_BOTH);
+#else
+        shutdown(m_server_socket, SHUT_RDWR);
+#endif
         CloseSocket(m_server_socket);
         m_server_socket = INVALID_SOCKET;
     }
+#ifndef _WIN32
+    if (m_local_socket != INVALID_SOCKET)
+    {
+        shutdown(m_local_socket, SHUT_RDWR);
+        CloseSocket(m_local_socket);
+        m_local_socket = INVALID_SOCKET;
+        if (!m_local_options.abstract)
+        {
+            unlink(m_local_options.path.c_str());
+        }
+    }
+#endif
 
     LOG_ERROR(
         SocketServer, "Server stopped");
@@ -160,17 +553,62 @@ void SocketServer::Run(RequestHandler handler)
     LOG_ERROR(SocketServer, 
         "Waiting for client connections...");
 
-    while (IsRunning())
+#ifndef _WIN32
+    // Nonblocking listeners let a readiness event drain the queue until accept() reports it empty
+    for (SOCKET listener : {m_server_socket, m_local_socket})
     {
-        sockaddr_in client_addr;
-        socklen_t client_addr_len = sizeof(client_addr);
+        if (listener != INVALID_SOCKET)
+        {
+            fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+        }
+    }
+    const size_t batch = std::max<size_t>(1, m_tuning.accept_batch);
+#else
+    const size_t batch = 1;
+#endif
+    std::chrono::nanoseconds spin_budget = m_busy_poll.max_spin;
 
-        SOCKET client_socket = accept(
-            m_server_socket,
-            reinterpret_cast<struct sockaddr*>(&client_addr),
-            &client_addr_len);
+    while (IsRunning())
+    {
+        // Wait on every listener; Stop() shuts them down and Release() writes to the wake pipe
+#ifdef _WIN32
+        WSAPOLLFD listeners[2] = {};
+        const SOCKET watched[] = {m_server_socket, m_local_socket};
+#else
+        pollfd listeners[3] = {};
+        const SOCKET watched[] = {m_server_socket, m_local_socket, m_wake_pipe[0]};
+#endif
+        size_t listener_count = 0;
+        for (SOCKET listener : watched)
+        {
+            if (listener != INVALID_SOCKET)
+            {
+                listeners[listener_count].fd = listener;
+                listeners[listener_count].events = POLLIN;
+                ++listener_count;
+            }
+        }
 
-        if (client_socket == INVALID_SOCKET)
+#ifdef _WIN32
+        const int ready = WSAPoll(listeners, static_cast<ULONG>(listener_count), -1);
+#else
+        int ready = 0;
+        if (!m_busy_poll.enabled)
+        {
+            ready = poll(listeners, listener_count, -1);
+        }
+        else if (!Spin(spin_budget, [&]() { return (ready = poll(listeners, listener_count, 0)) != 0; }))
+        {
+            const auto parked_at = std::chrono::steady_clock::now();
+            ready = poll(listeners, listener_count, -1);
+            EndPark(spin_budget, parked_at);
+        }
+        if (ready < 0 && errno == EINTR)
+        {
+            continue;
+        }
+#endif
+        if (ready <= 0)
         {
             if (IsRunning())
             {
@@ -182,177 +620,938 @@ void SocketServer::Run(RequestHandler handler)
             continue;
         }
 
-        // Get client address
-        char client_ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
-
-        LOG_INFO(SocketServer, 
-            "Accepted connection from " + std::string(client_ip));
-
-        // Handle client in a new thread
-        std::thread client_thread([this, client_socket, handler, client_ip]()
+        for (size_t i = 0; i < listener_count && IsRunning(); ++i)
         {
-            HandleClient(client_socket, handler, client_ip);
-        });
-        client_thread.detach();
+#ifndef _WIN32
+            if (listeners[i].fd == m_wake_pipe[0])
+            {
+                continue;
+            }
+#endif
+            if (listeners[i].revents != 0)
+            {
+                m_accept_wakeups.fetch_add(1, std::memory_order_relaxed);
+                for (size_t accepted = 0; accepted < batch && IsRunning(); ++accepted)
+                {
+                    if (!AcceptClient(listeners[i].fd, handler))
+                    {
+                        break;
+                    }
+                }
+            }
+        }
     }
 }
 
-bool SocketServer::IsRunning() const
+bool SocketServer::AcceptClient(SOCKET listener, const RequestHandler& handler)
 {
-    return m_is_running.load();
-}
+    sockaddr_storage client_addr;
+    socklen_t client_addr_len = sizeof(client_addr);
 
-std::string SocketServer::GetAddress() const
-{
-    if (!IsRunning())
-    {
-        return "";
-    }
-    return m_host + ":" + std::to_string(m_port);
-}
+#if defined(__linux__)
+    // Close-on-exec from the start, so a concurrent fork+exec (takeover, prefork restart) cannot inherit it.
+    // Client threads use blocking I/O with timeouts, so SOCK_NONBLOCK is left to the hand-off handlers.
+    SOCKET client_socket = accept4(
+        listener,
+        reinterpret_cast<struct sockaddr*>(&client_addr),
+        &client_addr_len,
+        SOCK_CLOEXEC);
+#else
+    SOCKET client_socket = accept(
+        listener,
+        reinterpret_cast<struct sockaddr*>(&client_addr),
+        &client_addr_len);
+#endif
 
-void SocketServer::HandleClient(SOCKET client_socket,
-                                RequestHandler handler,
-                                const std::string& client_ip)
-{
-    try
+    if (client_socket == INVALID_SOCKET)
     {
-        // Set client socket timeout
-        SetClientSocketTimeout(client_socket, 30); // 30 seconds
-
-        // Receive request
-        const std::string request_data = ReceiveData(client_socket);
-        if (request_data.empty())
+#ifndef _WIN32
+        // Queue drained, or (on a listener shared between processes) another process won this connection
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
         {
-            LOG_ERROR(SocketServer, 
-                "No data received from " + client_ip);
-
-            CloseSocket(client_socket);
-            return;
+            return false;
         }
-
-        LOG_INFO(SocketServer, 
-            "Received " + std::to_string(request_data.size()) +
-            " bytes from " + client_ip);
-
-        // Process request
-        std::string response = handler(request_data);
-
-        // Send response
-        if (!SendData(client_socket, response))
+        // The peer reset while queued: nothing wrong on our side
+        if (errno == ECONNABORTED || errno == EINTR)
         {
-            LOG_ERROR(SocketServer, 
-                "Failed to send response to " + client_ip);
+            return true;
         }
-    }
-    catch (const std::exception& e)
-    {
-        LOG_ERROR(SocketServer, 
-            "Exception while handling client " + client_ip + ": " + e.what());
-    }
-
-    CloseSocket(client_socket);
-}
-
-std::string SocketServer::ReceiveData(SOCKET client_socket)
-{
-    std::string data;
-    char buffer[8192];
-    int total_received = 0;
-    bool headers_complete = false;
-    size_t content_length = 0;
-    size_t headers_end_pos = 0;
-
-    while (true)
-    {
-        const int received = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
-        if (received <= 0)
+#endif
+        if (IsRunning())
         {
-            if (received == 0)
-            {
-                LOG_ERROR(
-                    SocketServer, "Client closed connection");
-            }
-            else
+            // Out of descriptors or memory: the connection stays queued and the listener readable,
+            // so back off instead of spinning, and log once a second
+            const std::string error = GetLastErrorString();
+            const auto now = std::chrono::steady_clock::now();
+            ++m_accept_errors;
+            if (now - m_accept_error_logged >= std::chrono::seconds(1))
             {
-                LOG_ERROR(
-                    SocketServer, "Error receiving data: " + GetLastErrorString());
+                LOG_ERROR(SocketServer, "Accept failed: " + error +
+                    (m_accept_errors > 1 ? " (" + std::to_string(m_accept_errors) + " times)" : ""));
+                m_accept_error_logged = now;
+                m_accept_errors = 0;
             }
-            break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
+        return false;
+    }
+#if !defined(_WIN32) && !defined(__linux__)
+    // BSD-derived stacks copy O_NONBLOCK from the listener; client threads need blocking I/O
+    fcntl(client_socket, F_SETFL, fcntl(client_socket, F_GETFL) & ~O_NONBLOCK);
+    fcntl(client_socket, F_SETFD, FD_CLOEXEC);
+#endif
 
-        buffer[received] = '\0';
-        data.append(buffer, received);
-        total_received += received;
+    if (client_addr.ss_family == AF_INET)
+    {
+        const int one = 1;
+        if (m_tuning.no_delay)
+        {
+            setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+        }
+#ifdef TCP_QUICKACK
+        if (m_tuning.quick_ack)
+        {
+            // Not sticky: the kernel may fall back to delayed ACKs later, the first exchanges benefit
+            setsockopt(client_socket, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+        }
+#endif
+#if defined(__linux__) && defined(SO_INCOMING_CPU)
+        if (m_tuning.cpu_stats)
+        {
+            // The CPU that ran the SYN's softirq versus this thread's: a mismatch pulls the socket across caches
+            int incoming = -1;
+            socklen_t length = sizeof(incoming);
+            if (getsockopt(client_socket, SOL_SOCKET, SO_INCOMING_CPU, &incoming, &length) == 0 && incoming >= 0)
+            {
+                (incoming == sched_getcpu() ? m_cpu_local : m_cpu_remote).fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+#endif
+#if defined(__linux__) && defined(SO_ZEROCOPY)
+        if (m_tuning.zerocopy_threshold > 0 &&
+            setsockopt(client_socket, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) != 0)
+        {
+            static std::atomic<bool> warned{false};
+            if (!warned.exchange(true))
+            {
+                LOG_WARN(SocketServer, "Failed to set SO_ZEROCOPY (Linux 4.14+): " + GetLastErrorString());
+            }
+        }
+#endif
+#if defined(SO_BUSY_POLL)
+        if (m_busy_poll.enabled && m_busy_poll.socket_busy_poll_us > 0)
+        {
+            // Blocking reads poll the device queue first instead of waiting for its interrupt
+            static std::atomic<bool> warned{false};
+            if (setsockopt(client_socket, SOL_SOCKET, SO_BUSY_POLL,
+                           &m_busy_poll.socket_busy_poll_us, sizeof(m_busy_poll.socket_busy_poll_us)) != 0 &&
+                !warned.exchange(true))
+            {
+                LOG_WARN(SocketServer, "Failed to set SO_BUSY_POLL (needs CAP_NET_ADMIN): " + GetLastErrorString());
+            }
+    #if defined(SO_PREFER_BUSY_POLL)
+            if (m_busy_poll.prefer_busy_poll)
+            {
+                setsockopt(client_socket, SOL_SOCKET, SO_PREFER_BUSY_POLL, &one, sizeof(one));
+            }
+    #endif
+        }
+#endif
+    }
+
+    // Get client address (unix socket peers have no address worth showing)
+    std::string client_ip = "unix:";
+    if (client_addr.ss_family == AF_INET)
+    {
+        char address[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &reinterpret_cast<sockaddr_in*>(&client_addr)->sin_addr, address, INET_ADDRSTRLEN);
+        client_ip = address;
+    }
 
-        // Detect end of headers
-        if (!headers_complete)
+    // Past the cap there is no thread to spare: answer right here and move on
+    m_accepted.fetch_add(1, std::memory_order_relaxed);
+    if (m_limits.max_connections > 0 && m_active.load() >= m_limits.max_connections)
+    {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN(SocketServer, "Connection limit reached, rejecting " + client_ip);
+        RejectClient(client_socket);
+        return true;
+    }
+
+    LOG_INFO(SocketServer, 
+        "Accepted connection from " + client_ip);
+
+    // Handle client in a new thread (the TLS handshake runs there too)
+    const bool tls = m_tls && client_addr.ss_family == AF_INET;
+    const auto accepted_at = std::chrono::steady_clock::now();
+    m_active.fetch_add(1);
+    std::thread client_thread([this, client_socket, handler, client_ip, tls, accepted_at]()
+    {
+        if (tls)
         {
-            headers_end_pos = data.find("\r\n\r\n");
-            if (headers_end_pos != std::string::npos)
+            m_tls->Serve(client_socket, [&](SOCKET plain_socket)
             {
-                headers_complete = true;
-                headers_end_pos += 4; // Skip delimiter
+                HandleClient(plain_socket, handler, client_ip, false);
+            });
+        }
+        else
+        {
+            HandleClient(client_socket, handler, client_ip, true, false, {}, accepted_at);
+        }
+        m_active.fetch_sub(1);
+    });
+    client_thread.detach();
+    return true;
+}
 
-                // Parse Content-Length
-                auto content_length_pos = data.find("Content-Length: ");
-                if (content_length_pos != std::string::npos)
+void SocketServer::RejectClient(SOCKET client_socket)
+{
+    static const std::string response =
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 21\r\n"
+        "Retry-After: 1\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "Server is at capacity";
+
+    // The send buffer of a new connection is empty, so this never blocks
+#ifdef MSG_NOSIGNAL
+    send(client_socket, response.data(), static_cast<int>(response.size()), MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+    send(client_socket, response.data(), static_cast<int>(response.size()), 0);
+#endif
+    CloseSocket(client_socket);
+}
+
+bool SocketServer::IsRunning() const
+{
+    return m_is_running.load();
+}
+
+std::string SocketServer::GetAddress() const
+{
+    if (!IsRunning())
+    {
+        return "";
+    }
+    if (m_port <= 0)
+    {
+        return "unix:" + std::string(m_local_options.abstract ? "@" : "") + m_local_options.path;
+    }
+    return m_host + ":" + std::to_string(m_port);
+}
+
+void SocketServer::HandleClient(SOCKET client_socket,
+                                RequestHandler handler,
+                                const std::string& client_ip,
+                                bool migratable,
+                                bool adopted,
+                                std::string buffered,
+                                std::chrono::steady_clock::time_point accepted_at)
+{
+    try
+    {
+        // Set client socket timeout (also the keep-alive idle timeout)
+        SetClientSocketTimeout(client_socket, m_limits.idle_timeout_seconds);
+        TrackConnection(client_socket, false);
+
+        std::string buffer = std::move(buffered);
+        std::string request_data;
+        size_t head_size = 0;
+        bool first_request = !adopted;
+        bool zerocopy_declined = false;
+
+        // How long the first bytes sat in this process before a thread read them
+        bool open = true;
+        if (accepted_at != std::chrono::steady_clock::time_point())
+        {
+            open = ReceiveMore(client_socket, buffer, true);
+            if (open)
+            {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - accepted_at).count();
+                const auto bound = std::lower_bound(std::begin(FirstByteLatency::kBoundsUs),
+                                                    std::end(FirstByteLatency::kBoundsUs), elapsed);
+                m_first_byte[static_cast<size_t>(bound - std::begin(FirstByteLatency::kBoundsUs))]
+                    .fetch_add(1, std::memory_order_relaxed);
+                m_first_byte_us.fetch_add(static_cast<uint64_t>(elapsed), std::memory_order_relaxed);
+            }
+        }
+        while (open)
+        {
+            // Between requests the connection carries no state but its buffer: another process may take it
+            if (!first_request && migratable && m_migration_handler && !m_draining.load())
+            {
+                UntrackConnection(client_socket);
+                if (m_migration_handler(client_socket, buffer, client_ip))
                 {
-                    content_length_pos += 16; // skip label
-                    const auto line_end = data.find("\r\n", content_length_pos);
-                    if (line_end != std::string::npos)
-                    {
-                        std::string length_str = data.substr(content_length_pos,
-                                                             line_end - content_length_pos);
-                        try
-                        {
-                            content_length = std::stoul(length_str);
-                        }
-                        catch (...)
-                        {
-                            content_length = 0;
-                        }
-                    }
+                    m_migrated_out.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                TrackConnection(client_socket, false);
+            }
+
+            // Between requests a kept-alive connection is idle, and a drain may close it
+            if (!first_request && buffer.empty() && !ReceiveIdle(client_socket, buffer))
+            {
+                break;
+            }
+            if (!ReceiveHead(client_socket, buffer, head_size))
+            {
+                break;
+            }
+
+            // Requests the pass-through handler claims stream their bodies through it
+            if (m_passthrough_handler)
+            {
+                const PassthroughResult result = m_passthrough_handler(client_socket, buffer, head_size, client_ip);
+                if (result == PassthroughResult::Close)
+                {
+                    break;
+                }
+                if (result == PassthroughResult::KeepAlive)
+                {
+                    first_request = false;
+                    continue;
+                }
+                if (result == PassthroughResult::Detached)
+                {
+                    UntrackConnection(client_socket);
+                    return;
+                }
+            }
+            if (!ReceiveRequest(client_socket, buffer, head_size, request_data))
+            {
+                break;
+            }
+
+            // HTTP/2 prior knowledge: the preface reads as a "PRI * HTTP/2.0" request
+            if (first_request && Http2Connection::StartsWithPreface(request_data))
+            {
+                Http2Connection connection(client_socket, handler, client_ip);
+                connection.ServePriorKnowledge(request_data + buffer);
+                break;
+            }
+            if (Http2Connection::IsUpgradeRequest(request_data))
+            {
+                Http2Connection connection(client_socket, handler, client_ip);
+                if (connection.ServeUpgrade(request_data, buffer))
+                {
+                    break;
+                }
+            }
+            first_request = false;
+
+            LOG_DEBUG(SocketServer, 
+                "Received " + std::to_string(request_data.size()) +
+                " bytes from " + client_ip);
+
+            // Process request
+            std::string response = handler(request_data);
+            bool keep_alive = IsKeepAlive(request_data) && !m_draining.load();
+
+            // 101 switches protocols; a response without Content-Length streams until close
+            const bool switching = response.compare(0, 13, "HTTP/1.1 101 ") == 0;
+            const bool streaming = !switching && !http::HttpParser::FindRawHeader(response, "Content-Length");
+            if (!switching)
+            {
+                // A handler or proxied upstream asking to close is honoured; the header is rewritten, never repeated
+                std::string chosen = http::HttpParser::FindRawHeader(response, "Connection").value_or("");
+                std::transform(chosen.begin(), chosen.end(), chosen.begin(), [](unsigned char c)
+                {
+                    return static_cast<char>(std::tolower(c));
+                });
+                if (chosen.find("close") != std::string::npos)
+                {
+                    keep_alive = false;
+                }
+                SetConnectionHeader(response, keep_alive && !streaming ? "keep-alive" : "close");
+            }
+
+            // Send response
+            if (!SendData(client_socket, response, &zerocopy_declined))
+            {
+                LOG_ERROR(SocketServer, 
+                    "Failed to send response to " + client_ip);
+                break;
+            }
+
+            // HTTP/1.x processing ends here: hand the socket over or drop it
+            if (switching || streaming)
+            {
+                UntrackConnection(client_socket);
+                if (m_handoff_handler &&
+                    m_handoff_handler(client_socket, request_data, response, buffer, client_ip))
+                {
+                    return;
                 }
+                break;
+            }
+
+            if (!keep_alive)
+            {
+                break;
             }
         }
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR(SocketServer, 
+            "Exception while handling client " + client_ip + ": " + e.what());
+    }
+
+    UntrackConnection(client_socket);
+    CloseSocket(client_socket);
+}
+
+bool SocketServer::ReceiveIdle(SOCKET client_socket, std::string& buffer)
+{
+    // Even while draining: the last response promised keep-alive, so the client may already be
+    // sending; Drain closes the connection once it stays idle past the grace period
+    TrackConnection(client_socket, true);
+    const bool received = ReceiveMore(client_socket, buffer, true);
+    TrackConnection(client_socket, false);
+    return received;
+}
+
+void SocketServer::TrackConnection(SOCKET client_socket, bool idle)
+{
+    std::lock_guard<std::mutex> lock(m_connections_mutex);
+    m_connections[client_socket] = idle ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+}
+
+void SocketServer::UntrackConnection(SOCKET client_socket)
+{
+    std::lock_guard<std::mutex> lock(m_connections_mutex);
+    m_connections.erase(client_socket);
+}
+
+void SocketServer::Inherit(SOCKET tcp_listener, SOCKET local_listener)
+{
+    CloseSocket(std::exchange(m_inherited_tcp, tcp_listener));
+    CloseSocket(std::exchange(m_inherited_local, local_listener));
+}
+
+void SocketServer::Release()
+{
+#ifdef _WIN32
+    // Sockets cannot be passed to another process here; stop as usual
+    Stop();
+#else
+    if (!m_is_running.exchange(false))
+    {
+        return;
+    }
 
-        // If we know expected body length, wait until complete
-        if (headers_complete && content_length > 0)
+    const char wake = 1;
+    if (write(m_wake_pipe[1], &wake, 1) < 0)
+    {
+        LOG_WARN(SocketServer, "Cannot wake the accept loop: " + GetLastErrorString());
+    }
+    CloseSocket(std::exchange(m_server_socket, INVALID_SOCKET));
+    CloseSocket(std::exchange(m_local_socket, INVALID_SOCKET));
+    LOG_INFO(SocketServer, "Listening sockets released");
+#endif
+}
+
+size_t SocketServer::Drain(std::chrono::milliseconds timeout)
+{
+#ifdef _WIN32
+    const int read_side = SD_RECEIVE;
+    const int both_sides = SD_BOTH;
+#else
+    const int read_side = SHUT_RD;
+    const int both_sides = SHUT_RDWR;
+#endif
+    // A keep-alive client between two requests is idle only briefly; closing it then loses a request
+    constexpr auto kIdleGrace = std::chrono::milliseconds(250);
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    m_draining.store(true);
+    while (m_active.load() > 0 && std::chrono::steady_clock::now() < deadline)
+    {
         {
-            const size_t current_body_size = data.size() - headers_end_pos;
-            if (current_body_size >= content_length)
+            // Idle connections see end-of-stream and close; busy ones close after their response
+            std::lock_guard<std::mutex> lock(m_connections_mutex);
+            const auto idle_before = std::chrono::steady_clock::now() - kIdleGrace;
+            for (const auto& [client_socket, idle_since] : m_connections)
             {
-                break; // complete
+                if (idle_since != std::chrono::steady_clock::time_point{} && idle_since < idle_before)
+                {
+                    shutdown(client_socket, read_side);
+                }
             }
         }
-        else if (headers_complete && content_length == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    const size_t remaining = m_active.load();
+    if (remaining > 0)
+    {
+        LOG_WARN(SocketServer, "Drain deadline passed, closing " + std::to_string(remaining) + " connections");
+        std::lock_guard<std::mutex> lock(m_connections_mutex);
+        for (const auto& [client_socket, idle_since] : m_connections)
         {
-            break; // no body
+            shutdown(client_socket, both_sides);
         }
+    }
+    return remaining;
+}
+
+void SocketServer::SetLimits(const ConnectionLimits& limits)
+{
+    m_limits = limits;
+}
 
-        // Size guard (1MB)
-        if (total_received > 1 * 1024 * 1024)
+void SocketServer::SetDecompressionLimits(const http::DecompressionLimits& limits)
+{
+    m_decompression = limits;
+    m_decompress = true;
+}
+
+void SocketServer::SetMigrationHandler(MigrationHandler handler)
+{
+    m_migration_handler = std::move(handler);
+}
+
+bool SocketServer::Adopt(SOCKET client_socket, std::string buffered, const std::string& client_ip, RequestHandler handler)
+{
+    if (!IsRunning() || !handler)
+    {
+        CloseSocket(client_socket);
+        return false;
+    }
+
+    m_migrated_in.fetch_add(1, std::memory_order_relaxed);
+    m_active.fetch_add(1);
+    std::thread client_thread([this, client_socket, buffered = std::move(buffered), client_ip, handler]() mutable
+    {
+        HandleClient(client_socket, handler, client_ip, true, true, std::move(buffered));
+        m_active.fetch_sub(1);
+    });
+    client_thread.detach();
+    return true;
+}
+
+void SocketServer::SetTuning(const SocketTuning& tuning)
+{
+    m_tuning = tuning;
+}
+
+void SocketServer::SetBusyPoll(const BusyPollOptions& options)
+{
+    m_busy_poll = options;
+#ifdef _WIN32
+    if (m_busy_poll.enabled)
+    {
+        LOG_WARN(SocketServer, "Busy-poll mode is not supported on this platform");
+        m_busy_poll.enabled = false;
+    }
+#endif
+    m_busy_poll.max_spin = std::max<std::chrono::microseconds>(m_busy_poll.max_spin, std::chrono::microseconds(1));
+}
+
+bool SocketServer::Spin(std::chrono::nanoseconds budget, const std::function<bool()>& ready)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + budget;
+    bool done = false;
+    auto now = start;
+    // Check the clock every few rounds: reading it costs about as much as a nonblocking poll
+    for (unsigned round = 0; !(done = ready()); ++round)
+    {
+        CpuRelax();
+        if ((round & 7) == 7 && (now = std::chrono::steady_clock::now()) >= deadline)
         {
-            LOG_ERROR(
-                SocketServer, "Received data too large, forcibly closing");
             break;
         }
     }
+    if (done)
+    {
+        now = std::chrono::steady_clock::now();
+        m_spin_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_spin_ns.fetch_add(static_cast<uint64_t>((now - start).count()), std::memory_order_relaxed);
+    return done;
+}
+
+void SocketServer::EndPark(std::chrono::nanoseconds& budget, std::chrono::steady_clock::time_point parked_at)
+{
+    const auto parked = std::chrono::steady_clock::now() - parked_at;
+    m_parks.fetch_add(1, std::memory_order_relaxed);
+    m_park_ns.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(parked).count()),
+                        std::memory_order_relaxed);
+
+    // A short park means a longer spin would have caught the data; a long one means spinning was wasted
+    const std::chrono::nanoseconds max_spin = m_busy_poll.max_spin;
+    budget = parked <= max_spin ? std::min(budget * 2, max_spin) : std::max(budget / 2, kMinSpin);
+}
+
+int SocketServer::Receive(SOCKET client_socket, char* data, int size)
+{
+#ifndef _WIN32
+    if (m_busy_poll.enabled)
+    {
+        // Every connection has its own thread, so a thread-local budget adapts per connection
+        thread_local std::chrono::nanoseconds budget = m_busy_poll.max_spin;
+        ssize_t received = -1;
+        if (Spin(budget, [&]()
+            {
+                received = recv(client_socket, data, static_cast<size_t>(size), MSG_DONTWAIT);
+                return received >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+            }))
+        {
+            return static_cast<int>(received);
+        }
+        const auto parked_at = std::chrono::steady_clock::now();
+        received = recv(client_socket, data, static_cast<size_t>(size), 0);
+        EndPark(budget, parked_at);
+        return static_cast<int>(received);
+    }
+#endif
+    return recv(client_socket, data, size, 0);
+}
+
+ConnectionStats SocketServer::GetConnectionStats() const
+{
+    ConnectionStats stats;
+    stats.active = m_active.load();
+    stats.accepted = m_accepted.load();
+    stats.rejected = m_rejected.load();
+    stats.accept_wakeups = m_accept_wakeups.load();
+    stats.migrated_out = m_migrated_out.load();
+    stats.migrated_in = m_migrated_in.load();
+    stats.cpu_local = m_cpu_local.load();
+    stats.cpu_remote = m_cpu_remote.load();
+    stats.zerocopy_sends = m_zerocopy_sends.load();
+    stats.zerocopy_copied = m_zerocopy_copied.load();
+    stats.busy_poll.spin_hits = m_spin_hits.load();
+    stats.busy_poll.parks = m_parks.load();
+    stats.busy_poll.spin_us = m_spin_ns.load() / 1000;
+    stats.busy_poll.park_us = m_park_ns.load() / 1000;
+    stats.listen_queue.length = m_queue_length.load();
+    stats.listen_queue.backlog = m_queue_backlog.load();
+    stats.listen_queue.peak = m_queue_peak.load();
+    stats.listen_queue.samples = m_queue_samples.load();
+    for (size_t i = 0; i < FirstByteLatency::kBuckets; ++i)
+    {
+        stats.first_byte.buckets[i] = m_first_byte[i].load();
+        stats.first_byte.count += stats.first_byte.buckets[i];
+    }
+    stats.first_byte.sum_us = m_first_byte_us.load();
+    return stats;
+}
+
+void SocketServer::SampleListenQueue()
+{
+#if defined(__linux__)
+    const SOCKET listener = m_server_socket;
+    if (!IsRunning() || listener == INVALID_SOCKET)
+    {
+        return;
+    }
+    // For a socket in LISTEN state the kernel puts the accept queue in tcpi_unacked and its limit in tcpi_sacked
+    tcp_info info{};
+    socklen_t length = sizeof(info);
+    if (getsockopt(listener, IPPROTO_TCP, TCP_INFO, &info, &length) != 0 || info.tcpi_state != TCP_LISTEN)
+    {
+        return;
+    }
+    m_queue_length.store(info.tcpi_unacked, std::memory_order_relaxed);
+    m_queue_backlog.store(info.tcpi_sacked, std::memory_order_relaxed);
+    if (info.tcpi_unacked > m_queue_peak.load(std::memory_order_relaxed))
+    {
+        m_queue_peak.store(info.tcpi_unacked, std::memory_order_relaxed);
+    }
+    m_queue_samples.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+bool SocketServer::ReadListenDrops(ListenDropCounters& counters)
+{
+#if defined(__linux__)
+    // Pairs of lines: "TcpExt: <names...>" then "TcpExt: <values...>"
+    std::ifstream netstat("/proc/net/netstat");
+    std::string names;
+    std::string values;
+    while (std::getline(netstat, names) && std::getline(netstat, values))
+    {
+        if (names.compare(0, 7, "TcpExt:") != 0)
+        {
+            continue;
+        }
+        std::istringstream name_stream(names);
+        std::istringstream value_stream(values);
+        std::string name;
+        std::string value;
+        int found = 0;
+        while (name_stream >> name && value_stream >> value)
+        {
+            if (name == "ListenOverflows")
+            {
+                counters.overflows = std::strtoull(value.c_str(), nullptr, 10);
+                ++found;
+            }
+            else if (name == "ListenDrops")
+            {
+                counters.drops = std::strtoull(value.c_str(), nullptr, 10);
+                ++found;
+            }
+        }
+        return found == 2;
+    }
+#else
+    (void)counters;
+#endif
+    return false;
+}
+
+uint32_t FirstByteLatency::QuantileUs(double quantile) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    const auto rank = static_cast<uint64_t>(quantile * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i + 1 < kBuckets; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            return kBoundsUs[i];
+        }
+    }
+    return UINT32_MAX;
+}
+
+void FirstByteLatency::Merge(const FirstByteLatency& other)
+{
+    for (size_t i = 0; i < kBuckets; ++i)
+    {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    sum_us += other.sum_us;
+}
+
+void SocketServer::SetTls(std::shared_ptr<TlsContext> tls)
+{
+    m_tls = std::move(tls);
+}
+
+void SocketServer::SetHandoffHandler(HandoffHandler handler)
+{
+    m_handoff_handler = std::move(handler);
+}
+
+void SocketServer::SetPassthroughHandler(PassthroughHandler handler)
+{
+    m_passthrough_handler = std::move(handler);
+}
+
+bool SocketServer::ReceiveMore(SOCKET client_socket, std::string& buffer, bool idle)
+{
+    char chunk[8192];
+    const int received = Receive(client_socket, chunk, sizeof(chunk));
+    if (received <= 0)
+    {
+        // Closing or timing out between requests is the normal end of a keep-alive connection
+        if (idle && buffer.empty())
+        {
+            LOG_DEBUG(SocketServer, "Client connection finished");
+        }
+        else if (received == 0)
+        {
+            LOG_ERROR(
+                SocketServer, "Client closed connection");
+        }
+        else
+        {
+            LOG_ERROR(
+                SocketServer, "Error receiving data: " + GetLastErrorString());
+        }
+        return false;
+    }
+    buffer.append(chunk, static_cast<size_t>(received));
+    return true;
+}
+
+bool SocketServer::ReceiveHead(SOCKET client_socket, std::string& buffer, size_t& head_size)
+{
+    constexpr size_t kMaxHeaderSize = 64 * 1024;
+
+    const bool idle = buffer.empty();
+
+    // Wait for the end of the headers
+    size_t search_from = 0;
+    size_t headers_end_pos;
+    while ((headers_end_pos = buffer.find("\r\n\r\n", search_from)) == std::string::npos)
+    {
+        if (buffer.size() > kMaxHeaderSize)
+        {
+            LOG_ERROR(
+                SocketServer, "Request headers too large, closing connection");
+            return false;
+        }
+        search_from = buffer.size() >= 3 ? buffer.size() - 3 : 0;
+        if (!ReceiveMore(client_socket, buffer, idle))
+        {
+            return false;
+        }
+    }
+    head_size = headers_end_pos + 4; // Include delimiter
+    return true;
+}
+
+bool SocketServer::ReceiveRequest(SOCKET client_socket, std::string& buffer, size_t head_size, std::string& request)
+{
+    const size_t headers_end_pos = head_size;
+
+    // Parse Content-Length
+    size_t content_length = 0;
+    const auto length_header = http::HttpParser::FindRawHeader(
+        std::string_view(buffer).substr(0, headers_end_pos), "content-length");
+    if (length_header)
+    {
+        try
+        {
+            content_length = std::stoul(*length_header);
+        }
+        catch (...)
+        {
+            content_length = 0;
+        }
+    }
+
+    // Size guard (1MB unless the limits say otherwise)
+    if (content_length > m_limits.max_request_size)
+    {
+        LOG_ERROR(
+            SocketServer, "Received data too large, forcibly closing");
+        return false;
+    }
+
+    // Encoded bodies are inflated as they arrive; only the decoded bytes are kept
+    if (m_decompress && content_length > 0)
+    {
+        const auto encoding = http::HttpParser::FindRawHeader(
+            std::string_view(buffer).substr(0, headers_end_pos), "content-encoding");
+        if (encoding)
+        {
+            return ReceiveDecodedBody(client_socket, buffer, headers_end_pos, content_length, *encoding, request);
+        }
+    }
+
+    // Wait until the body is complete
+    const size_t total = headers_end_pos + content_length;
+    while (buffer.size() < total)
+    {
+        if (!ReceiveMore(client_socket, buffer, false))
+        {
+            return false;
+        }
+    }
+
+    request.assign(buffer, 0, total);
+    buffer.erase(0, total);
+    return true;
+}
+
+bool SocketServer::ReceiveDecodedBody(SOCKET client_socket, std::string& buffer, size_t head_size,
+                                      size_t content_length, const std::string& encoding, std::string& request)
+{
+    http::RequestBodyDecoder decoder(m_decompression);
+    http::StatusCode status = decoder.Start(encoding);
+
+    const std::string head = buffer.substr(0, head_size);
+    buffer.erase(0, head_size);
+    std::string body;
+    size_t remaining = content_length;
+    while (status == http::StatusCode::OK && remaining > 0)
+    {
+        if (buffer.empty() && !ReceiveMore(client_socket, buffer, false))
+        {
+            return false;
+        }
+        const size_t take = std::min(remaining, buffer.size());
+        status = decoder.Feed(std::string_view(buffer).substr(0, take), body);
+        buffer.erase(0, take);
+        remaining -= take;
+    }
+    if (status == http::StatusCode::OK)
+    {
+        status = decoder.Finish();
+    }
+
+    if (status != http::StatusCode::OK)
+    {
+        // The rest of the body is never read, so the connection cannot continue
+        LOG_WARN_FMT(SocketServer, "Rejected {} request body after {} of {} bytes: {}",
+                     encoding, content_length - remaining, content_length, http::StatusToString(status));
+        http::Response error_response;
+        error_response.status = status;
+        error_response.SetJson("{\"error\":\"" + http::StatusToString(status) + "\"}");
+        error_response.headers["Connection"] = "close";
+        SendData(client_socket, http::HttpParser::SerializeResponse(error_response));
+        return false;
+    }
+
+    request = DecodedHead(head, body.size());
+    request.append(body);
+    return true;
+}
+
+bool SocketServer::IsKeepAlive(const std::string& request)
+{
+    const size_t line_end = request.find("\r\n");
+    const std::string request_line = request.substr(0, line_end);
+
+    std::string connection = http::HttpParser::FindRawHeader(request, "connection").value_or("");
+    std::transform(connection.begin(), connection.end(), connection.begin(), [](unsigned char c)
+    {
+        return static_cast<char>(std::tolower(c));
+    });
 
-    return data;
+    if (request_line.size() >= 8 && request_line.compare(request_line.size() - 8, 8, "HTTP/1.1") == 0)
+    {
+        return connection.find("close") == std::string::npos;
+    }
+    return connection.find("keep-alive") != std::string::npos;
 }
 
-bool SocketServer::SendData(SOCKET client_socket, const std::string& data)
+bool SocketServer::SendData(SOCKET client_socket, const std::string& data, bool* zerocopy_declined)
 {
+    // Once the kernel reports a copy (loopback, no scatter-gather) this connection stops paying for completions
     size_t total_sent = 0;
+    if (zerocopy_declined && !*zerocopy_declined &&
+        m_tuning.zerocopy_threshold > 0 && data.size() >= m_tuning.zerocopy_threshold)
+    {
+        // A decline can come part-way through (optmem exhausted): plain send() carries on from there
+        if (SendZeroCopy(client_socket, data, *zerocopy_declined, total_sent))
+        {
+            return true;
+        }
+        if (!*zerocopy_declined)
+        {
+            return false;
+        }
+    }
+
     size_t data_size = data.size();
     while (total_sent < data_size)
     {
+#ifdef MSG_NOSIGNAL
+        // A peer that closes a keep-alive connection must not raise SIGPIPE
+        int sent = send(client_socket,
+                        data.c_str() + total_sent,
+                        static_cast<int>(data_size - total_sent), MSG_NOSIGNAL);
+#else
         int sent = send(client_socket,
                         data.c_str() + total_sent,
                         static_cast<int>(data_size - total_sent), 0);
+#endif
         if (sent == SOCKET_ERROR)
         {
             LOG_ERROR(
@@ -364,28 +1563,175 @@ bool SocketServer::SendData(SOCKET client_socket, const std::string& data)
     return true;
 }
 
-bool SocketServer::SetSocketOptions()
+bool SocketServer::SendZeroCopy(SOCKET client_socket, const std::string& data, bool& declined, size_t& sent_bytes)
+{
+    sent_bytes = 0;
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+    // Without SO_ZEROCOPY (Unix sockets) the flag is ignored and no completion would ever arrive;
+    // kTLS sockets keep the option but fail the send with EOPNOTSUPP, handled below
+    int enabled = 0;
+    socklen_t length = sizeof(enabled);
+    if (getsockopt(client_socket, SOL_SOCKET, SO_ZEROCOPY, &enabled, &length) != 0 || enabled == 0)
+    {
+        declined = true;
+        return false;
+    }
+
+    // Each successful send() is one notification ID; completions report ranges of them
+    uint32_t pending = 0;
+    bool copied = false;
+    const auto reap = [&](bool wait)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kZeroCopyTimeoutMs);
+        while (pending > 0)
+        {
+            char control[128];
+            msghdr message{};
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+            if (recvmsg(client_socket, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    return false;
+                }
+                if (!wait)
+                {
+                    return true;
+                }
+                // The error queue signals POLLERR, which poll() reports whatever the requested events
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                pollfd descriptor{client_socket, 0, 0};
+                if (left.count() <= 0 || poll(&descriptor, 1, static_cast<int>(left.count())) < 0)
+                {
+                    return false;
+                }
+                continue;
+            }
+            for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header))
+            {
+                if (!((header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR) ||
+                      (header->cmsg_level == SOL_IPV6 && header->cmsg_type == IPV6_RECVERR)))
+                {
+                    continue;
+                }
+                const auto* error = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(header));
+                if (error->ee_errno != 0 || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                {
+                    continue;
+                }
+                pending -= std::min(pending, error->ee_data - error->ee_info + 1);
+                copied = copied || (error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+            }
+        }
+        return true;
+    };
+
+    size_t total_sent = 0;
+    while (total_sent < data.size())
+    {
+        const ssize_t sent = send(client_socket, data.data() + total_sent, data.size() - total_sent,
+                                  MSG_ZEROCOPY | MSG_NOSIGNAL);
+        if (sent >= 0)
+        {
+            total_sent += static_cast<size_t>(sent);
+            ++pending;
+            continue;
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        // Pinned ranges are charged to optmem_max: wait for some to be released and try again
+        if (errno == ENOBUFS && pending > 0)
+        {
+            const uint32_t before = pending;
+            if (!reap(false))
+            {
+                break;
+            }
+            if (pending == before)
+            {
+                pollfd descriptor{client_socket, 0, 0};
+                poll(&descriptor, 1, 10);
+            }
+            continue;
+        }
+        // Nothing left in flight to wait for: hand the rest to a plain send()
+        if (pending == 0 && (errno == EOPNOTSUPP || errno == ENOBUFS))
+        {
+            declined = true;
+            sent_bytes = total_sent;
+            return false;
+        }
+        LOG_ERROR(SocketServer, "Send failed: " + GetLastErrorString());
+        break;
+    }
+
+    // The caller frees or reuses the buffer next: every page must be released first
+    if (!reap(true))
+    {
+        LOG_ERROR(SocketServer, "Zero-copy completions did not arrive");
+        return false;
+    }
+    sent_bytes = total_sent;
+    if (total_sent < data.size())
+    {
+        return false;
+    }
+    m_zerocopy_sends.fetch_add(1, std::memory_order_relaxed);
+    if (copied)
+    {
+        m_zerocopy_copied.fetch_add(1, std::memory_order_relaxed);
+        declined = true;
+    }
+    return true;
+#else
+    (void)client_socket;
+    (void)data;
+    declined = true;
+    return false;
+#endif
+}
+
+bool SocketServer::SetSocketOptions(SOCKET listener, bool reuse_port)
 {
     int reuse = 1;
-    if (setsockopt(m_server_socket, SOL_SOCKET, SO_REUSEADDR,
+    if (setsockopt(listener, SOL_SOCKET, SO_REUSEADDR,
                    reinterpret_cast<const char*>(&reuse), sizeof(reuse)) == SOCKET_ERROR)
     {
         LOG_ERROR(
             SocketServer, "Failed to set SO_REUSEADDR: " + GetLastErrorString());
         return false;
     }
+    if (reuse_port)
+    {
+#ifdef SO_REUSEPORT
+        // Every socket bound with it gets its own accept queue; the kernel spreads connections across them
+        if (setsockopt(listener, SOL_SOCKET, SO_REUSEPORT,
+                       reinterpret_cast<const char*>(&reuse), sizeof(reuse)) == SOCKET_ERROR)
+        {
+            LOG_ERROR(
+                SocketServer, "Failed to set SO_REUSEPORT: " + GetLastErrorString());
+            return false;
+        }
+#else
+        LOG_ERROR(SocketServer, "SO_REUSEPORT is not supported on this platform");
+        return false;
+#endif
+    }
 #ifdef _WIN32
     DWORD timeout = 30000; // 30s
-    setsockopt(m_server_socket, SOL_SOCKET, SO_RCVTIMEO,
+    setsockopt(listener, SOL_SOCKET, SO_RCVTIMEO,
         reinterpret_cast<const char*>(&timeout), sizeof(timeout));
-    setsockopt(m_server_socket, SOL_SOCKET, SO_SNDTIMEO,
+    setsockopt(listener, SOL_SOCKET, SO_SNDTIMEO,
         reinterpret_cast<const char*>(&timeout), sizeof(timeout));
 #else
     struct timeval timeout;
     timeout.tv_sec = 30;
     timeout.tv_usec = 0;
-    setsockopt(m_server_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    setsockopt(m_server_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(listener, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(listener, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
 #endif
     return true;
 }
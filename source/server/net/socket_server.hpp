@@ -9,9 +9,19 @@
 
 #pragma once
 
+#include "net/compression.hpp"
+
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 #ifdef _WIN32
     #include <winsock2.h>
@@ -29,9 +39,190 @@
 
 namespace miniserver::network {
 
+class TlsContext;
+
 // Request handler functor: takes raw request data, returns serialized response
 using RequestHandler = std::function<std::string(const std::string& request_data)>;
 
+// Hand-off handler: takes over a connection after a response that ends HTTP/1.x
+// request processing (101 Switching Protocols, or a streaming response without
+// Content-Length). Receives the request, the response, bytes read past the
+// request and the peer address; returns true if it now owns the socket.
+using HandoffHandler = std::function<bool(SOCKET client_socket, const std::string& request_data,
+                                          const std::string& response, const std::string& buffered,
+                                          const std::string& client_ip)>;
+
+// Migration handler: offered a plaintext keep-alive connection each time it
+// falls idle between requests. Receives the socket, bytes already read past
+// the last request and the peer address; returns true if it passed the
+// socket to another process (and closed this process's descriptor).
+using MigrationHandler = std::function<bool(SOCKET client_socket, const std::string& buffered,
+                                            const std::string& client_ip)>;
+
+/**
+ * @brief Unix domain socket listener served alongside TCP (POSIX only)
+ */
+struct LocalSocketOptions
+{
+    std::string path;           ///< Socket file path, or the name in the abstract namespace (empty disables)
+    bool abstract = false;      ///< Linux abstract namespace: no file, no permissions, released with the process
+    int mode = 0660;            ///< Permissions of the socket file
+};
+
+/**
+ * @brief Per-listener connection limits
+ */
+struct ConnectionLimits
+{
+    size_t max_connections = 0;             ///< Open connections, one client thread each (0: unlimited); extra ones get 503
+    int idle_timeout_seconds = 30;          ///< Receive/send timeout, also the keep-alive idle timeout
+    size_t max_request_size = 1024 * 1024;  ///< Largest Content-Length body
+};
+
+/**
+ * @brief TCP socket options of a listener and the connections it accepts
+ *
+ * Zero or false leaves the kernel default. Options a platform lacks are
+ * skipped with a warning when the listener is opened.
+ */
+struct SocketTuning
+{
+    bool no_delay = false;          ///< TCP_NODELAY on accepted connections (no Nagle delay for small writes)
+    bool quick_ack = false;         ///< TCP_QUICKACK on accepted connections (Linux; no delayed ACK for the first request)
+    int defer_accept_seconds = 0;   ///< TCP_DEFER_ACCEPT: wake accept only once the request's first bytes arrived (Linux)
+    int fastopen_queue = 0;         ///< TCP_FASTOPEN: pending data-carrying SYNs allowed (0: off)
+    int receive_buffer = 0;         ///< SO_RCVBUF in bytes, set on the listener so accepted sockets inherit it
+    int send_buffer = 0;            ///< SO_SNDBUF in bytes, likewise
+    int backlog = SOMAXCONN;        ///< listen() backlog (the kernel caps it at net.core.somaxconn)
+    size_t accept_batch = 16;       ///< Connections accepted per readiness event before polling again
+    int incoming_cpu = -1;          ///< SO_INCOMING_CPU on the listener: preferred for connections received on that CPU (Linux, -1: off)
+    bool cpu_stats = false;         ///< Count connections accepted on / away from the CPU that received their packets (Linux)
+    size_t zerocopy_threshold = 0;  ///< Send HTTP/1.x responses at least this large with MSG_ZEROCOPY (Linux, 0: off)
+};
+
+/**
+ * @brief Busy-poll mode of a listener: spin on nonblocking checks before sleeping
+ *
+ * Trades CPU for latency on dedicated cores. Every wait of the accept loop
+ * and of the client threads first checks its socket without blocking for up
+ * to the thread's spin budget, then parks in the usual blocking call. The
+ * budget adapts between 1 us and max_spin: it doubles when data arrived soon
+ * after parking (a longer spin would have caught it) and halves when the
+ * park was long (the spin was wasted). POSIX only.
+ */
+struct BusyPollOptions
+{
+    bool enabled = false;                       ///< Spin before blocking
+    std::chrono::microseconds max_spin{100};    ///< Upper bound of the spin budget
+    int socket_busy_poll_us = 50;               ///< SO_BUSY_POLL on accepted sockets: the kernel polls the device queue while we wait (Linux, needs CAP_NET_ADMIN; 0: off)
+    bool prefer_busy_poll = true;               ///< SO_PREFER_BUSY_POLL: leave device queue processing to busy pollers (Linux 5.11+)
+};
+
+/**
+ * @brief Where the waits of a busy-polling listener spent their time
+ */
+struct BusyPollStats
+{
+    uint64_t spin_hits = 0;     ///< Waits that ended while spinning
+    uint64_t parks = 0;         ///< Waits that fell back to blocking
+    uint64_t spin_us = 0;       ///< Time spent spinning
+    uint64_t park_us = 0;       ///< Time spent parked
+};
+
+/**
+ * @brief Accept queue of a TCP listener, sampled from TCP_INFO (Linux)
+ *
+ * Connections the kernel has completed but nobody has accepted yet. A queue
+ * at its backlog means SYNs are being dropped (ListenOverflows).
+ */
+struct ListenQueueStats
+{
+    uint32_t length = 0;        ///< Connections waiting for accept() at the last sample
+    uint32_t backlog = 0;       ///< Queue limit (listen backlog capped by somaxconn)
+    uint32_t peak = 0;          ///< Longest queue sampled since Start
+    uint64_t samples = 0;       ///< Samples taken
+};
+
+/**
+ * @brief Host-wide accept queue losses from /proc/net/netstat (TcpExt, Linux)
+ */
+struct ListenDropCounters
+{
+    uint64_t overflows = 0;     ///< ListenOverflows: handshakes completed against a full accept queue
+    uint64_t drops = 0;         ///< ListenDrops: SYNs and handshakes dropped at a listener for any reason
+};
+
+/**
+ * @brief Time from accept() to the first request byte read, plaintext connections only
+ *
+ * A client that sends at once has its bytes waiting when the connection is
+ * accepted, so this is the in-process delay (thread start, scheduling,
+ * busy threads) before the server reads it; clients that connect early and
+ * send later add their own think time. Queueing before accept() shows in
+ * ListenQueueStats instead.
+ */
+struct FirstByteLatency
+{
+    static constexpr size_t kBuckets = 13;                          ///< Bounds below, then one bucket above them all
+    static constexpr uint32_t kBoundsUs[kBuckets - 1] =
+        {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000, 250000, 1000000};
+
+    uint64_t buckets[kBuckets] = {};    ///< Connections per bucket (not cumulative)
+    uint64_t count = 0;                 ///< Connections measured
+    uint64_t sum_us = 0;                ///< Sum of their latencies
+
+    /**
+     * @brief Upper bound of the bucket holding a quantile
+     * @param quantile 0..1
+     * @return Bound in microseconds (UINT32_MAX past the last bound, 0 with no samples)
+     */
+    uint32_t QuantileUs(double quantile) const;
+
+    /**
+     * @brief Add another histogram (several listeners)
+     */
+    void Merge(const FirstByteLatency& other);
+};
+
+/**
+ * @brief Connection counters of one SocketServer
+ */
+struct ConnectionStats
+{
+    size_t active = 0;          ///< Connections served by client threads now
+    uint64_t accepted = 0;      ///< Connections accepted since Start
+    uint64_t rejected = 0;      ///< Connections turned away at the limit
+    uint64_t accept_wakeups = 0;///< Readiness events on the listeners (accepted / wakeups: average batch)
+    uint64_t migrated_out = 0;  ///< Idle connections passed to another process
+    uint64_t migrated_in = 0;   ///< Connections adopted from another process
+    uint64_t cpu_local = 0;     ///< Accepted on the CPU that received the connection (cpu_stats)
+    uint64_t cpu_remote = 0;    ///< Accepted on another CPU than the one that received it (cpu_stats)
+    uint64_t zerocopy_sends = 0;///< Responses sent with MSG_ZEROCOPY
+    uint64_t zerocopy_copied = 0;///< Of which the kernel copied anyway (loopback, no scatter-gather NIC)
+    BusyPollStats busy_poll;    ///< Spin and park time (busy-poll mode)
+    ListenQueueStats listen_queue; ///< TCP accept queue (SampleListenQueue)
+    FirstByteLatency first_byte;///< Accept-to-first-byte latency
+};
+
+/**
+ * @brief Result of offering a request to the pass-through handler
+ */
+enum class PassthroughResult
+{
+    Declined,       ///< Not handled; the request is read and dispatched normally
+    KeepAlive,      ///< Response sent; the connection can serve the next request
+    Close,          ///< Response sent (or failed); the connection must be closed
+    Detached        ///< The handler took the socket over (CONNECT tunnel) and closes it itself
+};
+
+// Pass-through handler: offered every HTTP/1.x request as soon as its head has
+// arrived, before the body is read, so it can stream the body itself (reverse
+// proxy). Receives the connection, the receive buffer (starting with the head),
+// the head length and the peer address. When it handles the request it consumes
+// the head and body from the buffer and writes the whole response itself.
+using PassthroughHandler = std::function<PassthroughResult(SOCKET client_socket, std::string& buffer,
+                                                           size_t head_size, const std::string& client_ip)>;
+
 /**
  * @brief Cross-platform network socket server
  * 
@@ -84,14 +275,18 @@ public:
      * Creates a socket, binds it to the specified address and port,
      * and starts listening for incoming connections.
      * If host is empty or "0.0.0.0", it will bind to all available interfaces.
+     * A port of 0 skips TCP entirely, leaving only the local socket.
+     * When a local socket path is given, an AF_UNIX stream socket is bound as
+     * well; its connections go through the same HTTP pipeline, with
+     * "unix:" as the peer address. A stale socket file at the path is replaced.
      */
-    bool Start(const std::string& host, int port);
+    bool Start(const std::string& host, int port, const LocalSocketOptions& local_socket = {});
     
     /**
      * @brief Stop server (close listening socket)
      * 
      * @details
-     * Closes the listening socket and stops accepting new connections.
+     * Closes the listening sockets (removing the socket file) and stops accepting new connections.
      * Established connections will be closed naturally.
      */
     void Stop();
@@ -104,9 +299,209 @@ public:
      * Starts accepting client connections and processing requests.
      * This method will block until the server is stopped.
      * Each client connection is handled in a separate thread.
+     * HTTP/1.1 connections are kept alive (pipelined requests are answered
+     * in order); connections that open with the HTTP/2 preface or ask for
+     * "Upgrade: h2c" are served by Http2Connection.
      */
     void Run(RequestHandler handler);
+
+    /**
+     * @brief Set the handler that takes over upgraded and streaming connections
+     * @param handler Hand-off handler (must be set before Run)
+     *
+     * @details
+     * Called after a 101 Switching Protocols response or a response without
+     * Content-Length (its body runs until the connection closes). Without a
+     * handler (or when it declines) the connection is closed.
+     */
+    void SetHandoffHandler(HandoffHandler handler);
+
+    /**
+     * @brief Set the handler offered each HTTP/1.x request before its body is read
+     * @param handler Pass-through handler (must be set before Run)
+     */
+    void SetPassthroughHandler(PassthroughHandler handler);
+
+    /**
+     * @brief Set the handler that may move idle connections to another process
+     * @param handler Migration handler (must be set before Run)
+     *
+     * @details Only plaintext connections are offered: a TLS session lives in
+     * this process's memory.
+     */
+    void SetMigrationHandler(MigrationHandler handler);
+
+    /**
+     * @brief Serve a connection another process migrated here
+     * @param client_socket Connected socket (ownership passes to the server)
+     * @param buffered Bytes the previous owner read past its last request
+     * @param client_ip Peer address
+     * @param handler Request handler (the one given to Run)
+     * @return false if the server is not running (the socket is closed)
+     *
+     * @details The connection gets a client thread like an accepted one and
+     * continues with its next request.
+     */
+    bool Adopt(SOCKET client_socket, std::string buffered, const std::string& client_ip, RequestHandler handler);
+
+    /**
+     * @brief Set connection limits
+     * @param limits Connection cap, timeouts and request size (must be set before Run)
+     *
+     * @details
+     * Every connection owns a thread, so the cap is also this server's thread
+     * budget. A connection accepted beyond it is answered with 503 and closed
+     * at once, keeping the accept loop responsive.
+     */
+    void SetLimits(const ConnectionLimits& limits);
+
+    /**
+     * @brief Inflate Content-Encoding request bodies while they are received
+     * @param limits Size and ratio limits (must be set before Run)
+     *
+     * @details
+     * Body bytes are fed to the decoder as they arrive, so only the decoded
+     * body is accumulated and a request breaking a limit (or using an unknown
+     * coding) is answered 413/415/400 and closed without reading the rest.
+     * The handler receives the decoded body with Content-Encoding removed and
+     * Content-Length corrected. Without this, bodies are passed on as sent.
+     */
+    void SetDecompressionLimits(const http::DecompressionLimits& limits);
+
+    /**
+     * @brief Set the TCP socket options
+     * @param tuning Listener and per-connection options (must be set before Start)
+     *
+     * @details
+     * Listener options also apply to inherited sockets, except the buffer
+     * sizes, which only take full effect before listen().
+     */
+    void SetTuning(const SocketTuning& tuning);
+
+    /**
+     * @brief Select the busy-poll mode
+     * @param options Spin budget and kernel busy polling (must be set before Run)
+     */
+    void SetBusyPoll(const BusyPollOptions& options);
+
+    /**
+     * @brief Busy-poll settings set by SetBusyPoll
+     */
+    const BusyPollOptions& GetBusyPoll() const { return m_busy_poll; }
+
+    /**
+     * @brief Terminate TLS on TCP connections
+     * @param tls TLS context (nullptr: plaintext; must be set before Run)
+     *
+     * @details
+     * The client thread runs the handshake and serves the decrypted stream
+     * like any other connection. Unix socket peers stay plaintext.
+     */
+    void SetTls(std::shared_ptr<TlsContext> tls);
+
+    /**
+     * @brief TLS context set by SetTls (nullptr: plaintext)
+     */
+    const std::shared_ptr<TlsContext>& GetTls() const { return m_tls; }
+
+    /**
+     * @brief Snapshot of the connection counters
+     */
+    ConnectionStats GetConnectionStats() const;
+
+    /**
+     * @brief Sample the TCP listener's accept queue (called periodically by the owner)
+     *
+     * @details Reads TCP_INFO, which on a listening socket reports the queue
+     * length and its limit. Linux only; a no-op elsewhere.
+     */
+    void SampleListenQueue();
+
+    /**
+     * @brief Read the host's ListenOverflows and ListenDrops counters
+     * @param counters Receives the values
+     * @return false where /proc/net/netstat is unavailable
+     */
+    static bool ReadListenDrops(ListenDropCounters& counters);
     
+    /**
+     * @brief Bind and listen on a Unix domain socket (POSIX only)
+     * @param options Path, namespace and permissions
+     * @param backlog listen() backlog (the kernel caps it at net.core.somaxconn)
+     * @return Listening socket, or INVALID_SOCKET (the reason is logged)
+     *
+     * @details A stale socket file at the path is replaced. The caller owns
+     * the socket and removes the file when done.
+     */
+    static SOCKET OpenLocalListener(const LocalSocketOptions& options, int backlog = SOMAXCONN);
+
+    /**
+     * @brief Bind and listen on a TCP port
+     * @param host Binding IP address ("0.0.0.0" or empty: all interfaces)
+     * @param port Listening port
+     * @param reuse_port Set SO_REUSEPORT so several sockets share the port, each with its own queue
+     * @param tuning Socket options and backlog
+     * @return Listening socket, or INVALID_SOCKET (the reason is logged)
+     */
+    static SOCKET OpenTcpListener(const std::string& host, int port, bool reuse_port = false,
+                                  const SocketTuning& tuning = {});
+
+    /**
+     * @brief Steer connections in a SO_REUSEPORT group by the CPU that received them
+     * @param listener Any member of the group, after every member is listening
+     * @param cpus CPU of each member, in the order the members started listening
+     * @return false if the program cannot be attached (the reason is logged); the kernel then hashes as before
+     *
+     * @details Attaches a classic BPF program picking the member whose CPU
+     * received the SYN, or the CPU number modulo the group size for a CPU
+     * without a member. Linux only.
+     */
+    static bool AttachCpuSteering(SOCKET listener, const std::vector<int>& cpus);
+
+    /**
+     * @brief Listen on sockets inherited from another process instead of binding
+     * @param tcp_listener Listening TCP socket (INVALID_SOCKET: bind as usual)
+     * @param local_listener Listening Unix domain socket (INVALID_SOCKET: bind as usual)
+     *
+     * @details
+     * Applies to the next Start. A TCP socket bound to a different port than
+     * the one Start is given is closed and a fresh one is bound.
+     */
+    void Inherit(SOCKET tcp_listener, SOCKET local_listener);
+
+    /**
+     * @brief Listening TCP socket (INVALID_SOCKET if none)
+     */
+    SOCKET GetTcpListener() const { return m_server_socket; }
+
+    /**
+     * @brief Listening Unix domain socket (INVALID_SOCKET if none)
+     */
+    SOCKET GetLocalListener() const { return m_local_socket; }
+
+    /**
+     * @brief Stop accepting after the listening sockets were passed to another process
+     *
+     * @details
+     * Unlike Stop, the sockets are neither shut down (the other process
+     * accepts on them now) nor is the socket file removed; only this
+     * process's descriptors are closed.
+     */
+    void Release();
+
+    /**
+     * @brief Let open connections finish after the server stopped accepting
+     * @param timeout Longest wait
+     * @return Connections still open at the deadline (they are then shut down)
+     *
+     * @details
+     * Responses from now on carry "Connection: close", so busy keep-alive
+     * connections end after their next response. Connections that sit idle
+     * for a short grace period are closed; a client that sends just then
+     * sees a closed reused connection, which HTTP clients retry.
+     */
+    size_t Drain(std::chrono::milliseconds timeout);
+
     /**
      * @brief Running state
      * @return true if the server is running
@@ -120,35 +515,183 @@ public:
     std::string GetAddress() const;
 
 private:
+    /**
+     * @brief Bind and listen on the TCP port
+     * @param host Binding IP address
+     * @param port Listening port
+     * @return true if listening
+     */
+    bool StartTcp(const std::string& host, int port);
+
+    /**
+     * @brief Bind and listen on the Unix domain socket
+     * @param options Path, namespace and permissions
+     * @return true if listening
+     */
+    bool StartLocalSocket(const LocalSocketOptions& options);
+
+    /**
+     * @brief Accept one connection and hand it to a client thread
+     * @param listener Readable listening socket
+     * @param handler Request handler
+     * @return false once the accept queue is empty, or after backing off from a failed accept
+     */
+    bool AcceptClient(SOCKET listener, const RequestHandler& handler);
+
+    /**
+     * @brief Answer a connection beyond the limit with 503 and close it
+     * @param client_socket Freshly accepted socket
+     */
+    static void RejectClient(SOCKET client_socket);
+
+    /**
+     * @brief Wait for the next request on a kept-alive connection, closable by Drain meanwhile
+     * @param client_socket Client socket
+     * @param buffer Per-connection receive buffer (empty)
+     * @return false if the peer closed, timed out or the server is draining
+     */
+    bool ReceiveIdle(SOCKET client_socket, std::string& buffer);
+
+    /**
+     * @brief Track a connection for Drain
+     * @param client_socket Client socket
+     * @param idle Waiting between requests
+     */
+    void TrackConnection(SOCKET client_socket, bool idle);
+
+    /**
+     * @brief Stop tracking a connection (before it is closed or handed off)
+     * @param client_socket Client socket
+     */
+    void UntrackConnection(SOCKET client_socket);
+
     /**
      * @brief Handle a single client connection
      * @param client_socket Client socket
      * @param handler Request handler
      * @param client_ip Client IP address
+     * @param migratable May be offered to the migration handler (plaintext)
+     * @param adopted Migrated from another process: continues between requests with `buffered`
+     * @param buffered Bytes received past the previous owner's last request
+     * @param accepted_at When accept() returned (epoch: not measured), for the first-byte latency
      */
-    void HandleClient(SOCKET client_socket, RequestHandler handler, const std::string& client_ip);
+    void HandleClient(SOCKET client_socket, RequestHandler handler, const std::string& client_ip,
+                      bool migratable, bool adopted = false, std::string buffered = {},
+                      std::chrono::steady_clock::time_point accepted_at = {});
     
     /**
-     * @brief Receive data from client
+     * @brief Wait until the buffer holds a complete HTTP/1.x request head
+     * @param client_socket Client socket
+     * @param buffer Per-connection receive buffer
+     * @param head_size Receives the head length including the blank line
+     * @return false if the peer closed, timed out, or sent oversized headers
+     */
+    bool ReceiveHead(SOCKET client_socket, std::string& buffer, size_t& head_size);
+
+    /**
+     * @brief Complete a request whose head is at the start of the buffer
+     * @param client_socket Client socket
+     * @param buffer Per-connection receive buffer; bytes past the request
+     *        (pipelined requests) are left in it for the next call
+     * @param head_size Head length returned by ReceiveHead
+     * @param request Receives the request (head and Content-Length body, decoded if SetDecompressionLimits was called)
+     * @return false if the peer closed, timed out, or sent an oversized or undecodable request
+     */
+    bool ReceiveRequest(SOCKET client_socket, std::string& buffer, size_t head_size, std::string& request);
+
+    /**
+     * @brief Receive a Content-Encoding body, inflating each chunk as it arrives
      * @param client_socket Client socket
-     * @return Received data
+     * @param buffer Per-connection receive buffer starting with the request head
+     * @param head_size Head length
+     * @param content_length Encoded body length
+     * @param encoding Content-Encoding header value
+     * @param request Receives the head (rewritten for the decoded body) and the decoded body
+     * @return false if the peer closed, or the body broke a limit or could not be decoded (an error response was sent)
      */
-    std::string ReceiveData(SOCKET client_socket);
+    bool ReceiveDecodedBody(SOCKET client_socket, std::string& buffer, size_t head_size,
+                            size_t content_length, const std::string& encoding, std::string& request);
+
+    /**
+     * @brief Append the next chunk received from a connection to its buffer
+     * @param client_socket Client socket
+     * @param buffer Per-connection receive buffer
+     * @param idle Waiting between requests (closing then is not an error)
+     * @return false if the peer closed or the receive failed
+     */
+    bool ReceiveMore(SOCKET client_socket, std::string& buffer, bool idle);
+
+    /**
+     * @brief Receive from a client socket, spinning first in busy-poll mode
+     * @param client_socket Client socket
+     * @param data Destination
+     * @param size Destination size
+     * @return recv() result
+     */
+    int Receive(SOCKET client_socket, char* data, int size);
+
+    /**
+     * @brief Spin until a nonblocking check succeeds or the budget runs out
+     * @param budget Spin budget of the calling thread
+     * @param ready Nonblocking check, true when the wait is over
+     * @return true if ready; otherwise the caller parks and reports it with EndPark
+     */
+    bool Spin(std::chrono::nanoseconds budget, const std::function<bool()>& ready);
+
+    /**
+     * @brief Account a finished park and adapt the spin budget
+     * @param budget Spin budget of the calling thread
+     * @param parked_at When the blocking wait began
+     */
+    void EndPark(std::chrono::nanoseconds& budget, std::chrono::steady_clock::time_point parked_at);
+
+    /**
+     * @brief Decide whether the connection stays open after this request
+     * @param request Raw request
+     * @return true for HTTP/1.1 without "Connection: close" and for
+     *         HTTP/1.0 with "Connection: keep-alive"
+     */
+    static bool IsKeepAlive(const std::string& request);
     
     /**
      * @brief Send data to client
      * @param client_socket Client socket
      * @param data Data to send
+     * @param zerocopy_declined The connection's zero-copy state: set once the kernel copies or refuses
+     *        MSG_ZEROCOPY, after which it is not tried again (nullptr: always a plain send)
      * @return true if sent successfully
      */
-    bool SendData(SOCKET client_socket, const std::string& data);
+    bool SendData(SOCKET client_socket, const std::string& data, bool* zerocopy_declined = nullptr);
+
+    /**
+     * @brief Send data with MSG_ZEROCOPY and wait until the kernel releases it
+     * @param client_socket Client socket with SO_ZEROCOPY set
+     * @param data Data to send; must stay unchanged until this returns
+     * @param declined Set when the socket cannot (or can no longer) send zero-copy
+     * @param sent Bytes handed to the kernel; when declined, the rest is for a plain send()
+     * @return true if sent and every completion arrived
+     *
+     * @details The pages are pinned rather than copied, so the buffer is only
+     * safe to reuse once a completion on the socket's error queue covers
+     * every send() call. Linux only.
+     */
+    bool SendZeroCopy(SOCKET client_socket, const std::string& data, bool& declined, size_t& sent);
     
     /**
-     * @brief Set socket options
+     * @brief Set listening socket options
+     * @param listener Socket to configure
+     * @param reuse_port Also set SO_REUSEPORT
      * @return true if set successfully
      */
-    bool SetSocketOptions();
+    static bool SetSocketOptions(SOCKET listener, bool reuse_port);
     
+    /**
+     * @brief Apply the listener options that still work after listen()
+     * @param listener Listening TCP socket
+     * @param tuning Options (backlog, TCP_DEFER_ACCEPT, TCP_FASTOPEN)
+     */
+    static void ApplyListenerTuning(SOCKET listener, const SocketTuning& tuning);
+
     /**
      * @brief Set client socket timeout
      * @param client_socket Client socket
@@ -170,9 +713,48 @@ private:
 
 private:
     SOCKET m_server_socket;                     ///< Server socket descriptor
+    SOCKET m_local_socket = INVALID_SOCKET;     ///< Unix domain listening socket
+    LocalSocketOptions m_local_options;         ///< Unix domain socket settings (file removed on Stop)
     std::atomic<bool> m_is_running;             ///< Server running state
     std::string m_host;                         ///< Bound host address
     int m_port;                                 ///< Listening port
+    HandoffHandler m_handoff_handler;           ///< Takes over upgraded and streaming connections
+    PassthroughHandler m_passthrough_handler;   ///< Streams requests it claims (reverse proxy)
+    MigrationHandler m_migration_handler;       ///< Moves idle connections to another process
+    ConnectionLimits m_limits;                  ///< Connection cap, timeouts, request size
+    http::DecompressionLimits m_decompression;  ///< Limits for bodies inflated while received
+    bool m_decompress = false;                  ///< Inflate Content-Encoding bodies in ReceiveRequest
+    std::shared_ptr<TlsContext> m_tls;          ///< TLS on TCP connections (nullptr: plaintext)
+    SocketTuning m_tuning;                      ///< TCP socket options
+    BusyPollOptions m_busy_poll;                ///< Spin-then-park waits
+    std::atomic<size_t> m_active{0};            ///< Connections served by client threads
+    std::atomic<uint64_t> m_accepted{0};        ///< Accepted since Start
+    std::atomic<uint64_t> m_rejected{0};        ///< Turned away at the cap
+    std::atomic<uint64_t> m_accept_wakeups{0};  ///< Readiness events handled by Run
+    uint64_t m_accept_errors = 0;               ///< Failed accepts since the last log line (accept thread)
+    std::chrono::steady_clock::time_point m_accept_error_logged; ///< Last "Accept failed" log line
+    std::atomic<uint64_t> m_migrated_out{0};    ///< Connections passed to another process
+    std::atomic<uint64_t> m_migrated_in{0};     ///< Connections adopted
+    std::atomic<uint64_t> m_cpu_local{0};       ///< Accepted on the receiving CPU
+    std::atomic<uint64_t> m_cpu_remote{0};      ///< Accepted away from the receiving CPU
+    std::atomic<uint64_t> m_zerocopy_sends{0};  ///< Responses sent with MSG_ZEROCOPY
+    std::atomic<uint64_t> m_zerocopy_copied{0}; ///< Zero-copy responses the kernel copied anyway
+    std::atomic<uint64_t> m_spin_hits{0};       ///< Busy-poll waits that ended while spinning
+    std::atomic<uint64_t> m_parks{0};           ///< Busy-poll waits that blocked
+    std::atomic<uint64_t> m_spin_ns{0};         ///< Time spent spinning
+    std::atomic<uint64_t> m_park_ns{0};         ///< Time spent parked
+    std::atomic<uint32_t> m_queue_length{0};    ///< Accept queue at the last sample
+    std::atomic<uint32_t> m_queue_backlog{0};   ///< Accept queue limit
+    std::atomic<uint32_t> m_queue_peak{0};      ///< Longest accept queue sampled
+    std::atomic<uint64_t> m_queue_samples{0};   ///< Accept queue samples
+    std::array<std::atomic<uint64_t>, FirstByteLatency::kBuckets> m_first_byte{}; ///< Accept-to-first-byte histogram
+    std::atomic<uint64_t> m_first_byte_us{0};   ///< Sum of accept-to-first-byte latencies
+    SOCKET m_inherited_tcp = INVALID_SOCKET;    ///< Passed in by Inherit for the next Start
+    SOCKET m_inherited_local = INVALID_SOCKET;  ///< Passed in by Inherit for the next Start
+    int m_wake_pipe[2] = {-1, -1};              ///< Wakes the accept loop on Release (POSIX)
+    std::atomic<bool> m_draining{false};        ///< Drain in progress: no more keep-alive
+    std::mutex m_connections_mutex;             ///< Guards m_connections and socket shutdown
+    std::unordered_map<SOCKET, std::chrono::steady_clock::time_point> m_connections; ///< Open client sockets and when they went idle (epoch: busy)
 };
 
 } // namespace miniserver::network
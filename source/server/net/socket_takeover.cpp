@@ -0,0 +1,354 @@
+/**
+ * @file socket_takeover.cpp
+ * @brief Listening-socket handoff implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/socket_takeover.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <cstddef>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+    constexpr size_t kMaxSockets = 64;          ///< Sockets passed in one message
+    constexpr char kReady = 'R';                ///< Replacement's confirmation byte
+
+#if defined(__linux__)
+    /**
+     * @brief Fill a sockaddr_un for a path or abstract name
+     */
+    bool MakeAddress(const LocalSocketOptions& options, sockaddr_un& address, socklen_t& length)
+    {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        const size_t offset = options.abstract ? 1 : 0;
+        if (options.path.empty() || options.path.size() + offset >= sizeof(address.sun_path))
+        {
+            return false;
+        }
+        std::memcpy(address.sun_path + offset, options.path.data(), options.path.size());
+        length = options.abstract
+            ? static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + options.path.size())
+            : static_cast<socklen_t>(sizeof(address));
+        return true;
+    }
+#endif
+}
+
+TakeoverServer::TakeoverServer(TakeoverProvider provider, TakeoverCompletion completion)
+    : m_provider(std::move(provider))
+    , m_completion(std::move(completion))
+{
+}
+
+TakeoverServer::~TakeoverServer()
+{
+    Stop();
+}
+
+bool TakeoverServer::Start(const LocalSocketOptions& options, std::chrono::milliseconds ready_timeout,
+                           SOCKET inherited)
+{
+#if defined(__linux__)
+    if (m_running.load() || !m_provider)
+    {
+        if (inherited != INVALID_SOCKET)
+        {
+            close(inherited);
+        }
+        return false;
+    }
+    m_options = options;
+    m_ready_timeout = ready_timeout;
+    m_handed_over.store(false);
+
+    // An abstract name stays taken while the old process lives, so it passes its socket along
+    m_listener = inherited != INVALID_SOCKET ? inherited : SocketServer::OpenLocalListener(m_options);
+    if (m_listener == INVALID_SOCKET)
+    {
+        return false;
+    }
+    m_running.store(true);
+    m_thread = std::thread(&TakeoverServer::AcceptLoop, this);
+    return true;
+#else
+    (void)options;
+    (void)ready_timeout;
+    (void)inherited;
+    LOG_ERROR(TakeoverServer, "Socket takeover needs Linux (SCM_RIGHTS)");
+    return false;
+#endif
+}
+
+void TakeoverServer::Stop()
+{
+#if defined(__linux__)
+    if (!m_running.exchange(false) && !m_thread.joinable())
+    {
+        return;
+    }
+
+    // Shutting the listener down wakes accept(); after a takeover the replacement accepts on it
+    if (m_listener != INVALID_SOCKET && !m_handed_over.load())
+    {
+        shutdown(m_listener, SHUT_RDWR);
+    }
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    if (m_listener != INVALID_SOCKET)
+    {
+        close(m_listener);
+        m_listener = INVALID_SOCKET;
+        if (!m_options.abstract && !m_handed_over.load())
+        {
+            unlink(m_options.path.c_str());
+        }
+    }
+#endif
+}
+
+void TakeoverServer::AcceptLoop()
+{
+#if defined(__linux__)
+    while (m_running.load())
+    {
+        const SOCKET client_socket = accept4(m_listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_socket == INVALID_SOCKET)
+        {
+            if (errno != EINTR && errno != ECONNABORTED && m_running.load())
+            {
+                LOG_ERROR_FMT(TakeoverServer, "Accept failed: {}", std::strerror(errno));
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+
+        const bool confirmed = HandOver(client_socket);
+        close(client_socket);
+        if (confirmed)
+        {
+            m_handed_over.store(true);
+            LOG_INFO(TakeoverServer, "Replacement process took over the listening sockets");
+            m_completion();
+            return;
+        }
+        LOG_WARN(TakeoverServer, "Replacement process did not confirm the takeover, still serving");
+    }
+#endif
+}
+
+bool TakeoverServer::HandOver(SOCKET client_socket)
+{
+#if defined(__linux__)
+    // Manifest: one "name\ttcp|unix" line per socket in descriptor order, the takeover socket, an empty line
+    std::string manifest;
+    std::vector<int> descriptors;
+    for (const InheritedListener& listener : m_provider())
+    {
+        if (listener.socket == INVALID_SOCKET || descriptors.size() == kMaxSockets - 1)
+        {
+            continue;
+        }
+        manifest += listener.name + (listener.local ? "\tunix\n" : "\ttcp\n");
+        descriptors.push_back(listener.socket);
+    }
+    manifest += "\ttakeover\n\n";
+    descriptors.push_back(m_listener);
+
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * descriptors.size()), 0);
+    iovec iov{manifest.data(), manifest.size()};
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int) * descriptors.size());
+    std::memcpy(CMSG_DATA(header), descriptors.data(), sizeof(int) * descriptors.size());
+    if (sendmsg(client_socket, &message, MSG_NOSIGNAL) != static_cast<ssize_t>(manifest.size()))
+    {
+        LOG_ERROR_FMT(TakeoverServer, "Cannot pass listening sockets: {}", std::strerror(errno));
+        return false;
+    }
+    LOG_INFO_FMT(TakeoverServer, "Passed {} listening sockets, waiting for the replacement", descriptors.size() - 1);
+
+    // The replacement confirms once its accept loops run on them
+    pollfd entry{client_socket, POLLIN, 0};
+    char reply = 0;
+    return poll(&entry, 1, static_cast<int>(m_ready_timeout.count())) > 0 &&
+        recv(client_socket, &reply, 1, 0) == 1 && reply == kReady;
+#else
+    (void)client_socket;
+    return false;
+#endif
+}
+
+TakeoverClient::~TakeoverClient()
+{
+#if defined(__linux__)
+    for (const InheritedListener& listener : m_listeners)
+    {
+        close(listener.socket);
+    }
+    if (m_takeover_socket != INVALID_SOCKET)
+    {
+        close(m_takeover_socket);
+    }
+    if (m_socket != INVALID_SOCKET)
+    {
+        close(m_socket);
+    }
+#endif
+}
+
+bool TakeoverClient::Connect(const LocalSocketOptions& options)
+{
+#if defined(__linux__)
+    sockaddr_un address;
+    socklen_t address_len = 0;
+    if (m_socket != INVALID_SOCKET || !MakeAddress(options, address, address_len))
+    {
+        return false;
+    }
+    m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_socket == INVALID_SOCKET || connect(m_socket, reinterpret_cast<sockaddr*>(&address), address_len) != 0)
+    {
+        if (m_socket != INVALID_SOCKET)
+        {
+            close(m_socket);
+            m_socket = INVALID_SOCKET;
+        }
+        return false;
+    }
+
+    // The descriptors ride on the first bytes of the manifest
+    timeval timeout{5, 0};
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    char buffer[4096];
+    iovec iov{buffer, sizeof(buffer)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxSockets)];
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t received;
+    do
+    {
+        received = recvmsg(m_socket, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0)
+    {
+        close(m_socket);
+        m_socket = INVALID_SOCKET;
+        return false;
+    }
+
+    std::vector<int> descriptors;
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header))
+    {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS)
+        {
+            const size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const size_t first = descriptors.size();
+            descriptors.resize(first + count);
+            std::memcpy(descriptors.data() + first, CMSG_DATA(header), count * sizeof(int));
+        }
+    }
+
+    std::string manifest(buffer, static_cast<size_t>(received));
+    while ((manifest.size() < 2 || manifest.compare(manifest.size() - 2, 2, "\n\n") != 0))
+    {
+        received = recv(m_socket, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            break;
+        }
+        manifest.append(buffer, static_cast<size_t>(received));
+    }
+
+    size_t index = 0;
+    for (size_t start = 0; start < manifest.size();)
+    {
+        const size_t end = std::min(manifest.find('\n', start), manifest.size());
+        const std::string line = manifest.substr(start, end - start);
+        const size_t tab = line.find('\t');
+        if (tab != std::string::npos && index < descriptors.size() && line.compare(tab + 1, std::string::npos, "takeover") == 0)
+        {
+            m_takeover_socket = descriptors[index++];
+        }
+        else if (tab != std::string::npos && index < descriptors.size())
+        {
+            m_listeners.push_back({line.substr(0, tab), line.compare(tab + 1, std::string::npos, "unix") == 0,
+                                   descriptors[index++]});
+        }
+        start = end + 1;
+    }
+    for (; index < descriptors.size(); ++index)
+    {
+        close(descriptors[index]);
+    }
+    LOG_INFO_FMT(TakeoverClient, "Received {} listening sockets from the running process", m_listeners.size());
+    return true;
+#else
+    (void)options;
+    return false;
+#endif
+}
+
+SOCKET TakeoverClient::Take(const std::string& name, bool local)
+{
+    auto it = std::find_if(m_listeners.begin(), m_listeners.end(), [&](const InheritedListener& listener)
+    {
+        return listener.name == name && listener.local == local;
+    });
+    if (it == m_listeners.end())
+    {
+        return INVALID_SOCKET;
+    }
+    const SOCKET taken = it->socket;
+    m_listeners.erase(it);
+    return taken;
+}
+
+SOCKET TakeoverClient::TakeTakeoverSocket()
+{
+    return std::exchange(m_takeover_socket, INVALID_SOCKET);
+}
+
+bool TakeoverClient::Confirm()
+{
+#if defined(__linux__)
+    const bool sent = m_socket != INVALID_SOCKET && send(m_socket, &kReady, 1, MSG_NOSIGNAL) == 1;
+    if (m_socket != INVALID_SOCKET)
+    {
+        close(m_socket);
+        m_socket = INVALID_SOCKET;
+    }
+    return sent;
+#else
+    return false;
+#endif
+}
+
+} // namespace miniserver::network
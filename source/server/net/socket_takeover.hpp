@@ -0,0 +1,158 @@
+/**
+ * @file socket_takeover.hpp
+ * @brief Listening-socket handoff between an old and a new server process
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/socket_server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Listening socket passed from a running process to its replacement
+ */
+struct InheritedListener
+{
+    std::string name;                   ///< Listener name
+    bool local = false;                 ///< Unix domain socket (false: TCP)
+    SOCKET socket = INVALID_SOCKET;     ///< Listening socket
+};
+
+/**
+ * @brief Lists the sockets to hand over (they stay owned by the caller)
+ */
+using TakeoverProvider = std::function<std::vector<InheritedListener>()>;
+
+/**
+ * @brief Called once the replacement process accepts on the handed-over sockets
+ */
+using TakeoverCompletion = std::function<void()>;
+
+/**
+ * @brief Hands this process's listening sockets to a replacement process
+ *
+ * Listens on a Unix domain socket. A process that connects receives every
+ * listening socket in one SCM_RIGHTS message, the takeover socket included,
+ * and answers with one byte once it accepts on them. Only then is the
+ * completion called, so a replacement that dies during startup leaves this
+ * process serving as before.
+ *
+ * @details Linux only; Start() fails elsewhere.
+ */
+class TakeoverServer
+{
+public:
+    /**
+     * @brief Constructor
+     * @param provider Lists the listening sockets when a replacement connects
+     * @param completion Called after a replacement confirmed (on the takeover thread)
+     */
+    TakeoverServer(TakeoverProvider provider, TakeoverCompletion completion);
+
+    /**
+     * @brief Destructor (stops the server)
+     */
+    ~TakeoverServer();
+
+    TakeoverServer(const TakeoverServer&) = delete;
+    TakeoverServer& operator=(const TakeoverServer&) = delete;
+
+    /**
+     * @brief Wait for a replacement process
+     * @param options Takeover socket (mode 0600 keeps other users out)
+     * @param ready_timeout Longest wait for the replacement's confirmation
+     * @param inherited Takeover socket received from the replaced process (INVALID_SOCKET: bind)
+     * @return false if the socket cannot be bound or the platform lacks SCM_RIGHTS
+     */
+    bool Start(const LocalSocketOptions& options, std::chrono::milliseconds ready_timeout,
+               SOCKET inherited = INVALID_SOCKET);
+
+    /**
+     * @brief Stop waiting; after a takeover the socket (and its file) belongs to the replacement
+     */
+    void Stop();
+
+private:
+    /**
+     * @brief Accept replacements until one confirms or Stop
+     */
+    void AcceptLoop();
+
+    /**
+     * @brief Send the sockets to one replacement and wait for its confirmation
+     * @param client_socket Connection from the replacement
+     * @return true if the replacement confirmed
+     */
+    bool HandOver(SOCKET client_socket);
+
+    TakeoverProvider m_provider;                ///< Lists the sockets to pass
+    TakeoverCompletion m_completion;            ///< Runs after a confirmation
+    LocalSocketOptions m_options;               ///< Takeover socket
+    std::chrono::milliseconds m_ready_timeout{0}; ///< Wait for the confirmation
+    SOCKET m_listener = INVALID_SOCKET;         ///< Takeover socket
+    std::thread m_thread;                       ///< Runs AcceptLoop
+    std::atomic<bool> m_running{false};         ///< Waiting for replacements
+    std::atomic<bool> m_handed_over{false};     ///< A replacement confirmed
+};
+
+/**
+ * @brief Receives listening sockets from the process being replaced
+ */
+class TakeoverClient
+{
+public:
+    TakeoverClient() = default;
+
+    /**
+     * @brief Closes sockets nobody took and the connection (an unconfirmed takeover is abandoned)
+     */
+    ~TakeoverClient();
+
+    TakeoverClient(const TakeoverClient&) = delete;
+    TakeoverClient& operator=(const TakeoverClient&) = delete;
+
+    /**
+     * @brief Ask a running process for its listening sockets
+     * @param options Takeover socket of the running process
+     * @return false if no process answers there (nothing to take over)
+     */
+    bool Connect(const LocalSocketOptions& options);
+
+    /**
+     * @brief Take one received socket
+     * @param name Listener name
+     * @param local Unix domain socket rather than TCP
+     * @return Listening socket now owned by the caller, or INVALID_SOCKET
+     */
+    SOCKET Take(const std::string& name, bool local);
+
+    /**
+     * @brief Take the old process's takeover socket, to wait for the next replacement on
+     * @return Listening socket now owned by the caller, or INVALID_SOCKET
+     */
+    SOCKET TakeTakeoverSocket();
+
+    /**
+     * @brief Tell the old process the sockets are in use, so it stops accepting and drains
+     * @return false if the old process is gone
+     */
+    bool Confirm();
+
+private:
+    SOCKET m_socket = INVALID_SOCKET;           ///< Connection to the old process
+    std::vector<InheritedListener> m_listeners; ///< Received sockets not yet taken
+    SOCKET m_takeover_socket = INVALID_SOCKET;  ///< Received takeover socket not yet taken
+};
+
+} // namespace miniserver::network
@@ -0,0 +1,630 @@
+/**
+ * @file tls.cpp
+ * @brief TLS termination implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/tls.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(MINISERVER_HAS_OPENSSL) && !defined(_WIN32)
+    #define MINISERVER_TLS_ENABLED 1
+    #include <cerrno>
+    #include <csignal>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <pthread.h>
+    #include <unistd.h>
+    #include <openssl/err.h>
+    #include <openssl/evp.h>
+    #include <openssl/rand.h>
+    #include <openssl/ssl.h>
+    #if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        #include <openssl/core_names.h>
+    #endif
+#endif
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Serialized sessions keyed by session ID, split into shards with their own lock
+ *
+ * Handshakes on different connections rarely hit the same shard, so the
+ * cache does not serialize them. Each shard evicts its oldest entry when
+ * full; expired entries are dropped on lookup.
+ */
+class TlsSessionCache
+{
+public:
+    TlsSessionCache(size_t capacity, size_t shards)
+        : m_shards(std::max<size_t>(shards, 1))
+        , m_per_shard(std::max<size_t>(capacity / std::max<size_t>(shards, 1), 1))
+    {
+    }
+
+    void Store(const std::string& id, std::string session, std::chrono::steady_clock::time_point expires)
+    {
+        Shard& shard = ShardFor(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        while (shard.entries.size() >= m_per_shard && !shard.order.empty())
+        {
+            shard.entries.erase(shard.order.front());
+            shard.order.pop_front();
+        }
+        if (shard.entries.insert_or_assign(id, Entry{std::move(session), expires}).second)
+        {
+            shard.order.push_back(id);
+        }
+    }
+
+    bool Load(const std::string& id, std::string& session)
+    {
+        Shard& shard = ShardFor(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.entries.find(id);
+        if (it == shard.entries.end())
+        {
+            return false;
+        }
+        if (it->second.expires < std::chrono::steady_clock::now())
+        {
+            shard.entries.erase(it);
+            return false;
+        }
+        session = it->second.session;
+        return true;
+    }
+
+    void Remove(const std::string& id)
+    {
+        Shard& shard = ShardFor(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.erase(id);
+        // Keep the eviction queue from filling up with IDs that are gone
+        if (shard.order.size() > 2 * m_per_shard)
+        {
+            std::deque<std::string> live;
+            for (std::string& queued : shard.order)
+            {
+                if (shard.entries.count(queued) != 0)
+                {
+                    live.push_back(std::move(queued));
+                }
+            }
+            shard.order.swap(live);
+        }
+    }
+
+private:
+    struct Entry
+    {
+        std::string session;                                ///< DER-encoded SSL_SESSION
+        std::chrono::steady_clock::time_point expires;      ///< Session timeout
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;                                   ///< Guards this shard
+        std::unordered_map<std::string, Entry> entries;     ///< Sessions by ID
+        std::deque<std::string> order;                      ///< Insertion order (eviction)
+    };
+
+    Shard& ShardFor(const std::string& id)
+    {
+        return m_shards[std::hash<std::string>{}(id) % m_shards.size()];
+    }
+
+    std::vector<Shard> m_shards;        ///< Independently locked parts
+    size_t m_per_shard;                 ///< Entries per shard
+};
+
+#ifdef MINISERVER_TLS_ENABLED
+
+namespace
+{
+    constexpr size_t kRelayBuffer = 64 * 1024;      ///< Bytes buffered per direction in the relay
+    constexpr unsigned char kSessionContext[] = "mini-server";
+
+    /**
+     * @brief Keys of one ticket key period
+     */
+    struct TicketKey
+    {
+        unsigned char name[16];         ///< Sent in the ticket, selects the key on resumption
+        unsigned char cipher[32];       ///< AES-256-CBC key
+        unsigned char mac[32];          ///< HMAC-SHA256 key
+    };
+
+    int ContextIndex()
+    {
+        static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return index;
+    }
+
+    void SetNonBlocking(SOCKET socket)
+    {
+        fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+    }
+
+    std::string OpenSslError()
+    {
+        const unsigned long error = ERR_get_error();
+        ERR_clear_error();
+        if (error == 0)
+        {
+            return std::strerror(errno);
+        }
+        char text[256];
+        ERR_error_string_n(error, text, sizeof(text));
+        return text;
+    }
+}
+
+/**
+ * @brief OpenSSL callbacks (session cache, ticket keys, ALPN)
+ */
+struct TlsCallbacks
+{
+    static TlsContext* Self(SSL_CTX* context)
+    {
+        return static_cast<TlsContext*>(SSL_CTX_get_ex_data(context, ContextIndex()));
+    }
+
+    static std::string SessionId(const SSL_SESSION* session)
+    {
+        unsigned int length = 0;
+        const unsigned char* id = SSL_SESSION_get_id(session, &length);
+        return std::string(reinterpret_cast<const char*>(id), length);
+    }
+
+    static int NewSession(SSL* ssl, SSL_SESSION* session)
+    {
+        const int length = i2d_SSL_SESSION(session, nullptr);
+        if (length <= 0)
+        {
+            return 0;
+        }
+        std::string encoded(static_cast<size_t>(length), '\0');
+        unsigned char* out = reinterpret_cast<unsigned char*>(encoded.data());
+        i2d_SSL_SESSION(session, &out);
+        const auto expires = std::chrono::steady_clock::now() + std::chrono::seconds(SSL_SESSION_get_timeout(session));
+        Self(SSL_get_SSL_CTX(ssl))->m_cache->Store(SessionId(session), std::move(encoded), expires);
+        return 0;   // the cache keeps its own copy, not a reference
+    }
+
+    static SSL_SESSION* GetSession(SSL* ssl, const unsigned char* id, int length, int* copy)
+    {
+        *copy = 0;
+        std::string encoded;
+        if (!Self(SSL_get_SSL_CTX(ssl))->m_cache->Load(std::string(reinterpret_cast<const char*>(id), length), encoded))
+        {
+            return nullptr;
+        }
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(encoded.data());
+        return d2i_SSL_SESSION(nullptr, &in, static_cast<long>(encoded.size()));
+    }
+
+    static void RemoveSession(SSL_CTX* context, SSL_SESSION* session)
+    {
+        Self(context)->m_cache->Remove(SessionId(session));
+    }
+
+    static int SelectProtocol(SSL*, const unsigned char** out, unsigned char* out_length,
+                              const unsigned char* in, unsigned int in_length, void*)
+    {
+        // h2 is detected from the connection preface, so ALPN only has to agree on it
+        static const unsigned char kProtocols[] = "\x02h2\x08http/1.1";
+        unsigned char* selected = nullptr;
+        if (SSL_select_next_proto(&selected, out_length, kProtocols, sizeof(kProtocols) - 1, in, in_length) !=
+            OPENSSL_NPN_NEGOTIATED)
+        {
+            return SSL_TLSEXT_ERR_NOACK;
+        }
+        *out = selected;
+        return SSL_TLSEXT_ERR_OK;
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    /**
+     * @brief Keys for one rotation period: HMAC-SHA256(secret, label | period | block)
+     */
+    static TicketKey DeriveTicketKey(const TlsContext& self, uint64_t period)
+    {
+        unsigned char material[96];
+        for (unsigned char block = 0; block < 3; ++block)
+        {
+            unsigned char input[32] = "mini-server session tickets";
+            for (int i = 0; i < 8; ++i)
+            {
+                input[23 + i] = static_cast<unsigned char>(period >> (8 * i));
+            }
+            input[31] = block;
+            size_t length = 0;
+            EVP_Q_mac(nullptr, "HMAC", nullptr, "SHA256", nullptr, self.m_ticket_secret.data(),
+                      self.m_ticket_secret.size(), input, sizeof(input), material + 32 * block, 32, &length);
+        }
+        TicketKey key;
+        std::memcpy(key.name, material, sizeof(key.name));
+        std::memcpy(key.cipher, material + 16, sizeof(key.cipher));
+        std::memcpy(key.mac, material + 48, sizeof(key.mac));
+        return key;
+    }
+
+    static int TicketKeys(SSL* ssl, unsigned char name[16], unsigned char iv[EVP_MAX_IV_LENGTH],
+                          EVP_CIPHER_CTX* cipher, EVP_MAC_CTX* mac, int encrypt)
+    {
+        const TlsContext& self = *Self(SSL_get_SSL_CTX(ssl));
+        // Wall clock, so every process holding the secret is in the same period
+        const uint64_t period = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count()) /
+            static_cast<uint64_t>(std::max<std::chrono::seconds::rep>(self.m_options.session_lifetime.count(), 1));
+
+        TicketKey key = DeriveTicketKey(self, period);
+        int result = 1;
+        if (encrypt)
+        {
+            if (RAND_bytes(iv, 16) != 1)
+            {
+                return -1;
+            }
+            std::memcpy(name, key.name, sizeof(key.name));
+        }
+        else if (std::memcmp(name, key.name, sizeof(key.name)) != 0)
+        {
+            // Tickets from the previous period still resume, and get replaced by a current one
+            key = DeriveTicketKey(self, period - 1);
+            if (std::memcmp(name, key.name, sizeof(key.name)) != 0)
+            {
+                return 0;
+            }
+            result = 2;
+        }
+
+        OSSL_PARAM parameters[] = {
+            OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.mac, sizeof(key.mac)),
+            OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0),
+            OSSL_PARAM_construct_end()};
+        const int ready = encrypt
+            ? EVP_EncryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.cipher, iv)
+            : EVP_DecryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.cipher, iv);
+        if (ready != 1 || EVP_MAC_CTX_set_params(mac, parameters) != 1)
+        {
+            return -1;
+        }
+        return result;
+    }
+#endif
+};
+
+#endif // MINISERVER_TLS_ENABLED
+
+bool TlsContext::IsAvailable()
+{
+#ifdef MINISERVER_TLS_ENABLED
+    return true;
+#else
+    return false;
+#endif
+}
+
+TlsContext::TlsContext(const TlsOptions& options)
+    : m_options(options)
+    , m_cache(std::make_unique<TlsSessionCache>(options.session_cache_size, options.session_cache_shards))
+{
+}
+
+TlsContext::~TlsContext()
+{
+#ifdef MINISERVER_TLS_ENABLED
+    if (m_context)
+    {
+        SSL_CTX_free(m_context);
+    }
+#endif
+}
+
+std::shared_ptr<TlsContext> TlsContext::Create(const TlsOptions& options)
+{
+#ifndef MINISERVER_TLS_ENABLED
+    (void)options;
+    LOG_ERROR(Tls, "TLS is not available: built without OpenSSL or on an unsupported platform");
+    return nullptr;
+#else
+    std::shared_ptr<TlsContext> tls(new TlsContext(options));
+    SSL_CTX* context = SSL_CTX_new(TLS_server_method());
+    if (!context)
+    {
+        LOG_ERROR(Tls, "Cannot create the TLS context: " + OpenSslError());
+        return nullptr;
+    }
+    tls->m_context = context;
+
+    if (SSL_CTX_use_certificate_chain_file(context, options.certificate_file.c_str()) != 1 ||
+        SSL_CTX_use_PrivateKey_file(context, options.key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(context) != 1)
+    {
+        LOG_ERROR(Tls, "Cannot load certificate " + options.certificate_file + " / key " + options.key_file + ": " +
+            OpenSslError());
+        return nullptr;
+    }
+
+    SSL_CTX_set_ex_data(context, ContextIndex(), tls.get());
+    SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+    // Most clients just close the connection; that is the end of the stream, not an error
+    long flags = SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE | SSL_OP_IGNORE_UNEXPECTED_EOF;
+    if (!options.session_tickets)
+    {
+        // TLS 1.3 then issues stateful tickets that resolve through the session cache
+        flags |= SSL_OP_NO_TICKET;
+    }
+#ifdef SSL_OP_ENABLE_KTLS
+    if (options.kernel_offload)
+    {
+        flags |= SSL_OP_ENABLE_KTLS;
+    }
+#endif
+    SSL_CTX_set_options(context, flags);
+    // The relay retries writes from a buffer that moves as it is refilled
+    SSL_CTX_set_mode(context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER |
+        SSL_MODE_RELEASE_BUFFERS);
+    SSL_CTX_set_alpn_select_cb(context, &TlsCallbacks::SelectProtocol, nullptr);
+
+    // Sessions live in the sharded cache, not OpenSSL's single-lock one
+    SSL_CTX_set_session_id_context(context, kSessionContext, sizeof(kSessionContext) - 1);
+    SSL_CTX_set_timeout(context, static_cast<long>(options.session_lifetime.count()));
+    SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(context, &TlsCallbacks::NewSession);
+    SSL_CTX_sess_set_get_cb(context, &TlsCallbacks::GetSession);
+    SSL_CTX_sess_set_remove_cb(context, &TlsCallbacks::RemoveSession);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (RAND_bytes(tls->m_ticket_secret.data(), static_cast<int>(tls->m_ticket_secret.size())) != 1)
+    {
+        LOG_ERROR(Tls, "Cannot generate the session ticket secret: " + OpenSslError());
+        return nullptr;
+    }
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(context, &TlsCallbacks::TicketKeys);
+#endif
+
+    LOG_INFO(Tls, "TLS enabled with " + options.certificate_file + " (" + OpenSSL_version(OPENSSL_VERSION) +
+        (options.session_tickets ? ", session tickets" : ", session cache") +
+        (options.kernel_offload ? ", kernel offload when available)" : ")"));
+    return tls;
+#endif
+}
+
+void TlsContext::Serve(SOCKET client_socket, const std::function<void(SOCKET plain_socket)>& serve)
+{
+#ifndef MINISERVER_TLS_ENABLED
+    // Unreachable: Create fails without TLS support
+    (void)client_socket;
+    (void)serve;
+#else
+    // OpenSSL writes with write(2): a peer that went away must not raise SIGPIPE in this thread
+    sigset_t pipe_signal;
+    sigemptyset(&pipe_signal);
+    sigaddset(&pipe_signal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_signal, nullptr);
+
+    const auto timeout_ms = m_options.handshake_timeout.count();
+    timeval timeout{static_cast<time_t>(timeout_ms / 1000), static_cast<suseconds_t>((timeout_ms % 1000) * 1000)};
+    setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    // Handshake flights and tickets go out as separate records; do not hold them back for ACKs
+    const int no_delay = 1;
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+    SSL* ssl = SSL_new(m_context);
+    if (!ssl || SSL_set_fd(ssl, client_socket) != 1 || SSL_accept(ssl) != 1)
+    {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        LOG_DEBUG(Tls, "Handshake failed: " + OpenSslError());
+        SSL_free(ssl);
+        close(client_socket);
+        return;
+    }
+    m_handshakes.fetch_add(1, std::memory_order_relaxed);
+    if (SSL_session_reused(ssl))
+    {
+        m_resumed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // With the kernel encrypting both directions the socket itself carries plaintext from here on
+    const bool kernel = BIO_get_ktls_send(SSL_get_wbio(ssl)) && BIO_get_ktls_recv(SSL_get_rbio(ssl)) &&
+        !SSL_has_pending(ssl);
+    if (kernel)
+    {
+        m_kernel.fetch_add(1, std::memory_order_relaxed);
+        SSL_free(ssl);
+        serve(client_socket);
+        return;
+    }
+
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0)
+    {
+        LOG_ERROR(Tls, "Cannot create the relay socket pair: " + std::string(std::strerror(errno)));
+        SSL_free(ssl);
+        close(client_socket);
+        return;
+    }
+    std::thread plaintext([&serve, inner = pair[0]]()
+    {
+        serve(inner);
+    });
+    Relay(ssl, client_socket, pair[1]);
+    // Whatever ended the relay, the HTTP side sees the connection close
+    shutdown(pair[1], SHUT_RDWR);
+    plaintext.join();
+
+    SSL_free(ssl);
+    close(pair[1]);
+    close(client_socket);
+#endif
+}
+
+void TlsContext::Relay(ssl_st* ssl, SOCKET client_socket, SOCKET inner_socket)
+{
+#ifndef MINISERVER_TLS_ENABLED
+    (void)ssl;
+    (void)client_socket;
+    (void)inner_socket;
+#else
+    SetNonBlocking(client_socket);
+    SetNonBlocking(inner_socket);
+
+    std::string to_inner;               // decrypted, not yet written to the plaintext side
+    std::string to_client;              // plaintext, not yet accepted by SSL_write
+    size_t to_inner_offset = 0;
+    size_t to_client_offset = 0;
+    bool client_eof = false;            // close_notify or EOF from the peer
+    bool inner_eof = false;             // the HTTP side closed
+    bool inner_shut = false;            // EOF forwarded to the HTTP side
+    bool wants_write = false;           // OpenSSL waits for the TCP socket to become writable
+    bool wants_read = false;            // SSL_write waits for a record from the peer (key update)
+    char chunk[16384];
+
+    while (true)
+    {
+        wants_write = false;
+        wants_read = false;
+
+        // Peer -> HTTP side
+        while (!client_eof && to_inner.size() < kRelayBuffer)
+        {
+            const int received = SSL_read(ssl, chunk, sizeof(chunk));
+            if (received > 0)
+            {
+                to_inner.append(chunk, static_cast<size_t>(received));
+                continue;
+            }
+            const int error = SSL_get_error(ssl, received);
+            if (error == SSL_ERROR_WANT_READ)
+            {
+                break;
+            }
+            if (error == SSL_ERROR_WANT_WRITE)
+            {
+                wants_write = true;
+                break;
+            }
+            ERR_clear_error();
+            if (error != SSL_ERROR_ZERO_RETURN && error != SSL_ERROR_SYSCALL)
+            {
+                return;
+            }
+            client_eof = true;
+        }
+        while (to_inner_offset < to_inner.size())
+        {
+            const ssize_t sent = send(inner_socket, to_inner.data() + to_inner_offset, to_inner.size() - to_inner_offset,
+                                      MSG_NOSIGNAL);
+            if (sent > 0)
+            {
+                to_inner_offset += static_cast<size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            // The HTTP side closed; whatever the peer still sends has nowhere to go
+            to_inner_offset = to_inner.size();
+            client_eof = true;
+        }
+        if (to_inner_offset == to_inner.size())
+        {
+            to_inner.clear();
+            to_inner_offset = 0;
+        }
+        if (client_eof && to_inner.empty() && !inner_shut)
+        {
+            shutdown(inner_socket, SHUT_WR);
+            inner_shut = true;
+        }
+
+        // HTTP side -> peer
+        while (!inner_eof && to_client.size() < kRelayBuffer)
+        {
+            const ssize_t received = recv(inner_socket, chunk, sizeof(chunk), 0);
+            if (received > 0)
+            {
+                to_client.append(chunk, static_cast<size_t>(received));
+                continue;
+            }
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            inner_eof = true;
+        }
+        while (to_client_offset < to_client.size())
+        {
+            const int sent = SSL_write(ssl, to_client.data() + to_client_offset,
+                                       static_cast<int>(std::min<size_t>(to_client.size() - to_client_offset, kRelayBuffer)));
+            if (sent > 0)
+            {
+                to_client_offset += static_cast<size_t>(sent);
+                continue;
+            }
+            const int error = SSL_get_error(ssl, sent);
+            if (error == SSL_ERROR_WANT_WRITE || error == SSL_ERROR_WANT_READ)
+            {
+                (error == SSL_ERROR_WANT_WRITE ? wants_write : wants_read) = true;
+                break;
+            }
+            ERR_clear_error();
+            return;
+        }
+        if (to_client_offset == to_client.size())
+        {
+            to_client.clear();
+            to_client_offset = 0;
+        }
+
+        if (inner_eof && to_client.empty())
+        {
+            // Best effort: a nonblocking close_notify that does not fit is not worth waiting for
+            SSL_shutdown(ssl);
+            ERR_clear_error();
+            return;
+        }
+
+        pollfd fds[2];
+        fds[0].fd = client_socket;
+        fds[0].events = static_cast<short>(((!client_eof && to_inner.size() < kRelayBuffer) || wants_read ? POLLIN : 0) |
+                                           (wants_write ? POLLOUT : 0));
+        fds[0].revents = 0;
+        fds[1].fd = inner_socket;
+        fds[1].events = static_cast<short>(((!inner_eof && to_client.size() < kRelayBuffer) ? POLLIN : 0) |
+                                           (!to_inner.empty() ? POLLOUT : 0));
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0 && errno != EINTR)
+        {
+            return;
+        }
+    }
+#endif
+}
+
+TlsStats TlsContext::GetStats() const
+{
+    TlsStats stats;
+    stats.handshakes = m_handshakes.load(std::memory_order_relaxed);
+    stats.resumed = m_resumed.load(std::memory_order_relaxed);
+    stats.failed = m_failed.load(std::memory_order_relaxed);
+    stats.kernel = m_kernel.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace miniserver::network
@@ -0,0 +1,129 @@
+/**
+ * @file tls.hpp
+ * @brief TLS termination (OpenSSL) with a sharded session cache, session tickets and kernel TLS offload
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/socket_server.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+struct ssl_ctx_st;
+struct ssl_st;
+
+namespace miniserver::network
+{
+
+/**
+ * @brief TLS settings
+ */
+struct TlsOptions
+{
+    std::string certificate_file;                       ///< PEM certificate chain (leaf first)
+    std::string key_file;                               ///< PEM private key
+    bool session_tickets = true;                        ///< Stateless resumption; off: resumption through the session cache only
+    size_t session_cache_size = 20480;                  ///< Cached sessions across all shards
+    size_t session_cache_shards = 16;                   ///< Independently locked parts of the cache
+    std::chrono::seconds session_lifetime{3600};        ///< Session timeout, also the ticket key rotation period
+    bool kernel_offload = true;                         ///< Hand record encryption to the kernel (kTLS) when it supports the cipher
+    std::chrono::milliseconds handshake_timeout{10000}; ///< Longest handshake
+};
+
+/**
+ * @brief TLS counters
+ */
+struct TlsStats
+{
+    uint64_t handshakes = 0;            ///< Completed handshakes
+    uint64_t resumed = 0;               ///< Of which resumed a session (cache or ticket)
+    uint64_t failed = 0;                ///< Handshakes that failed or timed out
+    uint64_t kernel = 0;                ///< Connections served on kTLS in both directions
+};
+
+class TlsSessionCache;
+
+/**
+ * @brief Server-side TLS context shared by every connection of a listener
+ *
+ * Serve() runs the handshake on an accepted TCP connection and then hands a
+ * plaintext socket to the regular HTTP code. When the kernel took over
+ * record encryption in both directions (kTLS), that is the TCP socket
+ * itself: no copies in user space, and everything that works on a socket
+ * (sendfile, splice, the event loop) works unchanged. Otherwise a relay
+ * thread pair moves data between OpenSSL and one end of a socketpair.
+ *
+ * Sessions resume through tickets or a sharded in-memory cache. Ticket keys
+ * rotate every session lifetime and derive from a secret made when the
+ * context is created, so processes forked after that (prefork workers)
+ * accept each other's tickets.
+ *
+ * @details Needs OpenSSL (MINISERVER_HAS_OPENSSL) and POSIX; Create fails otherwise.
+ */
+class TlsContext
+{
+public:
+    /**
+     * @brief Load the certificate and key and set up the context
+     * @param options Certificate, key and session settings
+     * @return Context, or nullptr (the reason is logged)
+     */
+    static std::shared_ptr<TlsContext> Create(const TlsOptions& options);
+
+    /**
+     * @brief Check whether the build includes TLS support
+     */
+    static bool IsAvailable();
+
+    ~TlsContext();
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    /**
+     * @brief Run the handshake and serve the connection
+     * @param client_socket Accepted TCP connection (closed on return)
+     * @param serve Serves plaintext HTTP on the socket it is given, which it closes
+     */
+    void Serve(SOCKET client_socket, const std::function<void(SOCKET plain_socket)>& serve);
+
+    /**
+     * @brief Snapshot of the counters
+     */
+    TlsStats GetStats() const;
+
+private:
+    explicit TlsContext(const TlsOptions& options);
+
+    /**
+     * @brief Move data between the TLS connection and the plaintext socket until both sides finished
+     * @param ssl Established TLS connection on client_socket
+     * @param client_socket TCP connection
+     * @param inner_socket Relay end of the socketpair
+     */
+    void Relay(ssl_st* ssl, SOCKET client_socket, SOCKET inner_socket);
+
+    /**
+     * @brief OpenSSL callbacks need the context and the cache
+     */
+    friend struct TlsCallbacks;
+
+    TlsOptions m_options;                               ///< Settings
+    ssl_ctx_st* m_context = nullptr;                    ///< OpenSSL context
+    std::unique_ptr<TlsSessionCache> m_cache;           ///< Sessions for ID and stateful-ticket resumption
+    std::array<unsigned char, 32> m_ticket_secret{};    ///< Ticket keys derive from this
+    std::atomic<uint64_t> m_handshakes{0};              ///< Completed handshakes
+    std::atomic<uint64_t> m_resumed{0};                 ///< Resumed sessions
+    std::atomic<uint64_t> m_failed{0};                  ///< Failed handshakes
+    std::atomic<uint64_t> m_kernel{0};                  ///< kTLS in both directions
+};
+
+} // namespace miniserver::network
@@ -0,0 +1,183 @@
+/**
+ * @file udp_ingest.hpp
+ * @brief UDP telemetry ingest: statsd-style lines received in batches and handed over in batches
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/udp_socket.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace miniserver::network
+{
+
+/**
+ * @brief Kind of a statsd metric ("|c", "|g", ...)
+ */
+enum class MetricType : uint8_t
+{
+    Counter,        ///< c
+    Gauge,          ///< g
+    Timer,          ///< ms
+    Histogram,      ///< h
+    Distribution,   ///< d
+    Set             ///< s
+};
+
+/**
+ * @brief One parsed line, "name:value|type[|@rate][|#tags]"
+ *
+ * The views point into the receive buffer and are valid only during the
+ * handler call that delivers them.
+ */
+struct Metric
+{
+    std::string_view name;              ///< Bucket name
+    std::string_view raw_value;         ///< Value as sent (set members need not be numbers)
+    double value = 0.0;                 ///< Parsed value (0 for a non-numeric set member)
+    bool delta = false;                 ///< Gauge sent with a sign: adjusts the gauge instead of replacing it
+    MetricType type = MetricType::Counter;
+    double sample_rate = 1.0;           ///< "@0.1": the client sent one in ten
+    std::string_view tags;              ///< "#k:v,k2" without the '#'
+};
+
+/**
+ * @brief statsd line parsing without allocation
+ */
+namespace statsd
+{
+    /**
+     * @brief Parse one line
+     * @param line Line without its newline
+     * @param metric Receives the fields
+     * @return false if the line is malformed
+     */
+    bool ParseLine(std::string_view line, Metric& metric);
+
+    /**
+     * @brief Parse every newline-separated line of a datagram
+     * @param datagram Payload
+     * @param metrics Parsed lines are appended (reuse the vector to avoid allocating)
+     * @return Malformed lines skipped
+     */
+    size_t ParseDatagram(std::string_view datagram, std::vector<Metric>& metrics);
+}
+
+/**
+ * @brief Receives the metrics of one receive batch
+ * @param metrics Parsed lines, valid only during the call
+ * @param count Number of lines
+ */
+using IngestHandler = std::function<void(const Metric* metrics, size_t count)>;
+
+/**
+ * @brief UDP ingest listener settings
+ */
+struct UdpIngestOptions
+{
+    std::string host = "0.0.0.0";               ///< UDP bind address
+    int port = 0;                               ///< UDP port (0: none)
+    size_t batch = 64;                          ///< Datagrams (or GRO trains) per recvmmsg call
+    int receive_buffer = 16 * 1024 * 1024;      ///< SO_RCVBUF: absorbs bursts while a batch is handled
+    bool reuse_port = false;                    ///< SO_REUSEPORT, so every prefork worker binds the port
+};
+
+/**
+ * @brief UDP ingest counters
+ */
+struct UdpIngestStats
+{
+    uint64_t receive_calls = 0;         ///< recvmmsg calls that returned data
+    uint64_t datagrams = 0;             ///< Datagrams received
+    uint64_t metrics = 0;               ///< Lines parsed
+    uint64_t malformed = 0;             ///< Lines skipped
+    uint64_t callbacks = 0;             ///< Handler calls
+};
+
+/**
+ * @brief Fire-and-forget telemetry listener
+ *
+ * One thread owns the socket: it drains the queue with recvmmsg (and GRO
+ * where the kernel coalesces), parses each datagram's lines into views of
+ * the receive buffers, and calls the handler once per batch. Nothing is
+ * allocated per datagram once the metric vector has grown to its working
+ * size, and nothing is ever sent back. Counters are updated once per
+ * batch.
+ *
+ * @details Requires a POSIX socket API; Start() fails elsewhere.
+ */
+class UdpIngestServer
+{
+public:
+    /**
+     * @brief Constructor
+     * @param handler Called on the ingest thread with each batch (empty: parse and count only)
+     */
+    explicit UdpIngestServer(IngestHandler handler);
+
+    /**
+     * @brief Destructor (stops the listener)
+     */
+    ~UdpIngestServer();
+
+    UdpIngestServer(const UdpIngestServer&) = delete;
+    UdpIngestServer& operator=(const UdpIngestServer&) = delete;
+
+    /**
+     * @brief Bind the port and start the ingest thread
+     * @param options Listener settings
+     * @return false if the port cannot be bound
+     */
+    bool Start(const UdpIngestOptions& options);
+
+    /**
+     * @brief Stop the ingest thread and close the socket
+     */
+    void Stop();
+
+    /**
+     * @brief Check whether the listener is running
+     */
+    bool IsRunning() const { return m_running.load(); }
+
+    /**
+     * @brief Bound UDP port (useful with port 0)
+     */
+    int GetPort() const { return m_socket.Port(); }
+
+    /**
+     * @brief Counters snapshot
+     */
+    UdpIngestStats GetStats() const;
+
+private:
+    /**
+     * @brief Ingest thread body
+     */
+    void Loop();
+
+    IngestHandler m_handler;                            ///< Batch consumer
+    UdpIngestOptions m_options;                         ///< Settings
+    UdpSocket m_socket;                                 ///< Listening socket
+    int m_wake_pipe[2] = {-1, -1};                      ///< Wakes the thread for Stop
+    std::thread m_thread;                               ///< Runs Loop
+    std::atomic<bool> m_running{false};                 ///< Serving
+
+    std::atomic<uint64_t> m_receive_calls{0};           ///< recvmmsg calls with data
+    std::atomic<uint64_t> m_datagrams{0};               ///< Datagrams received
+    std::atomic<uint64_t> m_metrics{0};                 ///< Lines parsed
+    std::atomic<uint64_t> m_malformed{0};               ///< Lines skipped
+    std::atomic<uint64_t> m_callbacks{0};               ///< Handler calls
+};
+
+} // namespace miniserver::network
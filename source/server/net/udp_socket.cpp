@@ -0,0 +1,429 @@
+/**
+ * @file udp_socket.cpp
+ * @brief Batched UDP socket implementation
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/udp_socket.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__)
+    #include <netinet/udp.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+#if defined(__linux__)
+    constexpr size_t kMaxSegments = 64;             ///< Kernel limit of datagrams per GSO send (UDP_MAX_SEGMENTS)
+    constexpr size_t kMaxSuperDatagram = 65000;     ///< Stay below the 64 KiB IP payload limit
+    constexpr size_t kSendMessages = 64;            ///< Messages per sendmmsg call
+#endif
+} // namespace
+
+#ifndef _WIN32
+
+bool UdpAddress::operator==(const UdpAddress& other) const
+{
+    if (length != other.length)
+    {
+        return false;
+    }
+    const auto* left = reinterpret_cast<const sockaddr_in*>(&storage);
+    const auto* right = reinterpret_cast<const sockaddr_in*>(&other.storage);
+    return left->sin_port == right->sin_port && left->sin_addr.s_addr == right->sin_addr.s_addr;
+}
+
+std::string UdpAddress::ToString() const
+{
+    const auto* address = reinterpret_cast<const sockaddr_in*>(&storage);
+    char text[INET_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &address->sin_addr, text, sizeof(text));
+    return std::string(text) + ":" + std::to_string(ntohs(address->sin_port));
+}
+
+bool UdpAddress::Resolve(const std::string& host, int port, UdpAddress& address)
+{
+    address = UdpAddress{};
+    auto* ipv4 = reinterpret_cast<sockaddr_in*>(&address.storage);
+    ipv4->sin_family = AF_INET;
+    ipv4->sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &ipv4->sin_addr) != 1)
+    {
+        return false;
+    }
+    address.length = sizeof(sockaddr_in);
+    return true;
+}
+
+#else
+
+bool UdpAddress::operator==(const UdpAddress&) const
+{
+    return true;
+}
+
+std::string UdpAddress::ToString() const
+{
+    return {};
+}
+
+bool UdpAddress::Resolve(const std::string&, int, UdpAddress&)
+{
+    return false;
+}
+
+#endif
+
+UdpReceiveBatch::UdpReceiveBatch(size_t messages, size_t message_size)
+    : m_messages(std::max<size_t>(messages, 1))
+    , m_message_size(std::max<size_t>(message_size, 1500))
+    , m_buffers(m_messages * m_message_size)
+    , m_peers(m_messages)
+{
+    m_datagrams.reserve(m_messages);
+#if defined(__linux__)
+    m_headers.resize(m_messages);
+    m_vectors.resize(m_messages);
+    m_controls.resize(m_messages * CMSG_SPACE(sizeof(int)));
+    for (size_t i = 0; i < m_messages; ++i)
+    {
+        m_vectors[i].iov_base = m_buffers.data() + i * m_message_size;
+        m_vectors[i].iov_len = m_message_size;
+    }
+#endif
+}
+
+void UdpSendBatch::Add(const UdpAddress& peer, std::string_view datagram)
+{
+    m_entries.push_back({peer, m_buffer.size(), datagram.size()});
+    m_buffer.append(datagram.data(), datagram.size());
+}
+
+void UdpSendBatch::Clear()
+{
+    m_buffer.clear();
+    m_entries.clear();
+}
+
+UdpSocket::~UdpSocket()
+{
+    Close();
+}
+
+std::string UdpSocket::LastError()
+{
+    return std::strerror(errno);
+}
+
+#ifndef _WIN32
+
+bool UdpSocket::Open(const std::string& host, int port, bool reuse_port)
+{
+    Close();
+
+    UdpAddress address;
+    if (!UdpAddress::Resolve(host, port, address))
+    {
+        errno = EINVAL;
+        return false;
+    }
+
+    m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_socket < 0)
+    {
+        return false;
+    }
+    fcntl(m_socket, F_SETFD, FD_CLOEXEC);
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+
+    const int enable = 1;
+    if (reuse_port)
+    {
+#ifdef SO_REUSEPORT
+        setsockopt(m_socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+#endif
+    }
+
+    // Datagrams arrive in bursts; a deep receive queue avoids drops between batches
+    const int buffer_size = 4 * 1024 * 1024;
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+
+    if (bind(m_socket, reinterpret_cast<const sockaddr*>(&address.storage), address.length) != 0)
+    {
+        const int error = errno;
+        Close();
+        errno = error;
+        return false;
+    }
+
+    sockaddr_in bound{};
+    socklen_t length = sizeof(bound);
+    getsockname(m_socket, reinterpret_cast<sockaddr*>(&bound), &length);
+    m_port = ntohs(bound.sin_port);
+
+#if defined(__linux__)
+    m_gro = setsockopt(m_socket, IPPROTO_UDP, UDP_GRO, &enable, sizeof(enable)) == 0;
+    // Probe GSO with a per-socket segment size, then clear it: each send sets its own
+    int segment = 1200;
+    m_gso = setsockopt(m_socket, IPPROTO_UDP, UDP_SEGMENT, &segment, sizeof(segment)) == 0;
+    segment = 0;
+    setsockopt(m_socket, IPPROTO_UDP, UDP_SEGMENT, &segment, sizeof(segment));
+#endif
+    return true;
+}
+
+void UdpSocket::Close()
+{
+    if (m_socket >= 0)
+    {
+        close(m_socket);
+        m_socket = -1;
+    }
+    m_port = 0;
+    m_gso = false;
+    m_gro = false;
+}
+
+bool UdpSocket::Receive(UdpReceiveBatch& batch)
+{
+    batch.m_datagrams.clear();
+    batch.m_count = 0;
+    if (m_socket < 0)
+    {
+        return false;
+    }
+
+#if defined(__linux__)
+    // The kernel rewrites name and control lengths, so reset them on every call
+    auto& headers = batch.m_headers;
+    for (size_t i = 0; i < batch.m_messages; ++i)
+    {
+        msghdr& message = headers[i].msg_hdr;
+        message = msghdr{};
+        message.msg_name = &batch.m_peers[i].storage;
+        message.msg_namelen = sizeof(sockaddr_storage);
+        message.msg_iov = &batch.m_vectors[i];
+        message.msg_iovlen = 1;
+        message.msg_control = batch.m_controls.data() + i * CMSG_SPACE(sizeof(int));
+        message.msg_controllen = CMSG_SPACE(sizeof(int));
+    }
+
+    const int received = recvmmsg(m_socket, headers.data(), static_cast<unsigned int>(headers.size()), MSG_DONTWAIT, nullptr);
+    if (received < 0)
+    {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    ++m_stats.receive_calls;
+
+    for (int i = 0; i < received; ++i)
+    {
+        const msghdr& message = headers[i].msg_hdr;
+        batch.m_peers[i].length = message.msg_namelen;
+        const size_t length = headers[i].msg_len;
+
+        // With GRO, one buffer holds a train of equal-sized datagrams (the last may be shorter)
+        size_t segment = length;
+        for (cmsghdr* control = CMSG_FIRSTHDR(&message); control != nullptr;
+             control = CMSG_NXTHDR(const_cast<msghdr*>(&message), control))
+        {
+            if (control->cmsg_level == IPPROTO_UDP && control->cmsg_type == UDP_GRO)
+            {
+                int size = 0;
+                std::memcpy(&size, CMSG_DATA(control), sizeof(size));
+                if (size > 0)
+                {
+                    segment = static_cast<size_t>(size);
+                }
+            }
+        }
+
+        const char* data = static_cast<const char*>(batch.m_vectors[i].iov_base);
+        size_t offset = 0;
+        do
+        {
+            const size_t size = std::min(segment, length - offset);
+            batch.m_datagrams.push_back({std::string_view(data + offset, size), static_cast<size_t>(i)});
+            offset += size;
+        } while (offset < length);
+    }
+#else
+    for (size_t i = 0; i < batch.m_messages; ++i)
+    {
+        UdpAddress& peer = batch.m_peers[i];
+        peer.length = sizeof(sockaddr_storage);
+        char* buffer = batch.m_buffers.data() + i * batch.m_message_size;
+        const ssize_t length = recvfrom(m_socket, buffer, batch.m_message_size, 0,
+                                        reinterpret_cast<sockaddr*>(&peer.storage), &peer.length);
+        if (length < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            {
+                break;
+            }
+            return false;
+        }
+        ++m_stats.receive_calls;
+        batch.m_datagrams.push_back({std::string_view(buffer, static_cast<size_t>(length)), i});
+    }
+#endif
+
+    batch.m_count = batch.m_datagrams.size();
+    m_stats.datagrams_received += batch.m_count;
+    return true;
+}
+
+size_t UdpSocket::Send(UdpSendBatch& batch)
+{
+    size_t sent = 0;
+    if (m_socket < 0 || batch.m_entries.empty())
+    {
+        batch.Clear();
+        return 0;
+    }
+
+#if defined(__linux__)
+    // One message per run of equal-sized datagrams to the same peer (GSO), or per datagram
+    struct Group
+    {
+        size_t first;                   ///< First entry
+        size_t count;                   ///< Entries in the run
+    };
+    const auto& entries = batch.m_entries;
+    size_t index = 0;
+    while (index < entries.size())
+    {
+        std::vector<Group> groups;
+        while (index < entries.size() && groups.size() < kSendMessages)
+        {
+            size_t count = 1;
+            if (m_gso)
+            {
+                const size_t size = entries[index].length;
+                while (index + count < entries.size() && count < kMaxSegments
+                       && (count + 1) * size <= kMaxSuperDatagram
+                       && entries[index + count].peer == entries[index].peer
+                       && entries[index + count].length <= size
+                       && entries[index + count - 1].length == size)
+                {
+                    ++count;
+                }
+            }
+            groups.push_back({index, count});
+            index += count;
+        }
+
+        std::vector<mmsghdr> headers(groups.size());
+        std::vector<iovec> vectors(groups.size());
+        std::vector<char> controls(groups.size() * CMSG_SPACE(sizeof(uint16_t)));
+        for (size_t g = 0; g < groups.size(); ++g)
+        {
+            const auto& first = entries[groups[g].first];
+            const auto& last = entries[groups[g].first + groups[g].count - 1];
+            vectors[g].iov_base = batch.m_buffer.data() + first.offset;
+            vectors[g].iov_len = last.offset + last.length - first.offset;
+            msghdr& message = headers[g].msg_hdr;
+            message = msghdr{};
+            message.msg_name = const_cast<sockaddr_storage*>(&first.peer.storage);
+            message.msg_namelen = first.peer.length;
+            message.msg_iov = &vectors[g];
+            message.msg_iovlen = 1;
+            if (groups[g].count > 1)
+            {
+                message.msg_control = controls.data() + g * CMSG_SPACE(sizeof(uint16_t));
+                message.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                cmsghdr* control = CMSG_FIRSTHDR(&message);
+                control->cmsg_level = IPPROTO_UDP;
+                control->cmsg_type = UDP_SEGMENT;
+                control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                const auto segment = static_cast<uint16_t>(first.length);
+                std::memcpy(CMSG_DATA(control), &segment, sizeof(segment));
+            }
+        }
+
+        size_t done = 0;
+        while (done < groups.size())
+        {
+            const int result = sendmmsg(m_socket, headers.data() + done, static_cast<unsigned int>(groups.size() - done), 0);
+            ++m_stats.send_calls;
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno == EIO && groups[done].count > 1)
+                {
+                    // The device cannot segment (no checksum offload): resend this run without GSO
+                    m_gso = false;
+                    index = groups[done].first;
+                    break;
+                }
+                // Full queue or unreachable peer: drop the message like the network would
+                ++done;
+                continue;
+            }
+            for (int i = 0; i < result; ++i)
+            {
+                sent += groups[done + i].count;
+            }
+            done += static_cast<size_t>(result);
+        }
+    }
+#else
+    for (const auto& entry : batch.m_entries)
+    {
+        ++m_stats.send_calls;
+        if (sendto(m_socket, batch.m_buffer.data() + entry.offset, entry.length, 0,
+                   reinterpret_cast<const sockaddr*>(&entry.peer.storage), entry.peer.length) >= 0)
+        {
+            ++sent;
+        }
+    }
+#endif
+
+    m_stats.datagrams_sent += sent;
+    batch.Clear();
+    return sent;
+}
+
+#else
+
+bool UdpSocket::Open(const std::string&, int, bool)
+{
+    return false;
+}
+
+void UdpSocket::Close()
+{
+}
+
+bool UdpSocket::Receive(UdpReceiveBatch& batch)
+{
+    batch.m_count = 0;
+    return false;
+}
+
+size_t UdpSocket::Send(UdpSendBatch& batch)
+{
+    batch.Clear();
+    return 0;
+}
+
+#endif
+
+} // namespace miniserver::network
@@ -0,0 +1,202 @@
+/**
+ * @file udp_socket.hpp
+ * @brief Nonblocking UDP socket with batched receive and send (recvmmsg/sendmmsg, GRO/GSO)
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <sys/uio.h>
+#endif
+
+namespace miniserver::network
+{
+
+/**
+ * @brief IPv4 peer address of a datagram
+ */
+struct UdpAddress
+{
+#ifndef _WIN32
+    sockaddr_storage storage{};         ///< Address (AF_INET)
+    socklen_t length = 0;               ///< Used bytes of storage
+#endif
+
+    /**
+     * @brief Same address and port
+     */
+    bool operator==(const UdpAddress& other) const;
+    bool operator!=(const UdpAddress& other) const { return !(*this == other); }
+
+    /**
+     * @brief "a.b.c.d:port"
+     */
+    std::string ToString() const;
+
+    /**
+     * @brief Parse a numeric IPv4 address
+     * @return false if host is not a dotted quad
+     */
+    static bool Resolve(const std::string& host, int port, UdpAddress& address);
+};
+
+/**
+ * @brief Receive buffers for one batched read, allocated once and reused
+ *
+ * With GRO one buffer may hold several coalesced datagrams; Count/Data/Peer
+ * list them after the split.
+ */
+class UdpReceiveBatch
+{
+public:
+    /**
+     * @param messages Datagrams (or GRO trains) per system call
+     * @param message_size Bytes per buffer (64 KiB holds any GRO train)
+     */
+    explicit UdpReceiveBatch(size_t messages = 32, size_t message_size = 65536);
+
+    UdpReceiveBatch(const UdpReceiveBatch&) = delete;
+    UdpReceiveBatch& operator=(const UdpReceiveBatch&) = delete;
+
+    size_t Count() const { return m_count; }
+    std::string_view Data(size_t index) const { return m_datagrams[index].data; }
+    const UdpAddress& Peer(size_t index) const { return m_peers[m_datagrams[index].message]; }
+
+private:
+    friend class UdpSocket;
+
+    struct Entry
+    {
+        std::string_view data;          ///< Datagram inside a buffer
+        size_t message = 0;             ///< Buffer (and peer) index
+    };
+
+    size_t m_messages;                  ///< Buffers
+    size_t m_message_size;              ///< Bytes per buffer
+    std::vector<char> m_buffers;        ///< m_messages buffers back to back
+    std::vector<UdpAddress> m_peers;    ///< Sender of each buffer
+    std::vector<Entry> m_datagrams;     ///< Datagrams after the GRO split
+    size_t m_count = 0;                 ///< Valid entries in m_datagrams
+#if defined(__linux__)
+    std::vector<mmsghdr> m_headers;     ///< recvmmsg descriptors, one per buffer
+    std::vector<iovec> m_vectors;       ///< Buffer of each descriptor
+    std::vector<char> m_controls;       ///< UDP_GRO control messages
+#endif
+};
+
+/**
+ * @brief Datagrams queued for one batched write
+ *
+ * Payloads are stored back to back, so a run of equal-sized datagrams to
+ * the same peer leaves as one GSO super-datagram.
+ */
+class UdpSendBatch
+{
+public:
+    /**
+     * @brief Queue a datagram
+     */
+    void Add(const UdpAddress& peer, std::string_view datagram);
+
+    size_t Count() const { return m_entries.size(); }
+    bool Empty() const { return m_entries.empty(); }
+    void Clear();
+
+private:
+    friend class UdpSocket;
+
+    struct Entry
+    {
+        UdpAddress peer;                ///< Destination
+        size_t offset = 0;              ///< Payload start in m_buffer
+        size_t length = 0;              ///< Payload size
+    };
+
+    std::string m_buffer;               ///< Payloads back to back
+    std::vector<Entry> m_entries;       ///< Datagrams in order
+};
+
+/**
+ * @brief System call counters of a socket
+ */
+struct UdpSocketStats
+{
+    uint64_t receive_calls = 0;         ///< recvmmsg/recvfrom calls that returned data
+    uint64_t datagrams_received = 0;    ///< Datagrams after the GRO split
+    uint64_t send_calls = 0;            ///< sendmmsg/sendto calls
+    uint64_t datagrams_sent = 0;        ///< Datagrams handed to the kernel
+};
+
+/**
+ * @brief Nonblocking IPv4 UDP socket
+ *
+ * On Linux, reads use recvmmsg with UDP_GRO and writes use sendmmsg with
+ * UDP_SEGMENT (GSO), falling back per feature when the kernel refuses it.
+ * Other POSIX systems loop over recvfrom/sendto. Not available on Windows.
+ */
+class UdpSocket
+{
+public:
+    UdpSocket() = default;
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    /**
+     * @brief Bind a socket
+     * @param host IPv4 address to bind ("0.0.0.0": any)
+     * @param port Port (0: ephemeral, e.g. for clients)
+     * @param reuse_port Set SO_REUSEPORT before binding
+     * @return false on failure (see LastError)
+     */
+    bool Open(const std::string& host, int port, bool reuse_port = false);
+
+    /**
+     * @brief Close the socket
+     */
+    void Close();
+
+    /**
+     * @brief Read whatever is queued, up to one batch
+     * @param batch Reused buffers; Count() is 0 when nothing was queued
+     * @return false on a socket error
+     */
+    bool Receive(UdpReceiveBatch& batch);
+
+    /**
+     * @brief Write the queued datagrams and clear the batch
+     * @param batch Datagrams to send
+     * @return Datagrams the kernel accepted (the rest are dropped, as a full queue would)
+     */
+    size_t Send(UdpSendBatch& batch);
+
+    int Descriptor() const { return m_socket; }
+    int Port() const { return m_port; }
+    bool UsesGso() const { return m_gso; }
+    bool UsesGro() const { return m_gro; }
+    const UdpSocketStats& Stats() const { return m_stats; }
+
+    /**
+     * @brief Description of the last failed call (errno)
+     */
+    static std::string LastError();
+
+private:
+    int m_socket = -1;                  ///< Descriptor
+    int m_port = 0;                     ///< Bound port
+    bool m_gso = false;                 ///< UDP_SEGMENT accepted
+    bool m_gro = false;                 ///< UDP_GRO enabled
+    UdpSocketStats m_stats;             ///< Counters
+};
+
+} // namespace miniserver::network
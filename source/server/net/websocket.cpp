@@ -0,0 +1,1203 @@
+/**
+ * @file websocket.cpp
+ * @brief WebSocket (RFC 6455) handshake, framing and sessions
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#include "net/websocket.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+
+#ifdef MINISERVER_HAS_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace miniserver::network
+{
+
+namespace
+{
+    constexpr char kHandshakeGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    constexpr size_t kReadChunkSize = 16 * 1024;
+    constexpr size_t kMaxReadPerEvent = 256 * 1024;     ///< Yield to other sockets after this much
+    constexpr size_t kMinCompressSize = 64;             ///< Smaller messages are sent uncompressed
+    constexpr size_t kMaxControlPayload = 125;
+    constexpr size_t kMaxCloseReason = 123;
+
+#ifdef MSG_NOSIGNAL
+    constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kSendFlags = 0;
+#endif
+
+    std::atomic<uint64_t> g_next_session_id{1};
+
+    /**
+     * @brief Minimal SHA-1, only used for the handshake accept key
+     */
+    std::array<uint8_t, 20> Sha1(std::string_view data)
+    {
+        uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+        auto rotl = [](uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); };
+
+        std::string message(data);
+        const uint64_t bit_length = static_cast<uint64_t>(data.size()) * 8;
+        message.push_back(static_cast<char>(0x80));
+        while (message.size() % 64 != 56)
+        {
+            message.push_back('\0');
+        }
+        for (int shift = 56; shift >= 0; shift -= 8)
+        {
+            message.push_back(static_cast<char>((bit_length >> shift) & 0xFF));
+        }
+
+        for (size_t block = 0; block < message.size(); block += 64)
+        {
+            uint32_t w[80];
+            for (int i = 0; i < 16; ++i)
+            {
+                const auto* p = reinterpret_cast<const uint8_t*>(message.data() + block + i * 4);
+                w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+            }
+            for (int i = 16; i < 80; ++i)
+            {
+                w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+            }
+
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (int i = 0; i < 80; ++i)
+            {
+                uint32_t f, k;
+                if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+                else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+                else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+                else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+                const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = rotl(b, 30);
+                b = a;
+                a = temp;
+            }
+            h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+        }
+
+        std::array<uint8_t, 20> digest{};
+        for (int i = 0; i < 20; ++i)
+        {
+            digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - (i % 4) * 8));
+        }
+        return digest;
+    }
+
+    std::string Base64Encode(const uint8_t* data, size_t size)
+    {
+        static constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string result;
+        result.reserve((size + 2) / 3 * 4);
+        for (size_t i = 0; i < size; i += 3)
+        {
+            const uint32_t chunk = (uint32_t(data[i]) << 16) |
+                                   (i + 1 < size ? uint32_t(data[i + 1]) << 8 : 0) |
+                                   (i + 2 < size ? uint32_t(data[i + 2]) : 0);
+            result.push_back(kAlphabet[(chunk >> 18) & 0x3F]);
+            result.push_back(kAlphabet[(chunk >> 12) & 0x3F]);
+            result.push_back(i + 1 < size ? kAlphabet[(chunk >> 6) & 0x3F] : '=');
+            result.push_back(i + 2 < size ? kAlphabet[chunk & 0x3F] : '=');
+        }
+        return result;
+    }
+
+    std::string_view Trim(std::string_view value)
+    {
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        {
+            value.remove_prefix(1);
+        }
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        {
+            value.remove_suffix(1);
+        }
+        return value;
+    }
+
+    bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+    {
+        return a.size() == b.size() &&
+               std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+               {
+                   return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+               });
+    }
+
+    /**
+     * @brief Check a comma-separated header value for a token (case-insensitive)
+     */
+    bool HasToken(std::string_view value, std::string_view token)
+    {
+        while (!value.empty())
+        {
+            const size_t comma = value.find(',');
+            if (EqualsIgnoreCase(Trim(value.substr(0, comma)), token))
+            {
+                return true;
+            }
+            if (comma == std::string_view::npos)
+            {
+                break;
+            }
+            value.remove_prefix(comma + 1);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Parse one permessage-deflate extension ("name; param; param=value")
+     * @return false if it is not permessage-deflate or carries unusable parameters
+     */
+    bool ParseDeflateExtension(std::string_view extension, WebSocketDeflateParams& params)
+    {
+        params = WebSocketDeflateParams{};
+        size_t semicolon = extension.find(';');
+        if (!EqualsIgnoreCase(Trim(extension.substr(0, semicolon)), "permessage-deflate"))
+        {
+            return false;
+        }
+
+        bool seen_server_bits = false;
+        bool seen_client_bits = false;
+        bool seen_server_reset = false;
+        bool seen_client_reset = false;
+        while (semicolon != std::string_view::npos)
+        {
+            extension.remove_prefix(semicolon + 1);
+            semicolon = extension.find(';');
+            const std::string_view param = Trim(extension.substr(0, semicolon));
+            const size_t equals = param.find('=');
+            const std::string_view name = Trim(param.substr(0, equals));
+            std::string_view value;
+            if (equals != std::string_view::npos)
+            {
+                value = Trim(param.substr(equals + 1));
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+                {
+                    value = value.substr(1, value.size() - 2);
+                }
+            }
+
+            auto parse_bits = [](std::string_view text, int& bits)
+            {
+                if (text.empty() || text.size() > 2 ||
+                    !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; }))
+                {
+                    return false;
+                }
+                bits = std::stoi(std::string(text));
+                return bits >= 8 && bits <= 15;
+            };
+
+            if (name == "server_no_context_takeover" && value.empty() && !seen_server_reset)
+            {
+                seen_server_reset = true;
+                params.server_no_context_takeover = true;
+            }
+            else if (name == "client_no_context_takeover" && value.empty() && !seen_client_reset)
+            {
+                seen_client_reset = true;
+                params.client_no_context_takeover = true;
+            }
+            else if (name == "server_max_window_bits" && !seen_server_bits)
+            {
+                seen_server_bits = true;
+                // zlib cannot produce raw deflate with an 8-bit window
+                if (!parse_bits(value, params.server_max_window_bits) || params.server_max_window_bits < 9)
+                {
+                    return false;
+                }
+            }
+            else if (name == "client_max_window_bits" && !seen_client_bits)
+            {
+                // Our inflater always uses the largest window, so any client window works
+                seen_client_bits = true;
+                int bits = 15;
+                if (!value.empty() && !parse_bits(value, bits))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool IsValidCloseCode(uint16_t code)
+    {
+        return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1014) ||
+               (code >= 3000 && code <= 4999);
+    }
+
+    void CloseSocketHandle(SOCKET socket)
+    {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    bool WouldBlock()
+    {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+    }
+}
+
+// =============================================================================
+// Handshake and framing helpers
+// =============================================================================
+
+namespace websocket
+{
+    std::string ComputeAcceptKey(std::string_view client_key)
+    {
+        const auto digest = Sha1(std::string(Trim(client_key)) + kHandshakeGuid);
+        return Base64Encode(digest.data(), digest.size());
+    }
+
+    bool IsUpgradeRequest(const http::Request& request)
+    {
+        return request.method == http::Method::GET &&
+               HasToken(request.GetHeader("Upgrade"), "websocket") &&
+               HasToken(request.GetHeader("Connection"), "upgrade");
+    }
+
+    std::optional<WebSocketDeflateParams> NegotiateDeflate(std::string_view offers)
+    {
+#ifdef MINISERVER_HAS_ZLIB
+        while (!offers.empty())
+        {
+            const size_t comma = offers.find(',');
+            WebSocketDeflateParams params;
+            if (ParseDeflateExtension(offers.substr(0, comma), params))
+            {
+                return params;
+            }
+            if (comma == std::string_view::npos)
+            {
+                break;
+            }
+            offers.remove_prefix(comma + 1);
+        }
+#else
+        (void)offers;
+#endif
+        return std::nullopt;
+    }
+
+    std::optional<WebSocketDeflateParams> ParseDeflateParams(std::string_view accepted)
+    {
+        WebSocketDeflateParams params;
+        if (ParseDeflateExtension(accepted.substr(0, accepted.find(',')), params))
+        {
+            return params;
+        }
+        return std::nullopt;
+    }
+
+    std::string FormatDeflateResponse(const WebSocketDeflateParams& params)
+    {
+        std::string value = "permessage-deflate";
+        if (params.server_no_context_takeover)
+        {
+            value += "; server_no_context_takeover";
+        }
+        if (params.client_no_context_takeover)
+        {
+            value += "; client_no_context_takeover";
+        }
+        if (params.server_max_window_bits < 15)
+        {
+            value += "; server_max_window_bits=" + std::to_string(params.server_max_window_bits);
+        }
+        return value;
+    }
+
+    std::string EncodeFrame(WebSocketOpcode opcode, std::string_view payload, bool fin, bool compressed)
+    {
+        std::string frame;
+        frame.reserve(payload.size() + 10);
+        frame.push_back(static_cast<char>((fin ? 0x80 : 0x00) | (compressed ? 0x40 : 0x00) |
+                                          static_cast<uint8_t>(opcode)));
+        if (payload.size() < 126)
+        {
+            frame.push_back(static_cast<char>(payload.size()));
+        }
+        else if (payload.size() <= 0xFFFF)
+        {
+            frame.push_back(static_cast<char>(126));
+            frame.push_back(static_cast<char>((payload.size() >> 8) & 0xFF));
+            frame.push_back(static_cast<char>(payload.size() & 0xFF));
+        }
+        else
+        {
+            frame.push_back(static_cast<char>(127));
+            for (int shift = 56; shift >= 0; shift -= 8)
+            {
+                frame.push_back(static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xFF));
+            }
+        }
+        frame.append(payload.data(), payload.size());
+        return frame;
+    }
+
+    bool IsValidUtf8(std::string_view data)
+    {
+        size_t i = 0;
+        while (i < data.size())
+        {
+            const auto byte = static_cast<uint8_t>(data[i]);
+            if (byte < 0x80)
+            {
+                ++i;
+                continue;
+            }
+
+            size_t length;
+            uint32_t code_point;
+            if ((byte & 0xE0) == 0xC0)      { length = 2; code_point = byte & 0x1F; }
+            else if ((byte & 0xF0) == 0xE0) { length = 3; code_point = byte & 0x0F; }
+            else if ((byte & 0xF8) == 0xF0) { length = 4; code_point = byte & 0x07; }
+            else
+            {
+                return false;
+            }
+            if (i + length > data.size())
+            {
+                return false;
+            }
+            for (size_t j = 1; j < length; ++j)
+            {
+                const auto next = static_cast<uint8_t>(data[i + j]);
+                if ((next & 0xC0) != 0x80)
+                {
+                    return false;
+                }
+                code_point = (code_point << 6) | (next & 0x3F);
+            }
+
+            // Reject overlong forms, surrogates and values past U+10FFFF
+            static constexpr uint32_t kMinimum[] = {0, 0, 0x80, 0x800, 0x10000};
+            if (code_point < kMinimum[length] || code_point > 0x10FFFF ||
+                (code_point >= 0xD800 && code_point <= 0xDFFF))
+            {
+                return false;
+            }
+            i += length;
+        }
+        return true;
+    }
+} // namespace websocket
+
+// =============================================================================
+// permessage-deflate streams
+// =============================================================================
+
+struct WebSocketSession::DeflateContext
+{
+#ifdef MINISERVER_HAS_ZLIB
+    z_stream deflater{};
+    z_stream inflater{};
+    bool deflater_ready = false;
+    bool inflater_ready = false;
+    bool reset_deflater = false;
+    bool reset_inflater = false;
+
+    explicit DeflateContext(const WebSocketDeflateParams& params)
+        : reset_deflater(params.server_no_context_takeover)
+        , reset_inflater(params.client_no_context_takeover)
+    {
+        // Messages are generated per connection, so use the fast level like dynamic responses
+        deflater_ready = deflateInit2(&deflater, Z_BEST_SPEED, Z_DEFLATED, -params.server_max_window_bits,
+                                      8, Z_DEFAULT_STRATEGY) == Z_OK;
+        inflater_ready = inflateInit2(&inflater, -15) == Z_OK;
+    }
+
+    ~DeflateContext()
+    {
+        if (deflater_ready) deflateEnd(&deflater);
+        if (inflater_ready) inflateEnd(&inflater);
+    }
+
+    /**
+     * @brief Compress one message (RFC 7692 section 7.2.1)
+     */
+    bool Compress(std::string_view input, std::string& output)
+    {
+        if (!deflater_ready)
+        {
+            return false;
+        }
+        output.clear();
+        deflater.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        deflater.avail_in = static_cast<uInt>(input.size());
+        do
+        {
+            const size_t old_size = output.size();
+            output.resize(old_size + input.size() / 2 + 64);
+            deflater.next_out = reinterpret_cast<Bytef*>(output.data() + old_size);
+            deflater.avail_out = static_cast<uInt>(output.size() - old_size);
+            if (deflate(&deflater, Z_SYNC_FLUSH) == Z_STREAM_ERROR)
+            {
+                return false;
+            }
+            output.resize(output.size() - deflater.avail_out);
+        } while (deflater.avail_out == 0);
+
+        // Drop the empty stored block that ends a sync flush
+        if (output.size() >= 4 && output.compare(output.size() - 4, 4, "\x00\x00\xff\xff", 4) == 0)
+        {
+            output.resize(output.size() - 4);
+        }
+        if (reset_deflater)
+        {
+            deflateReset(&deflater);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Inflate one message (RFC 7692 section 7.2.2)
+     * @return false on corrupt data or when the result exceeds max_size
+     */
+    bool Inflate(std::string input, std::string& output, size_t max_size, bool& too_large)
+    {
+        too_large = false;
+        if (!inflater_ready)
+        {
+            return false;
+        }
+        input.append("\x00\x00\xff\xff", 4);
+        output.clear();
+        inflater.next_in = reinterpret_cast<Bytef*>(input.data());
+        inflater.avail_in = static_cast<uInt>(input.size());
+
+        constexpr size_t kChunkSize = 16 * 1024;
+        bool stream_ended = false;
+        while (true)
+        {
+            const size_t old_size = output.size();
+            output.resize(old_size + kChunkSize);
+            inflater.next_out = reinterpret_cast<Bytef*>(output.data() + old_size);
+            inflater.avail_out = static_cast<uInt>(kChunkSize);
+            const int result = inflate(&inflater, Z_SYNC_FLUSH);
+            output.resize(output.size() - inflater.avail_out);
+
+            if (result != Z_OK && result != Z_BUF_ERROR && result != Z_STREAM_END)
+            {
+                return false;
+            }
+            if (output.size() > max_size)
+            {
+                too_large = true;
+                return false;
+            }
+            // The sender closed the DEFLATE stream with a BFINAL block (section 7.2.3.3); the appended tail is not read
+            if (result == Z_STREAM_END)
+            {
+                stream_ended = true;
+                break;
+            }
+            if (inflater.avail_in == 0 && inflater.avail_out != 0)
+            {
+                break;
+            }
+            if (result == Z_BUF_ERROR)
+            {
+                return false;
+            }
+        }
+
+        if (reset_inflater)
+        {
+            inflateReset(&inflater);
+        }
+        else if (stream_ended)
+        {
+            // A finished stream takes no more input: start a new one primed with the window, which
+            // later messages may still reference under context takeover
+            Bytef window[32768];
+            uInt window_size = sizeof(window);
+            inflateGetDictionary(&inflater, window, &window_size);
+            inflateReset(&inflater);
+            inflateSetDictionary(&inflater, window, window_size);
+        }
+        return true;
+    }
+#else
+    explicit DeflateContext(const WebSocketDeflateParams&) {}
+    bool Compress(std::string_view, std::string&) { return false; }
+    bool Inflate(std::string, std::string&, size_t, bool& too_large) { too_large = false; return false; }
+#endif
+};
+
+// =============================================================================
+// WebSocketSession
+// =============================================================================
+
+WebSocketSession::WebSocketSession(EventLoop& loop, SOCKET socket, std::string path, std::string remote_address,
+                                   std::shared_ptr<const WebSocketHandler> handler, const WebSocketOptions& options,
+                                   std::optional<WebSocketDeflateParams> deflate)
+    : m_loop(loop)
+    , m_socket(socket)
+    , m_id(g_next_session_id.fetch_add(1))
+    , m_path(std::move(path))
+    , m_remote_address(std::move(remote_address))
+    , m_handler(std::move(handler))
+    , m_options(options)
+    , m_deflate_params(deflate)
+{
+    if (m_deflate_params)
+    {
+        m_deflate = std::make_unique<DeflateContext>(*m_deflate_params);
+    }
+}
+
+WebSocketSession::~WebSocketSession()
+{
+    if (m_socket != INVALID_SOCKET)
+    {
+        CloseSocketHandle(m_socket);
+    }
+}
+
+void WebSocketSession::Start(std::string initial_data)
+{
+    auto self = shared_from_this();
+    EventLoop::SetNonBlocking(m_socket);
+    if (!m_loop.Watch(m_socket, EventLoop::Readable, [self](uint32_t events) { self->OnEvents(events); }))
+    {
+        Terminate(1006, "Unable to watch socket");
+        return;
+    }
+    m_watching = true;
+    m_interest = EventLoop::Readable;
+    m_state.store(State::Open);
+
+    LOG_DEBUG_FMT(WebSocket, "Session {} opened on {} from {}{}", m_id, m_path, m_remote_address,
+                  m_deflate ? " (permessage-deflate)" : "");
+
+    if (m_handler->on_open)
+    {
+        try
+        {
+            m_handler->on_open(self);
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT(WebSocket, "on_open failed for {}: {}", m_path, e.what());
+            Fail(1011, "Internal error");
+            return;
+        }
+    }
+
+    SchedulePing();
+    m_input = std::move(initial_data);
+    ProcessInput();
+    if (m_state.load() != State::Closed)
+    {
+        FlushOutput();
+    }
+}
+
+bool WebSocketSession::Send(std::string text)
+{
+    return QueueMessage(std::move(text), false);
+}
+
+bool WebSocketSession::SendBinary(std::string data)
+{
+    return QueueMessage(std::move(data), true);
+}
+
+void WebSocketSession::Close(uint16_t code, std::string reason)
+{
+    auto close = [self = shared_from_this(), code, reason = std::move(reason)]()
+    {
+        if (self->m_state.load() != State::Open)
+        {
+            return;
+        }
+        self->m_close_code = code;
+        self->m_close_reason = reason;
+        self->SendClose(code, reason);
+        self->FlushOutput();
+    };
+
+    if (m_loop.IsInLoopThread())
+    {
+        close();
+    }
+    else
+    {
+        m_loop.Post(std::move(close));
+    }
+}
+
+bool WebSocketSession::QueueMessage(std::string payload, bool binary)
+{
+    if (m_state.load() != State::Open)
+    {
+        return false;
+    }
+
+    const size_t size = payload.size();
+    if (m_queued_bytes.load() + size > m_options.max_send_queue)
+    {
+        LOG_WARN_FMT(WebSocket, "Session {} send queue full, dropping {} byte message", m_id, size);
+        return false;
+    }
+
+    if (m_loop.IsInLoopThread())
+    {
+        SendMessageNow(payload, binary);
+        FlushOutput();
+        return true;
+    }
+
+    // Reserve the bytes now so concurrent senders see the backlog
+    m_queued_bytes.fetch_add(size);
+    m_loop.Post([self = shared_from_this(), payload = std::move(payload), binary]()
+    {
+        if (self->m_state.load() == State::Open)
+        {
+            self->SendMessageNow(payload, binary);
+            self->FlushOutput();
+        }
+        self->m_queued_bytes.fetch_sub(payload.size());
+    });
+    return true;
+}
+
+void WebSocketSession::OnEvents(uint32_t events)
+{
+    if (events & EventLoop::Shutdown)
+    {
+        if (m_state.load() == State::Open)
+        {
+            SendClose(1001, "Server shutting down");
+            FlushOutput();
+        }
+        Terminate(1001, "Server shutting down");
+        return;
+    }
+
+    if (events & EventLoop::Readable)
+    {
+        ReadAvailable();
+    }
+    if ((events & EventLoop::Writable) && m_state.load() != State::Closed)
+    {
+        FlushOutput();
+    }
+    if ((events & EventLoop::Error) && m_state.load() != State::Closed)
+    {
+        Terminate(1006, "Connection error");
+    }
+}
+
+void WebSocketSession::ReadAvailable()
+{
+    char buffer[kReadChunkSize];
+    size_t total = 0;
+    bool peer_closed = false;
+
+    while (total < kMaxReadPerEvent)
+    {
+        const auto received = recv(m_socket, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            m_input.append(buffer, static_cast<size_t>(received));
+            total += static_cast<size_t>(received);
+            continue;
+        }
+        if (received == 0)
+        {
+            peer_closed = true;
+        }
+        else if (!WouldBlock())
+        {
+            Terminate(1006, "Receive failed");
+            return;
+        }
+        break;
+    }
+
+    if (total > 0)
+    {
+        m_pong_pending = false;
+        ProcessInput();
+    }
+    if (peer_closed && m_state.load() != State::Closed)
+    {
+        // A peer that closes after our close frame has completed the handshake
+        if (m_state.load() == State::Closing)
+        {
+            Terminate(m_close_code, m_close_reason);
+        }
+        else
+        {
+            Terminate(1006, "Connection closed without close frame");
+        }
+    }
+}
+
+void WebSocketSession::ProcessInput()
+{
+    while (m_state.load() != State::Closed && !m_close_after_flush)
+    {
+        const size_t available = m_input.size() - m_input_offset;
+        if (available < 2)
+        {
+            break;
+        }
+
+        const auto* data = reinterpret_cast<const uint8_t*>(m_input.data() + m_input_offset);
+        const bool fin = (data[0] & 0x80) != 0;
+        const bool rsv1 = (data[0] & 0x40) != 0;
+        const auto opcode = static_cast<WebSocketOpcode>(data[0] & 0x0F);
+        const bool masked = (data[1] & 0x80) != 0;
+        const uint8_t length7 = data[1] & 0x7F;
+
+        size_t header_size = 2 + (length7 == 126 ? 2 : length7 == 127 ? 8 : 0) + (masked ? 4 : 0);
+        if (available < header_size)
+        {
+            break;
+        }
+
+        uint64_t length = length7;
+        if (length7 == 126)
+        {
+            length = (uint64_t(data[2]) << 8) | data[3];
+        }
+        else if (length7 == 127)
+        {
+            length = 0;
+            for (int i = 0; i < 8; ++i)
+            {
+                length = (length << 8) | data[2 + i];
+            }
+        }
+
+        // Validate the header before buffering the payload
+        const bool control = (static_cast<uint8_t>(opcode) & 0x08) != 0;
+        if ((data[0] & 0x30) != 0)
+        {
+            return Fail(1002, "Reserved bits set");
+        }
+        if (!masked)
+        {
+            return Fail(1002, "Client frames must be masked");
+        }
+        if (opcode != WebSocketOpcode::Continuation && opcode != WebSocketOpcode::Text &&
+            opcode != WebSocketOpcode::Binary && opcode != WebSocketOpcode::Close &&
+            opcode != WebSocketOpcode::Ping && opcode != WebSocketOpcode::Pong)
+        {
+            return Fail(1002, "Unknown opcode");
+        }
+        if (control && (!fin || length > kMaxControlPayload))
+        {
+            return Fail(1002, "Invalid control frame");
+        }
+        if (!control && length > m_options.max_message_size - std::min(m_message.size(), m_options.max_message_size))
+        {
+            return Fail(1009, "Message too big");
+        }
+
+        if (available - header_size < length)
+        {
+            break;
+        }
+
+        const uint8_t* mask = data + header_size - 4;
+        std::string payload(m_input.data() + m_input_offset + header_size, static_cast<size_t>(length));
+        for (size_t i = 0; i < payload.size(); ++i)
+        {
+            payload[i] = static_cast<char>(payload[i] ^ mask[i & 3]);
+        }
+        m_input_offset += header_size + static_cast<size_t>(length);
+
+        if (!HandleFrame(fin, rsv1, opcode, std::move(payload)))
+        {
+            break;
+        }
+    }
+
+    if (m_input_offset >= m_input.size())
+    {
+        m_input.clear();
+        m_input_offset = 0;
+    }
+    else if (m_input_offset > kReadChunkSize)
+    {
+        m_input.erase(0, m_input_offset);
+        m_input_offset = 0;
+    }
+}
+
+bool WebSocketSession::HandleFrame(bool fin, bool rsv1, WebSocketOpcode opcode, std::string payload)
+{
+    if ((static_cast<uint8_t>(opcode) & 0x08) != 0)
+    {
+        if (rsv1)
+        {
+            Fail(1002, "Compressed control frame");
+            return false;
+        }
+        return HandleControlFrame(opcode, std::move(payload));
+    }
+
+    if (opcode == WebSocketOpcode::Continuation)
+    {
+        if (!m_in_message || rsv1)
+        {
+            Fail(1002, "Unexpected continuation frame");
+            return false;
+        }
+    }
+    else
+    {
+        if (m_in_message)
+        {
+            Fail(1002, "Expected continuation frame");
+            return false;
+        }
+        if (rsv1 && !m_deflate)
+        {
+            Fail(1002, "Compression was not negotiated");
+            return false;
+        }
+        m_in_message = true;
+        m_message_binary = opcode == WebSocketOpcode::Binary;
+        m_message_compressed = rsv1;
+        m_message.clear();
+    }
+
+    m_message += payload;
+    if (fin)
+    {
+        m_in_message = false;
+        DeliverMessage();
+    }
+    return m_state.load() != State::Closed && !m_close_after_flush;
+}
+
+bool WebSocketSession::HandleControlFrame(WebSocketOpcode opcode, std::string payload)
+{
+    switch (opcode)
+    {
+        case WebSocketOpcode::Ping:
+            if (m_state.load() == State::Open)
+            {
+                SendFrame(WebSocketOpcode::Pong, payload);
+                FlushOutput();
+            }
+            return m_state.load() != State::Closed;
+
+        case WebSocketOpcode::Pong:
+            m_pong_pending = false;
+            return true;
+
+        case WebSocketOpcode::Close:
+        {
+            uint16_t code = 1005;
+            std::string reason;
+            if (payload.size() == 1)
+            {
+                Fail(1002, "Invalid close frame");
+                return false;
+            }
+            if (payload.size() >= 2)
+            {
+                code = static_cast<uint16_t>((static_cast<uint8_t>(payload[0]) << 8) | static_cast<uint8_t>(payload[1]));
+                reason = payload.substr(2);
+                if (!IsValidCloseCode(code))
+                {
+                    Fail(1002, "Invalid close code");
+                    return false;
+                }
+                if (!websocket::IsValidUtf8(reason))
+                {
+                    Fail(1007, "Invalid close reason");
+                    return false;
+                }
+            }
+
+            if (m_state.load() == State::Open)
+            {
+                // Echo the peer's close and drop the connection once it is written
+                m_close_code = code;
+                m_close_reason = reason;
+                SendClose(code, "");
+                m_close_after_flush = true;
+                FlushOutput();
+            }
+            else
+            {
+                Terminate(m_close_code, m_close_reason);
+            }
+            return false;
+        }
+
+        default:
+            return true;
+    }
+}
+
+void WebSocketSession::DeliverMessage()
+{
+    if (m_state.load() != State::Open)
+    {
+        m_message.clear();
+        return;
+    }
+
+    WebSocketMessage message;
+    message.binary = m_message_binary;
+    if (m_message_compressed)
+    {
+        bool too_large = false;
+        if (!m_deflate->Inflate(std::move(m_message), message.data, m_options.max_message_size, too_large))
+        {
+            m_message.clear();
+            Fail(too_large ? 1009 : 1007, too_large ? "Message too big" : "Invalid compressed data");
+            return;
+        }
+    }
+    else
+    {
+        message.data = std::move(m_message);
+    }
+    m_message.clear();
+
+    if (!message.binary && !websocket::IsValidUtf8(message.data))
+    {
+        Fail(1007, "Invalid UTF-8 in text message");
+        return;
+    }
+
+    if (m_handler->on_message)
+    {
+        try
+        {
+            m_handler->on_message(shared_from_this(), message);
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT(WebSocket, "on_message failed for {}: {}", m_path, e.what());
+            Fail(1011, "Internal error");
+        }
+    }
+}
+
+void WebSocketSession::SendFrame(WebSocketOpcode opcode, std::string_view payload, bool compressed)
+{
+    std::string frame = websocket::EncodeFrame(opcode, payload, true, compressed);
+    m_queued_bytes.fetch_add(frame.size());
+    m_output += frame;
+}
+
+void WebSocketSession::SendMessageNow(const std::string& payload, bool binary)
+{
+    const auto opcode = binary ? WebSocketOpcode::Binary : WebSocketOpcode::Text;
+    if (m_deflate && payload.size() >= kMinCompressSize)
+    {
+        std::string compressed;
+        if (m_deflate->Compress(payload, compressed))
+        {
+            SendFrame(opcode, compressed, true);
+            return;
+        }
+    }
+    SendFrame(opcode, payload);
+}
+
+void WebSocketSession::SendClose(uint16_t code, const std::string& reason)
+{
+    std::string payload;
+    // 1005 and 1006 are reserved for reporting and never sent
+    if (code != 1005 && code != 1006)
+    {
+        payload.push_back(static_cast<char>(code >> 8));
+        payload.push_back(static_cast<char>(code & 0xFF));
+        payload += reason.substr(0, kMaxCloseReason);
+    }
+    SendFrame(WebSocketOpcode::Close, payload);
+    m_state.store(State::Closing);
+
+    if (m_close_timer == 0)
+    {
+        std::weak_ptr<WebSocketSession> weak = shared_from_this();
+        m_close_timer = m_loop.AddTimer(m_options.close_timeout, [weak]()
+        {
+            if (auto self = weak.lock())
+            {
+                self->m_close_timer = 0;
+                self->Terminate(self->m_close_code, self->m_close_reason);
+            }
+        });
+    }
+}
+
+void WebSocketSession::FlushOutput()
+{
+    while (m_output_offset < m_output.size())
+    {
+        const auto sent = send(m_socket, m_output.data() + m_output_offset,
+                               static_cast<int>(m_output.size() - m_output_offset), kSendFlags);
+        if (sent > 0)
+        {
+            m_output_offset += static_cast<size_t>(sent);
+            m_queued_bytes.fetch_sub(static_cast<size_t>(sent));
+            continue;
+        }
+        if (sent < 0 && WouldBlock())
+        {
+            break;
+        }
+        Terminate(1006, "Send failed");
+        return;
+    }
+
+    if (m_output_offset >= m_output.size())
+    {
+        m_output.clear();
+        m_output_offset = 0;
+        if (m_close_after_flush)
+        {
+            Terminate(m_close_code, m_close_reason);
+            return;
+        }
+    }
+    UpdateInterest();
+}
+
+void WebSocketSession::UpdateInterest()
+{
+    if (!m_watching)
+    {
+        return;
+    }
+    const uint32_t interest = EventLoop::Readable | (m_output.empty() ? 0u : uint32_t(EventLoop::Writable));
+    if (interest != m_interest)
+    {
+        m_interest = interest;
+        m_loop.Modify(m_socket, interest);
+    }
+}
+
+void WebSocketSession::Fail(uint16_t code, const std::string& reason)
+{
+    LOG_DEBUG_FMT(WebSocket, "Session {} failed: {} ({})", m_id, reason, code);
+    if (m_state.load() != State::Open)
+    {
+        Terminate(code, reason);
+        return;
+    }
+    m_close_code = code;
+    m_close_reason = reason;
+    SendClose(code, reason);
+    m_close_after_flush = true;
+    FlushOutput();
+}
+
+void WebSocketSession::Terminate(uint16_t code, const std::string& reason)
+{
+    if (m_state.exchange(State::Closed) == State::Closed)
+    {
+        return;
+    }
+
+    if (m_ping_timer != 0)
+    {
+        m_loop.CancelTimer(m_ping_timer);
+        m_ping_timer = 0;
+    }
+    if (m_close_timer != 0)
+    {
+        m_loop.CancelTimer(m_close_timer);
+        m_close_timer = 0;
+    }
+
+    // Keep the session alive until the callback below returns
+    auto self = shared_from_this();
+    if (m_watching)
+    {
+        m_loop.Unwatch(m_socket);
+        m_watching = false;
+    }
+    CloseSocketHandle(m_socket);
+    m_socket = INVALID_SOCKET;
+    m_queued_bytes.store(0);
+
+    LOG_DEBUG_FMT(WebSocket, "Session {} closed: {} {}", m_id, code, reason);
+
+    if (m_handler->on_close)
+    {
+        try
+        {
+            m_handler->on_close(self, code, reason);
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT(WebSocket, "on_close failed for {}: {}", m_path, e.what());
+        }
+    }
+}
+
+void WebSocketSession::SchedulePing()
+{
+    if (m_options.ping_interval.count() <= 0)
+    {
+        return;
+    }
+
+    std::weak_ptr<WebSocketSession> weak = shared_from_this();
+    m_ping_timer = m_loop.AddTimer(m_options.ping_interval, [weak]()
+    {
+        auto self = weak.lock();
+        if (!self || self->m_state.load() != State::Open)
+        {
+            return;
+        }
+        self->m_ping_timer = 0;
+
+        // Nothing received since the previous ping: the peer is gone
+        if (self->m_pong_pending)
+        {
+            self->Terminate(1006, "Keepalive timeout");
+            return;
+        }
+        self->m_pong_pending = true;
+        self->SendFrame(WebSocketOpcode::Ping, "");
+        self->FlushOutput();
+        if (self->m_state.load() == State::Open)
+        {
+            self->SchedulePing();
+        }
+    });
+}
+
+} // namespace miniserver::network
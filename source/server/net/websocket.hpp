@@ -0,0 +1,291 @@
+/**
+ * @file websocket.hpp
+ * @brief WebSocket (RFC 6455) handshake, framing and sessions
+ * @author Mini Server Team
+ * @version 1.0.0
+ */
+
+#pragma once
+
+#include "net/event_loop.hpp"
+#include "net/http_types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace miniserver::network
+{
+
+class WebSocketSession;
+
+/**
+ * @brief WebSocket frame opcodes
+ */
+enum class WebSocketOpcode : uint8_t
+{
+    Continuation = 0x0,
+    Text = 0x1,
+    Binary = 0x2,
+    Close = 0x8,
+    Ping = 0x9,
+    Pong = 0xA
+};
+
+/**
+ * @brief Complete (reassembled and inflated) WebSocket message
+ */
+struct WebSocketMessage
+{
+    std::string data;           ///< Payload (UTF-8 for text messages)
+    bool binary = false;        ///< Binary message rather than text
+};
+
+/**
+ * @brief Negotiated permessage-deflate parameters (RFC 7692)
+ */
+struct WebSocketDeflateParams
+{
+    bool server_no_context_takeover = false;    ///< Reset our compressor after every message
+    bool client_no_context_takeover = false;    ///< Client resets its compressor after every message
+    int server_max_window_bits = 15;            ///< LZ77 window used by our compressor
+};
+
+/**
+ * @brief WebSocket connection limits and timers
+ */
+struct WebSocketOptions
+{
+    size_t max_message_size = 1024 * 1024;                  ///< Largest accepted message (after inflation)
+    size_t max_send_queue = 4 * 1024 * 1024;                ///< Unsent bytes before Send() refuses
+    std::chrono::milliseconds ping_interval{30000};         ///< Keepalive ping period (0 disables)
+    std::chrono::milliseconds close_timeout{5000};          ///< Wait for the peer's close frame
+};
+
+/**
+ * @brief Callbacks for one WebSocket endpoint
+ *
+ * All callbacks run on the event loop thread and must not block; long work
+ * belongs on another thread, which can answer later through the session.
+ */
+struct WebSocketHandler
+{
+    using SessionPtr = std::shared_ptr<WebSocketSession>;
+
+    std::function<void(const SessionPtr&)> on_open;                                         ///< Handshake completed
+    std::function<void(const SessionPtr&, const WebSocketMessage&)> on_message;             ///< Message received
+    std::function<void(const SessionPtr&, uint16_t code, const std::string& reason)> on_close; ///< Connection closed
+};
+
+namespace websocket
+{
+    /**
+     * @brief Compute the Sec-WebSocket-Accept value for a client key
+     * @param client_key Sec-WebSocket-Key request header
+     * @return base64(SHA-1(key + GUID))
+     */
+    std::string ComputeAcceptKey(std::string_view client_key);
+
+    /**
+     * @brief Check whether a request asks to upgrade to WebSocket
+     * @param request Parsed HTTP request
+     * @return true for GET with "Upgrade: websocket" and "Connection: upgrade"
+     */
+    bool IsUpgradeRequest(const http::Request& request);
+
+    /**
+     * @brief Pick the first acceptable permessage-deflate offer
+     * @param offers Sec-WebSocket-Extensions request header
+     * @return Parameters to use, or nullopt if none is acceptable (or zlib is unavailable)
+     */
+    std::optional<WebSocketDeflateParams> NegotiateDeflate(std::string_view offers);
+
+    /**
+     * @brief Parse the permessage-deflate extension from a handshake response
+     * @param accepted Sec-WebSocket-Extensions response header
+     * @return Parameters, or nullopt if permessage-deflate was not accepted
+     */
+    std::optional<WebSocketDeflateParams> ParseDeflateParams(std::string_view accepted);
+
+    /**
+     * @brief Format negotiated parameters as a Sec-WebSocket-Extensions response value
+     */
+    std::string FormatDeflateResponse(const WebSocketDeflateParams& params);
+
+    /**
+     * @brief Encode one unmasked (server-to-client) frame
+     * @param opcode Frame opcode
+     * @param payload Frame payload
+     * @param fin Final fragment flag
+     * @param compressed Set RSV1 (permessage-deflate)
+     * @return Wire bytes
+     */
+    std::string EncodeFrame(WebSocketOpcode opcode, std::string_view payload, bool fin = true, bool compressed = false);
+
+    /**
+     * @brief Validate UTF-8 as required for text messages and close reasons
+     */
+    bool IsValidUtf8(std::string_view data);
+} // namespace websocket
+
+/**
+ * @brief One upgraded WebSocket connection living on an EventLoop
+ *
+ * The session owns the socket once Start() has run. Reading, frame parsing,
+ * reassembly, permessage-deflate and control frames are handled on the loop
+ * thread; Send()/Close() may be called from any thread and are forwarded to
+ * the loop.
+ */
+class WebSocketSession : public std::enable_shared_from_this<WebSocketSession>
+{
+public:
+    /**
+     * @brief Construct a session for an upgraded socket
+     * @param loop Event loop the session runs on
+     * @param socket Connected socket (closed by the session)
+     * @param path Request path of the handshake
+     * @param remote_address Peer address
+     * @param handler Endpoint callbacks
+     * @param options Limits and timers
+     * @param deflate Negotiated permessage-deflate parameters, if any
+     */
+    WebSocketSession(EventLoop& loop, SOCKET socket, std::string path, std::string remote_address,
+                     std::shared_ptr<const WebSocketHandler> handler, const WebSocketOptions& options,
+                     std::optional<WebSocketDeflateParams> deflate);
+
+    /**
+     * @brief Destructor (closes the socket if still open)
+     */
+    ~WebSocketSession();
+
+    WebSocketSession(const WebSocketSession&) = delete;
+    WebSocketSession& operator=(const WebSocketSession&) = delete;
+
+    /**
+     * @brief Register with the loop and call on_open (loop thread only)
+     * @param initial_data Bytes received after the handshake request
+     */
+    void Start(std::string initial_data);
+
+    /**
+     * @brief Send a text message (thread-safe)
+     * @param text UTF-8 text
+     * @return false if the session is closing or the send queue is full
+     */
+    bool Send(std::string text);
+
+    /**
+     * @brief Send a binary message (thread-safe)
+     * @param data Payload
+     * @return false if the session is closing or the send queue is full
+     */
+    bool SendBinary(std::string data);
+
+    /**
+     * @brief Start the closing handshake (thread-safe)
+     * @param code Close status code
+     * @param reason Close reason (UTF-8, at most 123 bytes)
+     */
+    void Close(uint16_t code = 1000, std::string reason = "");
+
+    /**
+     * @brief Whether messages can still be sent
+     */
+    bool IsOpen() const { return m_state.load() == State::Open; }
+
+    /**
+     * @brief Process-unique session identifier
+     */
+    uint64_t GetId() const { return m_id; }
+
+    /**
+     * @brief Request path of the handshake
+     */
+    const std::string& GetPath() const { return m_path; }
+
+    /**
+     * @brief Peer address
+     */
+    const std::string& GetRemoteAddress() const { return m_remote_address; }
+
+private:
+    enum class State
+    {
+        Connecting,     ///< Constructed, not yet started
+        Open,           ///< Exchanging messages
+        Closing,        ///< Close frame sent, waiting for the peer's
+        Closed          ///< Socket closed
+    };
+
+    struct DeflateContext;
+
+    bool QueueMessage(std::string payload, bool binary);
+    void OnEvents(uint32_t events);
+    void ReadAvailable();
+    void ProcessInput();
+
+    /**
+     * @brief Handle one complete frame
+     * @return false once the session has failed or closed
+     */
+    bool HandleFrame(bool fin, bool rsv1, WebSocketOpcode opcode, std::string payload);
+    bool HandleControlFrame(WebSocketOpcode opcode, std::string payload);
+    void DeliverMessage();
+
+    void SendFrame(WebSocketOpcode opcode, std::string_view payload, bool compressed = false);
+    void SendMessageNow(const std::string& payload, bool binary);
+    void SendClose(uint16_t code, const std::string& reason);
+    void FlushOutput();
+    void UpdateInterest();
+
+    /**
+     * @brief Fail the connection: send a close frame and drop the socket once it is written
+     */
+    void Fail(uint16_t code, const std::string& reason);
+
+    /**
+     * @brief Close the socket immediately and notify on_close once
+     */
+    void Terminate(uint16_t code, const std::string& reason);
+
+    void SchedulePing();
+
+    EventLoop& m_loop;                                      ///< Owning loop
+    SOCKET m_socket;                                        ///< Connection socket
+    const uint64_t m_id;                                    ///< Session identifier
+    std::string m_path;                                     ///< Handshake path
+    std::string m_remote_address;                           ///< Peer address
+    std::shared_ptr<const WebSocketHandler> m_handler;      ///< Endpoint callbacks
+    WebSocketOptions m_options;                             ///< Limits and timers
+    std::optional<WebSocketDeflateParams> m_deflate_params; ///< Negotiated compression
+    std::unique_ptr<DeflateContext> m_deflate;              ///< zlib streams (loop thread)
+
+    std::atomic<State> m_state{State::Connecting};          ///< Connection state
+    std::atomic<size_t> m_queued_bytes{0};                  ///< Bytes accepted by Send() and not yet written
+
+    std::string m_input;                                    ///< Unparsed received bytes (loop thread)
+    size_t m_input_offset = 0;                              ///< Parse position in m_input
+    std::string m_output;                                   ///< Unsent frames (loop thread)
+    size_t m_output_offset = 0;                             ///< Send position in m_output
+
+    std::string m_message;                                  ///< Fragments of the message in progress
+    bool m_in_message = false;                              ///< A fragmented message is in progress
+    bool m_message_binary = false;                          ///< Type of the message in progress
+    bool m_message_compressed = false;                      ///< RSV1 set on the first fragment
+
+    bool m_close_after_flush = false;                       ///< Drop the socket once m_output is written
+    uint16_t m_close_code = 1006;                           ///< Status reported to on_close
+    std::string m_close_reason;                             ///< Reason reported to on_close
+    bool m_pong_pending = false;                            ///< Ping sent, no traffic since
+    EventLoop::TimerId m_ping_timer = 0;                    ///< Keepalive timer
+    EventLoop::TimerId m_close_timer = 0;                   ///< Closing handshake timer
+    bool m_watching = false;                                ///< Registered with the loop
+    uint32_t m_interest = 0;                                ///< Events currently watched
+};
+
+} // namespace miniserver::network